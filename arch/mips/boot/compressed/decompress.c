@@ -16,6 +16,8 @@
 #include <linux/string.h>
 
 #include <asm/addrspace.h>
+#include <asm/cacheops.h>
+#include <asm/mipsregs.h>
 
 /*
  * These two variables specify the free mem region
@@ -68,10 +70,96 @@ void error(char *x)
 #include "../../../../lib/decompress_unxz.c"
 #endif
 
+#if defined(CONFIG_CPU_MIPS32) || defined(CONFIG_CPU_MIPS64)
+/*
+ * MIPS32/64 cores describe their caches in Config1, which is all we need
+ * to run the whole decompression cached, even when the boot loader left
+ * KSEG0 uncached.
+ */
+#define zboot_cache_op(op, addr)				\
+	__asm__ __volatile__(					\
+	"	.set	push		\n"			\
+	"	.set	mips3		\n"			\
+	"	cache	%0, 0(%1)	\n"			\
+	"	.set	pop		\n"			\
+	: : "i" (op), "r" (addr))
+
+struct zboot_cache {
+	unsigned long size;
+	unsigned long linesz;
+};
+
+static void zboot_cache_probe(struct zboot_cache *ic, struct zboot_cache *dc)
+{
+	unsigned int c1 = read_c0_config1();
+	unsigned int l;
+
+	l = (c1 & MIPS_CONF1_IL) >> 19;
+	ic->linesz = l ? 2 << l : 0;
+	ic->size = ic->linesz * (64 << ((c1 & MIPS_CONF1_IS) >> 22)) *
+		   (1 + ((c1 & MIPS_CONF1_IA) >> 16));
+
+	l = (c1 & MIPS_CONF1_DL) >> 10;
+	dc->linesz = l ? 2 << l : 0;
+	dc->size = dc->linesz * (64 << ((c1 & MIPS_CONF1_DS) >> 13)) *
+		   (1 + ((c1 & MIPS_CONF1_DA) >> 7));
+}
+
+static void zboot_cache_init(void)
+{
+	struct zboot_cache ic, dc;
+	unsigned long addr;
+
+	if ((read_c0_config() & CONF_CM_CMASK) != CONF_CM_UNCACHED)
+		return;
+
+	zboot_cache_probe(&ic, &dc);
+	if (!ic.linesz || !dc.linesz)
+		return;
+
+	/*
+	 * Nothing has been through the caches while KSEG0 was uncached,
+	 * so their contents can simply be thrown away.
+	 */
+	write_c0_taglo(0);
+	write_c0_taghi(0);
+	for (addr = CKSEG0; addr < CKSEG0 + ic.size; addr += ic.linesz)
+		zboot_cache_op(Index_Store_Tag_I, addr);
+	for (addr = CKSEG0; addr < CKSEG0 + dc.size; addr += dc.linesz)
+		zboot_cache_op(Index_Store_Tag_D, addr);
+
+	change_c0_config(CONF_CM_CMASK, CONF_CM_CACHABLE_NONCOHERENT);
+	back_to_back_c0_hazard();
+}
+
+/* The kernel was written through the D-cache; make the I-cache see it. */
+static void zboot_cache_flush(void)
+{
+	struct zboot_cache ic, dc;
+	unsigned long addr;
+
+	if ((read_c0_config() & CONF_CM_CMASK) == CONF_CM_UNCACHED)
+		return;
+
+	zboot_cache_probe(&ic, &dc);
+	if (dc.linesz)
+		for (addr = CKSEG0; addr < CKSEG0 + dc.size; addr += dc.linesz)
+			zboot_cache_op(Index_Writeback_Inv_D, addr);
+	if (ic.linesz)
+		for (addr = CKSEG0; addr < CKSEG0 + ic.size; addr += ic.linesz)
+			zboot_cache_op(Index_Invalidate_I, addr);
+}
+#else
+static inline void zboot_cache_init(void) { }
+static inline void zboot_cache_flush(void) { }
+#endif
+
 void decompress_kernel(unsigned long boot_heap_start)
 {
 	unsigned long zimage_start, zimage_size;
 
+	zboot_cache_init();
+
 	zimage_start = (unsigned long)(&__image_begin);
 	zimage_size = (unsigned long)(&__image_end) -
 	    (unsigned long)(&__image_begin);
@@ -95,6 +183,6 @@ void decompress_kernel(unsigned long boot_heap_start)
 	decompress((char *)zimage_start, zimage_size, 0, 0,
 		   (void *)VMLINUX_LOAD_ADDRESS_ULL, 0, error);
 
-	/* FIXME: should we flush cache here? */
+	zboot_cache_flush();
 	puts("Now, booting the kernel...\n");
 }
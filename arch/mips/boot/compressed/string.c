@@ -6,23 +6,64 @@
 
 #include <linux/types.h>
 
+/*
+ * Some decompressors copy bulk data with memcpy(): stored blocks and
+ * window updates in inflate, uncompressed chunks and dictionary flushes
+ * in xz. LZ4 only uses it for the final literals of a block; its match
+ * copies go through LZ4_WILDCOPY. Move whole words when source and
+ * destination are equally aligned.
+ */
 void *memcpy(void *dest, const void *src, size_t n)
 {
-	int i;
 	const char *s = src;
 	char *d = dest;
 
-	for (i = 0; i < n; i++)
-		d[i] = s[i];
+	if ((((unsigned long)d ^ (unsigned long)s) & (sizeof(long) - 1)) == 0) {
+		while (n && ((unsigned long)d & (sizeof(long) - 1))) {
+			*d++ = *s++;
+			n--;
+		}
+		while (n >= 4 * sizeof(long)) {
+			((long *)d)[0] = ((const long *)s)[0];
+			((long *)d)[1] = ((const long *)s)[1];
+			((long *)d)[2] = ((const long *)s)[2];
+			((long *)d)[3] = ((const long *)s)[3];
+			d += 4 * sizeof(long);
+			s += 4 * sizeof(long);
+			n -= 4 * sizeof(long);
+		}
+		while (n >= sizeof(long)) {
+			*(long *)d = *(const long *)s;
+			d += sizeof(long);
+			s += sizeof(long);
+			n -= sizeof(long);
+		}
+	}
+	while (n--)
+		*d++ = *s++;
 	return dest;
 }
 
 void *memset(void *s, int c, size_t n)
 {
-	int i;
 	char *ss = s;
+	unsigned long w = (unsigned char)c;
+
+	w |= w << 8;
+	w |= w << 16;
+	if (sizeof(long) > 4)
+		w |= w << 16 << 16;
 
-	for (i = 0; i < n; i++)
-		ss[i] = c;
+	while (n && ((unsigned long)ss & (sizeof(long) - 1))) {
+		*ss++ = c;
+		n--;
+	}
+	while (n >= sizeof(long)) {
+		*(unsigned long *)ss = w;
+		ss += sizeof(long);
+		n -= sizeof(long);
+	}
+	while (n--)
+		*ss++ = c;
 	return s;
 }
@@ -66,6 +66,27 @@ static inline void flush_icache_page(struct vm_area_struct *vma,
 extern void (*flush_icache_range)(unsigned long start, unsigned long end);
 extern void (*local_flush_icache_range)(unsigned long start, unsigned long end);
 
+/*
+ * Batched flush_icache_range() for code that writes many small pieces of
+ * code at once. Ranges that overlap or touch, to within a cache line, are
+ * merged and flushed as one when a disjoint range comes along or when the
+ * batch is flushed.
+ */
+struct icache_batch {
+	unsigned long start;
+	unsigned long end;
+};
+
+static inline void icache_batch_init(struct icache_batch *b)
+{
+	b->start = 0;
+	b->end = 0;
+}
+
+extern void icache_batch_add(struct icache_batch *b, unsigned long start,
+	unsigned long end);
+extern void icache_batch_flush(struct icache_batch *b);
+
 extern void (*__flush_cache_vmap)(void);
 
 static inline void flush_cache_vmap(unsigned long start, unsigned long end)
@@ -399,6 +399,14 @@ extern const char *__elf_platform;
 #endif
 
 #define ARCH_HAS_SETUP_ADDITIONAL_PAGES 1
+
+#define ARCH_DLINFO							\
+do {									\
+	if (current->mm->context.vdso_image)				\
+		NEW_AUX_ENT(AT_SYSINFO_EHDR,				\
+			(unsigned long)current->mm->context.vdso_image);\
+} while (0)
+
 struct linux_binprm;
 extern int arch_setup_additional_pages(struct linux_binprm *bprm,
 				       int uses_interp);
@@ -581,6 +581,10 @@ static inline void memcpy_toio(volatile void __iomem *dst, const void *src, int
  *    caches.  Dirty lines of the caches may be written back or simply
  *    be discarded.  This operation is necessary before dma operations
  *    to the memory.
+ *  - dma_cache_wback_inv_all(size) writes back and invalidates the entire
+ *    caches if that is cheaper than maintaining a number of ranges which,
+ *    taken together, are size bytes long.  It returns nonzero if it did so,
+ *    in which case the ranges need no further maintenance.
  *
  * This API used to be exported; it now is for arch code internal use only.
  */
@@ -594,6 +598,11 @@ extern void (*_dma_cache_inv)(unsigned long start, unsigned long size);
 #define dma_cache_wback(start, size)		_dma_cache_wback(start, size)
 #define dma_cache_inv(start, size)		_dma_cache_inv(start, size)
 
+extern int (*_dma_cache_wback_inv_all)(unsigned long size);
+
+#define dma_cache_wback_inv_all(size)					\
+	(_dma_cache_wback_inv_all && _dma_cache_wback_inv_all(size))
+
 #else /* Sane hardware */
 
 #define dma_cache_wback_inv(start,size) \
@@ -602,6 +611,8 @@ extern void (*_dma_cache_inv)(unsigned long start, unsigned long size);
 	do { (void) (start); (void) (size); } while (0)
 #define dma_cache_inv(start,size)	\
 	do { (void) (start); (void) (size); } while (0)
+#define dma_cache_wback_inv_all(size)	\
+	({ (void) (size); 0; })
 
 #endif /* CONFIG_DMA_NONCOHERENT */
 
@@ -0,0 +1,28 @@
+/*
+ *  JZ4740 memory bus load accounting
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under  the terms of the GNU General  Public License as published by the
+ *  Free Software Foundation;  either version 2 of the License, or (at your
+ *  option) any later version.
+ *
+ */
+
+#ifndef __ASM_MACH_JZ4740_BUS_H__
+#define __ASM_MACH_JZ4740_BUS_H__
+
+/*
+ * The SoC has no bus performance counters. Bus masters instead report the
+ * traffic they cause, which the memory bus devfreq driver turns into a load
+ * estimate: one-off transfers through jz4740_bus_add_traffic() and steady
+ * streams like the LCD scanout through jz4740_bus_add_bandwidth().
+ */
+#ifdef CONFIG_JZ4740_BUS_DEVFREQ
+void jz4740_bus_add_traffic(unsigned long bytes);
+void jz4740_bus_add_bandwidth(long bytes_per_sec);
+#else
+static inline void jz4740_bus_add_traffic(unsigned long bytes) {}
+static inline void jz4740_bus_add_bandwidth(long bytes_per_sec) {}
+#endif
+
+#endif
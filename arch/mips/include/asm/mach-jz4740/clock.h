@@ -25,4 +25,17 @@ void jz4740_clock_set_wait_mode(enum jz4740_wait_mode mode);
 void jz4740_clock_udc_enable_auto_suspend(void);
 void jz4740_clock_udc_disable_auto_suspend(void);
 
+struct jz4740_clock_board_data {
+	unsigned long ext_rate;
+	unsigned long rtc_rate;
+};
+
+extern struct jz4740_clock_board_data jz4740_clock_bdata;
+
+void jz4740_clock_suspend(void);
+void jz4740_clock_resume(void);
+
+void jz4740_clock_pll_disable(void);
+void jz4740_clock_pll_enable(void);
+
 #endif
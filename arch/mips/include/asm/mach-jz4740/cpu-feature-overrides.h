@@ -39,6 +39,7 @@
 #define cpu_has_mips64r2	0
 #define cpu_has_dsp		0
 #define cpu_has_dsp2		0
+#define cpu_has_mxu		1
 #define cpu_has_mipsmt		0
 #define cpu_has_userlocal	0
 #define cpu_has_nofpuex 0
@@ -31,4 +31,15 @@ enum jz4740_dma_request_type {
 	JZ4740_DMA_TYPE_SLCD		= 30,
 };
 
+/*
+ * Argument of the JZ4740_DMA_COALESCE control command. Completed descriptors
+ * are reported to the client in batches of count, or timeout_us after the
+ * first of a batch completed at the latest. A count of 0 or 1 reports every
+ * descriptor as soon as it completes, which is the default.
+ */
+struct jz4740_dma_coalesce {
+	unsigned int count;
+	unsigned int timeout_us;
+};
+
 #endif	/* __ASM_JZ4740_DMA_H__ */
@@ -41,6 +41,12 @@ enum jz4740_fb_lcd_type {
 * modes: list of valid video modes
 * bpp: bits per pixel for the lcd
 * lcd_type: lcd type
+* num_buffers: number of frames in video memory available for page flipping,
+*	defaults to 1
+* smart_panel: the panel keeps its own copy of the frame, so the controller
+*	does not scan out continuously but only sends what has changed
+* set_window: smart panels only, optional; prepares the panel for receiving
+*	lines y to y + height - 1 of the frame. Without it whole frames are sent.
 */
 
 struct jz4740_fb_platform_data {
@@ -53,6 +59,8 @@ struct jz4740_fb_platform_data {
 	unsigned int bpp;
 	enum jz4740_fb_lcd_type lcd_type;
 
+	unsigned int num_buffers;
+
 	struct {
 		uint32_t spl;
 		uint32_t cls;
@@ -62,6 +70,10 @@ struct jz4740_fb_platform_data {
 
 	unsigned pixclk_falling_edge:1;
 	unsigned date_enable_active_low:1;
+
+	unsigned smart_panel:1;
+	void (*set_window)(struct device *dev, unsigned int y,
+			   unsigned int height);
 };
 
 #endif
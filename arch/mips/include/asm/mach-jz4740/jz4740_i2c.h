@@ -0,0 +1,22 @@
+/*
+ *  JZ4740 I2C controller platform data
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under  the terms of the GNU General  Public License as published by the
+ *  Free Software Foundation;  either version 2 of the License, or (at your
+ *  option) any later version.
+ *
+ */
+
+#ifndef __LINUX_I2C_JZ4740_I2C_H__
+#define __LINUX_I2C_JZ4740_I2C_H__
+
+/**
+ * struct jz4740_i2c_platform_data - I2C controller configuration
+ * @bus_freq: SCL frequency in Hz, 100 kHz if zero
+ */
+struct jz4740_i2c_platform_data {
+	unsigned int bus_freq;
+};
+
+#endif
@@ -31,6 +31,14 @@ struct jz_nand_platform_data {
 
 	unsigned char banks[JZ_NAND_NUM_BANKS];
 
+	/* Use cache read and cache program for multi-page transfers */
+	bool cache_ops;
+	/* Let operations on different banks overlap */
+	bool parallel_banks;
+	/* Keep a mirrored bad block table in the last blocks of each chip
+	 * instead of scanning every block's OOB on boot */
+	bool flash_bbt;
+
 	void (*ident_callback)(struct platform_device *, struct nand_chip *,
 				struct mtd_partition **, int *num_partitions);
 };
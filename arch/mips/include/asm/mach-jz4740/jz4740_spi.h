@@ -0,0 +1,24 @@
+/*
+ *  JZ4740 SSI (SPI) controller platform data
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under  the terms of the GNU General  Public License as published by the
+ *  Free Software Foundation;  either version 2 of the License, or (at your
+ *  option) any later version.
+ *
+ */
+
+#ifndef __LINUX_SPI_JZ4740_SPI_H__
+#define __LINUX_SPI_JZ4740_SPI_H__
+
+/**
+ * struct jz4740_spi_platform_data - SSI controller configuration
+ * @num_chipselect: number of chip selects on the bus
+ * @chipselects: GPIO used as chip select for each of them, active low
+ */
+struct jz4740_spi_platform_data {
+	unsigned int num_chipselect;
+	const int *chipselects;
+};
+
+#endif
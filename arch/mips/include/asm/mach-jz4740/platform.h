@@ -25,6 +25,7 @@ extern struct platform_device jz4740_udc_xceiv_device;
 extern struct platform_device jz4740_mmc_device;
 extern struct platform_device jz4740_rtc_device;
 extern struct platform_device jz4740_i2c_device;
+extern struct platform_device jz4740_spi_device;
 extern struct platform_device jz4740_nand_device;
 extern struct platform_device jz4740_framebuffer_device;
 extern struct platform_device jz4740_i2s_device;
@@ -34,6 +35,8 @@ extern struct platform_device jz4740_adc_device;
 extern struct platform_device jz4740_wdt_device;
 extern struct platform_device jz4740_pwm_device;
 extern struct platform_device jz4740_dma_device;
+extern struct platform_device jz4740_cpuidle_device;
+extern struct platform_device jz4740_devfreq_device;
 
 void jz4740_serial_device_register(void);
 
@@ -55,6 +55,12 @@
 #define JZ_TIMER_CTRL_SRC_RTC		BIT(1)
 #define JZ_TIMER_CTRL_SRC_PCLK		BIT(0)
 
+/* Timer which runs the clocksource, a free running counter at EXT/16 */
+#define JZ4740_TCU_CLOCKSOURCE_TIMER	1
+
+/* Timer used for perf sampling if CONFIG_JZ4740_TCU_PMU is enabled */
+#define JZ4740_TCU_PMU_TIMER	2
+
 extern void __iomem *jz4740_timer_base;
 void __init jz4740_timer_init(void);
 
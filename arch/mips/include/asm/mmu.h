@@ -4,6 +4,7 @@
 typedef struct {
 	unsigned long asid[NR_CPUS];
 	void *vdso;
+	void *vdso_image;
 } mm_context_t;
 
 #endif /* __ASM_MMU_H */
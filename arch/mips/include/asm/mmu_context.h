@@ -11,6 +11,7 @@
 #ifndef _ASM_MMU_CONTEXT_H
 #define _ASM_MMU_CONTEXT_H
 
+#include <linux/bitops.h>
 #include <linux/errno.h>
 #include <linux/sched.h>
 #include <linux/smp.h>
@@ -92,7 +93,70 @@ static inline void enter_lazy_tlb(struct mm_struct *mm, struct task_struct *tsk)
 #define ASID_VERSION_MASK  ((unsigned long)~(ASID_MASK|(ASID_MASK-1)))
 #define ASID_FIRST_VERSION ((unsigned long)(~ASID_VERSION_MASK) + 1)
 
+/*
+ * With a R4000 style TLB a new ASID cycle doesn't flush the whole TLB.
+ * ASIDs which still have entries in the TLB are skipped for the cycle
+ * instead, and an mm may take back the ASID it had in the previous cycle
+ * if nobody else has been given it yet, so its TLB entries stay useful.
+ * KVM hands out ASIDs of its own and gets the classic scheme.
+ */
+#if !defined(CONFIG_CPU_R3000) && !defined(CONFIG_CPU_TX39XX) && \
+    !defined(CONFIG_CPU_R8000) && !defined(CONFIG_MIPS_MT_SMTC) && \
+    !defined(CONFIG_KVM)
+#define MIPS_ASID_LAZY_CYCLE
+
+struct asid_cycle {
+	DECLARE_BITMAP(stale, ASID_MASK + 1);	/* left in the TLB */
+	DECLARE_BITMAP(used, ASID_MASK + 1);	/* given out this cycle */
+};
+
+extern struct asid_cycle asid_cycle[NR_CPUS];
+extern void local_flush_tlb_asid_cycle(unsigned long cpu);
+#endif
+
 #ifndef CONFIG_MIPS_MT_SMTC
+#ifdef MIPS_ASID_LAZY_CYCLE
+static inline void
+get_new_mmu_context(struct mm_struct *mm, unsigned long cpu)
+{
+	struct asid_cycle *ac = &asid_cycle[cpu];
+	unsigned long asid = asid_cache(cpu);
+
+	do {
+		if (!((asid += ASID_INC) & ASID_MASK)) {
+			if (cpu_has_vtag_icache)
+				flush_icache_all();
+			local_flush_tlb_asid_cycle(cpu); /* start new asid cycle */
+			if (!asid)		/* fix version if needed */
+				asid = ASID_FIRST_VERSION;
+		}
+	} while (test_bit(asid & ASID_MASK, ac->stale) ||
+		 test_bit(asid & ASID_MASK, ac->used));
+
+	__set_bit(asid & ASID_MASK, ac->used);
+	cpu_context(cpu, mm) = asid_cache(cpu) = asid;
+}
+
+/*
+ * Called when the ASID of mm is from an older cycle. If it is from the
+ * previous one and still free, mm keeps it along with its TLB entries.
+ * This is never used to flush an mm, that must always get a new ASID.
+ */
+static inline void
+get_mmu_context(struct mm_struct *mm, unsigned long cpu)
+{
+	unsigned long ctx = cpu_context(cpu, mm);
+	unsigned long version = asid_cache(cpu) & ASID_VERSION_MASK;
+
+	if (ctx && (ctx & ASID_VERSION_MASK) == version - ASID_FIRST_VERSION &&
+	    !__test_and_set_bit(ctx & ASID_MASK, asid_cycle[cpu].used)) {
+		cpu_context(cpu, mm) = version | (ctx & ASID_MASK);
+		return;
+	}
+
+	get_new_mmu_context(mm, cpu);
+}
+#else
 /* Normal, classic MIPS get_new_mmu_context */
 static inline void
 get_new_mmu_context(struct mm_struct *mm, unsigned long cpu)
@@ -115,9 +179,13 @@ get_new_mmu_context(struct mm_struct *mm, unsigned long cpu)
 	cpu_context(cpu, mm) = asid_cache(cpu) = asid;
 }
 
+#define get_mmu_context(mm, cpu) get_new_mmu_context((mm), (cpu))
+#endif /* MIPS_ASID_LAZY_CYCLE */
+
 #else /* CONFIG_MIPS_MT_SMTC */
 
 #define get_new_mmu_context(mm, cpu) smtc_get_new_mmu_context((mm), (cpu))
+#define get_mmu_context(mm, cpu) smtc_get_new_mmu_context((mm), (cpu))
 
 #endif /* CONFIG_MIPS_MT_SMTC */
 
@@ -153,7 +221,7 @@ static inline void switch_mm(struct mm_struct *prev, struct mm_struct *next,
 
 	/* Check if our ASID is of an older version and thus invalid */
 	if ((cpu_context(cpu, next) ^ asid_cache(cpu)) & ASID_VERSION_MASK)
-		get_new_mmu_context(next, cpu);
+		get_mmu_context(next, cpu);
 #ifdef CONFIG_MIPS_MT_SMTC
 	/*
 	 * If the EntryHi ASID being replaced happens to be
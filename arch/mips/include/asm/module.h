@@ -11,6 +11,9 @@ struct mod_arch_specific {
 	const struct exception_table_entry *dbe_start;
 	const struct exception_table_entry *dbe_end;
 	struct mips_hi16 *r_mips_hi16_list;
+	/* Preallocated list entries for the relocation section in progress */
+	struct mips_hi16 *r_mips_hi16_pool;
+	unsigned int r_mips_hi16_free;
 };
 
 typedef uint8_t Elf64_Byte;		/* Type for a 8-bit quantity.  */
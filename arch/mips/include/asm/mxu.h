@@ -0,0 +1,143 @@
+/*
+ * Ingenic XBurst MXU SIMD unit support
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ */
+#ifndef _ASM_MXU_H
+#define _ASM_MXU_H
+
+#include <linux/hardirq.h>
+#include <linux/types.h>
+
+#include <asm/cpu-features.h>
+#include <asm/processor.h>
+
+/*
+ * The MXU has sixteen 32-bit registers. xr0 always reads as zero and xr16
+ * is the MXU control register, which also holds the enable bit of the unit.
+ */
+#define MXU_CR			16
+
+#define MXU_CR_EN		0x00000001
+
+/*
+ * The assembler doesn't know about the MXU, so S32M2I and S32I2M are
+ * encoded by hand, with $1 as the general purpose register.
+ */
+#define read_mxu_reg(xr)						\
+({									\
+	unsigned int __res;						\
+									\
+	__asm__ __volatile__(						\
+	"	.set	push				\n"		\
+	"	.set	noat				\n"		\
+	"	# s32m2i xr%1, $1			\n"		\
+	"	.word	0x7001002e | (%x1 << 6)		\n"		\
+	"	move	%0, $1				\n"		\
+	"	.set	pop				\n"		\
+	: "=r" (__res)							\
+	: "i" (xr));							\
+	__res;								\
+})
+
+#define write_mxu_reg(xr, val)						\
+do {									\
+	__asm__ __volatile__(						\
+	"	.set	push				\n"		\
+	"	.set	noat				\n"		\
+	"	move	$1, %0				\n"		\
+	"	# s32i2m xr%1, $1			\n"		\
+	"	.word	0x7001002f | (%x1 << 6)		\n"		\
+	"	.set	pop				\n"		\
+	:								\
+	: "r" (val), "i" (xr));						\
+} while (0)
+
+/* Read the live MXU state, the registers only matter if the unit is on */
+static inline void __read_mxu_state(struct mips_mxu_state *mxu)
+{
+	mxu->mxu_cr = read_mxu_reg(MXU_CR);
+	if (!(mxu->mxu_cr & MXU_CR_EN))
+		return;
+
+	mxu->xr[0] = read_mxu_reg(1);
+	mxu->xr[1] = read_mxu_reg(2);
+	mxu->xr[2] = read_mxu_reg(3);
+	mxu->xr[3] = read_mxu_reg(4);
+	mxu->xr[4] = read_mxu_reg(5);
+	mxu->xr[5] = read_mxu_reg(6);
+	mxu->xr[6] = read_mxu_reg(7);
+	mxu->xr[7] = read_mxu_reg(8);
+	mxu->xr[8] = read_mxu_reg(9);
+	mxu->xr[9] = read_mxu_reg(10);
+	mxu->xr[10] = read_mxu_reg(11);
+	mxu->xr[11] = read_mxu_reg(12);
+	mxu->xr[12] = read_mxu_reg(13);
+	mxu->xr[13] = read_mxu_reg(14);
+	mxu->xr[14] = read_mxu_reg(15);
+}
+
+static inline void __write_mxu_state(const struct mips_mxu_state *mxu)
+{
+	/* the registers can only be written with the unit enabled */
+	write_mxu_reg(MXU_CR, MXU_CR_EN);
+	write_mxu_reg(1, mxu->xr[0]);
+	write_mxu_reg(2, mxu->xr[1]);
+	write_mxu_reg(3, mxu->xr[2]);
+	write_mxu_reg(4, mxu->xr[3]);
+	write_mxu_reg(5, mxu->xr[4]);
+	write_mxu_reg(6, mxu->xr[5]);
+	write_mxu_reg(7, mxu->xr[6]);
+	write_mxu_reg(8, mxu->xr[7]);
+	write_mxu_reg(9, mxu->xr[8]);
+	write_mxu_reg(10, mxu->xr[9]);
+	write_mxu_reg(11, mxu->xr[10]);
+	write_mxu_reg(12, mxu->xr[11]);
+	write_mxu_reg(13, mxu->xr[12]);
+	write_mxu_reg(14, mxu->xr[13]);
+	write_mxu_reg(15, mxu->xr[14]);
+	write_mxu_reg(MXU_CR, mxu->mxu_cr);
+}
+
+static inline void init_mxu(void)
+{
+	if (cpu_has_mxu)
+		write_mxu_reg(MXU_CR, 0);
+}
+
+/*
+ * There is no trap on the first use of the MXU, so the context is switched
+ * based on its enable bit instead. A task that had the unit enabled gets its
+ * registers saved and the unit is switched off, which leaves the tasks that
+ * never enable it with the cost of a single control register read.
+ */
+#define __save_mxu(tsk)							\
+do {									\
+	__read_mxu_state(&tsk->thread.mxu);				\
+	if (tsk->thread.mxu.mxu_cr & MXU_CR_EN)				\
+		write_mxu_reg(MXU_CR, 0);				\
+} while (0)
+
+#define __restore_mxu(tsk)						\
+do {									\
+	if (tsk->thread.mxu.mxu_cr & MXU_CR_EN)				\
+		__write_mxu_state(&tsk->thread.mxu);			\
+} while (0)
+
+/*
+ * Kernel code may use the MXU between kernel_mxu_begin() and
+ * kernel_mxu_end(), provided may_use_mxu() returned true. The section runs
+ * with preemption disabled and must not sleep.
+ */
+static inline bool may_use_mxu(void)
+{
+	return cpu_has_mxu && !in_interrupt();
+}
+
+extern void kernel_mxu_begin(void);
+extern void kernel_mxu_end(void);
+
+#endif /* _ASM_MXU_H */
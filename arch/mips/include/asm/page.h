@@ -59,7 +59,21 @@ static inline unsigned int page_size_ftlb(unsigned int mmuextdef)
 }
 
 #ifdef CONFIG_MIPS_HUGE_TLB_SUPPORT
-#define HPAGE_SHIFT	(PAGE_SHIFT + PAGE_SHIFT - 3)
+/* Size mapped by a TLB entry pair of PM_HUGE_MASK sized pages */
+#define HPAGE_TLB_SHIFT	(PAGE_SHIFT + PAGE_SHIFT - 3)
+#define HPAGE_TLB_SIZE	(_AC(1,UL) << HPAGE_TLB_SHIFT)
+#ifdef CONFIG_64BIT
+#define HPAGE_SHIFT	HPAGE_TLB_SHIFT
+#else
+/*
+ * 32-bit kernels keep huge PTEs in the PGD, whose entries map twice what a
+ * huge TLB entry pair does. Each huge page then takes two TLB entries.
+ */
+#if defined(CONFIG_64BIT_PHYS_ADDR) && defined(CONFIG_CPU_MIPS32)
+#error Huge pages on 32-bit kernels need 32-bit PTEs
+#endif
+#define HPAGE_SHIFT	(PAGE_SHIFT + PAGE_SHIFT - 2)
+#endif
 #define HPAGE_SIZE	(_AC(1,UL) << HPAGE_SHIFT)
 #define HPAGE_MASK	(~(HPAGE_SIZE - 1))
 #define HUGETLB_PAGE_ORDER	(HPAGE_SHIFT - PAGE_SHIFT)
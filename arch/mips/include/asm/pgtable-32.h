@@ -79,7 +79,16 @@ static inline int pmd_none(pmd_t pmd)
 	return pmd_val(pmd) == (unsigned long) invalid_pte_table;
 }
 
-#define pmd_bad(pmd)		(pmd_val(pmd) & ~PAGE_MASK)
+static inline int pmd_bad(pmd_t pmd)
+{
+#ifdef CONFIG_MIPS_HUGE_TLB_SUPPORT
+	/* pmd_huge(pmd) but inline */
+	if (unlikely(pmd_val(pmd) & _PAGE_HUGE))
+		return 0;
+#endif
+
+	return pmd_val(pmd) & ~PAGE_MASK;
+}
 
 static inline int pmd_present(pmd_t pmd)
 {
@@ -170,6 +179,12 @@ pfn_pte(unsigned long pfn, pgprot_t prot)
 #define __swp_offset(x)		 ((x).val >> 7)
 #define __swp_entry(type,offset)	\
 		((swp_entry_t)	{ ((type) << 2) | ((offset) << 7) })
+#elif defined(CONFIG_MIPS_HUGE_TLB_SUPPORT)
+/* The huge and splitting bits move GLOBAL and VALID up to bits 7 and 8 */
+#define __swp_type(x)		(((x).val >> 10) & 0x1f)
+#define __swp_offset(x)		 ((x).val >> 15)
+#define __swp_entry(type,offset)	\
+		((swp_entry_t)	{ ((type) << 10) | ((offset) << 15) })
 #else
 #define __swp_type(x)		(((x).val >> 8) & 0x1f)
 #define __swp_offset(x)		 ((x).val >> 13)
@@ -186,6 +201,19 @@ pfn_pte(unsigned long pfn, pgprot_t prot)
 #define pte_to_pgoff(_pte)	((_pte).pte_high >> 2)
 #define pgoff_to_pte(off)	((pte_t) { _PAGE_FILE, (off) << 2 })
 
+#elif defined(CONFIG_MIPS_HUGE_TLB_SUPPORT)
+/*
+ * Bits 0 and 4 to 9 are taken, split up 25 bits of offset into this range:
+ */
+#define PTE_FILE_MAX_BITS	25
+
+#define pte_to_pgoff(_pte)	((((_pte).pte >> 1) & 0x7) | \
+				 (((_pte).pte >> 10) << 3))
+
+#define pgoff_to_pte(off)	((pte_t) { (((off) & 0x7) << 1) | \
+					   (((off) >> 3) << 10) | \
+					   _PAGE_FILE })
+
 #else
 /*
  * Bits 0, 4, 6, and 7 are taken, split up 28 bits of offset into this range:
@@ -120,6 +120,14 @@ struct mips_dsp_state {
 	unsigned int	dspcontrol;
 };
 
+#define NUM_MXU_REGS	15
+
+/* Ingenic XBurst MXU registers xr1-xr15 and the MXU control register */
+struct mips_mxu_state {
+	__u32		xr[NUM_MXU_REGS];
+	__u32		mxu_cr;
+};
+
 #define INIT_CPUMASK { \
 	{0,} \
 }
@@ -236,6 +244,9 @@ struct thread_struct {
 	/* Saved state of the DSP ASE, if available. */
 	struct mips_dsp_state dsp;
 
+	/* Saved state of the MXU, if available. */
+	struct mips_mxu_state mxu;
+
 	/* Saved watch register state, if available. */
 	union mips_watch_reg_state watch;
 
@@ -243,6 +254,8 @@ struct thread_struct {
 	unsigned long cp0_badvaddr;	/* Last user fault */
 	unsigned long cp0_baduaddr;	/* Last kernel fault accessing USEG */
 	unsigned long error_code;
+	unsigned long unaligned_count;	/* Fixed up unaligned accesses */
+	unsigned long unaligned_pc;	/* PC of the last one */
 #ifdef CONFIG_CPU_CAVIUM_OCTEON
 	struct octeon_cop2_state cp2 __attribute__ ((__aligned__(128)));
 	struct octeon_cvmseg_state cvmseg __attribute__ ((__aligned__(128)));
@@ -298,6 +311,13 @@ struct thread_struct {
 		.dspr		= {0, },			\
 		.dspcontrol	= 0,				\
 	},							\
+	/*							\
+	 * Saved MXU stuff					\
+	 */							\
+	.mxu			= {				\
+		.xr		= {0, },			\
+		.mxu_cr		= 0,				\
+	},							\
 	/*							\
 	 * saved watch register stuff				\
 	 */							\
@@ -308,6 +328,8 @@ struct thread_struct {
 	.cp0_badvaddr		= 0,				\
 	.cp0_baduaddr		= 0,				\
 	.error_code		= 0,				\
+	.unaligned_count	= 0,				\
+	.unaligned_pc		= 0,				\
 	/*							\
 	 * Platform specific cop2 registers(null if no COP2)	\
 	 */							\
@@ -328,6 +350,11 @@ extern void start_thread(struct pt_regs * regs, unsigned long pc, unsigned long
 
 unsigned long get_wchan(struct task_struct *p);
 
+/* /proc/<pid>/unaligned and /proc/<pid>/task/<tid>/unaligned */
+#define __HAVE_ARCH_PROC_PID_UNALIGNED
+extern int proc_tgid_unaligned(struct task_struct *task, char *buffer);
+extern int proc_tid_unaligned(struct task_struct *task, char *buffer);
+
 #define __KSTK_TOS(tsk) ((unsigned long)task_stack_page(tsk) + \
 			 THREAD_SIZE - 32 - sizeof(struct pt_regs))
 #define task_pt_regs(tsk) ((struct pt_regs *)__KSTK_TOS(tsk))
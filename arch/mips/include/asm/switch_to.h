@@ -15,6 +15,7 @@
 #include <asm/cpu-features.h>
 #include <asm/watch.h>
 #include <asm/dsp.h>
+#include <asm/mxu.h>
 #include <asm/cop2.h>
 
 struct task_struct;
@@ -79,6 +80,8 @@ do {									\
 	__mips_mt_fpaff_switch_to(prev);				\
 	if (cpu_has_dsp)						\
 		__save_dsp(prev);					\
+	if (cpu_has_mxu)						\
+		__save_mxu(prev);					\
 	if (cop2_present && (KSTK_STATUS(prev) & ST0_CU2)) {		\
 		if (cop2_lazy_restore)					\
 			KSTK_STATUS(prev) &= ~ST0_CU2;			\
@@ -104,6 +107,8 @@ do {									\
 	}								\
 	if (cpu_has_dsp)						\
 		__restore_dsp(current);					\
+	if (cpu_has_mxu)						\
+		__restore_mxu(current);					\
 	if (cpu_has_userlocal)						\
 		write_c0_userlocal(current_thread_info()->tp_value);	\
 	__restore_watch();						\
@@ -22,6 +22,13 @@ extern void local_flush_tlb_page(struct vm_area_struct *vma,
 	unsigned long page);
 extern void local_flush_tlb_one(unsigned long vaddr);
 
+/*
+ * Largest kernel range, in pages, that flush_tlb_kernel_range() flushes
+ * entry by entry instead of flushing the whole TLB.
+ */
+extern unsigned long tlb_kernel_range_max_pages(void);
+#define tlb_kernel_range_max_pages tlb_kernel_range_max_pages
+
 #ifdef CONFIG_SMP
 
 extern void flush_tlb_all(void);
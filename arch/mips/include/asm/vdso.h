@@ -26,4 +26,46 @@ struct mips_vdso {
 };
 #endif /* CONFIG_32BIT */
 
+/*
+ * Without a clocksource that userspace can read the vDSO only serves the
+ * coarse clocks and passes everything else to the system call. With one,
+ * its counter is mapped in the page below the data page.
+ */
+#define VDSO_CLOCK_NONE		0
+#define VDSO_CLOCK_COUNTER	1
+
+/*
+ * Timekeeping data shared with the vDSO, in the page just below the vDSO
+ * image. The layout is only known to the kernel and the vDSO itself.
+ */
+struct mips_vdso_data {
+	u32 seq;		/* Odd while an update is in progress */
+	u32 clock_mode;
+	u64 cycle_last;		/* Counter value at the last update */
+	u64 mask;
+	u32 mult;
+	u32 shift;
+	u64 xtime_sec;
+	u64 xtime_nsec;		/* Shifted by shift */
+	s64 wtm_sec;		/* Wall to monotonic offset */
+	u32 wtm_nsec;
+	u32 counter_offset;	/* Offset of the counter in its page */
+	s32 tz_minuteswest;
+	s32 tz_dsttime;
+};
+
+#ifndef __VDSO__
+struct clocksource;
+
+#ifdef CONFIG_GENERIC_TIME_VSYSCALL
+extern void mips_vdso_register_counter(struct clocksource *cs,
+				       phys_addr_t addr);
+#else
+static inline void mips_vdso_register_counter(struct clocksource *cs,
+					      phys_addr_t addr)
+{
+}
+#endif
+#endif /* __VDSO__ */
+
 #endif /* __ASM_VDSO_H */
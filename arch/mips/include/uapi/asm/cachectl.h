@@ -8,6 +8,8 @@
 #ifndef _ASM_CACHECTL
 #define _ASM_CACHECTL
 
+#include <linux/types.h>
+
 /*
  * Options for cacheflush system call
  */
@@ -15,6 +17,19 @@
 #define DCACHE	(1<<1)		/* writeback and flush data cache */
 #define BCACHE	(ICACHE|DCACHE) /* flush both caches		  */
 
+/*
+ * With CACHEFLUSH_RANGES, cacheflush(addr, nr, cache) takes an array of nr
+ * struct cacheflush_range at addr. Adjacent ranges are flushed together.
+ * It returns nr on success, older kernels return 0 after flushing the array
+ * itself instead.
+ */
+#define CACHEFLUSH_RANGES (1<<2)
+
+struct cacheflush_range {
+	__u64	addr;
+	__u64	len;
+};
+
 /*
  * Caching modes for the cachectl(2) call
  *
@@ -26,6 +26,7 @@
 #include <linux/power/jz4740-battery.h>
 #include <linux/power/gpio-charger.h>
 
+#include <asm/mach-jz4740/clock.h>
 #include <asm/mach-jz4740/jz4740_fb.h>
 #include <asm/mach-jz4740/jz4740_mmc.h>
 #include <asm/mach-jz4740/jz4740_nand.h>
@@ -37,7 +38,6 @@
 
 #include <asm/mach-jz4740/platform.h>
 
-#include "clock.h"
 
 static bool is_avt2;
 
@@ -287,6 +287,7 @@ static struct jz4740_fb_platform_data qi_lb60_fb_pdata = {
 	.modes		= qi_lb60_video_modes,
 	.bpp		= 24,
 	.lcd_type	= JZ_LCD_TYPE_8BIT_SERIAL,
+	.num_buffers	= 2,
 	.pixclk_falling_edge = 1,
 };
 
@@ -426,6 +427,13 @@ static struct platform_device qi_lb60_audio_device = {
 	.id = -1,
 };
 
+#ifdef CONFIG_SND_JZ4740_SOC_QI_LB60_SWDSP
+static struct platform_device qi_lb60_swdsp_device = {
+	.name = "snd-soc-swdsp",
+	.id = -1,
+};
+#endif
+
 static struct platform_device *jz_platform_devices[] __initdata = {
 	&jz4740_udc_device,
 	&jz4740_udc_xceiv_device,
@@ -441,10 +449,15 @@ static struct platform_device *jz_platform_devices[] __initdata = {
 	&jz4740_adc_device,
 	&jz4740_pwm_device,
 	&jz4740_dma_device,
+	&jz4740_cpuidle_device,
+	&jz4740_devfreq_device,
 	&qi_lb60_gpio_keys,
 	&qi_lb60_pwm_beeper,
 	&qi_lb60_charger_device,
 	&qi_lb60_audio_device,
+#ifdef CONFIG_SND_JZ4740_SOC_QI_LB60_SWDSP
+	&qi_lb60_swdsp_device,
+#endif
 };
 
 static void __init board_gpio_setup(void)
@@ -21,6 +21,7 @@
 #include <linux/gpio.h>
 #include <linux/delay.h>
 #include <linux/interrupt.h>
+#include <linux/irqdomain.h>
 #include <linux/bitops.h>
 
 #include <linux/debugfs.h>
@@ -77,6 +78,7 @@
 struct jz_gpio_chip {
 	unsigned int irq;
 	unsigned int irq_base;
+	struct irq_domain *domain;
 	uint32_t edge_trigger_both;
 
 	void __iomem *base;
@@ -216,6 +218,23 @@ static void jz_gpio_set_value(struct gpio_chip *chip, unsigned gpio, int value)
 	writel(BIT(gpio), reg);
 }
 
+static int jz_gpio_get_multiple(struct gpio_chip *chip, unsigned long *mask,
+	unsigned long *bits)
+{
+	uint32_t value = readl(CHIP_TO_REG(chip, JZ_REG_GPIO_PIN));
+
+	bits[0] = (bits[0] & ~mask[0]) | (value & mask[0]);
+
+	return 0;
+}
+
+static void jz_gpio_set_multiple(struct gpio_chip *chip, unsigned long *mask,
+	unsigned long *bits)
+{
+	writel(~bits[0] & mask[0], CHIP_TO_REG(chip, JZ_REG_GPIO_DATA_CLEAR));
+	writel(bits[0] & mask[0], CHIP_TO_REG(chip, JZ_REG_GPIO_DATA_SET));
+}
+
 static int jz_gpio_direction_output(struct gpio_chip *chip, unsigned gpio,
 	int value)
 {
@@ -275,13 +294,12 @@ int irq_to_gpio(unsigned irq)
 }
 EXPORT_SYMBOL_GPL(irq_to_gpio);
 
-#define IRQ_TO_BIT(irq) BIT(irq_to_gpio(irq) & 0x1f)
-
-static void jz_gpio_check_trigger_both(struct jz_gpio_chip *chip, unsigned int irq)
+static void jz_gpio_check_trigger_both(struct jz_gpio_chip *chip,
+	irq_hw_number_t hwirq)
 {
 	uint32_t value;
 	void __iomem *reg;
-	uint32_t mask = IRQ_TO_BIT(irq);
+	uint32_t mask = BIT(hwirq);
 
 	if (!(chip->edge_trigger_both & mask))
 		return;
@@ -300,31 +318,30 @@ static void jz_gpio_check_trigger_both(struct jz_gpio_chip *chip, unsigned int i
 static void jz_gpio_irq_demux_handler(unsigned int irq, struct irq_desc *desc)
 {
 	uint32_t flag;
-	unsigned int gpio_irq;
+	unsigned int hwirq;
 	struct jz_gpio_chip *chip = irq_desc_get_handler_data(desc);
 
 	flag = readl(chip->base + JZ_REG_GPIO_FLAG);
-	if (!flag)
-		return;
-
-	gpio_irq = chip->irq_base + __fls(flag);
-
-	jz_gpio_check_trigger_both(chip, gpio_irq);
 
-	generic_handle_irq(gpio_irq);
-};
+	while (flag) {
+		hwirq = __fls(flag);
+		jz_gpio_check_trigger_both(chip, hwirq);
+		generic_handle_irq(irq_linear_revmap(chip->domain, hwirq));
+		flag &= ~BIT(hwirq);
+	}
+}
 
 static inline void jz_gpio_set_irq_bit(struct irq_data *data, unsigned int reg)
 {
 	struct jz_gpio_chip *chip = irq_to_jz_gpio_chip(data);
-	writel(IRQ_TO_BIT(data->irq), chip->base + reg);
+	writel(BIT(data->hwirq), chip->base + reg);
 }
 
 static void jz_gpio_irq_unmask(struct irq_data *data)
 {
 	struct jz_gpio_chip *chip = irq_to_jz_gpio_chip(data);
 
-	jz_gpio_check_trigger_both(chip, data->irq);
+	jz_gpio_check_trigger_both(chip, data->hwirq);
 	irq_gc_unmask_enable_reg(data);
 };
 
@@ -348,17 +365,17 @@ static void jz_gpio_irq_shutdown(struct irq_data *data)
 static int jz_gpio_irq_set_type(struct irq_data *data, unsigned int flow_type)
 {
 	struct jz_gpio_chip *chip = irq_to_jz_gpio_chip(data);
-	unsigned int irq = data->irq;
+	uint32_t mask = BIT(data->hwirq);
 
 	if (flow_type == IRQ_TYPE_EDGE_BOTH) {
 		uint32_t value = readl(chip->base + JZ_REG_GPIO_PIN);
-		if (value & IRQ_TO_BIT(irq))
+		if (value & mask)
 			flow_type = IRQ_TYPE_EDGE_FALLING;
 		else
 			flow_type = IRQ_TYPE_EDGE_RISING;
-		chip->edge_trigger_both |= IRQ_TO_BIT(irq);
+		chip->edge_trigger_both |= mask;
 	} else {
-		chip->edge_trigger_both &= ~IRQ_TO_BIT(irq);
+		chip->edge_trigger_both &= ~mask;
 	}
 
 	switch (flow_type) {
@@ -402,6 +419,8 @@ static int jz_gpio_irq_set_wake(struct irq_data *data, unsigned int on)
 		.owner = THIS_MODULE, \
 		.set = jz_gpio_set_value, \
 		.get = jz_gpio_get_value, \
+		.get_multiple = jz_gpio_get_multiple, \
+		.set_multiple = jz_gpio_set_multiple, \
 		.direction_output = jz_gpio_direction_output, \
 		.direction_input = jz_gpio_direction_input, \
 		.base = JZ4740_GPIO_BASE_ ## _bank, \
@@ -453,6 +472,11 @@ static void jz4740_gpio_chip_init(struct jz_gpio_chip *chip, unsigned int id)
 	irq_setup_generic_chip(gc, IRQ_MSK(chip->gpio_chip.ngpio),
 		IRQ_GC_INIT_NESTED_LOCK, 0, IRQ_NOPROBE | IRQ_LEVEL);
 
+	chip->domain = irq_domain_add_legacy(NULL, chip->gpio_chip.ngpio,
+		chip->irq_base, 0, &irq_domain_simple_ops, NULL);
+	if (!chip->domain)
+		panic("Failed to add irq domain for %s", chip->gpio_chip.label);
+
 	gpiochip_add(&chip->gpio_chip);
 }
 
@@ -18,6 +18,7 @@
 #include <linux/types.h>
 #include <linux/interrupt.h>
 #include <linux/ioport.h>
+#include <linux/irqdomain.h>
 #include <linux/timex.h>
 #include <linux/slab.h>
 #include <linux/delay.h>
@@ -31,7 +32,11 @@
 
 #include <asm/mach-jz4740/base.h>
 
+#include "irq.h"
+
 static void __iomem *jz_intc_base;
+static struct irq_domain *jz_intc_domain;
+static uint32_t jz_intc_urgent;
 
 #define JZ_REG_INTC_STATUS	0x00
 #define JZ_REG_INTC_MASK	0x04
@@ -39,16 +44,30 @@ static void __iomem *jz_intc_base;
 #define JZ_REG_INTC_CLEAR_MASK	0x0c
 #define JZ_REG_INTC_PENDING	0x10
 
-static irqreturn_t jz4740_cascade(int irq, void *data)
+/*
+ * Handle all sources which are pending at the time of the exception in one go,
+ * instead of taking a new exception for each of them. Urgent sources go first.
+ */
+static void jz4740_cascade(unsigned int irq, struct irq_desc *desc)
 {
-	uint32_t irq_reg;
-
-	irq_reg = readl(jz_intc_base + JZ_REG_INTC_PENDING);
-
-	if (irq_reg)
-		generic_handle_irq(__fls(irq_reg) + JZ4740_IRQ_BASE);
-
-	return IRQ_HANDLED;
+	uint32_t pending, urgent;
+	unsigned int hwirq;
+
+	pending = readl(jz_intc_base + JZ_REG_INTC_PENDING);
+
+	urgent = pending & jz_intc_urgent;
+	while (urgent) {
+		hwirq = __fls(urgent);
+		generic_handle_irq(irq_linear_revmap(jz_intc_domain, hwirq));
+		urgent &= ~BIT(hwirq);
+	}
+	pending &= ~jz_intc_urgent;
+
+	while (pending) {
+		hwirq = __fls(pending);
+		generic_handle_irq(irq_linear_revmap(jz_intc_domain, hwirq));
+		pending &= ~BIT(hwirq);
+	}
 }
 
 static void jz4740_irq_set_mask(struct irq_chip_generic *gc, uint32_t mask)
@@ -59,6 +78,19 @@ static void jz4740_irq_set_mask(struct irq_chip_generic *gc, uint32_t mask)
 	writel(~mask, gc->reg_base + regs->disable);
 }
 
+/**
+ * jz4740_irq_set_urgent - handle an INTC source ahead of all others
+ * @irq: Linux irq number of the source
+ *
+ * The INTC has no priority levels. Sources marked here are dispatched
+ * first when several are pending, which keeps the latency of e.g. the
+ * profiling timer independent of the other interrupt load.
+ */
+void __init jz4740_irq_set_urgent(unsigned int irq)
+{
+	jz_intc_urgent |= BIT(irq - JZ4740_IRQ_BASE);
+}
+
 void jz4740_irq_suspend(struct irq_data *data)
 {
 	struct irq_chip_generic *gc = irq_data_get_irq_chip_data(data);
@@ -71,11 +103,6 @@ void jz4740_irq_resume(struct irq_data *data)
 	jz4740_irq_set_mask(gc, gc->mask_cache);
 }
 
-static struct irqaction jz4740_cascade_action = {
-	.handler = jz4740_cascade,
-	.name = "JZ4740 cascade interrupt",
-};
-
 void __init arch_init_irq(void)
 {
 	struct irq_chip_generic *gc;
@@ -105,7 +132,12 @@ void __init arch_init_irq(void)
 
 	irq_setup_generic_chip(gc, IRQ_MSK(32), 0, 0, IRQ_NOPROBE | IRQ_LEVEL);
 
-	setup_irq(2, &jz4740_cascade_action);
+	jz_intc_domain = irq_domain_add_legacy(NULL, 32, JZ4740_IRQ_BASE, 0,
+		&irq_domain_simple_ops, NULL);
+	if (!jz_intc_domain)
+		panic("Failed to add JZ4740 INTC irq domain");
+
+	irq_set_chained_handler(2, jz4740_cascade);
 }
 
 asmlinkage void plat_irq_dispatch(void)
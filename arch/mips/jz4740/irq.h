@@ -19,5 +19,6 @@
 
 extern void jz4740_irq_suspend(struct irq_data *data);
 extern void jz4740_irq_resume(struct irq_data *data);
+extern void jz4740_irq_set_urgent(unsigned int irq);
 
 #endif
@@ -0,0 +1,101 @@
+/*
+ *  JZ4740 kexec support
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under  the terms of the GNU General  Public License as published by the
+ *  Free Software Foundation;  either version 2 of the License, or (at your
+ *  option) any later version.
+ *
+ */
+
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/kexec.h>
+#include <linux/mm.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
+
+#include <asm/kexec.h>
+#include <asm/setup.h>
+
+/*
+ * The boot loader passes the kernel command line as argc and argv in a0 and
+ * a1, see prom.c, and the new kernel expects it the same way. kexec-tools
+ * hands the command line over as a segment starting with "kexec ", which is
+ * turned into an argument vector in the board specific part of the control
+ * pages. Those are never a copy destination, so they survive the relocation
+ * of the new kernel until its prom code has copied the command line.
+ */
+
+#define JZ4740_KEXEC_CMDLINE_PREFIX	"kexec "
+
+struct jz4740_kexec_args {
+	char *argv[3];
+	char cmdline[COMMAND_LINE_SIZE];
+};
+
+static int jz4740_kexec_find_cmdline(struct kimage *image, char *cmdline)
+{
+	const size_t prefix_len = strlen(JZ4740_KEXEC_CMDLINE_PREFIX);
+	unsigned long i;
+	size_t len;
+
+	for (i = 0; i < image->nr_segments; ++i) {
+		len = min_t(size_t, image->segment[i].bufsz,
+			    COMMAND_LINE_SIZE - 1);
+		if (len < prefix_len)
+			continue;
+
+		if (copy_from_user(cmdline, image->segment[i].buf, len))
+			return -EFAULT;
+		cmdline[len] = '\0';
+
+		if (strncmp(cmdline, JZ4740_KEXEC_CMDLINE_PREFIX, prefix_len))
+			continue;
+
+		memmove(cmdline, cmdline + prefix_len, len - prefix_len + 1);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int jz4740_kexec_prepare(struct kimage *image)
+{
+	struct jz4740_kexec_args *args;
+	int ret;
+
+	BUILD_BUG_ON(sizeof(*args) > KEXEC_CONTROL_PAGE_SIZE - PAGE_SIZE);
+
+	/* The first page holds the relocation code */
+	args = page_address(image->control_code_page) + PAGE_SIZE;
+
+	ret = jz4740_kexec_find_cmdline(image, args->cmdline);
+	if (ret < 0)
+		return ret;
+
+	/* Without a command line the new kernel uses its built-in one */
+	if (ret == 0 || !args->cmdline[0]) {
+		kexec_args[0] = 0;
+		kexec_args[1] = 0;
+		return 0;
+	}
+
+	/* The prom code skips argv[0] like the boot loader's program name */
+	args->argv[0] = args->cmdline + strlen(args->cmdline);
+	args->argv[1] = args->cmdline;
+	args->argv[2] = NULL;
+
+	kexec_args[0] = 2;
+	kexec_args[1] = (unsigned long)args->argv;
+
+	return 0;
+}
+
+static int __init jz4740_kexec_init(void)
+{
+	_machine_kexec_prepare = jz4740_kexec_prepare;
+
+	return 0;
+}
+arch_initcall(jz4740_kexec_init);
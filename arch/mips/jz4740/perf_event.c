@@ -0,0 +1,336 @@
+/*
+ *  JZ4740 TCU based perf sampling support
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under  the terms of the GNU General	 Public License as published by the
+ *  Free Software Foundation;  either version 2 of the License, or (at your
+ *  option) any later version.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+/*
+ * The XBurst core has no performance counters. Cycles are instead derived
+ * from the elapsed time and the current CPU clock rate, and sampling is
+ * driven by a dedicated TCU channel. This gives perf a cycles event whose
+ * samples do not depend on the hrtimer and tick machinery.
+ *
+ * There is no NMI, so a sample that falls into a region with interrupts
+ * disabled is taken when they are enabled again. The timer keeps counting
+ * past its period, so the handler knows how late it runs and reports that
+ * delay as the sample weight: irq-off regions show up as heavy samples at
+ * the point where interrupts get re-enabled.
+ */
+
+#include <linux/clk.h>
+#include <linux/err.h>
+#include <linux/init.h>
+#include <linux/interrupt.h>
+#include <linux/io.h>
+#include <linux/kernel.h>
+#include <linux/perf_event.h>
+#include <linux/sched.h>
+
+#include <asm/irq_regs.h>
+
+#include <asm/mach-jz4740/clock.h>
+#include <asm/mach-jz4740/irq.h>
+#include <asm/mach-jz4740/timer.h>
+
+#include "irq.h"
+
+#define TIMER_PMU JZ4740_TCU_PMU_TIMER
+
+/* Prescaler steps are a factor of 4 each, from 1 up to 1024 */
+#define TIMER_PMU_PRESCALE_MAX	5
+
+struct jz4740_pmu {
+	struct perf_event *event;
+	struct clk *cpu_clk;
+	struct notifier_block clk_nb;
+
+	unsigned long cpu_khz;
+	unsigned long timer_khz;
+	unsigned int prescale;
+};
+
+static struct jz4740_pmu jz4740_pmu;
+
+static u64 jz4740_pmu_ns_to_cycles(u64 ns)
+{
+	return div_u64(ns * jz4740_pmu.cpu_khz, USEC_PER_SEC);
+}
+
+static void jz4740_pmu_event_update(struct perf_event *event)
+{
+	struct hw_perf_event *hwc = &event->hw;
+	u64 now, prev, delta;
+
+	now = local_clock();
+	prev = local64_xchg(&hwc->prev_count, now);
+	delta = jz4740_pmu_ns_to_cycles(now - prev);
+
+	local64_add(delta, &event->count);
+	local64_sub(delta, &hwc->period_left);
+}
+
+static void jz4740_pmu_timer_program(struct perf_event *event)
+{
+	struct hw_perf_event *hwc = &event->hw;
+	s64 left = local64_read(&hwc->period_left);
+	unsigned int prescale = 0;
+	u64 ticks;
+
+	if (left <= 0) {
+		left += hwc->sample_period;
+		hwc->last_period = hwc->sample_period;
+		local64_set(&hwc->period_left, left);
+	}
+
+	ticks = div_u64((u64)left * jz4740_pmu.timer_khz, jz4740_pmu.cpu_khz);
+
+	while (ticks > 0xffff && prescale < TIMER_PMU_PRESCALE_MAX) {
+		ticks >>= 2;
+		++prescale;
+	}
+	ticks = clamp_t(u64, ticks, 1, 0xffff);
+	jz4740_pmu.prescale = prescale;
+
+	jz4740_timer_disable(TIMER_PMU);
+	jz4740_timer_set_ctrl(TIMER_PMU,
+		JZ_TIMER_CTRL_PRESCALER(prescale) | JZ_TIMER_CTRL_SRC_EXT);
+	jz4740_timer_set_count(TIMER_PMU, 0);
+	jz4740_timer_set_period(TIMER_PMU, ticks);
+	jz4740_timer_irq_full_enable(TIMER_PMU);
+	jz4740_timer_enable(TIMER_PMU);
+}
+
+static void jz4740_pmu_timer_stop(void)
+{
+	jz4740_timer_irq_full_disable(TIMER_PMU);
+	jz4740_timer_disable(TIMER_PMU);
+}
+
+/*
+ * Time since the timer expired. The count restarts from zero at the end of
+ * each period, so a delay longer than one period is not seen in full.
+ */
+static u64 jz4740_pmu_irq_delay_ns(void)
+{
+	u64 ticks = jz4740_timer_get_count(TIMER_PMU);
+
+	ticks <<= 2 * jz4740_pmu.prescale;
+
+	return div_u64(ticks * USEC_PER_SEC, jz4740_pmu.timer_khz);
+}
+
+static irqreturn_t jz4740_pmu_irq(int irq, void *devid)
+{
+	struct perf_event *event = jz4740_pmu.event;
+	struct perf_sample_data data;
+	struct hw_perf_event *hwc;
+	u64 delay;
+
+	if (!(readl(jz4740_timer_base + JZ_REG_TIMER_FLAG) &
+			JZ_TIMER_IRQ_FULL(TIMER_PMU)))
+		return IRQ_NONE;
+
+	delay = jz4740_pmu_irq_delay_ns();
+	jz4740_timer_ack_full(TIMER_PMU);
+
+	if (!event || !is_sampling_event(event)) {
+		jz4740_pmu_timer_stop();
+		return IRQ_HANDLED;
+	}
+
+	hwc = &event->hw;
+	jz4740_pmu_event_update(event);
+
+	/* A period longer than the timer can cover takes several interrupts */
+	if (local64_read(&hwc->period_left) > 0) {
+		jz4740_pmu_timer_program(event);
+		return IRQ_HANDLED;
+	}
+
+	perf_sample_data_init(&data, 0, hwc->last_period);
+	if (event->attr.sample_type & PERF_SAMPLE_WEIGHT)
+		data.weight = delay;
+	jz4740_pmu_timer_program(event);
+
+	if (perf_event_overflow(event, &data, get_irq_regs())) {
+		jz4740_pmu_timer_stop();
+		jz4740_pmu_event_update(event);
+		hwc->state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+	}
+
+	return IRQ_HANDLED;
+}
+
+static struct irqaction jz4740_pmu_irqaction = {
+	.handler = jz4740_pmu_irq,
+	.flags = IRQF_TIMER,
+	.name = "jz4740-pmu",
+};
+
+static void jz4740_pmu_start(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	hwc->state = 0;
+	local64_set(&hwc->prev_count, local_clock());
+
+	if (is_sampling_event(event))
+		jz4740_pmu_timer_program(event);
+}
+
+static void jz4740_pmu_stop(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	if (hwc->state & PERF_HES_STOPPED)
+		return;
+
+	jz4740_pmu_timer_stop();
+	jz4740_pmu_event_update(event);
+	hwc->state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+}
+
+static int jz4740_pmu_add(struct perf_event *event, int flags)
+{
+	if (jz4740_pmu.event)
+		return -EAGAIN;
+
+	jz4740_pmu.event = event;
+	event->hw.state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+
+	if (flags & PERF_EF_START)
+		jz4740_pmu_start(event, PERF_EF_RELOAD);
+
+	perf_event_update_userpage(event);
+
+	return 0;
+}
+
+static void jz4740_pmu_del(struct perf_event *event, int flags)
+{
+	jz4740_pmu_stop(event, PERF_EF_UPDATE);
+	jz4740_pmu.event = NULL;
+
+	perf_event_update_userpage(event);
+}
+
+static void jz4740_pmu_read(struct perf_event *event)
+{
+	if (!(event->hw.state & PERF_HES_STOPPED))
+		jz4740_pmu_event_update(event);
+}
+
+static int jz4740_pmu_event_init(struct perf_event *event)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	switch (event->attr.type) {
+	case PERF_TYPE_HARDWARE:
+		if (event->attr.config != PERF_COUNT_HW_CPU_CYCLES)
+			return -ENOENT;
+		break;
+	case PERF_TYPE_RAW:
+		if (event->attr.config != 0)
+			return -ENOENT;
+		break;
+	default:
+		return -ENOENT;
+	}
+
+	/* There is no way to tell apart user, kernel or idle cycles */
+	if (event->attr.exclude_user || event->attr.exclude_kernel ||
+	    event->attr.exclude_hv || event->attr.exclude_idle)
+		return -EOPNOTSUPP;
+
+	if (has_branch_stack(event))
+		return -EOPNOTSUPP;
+
+	if (is_sampling_event(event)) {
+		hwc->last_period = hwc->sample_period;
+		local64_set(&hwc->period_left, hwc->sample_period);
+	}
+
+	return 0;
+}
+
+static struct pmu jz4740_pmu_ops = {
+	.event_init = jz4740_pmu_event_init,
+	.add = jz4740_pmu_add,
+	.del = jz4740_pmu_del,
+	.start = jz4740_pmu_start,
+	.stop = jz4740_pmu_stop,
+	.read = jz4740_pmu_read,
+};
+
+static int jz4740_pmu_clk_notify(struct notifier_block *nb,
+	unsigned long action, void *data)
+{
+	struct clk_notifier_data *cnd = data;
+	struct perf_event *event;
+	unsigned long flags;
+
+	if (action != POST_RATE_CHANGE)
+		return NOTIFY_OK;
+
+	/* Account the cycles up to now at the old rate */
+	local_irq_save(flags);
+	event = jz4740_pmu.event;
+	if (event && !(event->hw.state & PERF_HES_STOPPED))
+		jz4740_pmu_event_update(event);
+	jz4740_pmu.cpu_khz = cnd->new_rate / 1000;
+	local_irq_restore(flags);
+
+	return NOTIFY_OK;
+}
+
+static int __init jz4740_pmu_init(void)
+{
+	int ret;
+
+	jz4740_pmu.cpu_clk = clk_get(NULL, "cclk");
+	if (IS_ERR(jz4740_pmu.cpu_clk))
+		return PTR_ERR(jz4740_pmu.cpu_clk);
+
+	jz4740_pmu.cpu_khz = clk_get_rate(jz4740_pmu.cpu_clk) / 1000;
+	jz4740_pmu.timer_khz = jz4740_clock_bdata.ext_rate / 1000;
+
+	jz4740_pmu.clk_nb.notifier_call = jz4740_pmu_clk_notify;
+	ret = clk_notifier_register(jz4740_pmu.cpu_clk, &jz4740_pmu.clk_nb);
+	if (ret)
+		goto err_clk_put;
+
+	jz4740_timer_start(TIMER_PMU);
+
+	ret = setup_irq(JZ4740_IRQ_TCU2, &jz4740_pmu_irqaction);
+	if (ret)
+		goto err_timer_stop;
+
+	/* Keep other pending sources from adding to the sample skid */
+	jz4740_irq_set_urgent(JZ4740_IRQ_TCU2);
+
+	ret = perf_pmu_register(&jz4740_pmu_ops, "cpu", PERF_TYPE_RAW);
+	if (ret)
+		goto err_free_irq;
+
+	pr_info("JZ4740 TCU based perf sampling enabled\n");
+
+	return 0;
+
+err_free_irq:
+	remove_irq(JZ4740_IRQ_TCU2, &jz4740_pmu_irqaction);
+err_timer_stop:
+	jz4740_timer_stop(TIMER_PMU);
+	clk_notifier_unregister(jz4740_pmu.cpu_clk, &jz4740_pmu.clk_nb);
+err_clk_put:
+	clk_put(jz4740_pmu.cpu_clk);
+	return ret;
+}
+device_initcall(jz4740_pmu_init);
@@ -24,13 +24,13 @@
 
 #include <asm/mach-jz4740/platform.h>
 #include <asm/mach-jz4740/base.h>
+#include <asm/mach-jz4740/clock.h>
 #include <asm/mach-jz4740/irq.h>
 
 #include <linux/serial_core.h>
 #include <linux/serial_8250.h>
 
 #include "serial.h"
-#include "clock.h"
 
 /* OHCI controller */
 static struct resource jz4740_usb_ohci_resources[] = {
@@ -155,6 +155,27 @@ struct platform_device jz4740_i2c_device = {
 	.resource	= jz4740_i2c_resources,
 };
 
+/* SSI (SPI) controller */
+static struct resource jz4740_spi_resources[] = {
+	{
+		.start	= JZ4740_SSI_BASE_ADDR,
+		.end	= JZ4740_SSI_BASE_ADDR + 0x1000 - 1,
+		.flags	= IORESOURCE_MEM,
+	},
+	{
+		.start	= JZ4740_IRQ_SSI,
+		.end	= JZ4740_IRQ_SSI,
+		.flags	= IORESOURCE_IRQ,
+	},
+};
+
+struct platform_device jz4740_spi_device = {
+	.name		= "jz4740-spi",
+	.id		= 0,
+	.num_resources	= ARRAY_SIZE(jz4740_spi_resources),
+	.resource	= jz4740_spi_resources,
+};
+
 /* NAND controller */
 static struct resource jz4740_nand_resources[] = {
 	{
@@ -202,6 +223,11 @@ static struct resource jz4740_framebuffer_resources[] = {
 		.end	= JZ4740_LCD_BASE_ADDR + 0x1000 - 1,
 		.flags	= IORESOURCE_MEM,
 	},
+	{
+		.start	= JZ4740_IRQ_LCD,
+		.end	= JZ4740_IRQ_LCD,
+		.flags	= IORESOURCE_IRQ,
+	},
 };
 
 struct platform_device jz4740_framebuffer_device = {
@@ -354,6 +380,42 @@ static struct resource jz4740_dma_resources[] = {
 struct platform_device jz4740_dma_device = {
 	.name		= "jz4740-dma",
 	.id		= -1,
+	.dev = {
+		.dma_mask = &jz4740_dma_device.dev.coherent_dma_mask,
+		.coherent_dma_mask = DMA_BIT_MASK(32),
+	},
 	.num_resources	= ARRAY_SIZE(jz4740_dma_resources),
 	.resource	= jz4740_dma_resources,
 };
+
+/* CPU idle, uses the SDRAM control register of the EMC */
+static struct resource jz4740_cpuidle_resources[] = {
+	{
+		.start	= JZ4740_EMC_BASE_ADDR + 0x80,
+		.end	= JZ4740_EMC_BASE_ADDR + 0x84 - 1,
+		.flags	= IORESOURCE_MEM,
+	},
+};
+
+struct platform_device jz4740_cpuidle_device = {
+	.name		= "cpuidle-jz4740",
+	.id		= -1,
+	.num_resources	= ARRAY_SIZE(jz4740_cpuidle_resources),
+	.resource	= jz4740_cpuidle_resources,
+};
+
+/* Memory bus devfreq, uses the SDRAM control and refresh registers */
+static struct resource jz4740_devfreq_resources[] = {
+	{
+		.start	= JZ4740_EMC_BASE_ADDR + 0x80,
+		.end	= JZ4740_EMC_BASE_ADDR + 0x90 - 1,
+		.flags	= IORESOURCE_MEM,
+	},
+};
+
+struct platform_device jz4740_devfreq_device = {
+	.name		= "jz4740-devfreq",
+	.id		= -1,
+	.num_resources	= ARRAY_SIZE(jz4740_devfreq_resources),
+	.resource	= jz4740_devfreq_resources,
+};
@@ -14,17 +14,52 @@
  */
 
 #include <linux/init.h>
+#include <linux/module.h>
+#include <linux/platform_device.h>
 #include <linux/pm.h>
 #include <linux/delay.h>
+#include <linux/io.h>
+#include <linux/sched.h>
 #include <linux/suspend.h>
 
 #include <asm/mach-jz4740/clock.h>
+#include <asm/mach-jz4740/platform.h>
+#include <asm/mach-jz4740/timer.h>
 
-#include "clock.h"
+/*
+ * Keeping the PLL running while asleep costs some power, but saves waiting
+ * for it to relock on every resume.
+ */
+static bool keep_pll;
+module_param(keep_pll, bool, 0644);
+MODULE_PARM_DESC(keep_pll, "Keep the PLL running during suspend to RAM");
+
+/*
+ * The resume callbacks of these devices only touch their own hardware, so
+ * they can run in parallel to each other and to the rest of the system.
+ */
+static struct platform_device *jz4740_async_pm_devices[] __initdata = {
+	&jz4740_usb_ohci_device,
+	&jz4740_mmc_device,
+	&jz4740_rtc_device,
+	&jz4740_framebuffer_device,
+};
 
 static int jz4740_pm_enter(suspend_state_t state)
 {
+	bool pll_off = !keep_pll;
+	uint16_t start, end;
+
+	/*
+	 * sched_clock() is suspended by now, so read the clocksource counter
+	 * itself. It wraps every 2^16 ticks at EXT/16, ~87ms with a 12MHz
+	 * crystal, which is well above the time taken here.
+	 */
+	start = jz4740_timer_get_count(JZ4740_TCU_CLOCKSOURCE_TIMER);
+
 	jz4740_clock_suspend();
+	if (pll_off)
+		jz4740_clock_pll_disable();
 
 	jz4740_clock_set_wait_mode(JZ4740_WAIT_MODE_SLEEP);
 
@@ -34,8 +69,21 @@ static int jz4740_pm_enter(suspend_state_t state)
 
 	jz4740_clock_set_wait_mode(JZ4740_WAIT_MODE_IDLE);
 
+	if (pll_off)
+		jz4740_clock_pll_enable();
 	jz4740_clock_resume();
 
+	/*
+	 * The timer is gated while asleep, so this is the time spent entering
+	 * and leaving sleep mode, without the time spent in it.
+	 */
+	end = jz4740_timer_get_count(JZ4740_TCU_CLOCKSOURCE_TIMER);
+	if (pm_print_times_enabled)
+		pr_info("PM: sleep mode entry and exit took %llu usecs%s\n",
+			div_u64((u64)(uint16_t)(end - start) * USEC_PER_SEC,
+				jz4740_clock_bdata.ext_rate >> 4),
+			pll_off ? "" : ", PLL kept running");
+
 	return 0;
 }
 
@@ -46,6 +94,11 @@ static const struct platform_suspend_ops jz4740_pm_ops = {
 
 static int __init jz4740_pm_init(void)
 {
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(jz4740_async_pm_devices); ++i)
+		device_enable_async_suspend(&jz4740_async_pm_devices[i]->dev);
+
 	suspend_set_ops(&jz4740_pm_ops);
 	return 0;
 
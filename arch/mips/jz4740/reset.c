@@ -19,10 +19,10 @@
 #include <asm/reboot.h>
 
 #include <asm/mach-jz4740/base.h>
+#include <asm/mach-jz4740/clock.h>
 #include <asm/mach-jz4740/timer.h>
 
 #include "reset.h"
-#include "clock.h"
 
 static void jz4740_halt(void)
 {
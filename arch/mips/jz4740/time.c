@@ -18,15 +18,18 @@
 #include <linux/time.h>
 
 #include <linux/clockchips.h>
+#include <linux/sched_clock.h>
 
+#include <asm/mach-jz4740/base.h>
 #include <asm/mach-jz4740/irq.h>
 #include <asm/mach-jz4740/timer.h>
+#include <asm/mach-jz4740/clock.h>
 #include <asm/time.h>
+#include <asm/vdso.h>
 
-#include "clock.h"
 
 #define TIMER_CLOCKEVENT 0
-#define TIMER_CLOCKSOURCE 1
+#define TIMER_CLOCKSOURCE JZ4740_TCU_CLOCKSOURCE_TIMER
 
 static uint16_t jz4740_jiffies_per_tick;
 
@@ -35,6 +38,11 @@ static cycle_t jz4740_clocksource_read(struct clocksource *cs)
 	return jz4740_timer_get_count(TIMER_CLOCKSOURCE);
 }
 
+static u64 notrace jz4740_read_sched_clock(void)
+{
+	return jz4740_timer_get_count(TIMER_CLOCKSOURCE);
+}
+
 static struct clocksource jz4740_clocksource = {
 	.name = "jz4740-timer",
 	.rating = 200,
@@ -116,11 +124,21 @@ void __init plat_time_init(void)
 
 	clockevent_set_clock(&jz4740_clockevent, clk_rate);
 	jz4740_clockevent.min_delta_ns = clockevent_delta2ns(100, &jz4740_clockevent);
+	/*
+	 * A coarser prescaler would not let NO_HZ idle any longer: it may
+	 * not sleep past a wrap of the 16 bit clocksource, which runs at the
+	 * same rate, so the idle length is bounded at about 76ms by the
+	 * clocksource rather than by the clockevent range.
+	 */
 	jz4740_clockevent.max_delta_ns = clockevent_delta2ns(0xffff, &jz4740_clockevent);
 	jz4740_clockevent.cpumask = cpumask_of(0);
 
 	clockevents_register_device(&jz4740_clockevent);
 
+	/* The TCU counters can be read from userspace without side effects */
+	mips_vdso_register_counter(&jz4740_clocksource,
+		JZ4740_TCU_BASE_ADDR + JZ_REG_TIMER_CNT(TIMER_CLOCKSOURCE));
+
 	ret = clocksource_register_hz(&jz4740_clocksource, clk_rate);
 
 	if (ret)
@@ -140,4 +158,6 @@ void __init plat_time_init(void)
 
 	jz4740_timer_enable(TIMER_CLOCKEVENT);
 	jz4740_timer_enable(TIMER_CLOCKSOURCE);
+
+	sched_clock_register(jz4740_read_sched_clock, 16, clk_rate);
 }
@@ -30,10 +30,44 @@
 
 #ifdef CONFIG_DYNAMIC_FTRACE
 
+/*
+ * While arch_ftrace_update_code() runs, the icache isn't flushed after each
+ * call site is patched. The touched range is recorded instead and flushed
+ * in one go, which for the whole kernel is a single blast of the caches.
+ * Until then a site runs either its old or its new instruction, and both
+ * are fine. The trampolines in mcount.S are still flushed right away, after
+ * the pending call sites, so the generic code sees its updates in order.
+ */
+static bool ftrace_batch;
+static unsigned long ftrace_batch_start = ULONG_MAX;
+static unsigned long ftrace_batch_end;
+
+static void ftrace_flush_batch(void)
+{
+	if (ftrace_batch_start < ftrace_batch_end)
+		flush_icache_range(ftrace_batch_start, ftrace_batch_end);
+	ftrace_batch_start = ULONG_MAX;
+	ftrace_batch_end = 0;
+}
+
+static void ftrace_flush_site(unsigned long ip)
+{
+	if (!ftrace_batch) {
+		flush_icache_range(ip, ip + 8);
+		return;
+	}
+
+	ftrace_batch_start = min(ftrace_batch_start, ip);
+	ftrace_batch_end = max(ftrace_batch_end, ip + 8);
+}
+
 /* Arch override because MIPS doesn't need to run this from stop_machine() */
 void arch_ftrace_update_code(int command)
 {
+	ftrace_batch = true;
 	ftrace_modify_all_code(command);
+	ftrace_flush_batch();
+	ftrace_batch = false;
 }
 
 #endif
@@ -87,10 +121,14 @@ static inline void ftrace_dyn_arch_init_insns(void)
 #endif
 }
 
+/* Patch one of the trampolines in mcount.S */
 static int ftrace_modify_code(unsigned long ip, unsigned int new_code)
 {
 	int faulted;
 
+	/* Call sites patched so far must be visible first */
+	ftrace_flush_batch();
+
 	/* *(unsigned int *)ip = new_code; */
 	safe_store_code(new_code, ip, faulted);
 
@@ -102,8 +140,20 @@ static int ftrace_modify_code(unsigned long ip, unsigned int new_code)
 	return 0;
 }
 
+/* Patch a call site of _mcount */
+static int ftrace_modify_site(unsigned long ip, unsigned int new_code)
+{
+	int faulted;
+
+	safe_store_code(new_code, ip, faulted);
+	if (unlikely(faulted))
+		return -EFAULT;
+	ftrace_flush_site(ip);
+	return 0;
+}
+
 #ifndef CONFIG_64BIT
-static int ftrace_modify_code_2(unsigned long ip, unsigned int new_code1,
+static int ftrace_modify_site_2(unsigned long ip, unsigned int new_code1,
 				unsigned int new_code2)
 {
 	int faulted;
@@ -114,7 +164,7 @@ static int ftrace_modify_code_2(unsigned long ip, unsigned int new_code1,
 	safe_store_code(new_code2, ip + 4, faulted);
 	if (unlikely(faulted))
 		return -EFAULT;
-	flush_icache_range(ip, ip + 8);
+	ftrace_flush_site(ip);
 	return 0;
 }
 #endif
@@ -162,7 +212,7 @@ int ftrace_make_nop(struct module *mod,
 	 */
 	new = in_kernel_space(ip) ? INSN_NOP : INSN_B_1F;
 #ifdef CONFIG_64BIT
-	return ftrace_modify_code(ip, new);
+	return ftrace_modify_site(ip, new);
 #else
 	/*
 	 * On 32 bit MIPS platforms, gcc adds a stack adjust
@@ -171,7 +221,7 @@ int ftrace_make_nop(struct module *mod,
 	 * This is based on a legacy API and does nothing but
 	 * waste instructions so it's being removed at runtime.
 	 */
-	return ftrace_modify_code_2(ip, new, INSN_NOP);
+	return ftrace_modify_site_2(ip, new, INSN_NOP);
 #endif
 }
 
@@ -183,7 +233,7 @@ int ftrace_make_call(struct dyn_ftrace *rec, unsigned long addr)
 	new = in_kernel_space(ip) ? insn_jal_ftrace_caller :
 		insn_lui_v1_hi16_mcount;
 
-	return ftrace_modify_code(ip, new);
+	return ftrace_modify_site(ip, new);
 }
 
 #define FTRACE_CALL_IP ((unsigned long)(&ftrace_call))
@@ -11,6 +11,7 @@
 #include <linux/delay.h>
 
 #include <asm/cacheflush.h>
+#include <asm/cpu-features.h>
 #include <asm/page.h>
 
 extern const unsigned char relocate_new_kernel[];
@@ -18,6 +19,10 @@ extern const size_t relocate_new_kernel_size;
 
 extern unsigned long kexec_start_address;
 extern unsigned long kexec_indirection_page;
+extern unsigned long kexec_dcache_size;
+extern unsigned long kexec_dcache_line;
+extern unsigned long kexec_icache_size;
+extern unsigned long kexec_icache_line;
 
 int (*_machine_kexec_prepare)(struct kimage *) = NULL;
 void (*_machine_kexec_shutdown)(void) = NULL;
@@ -74,6 +79,20 @@ machine_kexec(struct kimage *image)
 	kexec_indirection_page =
 		(unsigned long) phys_to_virt(image->head & PAGE_MASK);
 
+	/*
+	 * The relocation code copies the new kernel through the data cache,
+	 * so on CPUs with R4000 style caches it has to flush them itself
+	 * before jumping there.
+	 */
+	if (cpu_has_4k_cache) {
+		kexec_dcache_size = current_cpu_data.dcache.waysize *
+			current_cpu_data.dcache.ways;
+		kexec_dcache_line = current_cpu_data.dcache.linesz;
+		kexec_icache_size = current_cpu_data.icache.waysize *
+			current_cpu_data.icache.ways;
+		kexec_icache_line = current_cpu_data.icache.linesz;
+	}
+
 	memcpy((void*)reboot_code_buffer, relocate_new_kernel,
 	       relocate_new_kernel_size);
 
@@ -94,9 +94,9 @@ static int apply_r_mips_hi16_rel(struct module *me, u32 *location, Elf_Addr v)
 	 * the carry we need to add.  Save the information, and let LO16 do the
 	 * actual relocation.
 	 */
-	n = kmalloc(sizeof *n, GFP_KERNEL);
-	if (!n)
-		return -ENOMEM;
+	if (!me->arch.r_mips_hi16_free)
+		return -ENOEXEC;
+	n = me->arch.r_mips_hi16_pool + --me->arch.r_mips_hi16_free;
 
 	n->addr = (Elf_Addr *)location;
 	n->value = v;
@@ -106,17 +106,6 @@ static int apply_r_mips_hi16_rel(struct module *me, u32 *location, Elf_Addr v)
 	return 0;
 }
 
-static void free_relocation_chain(struct mips_hi16 *l)
-{
-	struct mips_hi16 *next;
-
-	while (l) {
-		next = l->next;
-		kfree(l);
-		l = next;
-	}
-}
-
 static int apply_r_mips_lo16_rel(struct module *me, u32 *location, Elf_Addr v)
 {
 	unsigned long insnlo = *location;
@@ -129,7 +118,6 @@ static int apply_r_mips_lo16_rel(struct module *me, u32 *location, Elf_Addr v)
 	if (me->arch.r_mips_hi16_list != NULL) {
 		l = me->arch.r_mips_hi16_list;
 		while (l != NULL) {
-			struct mips_hi16 *next;
 			unsigned long insn;
 
 			/*
@@ -157,9 +145,7 @@ static int apply_r_mips_lo16_rel(struct module *me, u32 *location, Elf_Addr v)
 			insn = (insn & ~0xffff) | val;
 			*l->addr = insn;
 
-			next = l->next;
-			kfree(l);
-			l = next;
+			l = l->next;
 		}
 
 		me->arch.r_mips_hi16_list = NULL;
@@ -175,7 +161,6 @@ static int apply_r_mips_lo16_rel(struct module *me, u32 *location, Elf_Addr v)
 	return 0;
 
 out_danger:
-	free_relocation_chain(l);
 	me->arch.r_mips_hi16_list = NULL;
 
 	pr_err("module %s: dangerous R_MIPS_LO16 REL relocation\n", me->name);
@@ -197,17 +182,39 @@ int apply_relocate(Elf_Shdr *sechdrs, const char *strtab,
 		   struct module *me)
 {
 	Elf_Mips_Rel *rel = (void *) sechdrs[relsec].sh_addr;
+	unsigned int i, nrel = sechdrs[relsec].sh_size / sizeof(*rel);
+	unsigned int nhi16 = 0;
 	Elf_Sym *sym;
 	u32 *location;
-	unsigned int i;
 	Elf_Addr v;
-	int res;
+	int res = 0;
 
 	pr_debug("Applying relocate section %u to %u\n", relsec,
 	       sechdrs[relsec].sh_info);
 
+	/*
+	 * Allocate the entries for pending R_MIPS_HI16 relocations in one
+	 * go rather than once per relocation.
+	 */
+	for (i = 0; i < nrel; i++)
+		if (ELF_MIPS_R_TYPE(rel[i]) == R_MIPS_HI16)
+			nhi16++;
+
 	me->arch.r_mips_hi16_list = NULL;
-	for (i = 0; i < sechdrs[relsec].sh_size / sizeof(*rel); i++) {
+	me->arch.r_mips_hi16_pool = NULL;
+	me->arch.r_mips_hi16_free = nhi16;
+	if (nhi16) {
+		size_t size = nhi16 * sizeof(*me->arch.r_mips_hi16_pool);
+
+		if (size <= PAGE_SIZE)
+			me->arch.r_mips_hi16_pool = kmalloc(size, GFP_KERNEL);
+		else
+			me->arch.r_mips_hi16_pool = vmalloc(size);
+		if (!me->arch.r_mips_hi16_pool)
+			return -ENOMEM;
+	}
+
+	for (i = 0; i < nrel; i++) {
 		/* This is where to make the change */
 		location = (void *)sechdrs[sechdrs[relsec].sh_info].sh_addr
 			+ rel[i].r_offset;
@@ -220,30 +227,34 @@ int apply_relocate(Elf_Shdr *sechdrs, const char *strtab,
 				continue;
 			printk(KERN_WARNING "%s: Unknown symbol %s\n",
 			       me->name, strtab + sym->st_name);
-			return -ENOENT;
+			res = -ENOENT;
+			goto out;
 		}
 
 		v = sym->st_value;
 
 		res = reloc_handlers_rel[ELF_MIPS_R_TYPE(rel[i])](me, location, v);
 		if (res)
-			return res;
+			goto out;
 	}
 
 	/*
-	 * Normally the hi16 list should be deallocated at this point.	A
+	 * Normally the hi16 list should be empty at this point.  A
 	 * malformed binary however could contain a series of R_MIPS_HI16
 	 * relocations not followed by a R_MIPS_LO16 relocation.  In that
-	 * case, free up the list and return an error.
+	 * case, return an error.
 	 */
-	if (me->arch.r_mips_hi16_list) {
-		free_relocation_chain(me->arch.r_mips_hi16_list);
-		me->arch.r_mips_hi16_list = NULL;
+	if (me->arch.r_mips_hi16_list)
+		res = -ENOEXEC;
 
-		return -ENOEXEC;
-	}
-
-	return 0;
+out:
+	me->arch.r_mips_hi16_list = NULL;
+	if (is_vmalloc_addr(me->arch.r_mips_hi16_pool))
+		vfree(me->arch.r_mips_hi16_pool);
+	else
+		kfree(me->arch.r_mips_hi16_pool);
+	me->arch.r_mips_hi16_pool = NULL;
+	return res;
 }
 
 /* Given an address, look for it in the module exception tables. */
@@ -0,0 +1,47 @@
+/*
+ * Kernel mode use of the Ingenic XBurst MXU SIMD unit
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ */
+#include <linux/bug.h>
+#include <linux/export.h>
+#include <linux/preempt.h>
+#include <linux/sched.h>
+
+#include <asm/mxu.h>
+
+/**
+ * kernel_mxu_begin - start using the MXU in kernel mode
+ *
+ * Saves the MXU state of the current task if it has the unit enabled, and
+ * enables the unit for the kernel. Preemption stays disabled until the
+ * matching kernel_mxu_end(). Must only be called if may_use_mxu() is true.
+ */
+void kernel_mxu_begin(void)
+{
+	BUG_ON(!may_use_mxu());
+
+	preempt_disable();
+	__read_mxu_state(&current->thread.mxu);
+	write_mxu_reg(MXU_CR, MXU_CR_EN);
+}
+EXPORT_SYMBOL_GPL(kernel_mxu_begin);
+
+/**
+ * kernel_mxu_end - stop using the MXU in kernel mode
+ *
+ * Gives the MXU back to the current task, in the state in which
+ * kernel_mxu_begin() found it.
+ */
+void kernel_mxu_end(void)
+{
+	if (current->thread.mxu.mxu_cr & MXU_CR_EN)
+		__write_mxu_state(&current->thread.mxu);
+	else
+		write_mxu_reg(MXU_CR, 0);
+	preempt_enable();
+}
+EXPORT_SYMBOL_GPL(kernel_mxu_end);
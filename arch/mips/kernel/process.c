@@ -32,6 +32,7 @@
 #include <asm/cpu.h>
 #include <asm/dsp.h>
 #include <asm/fpu.h>
+#include <asm/mxu.h>
 #include <asm/pgtable.h>
 #include <asm/mipsregs.h>
 #include <asm/processor.h>
@@ -65,6 +66,7 @@ void start_thread(struct pt_regs * regs, unsigned long pc, unsigned long sp)
 	clear_used_math();
 	clear_fpu_owner();
 	init_dsp();
+	init_mxu();
 	regs->cp0_epc = pc;
 	regs->regs[29] = sp;
 }
@@ -95,6 +97,10 @@ int copy_thread(unsigned long clone_flags, unsigned long usp,
 	if (cpu_has_dsp)
 		save_dsp(p);
 
+	/* the child starts out with a copy of the live MXU state */
+	if (cpu_has_mxu)
+		__read_mxu_state(&p->thread.mxu);
+
 	preempt_enable();
 
 	/* set up new TSS. */
@@ -102,6 +108,8 @@ int copy_thread(unsigned long clone_flags, unsigned long usp,
 	/*  Put the stack after the struct pt_regs.  */
 	childksp = (unsigned long) childregs;
 	p->thread.cp0_status = read_c0_status() & ~(ST0_CU2|ST0_CU1);
+	p->thread.unaligned_count = 0;
+	p->thread.unaligned_pc = 0;
 	if (unlikely(p->flags & PF_KTHREAD)) {
 		unsigned long status = p->thread.cp0_status;
 		memset(childregs, 0, sizeof(struct pt_regs));
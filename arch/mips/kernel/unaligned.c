@@ -74,6 +74,7 @@
  */
 #include <linux/context_tracking.h>
 #include <linux/mm.h>
+#include <linux/ptrace.h>
 #include <linux/signal.h>
 #include <linux/smp.h>
 #include <linux/sched.h>
@@ -107,6 +108,21 @@ static u32 unaligned_action;
 #endif
 extern void show_registers(struct pt_regs *regs);
 
+/*
+ * Account an access that was fixed up. User accesses are also counted per
+ * thread, along with the last PC that needed it, for /proc/<pid>/unaligned.
+ */
+static inline void unaligned_fixed(struct pt_regs *regs, unsigned long pc)
+{
+#ifdef CONFIG_DEBUG_FS
+	unaligned_instructions++;
+#endif
+	if (user_mode(regs)) {
+		current->thread.unaligned_count++;
+		current->thread.unaligned_pc = pc;
+	}
+}
+
 #ifdef __BIG_ENDIAN
 #define     LoadHW(addr, value, res)  \
 		__asm__ __volatile__ (".set\tnoat\n"        \
@@ -647,9 +663,7 @@ static void emulate_load_store_insn(struct pt_regs *regs,
 		goto sigill;
 	}
 
-#ifdef CONFIG_DEBUG_FS
-	unaligned_instructions++;
-#endif
+	unaligned_fixed(regs, origpc);
 
 	return;
 
@@ -1275,9 +1289,7 @@ storeDW:
 success:
 	regs->cp0_epc = contpc;	/* advance or branch */
 
-#ifdef CONFIG_DEBUG_FS
-	unaligned_instructions++;
-#endif
+	unaligned_fixed(regs, origpc);
 	return;
 
 fault:
@@ -1519,9 +1531,7 @@ writeDW:
 		goto sigill;
 	}
 
-#ifdef CONFIG_DEBUG_FS
-	unaligned_instructions++;
-#endif
+	unaligned_fixed(regs, origpc);
 
 	return;
 
@@ -1655,3 +1665,43 @@ static int __init debugfs_unaligned(void)
 }
 __initcall(debugfs_unaligned);
 #endif
+
+#ifdef CONFIG_PROC_FS
+static int do_proc_unaligned(struct task_struct *task, char *buffer,
+			     int whole)
+{
+	unsigned long count = task->thread.unaligned_count;
+	unsigned long pc = task->thread.unaligned_pc;
+	struct task_struct *t = task;
+	unsigned long flags;
+
+	if (!ptrace_may_access(task, PTRACE_MODE_READ))
+		return -EACCES;
+
+	/* For the process, report the PC of the thread with the most */
+	if (whole && lock_task_sighand(task, &flags)) {
+		unsigned long most = count;
+
+		while_each_thread(task, t) {
+			count += t->thread.unaligned_count;
+			if (t->thread.unaligned_count > most) {
+				most = t->thread.unaligned_count;
+				pc = t->thread.unaligned_pc;
+			}
+		}
+		unlock_task_sighand(task, &flags);
+	}
+
+	return sprintf(buffer, "count: %lu\npc: 0x%lx\n", count, pc);
+}
+
+int proc_tid_unaligned(struct task_struct *task, char *buffer)
+{
+	return do_proc_unaligned(task, buffer, 0);
+}
+
+int proc_tgid_unaligned(struct task_struct *task, char *buffer)
+{
+	return do_proc_unaligned(task, buffer, 1);
+}
+#endif /* CONFIG_PROC_FS */
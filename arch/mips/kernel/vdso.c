@@ -16,6 +16,8 @@
 #include <linux/elf.h>
 #include <linux/vmalloc.h>
 #include <linux/unistd.h>
+#include <linux/slab.h>
+#include <linux/timekeeper_internal.h>
 
 #include <asm/vdso.h>
 #include <asm/uasm.h>
@@ -29,6 +31,179 @@
 
 static struct page *vdso_page;
 
+#ifdef CONFIG_GENERIC_TIME_VSYSCALL
+/*
+ * Besides the signal trampolines every process gets the vDSO image, the
+ * page with the timekeeping data right below it and, if the timekeeping
+ * clocksource can be read from userspace, the page with its counter below
+ * that.
+ */
+extern char vdso_start[], vdso_end[];
+
+static union {
+	struct mips_vdso_data	data;
+	u8			page[PAGE_SIZE];
+} vdso_data_store __page_aligned_data;
+
+static struct mips_vdso_data *vdso_data = &vdso_data_store.data;
+
+static struct page *vdso_data_page;
+static struct page **vdso_image_pages;
+static unsigned int vdso_image_npages;
+
+static struct clocksource *vdso_clocksource;
+static unsigned long vdso_counter_pfn;
+
+/*
+ * Let the vDSO read the counter of @cs at physical address @addr directly.
+ * The counter register is read with a 32-bit load and masked with the
+ * clocksource mask, and the whole page it is in becomes readable by every
+ * process, so it must not hold registers with read side effects.
+ */
+void __init mips_vdso_register_counter(struct clocksource *cs,
+				       phys_addr_t addr)
+{
+	vdso_clocksource = cs;
+	vdso_counter_pfn = PFN_DOWN(addr);
+	vdso_data->counter_offset = offset_in_page(addr);
+}
+
+static inline void vdso_write_begin(struct mips_vdso_data *vd)
+{
+	++vd->seq;
+	smp_wmb();
+}
+
+static inline void vdso_write_end(struct mips_vdso_data *vd)
+{
+	smp_wmb();
+	++vd->seq;
+}
+
+void update_vsyscall(struct timekeeper *tk)
+{
+	struct mips_vdso_data *vd = vdso_data;
+
+	vdso_write_begin(vd);
+
+	vd->xtime_sec = tk->xtime_sec;
+	vd->xtime_nsec = tk->xtime_nsec;
+	vd->shift = tk->shift;
+	vd->wtm_sec = tk->wall_to_monotonic.tv_sec;
+	vd->wtm_nsec = tk->wall_to_monotonic.tv_nsec;
+
+	if (vdso_clocksource && tk->clock == vdso_clocksource) {
+		vd->clock_mode = VDSO_CLOCK_COUNTER;
+		vd->cycle_last = tk->clock->cycle_last;
+		vd->mask = tk->clock->mask;
+		vd->mult = tk->mult;
+	} else {
+		vd->clock_mode = VDSO_CLOCK_NONE;
+	}
+
+	vdso_write_end(vd);
+}
+
+void update_vsyscall_tz(void)
+{
+	struct mips_vdso_data *vd = vdso_data;
+
+	vdso_write_begin(vd);
+	vd->tz_minuteswest = sys_tz.tz_minuteswest;
+	vd->tz_dsttime = sys_tz.tz_dsttime;
+	vdso_write_end(vd);
+}
+
+static void __init init_vdso_image(void)
+{
+	unsigned int i;
+
+	vdso_data_page = virt_to_page(vdso_data);
+
+	vdso_image_npages = (vdso_end - vdso_start) >> PAGE_SHIFT;
+	vdso_image_pages = kcalloc(vdso_image_npages + 1,
+				   sizeof(*vdso_image_pages), GFP_KERNEL);
+	if (!vdso_image_pages)
+		panic("Cannot allocate vdso");
+
+	for (i = 0; i < vdso_image_npages; i++)
+		vdso_image_pages[i] = virt_to_page(vdso_start + i * PAGE_SIZE);
+}
+
+/* Size of the data and counter pages below the image */
+static unsigned long vdso_vvar_size(void)
+{
+	return vdso_counter_pfn ? 2 * PAGE_SIZE : PAGE_SIZE;
+}
+
+static unsigned long vdso_image_size(void)
+{
+	return vdso_vvar_size() + (vdso_image_npages << PAGE_SHIFT);
+}
+
+static int install_vdso_image(struct mm_struct *mm, unsigned long addr)
+{
+	/* The counter page has no struct page, it is filled in below */
+	static struct page *no_pages[] = { NULL };
+	struct vm_area_struct *vma;
+	int ret;
+
+	if (vdso_counter_pfn) {
+		ret = install_special_mapping(mm, addr, PAGE_SIZE,
+					      VM_READ|VM_MAYREAD, no_pages);
+		if (ret)
+			return ret;
+
+		vma = find_vma(mm, addr);
+		ret = io_remap_pfn_range(vma, addr, vdso_counter_pfn, PAGE_SIZE,
+					 pgprot_noncached(PAGE_READONLY));
+		if (ret)
+			return ret;
+
+		addr += PAGE_SIZE;
+	}
+
+	ret = install_special_mapping(mm, addr, PAGE_SIZE,
+				      VM_READ|VM_MAYREAD, &vdso_data_page);
+	if (ret)
+		return ret;
+
+	addr += PAGE_SIZE;
+
+	ret = install_special_mapping(mm, addr,
+				      vdso_image_npages << PAGE_SHIFT,
+				      VM_READ|VM_EXEC|
+				      VM_MAYREAD|VM_MAYWRITE|VM_MAYEXEC,
+				      vdso_image_pages);
+	if (ret)
+		return ret;
+
+	mm->context.vdso_image = (void *)addr;
+
+	return 0;
+}
+#else
+static inline void init_vdso_image(void)
+{
+}
+
+static inline unsigned long vdso_vvar_size(void)
+{
+	return 0;
+}
+
+static inline unsigned long vdso_image_size(void)
+{
+	return 0;
+}
+
+static inline int install_vdso_image(struct mm_struct *mm,
+				     unsigned long addr)
+{
+	return 0;
+}
+#endif /* CONFIG_GENERIC_TIME_VSYSCALL */
+
 static void __init install_trampoline(u32 *tramp, unsigned int sigreturn)
 {
 	uasm_i_addiu(&tramp, 2, 0, sigreturn);	/* li v0, sigreturn */
@@ -61,6 +236,8 @@ static int __init init_vdso(void)
 
 	vunmap(vdso);
 
+	init_vdso_image();
+
 	return 0;
 }
 subsys_initcall(init_vdso);
@@ -80,7 +257,8 @@ int arch_setup_additional_pages(struct linux_binprm *bprm, int uses_interp)
 
 	addr = vdso_addr(mm->start_stack);
 
-	addr = get_unmapped_area(NULL, addr, PAGE_SIZE, 0, 0);
+	addr = get_unmapped_area(NULL, addr, PAGE_SIZE + vdso_image_size(),
+				 0, 0);
 	if (IS_ERR_VALUE(addr)) {
 		ret = addr;
 		goto up_fail;
@@ -96,6 +274,8 @@ int arch_setup_additional_pages(struct linux_binprm *bprm, int uses_interp)
 
 	mm->context.vdso = (void *)addr;
 
+	ret = install_vdso_image(mm, addr + PAGE_SIZE);
+
 up_fail:
 	up_write(&mm->mmap_sem);
 	return ret;
@@ -103,7 +283,19 @@ up_fail:
 
 const char *arch_vma_name(struct vm_area_struct *vma)
 {
-	if (vma->vm_mm && vma->vm_start == (long)vma->vm_mm->context.vdso)
+	struct mm_struct *mm = vma->vm_mm;
+	unsigned long image;
+
+	if (!mm)
+		return NULL;
+
+	image = (unsigned long)mm->context.vdso_image;
+	if (vma->vm_start == (long)mm->context.vdso)
+		return image ? "[sigpage]" : "[vdso]";
+	if (image && vma->vm_start == image)
 		return "[vdso]";
+	if (image && vma->vm_end <= image &&
+	    vma->vm_start >= image - vdso_vvar_size())
+		return "[vvar]";
 	return NULL;
 }
@@ -0,0 +1,245 @@
+/*
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ *
+ * Userspace clock_gettime() and gettimeofday() for MIPS.
+ */
+
+#include <linux/compiler.h>
+#include <linux/time.h>
+
+#include <asm/barrier.h>
+#include <asm/page.h>
+#include <asm/unistd.h>
+#include <asm/vdso.h>
+
+/*
+ * The data page sits right below the image. ld.so does not relocate the
+ * vDSO, so find the image in a way that needs neither a GOT entry nor a
+ * run time relocation: branch over a word holding the distance from that
+ * word to the start of the image.
+ */
+static __always_inline const struct mips_vdso_data *get_vdso_data(void)
+{
+	unsigned long addr;
+
+	__asm__(
+	"	.set	push				\n"
+	"	.set	noreorder			\n"
+	"	bal	1f				\n"
+	"	 nop					\n"
+	"	.word	_start - .			\n"
+	"1:	lw	%0, 0($31)			\n"
+	"	addu	%0, %0, $31			\n"
+	"	.set	pop				\n"
+	: "=r" (addr)
+	:
+	: "$31");
+
+	return (const struct mips_vdso_data *)(addr - PAGE_SIZE);
+}
+
+static __always_inline u32 vdso_read_begin(const struct mips_vdso_data *vd)
+{
+	u32 seq;
+
+	while ((seq = ACCESS_ONCE(vd->seq)) & 1)
+		barrier();
+
+	smp_rmb();
+	return seq;
+}
+
+static __always_inline int vdso_read_retry(const struct mips_vdso_data *vd,
+					   u32 start)
+{
+	smp_rmb();
+	return ACCESS_ONCE(vd->seq) != start;
+}
+
+static __always_inline u64 vdso_read_counter(const struct mips_vdso_data *vd)
+{
+	const volatile u32 *counter;
+
+	counter = (const void *)vd - PAGE_SIZE + vd->counter_offset;
+	return *counter;
+}
+
+static __always_inline void vdso_set_timespec(struct timespec *ts, s64 sec,
+					      u64 nsec)
+{
+	/* Avoid a 64-bit division, nsec is never more than a few seconds */
+	while (nsec >= NSEC_PER_SEC) {
+		nsec -= NSEC_PER_SEC;
+		++sec;
+	}
+
+	ts->tv_sec = sec;
+	ts->tv_nsec = nsec;
+}
+
+static __always_inline int do_realtime_coarse(struct timespec *ts,
+					      const struct mips_vdso_data *vd)
+{
+	u64 sec, nsec;
+	u32 seq;
+
+	do {
+		seq = vdso_read_begin(vd);
+		sec = vd->xtime_sec;
+		nsec = vd->xtime_nsec >> vd->shift;
+	} while (vdso_read_retry(vd, seq));
+
+	vdso_set_timespec(ts, sec, nsec);
+	return 0;
+}
+
+static __always_inline int do_monotonic_coarse(struct timespec *ts,
+					       const struct mips_vdso_data *vd)
+{
+	u64 nsec;
+	s64 sec;
+	u32 seq;
+
+	do {
+		seq = vdso_read_begin(vd);
+		sec = vd->xtime_sec + vd->wtm_sec;
+		nsec = (vd->xtime_nsec >> vd->shift) + vd->wtm_nsec;
+	} while (vdso_read_retry(vd, seq));
+
+	vdso_set_timespec(ts, sec, nsec);
+	return 0;
+}
+
+static __always_inline u64 vdso_get_ns(const struct mips_vdso_data *vd)
+{
+	u64 cycles;
+
+	cycles = (vdso_read_counter(vd) - vd->cycle_last) & vd->mask;
+	return (cycles * vd->mult + vd->xtime_nsec) >> vd->shift;
+}
+
+static __always_inline int do_realtime(struct timespec *ts,
+				       const struct mips_vdso_data *vd)
+{
+	u64 sec, nsec;
+	u32 seq;
+
+	do {
+		seq = vdso_read_begin(vd);
+		if (vd->clock_mode == VDSO_CLOCK_NONE)
+			return -1;
+
+		sec = vd->xtime_sec;
+		nsec = vdso_get_ns(vd);
+	} while (vdso_read_retry(vd, seq));
+
+	vdso_set_timespec(ts, sec, nsec);
+	return 0;
+}
+
+static __always_inline int do_monotonic(struct timespec *ts,
+					const struct mips_vdso_data *vd)
+{
+	u64 nsec;
+	s64 sec;
+	u32 seq;
+
+	do {
+		seq = vdso_read_begin(vd);
+		if (vd->clock_mode == VDSO_CLOCK_NONE)
+			return -1;
+
+		sec = vd->xtime_sec + vd->wtm_sec;
+		nsec = vdso_get_ns(vd) + vd->wtm_nsec;
+	} while (vdso_read_retry(vd, seq));
+
+	vdso_set_timespec(ts, sec, nsec);
+	return 0;
+}
+
+static __always_inline long clock_gettime_fallback(clockid_t _clkid,
+						   struct timespec *_ts)
+{
+	register struct timespec *ts asm("a1") = _ts;
+	register clockid_t clkid asm("a0") = _clkid;
+	register long ret asm("v0");
+	register long nr asm("v0") = __NR_clock_gettime;
+	register long error asm("a3");
+
+	asm volatile(
+	"	syscall\n"
+	: "=r" (ret), "=r" (error)
+	: "r" (clkid), "r" (ts), "r" (nr)
+	: "$1", "$3", "$8", "$9", "$10", "$11", "$12", "$13",
+	  "$14", "$15", "$24", "$25", "hi", "lo", "memory");
+
+	return error ? -ret : ret;
+}
+
+static __always_inline long gettimeofday_fallback(struct timeval *_tv,
+						  struct timezone *_tz)
+{
+	register struct timezone *tz asm("a1") = _tz;
+	register struct timeval *tv asm("a0") = _tv;
+	register long ret asm("v0");
+	register long nr asm("v0") = __NR_gettimeofday;
+	register long error asm("a3");
+
+	asm volatile(
+	"	syscall\n"
+	: "=r" (ret), "=r" (error)
+	: "r" (tv), "r" (tz), "r" (nr)
+	: "$1", "$3", "$8", "$9", "$10", "$11", "$12", "$13",
+	  "$14", "$15", "$24", "$25", "hi", "lo", "memory");
+
+	return error ? -ret : ret;
+}
+
+int __vdso_clock_gettime(clockid_t clkid, struct timespec *ts)
+{
+	const struct mips_vdso_data *vd = get_vdso_data();
+
+	switch (clkid) {
+	case CLOCK_REALTIME_COARSE:
+		return do_realtime_coarse(ts, vd);
+	case CLOCK_MONOTONIC_COARSE:
+		return do_monotonic_coarse(ts, vd);
+	case CLOCK_REALTIME:
+		if (!do_realtime(ts, vd))
+			return 0;
+		break;
+	case CLOCK_MONOTONIC:
+		if (!do_monotonic(ts, vd))
+			return 0;
+		break;
+	}
+
+	return clock_gettime_fallback(clkid, ts);
+}
+
+int __vdso_gettimeofday(struct timeval *tv, struct timezone *tz)
+{
+	const struct mips_vdso_data *vd = get_vdso_data();
+	struct timespec ts;
+	u32 seq;
+
+	if (tv) {
+		if (do_realtime(&ts, vd))
+			return gettimeofday_fallback(tv, tz);
+
+		tv->tv_sec = ts.tv_sec;
+		tv->tv_usec = (u32)ts.tv_nsec / NSEC_PER_USEC;
+	}
+
+	if (unlikely(tz)) {
+		do {
+			seq = vdso_read_begin(vd);
+			tz->tz_minuteswest = vd->tz_minuteswest;
+			tz->tz_dsttime = vd->tz_dsttime;
+		} while (vdso_read_retry(vd, seq));
+	}
+
+	return 0;
+}
@@ -688,6 +688,24 @@ static void r4k_dma_cache_inv(unsigned long addr, unsigned long size)
 	bc_inv(addr, size);
 	__sync();
 }
+
+/*
+ * Used for scatterlists: many small ranges which each stay below the
+ * threshold above can still add up to more than the size of the cache.
+ * Only used without secondary or board caches, see r4k_cache_init().
+ */
+static int r4k_dma_cache_wback_inv_all(unsigned long size)
+{
+	if (size < dcache_size)
+		return 0;
+
+	preempt_disable();
+	r4k_blast_dcache();
+	preempt_enable();
+
+	__sync();
+	return 1;
+}
 #endif /* CONFIG_DMA_NONCOHERENT */
 
 /*
@@ -1501,6 +1519,10 @@ void r4k_cache_init(void)
 		_dma_cache_wback_inv	= r4k_dma_cache_wback_inv;
 		_dma_cache_wback	= r4k_dma_cache_wback_inv;
 		_dma_cache_inv		= r4k_dma_cache_inv;
+
+		if (cpu_has_safe_index_cacheops && !scache_size &&
+		    bcops == &no_sc_ops)
+			_dma_cache_wback_inv_all = r4k_dma_cache_wback_inv_all;
 	}
 #endif
 
@@ -14,8 +14,10 @@
 #include <linux/sched.h>
 #include <linux/syscalls.h>
 #include <linux/mm.h>
+#include <linux/uaccess.h>
 
 #include <asm/cacheflush.h>
+#include <asm/cachectl.h>
 #include <asm/processor.h>
 #include <asm/cpu.h>
 #include <asm/cpu-features.h>
@@ -55,11 +57,77 @@ EXPORT_SYMBOL(flush_icache_all);
 void (*_dma_cache_wback_inv)(unsigned long start, unsigned long size);
 void (*_dma_cache_wback)(unsigned long start, unsigned long size);
 void (*_dma_cache_inv)(unsigned long start, unsigned long size);
+int (*_dma_cache_wback_inv_all)(unsigned long size);
 
 EXPORT_SYMBOL(_dma_cache_wback_inv);
 
 #endif /* CONFIG_DMA_NONCOHERENT */
 
+void icache_batch_add(struct icache_batch *b, unsigned long start,
+	unsigned long end)
+{
+	if (start >= end)
+		return;
+
+	if (b->start < b->end &&
+	    start <= ALIGN(b->end, L1_CACHE_BYTES) &&
+	    end >= (b->start & ~(L1_CACHE_BYTES - 1))) {
+		b->start = min(b->start, start);
+		b->end = max(b->end, end);
+		return;
+	}
+
+	icache_batch_flush(b);
+	b->start = start;
+	b->end = end;
+}
+EXPORT_SYMBOL(icache_batch_add);
+
+void icache_batch_flush(struct icache_batch *b)
+{
+	if (b->start < b->end)
+		flush_icache_range(b->start, b->end);
+	icache_batch_init(b);
+}
+EXPORT_SYMBOL(icache_batch_flush);
+
+#define CACHEFLUSH_RANGES_CHUNK 16
+
+static long cacheflush_ranges(const struct cacheflush_range __user *ur,
+	unsigned long nr)
+{
+	struct cacheflush_range r[CACHEFLUSH_RANGES_CHUNK];
+	struct icache_batch b;
+	unsigned long done, i, n;
+	long ret = 0;
+
+	icache_batch_init(&b);
+	for (done = 0; done < nr; done += n) {
+		n = min_t(unsigned long, nr - done, CACHEFLUSH_RANGES_CHUNK);
+		if (copy_from_user(r, ur + done, n * sizeof(r[0]))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		for (i = 0; i < n; i++) {
+			unsigned long start = r[i].addr;
+			unsigned long len = r[i].len;
+
+			if (start != r[i].addr || len != r[i].len ||
+			    !access_ok(VERIFY_WRITE, (void __user *)start, len)) {
+				ret = -EFAULT;
+				goto out;
+			}
+			icache_batch_add(&b, start, start + len);
+		}
+		cond_resched();
+	}
+out:
+	icache_batch_flush(&b);
+
+	return ret ? ret : nr;
+}
+
 /*
  * We could optimize the case where the cache argument is not BCACHE but
  * that seems very atypical use ...
@@ -69,6 +137,8 @@ SYSCALL_DEFINE3(cacheflush, unsigned long, addr, unsigned long, bytes,
 {
 	if (bytes == 0)
 		return 0;
+	if (cache & CACHEFLUSH_RANGES)
+		return cacheflush_ranges((void __user *)addr, bytes);
 	if (!access_ok(VERIFY_WRITE, (void __user *) addr, bytes))
 		return -EFAULT;
 
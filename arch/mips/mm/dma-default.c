@@ -140,9 +140,14 @@ static void *mips_dma_alloc_coherent(struct device *dev, size_t size,
 		memset(ret, 0, size);
 		*dma_handle = plat_map_dma_mem(dev, ret, size);
 
+		/*
+		 * With DMA_ATTR_NON_CONSISTENT the caller keeps the cached
+		 * mapping and syncs it through dma_cache_sync() itself.
+		 */
 		if (!plat_device_is_coherent(dev)) {
 			dma_cache_wback_inv((unsigned long) ret, size);
-			if (!hw_coherentio)
+			if (!hw_coherentio &&
+			    !dma_get_attr(DMA_ATTR_NON_CONSISTENT, attrs))
 				ret = UNCAC_ADDR(ret);
 		}
 	}
@@ -170,7 +175,8 @@ static void mips_dma_free_coherent(struct device *dev, size_t size, void *vaddr,
 
 	plat_unmap_dma_mem(dev, dma_handle, size, DMA_BIDIRECTIONAL);
 
-	if (!plat_device_is_coherent(dev) && !hw_coherentio)
+	if (!plat_device_is_coherent(dev) && !hw_coherentio &&
+	    !dma_get_attr(DMA_ATTR_NON_CONSISTENT, attrs))
 		addr = CAC_ADDR(addr);
 
 	free_pages(addr, get_order(size));
@@ -234,6 +240,22 @@ static inline void __dma_sync(struct page *page,
 	} while (left);
 }
 
+/*
+ * Maintaining the entries of a long scatterlist one by one can take longer
+ * than writing back and invalidating the whole cache. Returns nonzero if the
+ * cache was flushed, in which case the entries need no further maintenance.
+ */
+static int __dma_sync_sg_all(struct scatterlist *sg, int nents)
+{
+	unsigned long size = 0;
+	int i;
+
+	for (i = 0; i < nents; i++, sg++)
+		size += sg->length;
+
+	return dma_cache_wback_inv_all(size);
+}
+
 static void mips_dma_unmap_page(struct device *dev, dma_addr_t dma_addr,
 	size_t size, enum dma_data_direction direction, struct dma_attrs *attrs)
 {
@@ -247,10 +269,12 @@ static void mips_dma_unmap_page(struct device *dev, dma_addr_t dma_addr,
 static int mips_dma_map_sg(struct device *dev, struct scatterlist *sg,
 	int nents, enum dma_data_direction direction, struct dma_attrs *attrs)
 {
-	int i;
+	int i, sync;
+
+	sync = !plat_device_is_coherent(dev) && !__dma_sync_sg_all(sg, nents);
 
 	for (i = 0; i < nents; i++, sg++) {
-		if (!plat_device_is_coherent(dev))
+		if (sync)
 			__dma_sync(sg_page(sg), sg->offset, sg->length,
 				   direction);
 #ifdef CONFIG_NEED_SG_DMA_LENGTH
@@ -277,11 +301,13 @@ static void mips_dma_unmap_sg(struct device *dev, struct scatterlist *sg,
 	int nhwentries, enum dma_data_direction direction,
 	struct dma_attrs *attrs)
 {
-	int i;
+	int i, sync;
+
+	sync = !plat_device_is_coherent(dev) && direction != DMA_TO_DEVICE &&
+	       !__dma_sync_sg_all(sg, nhwentries);
 
 	for (i = 0; i < nhwentries; i++, sg++) {
-		if (!plat_device_is_coherent(dev) &&
-		    direction != DMA_TO_DEVICE)
+		if (sync)
 			__dma_sync(sg_page(sg), sg->offset, sg->length,
 				   direction);
 		plat_unmap_dma_mem(dev, sg->dma_address, sg->length, direction);
@@ -309,7 +335,7 @@ static void mips_dma_sync_sg_for_cpu(struct device *dev,
 {
 	int i;
 
-	if (cpu_needs_post_dma_flush(dev))
+	if (cpu_needs_post_dma_flush(dev) && !__dma_sync_sg_all(sg, nelems))
 		for (i = 0; i < nelems; i++, sg++)
 			__dma_sync(sg_page(sg), sg->offset, sg->length,
 				   direction);
@@ -320,7 +346,7 @@ static void mips_dma_sync_sg_for_device(struct device *dev,
 {
 	int i;
 
-	if (!plat_device_is_coherent(dev))
+	if (!plat_device_is_coherent(dev) && !__dma_sync_sg_all(sg, nelems))
 		for (i = 0; i < nelems; i++, sg++)
 			__dma_sync(sg_page(sg), sg->offset, sg->length,
 				   direction);
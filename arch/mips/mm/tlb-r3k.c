@@ -118,6 +118,11 @@ void local_flush_tlb_range(struct vm_area_struct *vma, unsigned long start,
 	}
 }
 
+unsigned long tlb_kernel_range_max_pages(void)
+{
+	return current_cpu_data.tlbsize;
+}
+
 void local_flush_tlb_kernel_range(unsigned long start, unsigned long end)
 {
 	unsigned long size, flags;
@@ -127,7 +132,7 @@ void local_flush_tlb_kernel_range(unsigned long start, unsigned long end)
 #endif
 	local_irq_save(flags);
 	size = (end - start + (PAGE_SIZE - 1)) >> PAGE_SHIFT;
-	if (size <= current_cpu_data.tlbsize) {
+	if (size <= tlb_kernel_range_max_pages()) {
 		int pid = read_c0_entryhi();
 
 		start &= PAGE_MASK;
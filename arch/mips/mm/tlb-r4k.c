@@ -8,6 +8,8 @@
  * Carsten Langgaard, carstenl@mips.com
  * Copyright (C) 2002 MIPS Technologies, Inc.  All rights reserved.
  */
+#include <linux/bitmap.h>
+#include <linux/debugfs.h>
 #include <linux/init.h>
 #include <linux/sched.h>
 #include <linux/smp.h>
@@ -115,6 +117,93 @@ void local_flush_tlb_all(void)
 }
 EXPORT_SYMBOL(local_flush_tlb_all);
 
+#ifdef MIPS_ASID_LAZY_CYCLE
+
+/* EntryLo global and valid bits */
+#define ENTRYLO_G	(1 << 0)
+#define ENTRYLO_V	(1 << 1)
+
+struct asid_cycle asid_cycle[NR_CPUS];
+
+/* Number of ASID cycles, and of those which flushed the whole TLB */
+static u32 asid_cycles;
+static u32 asid_cycle_flushes;
+
+/*
+ * Start a new ASID cycle on this CPU. Rather than flushing the TLB, note
+ * the ASIDs which still have valid entries in it so they are skipped this
+ * cycle. If too many are left, or the TLB is too large to walk cheaply,
+ * flush it after all. Called with interrupts disabled.
+ */
+void local_flush_tlb_asid_cycle(unsigned long cpu)
+{
+	struct asid_cycle *ac = &asid_cycle[cpu];
+	unsigned long old_ctx, entryhi, lo0, lo1;
+	unsigned int old_pagemask;
+	int entry;
+
+	bitmap_zero(ac->used, ASID_MASK + 1);
+	bitmap_zero(ac->stale, ASID_MASK + 1);
+	asid_cycles++;
+
+	if (cpu_has_tlbinv || current_cpu_data.tlbsize > ASID_MASK / 2)
+		goto flush;
+
+	old_ctx = read_c0_entryhi();
+	old_pagemask = read_c0_pagemask();
+
+	for (entry = 0; entry < current_cpu_data.tlbsize; entry++) {
+		write_c0_index(entry);
+		mtc0_tlbw_hazard();
+		tlb_read();
+		tlbw_use_hazard();
+
+		entryhi = read_c0_entryhi();
+		lo0 = read_c0_entrylo0();
+		lo1 = read_c0_entrylo1();
+
+		/* Global entries match any ASID, invalid ones don't matter */
+		if ((lo0 & lo1 & ENTRYLO_G) || !((lo0 | lo1) & ENTRYLO_V))
+			continue;
+		__set_bit(entryhi & ASID_MASK, ac->stale);
+	}
+
+	write_c0_entryhi(old_ctx);
+	write_c0_pagemask(old_pagemask);
+	back_to_back_c0_hazard();
+
+	if (bitmap_weight(ac->stale, ASID_MASK + 1) <= (ASID_MASK + 1) / 2)
+		return;
+
+	bitmap_zero(ac->stale, ASID_MASK + 1);
+flush:
+	asid_cycle_flushes++;
+	local_flush_tlb_all();
+}
+
+#ifdef CONFIG_DEBUG_FS
+static int __init debugfs_asid_cycle(void)
+{
+	extern struct dentry *mips_debugfs_dir;
+	struct dentry *d;
+
+	if (!mips_debugfs_dir)
+		return -ENODEV;
+	d = debugfs_create_u32("asid_cycles", S_IRUGO | S_IWUSR,
+			       mips_debugfs_dir, &asid_cycles);
+	if (!d)
+		return -ENOMEM;
+	d = debugfs_create_u32("asid_cycle_flushes", S_IRUGO | S_IWUSR,
+			       mips_debugfs_dir, &asid_cycle_flushes);
+	if (!d)
+		return -ENOMEM;
+	return 0;
+}
+__initcall(debugfs_asid_cycle);
+#endif
+
+#endif /* MIPS_ASID_LAZY_CYCLE */
+
 /* All entries common to a mm share an asid.  To effectively flush
    these entries, we just bump the asid. */
 void local_flush_tlb_mm(struct mm_struct *mm)
@@ -179,16 +268,21 @@ void local_flush_tlb_range(struct vm_area_struct *vma, unsigned long start,
 	}
 }
 
+unsigned long tlb_kernel_range_max_pages(void)
+{
+	/* Each entry maps an even/odd pair of pages */
+	return 2 * (current_cpu_data.tlbsizeftlbsets ?
+		    current_cpu_data.tlbsize / 8 :
+		    current_cpu_data.tlbsize / 2);
+}
+
 void local_flush_tlb_kernel_range(unsigned long start, unsigned long end)
 {
 	unsigned long size, flags;
 
 	ENTER_CRITICAL(flags);
 	size = (end - start + (PAGE_SIZE - 1)) >> PAGE_SHIFT;
-	size = (size + 1) >> 1;
-	if (size <= (current_cpu_data.tlbsizeftlbsets ?
-		     current_cpu_data.tlbsize / 8 :
-		     current_cpu_data.tlbsize / 2)) {
+	if (size <= tlb_kernel_range_max_pages()) {
 		int pid = read_c0_entryhi();
 
 		start &= (PAGE_MASK << 1);
@@ -326,8 +420,10 @@ void __update_tlb(struct vm_area_struct * vma, unsigned long address, pte_t pte)
 		write_c0_pagemask(PM_HUGE_MASK);
 		ptep = (pte_t *)pmdp;
 		lo = pte_to_entrylo(pte_val(*ptep));
+		/* Pick the TLB entry pair of the huge page holding address */
+		lo += (address & (HPAGE_SIZE - 1) & ~(HPAGE_TLB_SIZE - 1)) >> 6;
 		write_c0_entrylo0(lo);
-		write_c0_entrylo1(lo + (HPAGE_SIZE >> 7));
+		write_c0_entrylo1(lo + (HPAGE_TLB_SIZE >> 7));
 
 		mtc0_tlbw_hazard();
 		if (idx < 0)
@@ -107,6 +107,12 @@ out_restore:
 	local_irq_restore(flags);
 }
 
+unsigned long tlb_kernel_range_max_pages(void)
+{
+	/* Each entry maps an even/odd pair of pages */
+	return TFP_TLB_SIZE;
+}
+
 /* Usable for KV1 addresses only! */
 void local_flush_tlb_kernel_range(unsigned long start, unsigned long end)
 {
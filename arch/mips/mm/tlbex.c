@@ -22,6 +22,8 @@
  */
 
 #include <linux/bug.h>
+#include <linux/debugfs.h>
+#include <linux/init.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 #include <linux/smp.h>
@@ -57,6 +59,72 @@ struct tlb_reg_save {
 
 static struct tlb_reg_save handler_reg_save[NR_CPUS];
 
+/*
+ * Optional count of the TLB exceptions taken, enabled with "tlbex_stats"
+ * on the command line. The handlers are synthesized during boot, so this
+ * can't be switched on later. The counters are updated without locking
+ * and are only approximate on SMP.
+ */
+static bool tlbex_stats;
+static u32 tlbex_refill_count;
+static u32 tlbex_load_count;
+static u32 tlbex_store_count;
+static u32 tlbex_modify_count;
+
+static int __init tlbex_stats_setup(char *s)
+{
+	tlbex_stats = true;
+	return 0;
+}
+early_param("tlbex_stats", tlbex_stats_setup);
+
+#ifdef CONFIG_DEBUG_FS
+static int __init debugfs_tlbex(void)
+{
+	extern struct dentry *mips_debugfs_dir;
+	struct dentry *dir;
+
+	if (!tlbex_stats)
+		return 0;
+	if (!mips_debugfs_dir)
+		return -ENODEV;
+	dir = debugfs_create_dir("tlbex", mips_debugfs_dir);
+	if (!dir)
+		return -ENOMEM;
+	if (!debugfs_create_u32("refill", S_IRUGO | S_IWUSR, dir,
+				&tlbex_refill_count) ||
+	    !debugfs_create_u32("load", S_IRUGO | S_IWUSR, dir,
+				&tlbex_load_count) ||
+	    !debugfs_create_u32("store", S_IRUGO | S_IWUSR, dir,
+				&tlbex_store_count) ||
+	    !debugfs_create_u32("modify", S_IRUGO | S_IWUSR, dir,
+				&tlbex_modify_count)) {
+		debugfs_remove_recursive(dir);
+		return -ENOMEM;
+	}
+	return 0;
+}
+__initcall(debugfs_tlbex);
+#endif
+
+/*
+ * Bump *counter from a handler. Must be used before anything is kept
+ * in K0 or K1. The counters live in unmapped kernel space, so this
+ * can't fault.
+ */
+static void build_tlbex_stat(u32 **p, u32 *counter)
+{
+	long addr = (long)counter;
+
+	if (!tlbex_stats)
+		return;
+
+	UASM_i_LA_mostly(p, K0, addr);
+	uasm_i_lw(p, K1, uasm_rel_lo(addr), K0);
+	uasm_i_addiu(p, K1, K1, 1);
+	uasm_i_sw(p, K1, uasm_rel_lo(addr), K0);
+}
+
 static inline int r45k_bvahwbug(void)
 {
 	/* XXX: We should probe for the presence of this bug, but we don't. */
@@ -404,6 +472,7 @@ static void build_r3000_tlb_refill_handler(void)
 	memset(tlb_handler, 0, sizeof(tlb_handler));
 	p = tlb_handler;
 
+	build_tlbex_stat(&p, &tlbex_refill_count);
 	uasm_i_mfc0(&p, K0, C0_BADVADDR);
 	uasm_i_lui(&p, K1, uasm_rel_hi(pgdc)); /* cp0 delay */
 	uasm_i_lw(&p, K1, uasm_rel_lo(pgdc), K1);
@@ -728,18 +797,33 @@ static void build_huge_update_entries(u32 **p, unsigned int pte,
 	 * huge page size is configured into entrylo0
 	 * and entrylo1 to cover the contiguous huge PTE
 	 * address space.
+	 *
+	 * On 32-bit kernels the huge page is twice what
+	 * the entry pair covers, so the pair for the half
+	 * holding the faulting address is loaded.
 	 */
-	small_sequence = (HPAGE_SIZE >> 7) < 0x10000;
+	small_sequence = (HPAGE_TLB_SIZE >> 7) < 0x10000;
 
 	/* We can clobber tmp.	It isn't used after this.*/
-	if (!small_sequence)
-		uasm_i_lui(p, tmp, HPAGE_SIZE >> (7 + 16));
+	if (HPAGE_SIZE != HPAGE_TLB_SIZE) {
+		UASM_i_MFC0(p, tmp, C0_BADVADDR);
+		UASM_i_SRL(p, tmp, tmp, HPAGE_TLB_SHIFT);
+		uasm_i_andi(p, tmp, tmp, HPAGE_SIZE / HPAGE_TLB_SIZE - 1);
+		UASM_i_SLL(p, tmp, tmp, HPAGE_TLB_SHIFT - 6);
+		build_convert_pte_to_entrylo(p, pte);
+		UASM_i_ADDU(p, pte, pte, tmp);
+		if (!small_sequence)
+			uasm_i_lui(p, tmp, HPAGE_TLB_SIZE >> (7 + 16));
+	} else {
+		if (!small_sequence)
+			uasm_i_lui(p, tmp, HPAGE_TLB_SIZE >> (7 + 16));
 
-	build_convert_pte_to_entrylo(p, pte);
+		build_convert_pte_to_entrylo(p, pte);
+	}
 	UASM_i_MTC0(p, pte, C0_ENTRYLO0); /* load it */
 	/* convert to entrylo1 */
 	if (small_sequence)
-		UASM_i_ADDIU(p, pte, pte, HPAGE_SIZE >> 7);
+		UASM_i_ADDIU(p, pte, pte, HPAGE_TLB_SIZE >> 7);
 	else
 		UASM_i_ADDU(p, pte, pte, tmp);
 
@@ -1254,6 +1338,8 @@ static void build_r4000_tlb_refill_handler(void)
 	memset(relocs, 0, sizeof(relocs));
 	memset(final_handler, 0, sizeof(final_handler));
 
+	build_tlbex_stat(&p, &tlbex_refill_count);
+
 	if ((scratch_reg >= 0 || scratchpad_available()) && use_bbit_insns()) {
 		htlb_info = build_fast_tlb_refill_handler(&p, &l, &r, K0, K1,
 							  scratch_reg);
@@ -1748,6 +1834,8 @@ static void build_r3000_tlb_load_handler(void)
 	memset(labels, 0, sizeof(labels));
 	memset(relocs, 0, sizeof(relocs));
 
+	build_tlbex_stat(&p, &tlbex_load_count);
+
 	build_r3000_tlbchange_handler_head(&p, K0, K1);
 	build_pte_present(&p, &r, K0, K1, -1, label_nopage_tlbl);
 	uasm_i_nop(&p); /* load delay */
@@ -1779,6 +1867,8 @@ static void build_r3000_tlb_store_handler(void)
 	memset(labels, 0, sizeof(labels));
 	memset(relocs, 0, sizeof(relocs));
 
+	build_tlbex_stat(&p, &tlbex_store_count);
+
 	build_r3000_tlbchange_handler_head(&p, K0, K1);
 	build_pte_writable(&p, &r, K0, K1, -1, label_nopage_tlbs);
 	uasm_i_nop(&p); /* load delay */
@@ -1810,6 +1900,8 @@ static void build_r3000_tlb_modify_handler(void)
 	memset(labels, 0, sizeof(labels));
 	memset(relocs, 0, sizeof(relocs));
 
+	build_tlbex_stat(&p, &tlbex_modify_count);
+
 	build_r3000_tlbchange_handler_head(&p, K0, K1);
 	build_pte_modifiable(&p, &r, K0, K1,  -1, label_nopage_tlbm);
 	uasm_i_nop(&p); /* load delay */
@@ -1900,6 +1992,8 @@ static void build_r4000_tlb_load_handler(void)
 	memset(labels, 0, sizeof(labels));
 	memset(relocs, 0, sizeof(relocs));
 
+	build_tlbex_stat(&p, &tlbex_load_count);
+
 	if (bcm1250_m3_war()) {
 		unsigned int segbits = 44;
 
@@ -2083,6 +2177,8 @@ static void build_r4000_tlb_store_handler(void)
 	memset(labels, 0, sizeof(labels));
 	memset(relocs, 0, sizeof(relocs));
 
+	build_tlbex_stat(&p, &tlbex_store_count);
+
 	wr = build_r4000_tlbchange_handler_head(&p, &l, &r);
 	build_pte_writable(&p, &r, wr.r1, wr.r2, wr.r3, label_nopage_tlbs);
 	if (m4kc_tlbp_war())
@@ -2138,6 +2234,8 @@ static void build_r4000_tlb_modify_handler(void)
 	memset(labels, 0, sizeof(labels));
 	memset(relocs, 0, sizeof(relocs));
 
+	build_tlbex_stat(&p, &tlbex_modify_count);
+
 	wr = build_r4000_tlbchange_handler_head(&p, &l, &r);
 	build_pte_modifiable(&p, &r, wr.r1, wr.r2, wr.r3, label_nopage_tlbm);
 	if (m4kc_tlbp_war())
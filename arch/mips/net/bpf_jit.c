@@ -0,0 +1,887 @@
+/*
+ * Just-In-Time compiler for BPF filters on 32-bit MIPS
+ *
+ * The generated code is assembled with the micro-assembler (uasm), the
+ * same way the TLB exception handlers and the page clearing and copying
+ * routines are built at boot.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; version 2 of the License.
+ */
+
+#include <linux/bitops.h>
+#include <linux/compiler.h>
+#include <linux/errno.h>
+#include <linux/filter.h>
+#include <linux/if_vlan.h>
+#include <linux/moduleloader.h>
+#include <linux/netdevice.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+
+#include <asm/cacheflush.h>
+#include <asm/cpu-features.h>
+#include <asm/uasm.h>
+
+/*
+ * ABI:
+ *
+ * s0	BPF register A
+ * s1	BPF register X
+ * s2	pointer to the skb
+ * s3	skb->data
+ * s4	skb_headlen(skb)
+ * t0-t2	scratch registers
+ * a1	offset of the packet load, kept for the slow path
+ * v0	return value
+ *
+ * The BPF memory words live in the stack frame, above the argument save
+ * area the o32 ABI requires for the slow path calls.
+ */
+
+enum {
+	r_zero = 0,
+	r_v0 = 2,
+	r_v1 = 3,
+	r_a0 = 4,
+	r_a1 = 5,
+	r_t0 = 8,
+	r_t1 = 9,
+	r_t2 = 10,
+	r_s0 = 16,
+	r_s1 = 17,
+	r_s2 = 18,
+	r_s3 = 19,
+	r_s4 = 20,
+	r_t9 = 25,
+	r_gp = 28,
+	r_sp = 29,
+	r_ra = 31,
+};
+
+#define r_A		r_s0
+#define r_X		r_s1
+#define r_skb		r_s2
+#define r_skb_data	r_s3
+#define r_skb_hl	r_s4
+#define r_off		r_a1
+#define r_ret		r_v0
+
+/* Results of the jit_get_skb_* helpers */
+#ifdef __BIG_ENDIAN
+#define r_load_err	r_v0
+#define r_load_val	r_v1
+#else
+#define r_load_val	r_v0
+#define r_load_err	r_v1
+#endif
+
+#define SCRATCH_OFF(k)		(16 + 4 * (k))
+#define SAVE_OFF(n)		(SCRATCH_OFF(BPF_MEMWORDS) + 4 * (n))
+#define FRAME_SIZE		ALIGN(SAVE_OFF(6), 8)
+
+#define SEEN_X			(1 << 0)
+#define SEEN_CALL		(1 << 1)
+#define SEEN_SKB		(1 << 2)
+#define SEEN_DATA		(1 << 3)
+
+/* Largest distance a conditional branch can cover */
+#define MAX_BRANCH_BYTES	0x1ffff
+
+struct jit_ctx {
+	const struct sk_filter *skf;
+	unsigned int idx;
+	unsigned int prologue_bytes;
+	u32 seen;
+	u32 *offsets;
+	u32 *target;
+};
+
+int bpf_jit_enable __read_mostly;
+
+static u64 jit_get_skb_b(struct sk_buff *skb, unsigned offset)
+{
+	u8 ret;
+	int err;
+
+	err = skb_copy_bits(skb, offset, &ret, 1);
+
+	return (u64)err << 32 | ret;
+}
+
+static u64 jit_get_skb_h(struct sk_buff *skb, unsigned offset)
+{
+	u16 ret;
+	int err;
+
+	err = skb_copy_bits(skb, offset, &ret, 2);
+
+	return (u64)err << 32 | ntohs(ret);
+}
+
+static u64 jit_get_skb_w(struct sk_buff *skb, unsigned offset)
+{
+	u32 ret;
+	int err;
+
+	err = skb_copy_bits(skb, offset, &ret, 4);
+
+	return (u64)err << 32 | ntohl(ret);
+}
+
+/*
+ * The first pass only counts the instructions, so nothing is written
+ * until the buffer has been allocated.
+ */
+#define emit_instr(ctx, func, ...)					\
+do {									\
+	if ((ctx)->target != NULL) {					\
+		u32 *p = &(ctx)->target[(ctx)->idx];			\
+		uasm_i_##func(&p, ##__VA_ARGS__);			\
+	}								\
+	(ctx)->idx++;							\
+} while (0)
+
+/* Rewrite an already emitted instruction, used for local forward branches */
+#define emit_instr_at(ctx, at, func, ...)				\
+do {									\
+	if ((ctx)->target != NULL) {					\
+		u32 *p = &(ctx)->target[at];				\
+		uasm_i_##func(&p, ##__VA_ARGS__);			\
+	}								\
+} while (0)
+
+/* Offset of a local branch at @from to @to, relative to its delay slot */
+#define local_b_imm(from, to)	(((int)(to) - (int)(from) - 1) * 4)
+
+static inline bool is_simm16(u32 imm)
+{
+	return (s32)imm >= -0x8000 && (s32)imm <= 0x7fff;
+}
+
+static void emit_load_imm(unsigned int reg, u32 imm, struct jit_ctx *ctx)
+{
+	if (is_simm16(imm)) {
+		emit_instr(ctx, addiu, reg, r_zero, imm);
+		return;
+	}
+
+	emit_instr(ctx, lui, reg, (s16)(imm >> 16));
+	if (imm & 0xffff)
+		emit_instr(ctx, ori, reg, reg, imm & 0xffff);
+}
+
+/* Compute the immediate value of a branch to the start of BPF insn @tgt */
+static inline s32 b_imm(unsigned int tgt, struct jit_ctx *ctx)
+{
+	if (ctx->target == NULL)
+		return 0;
+
+	/*
+	 * BPF allows only forward jumps and the offset of the target is
+	 * still the one computed during the first pass.
+	 */
+	return ctx->offsets[tgt] + ctx->prologue_bytes - (ctx->idx * 4 + 4);
+}
+
+/* Return 0 from the filter if @reg is not zero */
+static void emit_ret0_if_nez(unsigned int reg, struct jit_ctx *ctx)
+{
+	emit_instr(ctx, bnez, reg, b_imm(ctx->skf->len, ctx));
+	emit_instr(ctx, move, r_ret, r_zero);
+}
+
+/* Return 0 from the filter if @reg is zero */
+static void emit_ret0_if_eqz(unsigned int reg, struct jit_ctx *ctx)
+{
+	emit_instr(ctx, beqz, reg, b_imm(ctx->skf->len, ctx));
+	emit_instr(ctx, move, r_ret, r_zero);
+}
+
+static void emit_call(void *func, struct jit_ctx *ctx)
+{
+	ctx->seen |= SEEN_CALL;
+	emit_load_imm(r_t9, (u32)func, ctx);
+	emit_instr(ctx, jalr, r_ra, r_t9);
+	/* every helper takes the skb as its first argument */
+	emit_instr(ctx, move, r_a0, r_skb);
+}
+
+/*
+ * Load @size bytes in network order from skb->data + r_off into @dst. The
+ * data is assembled byte by byte, which works regardless of both the
+ * alignment of the packet and the endianness of the CPU.
+ */
+static void emit_load_be(unsigned int dst, unsigned int size,
+			 struct jit_ctx *ctx)
+{
+	switch (size) {
+	case 1:
+		emit_instr(ctx, lbu, dst, 0, r_t1);
+		break;
+	case 2:
+		emit_instr(ctx, lbu, r_t0, 0, r_t1);
+		emit_instr(ctx, lbu, dst, 1, r_t1);
+		emit_instr(ctx, sll, r_t0, r_t0, 8);
+		emit_instr(ctx, or, dst, dst, r_t0);
+		break;
+	case 4:
+		emit_instr(ctx, lbu, r_t0, 0, r_t1);
+		emit_instr(ctx, lbu, r_t2, 1, r_t1);
+		emit_instr(ctx, sll, r_t0, r_t0, 24);
+		emit_instr(ctx, sll, r_t2, r_t2, 16);
+		emit_instr(ctx, or, r_t0, r_t0, r_t2);
+		emit_instr(ctx, lbu, r_t2, 2, r_t1);
+		emit_instr(ctx, lbu, dst, 3, r_t1);
+		emit_instr(ctx, sll, r_t2, r_t2, 8);
+		emit_instr(ctx, or, r_t0, r_t0, r_t2);
+		emit_instr(ctx, or, dst, dst, r_t0);
+		break;
+	}
+}
+
+/*
+ * Load from the packet at the offset in r_off. The linear part of the skb
+ * is read directly, anything else goes through skb_copy_bits().
+ */
+static void emit_skb_load(unsigned int dst, unsigned int size,
+			  struct jit_ctx *ctx)
+{
+	void *func;
+	unsigned int b_neg, b_len, b_done;
+
+	ctx->seen |= SEEN_DATA | SEEN_CALL;
+
+	switch (size) {
+	case 1:
+		func = jit_get_skb_b;
+		break;
+	case 2:
+		func = jit_get_skb_h;
+		break;
+	default:
+		func = jit_get_skb_w;
+		break;
+	}
+
+	/* a negative offset can never be part of the linear data */
+	b_neg = ctx->idx;
+	emit_instr(ctx, bltz, r_off, 0);
+	emit_instr(ctx, addiu, r_t0, r_off, size);
+	emit_instr(ctx, sltu, r_t0, r_skb_hl, r_t0);
+	b_len = ctx->idx;
+	emit_instr(ctx, bnez, r_t0, 0);
+	emit_instr(ctx, addu, r_t1, r_skb_data, r_off);
+
+	emit_load_be(dst, size, ctx);
+	b_done = ctx->idx;
+	emit_instr(ctx, b, 0);
+	emit_instr(ctx, nop);
+
+	/* the slow path */
+	emit_instr_at(ctx, b_neg, bltz, r_off, local_b_imm(b_neg, ctx->idx));
+	emit_instr_at(ctx, b_len, bnez, r_t0, local_b_imm(b_len, ctx->idx));
+	emit_call(func, ctx);
+	/*
+	 * The offset is already in a1. @dst may be clobbered on failure as
+	 * the filter returns 0 then, and the delay slot of the error branch
+	 * would overwrite the value otherwise.
+	 */
+	emit_instr(ctx, move, dst, r_load_val);
+	emit_ret0_if_nez(r_load_err, ctx);
+
+	emit_instr_at(ctx, b_done, b, local_b_imm(b_done, ctx->idx));
+}
+
+static inline bool is_load_to_a(u16 inst)
+{
+	switch (inst) {
+	case BPF_S_LD_W_LEN:
+	case BPF_S_LD_W_ABS:
+	case BPF_S_LD_H_ABS:
+	case BPF_S_LD_B_ABS:
+	case BPF_S_LD_IMM:
+	case BPF_S_ANC_CPU:
+	case BPF_S_ANC_IFINDEX:
+	case BPF_S_ANC_MARK:
+	case BPF_S_ANC_PROTOCOL:
+	case BPF_S_ANC_RXHASH:
+	case BPF_S_ANC_VLAN_TAG:
+	case BPF_S_ANC_VLAN_TAG_PRESENT:
+	case BPF_S_ANC_QUEUE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void build_prologue(struct jit_ctx *ctx)
+{
+	u16 first_inst = ctx->skf->insns[0].code;
+
+	emit_instr(ctx, addiu, r_sp, r_sp, -FRAME_SIZE);
+	if (ctx->seen & SEEN_CALL)
+		emit_instr(ctx, sw, r_ra, SAVE_OFF(0), r_sp);
+	emit_instr(ctx, sw, r_A, SAVE_OFF(1), r_sp);
+	if (ctx->seen & SEEN_X)
+		emit_instr(ctx, sw, r_X, SAVE_OFF(2), r_sp);
+	if (ctx->seen & (SEEN_SKB | SEEN_DATA))
+		emit_instr(ctx, sw, r_skb, SAVE_OFF(3), r_sp);
+	if (ctx->seen & SEEN_DATA) {
+		emit_instr(ctx, sw, r_skb_data, SAVE_OFF(4), r_sp);
+		emit_instr(ctx, sw, r_skb_hl, SAVE_OFF(5), r_sp);
+	}
+
+	if (ctx->seen & (SEEN_SKB | SEEN_DATA))
+		emit_instr(ctx, move, r_skb, r_a0);
+
+	if (ctx->seen & SEEN_DATA) {
+		emit_instr(ctx, lw, r_skb_data,
+			   offsetof(struct sk_buff, data), r_skb);
+		/* headlen = len - data_len */
+		emit_instr(ctx, lw, r_skb_hl,
+			   offsetof(struct sk_buff, len), r_skb);
+		emit_instr(ctx, lw, r_t0,
+			   offsetof(struct sk_buff, data_len), r_skb);
+		emit_instr(ctx, subu, r_skb_hl, r_skb_hl, r_t0);
+	}
+
+	/*
+	 * X starts out as zero. Jumps make it hard to tell whether it can be
+	 * read before it is written, so always clear it when it is used.
+	 */
+	if (ctx->seen & SEEN_X)
+		emit_instr(ctx, move, r_X, r_zero);
+
+	/* do not leak kernel data to userspace */
+	if ((first_inst != BPF_S_RET_K) && !(is_load_to_a(first_inst)))
+		emit_instr(ctx, move, r_A, r_zero);
+}
+
+static void build_epilogue(struct jit_ctx *ctx)
+{
+	if (ctx->seen & SEEN_CALL)
+		emit_instr(ctx, lw, r_ra, SAVE_OFF(0), r_sp);
+	emit_instr(ctx, lw, r_A, SAVE_OFF(1), r_sp);
+	if (ctx->seen & SEEN_X)
+		emit_instr(ctx, lw, r_X, SAVE_OFF(2), r_sp);
+	if (ctx->seen & (SEEN_SKB | SEEN_DATA))
+		emit_instr(ctx, lw, r_skb, SAVE_OFF(3), r_sp);
+	if (ctx->seen & SEEN_DATA) {
+		emit_instr(ctx, lw, r_skb_data, SAVE_OFF(4), r_sp);
+		emit_instr(ctx, lw, r_skb_hl, SAVE_OFF(5), r_sp);
+	}
+
+	emit_instr(ctx, jr, r_ra);
+	emit_instr(ctx, addiu, r_sp, r_sp, FRAME_SIZE);
+}
+
+/*
+ * Emit the jumps of a conditional BPF instruction. The condition is true
+ * when @rs and @rt compare equal, or different if @ne is set.
+ */
+static void emit_cond_jump(const struct sock_filter *inst, unsigned int i,
+			   bool ne, unsigned int rs, unsigned int rt,
+			   struct jit_ctx *ctx)
+{
+	if (inst->jt) {
+		if (ne)
+			emit_instr(ctx, bne, rs, rt,
+				   b_imm(i + inst->jt + 1, ctx));
+		else
+			emit_instr(ctx, beq, rs, rt,
+				   b_imm(i + inst->jt + 1, ctx));
+		emit_instr(ctx, nop);
+	}
+
+	if (inst->jf) {
+		if (inst->jt)
+			emit_instr(ctx, b, b_imm(i + inst->jf + 1, ctx));
+		else if (ne)
+			emit_instr(ctx, beq, rs, rt,
+				   b_imm(i + inst->jf + 1, ctx));
+		else
+			emit_instr(ctx, bne, rs, rt,
+				   b_imm(i + inst->jf + 1, ctx));
+		emit_instr(ctx, nop);
+	}
+}
+
+static int build_body(struct jit_ctx *ctx)
+{
+	const struct sk_filter *prog = ctx->skf;
+	const struct sock_filter *inst;
+	unsigned int i, off, size;
+	u32 k;
+
+	for (i = 0; i < prog->len; i++) {
+		inst = &(prog->insns[i]);
+		/* K as an immediate value operand */
+		k = inst->k;
+
+		/* compute offsets only in the fake pass */
+		if (ctx->target == NULL)
+			ctx->offsets[i] = ctx->idx * 4;
+
+		switch (inst->code) {
+		case BPF_S_LD_IMM:
+			emit_load_imm(r_A, k, ctx);
+			break;
+		case BPF_S_LD_W_LEN:
+			ctx->seen |= SEEN_SKB;
+			BUILD_BUG_ON(FIELD_SIZEOF(struct sk_buff, len) != 4);
+			emit_instr(ctx, lw, r_A,
+				   offsetof(struct sk_buff, len), r_skb);
+			break;
+		case BPF_S_LD_MEM:
+			/* A = scratch[k] */
+			emit_instr(ctx, lw, r_A, SCRATCH_OFF(k), r_sp);
+			break;
+		case BPF_S_LD_W_ABS:
+			size = 4;
+			goto load;
+		case BPF_S_LD_H_ABS:
+			size = 2;
+			goto load;
+		case BPF_S_LD_B_ABS:
+			size = 1;
+load:
+			/* the interpreter will deal with the negative K */
+			if ((int)k < 0)
+				return -1;
+			emit_load_imm(r_off, k, ctx);
+			emit_skb_load(r_A, size, ctx);
+			break;
+		case BPF_S_LD_W_IND:
+			size = 4;
+			goto load_ind;
+		case BPF_S_LD_H_IND:
+			size = 2;
+			goto load_ind;
+		case BPF_S_LD_B_IND:
+			size = 1;
+load_ind:
+			ctx->seen |= SEEN_X;
+			if (is_simm16(k)) {
+				emit_instr(ctx, addiu, r_off, r_X, k);
+			} else {
+				emit_load_imm(r_t0, k, ctx);
+				emit_instr(ctx, addu, r_off, r_X, r_t0);
+			}
+			emit_skb_load(r_A, size, ctx);
+			break;
+		case BPF_S_LDX_IMM:
+			ctx->seen |= SEEN_X;
+			emit_load_imm(r_X, k, ctx);
+			break;
+		case BPF_S_LDX_W_LEN:
+			ctx->seen |= SEEN_X | SEEN_SKB;
+			emit_instr(ctx, lw, r_X,
+				   offsetof(struct sk_buff, len), r_skb);
+			break;
+		case BPF_S_LDX_MEM:
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, lw, r_X, SCRATCH_OFF(k), r_sp);
+			break;
+		case BPF_S_LDX_B_MSH:
+			/* X = ((*(frame + k)) & 0xf) << 2; */
+			ctx->seen |= SEEN_X;
+			/* the interpreter should deal with the negative K */
+			if ((int)k < 0)
+				return -1;
+			emit_load_imm(r_off, k, ctx);
+			emit_skb_load(r_X, 1, ctx);
+			emit_instr(ctx, andi, r_X, r_X, 0xf);
+			emit_instr(ctx, sll, r_X, r_X, 2);
+			break;
+		case BPF_S_ST:
+			emit_instr(ctx, sw, r_A, SCRATCH_OFF(k), r_sp);
+			break;
+		case BPF_S_STX:
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, sw, r_X, SCRATCH_OFF(k), r_sp);
+			break;
+		case BPF_S_ALU_ADD_K:
+			/* A += K */
+			if (is_simm16(k)) {
+				emit_instr(ctx, addiu, r_A, r_A, k);
+			} else {
+				emit_load_imm(r_t0, k, ctx);
+				emit_instr(ctx, addu, r_A, r_A, r_t0);
+			}
+			break;
+		case BPF_S_ALU_ADD_X:
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, addu, r_A, r_A, r_X);
+			break;
+		case BPF_S_ALU_SUB_K:
+			/* A -= K */
+			if (is_simm16(-k)) {
+				emit_instr(ctx, addiu, r_A, r_A, -k);
+			} else {
+				emit_load_imm(r_t0, k, ctx);
+				emit_instr(ctx, subu, r_A, r_A, r_t0);
+			}
+			break;
+		case BPF_S_ALU_SUB_X:
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, subu, r_A, r_A, r_X);
+			break;
+		case BPF_S_ALU_MUL_K:
+			/* A *= K */
+			if (is_power_of_2(k)) {
+				emit_instr(ctx, sll, r_A, r_A, ilog2(k));
+				break;
+			}
+			emit_load_imm(r_t0, k, ctx);
+			emit_instr(ctx, multu, r_A, r_t0);
+			emit_instr(ctx, mflo, r_A);
+			break;
+		case BPF_S_ALU_MUL_X:
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, multu, r_A, r_X);
+			emit_instr(ctx, mflo, r_A);
+			break;
+		case BPF_S_ALU_DIV_K:
+			/* A /= K, K is known not to be zero */
+			if (is_power_of_2(k)) {
+				if (k > 1)
+					emit_instr(ctx, srl, r_A, r_A, ilog2(k));
+				break;
+			}
+			emit_load_imm(r_t0, k, ctx);
+			emit_instr(ctx, divu, r_A, r_t0);
+			emit_instr(ctx, mflo, r_A);
+			break;
+		case BPF_S_ALU_MOD_K:
+			/* A %= K, K is known not to be zero */
+			if (is_power_of_2(k) && k - 1 <= 0xffff) {
+				emit_instr(ctx, andi, r_A, r_A, k - 1);
+				break;
+			}
+			emit_load_imm(r_t0, k, ctx);
+			emit_instr(ctx, divu, r_A, r_t0);
+			emit_instr(ctx, mfhi, r_A);
+			break;
+		case BPF_S_ALU_DIV_X:
+		case BPF_S_ALU_MOD_X:
+			ctx->seen |= SEEN_X;
+			/* a division by zero makes the filter return 0 */
+			emit_ret0_if_eqz(r_X, ctx);
+			emit_instr(ctx, divu, r_A, r_X);
+			if (inst->code == BPF_S_ALU_DIV_X)
+				emit_instr(ctx, mflo, r_A);
+			else
+				emit_instr(ctx, mfhi, r_A);
+			break;
+		case BPF_S_ALU_OR_K:
+			/* A |= K */
+			if (k <= 0xffff) {
+				emit_instr(ctx, ori, r_A, r_A, k);
+			} else {
+				emit_load_imm(r_t0, k, ctx);
+				emit_instr(ctx, or, r_A, r_A, r_t0);
+			}
+			break;
+		case BPF_S_ALU_OR_X:
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, or, r_A, r_A, r_X);
+			break;
+		case BPF_S_ALU_XOR_K:
+			/* A ^= K */
+			if (k <= 0xffff) {
+				emit_instr(ctx, xori, r_A, r_A, k);
+			} else {
+				emit_load_imm(r_t0, k, ctx);
+				emit_instr(ctx, xor, r_A, r_A, r_t0);
+			}
+			break;
+		case BPF_S_ANC_ALU_XOR_X:
+		case BPF_S_ALU_XOR_X:
+			/* A ^= X */
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, xor, r_A, r_A, r_X);
+			break;
+		case BPF_S_ALU_AND_K:
+			/* A &= K */
+			if (k <= 0xffff) {
+				emit_instr(ctx, andi, r_A, r_A, k);
+			} else {
+				emit_load_imm(r_t0, k, ctx);
+				emit_instr(ctx, and, r_A, r_A, r_t0);
+			}
+			break;
+		case BPF_S_ALU_AND_X:
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, and, r_A, r_A, r_X);
+			break;
+		case BPF_S_ALU_LSH_K:
+			if (unlikely(k > 31))
+				return -1;
+			emit_instr(ctx, sll, r_A, r_A, k);
+			break;
+		case BPF_S_ALU_LSH_X:
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, sllv, r_A, r_A, r_X);
+			break;
+		case BPF_S_ALU_RSH_K:
+			if (unlikely(k > 31))
+				return -1;
+			emit_instr(ctx, srl, r_A, r_A, k);
+			break;
+		case BPF_S_ALU_RSH_X:
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, srlv, r_A, r_A, r_X);
+			break;
+		case BPF_S_ALU_NEG:
+			/* A = -A */
+			emit_instr(ctx, subu, r_A, r_zero, r_A);
+			break;
+		case BPF_S_JMP_JA:
+			/* pc += K */
+			if (k) {
+				emit_instr(ctx, b, b_imm(i + k + 1, ctx));
+				emit_instr(ctx, nop);
+			}
+			break;
+		case BPF_S_JMP_JEQ_K:
+			/* pc += (A == K) ? pc->jt : pc->jf */
+			if (k) {
+				emit_load_imm(r_t0, k, ctx);
+				emit_cond_jump(inst, i, false, r_A, r_t0, ctx);
+			} else {
+				emit_cond_jump(inst, i, false, r_A, r_zero, ctx);
+			}
+			break;
+		case BPF_S_JMP_JGT_K:
+			/* pc += (A > K) ? pc->jt : pc->jf */
+			if (k < 0x7fff) {
+				/* A > K iff !(A < K + 1) */
+				emit_instr(ctx, sltiu, r_t0, r_A, k + 1);
+				emit_cond_jump(inst, i, false, r_t0, r_zero, ctx);
+			} else {
+				emit_load_imm(r_t0, k, ctx);
+				emit_instr(ctx, sltu, r_t0, r_t0, r_A);
+				emit_cond_jump(inst, i, true, r_t0, r_zero, ctx);
+			}
+			break;
+		case BPF_S_JMP_JGE_K:
+			/* pc += (A >= K) ? pc->jt : pc->jf */
+			if (k <= 0x7fff) {
+				emit_instr(ctx, sltiu, r_t0, r_A, k);
+			} else {
+				emit_load_imm(r_t0, k, ctx);
+				emit_instr(ctx, sltu, r_t0, r_A, r_t0);
+			}
+			emit_cond_jump(inst, i, false, r_t0, r_zero, ctx);
+			break;
+		case BPF_S_JMP_JSET_K:
+			/* pc += (A & K) ? pc->jt : pc->jf */
+			if (k <= 0xffff) {
+				emit_instr(ctx, andi, r_t0, r_A, k);
+			} else {
+				emit_load_imm(r_t0, k, ctx);
+				emit_instr(ctx, and, r_t0, r_A, r_t0);
+			}
+			emit_cond_jump(inst, i, true, r_t0, r_zero, ctx);
+			break;
+		case BPF_S_JMP_JEQ_X:
+			/* pc += (A == X) ? pc->jt : pc->jf */
+			ctx->seen |= SEEN_X;
+			emit_cond_jump(inst, i, false, r_A, r_X, ctx);
+			break;
+		case BPF_S_JMP_JGT_X:
+			/* pc += (A > X) ? pc->jt : pc->jf */
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, sltu, r_t0, r_X, r_A);
+			emit_cond_jump(inst, i, true, r_t0, r_zero, ctx);
+			break;
+		case BPF_S_JMP_JGE_X:
+			/* pc += (A >= X) ? pc->jt : pc->jf */
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, sltu, r_t0, r_A, r_X);
+			emit_cond_jump(inst, i, false, r_t0, r_zero, ctx);
+			break;
+		case BPF_S_JMP_JSET_X:
+			/* pc += (A & X) ? pc->jt : pc->jf */
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, and, r_t0, r_A, r_X);
+			emit_cond_jump(inst, i, true, r_t0, r_zero, ctx);
+			break;
+		case BPF_S_RET_A:
+			/* the return value is set in the delay slot */
+			if (i != prog->len - 1)
+				emit_instr(ctx, b, b_imm(prog->len, ctx));
+			emit_instr(ctx, move, r_ret, r_A);
+			break;
+		case BPF_S_RET_K:
+			if (i != prog->len - 1 && is_simm16(k)) {
+				/* the return value is set in the delay slot */
+				emit_instr(ctx, b, b_imm(prog->len, ctx));
+				emit_instr(ctx, addiu, r_ret, r_zero, k);
+				break;
+			}
+			emit_load_imm(r_ret, k, ctx);
+			if (i != prog->len - 1) {
+				emit_instr(ctx, b, b_imm(prog->len, ctx));
+				emit_instr(ctx, nop);
+			}
+			break;
+		case BPF_S_MISC_TAX:
+			/* X = A */
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, move, r_X, r_A);
+			break;
+		case BPF_S_MISC_TXA:
+			/* A = X */
+			ctx->seen |= SEEN_X;
+			emit_instr(ctx, move, r_A, r_X);
+			break;
+		case BPF_S_ANC_PROTOCOL:
+			/* A = ntohs(skb->protocol) */
+			ctx->seen |= SEEN_SKB;
+			BUILD_BUG_ON(FIELD_SIZEOF(struct sk_buff,
+						  protocol) != 2);
+			off = offsetof(struct sk_buff, protocol);
+			emit_instr(ctx, addiu, r_t1, r_skb, off);
+			emit_load_be(r_A, 2, ctx);
+			break;
+		case BPF_S_ANC_CPU:
+			/* A = current_thread_info()->cpu */
+			BUILD_BUG_ON(FIELD_SIZEOF(struct thread_info, cpu) != 4);
+			off = offsetof(struct thread_info, cpu);
+			emit_instr(ctx, lw, r_A, off, r_gp);
+			break;
+		case BPF_S_ANC_IFINDEX:
+		case BPF_S_ANC_HATYPE:
+			/* A = skb->dev->ifindex or skb->dev->type */
+			ctx->seen |= SEEN_SKB;
+			off = offsetof(struct sk_buff, dev);
+			emit_instr(ctx, lw, r_t0, off, r_skb);
+			emit_ret0_if_eqz(r_t0, ctx);
+
+			BUILD_BUG_ON(FIELD_SIZEOF(struct net_device,
+						  ifindex) != 4);
+			BUILD_BUG_ON(FIELD_SIZEOF(struct net_device,
+						  type) != 2);
+			if (inst->code == BPF_S_ANC_IFINDEX) {
+				off = offsetof(struct net_device, ifindex);
+				emit_instr(ctx, lw, r_A, off, r_t0);
+			} else {
+				off = offsetof(struct net_device, type);
+				emit_instr(ctx, lhu, r_A, off, r_t0);
+			}
+			break;
+		case BPF_S_ANC_MARK:
+			ctx->seen |= SEEN_SKB;
+			BUILD_BUG_ON(FIELD_SIZEOF(struct sk_buff, mark) != 4);
+			off = offsetof(struct sk_buff, mark);
+			emit_instr(ctx, lw, r_A, off, r_skb);
+			break;
+		case BPF_S_ANC_RXHASH:
+			ctx->seen |= SEEN_SKB;
+			BUILD_BUG_ON(FIELD_SIZEOF(struct sk_buff, rxhash) != 4);
+			off = offsetof(struct sk_buff, rxhash);
+			emit_instr(ctx, lw, r_A, off, r_skb);
+			break;
+		case BPF_S_ANC_VLAN_TAG:
+		case BPF_S_ANC_VLAN_TAG_PRESENT:
+			ctx->seen |= SEEN_SKB;
+			BUILD_BUG_ON(FIELD_SIZEOF(struct sk_buff, vlan_tci) != 2);
+			off = offsetof(struct sk_buff, vlan_tci);
+			emit_instr(ctx, lhu, r_A, off, r_skb);
+			if (inst->code == BPF_S_ANC_VLAN_TAG) {
+				emit_instr(ctx, andi, r_A, r_A,
+					   ~VLAN_TAG_PRESENT & 0xffff);
+			} else {
+				emit_instr(ctx, andi, r_A, r_A,
+					   VLAN_TAG_PRESENT);
+				emit_instr(ctx, srl, r_A, r_A,
+					   ilog2(VLAN_TAG_PRESENT));
+			}
+			break;
+		case BPF_S_ANC_QUEUE:
+			ctx->seen |= SEEN_SKB;
+			BUILD_BUG_ON(FIELD_SIZEOF(struct sk_buff,
+						  queue_mapping) != 2);
+			off = offsetof(struct sk_buff, queue_mapping);
+			emit_instr(ctx, lhu, r_A, off, r_skb);
+			break;
+		default:
+			return -1;
+		}
+	}
+
+	/* compute offsets only during the first pass */
+	if (ctx->target == NULL)
+		ctx->offsets[i] = ctx->idx * 4;
+
+	return 0;
+}
+
+void bpf_jit_compile(struct sk_filter *fp)
+{
+	struct jit_ctx ctx;
+	unsigned int tmp_idx;
+	unsigned int alloc_size;
+
+	if (!bpf_jit_enable)
+		return;
+
+	/*
+	 * The generated code relies on the load and HI/LO interlocks of the
+	 * MIPS32 ISA, and the branches are encoded for the standard ISA.
+	 */
+	if (!cpu_has_mips32 || IS_ENABLED(CONFIG_CPU_MICROMIPS))
+		return;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.skf = fp;
+
+	ctx.offsets = kzalloc(4 * (ctx.skf->len + 1), GFP_KERNEL);
+	if (ctx.offsets == NULL)
+		return;
+
+	/* fake pass to fill in the ctx->seen */
+	if (unlikely(build_body(&ctx)))
+		goto out;
+
+	tmp_idx = ctx.idx;
+	build_prologue(&ctx);
+	ctx.prologue_bytes = (ctx.idx - tmp_idx) * 4;
+
+	build_epilogue(&ctx);
+
+	/* every branch has to be able to reach the epilogue */
+	alloc_size = 4 * ctx.idx;
+	if (alloc_size > MAX_BRANCH_BYTES)
+		goto out;
+
+	ctx.target = module_alloc(alloc_size);
+	if (unlikely(ctx.target == NULL))
+		goto out;
+
+	ctx.idx = 0;
+	build_prologue(&ctx);
+	build_body(&ctx);
+	build_epilogue(&ctx);
+
+	flush_icache_range((unsigned long)ctx.target,
+			   (unsigned long)(ctx.target + ctx.idx));
+
+	if (bpf_jit_enable > 1)
+		/* there are 2 passes here */
+		bpf_jit_dump(fp->len, alloc_size, 2, ctx.target);
+
+	fp->bpf_func = (void *)ctx.target;
+out:
+	kfree(ctx.offsets);
+}
+
+void bpf_jit_free(struct sk_filter *fp)
+{
+	if (fp->bpf_func != sk_run_filter)
+		module_free(NULL, fp->bpf_func);
+	kfree(fp);
+}
@@ -832,6 +832,26 @@ done:
 	return &blkcg->css;
 }
 
+/**
+ * blkcg_task_low_weight - check whether a task's blkcg is weighted down
+ * @tsk: task of interest
+ *
+ * Returns %true if the blkio.weight of the cgroup @tsk belongs to is below
+ * the default. I/O paths which bypass the block layer, like UBI on raw
+ * flash, use this to give way to the I/O of normally weighted cgroups.
+ */
+bool blkcg_task_low_weight(struct task_struct *tsk)
+{
+	bool ret;
+
+	rcu_read_lock();
+	ret = task_blkcg(tsk)->cfq_weight < CFQ_WEIGHT_DEFAULT;
+	rcu_read_unlock();
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(blkcg_task_low_weight);
+
 /**
  * blkcg_init_queue - initialize blkcg part of request queue
  * @q: request_queue to initialize
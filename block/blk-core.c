@@ -2058,6 +2058,30 @@ void blk_account_io_completion(struct request *req, unsigned int bytes)
 	}
 }
 
+#ifdef CONFIG_BLK_DEV_LATENCY_HIST
+static void blk_account_io_latency(int cpu, struct hd_struct *part,
+				   struct request *req, const int rw)
+{
+	u64 now, usecs;
+	int bucket;
+
+	preempt_disable();
+	now = sched_clock();
+	preempt_enable();
+
+	usecs = div_u64(now - rq_start_time_ns(req), NSEC_PER_USEC);
+	bucket = usecs ? ilog2(usecs) : 0;
+	if (bucket >= DISK_LAT_BUCKETS)
+		bucket = DISK_LAT_BUCKETS - 1;
+	part_stat_inc(cpu, part, lat_hist[rw][bucket]);
+}
+#else
+static inline void blk_account_io_latency(int cpu, struct hd_struct *part,
+					  struct request *req, const int rw)
+{
+}
+#endif
+
 void blk_account_io_done(struct request *req)
 {
 	/*
@@ -2076,11 +2100,16 @@ void blk_account_io_done(struct request *req)
 
 		part_stat_inc(cpu, part, ios[rw]);
 		part_stat_add(cpu, part, ticks[rw], duration);
+		blk_account_io_latency(cpu, part, req, rw);
 		part_round_stats(cpu, part);
 		part_dec_in_flight(part, rw);
 
 		hd_struct_put(part);
 		part_stat_unlock();
+
+		if (rw == READ)
+			bdi_update_read_latency(&req->q->backing_dev_info,
+						duration);
 	}
 }
 
@@ -22,6 +22,8 @@ static const int write_expire = 5 * HZ; /* ditto for writes, these limits are SO
 static const int writes_starved = 2;    /* max times reads can starve a write */
 static const int fifo_batch = 16;       /* # of sequential requests treated as one
 				     by the above parameters. For throughput. */
+static const int au_sectors = -1;	/* write grouping unit, -1 = io_opt on
+					   non-rotational queues, 0 = off */
 
 struct deadline_data {
 	/*
@@ -49,6 +51,7 @@ struct deadline_data {
 	int fifo_batch;
 	int writes_starved;
 	int front_merges;
+	int au_sectors;
 };
 
 static void deadline_move_request(struct deadline_data *, struct request *);
@@ -236,6 +239,53 @@ static inline int deadline_check_fifo(struct deadline_data *dd, int ddir)
 	return 0;
 }
 
+/*
+ * Flash devices pay for every allocation unit (erase block group) that is
+ * open for writing at once, so writes are grouped by AU: a write batch
+ * finishes the AU it is in before the usual fifo_batch limit applies, and
+ * a new write batch starts at the lowest pending sector of its AU.
+ */
+static unsigned int deadline_au_sectors(struct deadline_data *dd,
+					struct request_queue *q)
+{
+	if (dd->au_sectors >= 0)
+		return dd->au_sectors;
+	if (!blk_queue_nonrot(q))
+		return 0;
+	return queue_io_opt(q) >> 9;
+}
+
+static inline sector_t deadline_au_start(sector_t sector, unsigned int au)
+{
+	sector_t tmp = sector;
+
+	return sector - sector_div(tmp, au);
+}
+
+/*
+ * find the first pending write in the AU that holds rq
+ */
+static struct request *
+deadline_au_first(struct deadline_data *dd, struct request *rq,
+		  unsigned int au)
+{
+	sector_t start = deadline_au_start(blk_rq_pos(rq), au);
+	struct rb_node *node = dd->sort_list[WRITE].rb_node;
+	struct request *first = rq;
+
+	while (node) {
+		struct request *__rq = rb_entry_rq(node);
+
+		if (blk_rq_pos(__rq) >= start) {
+			first = __rq;
+			node = node->rb_left;
+		} else
+			node = node->rb_right;
+	}
+
+	return first;
+}
+
 /*
  * deadline_dispatch_requests selects the best request according to
  * read/write expire, fifo_batch, etc
@@ -245,6 +295,7 @@ static int deadline_dispatch_requests(struct request_queue *q, int force)
 	struct deadline_data *dd = q->elevator->elevator_data;
 	const int reads = !list_empty(&dd->fifo_list[READ]);
 	const int writes = !list_empty(&dd->fifo_list[WRITE]);
+	unsigned int au = deadline_au_sectors(dd, q);
 	struct request *rq;
 	int data_dir;
 
@@ -260,6 +311,15 @@ static int deadline_dispatch_requests(struct request_queue *q, int force)
 		/* we have a next request are still entitled to batch */
 		goto dispatch_request;
 
+	/*
+	 * keep writing into the open AU unless a read has expired
+	 */
+	if (au && rq && rq == dd->next_rq[WRITE] &&
+	    (!reads || !deadline_check_fifo(dd, READ)) &&
+	    deadline_au_start(blk_rq_pos(rq), au) ==
+	    deadline_au_start(dd->last_sector - 1, au))
+		goto dispatch_request;
+
 	/*
 	 * at this point we are not running a batch. select the appropriate
 	 * data direction (read / write)
@@ -304,6 +364,8 @@ dispatch_find_request:
 		 * Start again from the request with the earliest expiry time.
 		 */
 		rq = rq_entry_fifo(dd->fifo_list[data_dir].next);
+		if (au && data_dir == WRITE)
+			rq = deadline_au_first(dd, rq, au);
 	} else {
 		/*
 		 * The last req was the same dir and we have a next request in
@@ -362,6 +424,7 @@ static int deadline_init_queue(struct request_queue *q, struct elevator_type *e)
 	dd->writes_starved = writes_starved;
 	dd->front_merges = 1;
 	dd->fifo_batch = fifo_batch;
+	dd->au_sectors = au_sectors;
 
 	spin_lock_irq(q->queue_lock);
 	q->elevator = eq;
@@ -402,6 +465,7 @@ SHOW_FUNCTION(deadline_write_expire_show, dd->fifo_expire[WRITE], 1);
 SHOW_FUNCTION(deadline_writes_starved_show, dd->writes_starved, 0);
 SHOW_FUNCTION(deadline_front_merges_show, dd->front_merges, 0);
 SHOW_FUNCTION(deadline_fifo_batch_show, dd->fifo_batch, 0);
+SHOW_FUNCTION(deadline_au_sectors_show, dd->au_sectors, 0);
 #undef SHOW_FUNCTION
 
 #define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX, __CONV)			\
@@ -425,6 +489,7 @@ STORE_FUNCTION(deadline_write_expire_store, &dd->fifo_expire[WRITE], 0, INT_MAX,
 STORE_FUNCTION(deadline_writes_starved_store, &dd->writes_starved, INT_MIN, INT_MAX, 0);
 STORE_FUNCTION(deadline_front_merges_store, &dd->front_merges, 0, 1, 0);
 STORE_FUNCTION(deadline_fifo_batch_store, &dd->fifo_batch, 0, INT_MAX, 0);
+STORE_FUNCTION(deadline_au_sectors_store, &dd->au_sectors, -1, INT_MAX, 0);
 #undef STORE_FUNCTION
 
 #define DD_ATTR(name) \
@@ -437,6 +502,7 @@ static struct elv_fs_entry deadline_attrs[] = {
 	DD_ATTR(writes_starved),
 	DD_ATTR(front_merges),
 	DD_ATTR(fifo_batch),
+	DD_ATTR(au_sectors),
 	__ATTR_NULL
 };
 
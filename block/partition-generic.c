@@ -135,6 +135,27 @@ ssize_t part_stat_show(struct device *dev,
 		jiffies_to_msecs(part_stat_read(p, time_in_queue)));
 }
 
+#ifdef CONFIG_BLK_DEV_LATENCY_HIST
+/*
+ * One line per bucket: upper bound in microseconds, reads, writes.
+ * The last bucket has no upper bound and is shown as 0.
+ */
+ssize_t part_latency_hist_show(struct device *dev,
+			       struct device_attribute *attr, char *buf)
+{
+	struct hd_struct *p = dev_to_part(dev);
+	ssize_t len = 0;
+	int i;
+
+	for (i = 0; i < DISK_LAT_BUCKETS; i++)
+		len += sprintf(buf + len, "%8lu %8lu %8lu\n",
+			       i < DISK_LAT_BUCKETS - 1 ? 2UL << i : 0,
+			       part_stat_read(p, lat_hist[READ][i]),
+			       part_stat_read(p, lat_hist[WRITE][i]));
+	return len;
+}
+#endif
+
 ssize_t part_inflight_show(struct device *dev,
 			struct device_attribute *attr, char *buf)
 {
@@ -176,6 +197,9 @@ static DEVICE_ATTR(discard_alignment, S_IRUGO, part_discard_alignment_show,
 		   NULL);
 static DEVICE_ATTR(stat, S_IRUGO, part_stat_show, NULL);
 static DEVICE_ATTR(inflight, S_IRUGO, part_inflight_show, NULL);
+#ifdef CONFIG_BLK_DEV_LATENCY_HIST
+static DEVICE_ATTR(latency_hist, S_IRUGO, part_latency_hist_show, NULL);
+#endif
 #ifdef CONFIG_FAIL_MAKE_REQUEST
 static struct device_attribute dev_attr_fail =
 	__ATTR(make-it-fail, S_IRUGO|S_IWUSR, part_fail_show, part_fail_store);
@@ -190,6 +214,9 @@ static struct attribute *part_attrs[] = {
 	&dev_attr_discard_alignment.attr,
 	&dev_attr_stat.attr,
 	&dev_attr_inflight.attr,
+#ifdef CONFIG_BLK_DEV_LATENCY_HIST
+	&dev_attr_latency_hist.attr,
+#endif
 #ifdef CONFIG_FAIL_MAKE_REQUEST
 	&dev_attr_fail.attr,
 #endif
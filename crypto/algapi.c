@@ -15,7 +15,9 @@
 #include <linux/init.h>
 #include <linux/kernel.h>
 #include <linux/list.h>
+#include <linux/interrupt.h>
 #include <linux/module.h>
+#include <linux/percpu.h>
 #include <linux/rtnetlink.h>
 #include <linux/slab.h>
 #include <linux/string.h>
@@ -953,8 +955,64 @@ void crypto_xor(u8 *dst, const u8 *src, unsigned int size)
 }
 EXPORT_SYMBOL_GPL(crypto_xor);
 
+static DEFINE_PER_CPU(void *, crypto_scratch);
+
+/*
+ * A transform without CRYPTO_ALG_ASYNC has completed by the time the
+ * request call returns, so the caller is done with the buffer before it
+ * could be needed again on this CPU.  Bottom halves are kept disabled in
+ * between so that softirq users cannot nest.
+ */
+void *crypto_scratch_alloc(struct crypto_tfm *tfm, unsigned int len,
+			   gfp_t gfp)
+{
+	void *p;
+
+	if (len <= CRYPTO_SCRATCH_SIZE &&
+	    !(tfm->__crt_alg->cra_flags & CRYPTO_ALG_ASYNC)) {
+		local_bh_disable();
+		p = __this_cpu_read(crypto_scratch);
+		if (p)
+			return p;
+		local_bh_enable();
+	}
+
+	return kmalloc(len, gfp);
+}
+EXPORT_SYMBOL_GPL(crypto_scratch_alloc);
+
+void crypto_scratch_free(void *p)
+{
+	/* A kmalloc()ed buffer never matches, whichever CPU we are on. */
+	if (p && p == __this_cpu_read(crypto_scratch)) {
+		local_bh_enable();
+		return;
+	}
+
+	kfree(p);
+}
+EXPORT_SYMBOL_GPL(crypto_scratch_free);
+
+static void crypto_free_scratch(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		kfree(per_cpu(crypto_scratch, cpu));
+		per_cpu(crypto_scratch, cpu) = NULL;
+	}
+}
+
 static int __init crypto_algapi_init(void)
 {
+	int cpu;
+
+	/* Without scratch space everything simply falls back to kmalloc(). */
+	for_each_possible_cpu(cpu)
+		per_cpu(crypto_scratch, cpu) =
+			kmalloc_node(CRYPTO_SCRATCH_SIZE, GFP_KERNEL,
+				     cpu_to_node(cpu));
+
 	crypto_init_proc();
 	return 0;
 }
@@ -962,6 +1020,7 @@ static int __init crypto_algapi_init(void)
 static void __exit crypto_algapi_exit(void)
 {
 	crypto_exit_proc();
+	crypto_free_scratch();
 }
 
 module_init(crypto_algapi_init);
@@ -0,0 +1,298 @@
+/*
+ * Handle async block requests by crypto hardware engine.
+ *
+ * Requests are queued per engine and handed to the driver by a kthread,
+ * up to max_batch of them at a time, so that a DMA driven block can
+ * process a whole descriptor chain per interrupt.  The next batch is
+ * started once every request of the current one has been finalized.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ */
+
+#include <crypto/engine.h>
+#include <linux/delay.h>
+#include <linux/device.h>
+#include <linux/err.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+
+#define CRYPTO_ENGINE_MAX_QLEN	10
+#define CRYPTO_ENGINE_STOP_POLLS	100
+
+static void crypto_pump_requests(struct crypto_engine *engine)
+{
+	struct crypto_async_request *req;
+	unsigned long flags;
+	unsigned int n = 0, i;
+	bool was_idle;
+	int ret;
+
+	spin_lock_irqsave(&engine->queue_lock, flags);
+
+	/* The hardware is still busy with the previous batch */
+	if (engine->in_flight)
+		goto out_unlock;
+
+	if (!engine->running || !crypto_queue_len(&engine->queue)) {
+		if (engine->idling)
+			goto out_unlock;
+		engine->idling = true;
+		spin_unlock_irqrestore(&engine->queue_lock, flags);
+
+		if (engine->unprepare_crypt_hardware &&
+		    engine->unprepare_crypt_hardware(engine))
+			dev_err(engine->dev, "failed to unprepare crypt hardware\n");
+		return;
+	}
+
+	was_idle = engine->idling;
+	engine->idling = false;
+
+	while (n < engine->max_batch) {
+		engine->backlog[n] = crypto_get_backlog(&engine->queue);
+		req = crypto_dequeue_request(&engine->queue);
+		if (!req)
+			break;
+		engine->batch[n++] = req;
+	}
+	engine->in_flight = n;
+
+	spin_unlock_irqrestore(&engine->queue_lock, flags);
+
+	for (i = 0; i < n; i++)
+		if (engine->backlog[i])
+			engine->backlog[i]->complete(engine->backlog[i],
+						     -EINPROGRESS);
+
+	if (was_idle && engine->prepare_crypt_hardware) {
+		ret = engine->prepare_crypt_hardware(engine);
+		if (ret) {
+			dev_err(engine->dev, "failed to prepare crypt hardware\n");
+			goto fail;
+		}
+	}
+
+	ret = engine->do_batch(engine, engine->batch, n);
+	if (ret) {
+		dev_err(engine->dev, "failed to start batch of %u: %d\n",
+			n, ret);
+		goto fail;
+	}
+	return;
+
+fail:
+	for (i = 0; i < n; i++)
+		crypto_finalize_request(engine, engine->batch[i], ret);
+	return;
+
+out_unlock:
+	spin_unlock_irqrestore(&engine->queue_lock, flags);
+}
+
+static void crypto_pump_work(struct kthread_work *work)
+{
+	struct crypto_engine *engine =
+		container_of(work, struct crypto_engine, pump_requests);
+
+	crypto_pump_requests(engine);
+}
+
+/**
+ * crypto_transfer_request_to_engine - queue a request for the hardware
+ * @engine: the engine to run the request on
+ * @req: the request
+ *
+ * Returns -EINPROGRESS once queued, -EBUSY if the request went to the
+ * backlog or was refused as in crypto_enqueue_request(), and -ESHUTDOWN
+ * if the engine is not running.
+ */
+int crypto_transfer_request_to_engine(struct crypto_engine *engine,
+				      struct crypto_async_request *req)
+{
+	unsigned long flags;
+	int ret;
+
+	spin_lock_irqsave(&engine->queue_lock, flags);
+
+	if (!engine->running) {
+		spin_unlock_irqrestore(&engine->queue_lock, flags);
+		return -ESHUTDOWN;
+	}
+
+	ret = crypto_enqueue_request(&engine->queue, req);
+
+	if (!engine->in_flight)
+		queue_kthread_work(&engine->kworker, &engine->pump_requests);
+
+	spin_unlock_irqrestore(&engine->queue_lock, flags);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(crypto_transfer_request_to_engine);
+
+/**
+ * crypto_finalize_request - complete a request of the current batch
+ * @engine: the engine the request ran on
+ * @req: the request
+ * @err: error code passed to the completion
+ *
+ * May be called from the driver's interrupt handler or DMA completion
+ * callback.  The next batch is started once all requests of the current
+ * one have been finalized.
+ */
+void crypto_finalize_request(struct crypto_engine *engine,
+			     struct crypto_async_request *req, int err)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&engine->queue_lock, flags);
+	if (!WARN_ON(!engine->in_flight) && !--engine->in_flight)
+		queue_kthread_work(&engine->kworker, &engine->pump_requests);
+	spin_unlock_irqrestore(&engine->queue_lock, flags);
+
+	req->complete(req, err);
+}
+EXPORT_SYMBOL_GPL(crypto_finalize_request);
+
+/**
+ * crypto_engine_start - start accepting and processing requests
+ * @engine: the engine
+ */
+int crypto_engine_start(struct crypto_engine *engine)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&engine->queue_lock, flags);
+
+	if (engine->running || engine->in_flight) {
+		spin_unlock_irqrestore(&engine->queue_lock, flags);
+		return -EBUSY;
+	}
+
+	engine->running = true;
+	spin_unlock_irqrestore(&engine->queue_lock, flags);
+
+	queue_kthread_work(&engine->kworker, &engine->pump_requests);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(crypto_engine_start);
+
+/**
+ * crypto_engine_stop - stop the engine once the queue has drained
+ * @engine: the engine
+ *
+ * Returns -EBUSY if requests are still pending after a grace period.
+ */
+int crypto_engine_stop(struct crypto_engine *engine)
+{
+	unsigned long flags;
+	unsigned int polls = CRYPTO_ENGINE_STOP_POLLS;
+	int ret = 0;
+
+	spin_lock_irqsave(&engine->queue_lock, flags);
+
+	while ((crypto_queue_len(&engine->queue) || engine->in_flight) &&
+	       polls--) {
+		spin_unlock_irqrestore(&engine->queue_lock, flags);
+		msleep(20);
+		spin_lock_irqsave(&engine->queue_lock, flags);
+	}
+
+	if (crypto_queue_len(&engine->queue) || engine->in_flight)
+		ret = -EBUSY;
+	else
+		engine->running = false;
+
+	spin_unlock_irqrestore(&engine->queue_lock, flags);
+
+	if (ret)
+		dev_warn(engine->dev, "could not stop engine\n");
+	else
+		queue_kthread_work(&engine->kworker, &engine->pump_requests);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(crypto_engine_stop);
+
+/**
+ * crypto_engine_alloc_init - allocate a crypto engine
+ * @dev: the device the engine belongs to
+ * @rt: run the engine kthread with realtime priority
+ * @max_batch: most requests handed to the driver at once
+ *
+ * The driver fills in the callbacks and then calls crypto_engine_start().
+ */
+struct crypto_engine *crypto_engine_alloc_init(struct device *dev, bool rt,
+					       unsigned int max_batch)
+{
+	struct sched_param param = { .sched_priority = MAX_RT_PRIO - 1 };
+	struct crypto_engine *engine;
+
+	if (!dev || !max_batch)
+		return NULL;
+
+	engine = kzalloc(sizeof(*engine) +
+			 2 * max_batch * sizeof(*engine->batch), GFP_KERNEL);
+	if (!engine)
+		return NULL;
+
+	engine->dev = dev;
+	engine->rt = rt;
+	engine->idling = true;
+	engine->max_batch = max_batch;
+	engine->batch = (struct crypto_async_request **)(engine + 1);
+	engine->backlog = engine->batch + max_batch;
+	snprintf(engine->name, sizeof(engine->name), "%s-engine",
+		 dev_name(dev));
+
+	crypto_init_queue(&engine->queue, CRYPTO_ENGINE_MAX_QLEN);
+	spin_lock_init(&engine->queue_lock);
+
+	init_kthread_worker(&engine->kworker);
+	engine->kworker_task = kthread_run(kthread_worker_fn,
+					   &engine->kworker, "%s",
+					   engine->name);
+	if (IS_ERR(engine->kworker_task)) {
+		dev_err(dev, "failed to create crypto request pump task\n");
+		kfree(engine);
+		return NULL;
+	}
+	init_kthread_work(&engine->pump_requests, crypto_pump_work);
+
+	if (engine->rt) {
+		dev_info(dev, "will run requests pump with realtime priority\n");
+		sched_setscheduler(engine->kworker_task, SCHED_FIFO, &param);
+	}
+
+	return engine;
+}
+EXPORT_SYMBOL_GPL(crypto_engine_alloc_init);
+
+/**
+ * crypto_engine_exit - stop and free a crypto engine
+ * @engine: the engine
+ */
+int crypto_engine_exit(struct crypto_engine *engine)
+{
+	int ret;
+
+	ret = crypto_engine_stop(engine);
+	if (ret)
+		return ret;
+
+	flush_kthread_worker(&engine->kworker);
+	kthread_stop(engine->kworker_task);
+	kfree(engine);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(crypto_engine_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Crypto hardware engine framework");
@@ -25,6 +25,7 @@
 #include <linux/async.h>
 #include <linux/pm_runtime.h>
 #include <linux/pinctrl/devinfo.h>
+#include <linux/boot_timeline.h>
 
 #include "base.h"
 #include "power/power.h"
@@ -279,6 +280,7 @@ static int really_probe(struct device *dev, struct device_driver *drv)
 {
 	int ret = 0;
 	int local_trigger_count = atomic_read(&deferred_trigger_count);
+	u64 tl_start = boot_timeline_start();
 
 	atomic_inc(&probe_count);
 	pr_debug("bus: '%s': %s: probing driver %s with device %s\n",
@@ -342,6 +344,8 @@ probe_failed:
 	 */
 	ret = 0;
 done:
+	boot_timeline_end(BOOT_TL_PROBE, tl_start, "%s:%s",
+			  drv->name, dev_name(dev));
 	atomic_dec(&probe_count);
 	wake_up(&probe_waitqueue);
 	return ret;
@@ -402,32 +406,42 @@ int driver_probe_device(struct device_driver *drv, struct device *dev)
 	return ret;
 }
 
-static int __device_attach(struct device_driver *drv, void *data)
+static bool driver_allows_async_probing(struct device_driver *drv,
+					struct device *dev)
 {
-	struct device *dev = data;
+	return drv->probe_async || dev->async_probe;
+}
+
+struct device_attach_data {
+	struct device *dev;
+	bool allow_async;	/* may hand the probe to an async thread */
+	bool have_async;	/* matched a driver that wants that */
+};
+
+static int __device_attach_driver(struct device_driver *drv, void *_data)
+{
+	struct device_attach_data *data = _data;
+	struct device *dev = data->dev;
 
 	if (!driver_match_device(drv, dev))
 		return 0;
 
+	if (data->allow_async && driver_allows_async_probing(drv, dev)) {
+		data->have_async = true;
+		return 1;
+	}
+
 	return driver_probe_device(drv, dev);
 }
 
-/**
- * device_attach - try to attach device to a driver.
- * @dev: device.
- *
- * Walk the list of drivers that the bus has and call
- * driver_probe_device() for each pair. If a compatible
- * pair is found, break out and return.
- *
- * Returns 1 if the device was bound to a driver;
- * 0 if no matching driver was found;
- * -ENODEV if the device is not registered.
- *
- * When called for a USB interface, @dev->parent lock must be held.
- */
-int device_attach(struct device *dev)
+static void __device_attach_async_helper(void *_dev, async_cookie_t cookie);
+
+static int __device_attach(struct device *dev, bool allow_async)
 {
+	struct device_attach_data data = {
+		.dev		= dev,
+		.allow_async	= allow_async,
+	};
 	int ret = 0;
 
 	device_lock(dev);
@@ -444,15 +458,60 @@ int device_attach(struct device *dev)
 			ret = 0;
 		}
 	} else {
-		ret = bus_for_each_drv(dev->bus, NULL, dev, __device_attach);
-		pm_request_idle(dev);
+		ret = bus_for_each_drv(dev->bus, NULL, &data,
+				       __device_attach_driver);
+		if (data.have_async) {
+			/* wait_for_device_probe() waits for this */
+			dev_dbg(dev, "scheduling asynchronous probe\n");
+			get_device(dev);
+			async_schedule(__device_attach_async_helper, dev);
+			ret = 0;
+		} else {
+			pm_request_idle(dev);
+		}
 	}
 out_unlock:
 	device_unlock(dev);
 	return ret;
 }
+
+static void __device_attach_async_helper(void *_dev, async_cookie_t cookie)
+{
+	struct device *dev = _dev;
+
+	__device_attach(dev, false);
+	put_device(dev);
+}
+
+/**
+ * device_attach - try to attach device to a driver.
+ * @dev: device.
+ *
+ * Walk the list of drivers that the bus has and call
+ * driver_probe_device() for each pair. If a compatible
+ * pair is found, break out and return.
+ *
+ * Returns 1 if the device was bound to a driver;
+ * 0 if no matching driver was found;
+ * -ENODEV if the device is not registered.
+ *
+ * When called for a USB interface, @dev->parent lock must be held.
+ */
+int device_attach(struct device *dev)
+{
+	return __device_attach(dev, false);
+}
 EXPORT_SYMBOL_GPL(device_attach);
 
+/*
+ * Like device_attach(), but honours async probing.  Used when a device
+ * is first added to its bus.
+ */
+void device_initial_probe(struct device *dev)
+{
+	__device_attach(dev, true);
+}
+
 static int __driver_attach(struct device *dev, void *data)
 {
 	struct device_driver *drv = data;
@@ -470,6 +529,13 @@ static int __driver_attach(struct device *dev, void *data)
 	if (!driver_match_device(drv, dev))
 		return 0;
 
+	/* devices asking for it are probed async even for sync drivers */
+	if (dev->async_probe && !drv->probe_async) {
+		get_device(dev);
+		async_schedule(__device_attach_async_helper, dev);
+		return 0;
+	}
+
 	if (dev->parent)	/* Needed for USB */
 		device_lock(dev->parent);
 	device_lock(dev);
@@ -497,6 +563,36 @@ int driver_attach(struct device_driver *drv)
 }
 EXPORT_SYMBOL_GPL(driver_attach);
 
+static void driver_attach_async(void *_drv, async_cookie_t cookie)
+{
+	struct device_driver *drv = _drv;
+	int ret;
+
+	ret = driver_attach(drv);
+	pr_debug("bus: '%s': driver %s async attach completed: %d\n",
+		 drv->bus->name, drv->name, ret);
+}
+
+/**
+ * driver_attach_maybe_async - bind a newly registered driver to devices
+ * @drv: driver.
+ *
+ * Drivers with @probe_async set are bound from an async thread, so
+ * that their probes overlap with the rest of boot.  Everyone needing
+ * the devices to be there, mounting root in the first place, waits
+ * for them in wait_for_device_probe().
+ */
+int driver_attach_maybe_async(struct device_driver *drv)
+{
+	if (!drv->probe_async)
+		return driver_attach(drv);
+
+	pr_debug("bus: '%s': probing driver %s asynchronously\n",
+		 drv->bus->name, drv->name);
+	async_schedule(driver_attach_async, drv);
+	return 0;
+}
+
 /*
  * __device_release_driver() must be called with @dev lock held.
  * When called for a USB interface, @dev->parent lock must be held as well.
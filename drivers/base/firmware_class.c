@@ -28,6 +28,9 @@
 #include <linux/suspend.h>
 #include <linux/syscore_ops.h>
 #include <linux/reboot.h>
+#include <linux/boot_timeline.h>
+#include <linux/initrd.h>
+#include <linux/xz.h>
 
 #include <generated/utsrelease.h>
 
@@ -316,13 +319,168 @@ static int fw_read_file_contents(struct file *file, struct firmware_buf *fw_buf)
 	return 0;
 }
 
+/*
+ * Firmware files can also be read in chunks and handed to a consumer as
+ * they arrive, either for request_firmware_stream() or to decompress them.
+ */
+#define FW_STREAM_CHUNK		(16 * 1024)
+
+typedef int (*fw_consume_t)(void *context, const u8 *data, size_t len);
+
+static int fw_stream_plain(struct file *file, u8 *chunk,
+			   fw_consume_t consume, void *context)
+{
+	loff_t pos = 0;
+	int rc;
+
+	for (;;) {
+		rc = kernel_read(file, pos, chunk, FW_STREAM_CHUNK);
+		if (rc <= 0)
+			return rc;
+		pos += rc;
+		rc = consume(context, chunk, rc);
+		if (rc)
+			return rc;
+	}
+}
+
+#ifdef CONFIG_FW_LOADER_COMPRESS
+/* Firmware is small, there is no point in allowing huge dictionaries */
+#define FW_XZ_DICT_MAX		(1 << 20)
+
+/* @chunk holds FW_STREAM_CHUNK bytes of input followed by as much output */
+static int fw_stream_xz(struct file *file, u8 *chunk,
+			fw_consume_t consume, void *context)
+{
+	struct xz_dec *xz;
+	struct xz_buf b;
+	enum xz_ret ret;
+	loff_t pos = 0;
+	int rc = 0;
+
+	xz = xz_dec_init(XZ_DYNALLOC, FW_XZ_DICT_MAX);
+	if (!xz)
+		return -ENOMEM;
+
+	b.in = chunk;
+	b.in_pos = 0;
+	b.in_size = 0;
+	b.out = chunk + FW_STREAM_CHUNK;
+	b.out_pos = 0;
+	b.out_size = FW_STREAM_CHUNK;
+
+	do {
+		if (b.in_pos == b.in_size) {
+			rc = kernel_read(file, pos, chunk, FW_STREAM_CHUNK);
+			if (rc < 0)
+				goto out;
+			pos += rc;
+			b.in_pos = 0;
+			b.in_size = rc;
+			rc = 0;
+		}
+
+		ret = xz_dec_run(xz, &b);
+
+		if (b.out_pos == b.out_size ||
+		    (ret == XZ_STREAM_END && b.out_pos)) {
+			rc = consume(context, b.out, b.out_pos);
+			if (rc)
+				goto out;
+			b.out_pos = 0;
+		}
+	} while (ret == XZ_OK);
+
+	if (ret != XZ_STREAM_END)
+		rc = ret == XZ_MEM_ERROR ? -ENOMEM : -EINVAL;
+out:
+	xz_dec_end(xz);
+	return rc;
+}
+
+struct fw_xz_buf {
+	u8 *data;
+	size_t size;
+	size_t alloc;
+};
+
+static int fw_xz_append(void *context, const u8 *data, size_t len)
+{
+	struct fw_xz_buf *xb = context;
+	u8 *p;
+
+	if (xb->size + len > xb->alloc) {
+		size_t alloc = max(xb->alloc * 2, xb->size + len);
+
+		if (alloc > INT_MAX)
+			return -EFBIG;
+		p = vmalloc(alloc);
+		if (!p)
+			return -ENOMEM;
+		memcpy(p, xb->data, xb->size);
+		vfree(xb->data);
+		xb->data = p;
+		xb->alloc = alloc;
+	}
+	memcpy(xb->data + xb->size, data, len);
+	xb->size += len;
+	return 0;
+}
+
+static int fw_read_xz_contents(struct file *file, struct firmware_buf *fw_buf)
+{
+	struct fw_xz_buf xb = { };
+	u8 *chunk;
+	int rc;
+
+	chunk = vmalloc(2 * FW_STREAM_CHUNK);
+	if (!chunk)
+		return -ENOMEM;
+	rc = fw_stream_xz(file, chunk, fw_xz_append, &xb);
+	vfree(chunk);
+
+	if (!rc && !xb.size)
+		rc = -EINVAL;
+	if (rc) {
+		vfree(xb.data);
+		return rc;
+	}
+	fw_buf->data = xb.data;
+	fw_buf->size = xb.size;
+	return 0;
+}
+#endif
+
+/*
+ * Open the firmware file at @path, or with CONFIG_FW_LOADER_COMPRESS its
+ * xz compressed variant at @path.xz.  @path must have room for PATH_MAX.
+ */
+static struct file *fw_open_file(char *path, bool *compressed)
+{
+	struct file *file;
+
+	*compressed = false;
+	file = filp_open(path, O_RDONLY, 0);
+#ifdef CONFIG_FW_LOADER_COMPRESS
+	if (IS_ERR(file) && strlcat(path, ".xz", PATH_MAX) < PATH_MAX) {
+		file = filp_open(path, O_RDONLY, 0);
+		*compressed = true;
+	}
+#endif
+	return file;
+}
+
 static int fw_get_filesystem_firmware(struct device *device,
 				       struct firmware_buf *buf)
 {
 	int i;
 	int rc = -ENOENT;
-	char *path = __getname();
+	char *path;
+	bool compressed;
+
+	wait_for_initramfs();
 
+	path = __getname();
 	for (i = 0; i < ARRAY_SIZE(fw_path); i++) {
 		struct file *file;
 
@@ -332,10 +490,15 @@ static int fw_get_filesystem_firmware(struct device *device,
 
 		snprintf(path, PATH_MAX, "%s/%s", fw_path[i], buf->fw_id);
 
-		file = filp_open(path, O_RDONLY, 0);
+		file = fw_open_file(path, &compressed);
 		if (IS_ERR(file))
 			continue;
-		rc = fw_read_file_contents(file, buf);
+#ifdef CONFIG_FW_LOADER_COMPRESS
+		if (compressed)
+			rc = fw_read_xz_contents(file, buf);
+		else
+#endif
+			rc = fw_read_file_contents(file, buf);
 		fput(file);
 		if (rc)
 			dev_warn(device, "firmware, attempted to load %s, but failed with error %d\n",
@@ -1076,6 +1239,7 @@ _request_firmware(const struct firmware **firmware_p, const char *name,
 {
 	struct firmware *fw;
 	long timeout;
+	u64 tl_start;
 	int ret;
 
 	if (!firmware_p)
@@ -1107,6 +1271,7 @@ _request_firmware(const struct firmware **firmware_p, const char *name,
 		}
 	}
 
+	tl_start = boot_timeline_start();
 	ret = fw_get_filesystem_firmware(device, fw->priv);
 	if (ret) {
 		if (opt_flags & FW_OPT_FALLBACK) {
@@ -1121,6 +1286,7 @@ _request_firmware(const struct firmware **firmware_p, const char *name,
 
 	if (!ret)
 		ret = assign_firmware_buf(fw, device, opt_flags);
+	boot_timeline_end(BOOT_TL_FIRMWARE, tl_start, "%s", name);
 
 	usermodehelper_read_unlock();
 
@@ -1289,6 +1455,89 @@ request_firmware_nowait(
 }
 EXPORT_SYMBOL(request_firmware_nowait);
 
+/**
+ * request_firmware_stream: - feed a firmware image to a driver in chunks
+ * @name: name of firmware file
+ * @device: device for which firmware is being loaded
+ * @consume: called for each chunk of the image, in order
+ * @context: passed to @consume
+ *
+ *	Unlike request_firmware(), the image is never held in memory as a
+ *	whole: it is read, and decompressed if need be, a chunk at a time,
+ *	so a driver can push it to the device while the rest is being read.
+ *	A non-zero return from @consume aborts the load and is returned.
+ *
+ *	Only built-in firmware and the firmware search path are looked at;
+ *	there is no user helper fallback and the image is not cached for
+ *	resume.
+ **/
+int request_firmware_stream(const char *name, struct device *device,
+			    int (*consume)(void *context, const u8 *data,
+					   size_t len),
+			    void *context)
+{
+	struct firmware fw;
+	bool compressed;
+	char *path;
+	u8 *chunk;
+	int i, rc = -ENOENT;
+
+	if (!name || name[0] == '\0')
+		return -EINVAL;
+
+	if (fw_get_builtin_firmware(&fw, name))
+		return consume(context, fw.data, fw.size);
+
+	/* the filesystems may be frozen, as for _request_firmware() */
+	rc = usermodehelper_read_trylock();
+	if (WARN_ON(rc)) {
+		dev_err(device, "firmware: %s will not be loaded\n", name);
+		return rc;
+	}
+	rc = -ENOENT;
+
+	wait_for_initramfs();
+
+	chunk = vmalloc(2 * FW_STREAM_CHUNK);
+	path = __getname();
+	if (!chunk || !path) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(fw_path); i++) {
+		struct file *file;
+
+		if (!fw_path[i][0])
+			continue;
+
+		snprintf(path, PATH_MAX, "%s/%s", fw_path[i], name);
+
+		file = fw_open_file(path, &compressed);
+		if (IS_ERR(file))
+			continue;
+#ifdef CONFIG_FW_LOADER_COMPRESS
+		if (compressed)
+			rc = fw_stream_xz(file, chunk, consume, context);
+		else
+#endif
+			rc = fw_stream_plain(file, chunk, consume, context);
+		fput(file);
+		if (rc)
+			dev_warn(device, "firmware, attempted to stream %s, but failed with error %d\n",
+				 path, rc);
+		break;
+	}
+
+out:
+	if (path)
+		__putname(path);
+	vfree(chunk);
+	usermodehelper_read_unlock();
+	return rc;
+}
+EXPORT_SYMBOL_GPL(request_firmware_stream);
+
 #ifdef CONFIG_PM_SLEEP
 static ASYNC_DOMAIN_EXCLUSIVE(fw_cache_domain);
 
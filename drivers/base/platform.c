@@ -598,6 +598,9 @@ int __init_or_module platform_driver_probe(struct platform_driver *drv,
 	/* make sure driver won't have bind/unbind attributes */
 	drv->driver.suppress_bind_attrs = true;
 
+	/* the probe must be over by the time we look at the result */
+	drv->driver.probe_async = false;
+
 	/* temporary section violation during probe() */
 	drv->probe = probe;
 	retval = code = platform_driver_register(drv);
@@ -129,6 +129,12 @@ struct regmap {
 	void *cache;
 	u32 cache_dirty;
 
+	/* cache sync statistics, the times are in microseconds */
+	u32 cache_sync_count;
+	u32 cache_sync_writes;
+	u32 cache_sync_last_us;
+	u32 cache_sync_max_us;
+
 	struct reg_default *patch;
 	int patch_regs;
 
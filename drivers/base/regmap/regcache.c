@@ -13,6 +13,7 @@
 #include <linux/slab.h>
 #include <linux/export.h>
 #include <linux/device.h>
+#include <linux/ktime.h>
 #include <trace/events/regmap.h>
 #include <linux/bsearch.h>
 #include <linux/sort.h>
@@ -276,6 +277,16 @@ static int regcache_default_sync(struct regmap *map, unsigned int min,
 	return 0;
 }
 
+static void regcache_sync_account(struct regmap *map, ktime_t start)
+{
+	s64 us = ktime_us_delta(ktime_get(), start);
+
+	map->cache_sync_count++;
+	map->cache_sync_last_us = min_t(s64, us, U32_MAX);
+	map->cache_sync_max_us = max(map->cache_sync_max_us,
+				     map->cache_sync_last_us);
+}
+
 /**
  * regcache_sync: Sync the register cache with the hardware.
  *
@@ -293,6 +304,8 @@ int regcache_sync(struct regmap *map)
 	unsigned int i;
 	const char *name;
 	unsigned int bypass;
+	bool synced = false;
+	ktime_t start;
 
 	BUG_ON(!map->cache_ops);
 
@@ -307,6 +320,9 @@ int regcache_sync(struct regmap *map)
 	if (!map->cache_dirty)
 		goto out;
 
+	start = ktime_get();
+	synced = true;
+	map->cache_sync_writes = 0;
 	map->async = true;
 
 	/* Apply any patch first */
@@ -341,6 +357,9 @@ out:
 
 	regmap_async_complete(map);
 
+	if (synced)
+		regcache_sync_account(map, start);
+
 	trace_regcache_sync(map->dev, name, "stop");
 
 	return ret;
@@ -616,6 +635,7 @@ static int regcache_sync_block_single(struct regmap *map, void *block,
 		map->cache_bypass = 1;
 
 		ret = _regmap_write(map, regtmp, val);
+		map->cache_sync_writes++;
 
 		map->cache_bypass = 0;
 		if (ret != 0)
@@ -636,14 +656,15 @@ static int regcache_sync_block_raw_flush(struct regmap *map, const void **data,
 	if (*data == NULL)
 		return 0;
 
-	count = cur - base;
+	count = (cur - base) / map->reg_stride;
 
 	dev_dbg(map->dev, "Writing %zu bytes for %d registers from 0x%x-0x%x\n",
-		count * val_bytes, count, base, cur - 1);
+		count * val_bytes, count, base, cur - map->reg_stride);
 
 	map->cache_bypass = 1;
 
 	ret = _regmap_raw_write(map, base, *data, count * val_bytes);
+	map->cache_sync_writes++;
 
 	map->cache_bypass = 0;
 
@@ -659,7 +680,7 @@ static int regcache_sync_block_raw(struct regmap *map, void *block,
 {
 	unsigned int i, val;
 	unsigned int regtmp = 0;
-	unsigned int base = 0;
+	unsigned int base = 0, top = 0;
 	const void *data = NULL;
 	int ret;
 
@@ -668,7 +689,7 @@ static int regcache_sync_block_raw(struct regmap *map, void *block,
 
 		if (!regcache_reg_present(cache_present, i)) {
 			ret = regcache_sync_block_raw_flush(map, &data,
-							    base, regtmp);
+							    base, top);
 			if (ret != 0)
 				return ret;
 			continue;
@@ -676,11 +697,18 @@ static int regcache_sync_block_raw(struct regmap *map, void *block,
 
 		val = regcache_get_val(map, block, i);
 
-		/* Is this the hardware default?  If so skip. */
+		/*
+		 * Hardware defaults need no write, but rewriting one inside
+		 * a run is cheaper than splitting the write in two, so they
+		 * are only left out at the edges of a run.
+		 */
 		ret = regcache_lookup_reg(map, regtmp);
 		if (ret >= 0 && val == map->reg_defaults[ret].def) {
+			if (regmap_writeable(map, regtmp))
+				continue;
+
 			ret = regcache_sync_block_raw_flush(map, &data,
-							    base, regtmp);
+							    base, top);
 			if (ret != 0)
 				return ret;
 			continue;
@@ -690,10 +718,10 @@ static int regcache_sync_block_raw(struct regmap *map, void *block,
 			data = regcache_get_val_addr(map, block, i);
 			base = regtmp;
 		}
+		top = regtmp + map->reg_stride;
 	}
 
-	return regcache_sync_block_raw_flush(map, &data, base, regtmp +
-			map->reg_stride);
+	return regcache_sync_block_raw_flush(map, &data, base, top);
 }
 
 int regcache_sync_block(struct regmap *map, void *block,
@@ -529,6 +529,14 @@ void regmap_debugfs_init(struct regmap *map, const char *name)
 				    &map->cache_dirty);
 		debugfs_create_bool("cache_bypass", 0400, map->debugfs,
 				    &map->cache_bypass);
+		debugfs_create_u32("cache_sync_count", 0400, map->debugfs,
+				   &map->cache_sync_count);
+		debugfs_create_u32("cache_sync_writes", 0400, map->debugfs,
+				   &map->cache_sync_writes);
+		debugfs_create_u32("cache_sync_last_us", 0400, map->debugfs,
+				   &map->cache_sync_last_us);
+		debugfs_create_u32("cache_sync_max_us", 0400, map->debugfs,
+				   &map->cache_sync_max_us);
 	}
 
 	next = rb_first(&map->range_tree);
@@ -19,6 +19,8 @@
 #include <linux/mutex.h>
 #include <linux/zsmalloc.h>
 
+#include "zcomp.h"
+
 /*
  * Some arbitrary value. This is just to catch
  * invalid value for num_devices module parameter.
@@ -52,8 +54,16 @@ static const size_t max_zpage_size = PAGE_SIZE / 4 * 3;
 
 /* Flags for zram pages (table[page_no].flags) */
 enum zram_pageflags {
-	/* Page consists entirely of zeros */
-	ZRAM_ZERO,
+	/* Page is filled with one repeated word, kept in the handle */
+	ZRAM_SAME,
+	/* Page did not compress and is stored as is */
+	ZRAM_HUGE,
+	/* Page has not been accessed since the last idle marking */
+	ZRAM_IDLE,
+	/* Page lives on the backing device, handle is the block number */
+	ZRAM_WB,
+	/* Page is being written to the backing device */
+	ZRAM_UNDER_WB,
 
 	__NR_ZRAM_PAGEFLAGS,
 };
@@ -76,23 +86,26 @@ struct zram_stats {
 	atomic64_t failed_writes;	/* can happen when memory is too low */
 	atomic64_t invalid_io;	/* non-page-aligned I/O requests */
 	atomic64_t notify_free;	/* no. of swap slot free notifications */
-	atomic_t pages_zero;		/* no. of zero filled pages */
+	atomic_t pages_same;		/* no. of same filled pages */
 	atomic_t pages_stored;	/* no. of pages currently stored */
 	atomic_t good_compress;	/* % of pages with compression ratio<=50% */
 	atomic_t bad_compress;	/* % of pages with compression ratio>=75% */
+#ifdef CONFIG_ZRAM_WRITEBACK
+	atomic64_t bd_count;	/* no. of pages on the backing device */
+	atomic64_t bd_reads;	/* no. of reads from the backing device */
+	atomic64_t bd_writes;	/* no. of writes to the backing device */
+#endif
 };
 
 struct zram_meta {
 	rwlock_t tb_lock;	/* protect table */
-	void *compress_workmem;
-	void *compress_buffer;
 	struct table *table;
 	struct zs_pool *mem_pool;
-	struct mutex buffer_lock; /* protect compress buffers */
 };
 
 struct zram {
 	struct zram_meta *meta;
+	struct zcomp *comp;
 	struct request_queue *queue;
 	struct gendisk *disk;
 	int init_done;
@@ -103,7 +116,16 @@ struct zram {
 	 * we can store in a disk.
 	 */
 	u64 disksize;	/* bytes */
+	int max_comp_streams;
 
 	struct zram_stats stats;
+	char compressor[10];
+#ifdef CONFIG_ZRAM_WRITEBACK
+	struct block_device *bdev;
+	char *backing_dev;	/* path of @bdev */
+	unsigned long *bitmap;	/* used blocks of @bdev */
+	unsigned long nr_pages;	/* size of @bdev in pages */
+	struct mutex wb_lock;	/* one writeback_store() at a time */
+#endif
 };
 #endif
@@ -0,0 +1,594 @@
+/*
+ *  Copyright (C) 2010, Lars-Peter Clausen <lars@metafoo.de>
+ *  JZ4740 SoC clock support
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under  the terms of the GNU General	 Public License as published by the
+ *  Free Software Foundation;  either version 2 of the License, or (at your
+ *  option) any later version.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <linux/clkdev.h>
+#include <linux/clk-provider.h>
+#include <linux/err.h>
+#include <linux/io.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+
+#include <asm/mach-jz4740/base.h>
+#include <asm/mach-jz4740/clock.h>
+
+#define JZ_REG_CLOCK_CTRL	0x00
+#define JZ_REG_CLOCK_LOW_POWER	0x04
+#define JZ_REG_CLOCK_PLL	0x10
+#define JZ_REG_CLOCK_GATE	0x20
+#define JZ_REG_CLOCK_SLEEP_CTRL 0x24
+#define JZ_REG_CLOCK_I2S	0x60
+#define JZ_REG_CLOCK_LCD	0x64
+#define JZ_REG_CLOCK_MMC	0x68
+#define JZ_REG_CLOCK_UHC	0x6C
+#define JZ_REG_CLOCK_SPI	0x74
+
+#define JZ_CLOCK_CTRL_I2S_SRC_PLL	BIT(31)
+#define JZ_CLOCK_CTRL_KO_ENABLE		BIT(30)
+#define JZ_CLOCK_CTRL_UDC_SRC_PLL	BIT(29)
+#define JZ_CLOCK_CTRL_UDIV_MASK		0x1f800000
+#define JZ_CLOCK_CTRL_CHANGE_ENABLE	BIT(22)
+#define JZ_CLOCK_CTRL_PLL_HALF		BIT(21)
+#define JZ_CLOCK_CTRL_LDIV_MASK		0x001f0000
+#define JZ_CLOCK_CTRL_UDIV_OFFSET	23
+#define JZ_CLOCK_CTRL_LDIV_OFFSET	16
+#define JZ_CLOCK_CTRL_MDIV_OFFSET	12
+#define JZ_CLOCK_CTRL_PDIV_OFFSET	 8
+#define JZ_CLOCK_CTRL_HDIV_OFFSET	 4
+#define JZ_CLOCK_CTRL_CDIV_OFFSET	 0
+#define JZ_CLOCK_CTRL_DIV_WIDTH		 4
+
+#define JZ_CLOCK_GATE_UART0	BIT(0)
+#define JZ_CLOCK_GATE_TCU	BIT(1)
+#define JZ_CLOCK_GATE_RTC	BIT(2)
+#define JZ_CLOCK_GATE_I2C	BIT(3)
+#define JZ_CLOCK_GATE_SPI	BIT(4)
+#define JZ_CLOCK_GATE_AIC	BIT(5)
+#define JZ_CLOCK_GATE_I2S	BIT(6)
+#define JZ_CLOCK_GATE_MMC	BIT(7)
+#define JZ_CLOCK_GATE_ADC	BIT(8)
+#define JZ_CLOCK_GATE_CIM	BIT(9)
+#define JZ_CLOCK_GATE_LCD	BIT(10)
+#define JZ_CLOCK_GATE_UDC	BIT(11)
+#define JZ_CLOCK_GATE_DMAC	BIT(12)
+#define JZ_CLOCK_GATE_IPU	BIT(13)
+#define JZ_CLOCK_GATE_UHC	BIT(14)
+#define JZ_CLOCK_GATE_UART1	BIT(15)
+
+#define JZ_CLOCK_I2S_DIV_MASK		0x01ff
+
+#define JZ_CLOCK_LCD_DIV_MASK		0x01ff
+
+#define JZ_CLOCK_MMC_DIV_MASK		0x001f
+
+#define JZ_CLOCK_UHC_DIV_MASK		0x000f
+
+#define JZ_CLOCK_SPI_SRC_PLL		BIT(31)
+#define JZ_CLOCK_SPI_DIV_MASK		0x000f
+
+#define JZ_CLOCK_PLL_M_MASK		0x01ff
+#define JZ_CLOCK_PLL_N_MASK		0x001f
+#define JZ_CLOCK_PLL_OD_MASK		0x0003
+#define JZ_CLOCK_PLL_STABLE		BIT(10)
+#define JZ_CLOCK_PLL_BYPASS		BIT(9)
+#define JZ_CLOCK_PLL_ENABLED		BIT(8)
+#define JZ_CLOCK_PLL_STABLIZE_MASK	0x000f
+#define JZ_CLOCK_PLL_M_OFFSET		23
+#define JZ_CLOCK_PLL_N_OFFSET		18
+#define JZ_CLOCK_PLL_OD_OFFSET		16
+
+#define JZ_CLOCK_LOW_POWER_MODE_DOZE BIT(2)
+#define JZ_CLOCK_LOW_POWER_MODE_SLEEP BIT(0)
+
+#define JZ_CLOCK_SLEEP_CTRL_SUSPEND_UHC BIT(7)
+#define JZ_CLOCK_SLEEP_CTRL_ENABLE_UDC BIT(6)
+
+#define JZ_CLOCK_LCD_MAX_RATE		150000000
+
+static void __iomem *jz_clock_base;
+static DEFINE_SPINLOCK(jz_clock_lock);
+
+/*
+ * Description of a peripheral clock. Each clock consists of an optional
+ * parent mux, an optional divider and an optional gate, which are combined
+ * into a composite clock. The fields of the mux, divider and gate are given
+ * as register offset and bit mask, a zero mask means the part is absent.
+ */
+struct jz4740_clk_info {
+	const char *name;
+	const char *parents[2];
+	unsigned long flags;
+
+	struct {
+		uint8_t reg;
+		uint32_t mask;
+	} mux;
+
+	struct {
+		uint8_t reg;
+		uint32_t mask;
+		/* The divider is bypassed while the mux selects "ext" */
+		bool bypass;
+		unsigned long max_rate;
+	} div;
+
+	struct {
+		uint8_t reg;
+		uint32_t mask;
+		bool set_to_enable;
+	} gate;
+};
+
+struct jz4740_clk_div {
+	struct clk_divider div;
+	void __iomem *src_reg;
+	uint32_t src_mask;
+	unsigned long max_rate;
+};
+
+static inline struct jz4740_clk_div *to_jz4740_clk_div(struct clk_hw *hw)
+{
+	return container_of(hw, struct jz4740_clk_div, div.hw);
+}
+
+static uint32_t jz_clk_reg_read(int reg)
+{
+	return readl(jz_clock_base + reg);
+}
+
+static void jz_clk_reg_set_bits(int reg, uint32_t mask)
+{
+	unsigned long flags;
+	uint32_t val;
+
+	spin_lock_irqsave(&jz_clock_lock, flags);
+	val = readl(jz_clock_base + reg);
+	val |= mask;
+	writel(val, jz_clock_base + reg);
+	spin_unlock_irqrestore(&jz_clock_lock, flags);
+}
+
+static void jz_clk_reg_clear_bits(int reg, uint32_t mask)
+{
+	unsigned long flags;
+	uint32_t val;
+
+	spin_lock_irqsave(&jz_clock_lock, flags);
+	val = readl(jz_clock_base + reg);
+	val &= ~mask;
+	writel(val, jz_clock_base + reg);
+	spin_unlock_irqrestore(&jz_clock_lock, flags);
+}
+
+static const int pllno[] = {1, 2, 2, 4};
+
+static unsigned long jz_clk_pll_recalc_rate(struct clk_hw *hw,
+	unsigned long parent_rate)
+{
+	uint32_t val;
+	int m;
+	int n;
+	int od;
+
+	val = jz_clk_reg_read(JZ_REG_CLOCK_PLL);
+
+	if (val & JZ_CLOCK_PLL_BYPASS)
+		return parent_rate;
+
+	m = ((val >> JZ_CLOCK_PLL_M_OFFSET) & JZ_CLOCK_PLL_M_MASK) + 2;
+	n = ((val >> JZ_CLOCK_PLL_N_OFFSET) & JZ_CLOCK_PLL_N_MASK) + 2;
+	od = (val >> JZ_CLOCK_PLL_OD_OFFSET) & JZ_CLOCK_PLL_OD_MASK;
+
+	return ((parent_rate / n) * m) / pllno[od];
+}
+
+static const struct clk_ops jz_clk_pll_ops = {
+	.recalc_rate = jz_clk_pll_recalc_rate,
+};
+
+static unsigned long jz_clk_pll_half_recalc_rate(struct clk_hw *hw,
+	unsigned long parent_rate)
+{
+	if (jz_clk_reg_read(JZ_REG_CLOCK_CTRL) & JZ_CLOCK_CTRL_PLL_HALF)
+		return parent_rate;
+	return parent_rate >> 1;
+}
+
+static const struct clk_ops jz_clk_pll_half_ops = {
+	.recalc_rate = jz_clk_pll_half_recalc_rate,
+};
+
+static bool jz_clk_div_is_bypassed(struct jz4740_clk_div *div)
+{
+	return div->src_reg && !(readl(div->src_reg) & div->src_mask);
+}
+
+static unsigned long jz_clk_div_recalc_rate(struct clk_hw *hw,
+	unsigned long parent_rate)
+{
+	if (jz_clk_div_is_bypassed(to_jz4740_clk_div(hw)))
+		return parent_rate;
+
+	return clk_divider_ops.recalc_rate(hw, parent_rate);
+}
+
+static long jz_clk_div_round_rate(struct clk_hw *hw, unsigned long rate,
+	unsigned long *parent_rate)
+{
+	struct jz4740_clk_div *div = to_jz4740_clk_div(hw);
+
+	if (jz_clk_div_is_bypassed(div))
+		return *parent_rate;
+
+	if (div->max_rate && rate > div->max_rate)
+		rate = div->max_rate;
+
+	return clk_divider_ops.round_rate(hw, rate, parent_rate);
+}
+
+static int jz_clk_div_set_rate(struct clk_hw *hw, unsigned long rate,
+	unsigned long parent_rate)
+{
+	struct jz4740_clk_div *div = to_jz4740_clk_div(hw);
+
+	if (jz_clk_div_is_bypassed(div))
+		return 0;
+
+	if (div->max_rate && rate > div->max_rate)
+		return -EINVAL;
+
+	return clk_divider_ops.set_rate(hw, rate, parent_rate);
+}
+
+static const struct clk_ops jz_clk_div_ops = {
+	.recalc_rate = jz_clk_div_recalc_rate,
+	.round_rate = jz_clk_div_round_rate,
+	.set_rate = jz_clk_div_set_rate,
+};
+
+static const struct clk_div_table jz_clk_main_div_table[] = {
+	{ .val = 0, .div = 1 },
+	{ .val = 1, .div = 2 },
+	{ .val = 2, .div = 3 },
+	{ .val = 3, .div = 4 },
+	{ .val = 4, .div = 6 },
+	{ .val = 5, .div = 8 },
+	{ .val = 6, .div = 12 },
+	{ .val = 7, .div = 16 },
+	{ .val = 8, .div = 24 },
+	{ .val = 9, .div = 32 },
+	{ },
+};
+
+static const struct {
+	const char *name;
+	uint8_t offset;
+} jz4740_main_clks[] __initconst = {
+	{ "cclk", JZ_CLOCK_CTRL_CDIV_OFFSET },
+	{ "hclk", JZ_CLOCK_CTRL_HDIV_OFFSET },
+	{ "pclk", JZ_CLOCK_CTRL_PDIV_OFFSET },
+	{ "mclk", JZ_CLOCK_CTRL_MDIV_OFFSET },
+};
+
+static struct jz4740_clk_info jz4740_clks[] __initdata = {
+	{
+		.name = "cko",
+		.parents = { "mclk" },
+		/* Used as the SDRAM clock, must never be turned off */
+		.flags = CLK_IGNORE_UNUSED,
+		.gate = { JZ_REG_CLOCK_CTRL, JZ_CLOCK_CTRL_KO_ENABLE, true },
+	},
+	{
+		.name = "lcd",
+		.parents = { "pll half" },
+		.div = { JZ_REG_CLOCK_CTRL, JZ_CLOCK_CTRL_LDIV_MASK,
+			.max_rate = JZ_CLOCK_LCD_MAX_RATE },
+		.gate = { JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_LCD },
+	},
+	{
+		.name = "i2s",
+		.parents = { "ext", "pll half" },
+		.mux = { JZ_REG_CLOCK_CTRL, JZ_CLOCK_CTRL_I2S_SRC_PLL },
+		.div = { JZ_REG_CLOCK_I2S, JZ_CLOCK_I2S_DIV_MASK, true },
+		.gate = { JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_I2S },
+	},
+	{
+		.name = "spi",
+		.parents = { "ext", "pll half" },
+		.mux = { JZ_REG_CLOCK_SPI, JZ_CLOCK_SPI_SRC_PLL },
+		.div = { JZ_REG_CLOCK_SPI, JZ_CLOCK_SPI_DIV_MASK, true },
+		.gate = { JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_SPI },
+	},
+	{
+		.name = "lcd_pclk",
+		.parents = { "pll half" },
+		.div = { JZ_REG_CLOCK_LCD, JZ_CLOCK_LCD_DIV_MASK },
+	},
+	{
+		.name = "mmc",
+		.parents = { "pll half" },
+		.div = { JZ_REG_CLOCK_MMC, JZ_CLOCK_MMC_DIV_MASK },
+		.gate = { JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_MMC },
+	},
+	{
+		.name = "uhc",
+		.parents = { "pll half" },
+		.div = { JZ_REG_CLOCK_UHC, JZ_CLOCK_UHC_DIV_MASK },
+		.gate = { JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_UHC },
+	},
+	{
+		.name = "udc",
+		.parents = { "ext", "pll half" },
+		.mux = { JZ_REG_CLOCK_CTRL, JZ_CLOCK_CTRL_UDC_SRC_PLL },
+		.div = { JZ_REG_CLOCK_CTRL, JZ_CLOCK_CTRL_UDIV_MASK, true },
+		.gate = { JZ_REG_CLOCK_SLEEP_CTRL,
+			JZ_CLOCK_SLEEP_CTRL_ENABLE_UDC, true },
+	},
+	{
+		.name = "uart0",
+		.parents = { "ext" },
+		/* The serial console does not manage its clock */
+		.flags = CLK_IGNORE_UNUSED,
+		.gate = { JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_UART0 },
+	},
+	{
+		.name = "uart1",
+		.parents = { "ext" },
+		.flags = CLK_IGNORE_UNUSED,
+		.gate = { JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_UART1 },
+	},
+	{
+		.name = "dma",
+		.parents = { "hclk" },
+		.gate = { JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_DMAC },
+	},
+	{
+		.name = "ipu",
+		.parents = { "hclk" },
+		.gate = { JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_IPU },
+	},
+	{
+		.name = "adc",
+		.parents = { "ext" },
+		.gate = { JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_ADC },
+	},
+	{
+		.name = "i2c",
+		.parents = { "ext" },
+		.gate = { JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_I2C },
+	},
+	{
+		.name = "aic",
+		.parents = { "ext" },
+		.gate = { JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_AIC },
+	},
+	{
+		.name = "rtc",
+		.parents = { "osc32k" },
+		/* The RTC driver does not manage its clock */
+		.flags = CLK_IGNORE_UNUSED,
+		.gate = { JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_RTC },
+	},
+};
+
+static struct clk * __init jz_clk_register_simple(const char *name,
+	const char *parent_name, const struct clk_ops *ops)
+{
+	struct clk_init_data init;
+	struct clk_hw *hw;
+	struct clk *clk;
+
+	hw = kzalloc(sizeof(*hw), GFP_KERNEL);
+	if (!hw)
+		return ERR_PTR(-ENOMEM);
+
+	init.name = name;
+	init.ops = ops;
+	init.flags = 0;
+	init.parent_names = &parent_name;
+	init.num_parents = 1;
+	hw->init = &init;
+
+	clk = clk_register(NULL, hw);
+	if (IS_ERR(clk))
+		kfree(hw);
+
+	return clk;
+}
+
+static struct clk * __init jz_clk_register(const struct jz4740_clk_info *info)
+{
+	const struct clk_ops *mux_ops = NULL, *div_ops = NULL, *gate_ops = NULL;
+	struct clk_hw *mux_hw = NULL, *div_hw = NULL, *gate_hw = NULL;
+	struct clk_mux *mux = NULL;
+	struct jz4740_clk_div *div = NULL;
+	struct clk_gate *gate = NULL;
+	struct clk *clk;
+
+	if (info->mux.mask) {
+		mux = kzalloc(sizeof(*mux), GFP_KERNEL);
+		if (!mux)
+			goto err_nomem;
+
+		mux->reg = jz_clock_base + info->mux.reg;
+		mux->shift = __ffs(info->mux.mask);
+		mux->mask = info->mux.mask >> mux->shift;
+		mux->lock = &jz_clock_lock;
+
+		mux_hw = &mux->hw;
+		mux_ops = &clk_mux_ops;
+	}
+
+	if (info->div.mask) {
+		div = kzalloc(sizeof(*div), GFP_KERNEL);
+		if (!div)
+			goto err_nomem;
+
+		div->div.reg = jz_clock_base + info->div.reg;
+		div->div.shift = __ffs(info->div.mask);
+		div->div.width = fls(info->div.mask) - div->div.shift;
+		div->div.lock = &jz_clock_lock;
+		div->max_rate = info->div.max_rate;
+		if (info->div.bypass) {
+			div->src_reg = mux->reg;
+			div->src_mask = info->mux.mask;
+		}
+
+		div_hw = &div->div.hw;
+		div_ops = &jz_clk_div_ops;
+	}
+
+	if (info->gate.mask) {
+		gate = kzalloc(sizeof(*gate), GFP_KERNEL);
+		if (!gate)
+			goto err_nomem;
+
+		gate->reg = jz_clock_base + info->gate.reg;
+		gate->bit_idx = __ffs(info->gate.mask);
+		if (!info->gate.set_to_enable)
+			gate->flags = CLK_GATE_SET_TO_DISABLE;
+		gate->lock = &jz_clock_lock;
+
+		gate_hw = &gate->hw;
+		gate_ops = &clk_gate_ops;
+	}
+
+	clk = clk_register_composite(NULL, info->name, (const char **)info->parents,
+			info->parents[1] ? 2 : 1, mux_hw, mux_ops, div_hw, div_ops,
+			gate_hw, gate_ops, info->flags);
+	if (IS_ERR(clk))
+		goto err_free;
+
+	return clk;
+
+err_nomem:
+	clk = ERR_PTR(-ENOMEM);
+err_free:
+	kfree(gate);
+	kfree(div);
+	kfree(mux);
+	return clk;
+}
+
+static void __init jz_clk_add(struct clk *clk, const char *name)
+{
+	if (IS_ERR(clk)) {
+		pr_err("jz4740: Failed to register clock %s: %ld\n", name,
+			PTR_ERR(clk));
+		return;
+	}
+
+	clk_register_clkdev(clk, name, NULL);
+}
+
+void jz4740_clock_set_wait_mode(enum jz4740_wait_mode mode)
+{
+	switch (mode) {
+	case JZ4740_WAIT_MODE_IDLE:
+		jz_clk_reg_clear_bits(JZ_REG_CLOCK_LOW_POWER, JZ_CLOCK_LOW_POWER_MODE_SLEEP);
+		break;
+	case JZ4740_WAIT_MODE_SLEEP:
+		jz_clk_reg_set_bits(JZ_REG_CLOCK_LOW_POWER, JZ_CLOCK_LOW_POWER_MODE_SLEEP);
+		break;
+	}
+}
+
+void jz4740_clock_udc_disable_auto_suspend(void)
+{
+	jz_clk_reg_clear_bits(JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_UDC);
+}
+EXPORT_SYMBOL_GPL(jz4740_clock_udc_disable_auto_suspend);
+
+void jz4740_clock_udc_enable_auto_suspend(void)
+{
+	jz_clk_reg_set_bits(JZ_REG_CLOCK_GATE, JZ_CLOCK_GATE_UDC);
+}
+EXPORT_SYMBOL_GPL(jz4740_clock_udc_enable_auto_suspend);
+
+void jz4740_clock_suspend(void)
+{
+	jz_clk_reg_set_bits(JZ_REG_CLOCK_GATE,
+		JZ_CLOCK_GATE_TCU | JZ_CLOCK_GATE_DMAC | JZ_CLOCK_GATE_UART0);
+}
+
+void jz4740_clock_resume(void)
+{
+	jz_clk_reg_clear_bits(JZ_REG_CLOCK_GATE,
+		JZ_CLOCK_GATE_TCU | JZ_CLOCK_GATE_DMAC | JZ_CLOCK_GATE_UART0);
+}
+
+void jz4740_clock_pll_disable(void)
+{
+	jz_clk_reg_clear_bits(JZ_REG_CLOCK_PLL, JZ_CLOCK_PLL_ENABLED);
+}
+
+void jz4740_clock_pll_enable(void)
+{
+	uint32_t pll;
+
+	jz_clk_reg_set_bits(JZ_REG_CLOCK_PLL, JZ_CLOCK_PLL_ENABLED);
+
+	do {
+		pll = jz_clk_reg_read(JZ_REG_CLOCK_PLL);
+	} while (!(pll & JZ_CLOCK_PLL_STABLE));
+}
+
+static int __init jz4740_clock_init(void)
+{
+	struct clk *clk;
+	size_t i;
+
+	jz_clock_base = ioremap(JZ4740_CPM_BASE_ADDR, 0x100);
+	if (!jz_clock_base)
+		return -EBUSY;
+
+	/*
+	 * Let changes of the CPU, AHB, APB and memory clock dividers take
+	 * effect right away. The divider clocks only update their own field
+	 * of the register, so the bit stays set from here on.
+	 */
+	jz_clk_reg_set_bits(JZ_REG_CLOCK_CTRL, JZ_CLOCK_CTRL_CHANGE_ENABLE);
+
+	clk = clk_register_fixed_rate(NULL, "ext", NULL, CLK_IS_ROOT,
+			jz4740_clock_bdata.ext_rate);
+	jz_clk_add(clk, "ext");
+
+	clk = clk_register_fixed_rate(NULL, "osc32k", NULL, CLK_IS_ROOT,
+			jz4740_clock_bdata.rtc_rate);
+	jz_clk_add(clk, "osc32k");
+
+	clk = jz_clk_register_simple("pll", "ext", &jz_clk_pll_ops);
+	jz_clk_add(clk, "pll");
+
+	clk = jz_clk_register_simple("pll half", "pll", &jz_clk_pll_half_ops);
+	jz_clk_add(clk, "pll half");
+
+	for (i = 0; i < ARRAY_SIZE(jz4740_main_clks); ++i) {
+		clk = clk_register_divider_table(NULL, jz4740_main_clks[i].name,
+				"pll", 0, jz_clock_base + JZ_REG_CLOCK_CTRL,
+				jz4740_main_clks[i].offset, JZ_CLOCK_CTRL_DIV_WIDTH,
+				0, jz_clk_main_div_table, &jz_clock_lock);
+		jz_clk_add(clk, jz4740_main_clks[i].name);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(jz4740_clks); ++i) {
+		clk = jz_clk_register(&jz4740_clks[i]);
+		jz_clk_add(clk, jz4740_clks[i].name);
+	}
+
+	return 0;
+}
+arch_initcall(jz4740_clock_init);
@@ -0,0 +1,185 @@
+/*
+ *  JZ4740 CPU frequency scaling support
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under  the terms of the GNU General	 Public License as published by the
+ *  Free Software Foundation;  either version 2 of the License, or (at your
+ *  option) any later version.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <linux/clk.h>
+#include <linux/cpu_cooling.h>
+#include <linux/cpufreq.h>
+#include <linux/err.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+
+#include <asm/cpu-info.h>
+
+/* Possible values of the CPU clock divider */
+static const unsigned int jz4740_cpufreq_divs[] = {
+	1, 2, 3, 4, 6, 8, 12, 16, 24, 32
+};
+
+static struct cpufreq_frequency_table *jz4740_cpufreq_table;
+static struct thermal_cooling_device *jz4740_cpufreq_cooling;
+
+static int jz4740_cpufreq_notifier(struct notifier_block *nb,
+	unsigned long val, void *data)
+{
+	if (val == CPUFREQ_POSTCHANGE)
+		current_cpu_data.udelay_val = loops_per_jiffy;
+
+	return 0;
+}
+
+static struct notifier_block jz4740_cpufreq_notifier_block = {
+	.notifier_call = jz4740_cpufreq_notifier,
+};
+
+static int jz4740_cpufreq_target(struct cpufreq_policy *policy,
+	unsigned int index)
+{
+	return clk_set_rate(policy->clk,
+			jz4740_cpufreq_table[index].frequency * 1000);
+}
+
+/*
+ * Only the CPU clock divider is changed, while the PLL and the AHB, APB and
+ * memory clock dividers are left alone. The SDRAM controller keeps running
+ * at the same rate and its timings stay valid, so there is no need to
+ * reprogram them or to wait for the PLL to relock. The CPU clock must be an
+ * integer multiple of the AHB clock though, which limits the usable dividers.
+ */
+static int jz4740_cpufreq_build_table(unsigned long pll_rate,
+	unsigned long hclk_rate)
+{
+	unsigned long rate;
+	size_t i, n = 0;
+
+	jz4740_cpufreq_table = kcalloc(ARRAY_SIZE(jz4740_cpufreq_divs) + 1,
+			sizeof(*jz4740_cpufreq_table), GFP_KERNEL);
+	if (!jz4740_cpufreq_table)
+		return -ENOMEM;
+
+	for (i = 0; i < ARRAY_SIZE(jz4740_cpufreq_divs); ++i) {
+		rate = pll_rate / jz4740_cpufreq_divs[i];
+		if (rate < hclk_rate || rate % hclk_rate)
+			continue;
+
+		jz4740_cpufreq_table[n].frequency = rate / 1000;
+		++n;
+	}
+	jz4740_cpufreq_table[n].frequency = CPUFREQ_TABLE_END;
+
+	return 0;
+}
+
+static int jz4740_cpufreq_init(struct cpufreq_policy *policy)
+{
+	struct clk *cpuclk, *pll, *hclk;
+	int ret;
+
+	cpuclk = clk_get(NULL, "cclk");
+	if (IS_ERR(cpuclk))
+		return PTR_ERR(cpuclk);
+
+	pll = clk_get(NULL, "pll");
+	hclk = clk_get(NULL, "hclk");
+	if (IS_ERR(pll) || IS_ERR(hclk)) {
+		ret = -ENODEV;
+		goto err_put_clks;
+	}
+
+	ret = jz4740_cpufreq_build_table(clk_get_rate(pll), clk_get_rate(hclk));
+	if (ret)
+		goto err_put_clks;
+
+	clk_put(hclk);
+	clk_put(pll);
+
+	policy->clk = cpuclk;
+
+	/* Changing the divider takes a few cycles of the slowest clock */
+	ret = cpufreq_generic_init(policy, jz4740_cpufreq_table, 10000);
+	if (ret)
+		goto err_free_table;
+
+	return 0;
+
+err_free_table:
+	kfree(jz4740_cpufreq_table);
+	clk_put(cpuclk);
+	return ret;
+
+err_put_clks:
+	if (!IS_ERR(hclk))
+		clk_put(hclk);
+	if (!IS_ERR(pll))
+		clk_put(pll);
+	clk_put(cpuclk);
+	return ret;
+}
+
+static int jz4740_cpufreq_exit(struct cpufreq_policy *policy)
+{
+	cpufreq_frequency_table_put_attr(policy->cpu);
+	kfree(jz4740_cpufreq_table);
+	clk_put(policy->clk);
+
+	return 0;
+}
+
+static struct cpufreq_driver jz4740_cpufreq_driver = {
+	.name = "jz4740",
+	.init = jz4740_cpufreq_init,
+	.exit = jz4740_cpufreq_exit,
+	.verify = cpufreq_generic_frequency_table_verify,
+	.target_index = jz4740_cpufreq_target,
+	.get = cpufreq_generic_get,
+	.attr = cpufreq_generic_attr,
+};
+
+static int __init jz4740_cpufreq_module_init(void)
+{
+	int ret;
+
+	cpufreq_register_notifier(&jz4740_cpufreq_notifier_block,
+				  CPUFREQ_TRANSITION_NOTIFIER);
+
+	ret = cpufreq_register_driver(&jz4740_cpufreq_driver);
+	if (ret) {
+		cpufreq_unregister_notifier(&jz4740_cpufreq_notifier_block,
+					    CPUFREQ_TRANSITION_NOTIFIER);
+		return ret;
+	}
+
+	/* Lets the board thermal zone cap the CPU clock when it runs hot */
+	jz4740_cpufreq_cooling = cpufreq_cooling_register(cpu_present_mask);
+	if (IS_ERR(jz4740_cpufreq_cooling)) {
+		pr_warn("jz4740-cpufreq: Failed to register cooling device: %ld\n",
+			PTR_ERR(jz4740_cpufreq_cooling));
+		jz4740_cpufreq_cooling = NULL;
+	}
+
+	return 0;
+}
+module_init(jz4740_cpufreq_module_init);
+
+static void __exit jz4740_cpufreq_module_exit(void)
+{
+	cpufreq_cooling_unregister(jz4740_cpufreq_cooling);
+	cpufreq_unregister_driver(&jz4740_cpufreq_driver);
+	cpufreq_unregister_notifier(&jz4740_cpufreq_notifier_block,
+				    CPUFREQ_TRANSITION_NOTIFIER);
+}
+module_exit(jz4740_cpufreq_module_exit);
+
+MODULE_DESCRIPTION("JZ4740 CPU frequency scaling driver");
+MODULE_LICENSE("GPL");
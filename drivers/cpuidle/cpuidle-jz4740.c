@@ -0,0 +1,106 @@
+/*
+ * CPU idle support for Ingenic JZ4740 SoCs
+ *
+ * This file is licensed under the terms of the GNU General Public
+ * License version 2.  This program is licensed "as is" without any
+ * warranty of any kind, whether express or implied.
+ *
+ * The cpu idle uses the wait instruction and SDRAM power-down in order
+ * to implement two idle states -
+ * #1 wait
+ * #2 wait and SDRAM power-down
+ *
+ * In power-down mode the EMC drops CKE whenever no access is pending and
+ * raises it again on the next access, so bus masters like the LCD or DMA
+ * controller keep working while the CPU sleeps. Each wakeup of the SDRAM
+ * costs a few memory clock cycles though, which is why this is only done
+ * when the CPU is expected to be idle for a while.
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/platform_device.h>
+#include <linux/cpuidle.h>
+#include <linux/io.h>
+#include <linux/export.h>
+
+#include <asm/idle.h>
+
+#define JZ4740_MAX_STATES	2
+
+#define JZ_EMC_SDRAM_CTRL_POWER_DOWN	BIT(18)
+
+static void __iomem *jz4740_sdram_ctrl;
+
+static int jz4740_enter_wait(struct cpuidle_device *dev,
+			     struct cpuidle_driver *drv, int index)
+{
+	cpu_wait();
+	return index;
+}
+
+static int jz4740_enter_power_down(struct cpuidle_device *dev,
+				   struct cpuidle_driver *drv, int index)
+{
+	uint32_t ctrl = readl(jz4740_sdram_ctrl);
+
+	writel(ctrl | JZ_EMC_SDRAM_CTRL_POWER_DOWN, jz4740_sdram_ctrl);
+	cpu_wait();
+	writel(ctrl, jz4740_sdram_ctrl);
+
+	return index;
+}
+
+static struct cpuidle_driver jz4740_idle_driver = {
+	.name			= "jz4740_idle",
+	.owner			= THIS_MODULE,
+	.states[0]		= {
+		.enter			= jz4740_enter_wait,
+		.exit_latency		= 1,
+		.target_residency	= 1,
+		.flags			= CPUIDLE_FLAG_TIME_VALID,
+		.name			= "WAIT",
+		.desc			= "MIPS wait",
+	},
+	.states[1]		= {
+		.enter			= jz4740_enter_power_down,
+		.exit_latency		= 10,
+		.target_residency	= 1000,
+		.flags			= CPUIDLE_FLAG_TIME_VALID,
+		.name			= "SDRAM_PD",
+		.desc			= "MIPS wait and SDRAM power-down",
+	},
+	.state_count = JZ4740_MAX_STATES,
+};
+
+/* Initialize CPU idle by registering the idle states */
+static int jz4740_cpuidle_probe(struct platform_device *pdev)
+{
+	struct resource *res;
+
+	if (!cpu_wait)
+		return -ENODEV;
+
+	/* The register is part of the EMC, which is claimed by the NAND
+	 * driver, so only map it. */
+	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+	if (!res)
+		return -ENXIO;
+
+	jz4740_sdram_ctrl = devm_ioremap(&pdev->dev, res->start,
+					 resource_size(res));
+	if (!jz4740_sdram_ctrl)
+		return -ENOMEM;
+
+	return cpuidle_register(&jz4740_idle_driver, NULL);
+}
+
+static struct platform_driver jz4740_cpuidle_driver = {
+	.driver = {
+		.name = "cpuidle-jz4740",
+		.owner = THIS_MODULE,
+	},
+	.probe = jz4740_cpuidle_probe,
+};
+
+module_platform_driver(jz4740_cpuidle_driver);
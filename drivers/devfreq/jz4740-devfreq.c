@@ -0,0 +1,496 @@
+/*
+ *  JZ4740 memory bus frequency scaling
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under  the terms of the GNU General  Public License as published by the
+ *  Free Software Foundation;  either version 2 of the License, or (at your
+ *  option) any later version.
+ *
+ */
+
+/*
+ * Scales the AHB clock together with the SDRAM clock. Both are kept at the
+ * ratio set up by the boot loader and only ever divided down from their
+ * boot rates by a common factor, which keeps the CPU clock an integer
+ * multiple of the AHB clock for every rate the cpufreq driver offers.
+ * The APB clock, which the peripherals are timed from, is left alone, so
+ * the AHB clock is never taken below it.
+ *
+ * There are no bus performance counters, so the load is estimated from the
+ * traffic the bus masters report (see <asm/mach-jz4740/bus.h>) and from the
+ * time the CPU was busy, as a stand-in for its cache refills.
+ *
+ * The bus also acts as a cooling device for the board thermal zone, each
+ * cooling state takes away the highest remaining rate.
+ */
+
+#include <linux/atomic.h>
+#include <linux/clk.h>
+#include <linux/devfreq.h>
+#include <linux/err.h>
+#include <linux/io.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/platform_device.h>
+#include <linux/slab.h>
+#include <linux/thermal.h>
+#include <linux/tick.h>
+
+#include <asm/mach-jz4740/bus.h>
+
+#define JZ_REG_SDRAM_CTRL		0x00
+#define JZ_REG_SDRAM_REFRESH_CONST	0x0c
+
+#define JZ_SDRAM_CTRL_BUS_WIDTH_16	BIT(31)
+
+#define JZ4740_DEVFREQ_POLL_MS		50
+
+/* Fraction of the peak SDRAM bandwidth which is usable in practice, in % */
+#define JZ4740_DEVFREQ_EFFICIENCY	50
+
+/* Share of the usable bandwidth a CPU which is busy all the time needs */
+#define JZ4740_DEVFREQ_CPU_WEIGHT	50
+
+/* Possible values of the AHB and memory clock dividers */
+static const unsigned int jz4740_devfreq_divs[] = {
+	1, 2, 3, 4, 6, 8, 12, 16, 24, 32
+};
+
+static atomic_long_t jz4740_bus_traffic = ATOMIC_LONG_INIT(0);
+static atomic_long_t jz4740_bus_bandwidth = ATOMIC_LONG_INIT(0);
+
+/**
+ * jz4740_bus_add_traffic() - Account a transfer to or from memory
+ * @bytes: Number of bytes which have been transferred
+ *
+ * May be called from any context.
+ */
+void jz4740_bus_add_traffic(unsigned long bytes)
+{
+	atomic_long_add(bytes, &jz4740_bus_traffic);
+}
+EXPORT_SYMBOL_GPL(jz4740_bus_add_traffic);
+
+/**
+ * jz4740_bus_add_bandwidth() - Change the bandwidth of steady bus traffic
+ * @bytes_per_sec: Bandwidth to add, or to remove if negative
+ *
+ * May be called from any context.
+ */
+void jz4740_bus_add_bandwidth(long bytes_per_sec)
+{
+	atomic_long_add(bytes_per_sec, &jz4740_bus_bandwidth);
+}
+EXPORT_SYMBOL_GPL(jz4740_bus_add_bandwidth);
+
+struct jz4740_devfreq {
+	struct devfreq *devfreq;
+	void __iomem *sdram_base;
+
+	struct clk *cclk;
+	struct clk *hclk;
+	struct clk *mclk;
+
+	unsigned long hclk_max;
+	unsigned long mclk_max;
+	uint16_t refresh_const_max;
+	unsigned int bus_width;
+
+	unsigned int freq_table[ARRAY_SIZE(jz4740_devfreq_divs)];
+	unsigned int num_freqs;
+	unsigned int cur;
+
+	struct thermal_cooling_device *cooling;
+	unsigned int cooling_state;
+
+	ktime_t last_sample;
+	u64 last_cpu_idle;
+	u64 last_cpu_wall;
+};
+
+static struct devfreq_simple_ondemand_data jz4740_devfreq_ondemand_data = {
+	.upthreshold = 70,
+	.downdifferential = 20,
+};
+
+/*
+ * Moves both clocks one step in the frequency table. The refresh interval
+ * must never get longer than the SDRAM allows, so the refresh constant is
+ * lowered before the memory clock slows down and raised only after it has
+ * sped up again. The rest of the SDRAM timings are given in cycles and were
+ * set up for the maximum rate, they stay valid at lower rates.
+ */
+static void jz4740_devfreq_set_index(struct jz4740_devfreq *jzdf,
+	unsigned int index)
+{
+	unsigned long div = jzdf->hclk_max / jzdf->freq_table[index];
+	unsigned long mclk_rate = jzdf->mclk_max / div;
+	uint16_t refresh_const = max_t(uint16_t,
+		jzdf->refresh_const_max / div, 1);
+
+	if (index < jzdf->cur) {
+		writew(refresh_const,
+			jzdf->sdram_base + JZ_REG_SDRAM_REFRESH_CONST);
+		clk_set_rate(jzdf->mclk, mclk_rate);
+		clk_set_rate(jzdf->hclk, jzdf->freq_table[index]);
+	} else {
+		clk_set_rate(jzdf->hclk, jzdf->freq_table[index]);
+		clk_set_rate(jzdf->mclk, mclk_rate);
+		writew(refresh_const,
+			jzdf->sdram_base + JZ_REG_SDRAM_REFRESH_CONST);
+	}
+
+	jzdf->cur = index;
+}
+
+static int jz4740_devfreq_target(struct device *dev, unsigned long *freq,
+	u32 flags)
+{
+	struct jz4740_devfreq *jzdf = dev_get_drvdata(dev);
+	unsigned long cclk_rate = clk_get_rate(jzdf->cclk);
+	unsigned int index;
+
+	/* The table is sorted by increasing frequency */
+	if (flags & DEVFREQ_FLAG_LEAST_UPPER_BOUND) {
+		for (index = jzdf->num_freqs - 1; index > 0; --index) {
+			if (jzdf->freq_table[index] <= *freq)
+				break;
+		}
+	} else {
+		for (index = 0; index < jzdf->num_freqs - 1; ++index) {
+			if (jzdf->freq_table[index] >= *freq)
+				break;
+		}
+	}
+
+	/* The thermal limit takes precedence over the governor */
+	index = min(index, jzdf->num_freqs - 1 - jzdf->cooling_state);
+
+	/* The CPU clock must stay a multiple of the AHB clock */
+	while (index > 0 && cclk_rate % jzdf->freq_table[index])
+		--index;
+
+	/* Step through the table, to keep the clock ratios close to valid */
+	while (jzdf->cur > index)
+		jz4740_devfreq_set_index(jzdf, jzdf->cur - 1);
+	while (jzdf->cur < index)
+		jz4740_devfreq_set_index(jzdf, jzdf->cur + 1);
+
+	*freq = jzdf->freq_table[index];
+
+	return 0;
+}
+
+static int jz4740_devfreq_get_dev_status(struct device *dev,
+	struct devfreq_dev_status *stat)
+{
+	struct jz4740_devfreq *jzdf = dev_get_drvdata(dev);
+	u64 traffic, capacity, cpu_idle, cpu_wall, cpu_busy;
+	unsigned long mclk_rate;
+	ktime_t now;
+	s64 elapsed;
+
+	now = ktime_get();
+	elapsed = ktime_us_delta(now, jzdf->last_sample);
+	jzdf->last_sample = now;
+	if (elapsed <= 0)
+		return -EAGAIN;
+
+	traffic = atomic_long_xchg(&jz4740_bus_traffic, 0);
+	traffic += div_u64((u64)atomic_long_read(&jz4740_bus_bandwidth) *
+			elapsed, USEC_PER_SEC);
+
+	/* Needs NO_HZ for the idle time accounting, ignored without it */
+	cpu_idle = get_cpu_idle_time_us(0, &cpu_wall);
+	if (cpu_idle != -1ULL) {
+		cpu_busy = (cpu_wall - jzdf->last_cpu_wall) -
+			(cpu_idle - jzdf->last_cpu_idle);
+		jzdf->last_cpu_idle = cpu_idle;
+		jzdf->last_cpu_wall = cpu_wall;
+
+		/* Scaled from the usable bandwidth at the maximum rate */
+		traffic += div_u64(cpu_busy * jzdf->mclk_max * jzdf->bus_width *
+				JZ4740_DEVFREQ_EFFICIENCY / 100 *
+				JZ4740_DEVFREQ_CPU_WEIGHT / 100, USEC_PER_SEC);
+	}
+
+	/* Time the bus needed for the traffic, at the current rate */
+	mclk_rate = clk_get_rate(jzdf->mclk);
+	capacity = (u64)mclk_rate * jzdf->bus_width *
+		JZ4740_DEVFREQ_EFFICIENCY / 100;
+
+	stat->current_frequency = clk_get_rate(jzdf->hclk);
+	stat->total_time = elapsed;
+	stat->busy_time = min_t(u64, div64_u64(traffic * USEC_PER_SEC,
+			capacity), elapsed);
+
+	return 0;
+}
+
+static int jz4740_devfreq_get_cur_freq(struct device *dev,
+	unsigned long *freq)
+{
+	struct jz4740_devfreq *jzdf = dev_get_drvdata(dev);
+
+	*freq = clk_get_rate(jzdf->hclk);
+
+	return 0;
+}
+
+static struct devfreq_dev_profile jz4740_devfreq_profile = {
+	.polling_ms = JZ4740_DEVFREQ_POLL_MS,
+	.target = jz4740_devfreq_target,
+	.get_dev_status = jz4740_devfreq_get_dev_status,
+	.get_cur_freq = jz4740_devfreq_get_cur_freq,
+};
+
+#if IS_ENABLED(CONFIG_THERMAL)
+static int jz4740_devfreq_get_max_state(struct thermal_cooling_device *cdev,
+	unsigned long *state)
+{
+	struct jz4740_devfreq *jzdf = cdev->devdata;
+
+	*state = jzdf->num_freqs - 1;
+
+	return 0;
+}
+
+static int jz4740_devfreq_get_cur_state(struct thermal_cooling_device *cdev,
+	unsigned long *state)
+{
+	struct jz4740_devfreq *jzdf = cdev->devdata;
+
+	*state = jzdf->cooling_state;
+
+	return 0;
+}
+
+static int jz4740_devfreq_set_cur_state(struct thermal_cooling_device *cdev,
+	unsigned long state)
+{
+	struct jz4740_devfreq *jzdf = cdev->devdata;
+	struct devfreq *devfreq = jzdf->devfreq;
+	int ret;
+
+	if (state >= jzdf->num_freqs)
+		return -EINVAL;
+
+	mutex_lock(&devfreq->lock);
+	jzdf->cooling_state = state;
+	ret = update_devfreq(devfreq);
+	mutex_unlock(&devfreq->lock);
+
+	return ret;
+}
+
+static const struct thermal_cooling_device_ops jz4740_devfreq_cooling_ops = {
+	.get_max_state = jz4740_devfreq_get_max_state,
+	.get_cur_state = jz4740_devfreq_get_cur_state,
+	.set_cur_state = jz4740_devfreq_set_cur_state,
+};
+
+static void jz4740_devfreq_register_cooling(struct platform_device *pdev,
+	struct jz4740_devfreq *jzdf)
+{
+	jzdf->cooling = thermal_cooling_device_register("jz4740-devfreq", jzdf,
+			&jz4740_devfreq_cooling_ops);
+	if (IS_ERR(jzdf->cooling)) {
+		dev_warn(&pdev->dev, "Failed to register cooling device: %ld\n",
+			PTR_ERR(jzdf->cooling));
+		jzdf->cooling = NULL;
+	}
+}
+
+static void jz4740_devfreq_unregister_cooling(struct jz4740_devfreq *jzdf)
+{
+	if (jzdf->cooling)
+		thermal_cooling_device_unregister(jzdf->cooling);
+}
+#else
+static inline void jz4740_devfreq_register_cooling(
+	struct platform_device *pdev, struct jz4740_devfreq *jzdf) {}
+static inline void jz4740_devfreq_unregister_cooling(
+	struct jz4740_devfreq *jzdf) {}
+#endif
+
+/*
+ * Only rates which divide the boot rates of both the AHB and the memory
+ * clock by the same factor, and which are not below the APB clock, are
+ * used.
+ */
+static void jz4740_devfreq_build_table(struct jz4740_devfreq *jzdf,
+	unsigned long pll_rate, unsigned long pclk_rate)
+{
+	unsigned long rate, factor;
+	size_t i;
+
+	for (i = ARRAY_SIZE(jz4740_devfreq_divs); i > 0; --i) {
+		rate = pll_rate / jz4740_devfreq_divs[i - 1];
+		if (rate > jzdf->hclk_max || rate < pclk_rate ||
+		    jzdf->hclk_max % rate)
+			continue;
+
+		factor = jzdf->hclk_max / rate;
+		if (jzdf->mclk_max % factor ||
+		    clk_round_rate(jzdf->mclk, jzdf->mclk_max / factor) !=
+		    jzdf->mclk_max / factor)
+			continue;
+
+		jzdf->freq_table[jzdf->num_freqs++] = rate;
+	}
+
+	jzdf->cur = jzdf->num_freqs - 1;
+}
+
+static void jz4740_devfreq_put_clks(struct jz4740_devfreq *jzdf)
+{
+	if (!IS_ERR(jzdf->mclk))
+		clk_put(jzdf->mclk);
+	if (!IS_ERR(jzdf->hclk))
+		clk_put(jzdf->hclk);
+	if (!IS_ERR(jzdf->cclk))
+		clk_put(jzdf->cclk);
+}
+
+static int jz4740_devfreq_probe(struct platform_device *pdev)
+{
+	struct jz4740_devfreq *jzdf;
+	struct resource *res;
+	struct clk *pll, *pclk;
+	int ret;
+
+	jzdf = devm_kzalloc(&pdev->dev, sizeof(*jzdf), GFP_KERNEL);
+	if (!jzdf)
+		return -ENOMEM;
+
+	/* The registers are part of the EMC, which is claimed by the NAND
+	 * driver, so only map them. */
+	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+	if (!res)
+		return -ENXIO;
+
+	jzdf->sdram_base = devm_ioremap(&pdev->dev, res->start,
+					resource_size(res));
+	if (!jzdf->sdram_base)
+		return -ENOMEM;
+
+	pll = clk_get(NULL, "pll");
+	if (IS_ERR(pll))
+		return PTR_ERR(pll);
+
+	jzdf->cclk = clk_get(NULL, "cclk");
+	jzdf->hclk = clk_get(NULL, "hclk");
+	jzdf->mclk = clk_get(NULL, "mclk");
+	if (IS_ERR(jzdf->cclk) || IS_ERR(jzdf->hclk) || IS_ERR(jzdf->mclk)) {
+		ret = -ENODEV;
+		goto err_put_clks;
+	}
+
+	jzdf->hclk_max = clk_get_rate(jzdf->hclk);
+	jzdf->mclk_max = clk_get_rate(jzdf->mclk);
+	jzdf->refresh_const_max = readw(jzdf->sdram_base +
+					JZ_REG_SDRAM_REFRESH_CONST);
+
+	if (readl(jzdf->sdram_base + JZ_REG_SDRAM_CTRL) &
+	    JZ_SDRAM_CTRL_BUS_WIDTH_16)
+		jzdf->bus_width = 2;
+	else
+		jzdf->bus_width = 4;
+
+	pclk = clk_get(NULL, "pclk");
+	if (IS_ERR(pclk)) {
+		ret = PTR_ERR(pclk);
+		goto err_put_clks;
+	}
+
+	jz4740_devfreq_build_table(jzdf, clk_get_rate(pll), clk_get_rate(pclk));
+	clk_put(pclk);
+	clk_put(pll);
+	pll = NULL;
+
+	if (jzdf->num_freqs < 2) {
+		dev_info(&pdev->dev, "No lower bus rates available\n");
+		ret = -ENODEV;
+		goto err_put_clks;
+	}
+
+	jzdf->last_sample = ktime_get();
+	jzdf->last_cpu_idle = get_cpu_idle_time_us(0, &jzdf->last_cpu_wall);
+
+	platform_set_drvdata(pdev, jzdf);
+
+	jz4740_devfreq_profile.initial_freq = jzdf->hclk_max;
+	jz4740_devfreq_profile.freq_table = jzdf->freq_table;
+	jz4740_devfreq_profile.max_state = jzdf->num_freqs;
+
+	jzdf->devfreq = devfreq_add_device(&pdev->dev, &jz4740_devfreq_profile,
+			"simple_ondemand", &jz4740_devfreq_ondemand_data);
+	if (IS_ERR(jzdf->devfreq)) {
+		ret = PTR_ERR(jzdf->devfreq);
+		goto err_put_clks;
+	}
+
+	jz4740_devfreq_register_cooling(pdev, jzdf);
+
+	return 0;
+
+err_put_clks:
+	if (pll)
+		clk_put(pll);
+	jz4740_devfreq_put_clks(jzdf);
+	return ret;
+}
+
+static int jz4740_devfreq_remove(struct platform_device *pdev)
+{
+	struct jz4740_devfreq *jzdf = platform_get_drvdata(pdev);
+	unsigned long freq = jzdf->hclk_max;
+
+	jz4740_devfreq_unregister_cooling(jzdf);
+	devfreq_remove_device(jzdf->devfreq);
+
+	/* Leave the bus running at full speed */
+	jzdf->cooling_state = 0;
+	jz4740_devfreq_target(&pdev->dev, &freq, 0);
+
+	jz4740_devfreq_put_clks(jzdf);
+
+	return 0;
+}
+
+#ifdef CONFIG_PM_SLEEP
+static int jz4740_devfreq_suspend(struct device *dev)
+{
+	struct jz4740_devfreq *jzdf = dev_get_drvdata(dev);
+
+	return devfreq_suspend_device(jzdf->devfreq);
+}
+
+static int jz4740_devfreq_resume(struct device *dev)
+{
+	struct jz4740_devfreq *jzdf = dev_get_drvdata(dev);
+
+	jzdf->last_sample = ktime_get();
+	atomic_long_set(&jz4740_bus_traffic, 0);
+
+	return devfreq_resume_device(jzdf->devfreq);
+}
+#endif
+
+static SIMPLE_DEV_PM_OPS(jz4740_devfreq_pm_ops, jz4740_devfreq_suspend,
+	jz4740_devfreq_resume);
+
+static struct platform_driver jz4740_devfreq_driver = {
+	.probe = jz4740_devfreq_probe,
+	.remove = jz4740_devfreq_remove,
+	.driver = {
+		.name = "jz4740-devfreq",
+		.owner = THIS_MODULE,
+		.pm = &jz4740_devfreq_pm_ops,
+	},
+};
+module_platform_driver(jz4740_devfreq_driver);
+
+MODULE_DESCRIPTION("JZ4740 memory bus frequency scaling driver");
+MODULE_LICENSE("GPL");
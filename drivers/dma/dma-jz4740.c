@@ -13,24 +13,37 @@
  *
  */
 
+#include <linux/debugfs.h>
 #include <linux/dmaengine.h>
 #include <linux/dma-mapping.h>
+#include <linux/dmapool.h>
 #include <linux/err.h>
+#include <linux/hrtimer.h>
 #include <linux/init.h>
 #include <linux/list.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
+#include <linux/pm_runtime.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/irq.h>
 #include <linux/clk.h>
+#include <linux/ktime.h>
 
+#include <asm/mach-jz4740/bus.h>
 #include <asm/mach-jz4740/dma.h>
 
 #include "virt-dma.h"
 
 #define JZ_DMA_NR_CHANS 6
 
+/* How long an idle controller keeps its clock, in ms */
+#define JZ_DMA_AUTOSUSPEND_DELAY 100
+
+/* Latency histogram buckets, bucket n counts latencies below 2^n us */
+#define JZ_DMA_LATENCY_BUCKETS 16
+
 #define JZ_REG_DMA_SRC_ADDR(x)		(0x00 + (x) * 0x20)
 #define JZ_REG_DMA_DST_ADDR(x)		(0x04 + (x) * 0x20)
 #define JZ_REG_DMA_TRANSFER_COUNT(x)	(0x08 + (x) * 0x20)
@@ -45,6 +58,7 @@
 #define JZ_REG_DMA_DOORBELL_SET		0x30C
 
 #define JZ_DMA_STATUS_CTRL_NO_DESC		BIT(31)
+#define JZ_DMA_STATUS_CTRL_CDOA_MASK		(0xff << 16)
 #define JZ_DMA_STATUS_CTRL_DESC_INV		BIT(6)
 #define JZ_DMA_STATUS_CTRL_ADDR_ERR		BIT(4)
 #define JZ_DMA_STATUS_CTRL_TRANSFER_DONE	BIT(3)
@@ -72,6 +86,16 @@
 #define JZ_DMA_CMD_TRANSFER_SIZE_OFFSET 8
 #define JZ_DMA_CMD_MODE_OFFSET 7
 
+#define JZ_DMA_STATUS_CTRL_CDOA_OFFSET 16
+
+#define JZ_DMA_HWDESC_COUNT_MASK		0xffffff
+#define JZ_DMA_HWDESC_OFFSET_OFFSET		24
+
+/* The controller fetches linked descriptors relative to the 4k page the
+ * current descriptor lives in, so a descriptor chain must not cross a page
+ * boundary. */
+#define JZ_DMA_MAX_HWDESCS 128
+
 #define JZ_DMA_CTRL_PRIORITY_MASK		(0x3 << 8)
 #define JZ_DMA_CTRL_HALT			BIT(3)
 #define JZ_DMA_CTRL_ADDRESS_ERROR		BIT(2)
@@ -106,11 +130,27 @@ struct jz4740_dma_sg {
 	unsigned int len;
 };
 
+/* Hardware descriptor layout, as fetched by the controller in descriptor
+ * mode. */
+struct jz4740_dma_hwdesc {
+	uint32_t cmd;
+	uint32_t src_addr;
+	uint32_t dst_addr;
+	uint32_t count;
+};
+
+#define JZ_DMA_HWDESC_BLOCK_SIZE \
+	(JZ_DMA_MAX_HWDESCS * sizeof(struct jz4740_dma_hwdesc))
+
 struct jz4740_dma_desc {
 	struct virt_dma_desc vdesc;
 
 	enum dma_transfer_direction direction;
 	bool cyclic;
+	ktime_t submitted;
+
+	struct jz4740_dma_hwdesc *hwdesc;
+	dma_addr_t hwdesc_phys;
 
 	unsigned int num_sgs;
 	struct jz4740_dma_sg sg[];
@@ -122,15 +162,34 @@ struct jz4740_dmaengine_chan {
 
 	dma_addr_t fifo_addr;
 	unsigned int transfer_shift;
+	uint32_t cmd;
 
 	struct jz4740_dma_desc *desc;
 	unsigned int next_sg;
+
+	/* Holds a runtime PM reference, protected by the vchan lock */
+	bool active;
+	/* Start of the not yet accounted busy time while active */
+	ktime_t busy_since;
+
+	/* Completed descriptors held back by completion coalescing, all
+	 * protected by the vchan lock */
+	unsigned int coalesce_count;
+	ktime_t coalesce_timeout;
+	struct list_head coalesced;
+	unsigned int num_coalesced;
+	struct hrtimer coalesce_timer;
+
+	unsigned long latency_hist[JZ_DMA_LATENCY_BUCKETS];
 };
 
 struct jz4740_dma_dev {
 	struct dma_device ddev;
 	void __iomem *base;
 	struct clk *clk;
+	struct dma_pool *desc_pool;
+	struct device_dma_parameters dma_parms;
+	struct dentry *debugfs;
 
 	struct jz4740_dmaengine_chan chan[JZ_DMA_NR_CHANS];
 };
@@ -142,6 +201,43 @@ static struct jz4740_dma_dev *jz4740_dma_chan_get_dev(
 		ddev);
 }
 
+/*
+ * Account data moved by the channel, along with the time it has been busy
+ * since the last call. Called with the vchan lock held.
+ */
+static void jz4740_dma_chan_account(struct jz4740_dmaengine_chan *chan,
+	size_t bytes)
+{
+	ktime_t now = ktime_get();
+
+	dma_chan_account(&chan->vchan.chan, bytes,
+		ktime_to_ns(ktime_sub(now, chan->busy_since)));
+	chan->busy_since = now;
+
+	jz4740_bus_add_traffic(bytes);
+}
+
+/* Called with the vchan lock held, the device is marked irq safe */
+static void jz4740_dma_chan_set_active(struct jz4740_dmaengine_chan *chan,
+	bool active)
+{
+	struct device *dev = jz4740_dma_chan_get_dev(chan)->ddev.dev;
+
+	if (chan->active == active)
+		return;
+
+	chan->active = active;
+
+	if (active) {
+		pm_runtime_get_sync(dev);
+		chan->busy_since = ktime_get();
+	} else {
+		jz4740_dma_chan_account(chan, 0);
+		pm_runtime_mark_last_busy(dev);
+		pm_runtime_put_autosuspend(dev);
+	}
+}
+
 static struct jz4740_dmaengine_chan *to_jz4740_dma_chan(struct dma_chan *c)
 {
 	return container_of(c, struct jz4740_dmaengine_chan, vchan.chan);
@@ -152,6 +248,71 @@ static struct jz4740_dma_desc *to_jz4740_dma_desc(struct virt_dma_desc *vdesc)
 	return container_of(vdesc, struct jz4740_dma_desc, vdesc);
 }
 
+/* Reports a completed descriptor to the client, called with the vchan lock
+ * held */
+static void jz4740_dma_chan_complete(struct jz4740_dmaengine_chan *chan,
+	struct jz4740_dma_desc *desc)
+{
+	s64 latency = ktime_us_delta(ktime_get(), desc->submitted);
+	unsigned int bucket;
+
+	bucket = latency > 0 ? fls64(latency) : 0;
+	chan->latency_hist[min_t(unsigned int, bucket,
+		JZ_DMA_LATENCY_BUCKETS - 1)]++;
+
+	vchan_cookie_complete(&desc->vdesc);
+}
+
+/* Reports all descriptors held back by completion coalescing */
+static void jz4740_dma_chan_flush(struct jz4740_dmaengine_chan *chan)
+{
+	struct jz4740_dma_desc *desc, *tmp;
+
+	list_for_each_entry_safe(desc, tmp, &chan->coalesced, vdesc.node) {
+		list_del(&desc->vdesc.node);
+		jz4740_dma_chan_complete(chan, desc);
+	}
+	chan->num_coalesced = 0;
+}
+
+/*
+ * The controller can only link descriptors within a single page, so it still
+ * interrupts to have the next descriptor started. Coalescing instead batches
+ * the completion tasklet and client callbacks of clients which asked for it.
+ */
+static void jz4740_dma_chan_done(struct jz4740_dmaengine_chan *chan,
+	struct jz4740_dma_desc *desc)
+{
+	if (chan->coalesce_count <= 1) {
+		jz4740_dma_chan_complete(chan, desc);
+		return;
+	}
+
+	list_add_tail(&desc->vdesc.node, &chan->coalesced);
+
+	if (++chan->num_coalesced >= chan->coalesce_count) {
+		/* A timer already waiting for the lock finds nothing to do */
+		hrtimer_try_to_cancel(&chan->coalesce_timer);
+		jz4740_dma_chan_flush(chan);
+	} else if (chan->num_coalesced == 1) {
+		hrtimer_start(&chan->coalesce_timer, chan->coalesce_timeout,
+			HRTIMER_MODE_REL);
+	}
+}
+
+static enum hrtimer_restart jz4740_dma_coalesce_timeout(struct hrtimer *timer)
+{
+	struct jz4740_dmaengine_chan *chan = container_of(timer,
+		struct jz4740_dmaengine_chan, coalesce_timer);
+	unsigned long flags;
+
+	spin_lock_irqsave(&chan->vchan.lock, flags);
+	jz4740_dma_chan_flush(chan);
+	spin_unlock_irqrestore(&chan->vchan.lock, flags);
+
+	return HRTIMER_NORESTART;
+}
+
 static inline uint32_t jz4740_dma_read(struct jz4740_dma_dev *dmadev,
 	unsigned int reg)
 {
@@ -261,12 +422,17 @@ static int jz4740_dma_slave_config(struct dma_chan *c,
 	cmd |= dst_width << JZ_DMA_CMD_DST_WIDTH_OFFSET;
 	cmd |= transfer_size << JZ_DMA_CMD_TRANSFER_SIZE_OFFSET;
 	cmd |= JZ4740_DMA_MODE_SINGLE << JZ_DMA_CMD_MODE_OFFSET;
+
+	chan->cmd = cmd;
 	cmd |= JZ_DMA_CMD_TRANSFER_IRQ_ENABLE;
 
+	pm_runtime_get_sync(dmadev->ddev.dev);
 	jz4740_dma_write(dmadev, JZ_REG_DMA_CMD(chan->id), cmd);
 	jz4740_dma_write(dmadev, JZ_REG_DMA_STATUS_CTRL(chan->id), 0);
 	jz4740_dma_write(dmadev, JZ_REG_DMA_REQ_TYPE(chan->id),
 		config->slave_id);
+	pm_runtime_mark_last_busy(dmadev->ddev.dev);
+	pm_runtime_put_autosuspend(dmadev->ddev.dev);
 
 	return 0;
 }
@@ -279,9 +445,15 @@ static int jz4740_dma_terminate_all(struct dma_chan *c)
 	LIST_HEAD(head);
 
 	spin_lock_irqsave(&chan->vchan.lock, flags);
-	jz4740_dma_write_mask(dmadev, JZ_REG_DMA_STATUS_CTRL(chan->id), 0,
-			JZ_DMA_STATUS_CTRL_ENABLE);
+	if (chan->active)
+		jz4740_dma_write_mask(dmadev, JZ_REG_DMA_STATUS_CTRL(chan->id),
+				0, JZ_DMA_STATUS_CTRL_ENABLE);
+	jz4740_dma_chan_set_active(chan, false);
 	chan->desc = NULL;
+	/* Descriptors held back have completed, only their callbacks are
+	 * dropped along with the rest */
+	hrtimer_try_to_cancel(&chan->coalesce_timer);
+	jz4740_dma_chan_flush(chan);
 	vchan_get_all_descriptors(&chan->vchan, &head);
 	spin_unlock_irqrestore(&chan->vchan.lock, flags);
 
@@ -290,6 +462,26 @@ static int jz4740_dma_terminate_all(struct dma_chan *c)
 	return 0;
 }
 
+static int jz4740_dma_set_coalesce(struct dma_chan *c,
+	const struct jz4740_dma_coalesce *config)
+{
+	struct jz4740_dmaengine_chan *chan = to_jz4740_dma_chan(c);
+	unsigned long flags;
+
+	if (config->count > 1 && !config->timeout_us)
+		return -EINVAL;
+
+	spin_lock_irqsave(&chan->vchan.lock, flags);
+	hrtimer_try_to_cancel(&chan->coalesce_timer);
+	jz4740_dma_chan_flush(chan);
+	chan->coalesce_count = config->count;
+	chan->coalesce_timeout = ns_to_ktime((u64)config->timeout_us *
+		NSEC_PER_USEC);
+	spin_unlock_irqrestore(&chan->vchan.lock, flags);
+
+	return 0;
+}
+
 static int jz4740_dma_control(struct dma_chan *chan, enum dma_ctrl_cmd cmd,
 	unsigned long arg)
 {
@@ -300,6 +492,9 @@ static int jz4740_dma_control(struct dma_chan *chan, enum dma_ctrl_cmd cmd,
 		return jz4740_dma_slave_config(chan, config);
 	case DMA_TERMINATE_ALL:
 		return jz4740_dma_terminate_all(chan);
+	case JZ4740_DMA_COALESCE:
+		return jz4740_dma_set_coalesce(chan,
+			(const struct jz4740_dma_coalesce *)arg);
 	default:
 		return -ENOSYS;
 	}
@@ -312,17 +507,45 @@ static int jz4740_dma_start_transfer(struct jz4740_dmaengine_chan *chan)
 	struct virt_dma_desc *vdesc;
 	struct jz4740_dma_sg *sg;
 
-	jz4740_dma_write_mask(dmadev, JZ_REG_DMA_STATUS_CTRL(chan->id), 0,
-			JZ_DMA_STATUS_CTRL_ENABLE);
-
+	/* An idle channel lets the controller clock be gated */
 	if (!chan->desc) {
 		vdesc = vchan_next_desc(&chan->vchan);
-		if (!vdesc)
+		if (!vdesc) {
+			jz4740_dma_chan_set_active(chan, false);
 			return 0;
+		}
 		chan->desc = to_jz4740_dma_desc(vdesc);
 		chan->next_sg = 0;
 	}
 
+	jz4740_dma_chan_set_active(chan, true);
+
+	jz4740_dma_write_mask(dmadev, JZ_REG_DMA_STATUS_CTRL(chan->id), 0,
+			JZ_DMA_STATUS_CTRL_ENABLE);
+
+	if (chan->desc->hwdesc) {
+		/* The whole list runs from the descriptor chain */
+		jz4740_dma_write(dmadev, JZ_REG_DMA_DESC_ADDR(chan->id),
+				chan->desc->hwdesc_phys);
+
+		jz4740_dma_write_mask(dmadev, JZ_REG_DMA_STATUS_CTRL(chan->id),
+				JZ_DMA_STATUS_CTRL_ENABLE,
+				JZ_DMA_STATUS_CTRL_HALT |
+				JZ_DMA_STATUS_CTRL_NO_DESC |
+				JZ_DMA_STATUS_CTRL_ENABLE);
+
+		jz4740_dma_write_mask(dmadev, JZ_REG_DMA_CTRL,
+				JZ_DMA_CTRL_ENABLE,
+				JZ_DMA_CTRL_HALT | JZ_DMA_CTRL_ENABLE);
+
+		jz4740_dma_write(dmadev, JZ_REG_DMA_DOORBELL_SET,
+				BIT(chan->id));
+
+		chan->next_sg = chan->desc->num_sgs;
+
+		return 0;
+	}
+
 	if (chan->next_sg == chan->desc->num_sgs)
 		chan->next_sg = 0;
 
@@ -354,16 +577,52 @@ static int jz4740_dma_start_transfer(struct jz4740_dmaengine_chan *chan)
 	return 0;
 }
 
+static size_t jz4740_dma_desc_size(struct jz4740_dma_desc *desc)
+{
+	size_t size = 0;
+	unsigned int i;
+
+	for (i = 0; i < desc->num_sgs; i++)
+		size += desc->sg[i].len;
+
+	return size;
+}
+
 static void jz4740_dma_chan_irq(struct jz4740_dmaengine_chan *chan)
 {
+	struct jz4740_dma_dev *dmadev = jz4740_dma_chan_get_dev(chan);
+	struct jz4740_dma_desc *desc;
+
 	spin_lock(&chan->vchan.lock);
-	if (chan->desc) {
-		if (chan->desc && chan->desc->cyclic) {
-			vchan_cyclic_callback(&chan->desc->vdesc);
+	desc = chan->desc;
+
+	/* A cyclic descriptor chain keeps running, only acknowledge the
+	 * period interrupt. */
+	if (desc && desc->cyclic && desc->hwdesc) {
+		jz4740_dma_write_mask(dmadev, JZ_REG_DMA_STATUS_CTRL(chan->id),
+			0, JZ_DMA_STATUS_CTRL_COUNT_TERMINATE |
+			JZ_DMA_STATUS_CTRL_TRANSFER_DONE);
+		jz4740_dma_chan_account(chan, desc->sg[0].len);
+		vchan_cyclic_callback(&desc->vdesc);
+		spin_unlock(&chan->vchan.lock);
+		return;
+	}
+
+	jz4740_dma_write_mask(dmadev, JZ_REG_DMA_STATUS_CTRL(chan->id), 0,
+		JZ_DMA_STATUS_CTRL_ENABLE | JZ_DMA_STATUS_CTRL_COUNT_TERMINATE |
+		JZ_DMA_STATUS_CTRL_TRANSFER_DONE);
+
+	if (desc) {
+		if (desc->cyclic) {
+			jz4740_dma_chan_account(chan, desc->sg[0].len);
+			vchan_cyclic_callback(&desc->vdesc);
 		} else {
-			if (chan->next_sg == chan->desc->num_sgs) {
+			if (chan->next_sg == desc->num_sgs) {
 				chan->desc = NULL;
-				vchan_cookie_complete(&chan->desc->vdesc);
+				list_del(&desc->vdesc.node);
+				jz4740_dma_chan_account(chan,
+					jz4740_dma_desc_size(desc));
+				jz4740_dma_chan_done(chan, desc);
 			}
 		}
 	}
@@ -379,15 +638,9 @@ static irqreturn_t jz4740_dma_irq(int irq, void *devid)
 
 	irq_status = readl(dmadev->base + JZ_REG_DMA_IRQ);
 
-	for (i = 0; i < 6; ++i) {
-		if (irq_status & (1 << i)) {
-			jz4740_dma_write_mask(dmadev,
-				JZ_REG_DMA_STATUS_CTRL(i), 0,
-				JZ_DMA_STATUS_CTRL_ENABLE |
-				JZ_DMA_STATUS_CTRL_TRANSFER_DONE);
-
+	for (i = 0; i < JZ_DMA_NR_CHANS; ++i) {
+		if (irq_status & (1 << i))
 			jz4740_dma_chan_irq(&dmadev->chan[i]);
-		}
 	}
 
 	return IRQ_HANDLED;
@@ -404,6 +657,83 @@ static void jz4740_dma_issue_pending(struct dma_chan *c)
 	spin_unlock_irqrestore(&chan->vchan.lock, flags);
 }
 
+static dma_cookie_t jz4740_dma_tx_submit(struct dma_async_tx_descriptor *tx)
+{
+	struct jz4740_dma_desc *desc = to_jz4740_dma_desc(
+		container_of(tx, struct virt_dma_desc, tx));
+
+	desc->submitted = ktime_get();
+
+	return vchan_tx_submit(tx);
+}
+
+static struct dma_async_tx_descriptor *jz4740_dma_tx_prep(
+	struct jz4740_dmaengine_chan *chan, struct jz4740_dma_desc *desc,
+	unsigned long flags)
+{
+	struct dma_async_tx_descriptor *tx;
+
+	tx = vchan_tx_prep(&chan->vchan, &desc->vdesc, flags);
+	/* Stamped for the latency histogram */
+	tx->tx_submit = jz4740_dma_tx_submit;
+
+	return tx;
+}
+
+/* Builds the hardware descriptor chain for desc, so the controller can run
+ * the whole transfer without being reprogrammed after every segment. If no
+ * chain can be allocated the descriptor is run one segment at a time. A
+ * cyclic chain prepared without DMA_PREP_INTERRUPT runs without any
+ * interrupts, its position is still available through the residue. */
+static void jz4740_dma_build_hwdesc(struct jz4740_dmaengine_chan *chan,
+	struct jz4740_dma_desc *desc, unsigned long flags)
+{
+	struct jz4740_dma_dev *dmadev = jz4740_dma_chan_get_dev(chan);
+	struct jz4740_dma_hwdesc *hwdesc;
+	unsigned int i, next;
+	uint32_t offset;
+
+	if (!dmadev->desc_pool || desc->num_sgs > JZ_DMA_MAX_HWDESCS)
+		return;
+
+	desc->hwdesc = dma_pool_alloc(dmadev->desc_pool, GFP_NOWAIT,
+			&desc->hwdesc_phys);
+	if (!desc->hwdesc)
+		return;
+
+	for (i = 0; i < desc->num_sgs; i++) {
+		hwdesc = &desc->hwdesc[i];
+
+		if (desc->direction == DMA_MEM_TO_DEV) {
+			hwdesc->src_addr = desc->sg[i].addr;
+			hwdesc->dst_addr = chan->fifo_addr;
+		} else {
+			hwdesc->src_addr = chan->fifo_addr;
+			hwdesc->dst_addr = desc->sg[i].addr;
+		}
+
+		next = i + 1;
+		if (next == desc->num_sgs && desc->cyclic)
+			next = 0;
+
+		hwdesc->cmd = chan->cmd;
+		if (next != desc->num_sgs)
+			hwdesc->cmd |= JZ_DMA_CMD_LINK_ENABLE;
+		/* Only interrupt once per period or at the end of the list */
+		if (desc->cyclic ? (flags & DMA_PREP_INTERRUPT) :
+				   next == desc->num_sgs)
+			hwdesc->cmd |= JZ_DMA_CMD_TRANSFER_IRQ_ENABLE;
+
+		/* The offset of the last descriptor is only used to find the
+		 * current segment when computing the residue. */
+		offset = (desc->hwdesc_phys +
+			next * sizeof(struct jz4740_dma_hwdesc)) >> 4;
+		hwdesc->count = (desc->sg[i].len >> chan->transfer_shift) &
+			JZ_DMA_HWDESC_COUNT_MASK;
+		hwdesc->count |= (offset & 0xff) << JZ_DMA_HWDESC_OFFSET_OFFSET;
+	}
+}
+
 static struct dma_async_tx_descriptor *jz4740_dma_prep_slave_sg(
 	struct dma_chan *c, struct scatterlist *sgl,
 	unsigned int sg_len, enum dma_transfer_direction direction,
@@ -427,7 +757,9 @@ static struct dma_async_tx_descriptor *jz4740_dma_prep_slave_sg(
 	desc->direction = direction;
 	desc->cyclic = false;
 
-	return vchan_tx_prep(&chan->vchan, &desc->vdesc, flags);
+	jz4740_dma_build_hwdesc(chan, desc, flags);
+
+	return jz4740_dma_tx_prep(chan, desc, flags);
 }
 
 static struct dma_async_tx_descriptor *jz4740_dma_prep_dma_cyclic(
@@ -458,7 +790,28 @@ static struct dma_async_tx_descriptor *jz4740_dma_prep_dma_cyclic(
 	desc->direction = direction;
 	desc->cyclic = true;
 
-	return vchan_tx_prep(&chan->vchan, &desc->vdesc, flags);
+	jz4740_dma_build_hwdesc(chan, desc, flags);
+
+	return jz4740_dma_tx_prep(chan, desc, flags);
+}
+
+/* Returns the index of the segment following the one the descriptor chain is
+ * currently working on. The controller keeps a copy of the current
+ * descriptor's link offset in the status register. */
+static unsigned int jz4740_dma_hwdesc_next_sg(
+	struct jz4740_dmaengine_chan *chan, struct jz4740_dma_desc *desc)
+{
+	struct jz4740_dma_dev *dmadev = jz4740_dma_chan_get_dev(chan);
+	unsigned int offset, base;
+	uint32_t status;
+
+	status = jz4740_dma_read(dmadev, JZ_REG_DMA_STATUS_CTRL(chan->id));
+	offset = (status & JZ_DMA_STATUS_CTRL_CDOA_MASK) >>
+		JZ_DMA_STATUS_CTRL_CDOA_OFFSET;
+	base = (desc->hwdesc_phys >> 4) & 0xff;
+
+	/* A cyclic chain links back to the first descriptor */
+	return ((offset - base) & 0xff) ?: desc->num_sgs;
 }
 
 static size_t jz4740_dma_desc_residue(struct jz4740_dmaengine_chan *chan,
@@ -470,6 +823,9 @@ static size_t jz4740_dma_desc_residue(struct jz4740_dmaengine_chan *chan,
 
 	residue = 0;
 
+	if (next_sg != 0 && desc->hwdesc)
+		next_sg = jz4740_dma_hwdesc_next_sg(chan, desc);
+
 	for (i = next_sg; i < desc->num_sgs; i++)
 		residue += desc->sg[i].len;
 
@@ -496,7 +852,7 @@ static enum dma_status jz4740_dma_tx_status(struct dma_chan *c,
 
 	spin_lock_irqsave(&chan->vchan.lock, flags);
 	vdesc = vchan_find_desc(&chan->vchan, cookie);
-	if (cookie == chan->desc->vdesc.tx.cookie) {
+	if (chan->desc && cookie == chan->desc->vdesc.tx.cookie) {
 		state->residue = jz4740_dma_desc_residue(chan, chan->desc,
 				chan->next_sg);
 	} else if (vdesc) {
@@ -517,12 +873,108 @@ static int jz4740_dma_alloc_chan_resources(struct dma_chan *c)
 
 static void jz4740_dma_free_chan_resources(struct dma_chan *c)
 {
+	struct jz4740_dmaengine_chan *chan = to_jz4740_dma_chan(c);
+	unsigned long flags;
+
+	hrtimer_cancel(&chan->coalesce_timer);
+
+	spin_lock_irqsave(&chan->vchan.lock, flags);
+	jz4740_dma_chan_flush(chan);
+	chan->coalesce_count = 0;
+	spin_unlock_irqrestore(&chan->vchan.lock, flags);
+
 	vchan_free_chan_resources(to_virt_chan(c));
 }
 
 static void jz4740_dma_desc_free(struct virt_dma_desc *vdesc)
 {
-	kfree(container_of(vdesc, struct jz4740_dma_desc, vdesc));
+	struct jz4740_dma_desc *desc = to_jz4740_dma_desc(vdesc);
+	struct jz4740_dma_dev *dmadev = jz4740_dma_chan_get_dev(
+		to_jz4740_dma_chan(vdesc->tx.chan));
+
+	if (desc->hwdesc)
+		dma_pool_free(dmadev->desc_pool, desc->hwdesc,
+			desc->hwdesc_phys);
+	kfree(desc);
+}
+
+#ifdef CONFIG_DEBUG_FS
+static int jz4740_dma_latency_show(struct seq_file *s, void *unused)
+{
+	struct jz4740_dma_dev *dmadev = s->private;
+	unsigned long hist[JZ_DMA_NR_CHANS][JZ_DMA_LATENCY_BUCKETS];
+	struct jz4740_dmaengine_chan *chan;
+	unsigned long flags;
+	unsigned int i, j;
+
+	for (i = 0; i < JZ_DMA_NR_CHANS; i++) {
+		chan = &dmadev->chan[i];
+		spin_lock_irqsave(&chan->vchan.lock, flags);
+		memcpy(hist[i], chan->latency_hist, sizeof(hist[i]));
+		spin_unlock_irqrestore(&chan->vchan.lock, flags);
+	}
+
+	seq_puts(s, "usecs     ");
+	for (i = 0; i < JZ_DMA_NR_CHANS; i++) {
+		chan = &dmadev->chan[i];
+		seq_printf(s, " %12s", dma_chan_name(&chan->vchan.chan));
+	}
+	seq_putc(s, '\n');
+
+	for (j = 0; j < JZ_DMA_LATENCY_BUCKETS; j++) {
+		if (j < JZ_DMA_LATENCY_BUCKETS - 1)
+			seq_printf(s, "< %-8u", 1U << j);
+		else
+			seq_printf(s, ">= %-7u", 1U << (j - 1));
+		for (i = 0; i < JZ_DMA_NR_CHANS; i++)
+			seq_printf(s, " %12lu", hist[i][j]);
+		seq_putc(s, '\n');
+	}
+
+	return 0;
+}
+
+static int jz4740_dma_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, jz4740_dma_latency_show, inode->i_private);
+}
+
+static const struct file_operations jz4740_dma_latency_fops = {
+	.open = jz4740_dma_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void jz4740_dma_debugfs_init(struct jz4740_dma_dev *dmadev)
+{
+	dmadev->debugfs = debugfs_create_dir(dev_name(dmadev->ddev.dev), NULL);
+	if (IS_ERR_OR_NULL(dmadev->debugfs))
+		return;
+
+	debugfs_create_file("latency", S_IRUGO, dmadev->debugfs, dmadev,
+		&jz4740_dma_latency_fops);
+}
+
+static void jz4740_dma_debugfs_exit(struct jz4740_dma_dev *dmadev)
+{
+	debugfs_remove_recursive(dmadev->debugfs);
+}
+#else
+static inline void jz4740_dma_debugfs_init(struct jz4740_dma_dev *dmadev) {}
+static inline void jz4740_dma_debugfs_exit(struct jz4740_dma_dev *dmadev) {}
+#endif
+
+static void jz4740_dma_pm_runtime_teardown(struct platform_device *pdev)
+{
+	struct jz4740_dma_dev *dmadev = platform_get_drvdata(pdev);
+
+	pm_runtime_disable(&pdev->dev);
+	if (!pm_runtime_status_suspended(&pdev->dev))
+		clk_disable(dmadev->clk);
+	pm_runtime_set_suspended(&pdev->dev);
+	pm_runtime_dont_use_autosuspend(&pdev->dev);
+	clk_unprepare(dmadev->clk);
 }
 
 static int jz4740_dma_probe(struct platform_device *pdev)
@@ -550,7 +1002,34 @@ static int jz4740_dma_probe(struct platform_device *pdev)
 	if (IS_ERR(dmadev->clk))
 		return PTR_ERR(dmadev->clk);
 
+	/*
+	 * The clock is only enabled while at least one channel is running.
+	 * Channels are started from atomic context, hence the irq safe
+	 * runtime PM callbacks.
+	 */
 	clk_prepare_enable(dmadev->clk);
+	platform_set_drvdata(pdev, dmadev);
+	pm_runtime_irq_safe(&pdev->dev);
+	pm_runtime_set_active(&pdev->dev);
+	pm_runtime_set_autosuspend_delay(&pdev->dev, JZ_DMA_AUTOSUSPEND_DELAY);
+	pm_runtime_use_autosuspend(&pdev->dev);
+	pm_runtime_get_noresume(&pdev->dev);
+	pm_runtime_enable(&pdev->dev);
+
+	/* Without descriptor memory the channels fall back to reprogramming
+	 * the controller after every segment. */
+	dmadev->desc_pool = dma_pool_create(dev_name(&pdev->dev), &pdev->dev,
+		JZ_DMA_HWDESC_BLOCK_SIZE, JZ_DMA_HWDESC_BLOCK_SIZE, 0);
+	if (!dmadev->desc_pool)
+		dev_warn(&pdev->dev, "Failed to create descriptor pool\n");
+
+	/*
+	 * The transfer count is given in units of the transfer size, which is
+	 * at least one byte. Let clients like the generic dmaengine PCM know
+	 * that segments much larger than the default of 64k are fine.
+	 */
+	pdev->dev.dma_parms = &dmadev->dma_parms;
+	dma_set_max_seg_size(&pdev->dev, JZ_DMA_HWDESC_COUNT_MASK);
 
 	dma_cap_set(DMA_SLAVE, dd->cap_mask);
 	dma_cap_set(DMA_CYCLIC, dd->cap_mask);
@@ -570,23 +1049,35 @@ static int jz4740_dma_probe(struct platform_device *pdev)
 		chan->id = i;
 		chan->vchan.desc_free = jz4740_dma_desc_free;
 		vchan_init(&chan->vchan, dd);
+		INIT_LIST_HEAD(&chan->coalesced);
+		hrtimer_init(&chan->coalesce_timer, CLOCK_MONOTONIC,
+			HRTIMER_MODE_REL);
+		chan->coalesce_timer.function = jz4740_dma_coalesce_timeout;
 	}
 
 	ret = dma_async_device_register(dd);
 	if (ret)
-		return ret;
+		goto err_destroy_pool;
 
 	irq = platform_get_irq(pdev, 0);
 	ret = request_irq(irq, jz4740_dma_irq, 0, dev_name(&pdev->dev), dmadev);
 	if (ret)
 		goto err_unregister;
 
-	platform_set_drvdata(pdev, dmadev);
+	jz4740_dma_debugfs_init(dmadev);
+
+	pm_runtime_mark_last_busy(&pdev->dev);
+	pm_runtime_put_autosuspend(&pdev->dev);
 
 	return 0;
 
 err_unregister:
 	dma_async_device_unregister(dd);
+err_destroy_pool:
+	if (dmadev->desc_pool)
+		dma_pool_destroy(dmadev->desc_pool);
+	pm_runtime_put_noidle(&pdev->dev);
+	jz4740_dma_pm_runtime_teardown(pdev);
 	return ret;
 }
 
@@ -595,19 +1086,66 @@ static int jz4740_dma_remove(struct platform_device *pdev)
 	struct jz4740_dma_dev *dmadev = platform_get_drvdata(pdev);
 	int irq = platform_get_irq(pdev, 0);
 
+	jz4740_dma_debugfs_exit(dmadev);
 	free_irq(irq, dmadev);
 	dma_async_device_unregister(&dmadev->ddev);
-	clk_disable_unprepare(dmadev->clk);
+	if (dmadev->desc_pool)
+		dma_pool_destroy(dmadev->desc_pool);
+	jz4740_dma_pm_runtime_teardown(pdev);
+
+	return 0;
+}
+
+/*
+ * Halts all channels, so a kernel started through kexec does not find the
+ * controller still transferring to or from memory it now owns.
+ */
+static void jz4740_dma_shutdown(struct platform_device *pdev)
+{
+	struct jz4740_dma_dev *dmadev = platform_get_drvdata(pdev);
+	unsigned int i;
+
+	pm_runtime_get_sync(&pdev->dev);
+
+	jz4740_dma_write_mask(dmadev, JZ_REG_DMA_CTRL, 0, JZ_DMA_CTRL_ENABLE);
+	for (i = 0; i < JZ_DMA_NR_CHANS; ++i)
+		jz4740_dma_write_mask(dmadev, JZ_REG_DMA_STATUS_CTRL(i), 0,
+				JZ_DMA_STATUS_CTRL_ENABLE);
+
+	pm_runtime_put_sync(&pdev->dev);
+}
+
+#ifdef CONFIG_PM_RUNTIME
+static int jz4740_dma_runtime_suspend(struct device *dev)
+{
+	struct jz4740_dma_dev *dmadev = dev_get_drvdata(dev);
+
+	clk_disable(dmadev->clk);
 
 	return 0;
 }
 
+static int jz4740_dma_runtime_resume(struct device *dev)
+{
+	struct jz4740_dma_dev *dmadev = dev_get_drvdata(dev);
+
+	return clk_enable(dmadev->clk);
+}
+#endif
+
+static const struct dev_pm_ops jz4740_dma_pm_ops = {
+	SET_RUNTIME_PM_OPS(jz4740_dma_runtime_suspend,
+		jz4740_dma_runtime_resume, NULL)
+};
+
 static struct platform_driver jz4740_dma_driver = {
 	.probe = jz4740_dma_probe,
 	.remove = jz4740_dma_remove,
+	.shutdown = jz4740_dma_shutdown,
 	.driver = {
 		.name = "jz4740-dma",
 		.owner = THIS_MODULE,
+		.pm = &jz4740_dma_pm_ops,
 	},
 };
 module_platform_driver(jz4740_dma_driver);
@@ -66,6 +66,8 @@
 #include <linux/acpi_dma.h>
 #include <linux/of_dma.h>
 #include <linux/mempool.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 static DEFINE_MUTEX(dma_list_mutex);
 static DEFINE_IDR(dma_idr);
@@ -606,6 +608,10 @@ struct dma_chan *__dma_request_channel(const dma_cap_mask_t *mask,
 			chan = NULL;
 		}
 	}
+	if (chan) {
+		chan->client = NULL;
+		chan->requester = __builtin_return_address(0);
+	}
 	mutex_unlock(&dma_list_mutex);
 
 	pr_debug("%s: %s (%s)\n",
@@ -627,20 +633,24 @@ EXPORT_SYMBOL_GPL(__dma_request_channel);
 struct dma_chan *dma_request_slave_channel_reason(struct device *dev,
 						  const char *name)
 {
-	struct dma_chan *chan;
+	struct dma_chan *chan = ERR_PTR(-ENODEV);
 
 	/* If device-tree is present get slave info from here */
 	if (dev->of_node)
-		return of_dma_request_slave_channel(dev->of_node, name);
-
+		chan = of_dma_request_slave_channel(dev->of_node, name);
 	/* If device was enumerated by ACPI get slave info from here */
-	if (ACPI_HANDLE(dev)) {
-		chan = acpi_dma_request_slave_chan_by_name(dev, name);
-		if (chan)
-			return chan;
+	else if (ACPI_HANDLE(dev))
+		chan = acpi_dma_request_slave_chan_by_name(dev, name) ?:
+			ERR_PTR(-ENODEV);
+
+	if (!IS_ERR(chan)) {
+		mutex_lock(&dma_list_mutex);
+		chan->client = dev;
+		chan->requester = __builtin_return_address(0);
+		mutex_unlock(&dma_list_mutex);
 	}
 
-	return ERR_PTR(-ENODEV);
+	return chan;
 }
 EXPORT_SYMBOL_GPL(dma_request_slave_channel_reason);
 
@@ -667,6 +677,8 @@ void dma_release_channel(struct dma_chan *chan)
 	WARN_ONCE(chan->client_count != 1,
 		  "chan reference count %d != 1\n", chan->client_count);
 	dma_chan_put(chan);
+	chan->client = NULL;
+	chan->requester = NULL;
 	/* drop PRIVATE cap enabled by __dma_request_channel() */
 	if (--chan->device->privatecnt == 0)
 		dma_cap_clear(DMA_PRIVATE, chan->device->cap_mask);
@@ -1261,12 +1273,94 @@ void dma_run_dependencies(struct dma_async_tx_descriptor *tx)
 }
 EXPORT_SYMBOL_GPL(dma_run_dependencies);
 
+/**
+ * dma_chan_account - account a slave transfer in the channel statistics
+ * @chan: channel the transfer ran on
+ * @bytes: number of bytes moved
+ * @busy_ns: time the channel spent on it
+ *
+ * The core only counts memcpy offload by itself. Drivers call this from
+ * their completion path so that bytes_transferred and the debugfs summary
+ * also cover slave transfers.
+ */
+void dma_chan_account(struct dma_chan *chan, size_t bytes, u64 busy_ns)
+{
+	this_cpu_add(chan->local->bytes_transferred, bytes);
+	this_cpu_add(chan->local->busy_ns, busy_ns);
+}
+EXPORT_SYMBOL_GPL(dma_chan_account);
+
+#ifdef CONFIG_DEBUG_FS
+static int dmaengine_summary_show(struct seq_file *s, void *unused)
+{
+	struct dma_device *device;
+	struct dma_chan *chan;
+	unsigned long bytes;
+	u64 busy_ns;
+	int i;
+
+	seq_puts(s, "channel         bytes        busy_us      client\n");
+
+	mutex_lock(&dma_list_mutex);
+	list_for_each_entry(device, &dma_device_list, global_node) {
+		list_for_each_entry(chan, &device->channels, device_node) {
+			bytes = 0;
+			busy_ns = 0;
+			for_each_possible_cpu(i) {
+				struct dma_chan_percpu *local;
+
+				local = per_cpu_ptr(chan->local, i);
+				bytes += local->bytes_transferred;
+				busy_ns += local->busy_ns;
+			}
+
+			seq_printf(s, "%-15s %-12lu %-12llu ", dma_chan_name(chan),
+				   bytes, div_u64(busy_ns, NSEC_PER_USEC));
+			if (chan->client)
+				seq_printf(s, "%s\n", dev_name(chan->client));
+			else if (chan->requester)
+				seq_printf(s, "%pf\n", chan->requester);
+			else if (chan->client_count)
+				seq_puts(s, "(public)\n");
+			else
+				seq_puts(s, "-\n");
+		}
+	}
+	mutex_unlock(&dma_list_mutex);
+
+	return 0;
+}
+
+static int dmaengine_summary_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dmaengine_summary_show, NULL);
+}
+
+static const struct file_operations dmaengine_summary_fops = {
+	.open		= dmaengine_summary_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void __init dmaengine_debugfs_init(void)
+{
+	debugfs_create_file("dmaengine", S_IRUGO, NULL, NULL,
+			    &dmaengine_summary_fops);
+}
+#else
+static inline void dmaengine_debugfs_init(void) {}
+#endif
+
 static int __init dma_bus_init(void)
 {
 	int err = dmaengine_init_unmap_pool();
 
 	if (err)
 		return err;
+
+	dmaengine_debugfs_init();
+
 	return class_register(&dma_devclass);
 }
 arch_initcall(dma_bus_init);
@@ -7,6 +7,10 @@
 #include <linux/interrupt.h>
 #include <linux/kdev_t.h>
 #include <linux/gpio.h>
+#include <linux/miscdevice.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <uapi/linux/gpio.h>
 
 #include "gpiolib.h"
 
@@ -906,3 +910,90 @@ static int __init gpiolib_sysfs_init(void)
 	return status;
 }
 postcore_initcall(gpiolib_sysfs_init);
+
+#ifdef CONFIG_GPIO_SYSFS_MULTI
+/*
+ * /dev/gpio: read or write several exported GPIOs with one ioctl, using
+ * the chips' multi-pin operations.  The same rules as for the sysfs value
+ * attribute apply: only exported GPIOs, and only outputs can be written.
+ */
+static long gpio_multi_ioctl(struct file *file, unsigned int cmd,
+			     unsigned long arg)
+{
+	struct gpio_desc *descs[GPIO_MULTI_MAX];
+	int values[GPIO_MULTI_MAX];
+	struct gpio_multi *m;
+	unsigned int i;
+	long status = 0;
+
+	if (cmd != GPIO_MULTI_GET && cmd != GPIO_MULTI_SET)
+		return -ENOTTY;
+
+	m = memdup_user((void __user *)arg, sizeof(*m));
+	if (IS_ERR(m))
+		return PTR_ERR(m);
+
+	if (!m->count || m->count > GPIO_MULTI_MAX) {
+		status = -EINVAL;
+		goto out_free;
+	}
+
+	mutex_lock(&sysfs_lock);
+
+	for (i = 0; i < m->count; i++) {
+		if (!gpio_is_valid(m->gpio[i])) {
+			status = -EINVAL;
+			goto out_unlock;
+		}
+		descs[i] = gpio_to_desc(m->gpio[i]);
+		if (!test_bit(FLAG_EXPORT, &descs[i]->flags)) {
+			status = -EIO;
+			goto out_unlock;
+		}
+		if (cmd == GPIO_MULTI_SET &&
+		    !test_bit(FLAG_IS_OUT, &descs[i]->flags)) {
+			status = -EPERM;
+			goto out_unlock;
+		}
+		values[i] = m->value[i];
+	}
+
+	if (cmd == GPIO_MULTI_SET) {
+		gpiod_set_array_value_cansleep(m->count, descs, values);
+	} else {
+		status = gpiod_get_array_value_cansleep(m->count, descs,
+							values);
+		if (status)
+			goto out_unlock;
+		for (i = 0; i < m->count; i++)
+			m->value[i] = values[i];
+		if (copy_to_user((void __user *)arg, m, sizeof(*m)))
+			status = -EFAULT;
+	}
+
+out_unlock:
+	mutex_unlock(&sysfs_lock);
+out_free:
+	kfree(m);
+	return status;
+}
+
+static const struct file_operations gpio_multi_fops = {
+	.owner		= THIS_MODULE,
+	.unlocked_ioctl	= gpio_multi_ioctl,
+	.compat_ioctl	= gpio_multi_ioctl,
+	.llseek		= noop_llseek,
+};
+
+static struct miscdevice gpio_multi_dev = {
+	.minor		= MISC_DYNAMIC_MINOR,
+	.name		= "gpio",
+	.fops		= &gpio_multi_fops,
+};
+
+static int __init gpiolib_multi_init(void)
+{
+	return misc_register(&gpio_multi_dev);
+}
+device_initcall(gpiolib_multi_init);
+#endif /* CONFIG_GPIO_SYSFS_MULTI */
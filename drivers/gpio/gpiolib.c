@@ -1356,6 +1356,150 @@ void gpiod_set_value(struct gpio_desc *desc, int value)
 }
 EXPORT_SYMBOL_GPL(gpiod_set_value);
 
+/*
+ * Array accessors: consecutive descriptors on the same chip are handled by
+ * a single get_multiple()/set_multiple() call where the chip provides one.
+ */
+static int gpiod_get_array_value_priv(bool can_sleep, unsigned int array_size,
+				      struct gpio_desc **desc_array,
+				      int *value_array)
+{
+	unsigned long mask[BITS_TO_LONGS(ARCH_NR_GPIOS)];
+	unsigned long bits[BITS_TO_LONGS(ARCH_NR_GPIOS)];
+	unsigned int i = 0, first, j;
+	struct gpio_chip *chip;
+	int hwgpio, err;
+
+	while (i < array_size) {
+		chip = desc_array[i]->chip;
+		if (!can_sleep)
+			WARN_ON(chip->can_sleep);
+
+		first = i;
+		memset(mask, 0, sizeof(mask));
+		do {
+			__set_bit(gpio_chip_hwgpio(desc_array[i]), mask);
+			i++;
+		} while (i < array_size && desc_array[i]->chip == chip);
+
+		if (chip->get_multiple) {
+			err = chip->get_multiple(chip, mask, bits);
+			if (err < 0)
+				return err;
+		} else {
+			memset(bits, 0, sizeof(bits));
+			for (j = first; j < i; j++) {
+				hwgpio = gpio_chip_hwgpio(desc_array[j]);
+				if (chip->get && chip->get(chip, hwgpio))
+					__set_bit(hwgpio, bits);
+			}
+		}
+
+		for (j = first; j < i; j++) {
+			hwgpio = gpio_chip_hwgpio(desc_array[j]);
+			value_array[j] = test_bit(hwgpio, bits);
+			if (test_bit(FLAG_ACTIVE_LOW, &desc_array[j]->flags))
+				value_array[j] = !value_array[j];
+			trace_gpio_value(desc_to_gpio(desc_array[j]), 1,
+					 value_array[j]);
+		}
+	}
+
+	return 0;
+}
+
+static void gpiod_set_array_value_priv(bool can_sleep, unsigned int array_size,
+				       struct gpio_desc **desc_array,
+				       int *value_array)
+{
+	unsigned long mask[BITS_TO_LONGS(ARCH_NR_GPIOS)];
+	unsigned long bits[BITS_TO_LONGS(ARCH_NR_GPIOS)];
+	unsigned int i = 0, count;
+	struct gpio_desc *desc;
+	struct gpio_chip *chip;
+	int hwgpio, value;
+
+	while (i < array_size) {
+		chip = desc_array[i]->chip;
+		if (!can_sleep)
+			WARN_ON(chip->can_sleep);
+
+		memset(mask, 0, sizeof(mask));
+		count = 0;
+		do {
+			desc = desc_array[i];
+			hwgpio = gpio_chip_hwgpio(desc);
+			value = !!value_array[i];
+			if (test_bit(FLAG_ACTIVE_LOW, &desc->flags))
+				value = !value;
+
+			if (test_bit(FLAG_OPEN_DRAIN, &desc->flags) ||
+			    test_bit(FLAG_OPEN_SOURCE, &desc->flags) ||
+			    !chip->set_multiple) {
+				_gpiod_set_raw_value(desc, value);
+			} else {
+				trace_gpio_value(desc_to_gpio(desc), 0, value);
+				__set_bit(hwgpio, mask);
+				if (value)
+					__set_bit(hwgpio, bits);
+				else
+					__clear_bit(hwgpio, bits);
+				count++;
+			}
+			i++;
+		} while (i < array_size && desc_array[i]->chip == chip);
+
+		if (count)
+			chip->set_multiple(chip, mask, bits);
+	}
+}
+
+/**
+ * gpiod_get_array_value() - read several gpios at once
+ * @array_size: number of elements in the descriptor / value arrays
+ * @desc_array: array of gpio descriptors whose values will be read
+ * @value_array: array to store the read values
+ *
+ * Read the logical values of the GPIOs, i.e. taking their ACTIVE_LOW
+ * status into account.  Runs of GPIOs on the same chip are sampled
+ * together if the chip supports it.  Returns 0 or a negative errno.
+ *
+ * This function should be called from contexts where we cannot sleep, and will
+ * complain if the GPIO chip functions potentially sleep.
+ */
+int gpiod_get_array_value(unsigned int array_size,
+			  struct gpio_desc **desc_array, int *value_array)
+{
+	if (!desc_array)
+		return -EINVAL;
+	return gpiod_get_array_value_priv(false, array_size, desc_array,
+					  value_array);
+}
+EXPORT_SYMBOL_GPL(gpiod_get_array_value);
+
+/**
+ * gpiod_set_array_value() - assign values to several gpios at once
+ * @array_size: number of elements in the descriptor / value arrays
+ * @desc_array: array of gpio descriptors whose values will be assigned
+ * @value_array: array of values to assign
+ *
+ * Set the logical values of the GPIOs, i.e. taking their ACTIVE_LOW
+ * status into account.  Runs of GPIOs on the same chip are updated
+ * together if the chip supports it.
+ *
+ * This function should be called from contexts where we cannot sleep, and will
+ * complain if the GPIO chip functions potentially sleep.
+ */
+void gpiod_set_array_value(unsigned int array_size,
+			   struct gpio_desc **desc_array, int *value_array)
+{
+	if (!desc_array)
+		return;
+	gpiod_set_array_value_priv(false, array_size, desc_array,
+				   value_array);
+}
+EXPORT_SYMBOL_GPL(gpiod_set_array_value);
+
 /**
  * gpiod_cansleep() - report whether gpio value access may sleep
  * @desc: gpio to check
@@ -1493,6 +1637,46 @@ void gpiod_set_raw_value_cansleep(struct gpio_desc *desc, int value)
 }
 EXPORT_SYMBOL_GPL(gpiod_set_raw_value_cansleep);
 
+/**
+ * gpiod_get_array_value_cansleep() - read several gpios at once
+ * @array_size: number of elements in the descriptor / value arrays
+ * @desc_array: array of gpio descriptors whose values will be read
+ * @value_array: array to store the read values
+ *
+ * Same as gpiod_get_array_value(), but may sleep.
+ */
+int gpiod_get_array_value_cansleep(unsigned int array_size,
+				   struct gpio_desc **desc_array,
+				   int *value_array)
+{
+	might_sleep_if(extra_checks);
+	if (!desc_array)
+		return -EINVAL;
+	return gpiod_get_array_value_priv(true, array_size, desc_array,
+					  value_array);
+}
+EXPORT_SYMBOL_GPL(gpiod_get_array_value_cansleep);
+
+/**
+ * gpiod_set_array_value_cansleep() - assign values to several gpios at once
+ * @array_size: number of elements in the descriptor / value arrays
+ * @desc_array: array of gpio descriptors whose values will be assigned
+ * @value_array: array of values to assign
+ *
+ * Same as gpiod_set_array_value(), but may sleep.
+ */
+void gpiod_set_array_value_cansleep(unsigned int array_size,
+				    struct gpio_desc **desc_array,
+				    int *value_array)
+{
+	might_sleep_if(extra_checks);
+	if (!desc_array)
+		return;
+	gpiod_set_array_value_priv(true, array_size, desc_array,
+				   value_array);
+}
+EXPORT_SYMBOL_GPL(gpiod_set_array_value_cansleep);
+
 /**
  * gpiod_set_value_cansleep() - assign a gpio's value
  * @desc: gpio whose value will be assigned
@@ -11,6 +11,11 @@
  * with this program; if not, write to the Free Software Foundation, Inc.,
  * 675 Mass Ave, Cambridge, MA 02139, USA.
  *
+ * Besides one-shot reads of in0_input the driver offers a buffered mode:
+ * while the jz4740-adcin character device is open, the ADCIN pin is sampled
+ * at in0_sample_rate and the results, in millivolts, are collected in an
+ * mpring. read() returns them in bulk once in0_watermark samples are
+ * queued, or the ring can be mapped and consumed in place.
  */
 
 #include <linux/err.h>
@@ -23,9 +28,17 @@
 #include <linux/io.h>
 
 #include <linux/completion.h>
+#include <linux/fs.h>
+#include <linux/hrtimer.h>
 #include <linux/mfd/core.h>
+#include <linux/mpring.h>
 
 #include <linux/hwmon.h>
+#include <linux/jz4740-adc.h>
+
+#define JZ4740_HWMON_FIFO_SIZE		1024
+#define JZ4740_HWMON_MAX_RATE		10000
+#define JZ4740_HWMON_DEFAULT_RATE	100
 
 struct jz4740_hwmon {
 	struct resource *mem;
@@ -39,8 +52,25 @@ struct jz4740_hwmon {
 	struct completion read_completion;
 
 	struct mutex lock;
+
+	/* Buffered mode */
+	struct platform_device *pdev;
+	struct mpring_miscdev mdev;
+	struct hrtimer timer;
+	ktime_t period;
+	unsigned int rate;
+	unsigned int watermark;
+	bool buffered;
+	uint16_t last;
 };
 
+static inline uint16_t jz4740_hwmon_read_mv(struct jz4740_hwmon *hwmon)
+{
+	unsigned long val = readw(hwmon->base) & 0xfff;
+
+	return (val * 3300) >> 12;
+}
+
 static ssize_t jz4740_hwmon_show_name(struct device *dev,
 	struct device_attribute *dev_attr, char *buf)
 {
@@ -51,21 +81,45 @@ static irqreturn_t jz4740_hwmon_irq(int irq, void *data)
 {
 	struct jz4740_hwmon *hwmon = data;
 
-	complete(&hwmon->read_completion);
+	if (!hwmon->buffered) {
+		complete(&hwmon->read_completion);
+		return IRQ_HANDLED;
+	}
+
+	hwmon->last = jz4740_hwmon_read_mv(hwmon);
+	mpring_write(hwmon->mdev.ring, &hwmon->last);
+
 	return IRQ_HANDLED;
 }
 
+static enum hrtimer_restart jz4740_hwmon_timer(struct hrtimer *timer)
+{
+	struct jz4740_hwmon *hwmon = container_of(timer, struct jz4740_hwmon,
+						  timer);
+
+	hrtimer_forward_now(timer, hwmon->period);
+	jz4740_adc_cell_trigger(hwmon->pdev);
+
+	return HRTIMER_RESTART;
+}
+
 static ssize_t jz4740_hwmon_read_adcin(struct device *dev,
 	struct device_attribute *dev_attr, char *buf)
 {
 	struct jz4740_hwmon *hwmon = dev_get_drvdata(dev);
 	struct completion *completion = &hwmon->read_completion;
 	long t;
-	unsigned long val;
 	int ret;
 
 	mutex_lock(&hwmon->lock);
 
+	/* The buffered mode owns the ADC, report its latest sample */
+	if (hwmon->buffered) {
+		ret = sprintf(buf, "%u\n", hwmon->last);
+		mutex_unlock(&hwmon->lock);
+		return ret;
+	}
+
 	reinit_completion(completion);
 
 	enable_irq(hwmon->irq);
@@ -74,9 +128,7 @@ static ssize_t jz4740_hwmon_read_adcin(struct device *dev,
 	t = wait_for_completion_interruptible_timeout(completion, HZ);
 
 	if (t > 0) {
-		val = readw(hwmon->base) & 0xfff;
-		val = (val * 3300) >> 12;
-		ret = sprintf(buf, "%lu\n", val);
+		ret = sprintf(buf, "%u\n", jz4740_hwmon_read_mv(hwmon));
 	} else {
 		ret = t ? t : -ETIMEDOUT;
 	}
@@ -89,12 +141,97 @@ static ssize_t jz4740_hwmon_read_adcin(struct device *dev,
 	return ret;
 }
 
+static ssize_t jz4740_hwmon_show_sample_rate(struct device *dev,
+	struct device_attribute *dev_attr, char *buf)
+{
+	struct jz4740_hwmon *hwmon = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", hwmon->rate);
+}
+
+static ssize_t jz4740_hwmon_store_sample_rate(struct device *dev,
+	struct device_attribute *dev_attr, const char *buf, size_t count)
+{
+	struct jz4740_hwmon *hwmon = dev_get_drvdata(dev);
+	unsigned int rate;
+	int ret;
+
+	ret = kstrtouint(buf, 10, &rate);
+	if (ret)
+		return ret;
+
+	if (rate == 0 || rate > JZ4740_HWMON_MAX_RATE)
+		return -EINVAL;
+
+	mutex_lock(&hwmon->lock);
+	if (hwmon->buffered) {
+		ret = -EBUSY;
+	} else {
+		hwmon->rate = rate;
+		hwmon->period = ktime_set(0, NSEC_PER_SEC / rate);
+		ret = count;
+	}
+	mutex_unlock(&hwmon->lock);
+
+	return ret;
+}
+
+static ssize_t jz4740_hwmon_show_watermark(struct device *dev,
+	struct device_attribute *dev_attr, char *buf)
+{
+	struct jz4740_hwmon *hwmon = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", hwmon->watermark);
+}
+
+static ssize_t jz4740_hwmon_store_watermark(struct device *dev,
+	struct device_attribute *dev_attr, const char *buf, size_t count)
+{
+	struct jz4740_hwmon *hwmon = dev_get_drvdata(dev);
+	unsigned int watermark;
+	int ret;
+
+	ret = kstrtouint(buf, 10, &watermark);
+	if (ret)
+		return ret;
+
+	if (watermark == 0 || watermark > JZ4740_HWMON_FIFO_SIZE)
+		return -EINVAL;
+
+	mutex_lock(&hwmon->lock);
+	if (hwmon->buffered) {
+		ret = -EBUSY;
+	} else {
+		hwmon->watermark = watermark;
+		ret = count;
+	}
+	mutex_unlock(&hwmon->lock);
+
+	return ret;
+}
+
+static ssize_t jz4740_hwmon_show_overruns(struct device *dev,
+	struct device_attribute *dev_attr, char *buf)
+{
+	struct jz4740_hwmon *hwmon = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", atomic_read(&hwmon->mdev.ring->dropped));
+}
+
 static DEVICE_ATTR(name, S_IRUGO, jz4740_hwmon_show_name, NULL);
 static DEVICE_ATTR(in0_input, S_IRUGO, jz4740_hwmon_read_adcin, NULL);
+static DEVICE_ATTR(in0_sample_rate, S_IRUGO | S_IWUSR,
+	jz4740_hwmon_show_sample_rate, jz4740_hwmon_store_sample_rate);
+static DEVICE_ATTR(in0_watermark, S_IRUGO | S_IWUSR,
+	jz4740_hwmon_show_watermark, jz4740_hwmon_store_watermark);
+static DEVICE_ATTR(in0_overruns, S_IRUGO, jz4740_hwmon_show_overruns, NULL);
 
 static struct attribute *jz4740_hwmon_attributes[] = {
 	&dev_attr_name.attr,
 	&dev_attr_in0_input.attr,
+	&dev_attr_in0_sample_rate.attr,
+	&dev_attr_in0_watermark.attr,
+	&dev_attr_in0_overruns.attr,
 	NULL
 };
 
@@ -102,6 +239,49 @@ static const struct attribute_group jz4740_hwmon_attr_group = {
 	.attrs = jz4740_hwmon_attributes,
 };
 
+static int jz4740_hwmon_open(struct mpring_miscdev *mdev)
+{
+	struct jz4740_hwmon *hwmon = container_of(mdev, struct jz4740_hwmon,
+						  mdev);
+	int ret = 0;
+
+	mutex_lock(&hwmon->lock);
+
+	if (hwmon->buffered) {
+		ret = -EBUSY;
+		goto out_unlock;
+	}
+
+	/* The ADC is idle, so nothing produces into the ring */
+	mpring_reset(mdev->ring);
+	mdev->ring->watermark = hwmon->watermark;
+	hwmon->buffered = true;
+
+	enable_irq(hwmon->irq);
+	hwmon->cell->enable(hwmon->pdev);
+	hrtimer_start(&hwmon->timer, hwmon->period, HRTIMER_MODE_REL);
+
+out_unlock:
+	mutex_unlock(&hwmon->lock);
+
+	return ret;
+}
+
+static void jz4740_hwmon_release(struct mpring_miscdev *mdev)
+{
+	struct jz4740_hwmon *hwmon = container_of(mdev, struct jz4740_hwmon,
+						  mdev);
+
+	mutex_lock(&hwmon->lock);
+
+	hrtimer_cancel(&hwmon->timer);
+	hwmon->cell->disable(hwmon->pdev);
+	disable_irq(hwmon->irq);
+	hwmon->buffered = false;
+
+	mutex_unlock(&hwmon->lock);
+}
+
 static int jz4740_hwmon_probe(struct platform_device *pdev)
 {
 	int ret;
@@ -143,20 +323,32 @@ static int jz4740_hwmon_probe(struct platform_device *pdev)
 	init_completion(&hwmon->read_completion);
 	mutex_init(&hwmon->lock);
 
+	hwmon->pdev = pdev;
+	hwmon->rate = JZ4740_HWMON_DEFAULT_RATE;
+	hwmon->period = ktime_set(0, NSEC_PER_SEC / hwmon->rate);
+	hwmon->watermark = 1;
+	hrtimer_init(&hwmon->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	hwmon->timer.function = jz4740_hwmon_timer;
+
+	hwmon->mdev.ring = mpring_alloc(JZ4740_HWMON_FIFO_SIZE,
+					sizeof(uint16_t));
+	if (IS_ERR(hwmon->mdev.ring))
+		return PTR_ERR(hwmon->mdev.ring);
+
 	platform_set_drvdata(pdev, hwmon);
 
 	ret = devm_request_irq(&pdev->dev, hwmon->irq, jz4740_hwmon_irq, 0,
 			       pdev->name, hwmon);
 	if (ret) {
 		dev_err(&pdev->dev, "Failed to request irq: %d\n", ret);
-		return ret;
+		goto err_free_ring;
 	}
 	disable_irq(hwmon->irq);
 
 	ret = sysfs_create_group(&pdev->dev.kobj, &jz4740_hwmon_attr_group);
 	if (ret) {
 		dev_err(&pdev->dev, "Failed to create sysfs group: %d\n", ret);
-		return ret;
+		goto err_free_ring;
 	}
 
 	hwmon->hwmon = hwmon_device_register(&pdev->dev);
@@ -165,10 +357,25 @@ static int jz4740_hwmon_probe(struct platform_device *pdev)
 		goto err_remove_file;
 	}
 
+	hwmon->mdev.misc.name = "jz4740-adcin";
+	hwmon->mdev.misc.parent = &pdev->dev;
+	hwmon->mdev.open = jz4740_hwmon_open;
+	hwmon->mdev.release = jz4740_hwmon_release;
+
+	ret = mpring_misc_register(&hwmon->mdev);
+	if (ret) {
+		dev_err(&pdev->dev, "Failed to register misc device: %d\n", ret);
+		goto err_hwmon_unregister;
+	}
+
 	return 0;
 
+err_hwmon_unregister:
+	hwmon_device_unregister(hwmon->hwmon);
 err_remove_file:
 	sysfs_remove_group(&pdev->dev.kobj, &jz4740_hwmon_attr_group);
+err_free_ring:
+	mpring_free(hwmon->mdev.ring);
 	return ret;
 }
 
@@ -176,8 +383,10 @@ static int jz4740_hwmon_remove(struct platform_device *pdev)
 {
 	struct jz4740_hwmon *hwmon = platform_get_drvdata(pdev);
 
+	mpring_misc_deregister(&hwmon->mdev);
 	hwmon_device_unregister(hwmon->hwmon);
 	sysfs_remove_group(&pdev->dev.kobj, &jz4740_hwmon_attr_group);
+	mpring_free(hwmon->mdev.ring);
 
 	return 0;
 }
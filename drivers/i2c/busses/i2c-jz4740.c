@@ -0,0 +1,410 @@
+/*
+ *  JZ4740 I2C controller driver
+ *
+ *  The controller has a single byte data register and no DMA request line,
+ *  so messages are moved one byte per interrupt.  Messages of a transfer are
+ *  chained with repeated starts, which gives the usual combined write-read
+ *  register accesses without releasing the bus in between.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under  the terms of the GNU General  Public License as published by the
+ *  Free Software Foundation;  either version 2 of the License, or (at your
+ *  option) any later version.
+ *
+ */
+
+#include <linux/clk.h>
+#include <linux/completion.h>
+#include <linux/err.h>
+#include <linux/i2c.h>
+#include <linux/interrupt.h>
+#include <linux/io.h>
+#include <linux/module.h>
+#include <linux/platform_device.h>
+
+#include <asm/mach-jz4740/gpio.h>
+#include <asm/mach-jz4740/jz4740_i2c.h>
+
+#define JZ_REG_I2C_DATA		0x00
+#define JZ_REG_I2C_CTRL		0x04
+#define JZ_REG_I2C_STATUS	0x08
+#define JZ_REG_I2C_CLOCK	0x0C
+
+#define JZ_I2C_CTRL_IRQ_ENABLE	BIT(4)
+#define JZ_I2C_CTRL_START	BIT(3)
+#define JZ_I2C_CTRL_STOP	BIT(2)
+#define JZ_I2C_CTRL_NACK	BIT(1)
+#define JZ_I2C_CTRL_ENABLE	BIT(0)
+
+#define JZ_I2C_STATUS_TX_BUSY	BIT(4)
+#define JZ_I2C_STATUS_BUSY	BIT(3)
+#define JZ_I2C_STATUS_TX_END	BIT(2)
+#define JZ_I2C_STATUS_DATA_VALID BIT(1)
+#define JZ_I2C_STATUS_NACK	BIT(0)
+
+#define JZ4740_I2C_DEFAULT_FREQ	100000
+#define JZ4740_I2C_TIMEOUT	(HZ / 5)
+
+enum jz4740_i2c_state {
+	JZ4740_I2C_STATE_IDLE,
+	JZ4740_I2C_STATE_ADDR,
+	JZ4740_I2C_STATE_WRITE,
+	JZ4740_I2C_STATE_READ,
+	JZ4740_I2C_STATE_STOP,
+};
+
+struct jz4740_i2c {
+	struct i2c_adapter adap;
+	void __iomem *base;
+	struct clk *clk;
+	int irq;
+	unsigned int bus_freq;
+
+	spinlock_t lock;
+	struct completion done;
+
+	/* Transfer state, owned by the interrupt handler once started */
+	enum jz4740_i2c_state state;
+	struct i2c_msg *msgs;
+	unsigned int num_msgs;
+	struct i2c_msg *msg;
+	unsigned int pos;
+	int error;
+};
+
+static const struct jz_gpio_bulk_request jz4740_i2c_pins[] = {
+	JZ_GPIO_BULK_PIN(I2C_SDA),
+	JZ_GPIO_BULK_PIN(I2C_SCK),
+};
+
+static inline uint32_t jz4740_i2c_read(struct jz4740_i2c *i2c,
+	unsigned int reg)
+{
+	return readl(i2c->base + reg);
+}
+
+static inline void jz4740_i2c_write(struct jz4740_i2c *i2c, unsigned int reg,
+	uint32_t val)
+{
+	writel(val, i2c->base + reg);
+}
+
+static void jz4740_i2c_ctrl_set(struct jz4740_i2c *i2c, uint32_t mask)
+{
+	uint32_t ctrl = jz4740_i2c_read(i2c, JZ_REG_I2C_CTRL);
+
+	jz4740_i2c_write(i2c, JZ_REG_I2C_CTRL, ctrl | mask);
+}
+
+static void jz4740_i2c_ctrl_clear(struct jz4740_i2c *i2c, uint32_t mask)
+{
+	uint32_t ctrl = jz4740_i2c_read(i2c, JZ_REG_I2C_CTRL);
+
+	jz4740_i2c_write(i2c, JZ_REG_I2C_CTRL, ctrl & ~mask);
+}
+
+/* Hand a byte to the controller, it clears DATA_VALID once it is sent */
+static void jz4740_i2c_send(struct jz4740_i2c *i2c, u8 val)
+{
+	jz4740_i2c_write(i2c, JZ_REG_I2C_DATA, val);
+	jz4740_i2c_write(i2c, JZ_REG_I2C_STATUS, JZ_I2C_STATUS_DATA_VALID);
+}
+
+static void jz4740_i2c_start_msg(struct jz4740_i2c *i2c)
+{
+	struct i2c_msg *msg = i2c->msg;
+
+	i2c->pos = 0;
+	i2c->state = JZ4740_I2C_STATE_ADDR;
+
+	/* Only the last byte of a read is not acknowledged */
+	if ((msg->flags & I2C_M_RD) && msg->len == 1)
+		jz4740_i2c_ctrl_set(i2c, JZ_I2C_CTRL_NACK);
+	else
+		jz4740_i2c_ctrl_clear(i2c, JZ_I2C_CTRL_NACK);
+
+	jz4740_i2c_ctrl_set(i2c, JZ_I2C_CTRL_START);
+	jz4740_i2c_send(i2c, (msg->addr << 1) |
+		((msg->flags & I2C_M_RD) ? 1 : 0));
+}
+
+static void jz4740_i2c_stop(struct jz4740_i2c *i2c, int error)
+{
+	i2c->error = error;
+	i2c->state = JZ4740_I2C_STATE_STOP;
+	jz4740_i2c_ctrl_set(i2c, JZ_I2C_CTRL_STOP);
+}
+
+static void jz4740_i2c_next_msg(struct jz4740_i2c *i2c)
+{
+	if (i2c->msg == &i2c->msgs[i2c->num_msgs - 1]) {
+		jz4740_i2c_stop(i2c, 0);
+		return;
+	}
+
+	i2c->msg++;
+	jz4740_i2c_start_msg(i2c);
+}
+
+static irqreturn_t jz4740_i2c_irq(int irq, void *devid)
+{
+	struct jz4740_i2c *i2c = devid;
+	struct i2c_msg *msg;
+	uint32_t status;
+
+	spin_lock(&i2c->lock);
+
+	msg = i2c->msg;
+	status = jz4740_i2c_read(i2c, JZ_REG_I2C_STATUS);
+
+	switch (i2c->state) {
+	case JZ4740_I2C_STATE_ADDR:
+	case JZ4740_I2C_STATE_WRITE:
+		/* Wait for the byte and its acknowledge to be through */
+		if ((status & JZ_I2C_STATUS_DATA_VALID) ||
+		    (status & JZ_I2C_STATUS_TX_BUSY))
+			break;
+
+		if (status & JZ_I2C_STATUS_NACK) {
+			jz4740_i2c_stop(i2c, i2c->state == JZ4740_I2C_STATE_ADDR ?
+				-ENXIO : -EIO);
+			break;
+		}
+
+		if (msg->flags & I2C_M_RD) {
+			if (msg->len)
+				i2c->state = JZ4740_I2C_STATE_READ;
+			else
+				jz4740_i2c_next_msg(i2c);
+		} else if (i2c->pos < msg->len) {
+			i2c->state = JZ4740_I2C_STATE_WRITE;
+			jz4740_i2c_send(i2c, msg->buf[i2c->pos++]);
+		} else {
+			jz4740_i2c_next_msg(i2c);
+		}
+		break;
+
+	case JZ4740_I2C_STATE_READ:
+		if (!(status & JZ_I2C_STATUS_DATA_VALID))
+			break;
+
+		msg->buf[i2c->pos++] = jz4740_i2c_read(i2c, JZ_REG_I2C_DATA);
+		if (i2c->pos == msg->len - 1)
+			jz4740_i2c_ctrl_set(i2c, JZ_I2C_CTRL_NACK);
+		jz4740_i2c_write(i2c, JZ_REG_I2C_STATUS, 0);
+
+		if (i2c->pos == msg->len)
+			jz4740_i2c_next_msg(i2c);
+		break;
+
+	case JZ4740_I2C_STATE_STOP:
+		if (!(status & JZ_I2C_STATUS_TX_END))
+			break;
+
+		i2c->state = JZ4740_I2C_STATE_IDLE;
+		jz4740_i2c_ctrl_clear(i2c, JZ_I2C_CTRL_IRQ_ENABLE);
+		complete(&i2c->done);
+		break;
+
+	default:
+		jz4740_i2c_ctrl_clear(i2c, JZ_I2C_CTRL_IRQ_ENABLE);
+		break;
+	}
+
+	spin_unlock(&i2c->lock);
+
+	return IRQ_HANDLED;
+}
+
+static void jz4740_i2c_set_speed(struct jz4740_i2c *i2c)
+{
+	unsigned long rate = clk_get_rate(i2c->clk);
+	unsigned int div;
+
+	/* SCL is the device clock divided by 16 * (div + 1) */
+	div = DIV_ROUND_UP(rate, 16 * i2c->bus_freq);
+	div = clamp(div, 1U, 0x10000U);
+
+	jz4740_i2c_write(i2c, JZ_REG_I2C_CLOCK, div - 1);
+}
+
+static int jz4740_i2c_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs,
+	int num)
+{
+	struct jz4740_i2c *i2c = i2c_get_adapdata(adap);
+	unsigned long flags;
+	int ret;
+
+	clk_prepare_enable(i2c->clk);
+	jz4740_i2c_write(i2c, JZ_REG_I2C_CTRL, JZ_I2C_CTRL_ENABLE);
+	jz4740_i2c_set_speed(i2c);
+	jz4740_i2c_write(i2c, JZ_REG_I2C_STATUS, 0);
+
+	reinit_completion(&i2c->done);
+
+	spin_lock_irqsave(&i2c->lock, flags);
+	i2c->msgs = msgs;
+	i2c->num_msgs = num;
+	i2c->msg = msgs;
+	i2c->error = 0;
+	jz4740_i2c_start_msg(i2c);
+	jz4740_i2c_ctrl_set(i2c, JZ_I2C_CTRL_IRQ_ENABLE);
+	spin_unlock_irqrestore(&i2c->lock, flags);
+
+	if (!wait_for_completion_timeout(&i2c->done, JZ4740_I2C_TIMEOUT)) {
+		spin_lock_irqsave(&i2c->lock, flags);
+		i2c->state = JZ4740_I2C_STATE_IDLE;
+		jz4740_i2c_write(i2c, JZ_REG_I2C_CTRL,
+			JZ_I2C_CTRL_ENABLE | JZ_I2C_CTRL_STOP);
+		spin_unlock_irqrestore(&i2c->lock, flags);
+
+		dev_err(&adap->dev, "Transfer timed out\n");
+		ret = -ETIMEDOUT;
+	} else {
+		ret = i2c->error ?: num;
+	}
+
+	jz4740_i2c_write(i2c, JZ_REG_I2C_CTRL, 0);
+	clk_disable_unprepare(i2c->clk);
+
+	return ret;
+}
+
+static u32 jz4740_i2c_functionality(struct i2c_adapter *adap)
+{
+	return I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL;
+}
+
+static const struct i2c_algorithm jz4740_i2c_algorithm = {
+	.master_xfer	= jz4740_i2c_xfer,
+	.functionality	= jz4740_i2c_functionality,
+};
+
+static int jz4740_i2c_probe(struct platform_device *pdev)
+{
+	struct jz4740_i2c_platform_data *pdata = pdev->dev.platform_data;
+	struct jz4740_i2c *i2c;
+	struct resource *mem;
+	int ret;
+
+	i2c = devm_kzalloc(&pdev->dev, sizeof(*i2c), GFP_KERNEL);
+	if (!i2c)
+		return -ENOMEM;
+
+	i2c->bus_freq = (pdata && pdata->bus_freq) ? pdata->bus_freq :
+		JZ4740_I2C_DEFAULT_FREQ;
+	spin_lock_init(&i2c->lock);
+	init_completion(&i2c->done);
+
+	i2c->irq = platform_get_irq(pdev, 0);
+	if (i2c->irq < 0) {
+		dev_err(&pdev->dev, "Failed to get platform irq: %d\n", i2c->irq);
+		return i2c->irq;
+	}
+
+	i2c->clk = devm_clk_get(&pdev->dev, "i2c");
+	if (IS_ERR(i2c->clk)) {
+		dev_err(&pdev->dev, "Failed to get i2c clock\n");
+		return PTR_ERR(i2c->clk);
+	}
+
+	mem = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+	i2c->base = devm_ioremap_resource(&pdev->dev, mem);
+	if (IS_ERR(i2c->base))
+		return PTR_ERR(i2c->base);
+
+	ret = devm_request_irq(&pdev->dev, i2c->irq, jz4740_i2c_irq, 0,
+		dev_name(&pdev->dev), i2c);
+	if (ret) {
+		dev_err(&pdev->dev, "Failed to request irq: %d\n", ret);
+		return ret;
+	}
+
+	ret = jz_gpio_bulk_request(jz4740_i2c_pins,
+		ARRAY_SIZE(jz4740_i2c_pins));
+	if (ret) {
+		dev_err(&pdev->dev, "Failed to request i2c pins: %d\n", ret);
+		return ret;
+	}
+
+	i2c->adap.owner = THIS_MODULE;
+	i2c->adap.class = I2C_CLASS_HWMON;
+	i2c->adap.algo = &jz4740_i2c_algorithm;
+	i2c->adap.dev.parent = &pdev->dev;
+	i2c->adap.nr = pdev->id;
+	strlcpy(i2c->adap.name, pdev->name, sizeof(i2c->adap.name));
+	i2c_set_adapdata(&i2c->adap, i2c);
+
+	ret = i2c_add_numbered_adapter(&i2c->adap);
+	if (ret) {
+		dev_err(&pdev->dev, "Failed to add i2c adapter: %d\n", ret);
+		goto err_gpio_bulk_free;
+	}
+
+	platform_set_drvdata(pdev, i2c);
+
+	dev_info(&pdev->dev, "JZ4740 I2C bus at %u Hz\n", i2c->bus_freq);
+
+	return 0;
+
+err_gpio_bulk_free:
+	jz_gpio_bulk_free(jz4740_i2c_pins, ARRAY_SIZE(jz4740_i2c_pins));
+
+	return ret;
+}
+
+static int jz4740_i2c_remove(struct platform_device *pdev)
+{
+	struct jz4740_i2c *i2c = platform_get_drvdata(pdev);
+
+	i2c_del_adapter(&i2c->adap);
+	jz_gpio_bulk_free(jz4740_i2c_pins, ARRAY_SIZE(jz4740_i2c_pins));
+
+	return 0;
+}
+
+#ifdef CONFIG_PM_SLEEP
+
+static int jz4740_i2c_suspend(struct device *dev)
+{
+	struct jz4740_i2c *i2c = dev_get_drvdata(dev);
+
+	/* Wait for a transfer in flight and keep new ones out */
+	i2c_lock_adapter(&i2c->adap);
+	jz_gpio_bulk_suspend(jz4740_i2c_pins, ARRAY_SIZE(jz4740_i2c_pins));
+
+	return 0;
+}
+
+static int jz4740_i2c_resume(struct device *dev)
+{
+	struct jz4740_i2c *i2c = dev_get_drvdata(dev);
+
+	jz_gpio_bulk_resume(jz4740_i2c_pins, ARRAY_SIZE(jz4740_i2c_pins));
+	i2c_unlock_adapter(&i2c->adap);
+
+	return 0;
+}
+
+static SIMPLE_DEV_PM_OPS(jz4740_i2c_pm_ops, jz4740_i2c_suspend,
+	jz4740_i2c_resume);
+#define JZ4740_I2C_PM_OPS (&jz4740_i2c_pm_ops)
+#else
+#define JZ4740_I2C_PM_OPS NULL
+#endif
+
+static struct platform_driver jz4740_i2c_driver = {
+	.probe = jz4740_i2c_probe,
+	.remove = jz4740_i2c_remove,
+	.driver = {
+		.name = "jz4740-i2c",
+		.owner = THIS_MODULE,
+		.pm = JZ4740_I2C_PM_OPS,
+	},
+};
+
+module_platform_driver(jz4740_i2c_driver);
+
+MODULE_DESCRIPTION("JZ4740 I2C controller driver");
+MODULE_LICENSE("GPL");
+MODULE_ALIAS("platform:jz4740-i2c");
@@ -14,7 +14,9 @@
 #define EVDEV_MINORS		32
 #define EVDEV_MIN_BUFFER_SIZE	64U
 #define EVDEV_BUF_PACKETS	8
+#define EVDEV_MAX_BATCH_USECS	USEC_PER_SEC
 
+#include <linux/hrtimer.h>
 #include <linux/poll.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
@@ -51,6 +53,9 @@ struct evdev_client {
 	struct list_head node;
 	int clkid;
 	bool revoked;
+	ktime_t batch_latency; /* longest a complete packet may wait for wakeup */
+	bool batch_pending; /* complete packets held back until batch_timer */
+	struct hrtimer batch_timer;
 	unsigned int bufsize;
 	struct input_event buffer[];
 };
@@ -152,10 +157,59 @@ static void __pass_event(struct evdev_client *client,
 		client->packet_head = client->tail;
 	}
 
-	if (event->type == EV_SYN && event->code == SYN_REPORT) {
+	if (event->type == EV_SYN && event->code == SYN_REPORT)
 		client->packet_head = client->head;
-		kill_fasync(&client->fasync, SIGIO, POLL_IN);
+}
+
+/*
+ * Decide whether the wakeup for a just completed packet is left to the
+ * batch timer, so that a client asking for it is woken once per batch
+ * rather than once per packet.  The batch is cut short once half of the
+ * buffer is used, to keep packets from being dropped.  Called with
+ * buffer_lock held.
+ */
+static bool evdev_batch_packet(struct evdev_client *client)
+{
+	unsigned int queued;
+
+	if (!client->batch_latency.tv64)
+		return false;
+
+	queued = (client->packet_head - client->tail) & (client->bufsize - 1);
+	if (queued >= client->bufsize / 2) {
+		client->batch_pending = false;
+		hrtimer_try_to_cancel(&client->batch_timer);
+		return false;
+	}
+
+	if (!client->batch_pending) {
+		client->batch_pending = true;
+		hrtimer_start(&client->batch_timer, client->batch_latency,
+			      HRTIMER_MODE_REL);
 	}
+
+	return true;
+}
+
+static enum hrtimer_restart evdev_batch_timeout(struct hrtimer *timer)
+{
+	struct evdev_client *client =
+		container_of(timer, struct evdev_client, batch_timer);
+	unsigned long flags;
+
+	spin_lock_irqsave(&client->buffer_lock, flags);
+	client->batch_pending = false;
+	kill_fasync(&client->fasync, SIGIO, POLL_IN);
+	spin_unlock_irqrestore(&client->buffer_lock, flags);
+
+	wake_up_interruptible(&client->evdev->wait);
+
+	return HRTIMER_NORESTART;
+}
+
+static bool evdev_client_has_packets(struct evdev_client *client)
+{
+	return client->packet_head != client->tail && !client->batch_pending;
 }
 
 static void evdev_pass_values(struct evdev_client *client,
@@ -185,6 +239,12 @@ static void evdev_pass_values(struct evdev_client *client,
 			wakeup = true;
 	}
 
+	if (wakeup && evdev_batch_packet(client))
+		wakeup = false;
+
+	if (wakeup)
+		kill_fasync(&client->fasync, SIGIO, POLL_IN);
+
 	spin_unlock(&client->buffer_lock);
 
 	if (wakeup)
@@ -201,7 +261,10 @@ static void evdev_events(struct input_handle *handle,
 	struct evdev_client *client;
 	ktime_t time_mono, time_real;
 
-	time_mono = ktime_get();
+	/* Prefer the time the driver captured the frame at */
+	time_mono = handle->dev->timestamp;
+	if (!time_mono.tv64)
+		time_mono = ktime_get();
 	time_real = ktime_sub(time_mono, ktime_get_monotonic_offset());
 
 	rcu_read_lock();
@@ -371,6 +434,7 @@ static int evdev_release(struct inode *inode, struct file *file)
 	mutex_unlock(&evdev->mutex);
 
 	evdev_detach_client(evdev, client);
+	hrtimer_cancel(&client->batch_timer);
 
 	if (is_vmalloc_addr(client))
 		vfree(client);
@@ -408,6 +472,8 @@ static int evdev_open(struct inode *inode, struct file *file)
 
 	client->bufsize = bufsize;
 	spin_lock_init(&client->buffer_lock);
+	hrtimer_init(&client->batch_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	client->batch_timer.function = evdev_batch_timeout;
 	client->evdev = evdev;
 	evdev_attach_client(evdev, client);
 
@@ -497,7 +563,7 @@ static ssize_t evdev_read(struct file *file, char __user *buffer,
 		if (!evdev->exist || client->revoked)
 			return -ENODEV;
 
-		if (client->packet_head == client->tail &&
+		if (!evdev_client_has_packets(client) &&
 		    (file->f_flags & O_NONBLOCK))
 			return -EAGAIN;
 
@@ -522,7 +588,7 @@ static ssize_t evdev_read(struct file *file, char __user *buffer,
 
 		if (!(file->f_flags & O_NONBLOCK)) {
 			error = wait_event_interruptible(evdev->wait,
-					client->packet_head != client->tail ||
+					evdev_client_has_packets(client) ||
 					!evdev->exist || client->revoked);
 			if (error)
 				return error;
@@ -546,7 +612,7 @@ static unsigned int evdev_poll(struct file *file, poll_table *wait)
 	else
 		mask = POLLHUP | POLLERR;
 
-	if (client->packet_head != client->tail)
+	if (evdev_client_has_packets(client))
 		mask |= POLLIN | POLLRDNORM;
 
 	return mask;
@@ -822,6 +888,18 @@ static int evdev_revoke(struct evdev *evdev, struct evdev_client *client,
 	return 0;
 }
 
+static void evdev_set_batch_latency(struct evdev_client *client,
+				    unsigned int usecs)
+{
+	spin_lock_irq(&client->buffer_lock);
+	client->batch_latency = ns_to_ktime((u64)usecs * NSEC_PER_USEC);
+	spin_unlock_irq(&client->buffer_lock);
+
+	/* Deliver what is held back right away when batching is turned off */
+	if (!usecs && hrtimer_cancel(&client->batch_timer))
+		evdev_batch_timeout(&client->batch_timer);
+}
+
 static long evdev_do_ioctl(struct file *file, unsigned int cmd,
 			   void __user *p, int compat_mode)
 {
@@ -898,6 +976,14 @@ static long evdev_do_ioctl(struct file *file, unsigned int cmd,
 		client->clkid = i;
 		return 0;
 
+	case EVIOCSBATCH:
+		if (copy_from_user(&i, p, sizeof(unsigned int)))
+			return -EFAULT;
+		if (i > EVDEV_MAX_BATCH_USECS)
+			return -EINVAL;
+		evdev_set_batch_latency(client, i);
+		return 0;
+
 	case EVIOCGKEYCODE:
 		return evdev_handle_get_keycode(dev, p);
 
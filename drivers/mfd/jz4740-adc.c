@@ -12,7 +12,7 @@
  * 675 Mass Ave, Cambridge, MA 02139, USA.
  *
  * This driver synchronizes access to the JZ4740 ADC core between the
- * JZ4740 battery and hwmon drivers.
+ * JZ4740 battery and hwmon or thermal drivers.
  */
 
 #include <linux/err.h>
@@ -157,6 +157,19 @@ int jz4740_adc_set_config(struct device *dev, uint32_t mask, uint32_t val)
 }
 EXPORT_SYMBOL_GPL(jz4740_adc_set_config);
 
+int jz4740_adc_cell_trigger(struct platform_device *pdev)
+{
+	struct jz4740_adc *adc = dev_get_drvdata(pdev->dev.parent);
+
+	if (!adc)
+		return -ENODEV;
+
+	jz4740_adc_set_enabled(adc, pdev->id, true);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(jz4740_adc_cell_trigger);
+
 static struct resource jz4740_hwmon_resources[] = {
 	{
 		.start = JZ_ADC_IRQ_ADCIN,
@@ -202,6 +215,47 @@ static const struct mfd_cell jz4740_adc_cells[] = {
 	},
 };
 
+/* Replaces the hwmon cell on boards with a thermistor on the ADCIN pin */
+static const struct mfd_cell jz4740_thermal_cell = {
+	.id = 0,
+	.name = "jz4740-thermal",
+	.num_resources = ARRAY_SIZE(jz4740_hwmon_resources),
+	.resources = jz4740_hwmon_resources,
+
+	.enable = jz4740_adc_cell_enable,
+	.disable = jz4740_adc_cell_disable,
+};
+
+static int jz4740_adc_add_cells(struct platform_device *pdev,
+	struct resource *mem_base, int irq_base)
+{
+	struct jz4740_adc_platform_data *pdata = dev_get_platdata(&pdev->dev);
+	struct mfd_cell thermal_cell;
+	int ret;
+
+	if (!pdata || !pdata->thermal)
+		return mfd_add_devices(&pdev->dev, 0, jz4740_adc_cells,
+				       ARRAY_SIZE(jz4740_adc_cells), mem_base,
+				       irq_base, NULL);
+
+	thermal_cell = jz4740_thermal_cell;
+	thermal_cell.platform_data = (void *)pdata->thermal;
+	thermal_cell.pdata_size = sizeof(*pdata->thermal);
+
+	ret = mfd_add_devices(&pdev->dev, 0, &thermal_cell, 1, mem_base,
+			      irq_base, NULL);
+	if (ret)
+		return ret;
+
+	/* Skip the hwmon cell, which would use the ADCIN pin as well */
+	ret = mfd_add_devices(&pdev->dev, 0, &jz4740_adc_cells[1], 1,
+			      mem_base, irq_base, NULL);
+	if (ret)
+		mfd_remove_devices(&pdev->dev);
+
+	return ret;
+}
+
 static int jz4740_adc_probe(struct platform_device *pdev)
 {
 	struct irq_chip_generic *gc;
@@ -283,9 +337,7 @@ static int jz4740_adc_probe(struct platform_device *pdev)
 	writeb(0x00, adc->base + JZ_REG_ADC_ENABLE);
 	writeb(0xff, adc->base + JZ_REG_ADC_CTRL);
 
-	ret = mfd_add_devices(&pdev->dev, 0, jz4740_adc_cells,
-			      ARRAY_SIZE(jz4740_adc_cells), mem_base,
-			      irq_base, NULL);
+	ret = jz4740_adc_add_cells(pdev, mem_base, irq_base);
 	if (ret < 0)
 		goto err_clk_put;
 
@@ -35,6 +35,7 @@
 #include <linux/capability.h>
 #include <linux/compat.h>
 #include <linux/pm_runtime.h>
+#include <linux/workqueue.h>
 
 #include <linux/mmc/ioctl.h>
 #include <linux/mmc/card.h>
@@ -119,6 +120,27 @@ struct mmc_blk_data {
 	struct device_attribute force_ro;
 	struct device_attribute power_ro_lock;
 	int	area_type;
+
+	/* Discards held back until the queue has been idle for a while */
+	spinlock_t	discard_lock;
+	struct list_head discard_list;
+	unsigned int	nr_discards;
+	struct delayed_work discard_work;
+};
+
+/*
+ * Erasing is slow on many SD/eMMC parts and holds up the writes queued
+ * behind it, so plain discards are completed at once and the erase is
+ * issued later from a work item.  This is only done when the queue does
+ * not promise zeroed data after a discard.
+ */
+#define MMC_BLK_MAX_DISCARDS	64
+#define MMC_BLK_DISCARD_DELAY	(HZ / 2)
+
+struct mmc_blk_discard {
+	struct list_head list;
+	sector_t from;
+	sector_t to;		/* exclusive */
 };
 
 static DEFINE_MUTEX(open_lock);
@@ -951,21 +973,13 @@ static inline void mmc_blk_reset_success(struct mmc_blk_data *md, int type)
 	md->reset_done &= ~type;
 }
 
-static int mmc_blk_issue_discard_rq(struct mmc_queue *mq, struct request *req)
+static int mmc_blk_erase(struct mmc_blk_data *md, unsigned int from,
+			 unsigned int nr)
 {
-	struct mmc_blk_data *md = mq->data;
 	struct mmc_card *card = md->queue.card;
-	unsigned int from, nr, arg;
+	unsigned int arg;
 	int err = 0, type = MMC_BLK_DISCARD;
 
-	if (!mmc_can_erase(card)) {
-		err = -EOPNOTSUPP;
-		goto out;
-	}
-
-	from = blk_rq_pos(req);
-	nr = blk_rq_sectors(req);
-
 	if (mmc_can_discard(card))
 		arg = MMC_DISCARD_ARG;
 	else if (mmc_can_trim(card))
@@ -989,7 +1003,176 @@ out:
 		goto retry;
 	if (!err)
 		mmc_blk_reset_success(md, type);
-	blk_end_request(req, err, blk_rq_bytes(req));
+	return err;
+}
+
+/*
+ * Add [from, from + nr) to the deferred discards, merging it with any
+ * range it touches.  Returns false if the caller must erase it now.
+ */
+static bool mmc_blk_defer_discard(struct mmc_blk_data *md, sector_t from,
+				  unsigned int nr)
+{
+	struct mmc_blk_discard *new, *d, *tmp;
+	sector_t to = from + nr;
+
+	if (md->queue.queue->limits.discard_zeroes_data)
+		return false;
+
+	new = kmalloc(sizeof(*new), GFP_NOIO);
+	if (!new)
+		return false;
+	new->from = from;
+	new->to = to;
+
+	spin_lock(&md->discard_lock);
+	list_for_each_entry_safe(d, tmp, &md->discard_list, list) {
+		if (d->to < new->from)
+			continue;
+		if (d->from > new->to)
+			break;
+		/* overlapping or adjacent: absorb it */
+		new->from = min(new->from, d->from);
+		new->to = max(new->to, d->to);
+		list_del(&d->list);
+		md->nr_discards--;
+		kfree(d);
+	}
+	if (md->nr_discards >= MMC_BLK_MAX_DISCARDS) {
+		spin_unlock(&md->discard_lock);
+		kfree(new);
+		return false;
+	}
+	/* the list is sorted, d is the first range after new */
+	list_add_tail(&new->list, &d->list);
+	md->nr_discards++;
+	spin_unlock(&md->discard_lock);
+
+	mod_delayed_work(system_freezable_wq, &md->discard_work,
+			 MMC_BLK_DISCARD_DELAY);
+	return true;
+}
+
+/*
+ * New data is about to be written to [from, from + nr), so a deferred
+ * discard must no longer cover it.
+ */
+static void mmc_blk_cancel_discard(struct mmc_blk_data *md, sector_t from,
+				   unsigned int nr)
+{
+	struct mmc_blk_discard *d, *tmp, *split;
+	sector_t to = from + nr;
+
+	if (list_empty(&md->discard_list))
+		return;
+
+	spin_lock(&md->discard_lock);
+	list_for_each_entry_safe(d, tmp, &md->discard_list, list) {
+		if (d->to <= from)
+			continue;
+		if (d->from >= to)
+			break;
+		if (d->from >= from && d->to <= to) {
+			list_del(&d->list);
+			md->nr_discards--;
+			kfree(d);
+		} else if (d->from < from && d->to > to) {
+			/* dropping the tail is always safe if we can't split */
+			split = kmalloc(sizeof(*split), GFP_ATOMIC);
+			if (split) {
+				split->from = to;
+				split->to = d->to;
+				list_add(&split->list, &d->list);
+				md->nr_discards++;
+			}
+			d->to = from;
+			break;
+		} else if (d->from < from) {
+			d->to = from;
+		} else {
+			d->from = to;
+		}
+	}
+	spin_unlock(&md->discard_lock);
+
+	/* push the erase back, the queue is busy */
+	mod_delayed_work(system_freezable_wq, &md->discard_work,
+			 MMC_BLK_DISCARD_DELAY);
+}
+
+static void mmc_blk_discard_work(struct work_struct *work)
+{
+	struct mmc_blk_data *md = container_of(to_delayed_work(work),
+					       struct mmc_blk_data,
+					       discard_work);
+	unsigned int max = md->queue.queue->limits.max_discard_sectors;
+	struct mmc_blk_discard *d;
+	struct mmc_card *card;
+	sector_t from;
+
+	/* Held by the queue whenever it has requests in flight */
+	down(&md->queue.thread_sem);
+	/* Cleared by mmc_cleanup_queue() once the queue thread is gone */
+	card = md->queue.card;
+	if (!card) {
+		up(&md->queue.thread_sem);
+		return;
+	}
+	mmc_get_card(card);
+	if (mmc_blk_part_switch(card, md))
+		goto out;
+
+	for (;;) {
+		spin_lock(&md->discard_lock);
+		d = list_first_entry_or_null(&md->discard_list,
+					     struct mmc_blk_discard, list);
+		if (d) {
+			list_del(&d->list);
+			md->nr_discards--;
+		}
+		spin_unlock(&md->discard_lock);
+		if (!d)
+			break;
+
+		/*
+		 * Merged ranges may exceed what one erase may cover.
+		 * Discard is only a hint, errors are not reported anywhere.
+		 */
+		for (from = d->from; from < d->to; from += max)
+			mmc_blk_erase(md, from, min_t(sector_t, max,
+						      d->to - from));
+		kfree(d);
+	}
+out:
+	mmc_put_card(card);
+	up(&md->queue.thread_sem);
+}
+
+static void mmc_blk_drop_discards(struct mmc_blk_data *md)
+{
+	struct mmc_blk_discard *d, *tmp;
+
+	cancel_delayed_work_sync(&md->discard_work);
+	list_for_each_entry_safe(d, tmp, &md->discard_list, list) {
+		list_del(&d->list);
+		kfree(d);
+	}
+	md->nr_discards = 0;
+}
+
+static int mmc_blk_issue_discard_rq(struct mmc_queue *mq, struct request *req)
+{
+	struct mmc_blk_data *md = mq->data;
+	struct mmc_card *card = md->queue.card;
+	int err = 0;
+
+	if (!mmc_can_erase(card))
+		err = -EOPNOTSUPP;
+	else if (!mmc_blk_defer_discard(md, blk_rq_pos(req),
+					blk_rq_sectors(req)))
+		err = mmc_blk_erase(md, blk_rq_pos(req), blk_rq_sectors(req));
+
+	mmc_blk_end_request(req, err, blk_rq_bytes(req));
 
 	return err ? 0 : 1;
 }
@@ -1056,7 +1239,7 @@ out_retry:
 	if (!err)
 		mmc_blk_reset_success(md, type);
 out:
-	blk_end_request(req, err, blk_rq_bytes(req));
+	mmc_blk_end_request(req, err, blk_rq_bytes(req));
 
 	return err ? 0 : 1;
 }
@@ -1071,7 +1254,7 @@ static int mmc_blk_issue_flush(struct mmc_queue *mq, struct request *req)
 	if (ret)
 		ret = -EIO;
 
-	blk_end_request_all(req, ret);
+	mmc_blk_end_request_all(req, ret);
 
 	return ret ? 0 : 1;
 }
@@ -1557,6 +1740,8 @@ static u8 mmc_blk_prep_packed_list(struct mmc_queue *mq, struct request *req)
 			break;
 
 		list_add_tail(&next->queuelist, &mqrq->packed->list);
+		mmc_blk_cancel_discard(md, blk_rq_pos(next),
+				       blk_rq_sectors(next));
 		cur = next;
 		reqs++;
 	} while (1);
@@ -1683,11 +1868,12 @@ static int mmc_blk_cmd_err(struct mmc_blk_data *md, struct mmc_card *card,
 
 		blocks = mmc_sd_num_wr_blocks(card);
 		if (blocks != (u32)-1) {
-			ret = blk_end_request(req, 0, blocks << 9);
+			ret = mmc_blk_end_request(req, 0, blocks << 9);
 		}
 	} else {
 		if (!mmc_packed_cmd(mq_rq->cmd_type))
-			ret = blk_end_request(req, 0, brq->data.bytes_xfered);
+			ret = mmc_blk_end_request(req, 0,
+						  brq->data.bytes_xfered);
 	}
 	return ret;
 }
@@ -1716,7 +1902,7 @@ static int mmc_blk_end_packed_req(struct mmc_queue_req *mq_rq)
 			return ret;
 		}
 		list_del_init(&prq->queuelist);
-		blk_end_request(prq, 0, blk_rq_bytes(prq));
+		mmc_blk_end_request(prq, 0, blk_rq_bytes(prq));
 		i++;
 	}
 
@@ -1734,7 +1920,7 @@ static void mmc_blk_abort_packed_req(struct mmc_queue_req *mq_rq)
 	while (!list_empty(&packed->list)) {
 		prq = list_entry_rq(packed->list.next);
 		list_del_init(&prq->queuelist);
-		blk_end_request(prq, -EIO, blk_rq_bytes(prq));
+		mmc_blk_end_request(prq, -EIO, blk_rq_bytes(prq));
 	}
 
 	mmc_blk_clear_packed(mq_rq);
@@ -1830,7 +2016,7 @@ static int mmc_blk_issue_rw_rq(struct mmc_queue *mq, struct request *rqc)
 				ret = mmc_blk_end_packed_req(mq_rq);
 				break;
 			} else {
-				ret = blk_end_request(req, 0,
+				ret = mmc_blk_end_request(req, 0,
 						brq->data.bytes_xfered);
 			}
 
@@ -1884,7 +2070,7 @@ static int mmc_blk_issue_rw_rq(struct mmc_queue *mq, struct request *rqc)
 			 * time, so we only reach here after trying to
 			 * read a single sector.
 			 */
-			ret = blk_end_request(req, -EIO,
+			ret = mmc_blk_end_request(req, -EIO,
 						brq->data.blksz);
 			if (!ret)
 				goto start_new_req;
@@ -1927,7 +2113,7 @@ static int mmc_blk_issue_rw_rq(struct mmc_queue *mq, struct request *rqc)
 		if (mmc_card_removed(card))
 			req->cmd_flags |= REQ_QUIET;
 		while (ret)
-			ret = blk_end_request(req, -EIO,
+			ret = mmc_blk_end_request(req, -EIO,
 					blk_rq_cur_bytes(req));
 	}
 
@@ -1935,7 +2121,7 @@ static int mmc_blk_issue_rw_rq(struct mmc_queue *mq, struct request *rqc)
 	if (rqc) {
 		if (mmc_card_removed(card)) {
 			rqc->cmd_flags |= REQ_QUIET;
-			blk_end_request_all(rqc, -EIO);
+			mmc_blk_end_request_all(rqc, -EIO);
 		} else {
 			/*
 			 * If current request is packed, it needs to put back.
@@ -1968,13 +2154,18 @@ static int mmc_blk_issue_rq(struct mmc_queue *mq, struct request *req)
 	ret = mmc_blk_part_switch(card, md);
 	if (ret) {
 		if (req) {
-			blk_end_request_all(req, -EIO);
+			mmc_blk_end_request_all(req, -EIO);
 		}
 		ret = 0;
 		goto out;
 	}
 
 	mq->flags &= ~MMC_QUEUE_NEW_REQUEST;
+	if (req && rq_data_dir(req) == WRITE &&
+	    !(cmd_flags & MMC_REQ_SPECIAL_MASK))
+		mmc_blk_cancel_discard(md, blk_rq_pos(req),
+				       blk_rq_sectors(req));
+
 	if (cmd_flags & REQ_DISCARD) {
 		/* complete ongoing async transfer before issuing discard */
 		if (card->host->areq)
@@ -2068,6 +2259,9 @@ static struct mmc_blk_data *mmc_blk_alloc_req(struct mmc_card *card,
 	spin_lock_init(&md->lock);
 	INIT_LIST_HEAD(&md->part);
 	md->usage = 1;
+	spin_lock_init(&md->discard_lock);
+	INIT_LIST_HEAD(&md->discard_list);
+	INIT_DELAYED_WORK(&md->discard_work, mmc_blk_discard_work);
 
 	ret = mmc_init_queue(&md->queue, card, &md->lock, subname);
 	if (ret)
@@ -2122,12 +2316,19 @@ static struct mmc_blk_data *mmc_blk_alloc_req(struct mmc_card *card,
 	     card->ext_csd.rel_sectors)) {
 		md->flags |= MMC_BLK_REL_WR;
 		blk_queue_flush(md->queue.queue, REQ_FLUSH | REQ_FUA);
+	} else if (mmc_card_mmc(card) && (card->ext_csd.cache_ctrl & 1)) {
+		/*
+		 * Writes may sit in the volatile cache, so let the block
+		 * layer send flushes. FUA is emulated by a post-flush.
+		 */
+		blk_queue_flush(md->queue.queue, REQ_FLUSH);
 	}
 
 	if (mmc_card_mmc(card) &&
 	    (area_type == MMC_BLK_DATA_AREA_MAIN) &&
 	    (md->flags & MMC_BLK_CMD23) &&
-	    card->ext_csd.packed_event_en) {
+	    card->ext_csd.packed_event_en &&
+	    !md->queue.queue->mq_ops) {
 		if (!mmc_packed_init(&md->queue, card))
 			md->flags |= MMC_BLK_PACKED_CMD;
 	}
@@ -2232,7 +2433,9 @@ static void mmc_blk_remove_req(struct mmc_blk_data *md)
 		 * from being accepted.
 		 */
 		card = md->queue.card;
+		cancel_delayed_work_sync(&md->discard_work);
 		mmc_cleanup_queue(&md->queue);
+		mmc_blk_drop_discards(md);
 		if (md->flags & MMC_BLK_PACKED_CMD)
 			mmc_packed_clean(&md->queue);
 		if (md->disk->flags & GENHD_FL_UP) {
@@ -12,6 +12,7 @@
 #include <linux/slab.h>
 #include <linux/module.h>
 #include <linux/blkdev.h>
+#include <linux/blk-mq.h>
 #include <linux/freezer.h>
 #include <linux/kthread.h>
 #include <linux/scatterlist.h>
@@ -23,6 +24,12 @@
 
 #define MMC_QUEUE_BOUNCESZ	65536
 
+/*
+ * Default read latency target for writeback throttling, see
+ * bdi_update_read_latency().
+ */
+#define MMC_READ_LAT_TARGET_MS	100
+
 /*
  * Prepare a MMC request. This just filters out odd stuff.
  */
@@ -46,6 +53,40 @@ static int mmc_prep_request(struct request_queue *q, struct request *req)
 	return BLKPREP_OK;
 }
 
+/*
+ * Issue @req, which is already in mqrq_cur, or just complete the previous
+ * request if @req is NULL.  Returns false if a new request arrived while
+ * waiting and nothing was issued.
+ */
+static bool mmc_queue_issue(struct mmc_queue *mq, struct request *req)
+{
+	struct mmc_queue_req *tmp;
+	unsigned int cmd_flags = req ? req->cmd_flags : 0;
+
+	mq->issue_fn(mq, req);
+	if (mq->flags & MMC_QUEUE_NEW_REQUEST) {
+		mq->flags &= ~MMC_QUEUE_NEW_REQUEST;
+		return false;
+	}
+
+	/*
+	 * Current request becomes previous request
+	 * and vice versa.
+	 * In case of special requests, current request
+	 * has been finished. Do not assign it to previous
+	 * request.
+	 */
+	if (cmd_flags & MMC_REQ_SPECIAL_MASK)
+		mq->mqrq_cur->req = NULL;
+
+	mq->mqrq_prev->brq.mrq.data = NULL;
+	mq->mqrq_prev->req = NULL;
+	tmp = mq->mqrq_prev;
+	mq->mqrq_prev = mq->mqrq_cur;
+	mq->mqrq_cur = tmp;
+	return true;
+}
+
 static int mmc_queue_thread(void *d)
 {
 	struct mmc_queue *mq = d;
@@ -56,8 +97,6 @@ static int mmc_queue_thread(void *d)
 	down(&mq->thread_sem);
 	do {
 		struct request *req = NULL;
-		struct mmc_queue_req *tmp;
-		unsigned int cmd_flags = 0;
 
 		spin_lock_irq(q->queue_lock);
 		set_current_state(TASK_INTERRUPTIBLE);
@@ -67,28 +106,7 @@ static int mmc_queue_thread(void *d)
 
 		if (req || mq->mqrq_prev->req) {
 			set_current_state(TASK_RUNNING);
-			cmd_flags = req ? req->cmd_flags : 0;
-			mq->issue_fn(mq, req);
-			if (mq->flags & MMC_QUEUE_NEW_REQUEST) {
-				mq->flags &= ~MMC_QUEUE_NEW_REQUEST;
-				continue; /* fetch again */
-			}
-
-			/*
-			 * Current request becomes previous request
-			 * and vice versa.
-			 * In case of special requests, current request
-			 * has been finished. Do not assign it to previous
-			 * request.
-			 */
-			if (cmd_flags & MMC_REQ_SPECIAL_MASK)
-				mq->mqrq_cur->req = NULL;
-
-			mq->mqrq_prev->brq.mrq.data = NULL;
-			mq->mqrq_prev->req = NULL;
-			tmp = mq->mqrq_prev;
-			mq->mqrq_prev = mq->mqrq_cur;
-			mq->mqrq_cur = tmp;
+			mmc_queue_issue(mq, req);
 		} else {
 			if (kthread_should_stop()) {
 				set_current_state(TASK_RUNNING);
@@ -142,6 +160,91 @@ static void mmc_request_fn(struct request_queue *q)
 		wake_up_process(mq->thread);
 }
 
+/*
+ * blk-mq calls us in the submitting task, or in kblockd when it has to
+ * defer, so the request is issued right here instead of being handed to
+ * a queue thread.  thread_sem serialises the submitters and lets
+ * mmc_queue_suspend() keep new requests out.
+ */
+static int mmc_mq_queue_rq(struct blk_mq_hw_ctx *hctx, struct request *req)
+{
+	struct mmc_queue *mq = req->q->queuedata;
+
+	if (req->cmd_type != REQ_TYPE_FS && !(req->cmd_flags & REQ_DISCARD)) {
+		blk_dump_rq_flags(req, "MMC bad request");
+		return BLK_MQ_RQ_QUEUE_ERROR;
+	}
+
+	if (!mq || mmc_card_removed(mq->card))
+		return BLK_MQ_RQ_QUEUE_ERROR;
+
+	down(&mq->thread_sem);
+	mq->mqrq_cur->req = req;
+	mmc_queue_issue(mq, req);
+	/* Nobody will come back for the request still in flight */
+	while (mq->mqrq_prev->req)
+		mmc_queue_issue(mq, NULL);
+	up(&mq->thread_sem);
+
+	return BLK_MQ_RQ_QUEUE_OK;
+}
+
+static struct blk_mq_ops mmc_mq_ops = {
+	.queue_rq	= mmc_mq_queue_rq,
+	.map_queue	= blk_mq_map_queue,
+};
+
+static struct request_queue *mmc_alloc_queue(struct mmc_queue *mq,
+					     spinlock_t *lock)
+{
+	struct blk_mq_reg reg = {
+		.ops		= &mmc_mq_ops,
+		.nr_hw_queues	= 1,
+		.queue_depth	= 2,
+		.numa_node	= NUMA_NO_NODE,
+		.flags		= BLK_MQ_F_SHOULD_MERGE,
+	};
+	struct request_queue *q;
+
+	if (IS_ENABLED(CONFIG_MMC_BLOCK_MQ)) {
+		q = blk_mq_init_queue(&reg, mq);
+		return IS_ERR(q) ? NULL : q;
+	}
+
+	q = blk_init_queue(mmc_request_fn, lock);
+	if (q)
+		blk_queue_prep_rq(q, mmc_prep_request);
+	return q;
+}
+
+static void mmc_queue_stop(struct request_queue *q)
+{
+	unsigned long flags;
+
+	if (q->mq_ops) {
+		blk_mq_stop_hw_queues(q);
+		return;
+	}
+
+	spin_lock_irqsave(q->queue_lock, flags);
+	blk_stop_queue(q);
+	spin_unlock_irqrestore(q->queue_lock, flags);
+}
+
+static void mmc_queue_start(struct request_queue *q)
+{
+	unsigned long flags;
+
+	if (q->mq_ops) {
+		blk_mq_start_stopped_hw_queues(q);
+		return;
+	}
+
+	spin_lock_irqsave(q->queue_lock, flags);
+	blk_start_queue(q);
+	spin_unlock_irqrestore(q->queue_lock, flags);
+}
+
 static struct scatterlist *mmc_alloc_sg(int sg_len, int *err)
 {
 	struct scatterlist *sg;
@@ -200,7 +303,7 @@ int mmc_init_queue(struct mmc_queue *mq, struct mmc_card *card,
 		limit = (u64)dma_max_pfn(mmc_dev(host)) << PAGE_SHIFT;
 
 	mq->card = card;
-	mq->queue = blk_init_queue(mmc_request_fn, lock);
+	mq->queue = mmc_alloc_queue(mq, lock);
 	if (!mq->queue)
 		return -ENOMEM;
 
@@ -208,10 +311,14 @@ int mmc_init_queue(struct mmc_queue *mq, struct mmc_card *card,
 	mq->mqrq_prev = mqrq_prev;
 	mq->queue->queuedata = mq;
 
-	blk_queue_prep_rq(mq->queue, mmc_prep_request);
 	queue_flag_set_unlocked(QUEUE_FLAG_NONROT, mq->queue);
 	if (mmc_can_erase(card))
 		mmc_queue_setup_discard(mq->queue, card);
+	/* Writes are cheapest when they fill one allocation unit at a time */
+	if (card->pref_erase)
+		blk_queue_io_opt(mq->queue, card->pref_erase << 9);
+	/* Keep the flusher from starving reads on slow cards */
+	mq->queue->backing_dev_info.read_lat_target = MMC_READ_LAT_TARGET_MS;
 
 #ifdef CONFIG_MMC_BLOCK_BOUNCE
 	if (host->max_segs == 1) {
@@ -289,6 +396,9 @@ int mmc_init_queue(struct mmc_queue *mq, struct mmc_card *card,
 
 	sema_init(&mq->thread_sem, 1);
 
+	if (mq->queue->mq_ops)
+		return 0;
+
 	mq->thread = kthread_run(mmc_queue_thread, mq, "mmcqd/%d%s",
 		host->index, subname ? subname : "");
 
@@ -329,14 +439,21 @@ void mmc_cleanup_queue(struct mmc_queue *mq)
 	/* Make sure the queue isn't suspended, as that will deadlock */
 	mmc_queue_resume(mq);
 
-	/* Then terminate our worker thread */
-	kthread_stop(mq->thread);
+	if (q->mq_ops) {
+		/* Wait for any submitter still issuing, then fail the rest */
+		down(&mq->thread_sem);
+		q->queuedata = NULL;
+		up(&mq->thread_sem);
+	} else {
+		/* Then terminate our worker thread */
+		kthread_stop(mq->thread);
 
-	/* Empty the queue */
-	spin_lock_irqsave(q->queue_lock, flags);
-	q->queuedata = NULL;
-	blk_start_queue(q);
-	spin_unlock_irqrestore(q->queue_lock, flags);
+		/* Empty the queue */
+		spin_lock_irqsave(q->queue_lock, flags);
+		q->queuedata = NULL;
+		blk_start_queue(q);
+		spin_unlock_irqrestore(q->queue_lock, flags);
+	}
 
 	kfree(mqrq_cur->bounce_sg);
 	mqrq_cur->bounce_sg = NULL;
@@ -414,14 +531,11 @@ void mmc_packed_clean(struct mmc_queue *mq)
 void mmc_queue_suspend(struct mmc_queue *mq)
 {
 	struct request_queue *q = mq->queue;
-	unsigned long flags;
 
 	if (!(mq->flags & MMC_QUEUE_SUSPENDED)) {
 		mq->flags |= MMC_QUEUE_SUSPENDED;
 
-		spin_lock_irqsave(q->queue_lock, flags);
-		blk_stop_queue(q);
-		spin_unlock_irqrestore(q->queue_lock, flags);
+		mmc_queue_stop(q);
 
 		down(&mq->thread_sem);
 	}
@@ -434,16 +548,13 @@ void mmc_queue_suspend(struct mmc_queue *mq)
 void mmc_queue_resume(struct mmc_queue *mq)
 {
 	struct request_queue *q = mq->queue;
-	unsigned long flags;
 
 	if (mq->flags & MMC_QUEUE_SUSPENDED) {
 		mq->flags &= ~MMC_QUEUE_SUSPENDED;
 
 		up(&mq->thread_sem);
 
-		spin_lock_irqsave(q->queue_lock, flags);
-		blk_start_queue(q);
-		spin_unlock_irqrestore(q->queue_lock, flags);
+		mmc_queue_start(q);
 	}
 }
 
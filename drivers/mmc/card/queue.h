@@ -1,6 +1,9 @@
 #ifndef MMC_QUEUE_H
 #define MMC_QUEUE_H
 
+#include <linux/blkdev.h>
+#include <linux/blk-mq.h>
+
 #define MMC_REQ_SPECIAL_MASK	(REQ_DISCARD | REQ_FLUSH)
 
 struct request;
@@ -73,4 +76,24 @@ extern void mmc_queue_bounce_post(struct mmc_queue_req *);
 extern int mmc_packed_init(struct mmc_queue *, struct mmc_card *);
 extern void mmc_packed_clean(struct mmc_queue *);
 
+/*
+ * Completion helpers that work for both the legacy request_fn queue and
+ * the blk-mq queue selected by CONFIG_MMC_BLOCK_MQ.
+ */
+static inline bool mmc_blk_end_request(struct request *req, int error,
+				       unsigned int nr_bytes)
+{
+	if (req->q->mq_ops)
+		return blk_mq_end_io_partial(req, error, nr_bytes);
+	return blk_end_request(req, error, nr_bytes);
+}
+
+static inline void mmc_blk_end_request_all(struct request *req, int error)
+{
+	if (req->q->mq_ops)
+		blk_mq_end_io(req, error);
+	else
+		blk_end_request_all(req, error);
+}
+
 #endif
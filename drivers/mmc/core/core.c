@@ -44,6 +44,9 @@
 #include "sd_ops.h"
 #include "sdio_ops.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/mmc.h>
+
 /* If the device is not responding */
 #define MMC_CORE_TIMEOUT_MS	(10 * 60 * 1000) /* 10 minute timeout */
 
@@ -148,6 +151,8 @@ void mmc_request_done(struct mmc_host *host, struct mmc_request *mrq)
 	struct mmc_command *cmd = mrq->cmd;
 	int err = cmd->error;
 
+	trace_mmc_request_done(host, mrq);
+
 	if (err && cmd->retries && mmc_host_is_spi(host)) {
 		if (cmd->resp[0] & R1_SPI_ILLEGAL_COMMAND)
 			cmd->retries = 0;
@@ -254,6 +259,8 @@ mmc_start_request(struct mmc_host *host, struct mmc_request *mrq)
 	}
 	mmc_host_clk_hold(host);
 	led_trigger_event(host->led, LED_FULL);
+	mrq->start_time = ktime_get();
+	trace_mmc_request_start(host, mrq);
 	host->ops->request(host, mrq);
 }
 
@@ -416,6 +423,8 @@ static int mmc_wait_for_data_req_done(struct mmc_host *host,
 					cmd->opcode, cmd->error);
 				cmd->retries--;
 				cmd->error = 0;
+				mrq->start_time = ktime_get();
+				trace_mmc_request_start(host, mrq);
 				host->ops->request(host, mrq);
 				continue; /* wait for done/new event again */
 			}
@@ -465,6 +474,8 @@ static void mmc_wait_for_req_done(struct mmc_host *host,
 			 mmc_hostname(host), cmd->opcode, cmd->error);
 		cmd->retries--;
 		cmd->error = 0;
+		mrq->start_time = ktime_get();
+		trace_mmc_request_start(host, mrq);
 		host->ops->request(host, mrq);
 	}
 }
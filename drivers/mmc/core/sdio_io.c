@@ -504,6 +504,99 @@ int sdio_writesb(struct sdio_func *func, unsigned int addr, void *src,
 }
 EXPORT_SYMBOL_GPL(sdio_writesb);
 
+static int sdio_ext_req_err_check(struct mmc_card *card,
+	struct mmc_async_req *areq)
+{
+	struct sdio_ext_req *req = container_of(areq, struct sdio_ext_req, areq);
+
+	return mmc_io_rw_extended_status(card, &req->cmd, &req->data);
+}
+
+/**
+ *	sdio_init_ext_req - set up a queued block mode transfer
+ *	@func: SDIO function to access
+ *	@req: request to set up
+ *	@write: transfer direction
+ *	@addr: address to start at
+ *	@incr_addr: whether to increment the address, or access a FIFO
+ *	@sg: scatterlist describing the data
+ *	@sg_len: number of scatterlist entries
+ *	@blocks: number of blocks of the current block size to transfer
+ *
+ *	Prepares a single IO_RW_EXTENDED command in block mode for
+ *	sdio_queue_ext_req(). The scatterlist must cover exactly @blocks
+ *	blocks. Returns -EINVAL for an address or block count that does
+ *	not fit into the command.
+ */
+int sdio_init_ext_req(struct sdio_func *func, struct sdio_ext_req *req,
+	int write, unsigned int addr, int incr_addr, struct scatterlist *sg,
+	unsigned int sg_len, unsigned int blocks)
+{
+	BUG_ON(!func);
+
+	if ((addr & ~0x1FFFF) || blocks == 0 || blocks > 511)
+		return -EINVAL;
+
+	memset(req, 0, sizeof(*req));
+
+	mmc_io_rw_extended_prep(&req->cmd, &req->data, write, func->num,
+		addr, incr_addr, blocks, func->cur_blksize);
+	req->data.sg = sg;
+	req->data.sg_len = sg_len;
+	mmc_set_data_timeout(&req->data, func->card);
+
+	req->mrq.cmd = &req->cmd;
+	req->mrq.data = &req->data;
+	req->areq.mrq = &req->mrq;
+	req->areq.err_check = sdio_ext_req_err_check;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(sdio_init_ext_req);
+
+/**
+ *	sdio_queue_ext_req - start a transfer behind the running one
+ *	@func: SDIO function to access
+ *	@req: request set up by sdio_init_ext_req()
+ *
+ *	Lets the host prepare @req, e.g. map it for DMA, while the request
+ *	queued before it is still running, then waits for that one and
+ *	starts @req. The host must be claimed.
+ *
+ *	Returns the outcome of the previous request. If it failed, @req
+ *	is not started and the queue is empty again.
+ */
+int sdio_queue_ext_req(struct sdio_func *func, struct sdio_ext_req *req)
+{
+	int err = 0;
+
+	BUG_ON(!func);
+
+	mmc_start_req(func->card->host, &req->areq, &err);
+
+	return err;
+}
+EXPORT_SYMBOL_GPL(sdio_queue_ext_req);
+
+/**
+ *	sdio_finish_ext_reqs - wait for the last queued transfer
+ *	@func: SDIO function to access
+ *
+ *	Waits for the request last queued with sdio_queue_ext_req() and
+ *	returns its outcome, or 0 if none is pending.
+ */
+int sdio_finish_ext_reqs(struct sdio_func *func)
+{
+	int err = 0;
+
+	BUG_ON(!func);
+
+	mmc_start_req(func->card->host, NULL, &err);
+
+	return err;
+}
+EXPORT_SYMBOL_GPL(sdio_finish_ext_reqs);
+
 /**
  *	sdio_readw - read a 16 bit integer from a SDIO function
  *	@func: SDIO function to access
@@ -118,6 +118,56 @@ int mmc_io_rw_direct(struct mmc_card *card, int write, unsigned fn,
 	return mmc_io_rw_direct_host(card->host, write, fn, addr, in, out);
 }
 
+/*
+ * Fill in the command and data of an IO_RW_EXTENDED request, everything
+ * but the scatterlist and the data timeout.
+ */
+void mmc_io_rw_extended_prep(struct mmc_command *cmd, struct mmc_data *data,
+	int write, unsigned fn, unsigned addr, int incr_addr, unsigned blocks,
+	unsigned blksz)
+{
+	cmd->opcode = SD_IO_RW_EXTENDED;
+	cmd->arg = write ? 0x80000000 : 0x00000000;
+	cmd->arg |= fn << 28;
+	cmd->arg |= incr_addr ? 0x04000000 : 0x00000000;
+	cmd->arg |= addr << 9;
+	if (blocks == 0)
+		cmd->arg |= (blksz == 512) ? 0 : blksz;	/* byte mode */
+	else
+		cmd->arg |= 0x08000000 | blocks;		/* block mode */
+	cmd->flags = MMC_RSP_SPI_R5 | MMC_RSP_R5 | MMC_CMD_ADTC;
+
+	data->blksz = blksz;
+	/* Code in host drivers/fwk assumes that "blocks" always is >=1 */
+	data->blocks = blocks ? blocks : 1;
+	data->flags = write ? MMC_DATA_WRITE : MMC_DATA_READ;
+}
+
+/*
+ * Turn the outcome of a completed IO_RW_EXTENDED request into an errno.
+ */
+int mmc_io_rw_extended_status(struct mmc_card *card, struct mmc_command *cmd,
+	struct mmc_data *data)
+{
+	if (cmd->error)
+		return cmd->error;
+	if (data->error)
+		return data->error;
+
+	if (mmc_host_is_spi(card->host)) {
+		/* host driver already reported errors */
+	} else {
+		if (cmd->resp[0] & R5_ERROR)
+			return -EIO;
+		if (cmd->resp[0] & R5_FUNCTION_NUMBER)
+			return -EINVAL;
+		if (cmd->resp[0] & R5_OUT_OF_RANGE)
+			return -ERANGE;
+	}
+
+	return 0;
+}
+
 int mmc_io_rw_extended(struct mmc_card *card, int write, unsigned fn,
 	unsigned addr, int incr_addr, u8 *buf, unsigned blocks, unsigned blksz)
 {
@@ -140,21 +190,8 @@ int mmc_io_rw_extended(struct mmc_card *card, int write, unsigned fn,
 	mrq.cmd = &cmd;
 	mrq.data = &data;
 
-	cmd.opcode = SD_IO_RW_EXTENDED;
-	cmd.arg = write ? 0x80000000 : 0x00000000;
-	cmd.arg |= fn << 28;
-	cmd.arg |= incr_addr ? 0x04000000 : 0x00000000;
-	cmd.arg |= addr << 9;
-	if (blocks == 0)
-		cmd.arg |= (blksz == 512) ? 0 : blksz;	/* byte mode */
-	else
-		cmd.arg |= 0x08000000 | blocks;		/* block mode */
-	cmd.flags = MMC_RSP_SPI_R5 | MMC_RSP_R5 | MMC_CMD_ADTC;
-
-	data.blksz = blksz;
-	/* Code in host drivers/fwk assumes that "blocks" always is >=1 */
-	data.blocks = blocks ? blocks : 1;
-	data.flags = write ? MMC_DATA_WRITE : MMC_DATA_READ;
+	mmc_io_rw_extended_prep(&cmd, &data, write, fn, addr, incr_addr,
+				blocks, blksz);
 
 	left_size = data.blksz * data.blocks;
 	nents = (left_size - 1) / seg_size + 1;
@@ -185,23 +222,7 @@ int mmc_io_rw_extended(struct mmc_card *card, int write, unsigned fn,
 	if (nents > 1)
 		sg_free_table(&sgtable);
 
-	if (cmd.error)
-		return cmd.error;
-	if (data.error)
-		return data.error;
-
-	if (mmc_host_is_spi(card->host)) {
-		/* host driver already reported errors */
-	} else {
-		if (cmd.resp[0] & R5_ERROR)
-			return -EIO;
-		if (cmd.resp[0] & R5_FUNCTION_NUMBER)
-			return -EINVAL;
-		if (cmd.resp[0] & R5_OUT_OF_RANGE)
-			return -ERANGE;
-	}
-
-	return 0;
+	return mmc_io_rw_extended_status(card, &cmd, &data);
 }
 
 int sdio_reset(struct mmc_host *host)
@@ -17,6 +17,11 @@ int mmc_io_rw_direct(struct mmc_card *card, int write, unsigned fn,
 	unsigned addr, u8 in, u8* out);
 int mmc_io_rw_extended(struct mmc_card *card, int write, unsigned fn,
 	unsigned addr, int incr_addr, u8 *buf, unsigned blocks, unsigned blksz);
+void mmc_io_rw_extended_prep(struct mmc_command *cmd, struct mmc_data *data,
+	int write, unsigned fn, unsigned addr, int incr_addr, unsigned blocks,
+	unsigned blksz);
+int mmc_io_rw_extended_status(struct mmc_card *card, struct mmc_command *cmd,
+	struct mmc_data *data);
 int sdio_reset(struct mmc_host *host);
 
 #endif
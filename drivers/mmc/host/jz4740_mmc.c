@@ -21,9 +21,12 @@
 #include <linux/interrupt.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
+#include <linux/pm_runtime.h>
 #include <linux/delay.h>
 #include <linux/scatterlist.h>
 #include <linux/clk.h>
+#include <linux/completion.h>
+#include <linux/dmaengine.h>
 
 #include <linux/bitops.h>
 #include <linux/gpio.h>
@@ -31,6 +34,7 @@
 #include <asm/cacheflush.h>
 #include <linux/dma-mapping.h>
 
+#include <asm/mach-jz4740/dma.h>
 #include <asm/mach-jz4740/jz4740_mmc.h>
 
 #define JZ_REG_MMC_STRPCL	0x00
@@ -105,13 +109,31 @@
 
 #define JZ_MMC_CLK_RATE 24000000
 
+/* The DMA trigger level is 8 words, that is to say, the DMA read trigger is
+ * when data words in the RX FIFO are >= 8 and the DMA write trigger is when
+ * data words in the TX FIFO are < 8. */
+#define JZ4740_MMC_FIFO_HALF_SIZE 8
+
+/* Transfers smaller than this are not worth the DMA setup and are done in
+ * PIO mode. */
+#define JZ4740_MMC_DMA_MIN_SIZE 512
+
+/* How long the module clock is kept running after the last request */
+#define JZ4740_MMC_AUTOSUSPEND_DELAY 50
+
 enum jz4740_mmc_state {
+	JZ4740_MMC_STATE_SEND_SBC,
 	JZ4740_MMC_STATE_READ_RESPONSE,
 	JZ4740_MMC_STATE_TRANSFER_DATA,
 	JZ4740_MMC_STATE_SEND_STOP,
 	JZ4740_MMC_STATE_DONE,
 };
 
+struct jz4740_mmc_host_next {
+	int sg_len;
+	s32 cookie;
+};
+
 struct jz4740_mmc_host {
 	struct mmc_host *mmc;
 	struct platform_device *pdev;
@@ -121,6 +143,7 @@ struct jz4740_mmc_host {
 	int irq;
 	int card_detect_irq;
 
+	struct resource *mem_res;
 	void __iomem *base;
 	struct mmc_request *req;
 	struct mmc_command *cmd;
@@ -136,8 +159,242 @@ struct jz4740_mmc_host {
 	struct timer_list timeout_timer;
 	struct sg_mapping_iter miter;
 	enum jz4740_mmc_state state;
+
+	/* DMA support */
+	struct dma_chan *dma_rx;
+	struct dma_chan *dma_tx;
+	bool use_dma;
+	bool dma_xfer;
+	int sg_len;
+	struct jz4740_mmc_host_next next_data;
+	struct completion dma_done;
+
+	/* A runtime PM reference is held while the SDIO irq is enabled */
+	bool sdio_irq_active;
 };
 
+/*----------------------------------------------------------------------------*/
+/* DMA infrastructure */
+
+static void jz4740_mmc_release_dma_channels(struct jz4740_mmc_host *host)
+{
+	if (!host->use_dma)
+		return;
+
+	dma_release_channel(host->dma_tx);
+	dma_release_channel(host->dma_rx);
+}
+
+static int jz4740_mmc_config_dma_channel(struct jz4740_mmc_host *host,
+	struct dma_chan *chan, enum dma_transfer_direction direction)
+{
+	struct dma_slave_config conf = {
+		.direction = direction,
+		.src_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES,
+		.dst_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES,
+		.src_maxburst = JZ4740_MMC_FIFO_HALF_SIZE,
+		.dst_maxburst = JZ4740_MMC_FIFO_HALF_SIZE,
+	};
+
+	if (direction == DMA_MEM_TO_DEV) {
+		conf.dst_addr = host->mem_res->start + JZ_REG_MMC_TXFIFO;
+		conf.slave_id = JZ4740_DMA_TYPE_MMC_TRANSMIT;
+	} else {
+		conf.src_addr = host->mem_res->start + JZ_REG_MMC_RXFIFO;
+		conf.slave_id = JZ4740_DMA_TYPE_MMC_RECEIVE;
+	}
+
+	return dmaengine_slave_config(chan, &conf);
+}
+
+static int jz4740_mmc_acquire_dma_channels(struct jz4740_mmc_host *host)
+{
+	dma_cap_mask_t mask;
+	int ret;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_SLAVE, mask);
+
+	host->dma_tx = dma_request_channel(mask, NULL, host);
+	if (!host->dma_tx) {
+		dev_warn(mmc_dev(host->mmc), "Failed to get dma_tx channel\n");
+		return -ENODEV;
+	}
+
+	host->dma_rx = dma_request_channel(mask, NULL, host);
+	if (!host->dma_rx) {
+		dev_warn(mmc_dev(host->mmc), "Failed to get dma_rx channel\n");
+		ret = -ENODEV;
+		goto err_release_tx;
+	}
+
+	ret = jz4740_mmc_config_dma_channel(host, host->dma_tx,
+			DMA_MEM_TO_DEV);
+	if (ret)
+		goto err_release_rx;
+
+	ret = jz4740_mmc_config_dma_channel(host, host->dma_rx,
+			DMA_DEV_TO_MEM);
+	if (ret)
+		goto err_release_rx;
+
+	/* Initialize DMA pre request cookie */
+	host->next_data.cookie = 1;
+
+	return 0;
+
+err_release_rx:
+	dma_release_channel(host->dma_rx);
+err_release_tx:
+	dma_release_channel(host->dma_tx);
+	return ret;
+}
+
+static inline enum dma_data_direction jz4740_mmc_get_dma_dir(
+	struct mmc_data *data)
+{
+	return (data->flags & MMC_DATA_READ) ? DMA_FROM_DEVICE : DMA_TO_DEVICE;
+}
+
+static inline struct dma_chan *jz4740_mmc_get_dma_chan(
+	struct jz4740_mmc_host *host, struct mmc_data *data)
+{
+	return (data->flags & MMC_DATA_READ) ? host->dma_rx : host->dma_tx;
+}
+
+/* The DMA controller moves whole words, so only transfers where every
+ * segment is word aligned can be handed to it. Everything else, as well as
+ * short transfers where the setup cost dominates, goes through the FIFO in
+ * PIO mode. */
+static bool jz4740_mmc_can_dma(struct jz4740_mmc_host *host,
+	struct mmc_data *data)
+{
+	struct scatterlist *sg;
+	unsigned int i;
+
+	if (!host->use_dma || (data->flags & MMC_DATA_STREAM))
+		return false;
+
+	if (data->blksz * data->blocks < JZ4740_MMC_DMA_MIN_SIZE)
+		return false;
+
+	for_each_sg(data->sg, sg, data->sg_len, i) {
+		if ((sg->offset | sg->length) & 3)
+			return false;
+	}
+
+	return true;
+}
+
+static void jz4740_mmc_dma_unmap(struct jz4740_mmc_host *host,
+	struct mmc_data *data)
+{
+	struct dma_chan *chan = jz4740_mmc_get_dma_chan(host, data);
+	enum dma_data_direction dir = jz4740_mmc_get_dma_dir(data);
+
+	dma_unmap_sg(chan->device->dev, data->sg, data->sg_len, dir);
+}
+
+/* Prepares DMA data for current/next transfer, returns non-zero on failure.
+ * If next is NULL the buffers are set up for the current request, reusing the
+ * mapping done by pre_req if the cookie matches. */
+static int jz4740_mmc_prepare_dma_data(struct jz4740_mmc_host *host,
+	struct mmc_data *data, struct jz4740_mmc_host_next *next)
+{
+	struct jz4740_mmc_host_next *next_data = &host->next_data;
+	struct dma_chan *chan = jz4740_mmc_get_dma_chan(host, data);
+	enum dma_data_direction dir = jz4740_mmc_get_dma_dir(data);
+	int sg_len;
+
+	if (!next && data->host_cookie &&
+	    data->host_cookie != next_data->cookie) {
+		dev_warn(mmc_dev(host->mmc),
+			"[%s] invalid cookie: data->host_cookie %d host->next_data.cookie %d\n",
+			__func__, data->host_cookie, next_data->cookie);
+		data->host_cookie = 0;
+	}
+
+	/* Check if next job is already prepared */
+	if (next || data->host_cookie != next_data->cookie) {
+		sg_len = dma_map_sg(chan->device->dev, data->sg, data->sg_len,
+				dir);
+	} else {
+		sg_len = next_data->sg_len;
+		next_data->sg_len = 0;
+	}
+
+	if (sg_len <= 0) {
+		dev_err(mmc_dev(host->mmc),
+			"Failed to map scatterlist for DMA operation\n");
+		return -EINVAL;
+	}
+
+	if (next) {
+		next->sg_len = sg_len;
+		data->host_cookie = ++next->cookie < 0 ? 1 : next->cookie;
+	} else {
+		host->sg_len = sg_len;
+	}
+
+	return 0;
+}
+
+static void jz4740_mmc_dma_callback(void *param)
+{
+	struct jz4740_mmc_host *host = param;
+
+	complete(&host->dma_done);
+}
+
+static int jz4740_mmc_start_dma_transfer(struct jz4740_mmc_host *host,
+	struct mmc_data *data)
+{
+	struct dma_chan *chan = jz4740_mmc_get_dma_chan(host, data);
+	struct dma_async_tx_descriptor *desc;
+	enum dma_transfer_direction direction;
+
+	if (data->flags & MMC_DATA_WRITE)
+		direction = DMA_MEM_TO_DEV;
+	else
+		direction = DMA_DEV_TO_MEM;
+
+	desc = dmaengine_prep_slave_sg(chan, data->sg, host->sg_len,
+			direction, DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!desc) {
+		dev_err(mmc_dev(host->mmc),
+			"Failed to allocate DMA %s descriptor\n",
+			direction == DMA_MEM_TO_DEV ? "TX" : "RX");
+		return -ENOMEM;
+	}
+
+	desc->callback = jz4740_mmc_dma_callback;
+	desc->callback_param = host;
+	reinit_completion(&host->dma_done);
+
+	dmaengine_submit(desc);
+	dma_async_issue_pending(chan);
+
+	return 0;
+}
+
+/* The controller signals the end of a read as soon as the last word has been
+ * received from the card, which may be before the DMA controller drained the
+ * FIFO. So wait for the DMA transfer to finish before handing the buffers
+ * back. */
+static void jz4740_mmc_wait_dma_transfer(struct jz4740_mmc_host *host,
+	struct mmc_data *data)
+{
+	if (data->error)
+		return;
+
+	if (!wait_for_completion_timeout(&host->dma_done, HZ)) {
+		dev_err(mmc_dev(host->mmc), "DMA transfer timed out\n");
+		data->error = -ETIMEDOUT;
+	}
+}
+
+/*----------------------------------------------------------------------------*/
+
 static void jz4740_mmc_set_irq_enabled(struct jz4740_mmc_host *host,
 	unsigned int irq, bool enabled)
 {
@@ -194,7 +451,20 @@ static void jz4740_mmc_request_done(struct jz4740_mmc_host *host)
 	req = host->req;
 	host->req = NULL;
 
+	if (host->dma_xfer) {
+		if (req->cmd->error || req->data->error)
+			dmaengine_terminate_all(
+				jz4740_mmc_get_dma_chan(host, req->data));
+		/* Buffers mapped by pre_req are unmapped by post_req */
+		if (!req->data->host_cookie)
+			jz4740_mmc_dma_unmap(host, req->data);
+		host->dma_xfer = false;
+	}
+
 	mmc_request_done(host->mmc, req);
+
+	pm_runtime_mark_last_busy(mmc_dev(host->mmc));
+	pm_runtime_put_autosuspend(mmc_dev(host->mmc));
 }
 
 static unsigned int jz4740_mmc_poll_irq(struct jz4740_mmc_host *host,
@@ -381,7 +651,7 @@ static void jz4740_mmc_timeout(unsigned long data)
 
 	jz4740_mmc_set_irq_enabled(host, JZ_MMC_IRQ_END_CMD_RES, false);
 
-	host->req->cmd->error = -ETIMEDOUT;
+	host->cmd->error = -ETIMEDOUT;
 	jz4740_mmc_request_done(host);
 }
 
@@ -442,6 +712,8 @@ static void jz4740_mmc_send_command(struct jz4740_mmc_host *host,
 			cmdat |= JZ_MMC_CMDAT_WRITE;
 		if (cmd->data->flags & MMC_DATA_STREAM)
 			cmdat |= JZ_MMC_CMDAT_STREAM;
+		if (host->dma_xfer)
+			cmdat |= JZ_MMC_CMDAT_DMA_EN;
 
 		writew(cmd->data->blksz, host->base + JZ_REG_MMC_BLKLEN);
 		writew(cmd->data->blocks, host->base + JZ_REG_MMC_NOB);
@@ -454,6 +726,17 @@ static void jz4740_mmc_send_command(struct jz4740_mmc_host *host,
 	jz4740_mmc_clock_enable(host, 1);
 }
 
+static void jz4740_mmc_start_command(struct jz4740_mmc_host *host,
+	struct mmc_command *cmd)
+{
+	writew(JZ_MMC_IRQ_END_CMD_RES, host->base + JZ_REG_MMC_IREG);
+	jz4740_mmc_set_irq_enabled(host, JZ_MMC_IRQ_END_CMD_RES, true);
+
+	set_bit(0, &host->waiting);
+	mod_timer(&host->timeout_timer, jiffies + 5*HZ);
+	jz4740_mmc_send_command(host, cmd);
+}
+
 static void jz_mmc_prepare_data_transfer(struct jz4740_mmc_host *host)
 {
 	struct mmc_command *cmd = host->req->cmd;
@@ -476,8 +759,18 @@ static irqreturn_t jz_mmc_irq_worker(int irq, void *devid)
 	struct mmc_request *req = host->req;
 	bool timeout = false;
 
-	if (cmd->error)
+	if (host->state == JZ4740_MMC_STATE_SEND_SBC) {
+		/* CMD23 went out first, now issue the data command itself */
+		if (!req->sbc->error) {
+			jz4740_mmc_read_response(host, req->sbc);
+			host->state = JZ4740_MMC_STATE_READ_RESPONSE;
+			jz4740_mmc_start_command(host, cmd);
+			return IRQ_HANDLED;
+		}
+		host->state = JZ4740_MMC_STATE_DONE;
+	} else if (cmd->error) {
 		host->state = JZ4740_MMC_STATE_DONE;
+	}
 
 	switch (host->state) {
 	case JZ4740_MMC_STATE_READ_RESPONSE:
@@ -487,6 +780,16 @@ static irqreturn_t jz_mmc_irq_worker(int irq, void *devid)
 		if (!cmd->data)
 			break;
 
+		if (host->dma_xfer) {
+			if (jz4740_mmc_start_dma_transfer(host, cmd->data)) {
+				cmd->data->error = -EIO;
+				break;
+			}
+			cmd->data->bytes_xfered = cmd->data->blocks *
+				cmd->data->blksz;
+			goto transfer_check;
+		}
+
 		jz_mmc_prepare_data_transfer(host);
 
 	case JZ4740_MMC_STATE_TRANSFER_DATA:
@@ -500,6 +803,7 @@ static irqreturn_t jz_mmc_irq_worker(int irq, void *devid)
 			break;
 		}
 
+transfer_check:
 		jz4740_mmc_transfer_check_state(host, cmd->data);
 
 		timeout = jz4740_mmc_poll_irq(host, JZ_MMC_IRQ_DATA_TRAN_DONE);
@@ -510,7 +814,11 @@ static irqreturn_t jz_mmc_irq_worker(int irq, void *devid)
 		writew(JZ_MMC_IRQ_DATA_TRAN_DONE, host->base + JZ_REG_MMC_IREG);
 
 	case JZ4740_MMC_STATE_SEND_STOP:
-		if (!req->stop)
+		if (host->dma_xfer)
+			jz4740_mmc_wait_dma_transfer(host, cmd->data);
+
+		/* A successful CMD23 transfer ends by itself */
+		if (!req->stop || (req->sbc && !cmd->data->error))
 			break;
 
 		jz4740_mmc_send_command(host, req->stop);
@@ -603,22 +911,65 @@ static void jz4740_mmc_request(struct mmc_host *mmc, struct mmc_request *req)
 {
 	struct jz4740_mmc_host *host = mmc_priv(mmc);
 
+	pm_runtime_get_sync(mmc_dev(mmc));
+
 	host->req = req;
 
+	if (req->data && (req->data->host_cookie ||
+	    jz4740_mmc_can_dma(host, req->data)))
+		host->dma_xfer = !jz4740_mmc_prepare_dma_data(host, req->data,
+				NULL);
+
 	writew(0xffff, host->base + JZ_REG_MMC_IREG);
 
-	writew(JZ_MMC_IRQ_END_CMD_RES, host->base + JZ_REG_MMC_IREG);
-	jz4740_mmc_set_irq_enabled(host, JZ_MMC_IRQ_END_CMD_RES, true);
+	if (req->sbc) {
+		host->state = JZ4740_MMC_STATE_SEND_SBC;
+		jz4740_mmc_start_command(host, req->sbc);
+	} else {
+		host->state = JZ4740_MMC_STATE_READ_RESPONSE;
+		jz4740_mmc_start_command(host, req->cmd);
+	}
+}
 
-	host->state = JZ4740_MMC_STATE_READ_RESPONSE;
-	set_bit(0, &host->waiting);
-	mod_timer(&host->timeout_timer, jiffies + 5*HZ);
-	jz4740_mmc_send_command(host, req->cmd);
+static void jz4740_mmc_pre_request(struct mmc_host *mmc,
+	struct mmc_request *req, bool is_first_req)
+{
+	struct jz4740_mmc_host *host = mmc_priv(mmc);
+	struct mmc_data *data = req->data;
+
+	if (!data || !jz4740_mmc_can_dma(host, data))
+		return;
+
+	data->host_cookie = 0;
+
+	if (jz4740_mmc_prepare_dma_data(host, data, &host->next_data))
+		data->host_cookie = 0;
+}
+
+static void jz4740_mmc_post_request(struct mmc_host *mmc,
+	struct mmc_request *req, int err)
+{
+	struct jz4740_mmc_host *host = mmc_priv(mmc);
+	struct mmc_data *data = req->data;
+
+	if (!data || !host->use_dma)
+		return;
+
+	if (data->host_cookie) {
+		jz4740_mmc_dma_unmap(host, data);
+		data->host_cookie = 0;
+	}
+
+	if (err)
+		dmaengine_terminate_all(jz4740_mmc_get_dma_chan(host, data));
 }
 
 static void jz4740_mmc_set_ios(struct mmc_host *mmc, struct mmc_ios *ios)
 {
 	struct jz4740_mmc_host *host = mmc_priv(mmc);
+
+	pm_runtime_get_sync(mmc_dev(mmc));
+
 	if (ios->clock)
 		jz4740_mmc_set_clock_rate(host, ios->clock);
 
@@ -629,7 +980,6 @@ static void jz4740_mmc_set_ios(struct mmc_host *mmc, struct mmc_ios *ios)
 			gpio_set_value(host->pdata->gpio_power,
 					!host->pdata->power_active_low);
 		host->cmdat |= JZ_MMC_CMDAT_INIT;
-		clk_prepare_enable(host->clk);
 		break;
 	case MMC_POWER_ON:
 		break;
@@ -637,7 +987,6 @@ static void jz4740_mmc_set_ios(struct mmc_host *mmc, struct mmc_ios *ios)
 		if (gpio_is_valid(host->pdata->gpio_power))
 			gpio_set_value(host->pdata->gpio_power,
 					host->pdata->power_active_low);
-		clk_disable_unprepare(host->clk);
 		break;
 	}
 
@@ -651,16 +1000,38 @@ static void jz4740_mmc_set_ios(struct mmc_host *mmc, struct mmc_ios *ios)
 	default:
 		break;
 	}
+
+	pm_runtime_mark_last_busy(mmc_dev(mmc));
+	pm_runtime_put_autosuspend(mmc_dev(mmc));
 }
 
+/*
+ * The controller only sees the card's interrupt while it is clocked. It is
+ * disabled from the interrupt handler through mmc_signal_sdio_irq() and
+ * enabled again from the SDIO irq thread, which may sleep.
+ */
 static void jz4740_mmc_enable_sdio_irq(struct mmc_host *mmc, int enable)
 {
 	struct jz4740_mmc_host *host = mmc_priv(mmc);
+
+	if (enable && !host->sdio_irq_active) {
+		pm_runtime_get_sync(mmc_dev(mmc));
+		host->sdio_irq_active = true;
+	}
+
 	jz4740_mmc_set_irq_enabled(host, JZ_MMC_IRQ_SDIO, enable);
+
+	if (!enable && host->sdio_irq_active) {
+		host->sdio_irq_active = false;
+		pm_runtime_mark_last_busy(mmc_dev(mmc));
+		pm_runtime_put_autosuspend(mmc_dev(mmc));
+	}
 }
 
 static const struct mmc_host_ops jz4740_mmc_ops = {
 	.request	= jz4740_mmc_request,
+	.pre_req	= jz4740_mmc_pre_request,
+	.post_req	= jz4740_mmc_post_request,
 	.set_ios	= jz4740_mmc_set_ios,
 	.get_ro		= mmc_gpio_get_ro,
 	.get_cd		= mmc_gpio_get_cd,
@@ -754,7 +1125,6 @@ static int jz4740_mmc_probe(struct platform_device* pdev)
 	struct mmc_host *mmc;
 	struct jz4740_mmc_host *host;
 	struct jz4740_mmc_platform_data *pdata;
-	struct resource *res;
 
 	pdata = pdev->dev.platform_data;
 
@@ -781,8 +1151,8 @@ static int jz4740_mmc_probe(struct platform_device* pdev)
 		goto err_free_host;
 	}
 
-	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
-	host->base = devm_ioremap_resource(&pdev->dev, res);
+	host->mem_res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+	host->base = devm_ioremap_resource(&pdev->dev, host->mem_res);
 	if (IS_ERR(host->base)) {
 		ret = PTR_ERR(host->base);
 		goto err_free_host;
@@ -803,7 +1173,12 @@ static int jz4740_mmc_probe(struct platform_device* pdev)
 	mmc->f_max = JZ_MMC_CLK_RATE;
 	mmc->ocr_avail = MMC_VDD_32_33 | MMC_VDD_33_34;
 	mmc->caps = (pdata && pdata->data_1bit) ? 0 : MMC_CAP_4_BIT_DATA;
-	mmc->caps |= MMC_CAP_SDIO_IRQ;
+	mmc->caps |= MMC_CAP_SDIO_IRQ | MMC_CAP_CMD23;
+	/*
+	 * Packed writes are plain CMD23 multi-block writes with a header
+	 * block, which the controller handles like any other transfer.
+	 */
+	mmc->caps2 |= MMC_CAP2_PACKED_WR | MMC_CAP2_CACHE_CTRL;
 
 	mmc->max_blk_size = (1 << 10) - 1;
 	mmc->max_blk_count = (1 << 15) - 1;
@@ -815,6 +1190,7 @@ static int jz4740_mmc_probe(struct platform_device* pdev)
 	host->mmc = mmc;
 	host->pdev = pdev;
 	spin_lock_init(&host->lock);
+	init_completion(&host->dma_done);
 	host->irq_mask = 0xffff;
 
 	ret = request_threaded_irq(host->irq, jz_mmc_irq, jz_mmc_irq_worker, 0,
@@ -831,17 +1207,49 @@ static int jz4740_mmc_probe(struct platform_device* pdev)
 	/* It is not important when it times out, it just needs to timeout. */
 	set_timer_slack(&host->timeout_timer, HZ);
 
+	host->use_dma = !jz4740_mmc_acquire_dma_channels(host);
+	if (host->use_dma)
+		mmc->max_seg_size = min_t(unsigned int, mmc->max_seg_size,
+			dma_get_max_seg_size(host->dma_rx->device->dev));
+
 	platform_set_drvdata(pdev, host);
+
+	/*
+	 * Without runtime PM the module clock simply stays on, otherwise it
+	 * is gated once the host has been idle for a while.
+	 */
+	clk_prepare_enable(host->clk);
+	pm_runtime_set_active(&pdev->dev);
+	pm_runtime_set_autosuspend_delay(&pdev->dev,
+		JZ4740_MMC_AUTOSUSPEND_DELAY);
+	pm_runtime_use_autosuspend(&pdev->dev);
+	pm_runtime_get_noresume(&pdev->dev);
+	pm_runtime_enable(&pdev->dev);
+
 	ret = mmc_add_host(mmc);
 
 	if (ret) {
 		dev_err(&pdev->dev, "Failed to add mmc host: %d\n", ret);
-		goto err_free_irq;
+		goto err_disable_pm;
 	}
+
+	pm_runtime_mark_last_busy(&pdev->dev);
+	pm_runtime_put_autosuspend(&pdev->dev);
 	dev_info(&pdev->dev, "JZ SD/MMC card driver registered\n");
 
+	dev_info(&pdev->dev, "Using %s, %d-bit mode\n",
+		 host->use_dma ? "DMA" : "PIO",
+		 (mmc->caps & MMC_CAP_4_BIT_DATA) ? 4 : 1);
+
 	return 0;
 
+err_disable_pm:
+	pm_runtime_disable(&pdev->dev);
+	pm_runtime_dont_use_autosuspend(&pdev->dev);
+	pm_runtime_put_noidle(&pdev->dev);
+	pm_runtime_set_suspended(&pdev->dev);
+	clk_disable_unprepare(host->clk);
+	jz4740_mmc_release_dma_channels(host);
 err_free_irq:
 	free_irq(host->irq, host);
 err_free_gpios:
@@ -858,22 +1266,54 @@ static int jz4740_mmc_remove(struct platform_device *pdev)
 {
 	struct jz4740_mmc_host *host = platform_get_drvdata(pdev);
 
+	pm_runtime_get_sync(&pdev->dev);
+
 	del_timer_sync(&host->timeout_timer);
 	jz4740_mmc_set_irq_enabled(host, 0xff, false);
 	jz4740_mmc_reset(host);
 
 	mmc_remove_host(host->mmc);
 
+	pm_runtime_disable(&pdev->dev);
+	pm_runtime_dont_use_autosuspend(&pdev->dev);
+	pm_runtime_put_noidle(&pdev->dev);
+	pm_runtime_set_suspended(&pdev->dev);
+	clk_disable_unprepare(host->clk);
+
 	free_irq(host->irq, host);
 
 	jz4740_mmc_free_gpios(pdev);
 	jz_gpio_bulk_free(jz4740_mmc_pins, jz4740_mmc_num_pins(host));
 
+	jz4740_mmc_release_dma_channels(host);
+
 	mmc_free_host(host->mmc);
 
 	return 0;
 }
 
+/*
+ * Stops the controller and any transfer it has in flight, so a kernel started
+ * through kexec does not get its memory overwritten by a stale transfer.
+ */
+static void jz4740_mmc_shutdown(struct platform_device *pdev)
+{
+	struct jz4740_mmc_host *host = platform_get_drvdata(pdev);
+
+	pm_runtime_get_sync(&pdev->dev);
+
+	del_timer_sync(&host->timeout_timer);
+	jz4740_mmc_set_irq_enabled(host, 0xff, false);
+
+	if (host->use_dma) {
+		dmaengine_terminate_all(host->dma_rx);
+		dmaengine_terminate_all(host->dma_tx);
+	}
+
+	jz4740_mmc_clock_disable(host);
+	jz4740_mmc_reset(host);
+}
+
 #ifdef CONFIG_PM_SLEEP
 
 static int jz4740_mmc_suspend(struct device *dev)
@@ -882,6 +1322,9 @@ static int jz4740_mmc_suspend(struct device *dev)
 
 	jz_gpio_bulk_suspend(jz4740_mmc_pins, jz4740_mmc_num_pins(host));
 
+	if (!pm_runtime_status_suspended(dev))
+		clk_disable_unprepare(host->clk);
+
 	return 0;
 }
 
@@ -889,25 +1332,51 @@ static int jz4740_mmc_resume(struct device *dev)
 {
 	struct jz4740_mmc_host *host = dev_get_drvdata(dev);
 
+	if (!pm_runtime_status_suspended(dev))
+		clk_prepare_enable(host->clk);
+
 	jz_gpio_bulk_resume(jz4740_mmc_pins, jz4740_mmc_num_pins(host));
 
 	return 0;
 }
 
-static SIMPLE_DEV_PM_OPS(jz4740_mmc_pm_ops, jz4740_mmc_suspend,
-	jz4740_mmc_resume);
-#define JZ4740_MMC_PM_OPS (&jz4740_mmc_pm_ops)
-#else
-#define JZ4740_MMC_PM_OPS NULL
 #endif
 
+#ifdef CONFIG_PM_RUNTIME
+
+static int jz4740_mmc_runtime_suspend(struct device *dev)
+{
+	struct jz4740_mmc_host *host = dev_get_drvdata(dev);
+
+	clk_disable_unprepare(host->clk);
+
+	return 0;
+}
+
+static int jz4740_mmc_runtime_resume(struct device *dev)
+{
+	struct jz4740_mmc_host *host = dev_get_drvdata(dev);
+
+	return clk_prepare_enable(host->clk);
+}
+
+#endif
+
+static const struct dev_pm_ops jz4740_mmc_pm_ops = {
+	SET_SYSTEM_SLEEP_PM_OPS(jz4740_mmc_suspend, jz4740_mmc_resume)
+	SET_RUNTIME_PM_OPS(jz4740_mmc_runtime_suspend,
+		jz4740_mmc_runtime_resume, NULL)
+};
+
 static struct platform_driver jz4740_mmc_driver = {
 	.probe = jz4740_mmc_probe,
 	.remove = jz4740_mmc_remove,
+	.shutdown = jz4740_mmc_shutdown,
 	.driver = {
 		.name = "jz4740-mmc",
 		.owner = THIS_MODULE,
-		.pm = JZ4740_MMC_PM_OPS,
+		.pm = &jz4740_mmc_pm_ops,
+		.probe_async = true,
 	},
 };
 
@@ -281,6 +281,54 @@ unlock:
 	return ret;
 }
 
+/*
+ * Flash only stays readable through a memory mapping while it is in array
+ * mode, i.e. while nobody programs or erases it.  So direct access is only
+ * offered for read-only MTD devices, which makes it safe to drop the
+ * point reference again before returning the address.
+ */
+static int blktrans_direct_access(struct block_device *bdev, sector_t sector,
+				  void **kaddr, unsigned long *pfn)
+{
+	struct mtd_blktrans_dev *dev = blktrans_dev_get(bdev->bd_disk);
+	resource_size_t phys;
+	size_t retlen;
+	loff_t from;
+	int ret = -ENXIO;
+
+	if (!dev)
+		return ret;
+
+	mutex_lock(&dev->lock);
+
+	if (!dev->mtd)
+		goto unlock;
+
+	ret = -EOPNOTSUPP;
+	if (dev->mtd->flags & MTD_WRITEABLE)
+		goto unlock;
+
+	ret = -EINVAL;
+	if (sector & (PAGE_SIZE / 512 - 1))
+		goto unlock;
+
+	from = (loff_t)(sector + get_start_sect(bdev)) << 9;
+	ret = mtd_point(dev->mtd, from, PAGE_SIZE, &retlen, kaddr, &phys);
+	if (ret)
+		goto unlock;
+	mtd_unpoint(dev->mtd, from, retlen);
+
+	if (retlen != PAGE_SIZE || !phys || (phys & ~PAGE_MASK)) {
+		ret = -EINVAL;
+		goto unlock;
+	}
+	*pfn = phys >> PAGE_SHIFT;
+unlock:
+	mutex_unlock(&dev->lock);
+	blktrans_dev_put(dev);
+	return ret;
+}
+
 static int blktrans_ioctl(struct block_device *bdev, fmode_t mode,
 			      unsigned int cmd, unsigned long arg)
 {
@@ -314,6 +362,7 @@ static const struct block_device_operations mtd_block_ops = {
 	.release	= blktrans_release,
 	.ioctl		= blktrans_ioctl,
 	.getgeo		= blktrans_getgeo,
+	.direct_access	= blktrans_direct_access,
 };
 
 int add_mtd_blktrans_dev(struct mtd_blktrans_dev *new)
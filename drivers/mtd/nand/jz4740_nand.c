@@ -18,13 +18,20 @@
 #include <linux/module.h>
 #include <linux/platform_device.h>
 #include <linux/slab.h>
+#include <linux/completion.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
 
 #include <linux/mtd/mtd.h>
 #include <linux/mtd/nand.h>
 #include <linux/mtd/partitions.h>
+#include <linux/mtd/concat.h>
 
 #include <linux/gpio.h>
 
+#include <asm/mach-jz4740/dma.h>
 #include <asm/mach-jz4740/jz4740_nand.h>
 
 #define JZ_REG_NAND_CTRL	0x50
@@ -57,6 +64,10 @@
 #define JZ_NAND_MEM_CMD_OFFSET 0x08000
 #define JZ_NAND_MEM_ADDR_OFFSET 0x10000
 
+/* Shorter transfers, like OOB and ECC bytes, are done in PIO mode */
+#define JZ_NAND_DMA_MIN_LEN 512
+#define JZ_NAND_DMA_BURST 16
+
 struct jz_nand {
 	struct mtd_info mtd;
 	struct nand_chip chip;
@@ -71,6 +82,31 @@ struct jz_nand {
 
 	struct jz_nand_platform_data *pdata;
 	bool is_reading;
+
+	struct dma_chan *dma_chan;
+	struct completion dma_done;
+	uint8_t *dma_buf;
+	size_t dma_buf_size;
+	/* Set when a transfer timed out, until the chip is selected again */
+	bool dma_failed;
+	int (*waitfunc)(struct mtd_info *mtd, struct nand_chip *chip);
+
+	/* All banks share the data bus, the chip select control register and
+	 * the ECC engine. The bus lock of the master protects them, the other
+	 * fields are only valid in the master. */
+	struct jz_nand *master;
+	struct mutex bus_lock;
+	bool bus_locked;
+
+	/* In parallel bank mode every additional bank is driven by its own
+	 * jz_nand, and the banks are concatenated into a single mtd. */
+	struct jz_nand *bank_nand[JZ_NAND_NUM_BANKS];
+	struct mtd_info *concat;
+
+	/* nand_bbt records where it found the tables in the descriptors, so
+	 * every jz_nand needs its own copy. */
+	struct nand_bbt_descr bbt_td;
+	struct nand_bbt_descr bbt_md;
 };
 
 static inline struct jz_nand *mtd_to_jz_nand(struct mtd_info *mtd)
@@ -78,6 +114,25 @@ static inline struct jz_nand *mtd_to_jz_nand(struct mtd_info *mtd)
 	return container_of(mtd, struct jz_nand, mtd);
 }
 
+static void jz_nand_bus_lock(struct jz_nand *nand)
+{
+	/* Panic writes happen in atomic context with everything else stopped */
+	if (nand->bus_locked || oops_in_progress)
+		return;
+
+	mutex_lock(&nand->master->bus_lock);
+	nand->bus_locked = true;
+}
+
+static void jz_nand_bus_unlock(struct jz_nand *nand)
+{
+	if (!nand->bus_locked)
+		return;
+
+	nand->bus_locked = false;
+	mutex_unlock(&nand->master->bus_lock);
+}
+
 static void jz_nand_select_chip(struct mtd_info *mtd, int chipnr)
 {
 	struct jz_nand *nand = mtd_to_jz_nand(mtd);
@@ -85,6 +140,11 @@ static void jz_nand_select_chip(struct mtd_info *mtd, int chipnr)
 	uint32_t ctrl;
 	int banknr;
 
+	if (chipnr != -1) {
+		jz_nand_bus_lock(nand);
+		nand->dma_failed = false;
+	}
+
 	ctrl = readl(nand->base + JZ_REG_NAND_CTRL);
 	ctrl &= ~JZ_NAND_CTRL_ASSERT_CHIP_MASK;
 
@@ -98,6 +158,9 @@ static void jz_nand_select_chip(struct mtd_info *mtd, int chipnr)
 	writel(ctrl, nand->base + JZ_REG_NAND_CTRL);
 
 	nand->selected_bank = banknr;
+
+	if (chipnr == -1)
+		jz_nand_bus_unlock(nand);
 }
 
 static void jz_nand_cmd_ctrl(struct mtd_info *mtd, int dat, unsigned int ctrl)
@@ -128,6 +191,251 @@ static void jz_nand_cmd_ctrl(struct mtd_info *mtd, int dat, unsigned int ctrl)
 		writeb(dat, chip->IO_ADDR_W);
 }
 
+static void jz_nand_dma_callback(void *param)
+{
+	struct jz_nand *nand = param;
+
+	complete(&nand->dma_done);
+}
+
+/* Moves len bytes between the data port of the selected bank and buf. The
+ * ECC engine snoops the data bus, so the RS encoder and decoder see the data
+ * just like they do for PIO transfers. Returns -ETIMEDOUT if the transfer
+ * timed out, or another error if it could not be started, in which case the
+ * caller falls back to PIO. */
+static int jz_nand_dma_transfer(struct jz_nand *nand, void *buf, int len,
+	enum dma_transfer_direction direction)
+{
+	struct device *dev = nand->dma_chan->device->dev;
+	struct dma_async_tx_descriptor *desc;
+	enum dma_slave_buswidth bus_width;
+	struct dma_slave_config conf;
+	enum dma_data_direction dir;
+	dma_addr_t port_addr;
+	dma_addr_t addr;
+	void *dma_buf = buf;
+	int ret = 0;
+
+	/* Buffers not suitable for the streaming DMA API, like the vmalloc
+	 * buffers used by UBI, are bounced. */
+	if (!virt_addr_valid(buf) || ((unsigned long)buf & 3)) {
+		if (len > nand->dma_buf_size)
+			return -EINVAL;
+		dma_buf = nand->dma_buf;
+		if (direction == DMA_MEM_TO_DEV)
+			memcpy(dma_buf, buf, len);
+	}
+
+	if (nand->chip.options & NAND_BUSWIDTH_16)
+		bus_width = DMA_SLAVE_BUSWIDTH_2_BYTES;
+	else
+		bus_width = DMA_SLAVE_BUSWIDTH_1_BYTE;
+
+	port_addr = nand->bank_mem[nand->selected_bank]->start;
+
+	memset(&conf, 0, sizeof(conf));
+	conf.direction = direction;
+	conf.slave_id = JZ4740_DMA_TYPE_AUTO_REQUEST;
+	if (direction == DMA_DEV_TO_MEM) {
+		conf.src_addr = port_addr;
+		conf.src_addr_width = bus_width;
+		conf.dst_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
+		conf.src_maxburst = JZ_NAND_DMA_BURST;
+		dir = DMA_FROM_DEVICE;
+	} else {
+		conf.dst_addr = port_addr;
+		conf.dst_addr_width = bus_width;
+		conf.src_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
+		conf.dst_maxburst = JZ_NAND_DMA_BURST;
+		dir = DMA_TO_DEVICE;
+	}
+
+	ret = dmaengine_slave_config(nand->dma_chan, &conf);
+	if (ret)
+		return ret;
+
+	addr = dma_map_single(dev, dma_buf, len, dir);
+	if (dma_mapping_error(dev, addr))
+		return -ENOMEM;
+
+	desc = dmaengine_prep_slave_single(nand->dma_chan, addr, len,
+			direction, DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!desc) {
+		ret = -ENOMEM;
+		goto err_unmap;
+	}
+
+	desc->callback = jz_nand_dma_callback;
+	desc->callback_param = nand;
+	reinit_completion(&nand->dma_done);
+
+	dmaengine_submit(desc);
+	dma_async_issue_pending(nand->dma_chan);
+
+	if (!wait_for_completion_timeout(&nand->dma_done,
+				msecs_to_jiffies(100))) {
+		/* It is unknown how far the data phase got, so it can not be
+		 * redone in PIO mode. Instead the whole operation is failed:
+		 * reads as uncorrectable by jz_nand_correct_ecc_rs(), writes
+		 * and erases by jz_nand_dma_wait(). */
+		dev_err(dev, "NAND DMA transfer timed out\n");
+		dmaengine_terminate_all(nand->dma_chan);
+		nand->dma_failed = true;
+		ret = -ETIMEDOUT;
+	}
+
+	dma_unmap_single(dev, addr, len, dir);
+
+	if (!ret && dma_buf != buf && direction == DMA_DEV_TO_MEM)
+		memcpy(buf, dma_buf, len);
+
+	return ret;
+
+err_unmap:
+	dma_unmap_single(dev, addr, len, dir);
+	return ret;
+}
+
+static inline bool jz_nand_use_dma(struct jz_nand *nand, int len)
+{
+	/* mtdoops and friends write from atomic context */
+	return nand->dma_chan && len >= JZ_NAND_DMA_MIN_LEN &&
+		!(len & (JZ_NAND_DMA_BURST - 1)) && !oops_in_progress;
+}
+
+static void jz_nand_read_buf(struct mtd_info *mtd, uint8_t *buf, int len)
+{
+	struct jz_nand *nand = mtd_to_jz_nand(mtd);
+	struct nand_chip *chip = mtd->priv;
+	int ret;
+
+	if (jz_nand_use_dma(nand, len)) {
+		ret = jz_nand_dma_transfer(nand, buf, len, DMA_DEV_TO_MEM);
+		if (!ret || ret == -ETIMEDOUT)
+			return;
+	}
+
+	if (chip->options & NAND_BUSWIDTH_16)
+		ioread16_rep(chip->IO_ADDR_R, buf, len >> 1);
+	else
+		ioread8_rep(chip->IO_ADDR_R, buf, len);
+}
+
+static void jz_nand_write_buf(struct mtd_info *mtd, const uint8_t *buf,
+	int len)
+{
+	struct jz_nand *nand = mtd_to_jz_nand(mtd);
+	struct nand_chip *chip = mtd->priv;
+	int ret;
+
+	if (jz_nand_use_dma(nand, len)) {
+		ret = jz_nand_dma_transfer(nand, (void *)buf, len,
+					   DMA_MEM_TO_DEV);
+		if (!ret || ret == -ETIMEDOUT)
+			return;
+	}
+
+	if (chip->options & NAND_BUSWIDTH_16)
+		iowrite16_rep(chip->IO_ADDR_W, buf, len >> 1);
+	else
+		iowrite8_rep(chip->IO_ADDR_W, buf, len);
+}
+
+static void jz_nand_request_dma(struct platform_device *pdev,
+	struct jz_nand *nand)
+{
+	dma_cap_mask_t mask;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_SLAVE, mask);
+
+	nand->dma_chan = dma_request_channel(mask, NULL, nand);
+	if (!nand->dma_chan) {
+		dev_info(&pdev->dev, "No DMA channel, using PIO\n");
+		return;
+	}
+
+	nand->dma_buf_size = nand->mtd.writesize;
+	nand->dma_buf = kmalloc(nand->dma_buf_size, GFP_KERNEL);
+	if (!nand->dma_buf) {
+		dma_release_channel(nand->dma_chan);
+		nand->dma_chan = NULL;
+		return;
+	}
+
+	init_completion(&nand->dma_done);
+}
+
+/* Reports the program or erase as failed if a DMA transfer of the operation
+ * timed out, as the chip can not know it got incomplete data. */
+static int jz_nand_dma_wait(struct mtd_info *mtd, struct nand_chip *chip)
+{
+	struct jz_nand *nand = mtd_to_jz_nand(mtd);
+	int status = nand->waitfunc(mtd, chip);
+
+	if (nand->dma_failed)
+		status |= NAND_STATUS_FAIL;
+
+	return status;
+}
+
+/* Must be called after nand_scan_ident() has set up chip->waitfunc */
+static void jz_nand_hook_dma_wait(struct jz_nand *nand)
+{
+	if (!nand->dma_chan)
+		return;
+
+	nand->waitfunc = nand->chip.waitfunc;
+	nand->chip.waitfunc = jz_nand_dma_wait;
+}
+
+static void jz_nand_release_dma(struct jz_nand *nand)
+{
+	if (!nand->dma_chan)
+		return;
+
+	dma_release_channel(nand->dma_chan);
+	kfree(nand->dma_buf);
+}
+
+/* Used in parallel bank mode, where the shared busy pin can not tell which
+ * bank is busy. Polls the status of the selected bank and hands the bus to
+ * the other banks while this one is programming or erasing. */
+static int jz_nand_wait(struct mtd_info *mtd, struct nand_chip *chip)
+{
+	struct jz_nand *nand = mtd_to_jz_nand(mtd);
+	unsigned long timeo = (chip->state == FL_ERASING ? 400 : 20);
+	int bank = nand->selected_bank;
+	uint32_t ctrl;
+	int status;
+
+	timeo = jiffies + msecs_to_jiffies(timeo);
+
+	/* Make sure tWB has passed */
+	ndelay(100);
+
+	for (;;) {
+		chip->cmdfunc(mtd, NAND_CMD_STATUS, -1, -1);
+		status = chip->read_byte(mtd);
+		if ((status & NAND_STATUS_READY) || !time_before(jiffies, timeo))
+			break;
+
+		if (oops_in_progress)
+			continue;
+
+		ctrl = readl(nand->base + JZ_REG_NAND_CTRL);
+		ctrl &= ~JZ_NAND_CTRL_ASSERT_CHIP(bank);
+		writel(ctrl, nand->base + JZ_REG_NAND_CTRL);
+
+		jz_nand_bus_unlock(nand);
+		cond_resched();
+		jz_nand_bus_lock(nand);
+	}
+
+	WARN_ON(!(status & NAND_STATUS_READY));
+	return status;
+}
+
 static int jz_nand_dev_ready(struct mtd_info *mtd)
 {
 	struct jz_nand *nand = mtd_to_jz_nand(mtd);
@@ -224,6 +532,9 @@ static int jz_nand_correct_ecc_rs(struct mtd_info *mtd, uint8_t *dat,
 	uint32_t t;
 	unsigned int timeout = 1000;
 
+	if (nand->dma_failed)
+		return -1;
+
 	t = read_ecc[0];
 
 	if (t == 0xff) {
@@ -373,6 +684,7 @@ static int jz_nand_detect_bank(struct platform_device *pdev,
 		chip->cmdfunc(mtd, NAND_CMD_READID, 0x00, -1);
 		*nand_maf_id = chip->read_byte(mtd);
 		*nand_dev_id = chip->read_byte(mtd);
+		chip->select_chip(mtd, -1);
 	} else {
 		/* Detect additional chip. */
 		chip->select_chip(mtd, chipnr);
@@ -380,9 +692,11 @@ static int jz_nand_detect_bank(struct platform_device *pdev,
 		chip->cmdfunc(mtd, NAND_CMD_READID, 0x00, -1);
 		if (*nand_maf_id != chip->read_byte(mtd)
 		 || *nand_dev_id != chip->read_byte(mtd)) {
+			chip->select_chip(mtd, -1);
 			ret = -ENODEV;
 			goto notfound_id;
 		}
+		chip->select_chip(mtd, -1);
 
 		/* Update size of the MTD. */
 		chip->numchips++;
@@ -405,6 +719,169 @@ notfound_gpio:
 	return ret;
 }
 
+static void jz_nand_release_banks(struct jz_nand *nand)
+{
+	size_t i;
+
+	for (i = 1; i < JZ_NAND_NUM_BANKS; i++) {
+		if (!nand->bank_nand[i])
+			continue;
+		nand_release(&nand->bank_nand[i]->mtd);
+		kfree(nand->bank_nand[i]);
+		nand->bank_nand[i] = NULL;
+	}
+}
+
+/* The RS ECC bytes start at OOB offset 6 in every layout we know of, and bytes
+ * 0 and 1 hold the factory bad block marker. That leaves bytes 2-5 for the
+ * BBT signature and version, unlike the nand_bbt defaults which use 8-12. */
+static uint8_t jz_nand_bbt_pattern[] = { 'B', 'b', 't' };
+static uint8_t jz_nand_bbt_mirror_pattern[] = { 't', 'b', 'B' };
+
+static const struct nand_bbt_descr jz_nand_bbt_main_descr = {
+	.options = NAND_BBT_LASTBLOCK | NAND_BBT_CREATE | NAND_BBT_WRITE
+		| NAND_BBT_2BIT | NAND_BBT_VERSION | NAND_BBT_PERCHIP,
+	.offs = 2,
+	.len = 3,
+	.veroffs = 5,
+	.maxblocks = 4,
+	.pattern = jz_nand_bbt_pattern,
+};
+
+static const struct nand_bbt_descr jz_nand_bbt_mirror_descr = {
+	.options = NAND_BBT_LASTBLOCK | NAND_BBT_CREATE | NAND_BBT_WRITE
+		| NAND_BBT_2BIT | NAND_BBT_VERSION | NAND_BBT_PERCHIP,
+	.offs = 2,
+	.len = 3,
+	.veroffs = 5,
+	.maxblocks = 4,
+	.pattern = jz_nand_bbt_mirror_pattern,
+};
+
+static void jz_nand_init_chip(struct jz_nand *nand)
+{
+	struct jz_nand_platform_data *pdata = nand->pdata;
+	struct mtd_info *mtd = &nand->mtd;
+	struct nand_chip *chip = &nand->chip;
+
+	mtd->priv	= chip;
+	mtd->owner	= THIS_MODULE;
+	mtd->name	= "jz4740-nand";
+
+	chip->ecc.hwctl		= jz_nand_hwctl;
+	chip->ecc.calculate	= jz_nand_calculate_ecc_rs;
+	chip->ecc.correct	= jz_nand_correct_ecc_rs;
+	chip->ecc.mode		= NAND_ECC_HW_OOB_FIRST;
+	chip->ecc.size		= 512;
+	chip->ecc.bytes		= 9;
+	chip->ecc.strength	= 4;
+
+	if (pdata)
+		chip->ecc.layout = pdata->ecc_layout;
+
+	chip->chip_delay = 50;
+	chip->cmd_ctrl = jz_nand_cmd_ctrl;
+	chip->select_chip = jz_nand_select_chip;
+	chip->read_buf = jz_nand_read_buf;
+	chip->write_buf = jz_nand_write_buf;
+
+	if (pdata && gpio_is_valid(pdata->busy_gpio))
+		chip->dev_ready = jz_nand_dev_ready;
+
+	if (pdata && pdata->cache_ops)
+		chip->options |= NAND_USE_CACHE_OPS;
+
+	if (pdata && pdata->flash_bbt) {
+		nand->bbt_td = jz_nand_bbt_main_descr;
+		nand->bbt_md = jz_nand_bbt_mirror_descr;
+		chip->bbt_td = &nand->bbt_td;
+		chip->bbt_md = &nand->bbt_md;
+		chip->bbt_options |= NAND_BBT_USE_FLASH;
+	}
+}
+
+/* Splits the detected chips into one nand_chip per bank, so nand_base does
+ * not serialize operations on different banks, and concatenates them into a
+ * single mtd again. The banks only contend for the bus while transferring
+ * commands and data, not while they are busy programming or erasing. */
+static int jz_nand_scan_parallel(struct platform_device *pdev,
+	struct jz_nand *nand, size_t numchips)
+{
+	struct mtd_info *mtds[JZ_NAND_NUM_BANKS];
+	struct jz_nand *bank_nand;
+	size_t i;
+	int ret;
+
+	nand->chip.numchips = 1;
+	nand->mtd.size = nand->chip.chipsize;
+	nand->chip.dev_ready = NULL;
+	nand->chip.waitfunc = jz_nand_wait;
+	mtds[0] = &nand->mtd;
+
+	for (i = 1; i < numchips; i++) {
+		bank_nand = kzalloc(sizeof(*bank_nand), GFP_KERNEL);
+		if (!bank_nand) {
+			ret = -ENOMEM;
+			goto err_release;
+		}
+
+		bank_nand->base = nand->base;
+		memcpy(bank_nand->bank_base, nand->bank_base,
+			sizeof(nand->bank_base));
+		memcpy(bank_nand->bank_mem, nand->bank_mem,
+			sizeof(nand->bank_mem));
+		bank_nand->banks[0] = nand->banks[i];
+		bank_nand->pdata = nand->pdata;
+		bank_nand->master = nand;
+		bank_nand->dma_chan = nand->dma_chan;
+		bank_nand->dma_buf = nand->dma_buf;
+		bank_nand->dma_buf_size = nand->dma_buf_size;
+		init_completion(&bank_nand->dma_done);
+
+		jz_nand_init_chip(bank_nand);
+		bank_nand->chip.dev_ready = NULL;
+		bank_nand->chip.waitfunc = jz_nand_wait;
+
+		ret = nand_scan_ident(&bank_nand->mtd, 1, NULL);
+		if (ret) {
+			kfree(bank_nand);
+			goto err_release;
+		}
+		/* Use whatever the board picked for the first bank */
+		bank_nand->chip.ecc.layout = nand->chip.ecc.layout;
+		jz_nand_hook_dma_wait(bank_nand);
+
+		ret = nand_scan_tail(&bank_nand->mtd);
+		if (ret) {
+			kfree(bank_nand);
+			goto err_release;
+		}
+
+		nand->bank_nand[i] = bank_nand;
+		mtds[i] = &bank_nand->mtd;
+	}
+
+	jz_nand_hook_dma_wait(nand);
+	ret = nand_scan_tail(&nand->mtd);
+	if (ret)
+		goto err_release;
+
+	nand->concat = mtd_concat_create(mtds, numchips, "jz4740-nand");
+	if (!nand->concat) {
+		nand_release(&nand->mtd);
+		ret = -ENOMEM;
+		goto err_release;
+	}
+
+	dev_info(&pdev->dev, "Running %zu banks in parallel\n", numchips);
+
+	return 0;
+
+err_release:
+	jz_nand_release_banks(nand);
+	return ret;
+}
+
 static int jz_nand_probe(struct platform_device *pdev)
 {
 	int ret;
@@ -435,29 +912,12 @@ static int jz_nand_probe(struct platform_device *pdev)
 
 	mtd		= &nand->mtd;
 	chip		= &nand->chip;
-	mtd->priv	= chip;
-	mtd->owner	= THIS_MODULE;
-	mtd->name	= "jz4740-nand";
-
-	chip->ecc.hwctl		= jz_nand_hwctl;
-	chip->ecc.calculate	= jz_nand_calculate_ecc_rs;
-	chip->ecc.correct	= jz_nand_correct_ecc_rs;
-	chip->ecc.mode		= NAND_ECC_HW_OOB_FIRST;
-	chip->ecc.size		= 512;
-	chip->ecc.bytes		= 9;
-	chip->ecc.strength	= 4;
-
-	if (pdata)
-		chip->ecc.layout = pdata->ecc_layout;
-
-	chip->chip_delay = 50;
-	chip->cmd_ctrl = jz_nand_cmd_ctrl;
-	chip->select_chip = jz_nand_select_chip;
-
-	if (pdata && gpio_is_valid(pdata->busy_gpio))
-		chip->dev_ready = jz_nand_dev_ready;
 
 	nand->pdata = pdata;
+	nand->master = nand;
+	mutex_init(&nand->bus_lock);
+	jz_nand_init_chip(nand);
+
 	platform_set_drvdata(pdev, nand);
 
 	/* We are going to autodetect NAND chips in the banks specified in the
@@ -504,13 +964,21 @@ static int jz_nand_probe(struct platform_device *pdev)
 					&pdata->num_partitions);
 	}
 
-	ret = nand_scan_tail(mtd);
+	/* The page size is known now, which is needed for the bounce buffer */
+	jz_nand_request_dma(pdev, nand);
+
+	if (pdata && pdata->parallel_banks && chipnr > 1) {
+		ret = jz_nand_scan_parallel(pdev, nand, chipnr);
+	} else {
+		jz_nand_hook_dma_wait(nand);
+		ret = nand_scan_tail(mtd);
+	}
 	if (ret) {
 		dev_err(&pdev->dev,  "Failed to scan NAND\n");
-		goto err_unclaim_banks;
+		goto err_release_dma;
 	}
 
-	ret = mtd_device_parse_register(mtd, NULL, NULL,
+	ret = mtd_device_parse_register(nand->concat ?: mtd, NULL, NULL,
 					pdata ? pdata->partitions : NULL,
 					pdata ? pdata->num_partitions : 0);
 
@@ -524,7 +992,13 @@ static int jz_nand_probe(struct platform_device *pdev)
 	return 0;
 
 err_nand_release:
+	if (nand->concat) {
+		mtd_concat_destroy(nand->concat);
+		jz_nand_release_banks(nand);
+	}
 	nand_release(mtd);
+err_release_dma:
+	jz_nand_release_dma(nand);
 err_unclaim_banks:
 	while (chipnr--) {
 		unsigned char bank = nand->banks[chipnr];
@@ -549,8 +1023,15 @@ static int jz_nand_remove(struct platform_device *pdev)
 	struct jz_nand_platform_data *pdata = dev_get_platdata(&pdev->dev);
 	size_t i;
 
+	if (nand->concat) {
+		mtd_device_unregister(nand->concat);
+		mtd_concat_destroy(nand->concat);
+		jz_nand_release_banks(nand);
+	}
 	nand_release(&nand->mtd);
 
+	jz_nand_release_dma(nand);
+
 	/* Deassert and disable all chips */
 	writel(0, nand->base + JZ_REG_NAND_CTRL);
 
@@ -578,6 +1059,7 @@ static struct platform_driver jz_nand_driver = {
 	.driver = {
 		.name = "jz4740-nand",
 		.owner = THIS_MODULE,
+		.probe_async = true,
 	},
 };
 
@@ -1321,10 +1321,19 @@ static int nand_read_page_hwecc_oob_first(struct mtd_info *mtd,
 	uint8_t *ecc_calc = chip->buffers->ecccalc;
 	unsigned int max_bitflips = 0;
 
-	/* Read the OOB area first */
-	chip->cmdfunc(mtd, NAND_CMD_READOOB, 0, page);
-	chip->read_buf(mtd, chip->oob_poi, mtd->oobsize);
-	chip->cmdfunc(mtd, NAND_CMD_READ0, 0, page);
+	/*
+	 * Read the OOB area first. During a cache read the page is already in
+	 * the cache register, so only change the column.
+	 */
+	if (chip->cache_read) {
+		chip->cmdfunc(mtd, NAND_CMD_RNDOUT, mtd->writesize, -1);
+		chip->read_buf(mtd, chip->oob_poi, mtd->oobsize);
+		chip->cmdfunc(mtd, NAND_CMD_RNDOUT, 0, -1);
+	} else {
+		chip->cmdfunc(mtd, NAND_CMD_READOOB, 0, page);
+		chip->read_buf(mtd, chip->oob_poi, mtd->oobsize);
+		chip->cmdfunc(mtd, NAND_CMD_READ0, 0, page);
+	}
 
 	for (i = 0; i < chip->ecc.total; i++)
 		ecc_code[i] = chip->oob_poi[eccpos[i]];
@@ -1478,6 +1487,33 @@ static int nand_setup_read_retry(struct mtd_info *mtd, int retry_mode)
 	return chip->setup_read_retry(mtd, retry_mode);
 }
 
+/**
+ * nand_cache_read_next - [INTERN] Check if the next page can be cache read
+ * @mtd: MTD device structure
+ * @realpage: the page currently being read
+ * @bytes: number of bytes read from the current page
+ * @readlen: number of bytes left to read, including the current page
+ *
+ * Returns true if the page following @realpage is read as a full page as
+ * part of this request and lives in the same eraseblock, so the chip can fetch
+ * it into its data register while the current page is transferred.
+ */
+static bool nand_cache_read_next(struct mtd_info *mtd, int realpage,
+				 int bytes, uint32_t readlen)
+{
+	struct nand_chip *chip = mtd->priv;
+	int blockmask = (1 << (chip->phys_erase_shift - chip->page_shift)) - 1;
+
+	if (!((realpage + 1) & blockmask))
+		return false;
+
+	if (readlen <= bytes)
+		return false;
+
+	/* A trailing partial page is read with a subpage read */
+	return readlen - bytes >= mtd->writesize || !NAND_HAS_SUBPAGE_READ(chip);
+}
+
 /**
  * nand_do_read_ops - [INTERN] Read data with ECC
  * @mtd: MTD device structure
@@ -1501,6 +1537,12 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 	unsigned int max_bitflips = 0;
 	int retry_mode = 0;
 	bool ecc_fail = false;
+	bool use_cache_read, cache_end;
+
+	/* Read retries need to read the same page again, which does not mix
+	 * with sequential cache reads. */
+	use_cache_read = NAND_USE_CACHERD(chip) && chip->read_retries <= 1 &&
+		mtd->writesize > 512;
 
 	chipnr = (int)(from >> chip->chip_shift);
 	chip->select_chip(mtd, chipnr);
@@ -1520,12 +1562,35 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 		bytes = min(mtd->writesize - col, readlen);
 		aligned = (bytes == mtd->writesize);
 
-		/* Is the current page in the buffer? */
-		if (realpage != chip->pagebuf || oob) {
+		/*
+		 * Is the current page in the buffer? During a cache read the
+		 * chip has already fetched this page, so it has to be read out
+		 * to keep the following pages in step.
+		 */
+		if (realpage != chip->pagebuf || oob || chip->cache_read) {
 			bufpoi = aligned ? buf : chip->buffers->databuf;
 
 read_retry:
-			chip->cmdfunc(mtd, NAND_CMD_READ0, 0x00, page);
+			if (!chip->cache_read)
+				chip->cmdfunc(mtd, NAND_CMD_READ0, 0x00, page);
+
+			/*
+			 * Move the page to the cache register and let the chip
+			 * fetch the next one while this one is transferred.
+			 */
+			cache_end = false;
+			if (use_cache_read) {
+				if (nand_cache_read_next(mtd, realpage, bytes,
+							 readlen)) {
+					chip->cmdfunc(mtd,
+						NAND_CMD_READCACHESEQ, -1, -1);
+					chip->cache_read = 1;
+				} else if (chip->cache_read) {
+					chip->cmdfunc(mtd,
+						NAND_CMD_READCACHEEND, -1, -1);
+					cache_end = true;
+				}
+			}
 
 			/*
 			 * Now read the page into the buffer.  Absent an error,
@@ -1542,6 +1607,8 @@ read_retry:
 			else
 				ret = chip->ecc.read_page(mtd, chip, bufpoi,
 							  oob_required, page);
+			if (cache_end)
+				chip->cache_read = 0;
 			if (ret < 0) {
 				if (!aligned)
 					/* Invalidate page cache */
@@ -1634,6 +1701,13 @@ read_retry:
 			chip->select_chip(mtd, chipnr);
 		}
 	}
+
+	/* Terminate a cache read interrupted by an error */
+	if (chip->cache_read) {
+		chip->cmdfunc(mtd, NAND_CMD_READCACHEEND, -1, -1);
+		chip->cache_read = 0;
+	}
+
 	chip->select_chip(mtd, -1);
 
 	ops->retlen = ops->len - (size_t) readlen;
@@ -2222,12 +2296,15 @@ static int nand_write_page(struct mtd_info *mtd, struct nand_chip *chip,
 		return status;
 
 	/*
-	 * Cached progamming disabled for now. Not sure if it's worth the
-	 * trouble. The speed gain is not very impressive. (2.3->2.6Mib/s).
+	 * Cached programming is only used if the driver asks for it. The
+	 * speed gain depends a lot on the chip (2.3->2.6Mib/s for some).
 	 */
-	cached = 0;
+	if (!cached || !NAND_USE_CACHEPROG(chip)) {
+		int fail_mask = NAND_STATUS_FAIL;
 
-	if (!cached || !NAND_HAS_CACHEPROG(chip)) {
+		/* The previous page may have been a cached program */
+		if (NAND_USE_CACHEPROG(chip))
+			fail_mask |= NAND_STATUS_FAIL_N1;
 
 		chip->cmdfunc(mtd, NAND_CMD_PAGEPROG, -1, -1);
 		status = chip->waitfunc(mtd, chip);
@@ -2235,15 +2312,19 @@ static int nand_write_page(struct mtd_info *mtd, struct nand_chip *chip,
 		 * See if operation failed and additional status checks are
 		 * available.
 		 */
-		if ((status & NAND_STATUS_FAIL) && (chip->errstat))
+		if ((status & fail_mask) && (chip->errstat))
 			status = chip->errstat(mtd, chip, FL_WRITING, status,
 					       page);
 
-		if (status & NAND_STATUS_FAIL)
+		if (status & fail_mask)
 			return -EIO;
 	} else {
 		chip->cmdfunc(mtd, NAND_CMD_CACHEDPROG, -1, -1);
 		status = chip->waitfunc(mtd, chip);
+
+		/* Only the result of the previous page is known by now */
+		if (status & NAND_STATUS_FAIL_N1)
+			return -EIO;
 	}
 
 	return 0;
@@ -3140,6 +3221,12 @@ static int nand_flash_detect_onfi(struct mtd_info *mtd, struct nand_chip *chip,
 	else
 		*busw = 0;
 
+	val = le16_to_cpu(p->opt_cmd);
+	if (val & ONFI_OPT_CMD_PAGE_CACHE_PROG)
+		chip->options |= NAND_CACHEPRG;
+	if (val & ONFI_OPT_CMD_READ_CACHE)
+		chip->options |= NAND_CACHERD;
+
 	if (p->ecc_bits != 0xff) {
 		chip->ecc_strength_ds = p->ecc_bits;
 		chip->ecc_step_ds = 512;
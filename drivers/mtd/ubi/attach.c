@@ -1239,15 +1239,34 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	if (!vidh)
 		goto out_ech;
 
+	/*
+	 * If the VID header sits in the same or the next flash page as the EC
+	 * header, read both of them in one go. This halves the number of
+	 * flash read operations needed to scan a populated device.
+	 */
+	if (ubi->vid_hdr_aloffset <= ubi->hdrs_min_io_size) {
+		ubi->scan_hdr_len = ubi->vid_hdr_aloffset +
+				    ubi->vid_hdr_alsize;
+		ubi->scan_hdr_pnum = -1;
+		ubi->scan_hdr_empty = 0;
+		ubi->scan_hdr_buf = kmalloc(ubi->scan_hdr_len, GFP_KERNEL);
+	}
+
+	err = 0;
 	for (pnum = start; pnum < ubi->peb_count; pnum++) {
 		cond_resched();
 
 		dbg_gen("process PEB %d", pnum);
 		err = scan_peb(ubi, ai, pnum, NULL, NULL);
 		if (err < 0)
-			goto out_vidh;
+			break;
 	}
 
+	kfree(ubi->scan_hdr_buf);
+	ubi->scan_hdr_buf = NULL;
+	if (err < 0)
+		goto out_vidh;
+
 	ubi_msg("scanning is finished");
 
 	/* Calculate mean erase counter */
@@ -117,6 +117,9 @@ static struct class_attribute ubi_version =
 
 static ssize_t dev_attribute_show(struct device *dev,
 				  struct device_attribute *attr, char *buf);
+static ssize_t dev_attribute_store(struct device *dev,
+				   struct device_attribute *attr,
+				   const char *buf, size_t count);
 
 /* UBI device attributes (correspond to files in '/<sysfs>/class/ubi/ubiX') */
 static struct device_attribute dev_eraseblock_size =
@@ -141,6 +144,13 @@ static struct device_attribute dev_bgt_enabled =
 	__ATTR(bgt_enabled, S_IRUGO, dev_attribute_show, NULL);
 static struct device_attribute dev_mtd_num =
 	__ATTR(mtd_num, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_fg_io_bytes =
+	__ATTR(fg_io_bytes, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_bg_io_bytes =
+	__ATTR(bg_io_bytes, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_bg_max_rate =
+	__ATTR(bg_max_rate, S_IRUGO | S_IWUSR, dev_attribute_show,
+	       dev_attribute_store);
 
 /**
  * ubi_volume_notify - send a volume change notification.
@@ -378,6 +388,18 @@ static ssize_t dev_attribute_show(struct device *dev,
 		ret = sprintf(buf, "%d\n", ubi->thread_enabled);
 	else if (attr == &dev_mtd_num)
 		ret = sprintf(buf, "%d\n", ubi->mtd->index);
+	else if (attr == &dev_fg_io_bytes || attr == &dev_bg_io_bytes) {
+		unsigned long long bytes;
+
+		spin_lock(&ubi->io_class_lock);
+		if (attr == &dev_fg_io_bytes)
+			bytes = ubi->fg_io_bytes;
+		else
+			bytes = ubi->bg_io_bytes;
+		spin_unlock(&ubi->io_class_lock);
+		ret = sprintf(buf, "%llu\n", bytes);
+	} else if (attr == &dev_bg_max_rate)
+		ret = sprintf(buf, "%u\n", ubi->bg_max_rate);
 	else
 		ret = -EINVAL;
 
@@ -385,6 +407,40 @@ static ssize_t dev_attribute_show(struct device *dev,
 	return ret;
 }
 
+/*
+ * "Store" method for files in '/<sysfs>/class/ubi/ubiX/'. Only the background
+ * I/O limit in KiB/s is writable, zero means unlimited.
+ */
+static ssize_t dev_attribute_store(struct device *dev,
+				   struct device_attribute *attr,
+				   const char *buf, size_t count)
+{
+	struct ubi_device *ubi;
+	unsigned int val;
+	int err;
+
+	if (attr != &dev_bg_max_rate)
+		return -EINVAL;
+
+	err = kstrtouint(buf, 0, &val);
+	if (err)
+		return err;
+
+	ubi = container_of(dev, struct ubi_device, dev);
+	ubi = ubi_get_device(ubi->ubi_num);
+	if (!ubi)
+		return -ENODEV;
+
+	spin_lock(&ubi->io_class_lock);
+	ubi->bg_max_rate = val;
+	ubi->bg_window_start = jiffies;
+	ubi->bg_window_bytes = 0;
+	spin_unlock(&ubi->io_class_lock);
+
+	ubi_put_device(ubi);
+	return count;
+}
+
 static void dev_release(struct device *dev)
 {
 	struct ubi_device *ubi = container_of(dev, struct ubi_device, dev);
@@ -445,6 +501,15 @@ static int ubi_sysfs_init(struct ubi_device *ubi, int *ref)
 	if (err)
 		return err;
 	err = device_create_file(&ubi->dev, &dev_mtd_num);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_fg_io_bytes);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_bg_io_bytes);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_bg_max_rate);
 	return err;
 }
 
@@ -454,6 +519,9 @@ static int ubi_sysfs_init(struct ubi_device *ubi, int *ref)
  */
 static void ubi_sysfs_close(struct ubi_device *ubi)
 {
+	device_remove_file(&ubi->dev, &dev_bg_max_rate);
+	device_remove_file(&ubi->dev, &dev_bg_io_bytes);
+	device_remove_file(&ubi->dev, &dev_fg_io_bytes);
 	device_remove_file(&ubi->dev, &dev_mtd_num);
 	device_remove_file(&ubi->dev, &dev_bgt_enabled);
 	device_remove_file(&ubi->dev, &dev_min_io_size);
@@ -947,6 +1015,8 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 		ubi->mtd) / 100) * 5, UBI_FM_MAX_POOL_SIZE);
 	if (ubi->fm_pool.max_size < UBI_FM_MIN_POOL_SIZE)
 		ubi->fm_pool.max_size = UBI_FM_MIN_POOL_SIZE;
+	ubi->fm_pool_min_size = ubi->fm_pool.max_size;
+	ubi->fm_last_update = jiffies;
 
 	ubi->fm_wl_pool.max_size = UBI_FM_WL_POOL_SIZE;
 	ubi->fm_disabled = !fm_autoconvert;
@@ -967,6 +1037,9 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 	mutex_init(&ubi->ckvol_mutex);
 	mutex_init(&ubi->device_mutex);
 	spin_lock_init(&ubi->volumes_lock);
+	spin_lock_init(&ubi->io_class_lock);
+	/* jiffies start near wrap, a zero window start is far in the future */
+	ubi->bg_window_start = jiffies;
 	mutex_init(&ubi->fm_mutex);
 	init_rwsem(&ubi->fm_sem);
 
@@ -981,6 +1054,20 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 	if (!ubi->peb_buf)
 		goto out_free;
 
+	ubi->bitflips = vzalloc(sizeof(struct ubi_bitflip_stats) +
+				ubi->peb_count * sizeof(struct ubi_peb_bitflips));
+	if (!ubi->bitflips)
+		goto out_free;
+	spin_lock_init(&ubi->bitflips->lock);
+	/*
+	 * MTD already returns -EUCLEAN at the bitflip threshold, so scrub
+	 * one corrected bitflip earlier to move the data while every ECC
+	 * step still has margin left.
+	 */
+	ubi->bitflip_scrub = mtd->bitflip_threshold;
+	if (ubi->bitflip_scrub > 1)
+		ubi->bitflip_scrub -= 1;
+
 #ifdef CONFIG_MTD_UBI_FASTMAP
 	ubi->fm_size = ubi_calc_fm_size(ubi);
 	ubi->fm_buf = vzalloc(ubi->fm_size);
@@ -1058,6 +1145,7 @@ out_detach:
 	ubi_free_internal_volumes(ubi);
 	vfree(ubi->vtbl);
 out_free:
+	vfree(ubi->bitflips);
 	vfree(ubi->peb_buf);
 	vfree(ubi->fm_buf);
 	if (ref)
@@ -1134,6 +1222,7 @@ int ubi_detach_mtd_dev(int ubi_num, int anyway)
 	ubi_free_internal_volumes(ubi);
 	vfree(ubi->vtbl);
 	put_mtd_device(ubi->mtd);
+	vfree(ubi->bitflips);
 	vfree(ubi->peb_buf);
 	vfree(ubi->fm_buf);
 	ubi_msg("mtd%d is detached from ubi%d", ubi->mtd->index, ubi->ubi_num);
@@ -1254,6 +1343,12 @@ static int __init ubi_init(void)
 	if (err)
 		goto out_slab;
 
+	/*
+	 * MTD drivers may be probed asynchronously, make sure the devices
+	 * given on the command line had a chance to show up.
+	 */
+	if (mtd_devs)
+		wait_for_device_probe();
 
 	/* Attach MTD devices */
 	for (i = 0; i < mtd_devs; i++) {
@@ -1298,6 +1393,15 @@ static int __init ubi_init(void)
 		}
 	}
 
+	err = ubiblock_init();
+	if (err) {
+		ubi_err("block: cannot initialize, error %d", err);
+
+		/* See comment above re-ubi_is_module(). */
+		if (ubi_is_module())
+			goto out_detach;
+	}
+
 	return 0;
 
 out_detach:
@@ -1326,6 +1430,8 @@ static void __exit ubi_exit(void)
 {
 	int i;
 
+	ubiblock_exit();
+
 	for (i = 0; i < UBI_MAX_DEVICES; i++)
 		if (ubi_devices[i]) {
 			mutex_lock(&ubi_devices_mutex);
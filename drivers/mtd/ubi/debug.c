@@ -20,6 +20,7 @@
 
 #include "ubi.h"
 #include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/uaccess.h>
 #include <linux/module.h>
 
@@ -359,6 +360,56 @@ static const struct file_operations dfs_fops = {
 	.owner  = THIS_MODULE,
 };
 
+/* Show the corrected bitflip statistics of an UBI device */
+static int dfs_bitflips_show(struct seq_file *s, void *unused)
+{
+	unsigned long ubi_num = (unsigned long)s->private;
+	struct ubi_bitflip_stats *bf;
+	struct ubi_device *ubi;
+	int i;
+
+	ubi = ubi_get_device(ubi_num);
+	if (!ubi)
+		return -ENODEV;
+	bf = ubi->bitflips;
+
+	seq_printf(s, "scrub level: %u\n", ubi->bitflip_scrub);
+	seq_puts(s, "bitflips      reads\n");
+	spin_lock(&bf->lock);
+	for (i = 0; i < UBI_BITFLIP_HIST_SIZE; i++)
+		seq_printf(s, "%7d%s %10lu\n", i + 1,
+			   i == UBI_BITFLIP_HIST_SIZE - 1 ? "+" : " ",
+			   bf->hist[i]);
+	spin_unlock(&bf->lock);
+
+	seq_puts(s, "\n    PEB  max reads\n");
+	for (i = 0; i < ubi->peb_count; i++) {
+		struct ubi_peb_bitflips peb;
+
+		spin_lock(&bf->lock);
+		peb = bf->peb[i];
+		spin_unlock(&bf->lock);
+		if (peb.reads)
+			seq_printf(s, "%7d %4u %5u\n", i, peb.max, peb.reads);
+	}
+
+	ubi_put_device(ubi);
+	return 0;
+}
+
+static int dfs_bitflips_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dfs_bitflips_show, inode->i_private);
+}
+
+static const struct file_operations dfs_bitflips_fops = {
+	.open    = dfs_bitflips_open,
+	.read    = seq_read,
+	.llseek  = seq_lseek,
+	.release = single_release,
+	.owner   = THIS_MODULE,
+};
+
 /**
  * ubi_debugfs_init_dev - initialize debugfs for an UBI device.
  * @ubi: UBI device description object
@@ -427,6 +478,20 @@ int ubi_debugfs_init_dev(struct ubi_device *ubi)
 		goto out_remove;
 	d->dfs_emulate_io_failures = dent;
 
+	fname = "bitflips";
+	dent = debugfs_create_file(fname, S_IRUSR, d->dfs_dir, (void *)ubi_num,
+				   &dfs_bitflips_fops);
+	if (IS_ERR_OR_NULL(dent))
+		goto out_remove;
+	d->dfs_bitflips = dent;
+
+	fname = "bitflip_scrub";
+	dent = debugfs_create_u32(fname, S_IRUSR | S_IWUSR, d->dfs_dir,
+				  &ubi->bitflip_scrub);
+	if (IS_ERR_OR_NULL(dent))
+		goto out_remove;
+	d->dfs_bitflip_scrub = dent;
+
 	return 0;
 
 out_remove:
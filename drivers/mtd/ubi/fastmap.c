@@ -14,8 +14,16 @@
  */
 
 #include <linux/crc32.h>
+#include <linux/jiffies.h>
 #include "ubi.h"
 
+/*
+ * The user pool is grown if it runs empty sooner than this after the last
+ * fastmap update, and shrunk if it lasts longer than UBI_FM_POOL_SHRINK_TIME.
+ */
+#define UBI_FM_POOL_GROW_TIME	(30 * HZ)
+#define UBI_FM_POOL_SHRINK_TIME	(600 * HZ)
+
 /**
  * ubi_calc_fm_size - calculates the fastmap size in bytes for an UBI device.
  * @ubi: UBI device description object
@@ -1397,6 +1405,38 @@ static int invalidate_fastmap(struct ubi_device *ubi,
 	return ret;
 }
 
+/**
+ * tune_pool_size - adapt the size of the user pool to the write rate.
+ * @ubi: UBI device object
+ *
+ * A new fastmap has to be written whenever the user pool runs empty, so a
+ * bigger pool means fewer fastmap writes under heavy writing. But all PEBs
+ * of the pool have to be scanned at attach time, so the pool is shrunk back
+ * again once writing calms down.
+ */
+static void tune_pool_size(struct ubi_device *ubi)
+{
+	struct ubi_fm_pool *pool = &ubi->fm_pool;
+	unsigned long now = jiffies;
+	int max_size = pool->max_size;
+
+	if (pool->size && pool->used == pool->size) {
+		if (time_before(now, ubi->fm_last_update +
+				UBI_FM_POOL_GROW_TIME))
+			max_size = min(max_size * 2, UBI_FM_MAX_POOL_SIZE);
+		else if (time_after(now, ubi->fm_last_update +
+				    UBI_FM_POOL_SHRINK_TIME))
+			max_size = max(max_size / 2, ubi->fm_pool_min_size);
+	}
+
+	if (max_size != pool->max_size) {
+		dbg_bld("fastmap pool size %d -> %d", pool->max_size, max_size);
+		pool->max_size = max_size;
+	}
+
+	ubi->fm_last_update = now;
+}
+
 /**
  * ubi_update_fastmap - will be called by UBI if a volume changes or
  * a fastmap pool becomes full.
@@ -1412,6 +1452,7 @@ int ubi_update_fastmap(struct ubi_device *ubi)
 
 	mutex_lock(&ubi->fm_mutex);
 
+	tune_pool_size(ubi);
 	ubi_refill_pools(ubi);
 
 	if (ubi->ro_mode || ubi->fm_disabled) {
@@ -91,6 +91,9 @@
 #include <linux/slab.h>
 #include "ubi.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/ubi.h>
+
 static int self_check_not_bad(const struct ubi_device *ubi, int pnum);
 static int self_check_peb_ec_hdr(const struct ubi_device *ubi, int pnum);
 static int self_check_ec_hdr(const struct ubi_device *ubi, int pnum,
@@ -101,6 +104,36 @@ static int self_check_vid_hdr(const struct ubi_device *ubi, int pnum,
 static int self_check_write(struct ubi_device *ubi, const void *buf, int pnum,
 			    int offset, int len);
 
+/**
+ * account_bitflips - account the bitflips corrected by a read.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock which was read
+ * @bitflips: most bitflips corrected in one ECC step of the read
+ *
+ * Bitflips are counted per ECC step, like the MTD bitflip threshold, so that
+ * long reads do not look worse than short ones. Returns non-zero if @pnum
+ * should be scrubbed.
+ */
+static int account_bitflips(const struct ubi_device *ubi, int pnum,
+			    unsigned int bitflips)
+{
+	struct ubi_bitflip_stats *bf = ubi->bitflips;
+	struct ubi_peb_bitflips *peb;
+
+	if (!bitflips || !bf)
+		return 0;
+
+	spin_lock(&bf->lock);
+	bf->hist[min_t(unsigned int, bitflips, UBI_BITFLIP_HIST_SIZE) - 1] += 1;
+	peb = &bf->peb[pnum];
+	peb->max = max_t(unsigned int, peb->max, min(bitflips, 255U));
+	if (peb->reads < 255)
+		peb->reads += 1;
+	spin_unlock(&bf->lock);
+
+	return ubi->bitflip_scrub && bitflips >= ubi->bitflip_scrub;
+}
+
 /**
  * ubi_io_read - read data from a physical eraseblock.
  * @ubi: UBI device description object
@@ -116,7 +149,10 @@ static int self_check_write(struct ubi_device *ubi, const void *buf, int pnum,
  * o %0 if all the requested data were successfully read;
  * o %UBI_IO_BITFLIPS if all the requested data were successfully read, but
  *   correctable bit-flips were detected; this is harmless but may indicate
- *   that this eraseblock may become bad soon (but do not have to);
+ *   that this eraseblock may become bad soon (but do not have to). This is
+ *   also returned once the bitflips corrected in one ECC step of the read
+ *   reach @ubi->bitflip_scrub, so that the PEB gets scrubbed in the background
+ *   before its reads start failing;
  * o %-EBADMSG if the MTD subsystem reported about data integrity problems, for
  *   example it can be an ECC error in case of NAND; this most probably means
  *   that the data is corrupted;
@@ -126,9 +162,11 @@ static int self_check_write(struct ubi_device *ubi, const void *buf, int pnum,
 int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 		int len)
 {
-	int err, retries = 0;
+	int err, scrub = 0, retries = 0;
+	unsigned int bitflips;
 	size_t read;
 	loff_t addr;
+	ktime_t start;
 
 	dbg_io("read %d bytes from PEB %d:%d", len, pnum, offset);
 
@@ -164,7 +202,11 @@ int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 
 	addr = (loff_t)pnum * ubi->peb_size + offset;
 retry:
-	err = mtd_read(ubi->mtd, addr, len, &read, buf);
+	start = ktime_get();
+	err = mtd_read_bitflips(ubi->mtd, addr, len, &read, buf, &bitflips);
+	trace_ubi_io_read(ubi->ubi_num, pnum, offset, len, err, start);
+	if (!mtd_is_eccerr(err))
+		scrub = account_bitflips(ubi, pnum, bitflips);
 	if (err) {
 		const char *errstr = mtd_is_eccerr(err) ? " (ECC error)" : "";
 
@@ -205,6 +247,12 @@ retry:
 	} else {
 		ubi_assert(len == read);
 
+		if (scrub) {
+			dbg_io("bit-flips reached the scrubbing level in PEB %d",
+			       pnum);
+			err = UBI_IO_BITFLIPS;
+		}
+
 		if (ubi_dbg_is_bitflip(ubi)) {
 			dbg_gen("bit-flip (emulated)");
 			err = UBI_IO_BITFLIPS;
@@ -237,6 +285,7 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 	int err;
 	size_t written;
 	loff_t addr;
+	ktime_t start;
 
 	dbg_io("write %d bytes to PEB %d:%d", len, pnum, offset);
 
@@ -280,7 +329,9 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 	}
 
 	addr = (loff_t)pnum * ubi->peb_size + offset;
+	start = ktime_get();
 	err = mtd_write(ubi->mtd, addr, len, &written, buf);
+	trace_ubi_io_write(ubi->ubi_num, pnum, offset, len, err, start);
 	if (err) {
 		ubi_err("error %d while writing %d bytes to PEB %d:%d, written %zd bytes",
 			err, len, pnum, offset, written);
@@ -333,6 +384,7 @@ static int do_sync_erase(struct ubi_device *ubi, int pnum)
 	int err, retries = 0;
 	struct erase_info ei;
 	wait_queue_head_t wq;
+	ktime_t start;
 
 	dbg_io("erase PEB %d", pnum);
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
@@ -352,8 +404,10 @@ retry:
 	ei.callback = erase_callback;
 	ei.priv     = (unsigned long)&wq;
 
+	start = ktime_get();
 	err = mtd_erase(ubi->mtd, &ei);
 	if (err) {
+		trace_ubi_io_erase(ubi->ubi_num, pnum, err, start);
 		if (retries++ < UBI_IO_RETRIES) {
 			ubi_warn("error %d while erasing PEB %d, retry",
 				 err, pnum);
@@ -372,6 +426,9 @@ retry:
 		return -EINTR;
 	}
 
+	trace_ubi_io_erase(ubi->ubi_num, pnum,
+			   ei.state == MTD_ERASE_FAILED ? -EIO : 0, start);
+
 	if (ei.state == MTD_ERASE_FAILED) {
 		if (retries++ < UBI_IO_RETRIES) {
 			ubi_warn("error while erasing PEB %d, retry", pnum);
@@ -594,6 +651,13 @@ int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture)
 	if (err)
 		return err;
 
+	if (ubi->bitflips) {
+		spin_lock(&ubi->bitflips->lock);
+		memset(&ubi->bitflips->peb[pnum], 0,
+		       sizeof(struct ubi_peb_bitflips));
+		spin_unlock(&ubi->bitflips->lock);
+	}
+
 	return ret + 1;
 }
 
@@ -705,6 +769,51 @@ bad:
 	return 1;
 }
 
+/**
+ * read_hdr - read a UBI header, possibly from the scanning header buffer.
+ * @ubi: UBI device description object
+ * @buf: buffer where to store the read data
+ * @pnum: physical eraseblock number to read from
+ * @offset: offset within the physical eraseblock from where to read
+ * @len: how many bytes to read
+ *
+ * While the device is being scanned, @ubi->scan_hdr_buf is set and reading
+ * the EC header fetches the VID header along with it, so that the following
+ * VID header read costs no flash access. Only a clean read is buffered; if
+ * the combined read returns bit-flips or an error, the caller's own region is
+ * read again with 'ubi_io_read()' so that it sees exactly the same return
+ * codes as without the buffer. Right after an empty PEB the VID header is not
+ * fetched, because empty PEBs usually come in runs and have no VID header.
+ * Returns the same codes as 'ubi_io_read()'.
+ */
+static int read_hdr(struct ubi_device *ubi, void *buf, int pnum, int offset,
+		    int len)
+{
+	int err;
+
+	if (!ubi->scan_hdr_buf)
+		return ubi_io_read(ubi, buf, pnum, offset, len);
+
+	if (offset)
+		ubi->scan_hdr_empty = 0;
+
+	if (ubi->scan_hdr_pnum != pnum) {
+		ubi->scan_hdr_pnum = -1;
+		if (offset || ubi->scan_hdr_empty)
+			return ubi_io_read(ubi, buf, pnum, offset, len);
+
+		err = ubi_io_read(ubi, ubi->scan_hdr_buf, pnum, 0,
+				  ubi->scan_hdr_len);
+		if (err)
+			return ubi_io_read(ubi, buf, pnum, offset, len);
+		ubi->scan_hdr_pnum = pnum;
+	}
+
+	ubi_assert(offset + len <= ubi->scan_hdr_len);
+	memcpy(buf, ubi->scan_hdr_buf + offset, len);
+	return 0;
+}
+
 /**
  * ubi_io_read_ec_hdr - read and check an erase counter header.
  * @ubi: UBI device description object
@@ -736,7 +845,7 @@ int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 	dbg_io("read EC header from PEB %d", pnum);
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
 
-	read_err = ubi_io_read(ubi, ec_hdr, pnum, 0, UBI_EC_HDR_SIZE);
+	read_err = read_hdr(ubi, ec_hdr, pnum, 0, UBI_EC_HDR_SIZE);
 	if (read_err) {
 		if (read_err != UBI_IO_BITFLIPS && !mtd_is_eccerr(read_err))
 			return read_err;
@@ -769,6 +878,8 @@ int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 					 pnum);
 			dbg_bld("no EC header found at PEB %d, only 0xFF bytes",
 				pnum);
+			if (ubi->scan_hdr_buf)
+				ubi->scan_hdr_empty = 1;
 			if (!read_err)
 				return UBI_IO_FF;
 			else
@@ -1008,8 +1119,8 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 	ubi_assert(pnum >= 0 &&  pnum < ubi->peb_count);
 
 	p = (char *)vid_hdr - ubi->vid_hdr_shift;
-	read_err = ubi_io_read(ubi, p, pnum, ubi->vid_hdr_aloffset,
-			  ubi->vid_hdr_alsize);
+	read_err = read_hdr(ubi, p, pnum, ubi->vid_hdr_aloffset,
+			    ubi->vid_hdr_alsize);
 	if (read_err && read_err != UBI_IO_BITFLIPS && !mtd_is_eccerr(read_err))
 		return read_err;
 
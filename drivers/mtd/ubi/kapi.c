@@ -25,6 +25,7 @@
 #include <linux/slab.h>
 #include <linux/namei.h>
 #include <linux/fs.h>
+#include <linux/ioprio.h>
 #include <asm/div64.h>
 #include "ubi.h"
 
@@ -682,6 +683,50 @@ int ubi_is_mapped(struct ubi_volume_desc *desc, int lnum)
 }
 EXPORT_SYMBOL_GPL(ubi_is_mapped);
 
+/**
+ * ubi_io_busy - check for recent foreground I/O.
+ * @desc: volume descriptor
+ *
+ * Returns non-zero if there was foreground I/O on the UBI device of @desc
+ * within the last %UBI_FG_IO_QUIET milliseconds. Users with background work
+ * of their own, like UBIFS garbage collection, put it off while this is the
+ * case. See 'ubi_io_background()' for what is foreground I/O.
+ */
+int ubi_io_busy(struct ubi_volume_desc *desc)
+{
+	return ubi_io_fg_recent(desc->vol->ubi);
+}
+EXPORT_SYMBOL_GPL(ubi_io_busy);
+
+/**
+ * ubi_io_throttle - apply the background I/O limit to the current task.
+ * @desc: volume descriptor
+ *
+ * Background tasks are held back here while the background I/O on the UBI
+ * device of @desc is over the "bg_max_rate" limit. Users call this before
+ * reading or writing on behalf of a task, at a point where they hold no locks
+ * which other tasks' I/O may need.
+ */
+void ubi_io_throttle(struct ubi_volume_desc *desc)
+{
+	ubi_io_bg_throttle(desc->vol->ubi);
+}
+EXPORT_SYMBOL_GPL(ubi_io_throttle);
+
+/**
+ * ubi_io_set_background - make the current task's UBI I/O background I/O.
+ *
+ * Meant for kernel threads doing background work, like the UBIFS background
+ * thread. The task is put into the idle I/O scheduling class.
+ */
+void ubi_io_set_background(void)
+{
+#ifdef CONFIG_BLOCK
+	set_task_ioprio(current, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0));
+#endif
+}
+EXPORT_SYMBOL_GPL(ubi_io_set_background);
+
 /**
  * ubi_sync - synchronize UBI device buffers.
  * @ubi_num: UBI device to synchronize
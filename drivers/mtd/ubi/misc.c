@@ -20,6 +20,9 @@
 
 /* Here we keep miscellaneous functions which are used all over the UBI code */
 
+#include <linux/blkdev.h>
+#include <linux/freezer.h>
+#include <linux/ioprio.h>
 #include "ubi.h"
 
 /**
@@ -151,3 +154,96 @@ int ubi_check_pattern(const void *buf, uint8_t patt, int size)
 			return 0;
 	return 1;
 }
+
+/**
+ * ubi_io_background - check whether the current task does background I/O.
+ * @ubi: UBI device description object
+ *
+ * Flash I/O does not go through the block layer, so neither the I/O
+ * scheduler nor the blkio controller ever see it. Instead, I/O done by the
+ * UBI background thread, by tasks in the idle I/O scheduling class and by
+ * tasks in a blkio cgroup weighted below the default is background I/O. It
+ * gives way to all other, foreground, I/O.
+ */
+bool ubi_io_background(const struct ubi_device *ubi)
+{
+	struct io_context *ioc = current->io_context;
+	int class;
+
+	if (current == ubi->bgt_thread)
+		return true;
+
+	if (ioc && ioprio_valid(ioc->ioprio))
+		class = IOPRIO_PRIO_CLASS(ioc->ioprio);
+	else
+		class = task_nice_ioclass(current);
+	if (class == IOPRIO_CLASS_IDLE)
+		return true;
+
+	return blkcg_task_low_weight(current);
+}
+
+/**
+ * ubi_io_account - account volume I/O to the class of the current task.
+ * @ubi: UBI device description object
+ * @len: number of bytes read or written
+ */
+void ubi_io_account(struct ubi_device *ubi, int len)
+{
+	bool background = ubi_io_background(ubi);
+
+	spin_lock(&ubi->io_class_lock);
+	if (background) {
+		ubi->bg_io_bytes += len;
+		ubi->bg_window_bytes += len;
+	} else {
+		ubi->fg_io_bytes += len;
+		ubi->fg_io_stamp = jiffies;
+	}
+	spin_unlock(&ubi->io_class_lock);
+}
+
+/**
+ * ubi_io_fg_recent - check for recent foreground I/O.
+ * @ubi: UBI device description object
+ *
+ * Returns %true if there was foreground I/O within the last
+ * %UBI_FG_IO_QUIET milliseconds, in which case background work should wait.
+ */
+bool ubi_io_fg_recent(struct ubi_device *ubi)
+{
+	unsigned long stamp = ACCESS_ONCE(ubi->fg_io_stamp);
+
+	return time_in_range(jiffies, stamp,
+			     stamp + msecs_to_jiffies(UBI_FG_IO_QUIET));
+}
+
+/**
+ * ubi_io_bg_throttle - enforce the background I/O limit.
+ * @ubi: UBI device description object
+ *
+ * If the current task does background I/O and the background I/O in the
+ * current one second window already reached the "bg_max_rate" limit, this
+ * function sleeps until the window ends. The sleep does not hold up the
+ * freezer. Must not be called with locks held which foreground I/O may need.
+ */
+void ubi_io_bg_throttle(struct ubi_device *ubi)
+{
+	unsigned long wait = 0;
+
+	if (!ACCESS_ONCE(ubi->bg_max_rate) || !ubi_io_background(ubi))
+		return;
+
+	spin_lock(&ubi->io_class_lock);
+	if (time_after_eq(jiffies, ubi->bg_window_start + HZ)) {
+		ubi->bg_window_start = jiffies;
+		ubi->bg_window_bytes = 0;
+	} else if (ubi->bg_window_bytes >= ubi->bg_max_rate * 1024ULL) {
+		wait = ubi->bg_window_start + HZ - jiffies;
+	}
+	spin_unlock(&ubi->io_class_lock);
+
+	if (wait)
+		freezable_schedule_timeout_killable(min_t(unsigned long,
+							  wait, HZ));
+}
@@ -73,6 +73,9 @@
  */
 #define UBI_IO_RETRIES 3
 
+/* Buckets of the corrected bitflips per read histogram, the last one is open */
+#define UBI_BITFLIP_HIST_SIZE 8
+
 /*
  * Length of the protection queue. The length is effectively equivalent to the
  * number of (global) erase cycles PEBs are protected from the wear-leveling
@@ -80,6 +83,14 @@
  */
 #define UBI_PROT_QUEUE_LEN 10
 
+/*
+ * Foreground I/O less than this many milliseconds ago makes background work
+ * wait, but wear-leveling is not put off for longer than UBI_BG_MAX_DEFER
+ * milliseconds at a time.
+ */
+#define UBI_FG_IO_QUIET 100
+#define UBI_BG_MAX_DEFER 5000
+
 /* The volume ID/LEB number/erase counter is unknown */
 #define UBI_UNKNOWN -1
 
@@ -347,6 +358,31 @@ struct ubi_volume_desc {
 
 struct ubi_wl_entry;
 
+/**
+ * struct ubi_peb_bitflips - corrected bitflips seen on one PEB.
+ * @max: highest number of bitflips corrected in one ECC step of a read
+ * @reads: number of reads which needed correction
+ *
+ * Both counters saturate and are cleared when the PEB is erased.
+ */
+struct ubi_peb_bitflips {
+	uint8_t max;
+	uint8_t reads;
+};
+
+/**
+ * struct ubi_bitflip_stats - corrected bitflip statistics of an UBI device.
+ * @lock: protects the statistics
+ * @hist: number of reads by the most bitflips corrected in one of their ECC
+ *        steps, starting with 1
+ * @peb: per-PEB statistics
+ */
+struct ubi_bitflip_stats {
+	spinlock_t lock;
+	unsigned long hist[UBI_BITFLIP_HIST_SIZE];
+	struct ubi_peb_bitflips peb[];
+};
+
 /**
  * struct ubi_debug_info - debugging information for an UBI device.
  *
@@ -362,6 +398,8 @@ struct ubi_wl_entry;
  * @dfs_disable_bgt: debugfs knob to disable the background task
  * @dfs_emulate_bitflips: debugfs knob to emulate bit-flips
  * @dfs_emulate_io_failures: debugfs knob to emulate write/erase failures
+ * @dfs_bitflips: debugfs file with the corrected bitflip statistics
+ * @dfs_bitflip_scrub: debugfs knob for the proactive scrubbing level
  */
 struct ubi_debug_info {
 	unsigned int chk_gen:1;
@@ -376,6 +414,8 @@ struct ubi_debug_info {
 	struct dentry *dfs_disable_bgt;
 	struct dentry *dfs_emulate_bitflips;
 	struct dentry *dfs_emulate_io_failures;
+	struct dentry *dfs_bitflips;
+	struct dentry *dfs_bitflip_scrub;
 };
 
 /**
@@ -421,6 +461,8 @@ struct ubi_debug_info {
  * @fm_pool: in-memory data structure of the fastmap pool
  * @fm_wl_pool: in-memory data structure of the fastmap pool used by the WL
  *		sub-system
+ * @fm_pool_min_size: the size @fm_pool is never shrunk below
+ * @fm_last_update: time of the last fastmap update, in jiffies
  * @fm_mutex: serializes ubi_update_fastmap() and protects @fm_buf
  * @fm_buf: vmalloc()'d buffer which holds the raw fastmap
  * @fm_size: fastmap size in bytes
@@ -452,6 +494,14 @@ struct ubi_debug_info {
  * @thread_enabled: if the background thread is enabled
  * @bgt_name: background thread name
  *
+ * @io_class_lock: protects the I/O class fields below, see 'ubi_io_account()'
+ * @fg_io_bytes: bytes read and written by foreground tasks
+ * @bg_io_bytes: bytes read and written by background tasks
+ * @fg_io_stamp: time of the last foreground I/O, in jiffies
+ * @bg_max_rate: background I/O limit in KiB/s, zero if unlimited
+ * @bg_window_start: start of the current background I/O limit window
+ * @bg_window_bytes: background I/O done in the current window
+ *
  * @flash_size: underlying MTD device size (in bytes)
  * @peb_count: count of physical eraseblocks on the MTD device
  * @peb_size: physical eraseblock size
@@ -484,8 +534,19 @@ struct ubi_debug_info {
  *
  * @peb_buf: a buffer of PEB size used for different purposes
  * @buf_mutex: protects @peb_buf
+ * @scan_hdr_buf: buffer for the EC and VID headers of the PEB being scanned,
+ *                only allocated during full scanning
+ * @scan_hdr_len: size of @scan_hdr_buf
+ * @scan_hdr_pnum: PEB whose headers are in @scan_hdr_buf, %-1 if none
+ * @scan_hdr_empty: the last scanned PEB was empty
  * @ckvol_mutex: serializes static volume checking when opening
  *
+ * @bitflips: corrected bitflip statistics
+ * @bitflip_scrub: have a PEB scrubbed once a read of it needed this many
+ *                 bitflips corrected in one ECC step, even if the MTD layer
+ *                 did not report the read as %-EUCLEAN (%0 to disable);
+ *                 defaults to one below the MTD bitflip threshold
+ *
  * @dbg: debugging information for this UBI device
  */
 struct ubi_device {
@@ -526,6 +587,8 @@ struct ubi_device {
 	struct ubi_fastmap_layout *fm;
 	struct ubi_fm_pool fm_pool;
 	struct ubi_fm_pool fm_wl_pool;
+	int fm_pool_min_size;
+	unsigned long fm_last_update;
 	struct rw_semaphore fm_sem;
 	struct mutex fm_mutex;
 	void *fm_buf;
@@ -554,6 +617,15 @@ struct ubi_device {
 	int thread_enabled;
 	char bgt_name[sizeof(UBI_BGT_NAME_PATTERN)+2];
 
+	/* I/O classes */
+	spinlock_t io_class_lock;
+	unsigned long long fg_io_bytes;
+	unsigned long long bg_io_bytes;
+	unsigned long fg_io_stamp;
+	unsigned int bg_max_rate;
+	unsigned long bg_window_start;
+	unsigned long long bg_window_bytes;
+
 	/* I/O sub-system's stuff */
 	long long flash_size;
 	int peb_count;
@@ -580,8 +652,15 @@ struct ubi_device {
 
 	void *peb_buf;
 	struct mutex buf_mutex;
+	void *scan_hdr_buf;
+	int scan_hdr_len;
+	int scan_hdr_pnum;
+	int scan_hdr_empty;
 	struct mutex ckvol_mutex;
 
+	struct ubi_bitflip_stats *bitflips;
+	u32 bitflip_scrub;
+
 	struct ubi_debug_info dbg;
 };
 
@@ -782,6 +861,10 @@ int ubi_check_volume(struct ubi_device *ubi, int vol_id);
 void ubi_update_reserved(struct ubi_device *ubi);
 void ubi_calculate_reserved(struct ubi_device *ubi);
 int ubi_check_pattern(const void *buf, uint8_t patt, int size);
+bool ubi_io_background(const struct ubi_device *ubi);
+void ubi_io_account(struct ubi_device *ubi, int len);
+bool ubi_io_fg_recent(struct ubi_device *ubi);
+void ubi_io_bg_throttle(struct ubi_device *ubi);
 
 /* eba.c */
 int ubi_eba_unmap_leb(struct ubi_device *ubi, struct ubi_volume *vol,
@@ -853,6 +936,25 @@ void ubi_free_internal_volumes(struct ubi_device *ubi);
 void ubi_do_get_device_info(struct ubi_device *ubi, struct ubi_device_info *di);
 void ubi_do_get_volume_info(struct ubi_device *ubi, struct ubi_volume *vol,
 			    struct ubi_volume_info *vi);
+/* block.c */
+#ifdef CONFIG_MTD_UBI_BLOCK
+int ubiblock_init(void);
+void ubiblock_exit(void);
+int ubiblock_create(struct ubi_volume_info *vi);
+int ubiblock_remove(struct ubi_volume_info *vi);
+#else
+static inline int ubiblock_init(void) { return 0; }
+static inline void ubiblock_exit(void) {}
+static inline int ubiblock_create(struct ubi_volume_info *vi)
+{
+	return -ENOSYS;
+}
+static inline int ubiblock_remove(struct ubi_volume_info *vi)
+{
+	return -ENOSYS;
+}
+#endif
+
 /* scan.c */
 int ubi_compare_lebs(struct ubi_device *ubi, const struct ubi_ainf_peb *aeb,
 		      int pnum, const struct ubi_vid_hdr *vid_hdr);
@@ -102,6 +102,7 @@
 #include <linux/crc32.h>
 #include <linux/freezer.h>
 #include <linux/kthread.h>
+#include <trace/events/ubi.h>
 #include "ubi.h"
 
 /* Number of physical eraseblocks reserved for wear-leveling purposes */
@@ -824,18 +825,33 @@ repeat:
 	spin_unlock(&ubi->wl_lock);
 }
 
+static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
+			int cancel);
+
 /**
  * __schedule_ubi_work - schedule a work.
  * @ubi: UBI device description object
  * @wrk: the work to schedule
  *
  * This function adds a work defined by @wrk to the tail of the pending works
- * list. Can only be used of ubi->work_sem is already held in read mode!
+ * list. Erase works are queued in front of all other works though: they are
+ * quick and they are what produces free PEBs, so a writer waiting in
+ * 'produce_free_peb()' should not have to wait for a wear-leveling copy to
+ * finish first. Erase works themselves are still done in FIFO order. Can only
+ * be used of ubi->work_sem is already held in read mode!
  */
 static void __schedule_ubi_work(struct ubi_device *ubi, struct ubi_work *wrk)
 {
+	struct list_head *pos = &ubi->works;
+
 	spin_lock(&ubi->wl_lock);
-	list_add_tail(&wrk->list, &ubi->works);
+	if (wrk->func == erase_worker) {
+		list_for_each(pos, &ubi->works)
+			if (list_entry(pos, struct ubi_work, list)->func !=
+			    erase_worker)
+				break;
+	}
+	list_add_tail(&wrk->list, pos);
 	ubi_assert(ubi->works_count >= 0);
 	ubi->works_count += 1;
 	if (ubi->thread_enabled && !ubi_dbg_is_bgt_disabled(ubi))
@@ -848,8 +864,8 @@ static void __schedule_ubi_work(struct ubi_device *ubi, struct ubi_work *wrk)
  * @ubi: UBI device description object
  * @wrk: the work to schedule
  *
- * This function adds a work defined by @wrk to the tail of the pending works
- * list.
+ * This function adds a work defined by @wrk to the pending works list, see
+ * '__schedule_ubi_work()'.
  */
 static void schedule_ubi_work(struct ubi_device *ubi, struct ubi_work *wrk)
 {
@@ -858,9 +874,6 @@ static void schedule_ubi_work(struct ubi_device *ubi, struct ubi_work *wrk)
 	up_read(&ubi->work_sem);
 }
 
-static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
-			int cancel);
-
 #ifdef CONFIG_MTD_UBI_FASTMAP
 /**
  * ubi_is_erase_work - checks whether a work is erase work.
@@ -1048,6 +1061,8 @@ static int wear_leveling_worker(struct ubi_device *ubi, struct ubi_work *wrk,
 		self_check_in_wl_tree(ubi, e1, &ubi->used);
 		rb_erase(&e1->u.rb, &ubi->used);
 		dbg_wl("anchor-move PEB %d to PEB %d", e1->pnum, e2->pnum);
+		trace_ubi_wl_move(ubi->ubi_num, "anchor", e1->pnum, e1->ec,
+				  e2->pnum, e2->ec);
 	} else if (!ubi->scrub.rb_node) {
 #else
 	if (!ubi->scrub.rb_node) {
@@ -1074,6 +1089,8 @@ static int wear_leveling_worker(struct ubi_device *ubi, struct ubi_work *wrk,
 		rb_erase(&e1->u.rb, &ubi->used);
 		dbg_wl("move PEB %d EC %d to PEB %d EC %d",
 		       e1->pnum, e1->ec, e2->pnum, e2->ec);
+		trace_ubi_wl_move(ubi->ubi_num, "wear-level", e1->pnum, e1->ec,
+				  e2->pnum, e2->ec);
 	} else {
 		/* Perform scrubbing */
 		scrubbing = 1;
@@ -1085,6 +1102,8 @@ static int wear_leveling_worker(struct ubi_device *ubi, struct ubi_work *wrk,
 		self_check_in_wl_tree(ubi, e1, &ubi->scrub);
 		rb_erase(&e1->u.rb, &ubi->scrub);
 		dbg_wl("scrub PEB %d to PEB %d", e1->pnum, e2->pnum);
+		trace_ubi_wl_move(ubi->ubi_num, "scrub", e1->pnum, e1->ec,
+				  e2->pnum, e2->ec);
 	}
 
 	ubi->move_from = e1;
@@ -1337,8 +1356,11 @@ static int ensure_wear_leveling(struct ubi_device *ubi, int nested)
 		if (!(e2->ec - e1->ec >= UBI_WL_THRESHOLD))
 			goto out_unlock;
 		dbg_wl("schedule wear-leveling");
-	} else
+		trace_ubi_wl_schedule(ubi->ubi_num, false);
+	} else {
 		dbg_wl("schedule scrubbing");
+		trace_ubi_wl_schedule(ubi->ubi_num, true);
+	}
 
 	ubi->wl_scheduled = 1;
 	spin_unlock(&ubi->wl_lock);
@@ -1639,6 +1661,7 @@ int ubi_wl_scrub_peb(struct ubi_device *ubi, int pnum)
 	struct ubi_wl_entry *e;
 
 	ubi_msg("schedule PEB %d for scrubbing", pnum);
+	trace_ubi_wl_scrub_peb(ubi->ubi_num, pnum);
 
 retry:
 	spin_lock(&ubi->wl_lock);
@@ -1787,7 +1810,8 @@ static void tree_destroy(struct rb_root *root)
  */
 int ubi_thread(void *u)
 {
-	int failures = 0;
+	int failures = 0, deferring = 0;
+	unsigned long defer_since = 0;
 	struct ubi_device *ubi = u;
 
 	ubi_msg("background thread \"%s\" started, PID %d",
@@ -1795,7 +1819,8 @@ int ubi_thread(void *u)
 
 	set_freezable();
 	for (;;) {
-		int err;
+		struct ubi_work *wrk;
+		int err, yield;
 
 		if (kthread_should_stop())
 			break;
@@ -1811,8 +1836,30 @@ int ubi_thread(void *u)
 			schedule();
 			continue;
 		}
+		wrk = list_entry(ubi->works.next, struct ubi_work, list);
+		yield = wrk->func != erase_worker;
 		spin_unlock(&ubi->wl_lock);
 
+		/*
+		 * Wear-leveling and scrubbing give way to foreground I/O, but
+		 * only for so long. Erasures do not, writers may be waiting
+		 * for free PEBs. Writers out of free PEBs do works themselves
+		 * anyway.
+		 */
+		if (yield && ubi_io_fg_recent(ubi)) {
+			if (!deferring) {
+				deferring = 1;
+				defer_since = jiffies;
+			}
+			if (time_before(jiffies, defer_since +
+					msecs_to_jiffies(UBI_BG_MAX_DEFER))) {
+				schedule_timeout_interruptible(
+					msecs_to_jiffies(UBI_FG_IO_QUIET));
+				continue;
+			}
+		}
+		deferring = 0;
+
 		err = do_work(ubi);
 		if (err) {
 			ubi_err("%s: work failed with error code %d",
@@ -1831,6 +1878,7 @@ int ubi_thread(void *u)
 		} else
 			failures = 0;
 
+		ubi_io_bg_throttle(ubi);
 		cond_resched();
 	}
 
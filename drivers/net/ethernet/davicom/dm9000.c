@@ -36,6 +36,7 @@
 #include <linux/platform_device.h>
 #include <linux/irq.h>
 #include <linux/slab.h>
+#include <linux/highmem.h>
 
 #include <asm/delay.h>
 #include <asm/irq.h>
@@ -47,6 +48,8 @@
 
 #define DM9000_PHY		0x40	/* PHY address 0x01 */
 
+#define DM9000_RX_POOL_PAGES	16	/* two full size frames per page */
+
 #define CARDNAME	"dm9000"
 #define DRV_VERSION	"1.31"
 
@@ -105,8 +108,10 @@ typedef struct board_info {
 	u16		queue_ip_summed;
 	u16		dbug_cnt;
 	u8		io_mode;		/* 0:word, 2:byte */
+	u8		io_width;		/* data port width in bytes */
 	u8		phy_addr;
 	u8		imr_all;
+	bool		rx_napi;	/* RX interrupt masked for NAPI */
 
 	unsigned int	flags;
 	unsigned int	in_suspend:1;
@@ -132,6 +137,8 @@ typedef struct board_info {
 
 	struct delayed_work phy_poll;
 	struct net_device  *ndev;
+	struct napi_struct napi;
+	struct netdev_frag_pool *rx_pool;	/* RX buffers, used by NAPI */
 
 	spinlock_t	lock;
 
@@ -216,6 +223,74 @@ static void dm9000_outblk_32bit(void __iomem *reg, void *data, int count)
 	iowrite32_rep(reg, data, (count+3) >> 2);
 }
 
+/* Fragmented skbs are streamed into the TX SRAM piece by piece. The
+ * outblk routines can only write whole bus words from aligned memory.
+ * A word left partial at a fragment boundary is completed in a small
+ * bounce buffer, after which the rest of the next fragment goes straight
+ * from the page if that leaves it aligned. Fragments that stay
+ * misaligned relative to the bus word are copied through the bounce
+ * buffer in full.
+ */
+#define DM9000_TX_BOUNCE	64
+
+static unsigned int dm9000_outblk_piece(board_info_t *db, u8 *bounce,
+					unsigned int blen, const u8 *data,
+					unsigned int len)
+{
+	unsigned int width = db->io_width;
+	unsigned int n;
+
+	while (len) {
+		if (!blen && IS_ALIGNED((unsigned long)data, width) &&
+		    len >= width) {
+			n = round_down(len, width);
+			(db->outblk)(db->io_data, (void *)data, n);
+		} else {
+			n = DM9000_TX_BOUNCE - blen;
+			if (blen && IS_ALIGNED((unsigned long)data + width - blen,
+					       width))
+				n = width - blen;
+			n = min(len, n);
+			memcpy(bounce + blen, data, n);
+			blen += n;
+			if (blen >= width) {
+				unsigned int m = round_down(blen, width);
+
+				(db->outblk)(db->io_data, bounce, m);
+				blen -= m;
+				memmove(bounce, bounce + m, blen);
+			}
+		}
+		data += n;
+		len -= n;
+	}
+
+	return blen;
+}
+
+static void dm9000_outblk_skb(board_info_t *db, struct sk_buff *skb)
+{
+	u8 bounce[DM9000_TX_BOUNCE] __aligned(4);
+	unsigned int blen;
+	int i;
+
+	blen = dm9000_outblk_piece(db, bounce, 0, skb->data,
+				   skb_headlen(skb));
+
+	for (i = 0; i < skb_shinfo(skb)->nr_frags; i++) {
+		const skb_frag_t *frag = &skb_shinfo(skb)->frags[i];
+		u8 *vaddr = kmap_atomic(skb_frag_page(frag));
+
+		blen = dm9000_outblk_piece(db, bounce, blen,
+					   vaddr + frag->page_offset,
+					   skb_frag_size(frag));
+		kunmap_atomic(vaddr);
+	}
+
+	if (blen)
+		(db->outblk)(db->io_data, bounce, blen);
+}
+
 /* input block from chip to memory */
 
 static void dm9000_inblk_8bit(void __iomem *reg, void *data, int count)
@@ -385,6 +460,7 @@ static void dm9000_set_io(struct board_info *db, int byte_width)
 		db->dumpblk = dm9000_dumpblk_8bit;
 		db->outblk  = dm9000_outblk_8bit;
 		db->inblk   = dm9000_inblk_8bit;
+		db->io_width = 1;
 		break;
 
 
@@ -394,6 +470,7 @@ static void dm9000_set_io(struct board_info *db, int byte_width)
 		db->dumpblk = dm9000_dumpblk_16bit;
 		db->outblk  = dm9000_outblk_16bit;
 		db->inblk   = dm9000_inblk_16bit;
+		db->io_width = 2;
 		break;
 
 	case 4:
@@ -401,6 +478,7 @@ static void dm9000_set_io(struct board_info *db, int byte_width)
 		db->dumpblk = dm9000_dumpblk_32bit;
 		db->outblk  = dm9000_outblk_32bit;
 		db->inblk   = dm9000_inblk_32bit;
+		db->io_width = 4;
 		break;
 	}
 }
@@ -947,6 +1025,7 @@ dm9000_init_dm9000(struct net_device *dev)
 	/* Init Driver variable */
 	db->tx_pkt_cnt = 0;
 	db->queue_pkt_len = 0;
+	db->rx_napi = false;
 	dev->trans_start = jiffies;
 }
 
@@ -1016,7 +1095,10 @@ dm9000_start_xmit(struct sk_buff *skb, struct net_device *dev)
 	/* Move data to DM9000 TX RAM */
 	writeb(DM9000_MWCMD, db->io_addr);
 
-	(db->outblk)(db->io_data, skb->data, skb->len);
+	if (skb_is_nonlinear(skb))
+		dm9000_outblk_skb(db, skb);
+	else
+		(db->outblk)(db->io_data, skb->data, skb->len);
 	dev->stats.tx_bytes += skb->len;
 
 	db->tx_pkt_cnt++;
@@ -1070,10 +1152,15 @@ struct dm9000_rxhdr {
 } __packed;
 
 /*
- *  Received a packet and pass to upper layer
+ *  Received up to budget packets and pass them to upper layer through GRO,
+ *  so TCP segments of one flow are merged before they walk the stack
+ *
+ *  The lock is only held while a single packet is copied out of the chip,
+ *  the packet is handed to the stack after dropping it since that may call
+ *  back into dm9000_start_xmit().
  */
-static void
-dm9000_rx(struct net_device *dev)
+static int
+dm9000_rx(struct net_device *dev, int budget)
 {
 	board_info_t *db = netdev_priv(dev);
 	struct dm9000_rxhdr rxhdr;
@@ -1081,9 +1168,16 @@ dm9000_rx(struct net_device *dev)
 	u8 rxbyte, *rdptr;
 	bool GoodPacket;
 	int RxLen;
+	int work_done = 0;
+	unsigned long flags;
+	u8 reg_save;
+
+	while (work_done < budget) {
+		spin_lock_irqsave(&db->lock, flags);
+
+		/* Save previous register address */
+		reg_save = readb(db->io_addr);
 
-	/* Check packet ready or not */
-	do {
 		ior(db, DM9000_MRCMDX);	/* Dummy read */
 
 		/* Get most updated data */
@@ -1094,11 +1188,11 @@ dm9000_rx(struct net_device *dev)
 			dev_warn(db->dev, "status check fail: %d\n", rxbyte);
 			iow(db, DM9000_RCR, 0x00);	/* Stop Device */
 			iow(db, DM9000_ISR, IMR_PAR);	/* Stop INT request */
-			return;
+			goto out_unlock;
 		}
 
 		if (!(rxbyte & DM9000_PKT_RDY))
-			return;
+			goto out_unlock;
 
 		/* A packet ready now  & Get status/length */
 		GoodPacket = true;
@@ -1146,8 +1240,10 @@ dm9000_rx(struct net_device *dev)
 		}
 
 		/* Move data from DM9000 */
+		skb = NULL;
 		if (GoodPacket &&
-		    ((skb = netdev_alloc_skb(dev, RxLen + 4)) != NULL)) {
+		    ((skb = netdev_frag_pool_alloc_skb(dev, db->rx_pool,
+						RxLen + 4, GFP_ATOMIC)) != NULL)) {
 			skb_reserve(skb, 2);
 			rdptr = (u8 *) skb_put(skb, RxLen - 4);
 
@@ -1155,24 +1251,77 @@ dm9000_rx(struct net_device *dev)
 
 			(db->inblk)(db->io_data, rdptr, RxLen);
 			dev->stats.rx_bytes += RxLen;
-
-			/* Pass to upper layer */
-			skb->protocol = eth_type_trans(skb, dev);
-			if (dev->features & NETIF_F_RXCSUM) {
-				if ((((rxbyte & 0x1c) << 3) & rxbyte) == 0)
-					skb->ip_summed = CHECKSUM_UNNECESSARY;
-				else
-					skb_checksum_none_assert(skb);
-			}
-			netif_rx(skb);
-			dev->stats.rx_packets++;
-
 		} else {
 			/* need to dump the packet's data */
 
 			(db->dumpblk)(db->io_data, RxLen);
 		}
-	} while (rxbyte & DM9000_PKT_RDY);
+
+		/* Restore previous register address */
+		writeb(reg_save, db->io_addr);
+		spin_unlock_irqrestore(&db->lock, flags);
+
+		work_done++;
+
+		if (!skb)
+			continue;
+
+		/* Pass to upper layer */
+		skb->protocol = eth_type_trans(skb, dev);
+		if (dev->features & NETIF_F_RXCSUM) {
+			if ((((rxbyte & 0x1c) << 3) & rxbyte) == 0)
+				skb->ip_summed = CHECKSUM_UNNECESSARY;
+			else
+				skb_checksum_none_assert(skb);
+		}
+		napi_gro_receive(&db->napi, skb);
+		dev->stats.rx_packets++;
+	}
+
+	return work_done;
+
+out_unlock:
+	writeb(reg_save, db->io_addr);
+	spin_unlock_irqrestore(&db->lock, flags);
+	return work_done;
+}
+
+static int dm9000_poll(struct napi_struct *napi, int budget)
+{
+	board_info_t *db = container_of(napi, board_info_t, napi);
+	unsigned long flags;
+	int work_done;
+	u8 reg_save;
+
+	/* Acknowledge the RX status before draining the chip, so only
+	 * packets arriving from now on will raise the interrupt again */
+	spin_lock_irqsave(&db->lock, flags);
+	reg_save = readb(db->io_addr);
+	iow(db, DM9000_ISR, ISR_PRS);
+	writeb(reg_save, db->io_addr);
+	spin_unlock_irqrestore(&db->lock, flags);
+
+	work_done = dm9000_rx(db->ndev, budget);
+
+	if (work_done < budget) {
+		/* Flush the GRO list before taking the lock, passing the
+		 * merged packets up may transmit and need it */
+		napi_gro_flush(napi, false);
+
+		spin_lock_irqsave(&db->lock, flags);
+		reg_save = readb(db->io_addr);
+
+		napi_complete(napi);
+
+		/* Unmask the RX interrupt again */
+		db->rx_napi = false;
+		iow(db, DM9000_IMR, db->imr_all);
+
+		writeb(reg_save, db->io_addr);
+		spin_unlock_irqrestore(&db->lock, flags);
+	}
+
+	return work_done;
 }
 
 static irqreturn_t dm9000_interrupt(int irq, void *dev_id)
@@ -1203,9 +1352,12 @@ static irqreturn_t dm9000_interrupt(int irq, void *dev_id)
 	if (netif_msg_intr(db))
 		dev_dbg(db->dev, "interrupt status %02x\n", int_status);
 
-	/* Received the coming packet */
-	if (int_status & ISR_PRS)
-		dm9000_rx(dev);
+	/* Received the coming packet, leave it to NAPI and keep the RX
+	 * interrupt masked until it has emptied the RX SRAM */
+	if ((int_status & ISR_PRS) && napi_schedule_prep(&db->napi)) {
+		db->rx_napi = true;
+		__napi_schedule(&db->napi);
+	}
 
 	/* Trnasmit Interrupt check */
 	if (int_status & ISR_PTS)
@@ -1219,7 +1371,8 @@ static irqreturn_t dm9000_interrupt(int irq, void *dev_id)
 	}
 
 	/* Re-enable interrupt mask */
-	iow(db, DM9000_IMR, db->imr_all);
+	iow(db, DM9000_IMR,
+	    db->rx_napi ? db->imr_all & ~IMR_PRM : db->imr_all);
 
 	/* Restore previous register address */
 	writeb(reg_save, db->io_addr);
@@ -1304,8 +1457,17 @@ dm9000_open(struct net_device *dev)
 	dm9000_reset(db);
 	dm9000_init_dm9000(dev);
 
-	if (request_irq(dev->irq, dm9000_interrupt, irqflags, dev->name, dev))
+	/* Without a pool RX falls back to allocating every buffer */
+	db->rx_pool = netdev_frag_pool_create(DM9000_RX_POOL_PAGES);
+
+	napi_enable(&db->napi);
+
+	if (request_irq(dev->irq, dm9000_interrupt, irqflags, dev->name, dev)) {
+		napi_disable(&db->napi);
+		netdev_frag_pool_destroy(db->rx_pool);
+		db->rx_pool = NULL;
 		return -EAGAIN;
+	}
 
 	/* Init driver variable */
 	db->dbug_cnt = 0;
@@ -1346,12 +1508,16 @@ dm9000_stop(struct net_device *ndev)
 
 	netif_stop_queue(ndev);
 	netif_carrier_off(ndev);
+	napi_disable(&db->napi);
 
 	/* free interrupt */
 	free_irq(ndev->irq, ndev);
 
 	dm9000_shutdown(ndev);
 
+	netdev_frag_pool_destroy(db->rx_pool);
+	db->rx_pool = NULL;
+
 	return 0;
 }
 
@@ -1589,9 +1755,12 @@ dm9000_probe(struct platform_device *pdev)
 		db->type = TYPE_DM9000E;
 	}
 
-	/* dm9000a/b are capable of hardware checksum offload */
+	/* dm9000a/b are capable of hardware checksum offload, which in
+	 * turn lets the stack hand us page fragments (sendfile/splice)
+	 */
 	if (db->type == TYPE_DM9000A || db->type == TYPE_DM9000B) {
-		ndev->hw_features = NETIF_F_RXCSUM | NETIF_F_IP_CSUM;
+		ndev->hw_features = NETIF_F_RXCSUM | NETIF_F_IP_CSUM |
+				    NETIF_F_SG;
 		ndev->features |= ndev->hw_features;
 	}
 
@@ -1604,6 +1773,8 @@ dm9000_probe(struct platform_device *pdev)
 	ndev->watchdog_timeo	= msecs_to_jiffies(watchdog);
 	ndev->ethtool_ops	= &dm9000_ethtool_ops;
 
+	netif_napi_add(ndev, &db->napi, dm9000_poll, NAPI_POLL_WEIGHT);
+
 	db->msg_enable       = NETIF_MSG_LINK;
 	db->mii.phy_id_mask  = 0x1f;
 	db->mii.reg_num_mask = 0x1f;
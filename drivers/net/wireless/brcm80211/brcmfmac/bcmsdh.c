@@ -485,12 +485,11 @@ static int brcmf_sdiod_sglist_rw(struct brcmf_sdio_dev *sdiodev, uint fn,
 	unsigned char *pkt_data, *orig_data, *dst_data;
 	struct sk_buff *pkt_next = NULL, *local_pkt_next;
 	struct sk_buff_head local_list, *target_list;
-	struct mmc_request mmc_req;
-	struct mmc_command mmc_cmd;
-	struct mmc_data mmc_dat;
-	struct sg_table st;
+	struct sdio_func *func = sdiodev->func[fn];
+	struct sdio_ext_req req[2];
+	struct sg_table st[2];
 	struct scatterlist *sgl;
-	int ret = 0;
+	int ret = 0, err, cur = 0;
 
 	if (!pktlist->qlen)
 		return -EINVAL;
@@ -499,6 +498,7 @@ static int brcmf_sdiod_sglist_rw(struct brcmf_sdio_dev *sdiodev, uint fn,
 	if (brcmf_sdiod_pm_resume_error(sdiodev))
 		return -EIO;
 
+	memset(st, 0, sizeof(st));
 	target_list = pktlist;
 	/* for host with broken sg support, prepare a page aligned list */
 	__skb_queue_head_init(&local_list);
@@ -525,7 +525,7 @@ static int brcmf_sdiod_sglist_rw(struct brcmf_sdio_dev *sdiodev, uint fn,
 		target_list = &local_list;
 	}
 
-	func_blk_sz = sdiodev->func[fn]->cur_blksize;
+	func_blk_sz = func->cur_blksize;
 	max_req_sz = sdiodev->max_request_size;
 	max_seg_cnt = min_t(unsigned short, sdiodev->max_segment_count,
 			    target_list->qlen);
@@ -533,32 +533,20 @@ static int brcmf_sdiod_sglist_rw(struct brcmf_sdio_dev *sdiodev, uint fn,
 	pkt_offset = 0;
 	pkt_next = target_list->next;
 
-	if (sg_alloc_table(&st, max_seg_cnt, GFP_KERNEL)) {
+	/*
+	 * Chains larger than a single request are split over several CMD53s.
+	 * Alternate between two requests so the host can set up the next one
+	 * while the previous one is on the bus.
+	 */
+	if (sg_alloc_table(&st[0], max_seg_cnt, GFP_KERNEL)) {
 		ret = -ENOMEM;
 		goto exit;
 	}
 
-	memset(&mmc_req, 0, sizeof(struct mmc_request));
-	memset(&mmc_cmd, 0, sizeof(struct mmc_command));
-	memset(&mmc_dat, 0, sizeof(struct mmc_data));
-
-	mmc_dat.sg = st.sgl;
-	mmc_dat.blksz = func_blk_sz;
-	mmc_dat.flags = write ? MMC_DATA_WRITE : MMC_DATA_READ;
-	mmc_cmd.opcode = SD_IO_RW_EXTENDED;
-	mmc_cmd.arg = write ? 1<<31 : 0;	/* write flag  */
-	mmc_cmd.arg |= (fn & 0x7) << 28;	/* SDIO func num */
-	mmc_cmd.arg |= 1<<27;			/* block mode */
-	/* for function 1 the addr will be incremented */
-	mmc_cmd.arg |= (fn == 1) ? 1<<26 : 0;
-	mmc_cmd.flags = MMC_RSP_SPI_R5 | MMC_RSP_R5 | MMC_CMD_ADTC;
-	mmc_req.cmd = &mmc_cmd;
-	mmc_req.data = &mmc_dat;
-
 	while (seg_sz) {
 		req_sz = 0;
 		sg_cnt = 0;
-		sgl = st.sgl;
+		sgl = st[cur].sgl;
 		/* prep sg table */
 		while (pkt_next != (struct sk_buff *)target_list) {
 			pkt_data = pkt_next->data + pkt_offset;
@@ -588,33 +576,45 @@ static int brcmf_sdiod_sglist_rw(struct brcmf_sdio_dev *sdiodev, uint fn,
 			brcmf_err("sg request length %u is not %u aligned\n",
 				  req_sz, func_blk_sz);
 			ret = -ENOTBLK;
-			goto exit;
+			break;
 		}
 
-		mmc_dat.sg_len = sg_cnt;
-		mmc_dat.blocks = req_sz / func_blk_sz;
-		mmc_cmd.arg |= (addr & 0x1FFFF) << 9;	/* address */
-		mmc_cmd.arg |= mmc_dat.blocks & 0x1FF;	/* block count */
-		/* incrementing addr for function 1 */
+		/* for function 1 the addr will be incremented */
+		ret = sdio_init_ext_req(func, &req[cur], write, addr & 0x1FFFF,
+					fn == 1, st[cur].sgl, sg_cnt,
+					req_sz / func_blk_sz);
+		if (ret)
+			break;
 		if (fn == 1)
 			addr += req_sz;
 
-		mmc_set_data_timeout(&mmc_dat, sdiodev->func[fn]->card);
-		mmc_wait_for_req(sdiodev->func[fn]->card->host, &mmc_req);
-
-		ret = mmc_cmd.error ? mmc_cmd.error : mmc_dat.error;
-		if (ret == -ENOMEDIUM) {
-			brcmf_bus_change_state(sdiodev->bus_if,
-					       BRCMF_BUS_NOMEDIUM);
-			break;
-		} else if (ret != 0) {
-			brcmf_err("CMD53 sg block %s failed %d\n",
-				  write ? "write" : "read", ret);
-			ret = -EIO;
+		ret = sdio_queue_ext_req(func, &req[cur]);
+		if (ret)
 			break;
+		cur ^= 1;
+		if (seg_sz && !st[cur].sgl &&
+		    sg_alloc_table(&st[cur], max_seg_cnt, GFP_KERNEL)) {
+			/* no second table, let the first one drain instead */
+			ret = sdio_finish_ext_reqs(func);
+			if (ret)
+				break;
+			cur ^= 1;
 		}
 	}
 
+	err = sdio_finish_ext_reqs(func);
+	if (!ret)
+		ret = err;
+	if (ret == -ENOMEDIUM) {
+		brcmf_bus_change_state(sdiodev->bus_if, BRCMF_BUS_NOMEDIUM);
+	} else if (ret == -ENOTBLK) {
+		/* already reported */
+	} else if (ret != 0) {
+		brcmf_err("CMD53 sg block %s failed %d\n",
+			  write ? "write" : "read", ret);
+		ret = -EIO;
+	}
+
 	if (sdiodev->pdata && sdiodev->pdata->broken_sg_support && !write) {
 		local_pkt_next = local_list.next;
 		orig_offset = 0;
@@ -640,7 +640,8 @@ static int brcmf_sdiod_sglist_rw(struct brcmf_sdio_dev *sdiodev, uint fn,
 	}
 
 exit:
-	sg_free_table(&st);
+	sg_free_table(&st[0]);
+	sg_free_table(&st[1]);
 	while ((pkt_next = __skb_dequeue(&local_list)) != NULL)
 		brcmu_pkt_buf_free_skb(pkt_next);
 
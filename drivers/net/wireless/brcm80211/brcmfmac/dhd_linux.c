@@ -191,6 +191,7 @@ static netdev_tx_t brcmf_netdev_start_xmit(struct sk_buff *skb,
 	struct brcmf_if *ifp = netdev_priv(ndev);
 	struct brcmf_pub *drvr = ifp->drvr;
 	struct ethhdr *eh;
+	bool more = skb->xmit_more;
 
 	brcmf_dbg(DATA, "Enter, idx=%d\n", ifp->bssidx);
 
@@ -241,6 +242,9 @@ static netdev_tx_t brcmf_netdev_start_xmit(struct sk_buff *skb,
 done:
 	if (ret) {
 		ifp->stats.tx_dropped++;
+		/* last of a burst got dropped, flush what was deferred */
+		if (!more && drvr->bus_if->state == BRCMF_BUS_DATA)
+			brcmf_fws_kick(drvr);
 	} else {
 		ifp->stats.tx_packets++;
 		ifp->stats.tx_bytes += skb->len;
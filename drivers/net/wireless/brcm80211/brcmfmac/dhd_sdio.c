@@ -123,6 +123,9 @@ struct rte_console {
 
 #define BRCMF_FIRSTREAD	(1 << 6)
 
+/* Pages in the recycling pool for rx frame buffers */
+#define BRCMF_RX_POOL_PAGES	32
+
 
 /* SBSDIO_DEVICE_CTL */
 
@@ -400,6 +403,7 @@ struct brcmf_sdio {
 	struct sk_buff *glomd;	/* Packet containing glomming descriptor */
 	struct sk_buff_head glom; /* Packet list for glommed superframe */
 	uint glomerr;		/* Glom packet read errors */
+	struct netdev_frag_pool *rx_pool; /* Rx frame buffers, used by dpc */
 
 	u8 *rxbuf;		/* Buffer for receiving control packets */
 	uint rxblen;		/* Allocated length of rxbuf */
@@ -607,6 +611,20 @@ static void pkt_align(struct sk_buff *p, int len, int align)
 	__skb_trim(p, len);
 }
 
+/* Get a buffer for a received frame, only called from the dpc */
+static struct sk_buff *brcmf_sdio_rx_skb(struct brcmf_sdio *bus, uint len)
+{
+	struct sk_buff *skb;
+
+	skb = netdev_frag_pool_alloc_skb(NULL, bus->rx_pool, len, GFP_ATOMIC);
+	if (skb) {
+		skb_put(skb, len);
+		skb->priority = 0;
+	}
+
+	return skb;
+}
+
 /* To check if there's window offered */
 static bool data_ok(struct brcmf_sdio *bus)
 {
@@ -1363,7 +1381,8 @@ static u8 brcmf_sdio_rxglom(struct brcmf_sdio *bus, u8 rxseq)
 			}
 
 			/* Allocate/chain packet for next subframe */
-			pnext = brcmu_pkt_buf_get_skb(sublen + bus->sgentry_align);
+			pnext = brcmf_sdio_rx_skb(bus,
+						  sublen + bus->sgentry_align);
 			if (pnext == NULL) {
 				brcmf_err("bcm_pkt_buf_get_skb failed, num %d len %d\n",
 					  num, sublen);
@@ -1740,8 +1759,8 @@ static uint brcmf_sdio_readframes(struct brcmf_sdio *bus, uint maxframes)
 
 		brcmf_sdio_pad(bus, &pad, &rd->len_left);
 
-		pkt = brcmu_pkt_buf_get_skb(rd->len_left + head_read +
-					    bus->head_align);
+		pkt = brcmf_sdio_rx_skb(bus, rd->len_left + head_read +
+					bus->head_align);
 		if (!pkt) {
 			/* Give up on data, request rtx of events */
 			brcmf_err("brcmu_pkt_buf_get_skb failed\n");
@@ -3894,6 +3913,8 @@ struct brcmf_sdio *brcmf_sdio_probe(struct brcmf_sdio_dev *sdiodev)
 	bus->sdiodev = sdiodev;
 	sdiodev->bus = bus;
 	skb_queue_head_init(&bus->glom);
+	/* Without a pool every rx frame is allocated on its own */
+	bus->rx_pool = netdev_frag_pool_create(BRCMF_RX_POOL_PAGES);
 	bus->txbound = BRCMF_TXBOUND;
 	bus->rxbound = BRCMF_RXBOUND;
 	bus->txminmax = BRCMF_TXMINMAX;
@@ -4050,6 +4071,7 @@ void brcmf_sdio_remove(struct brcmf_sdio *bus)
 			brcmf_sdio_chip_detach(&bus->ci);
 		}
 
+		netdev_frag_pool_destroy(bus->rx_pool);
 		kfree(bus->rxbuf);
 		kfree(bus->hdrbuf);
 		kfree(bus);
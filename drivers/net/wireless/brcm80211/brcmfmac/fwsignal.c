@@ -1869,6 +1869,7 @@ int brcmf_fws_process_skb(struct brcmf_if *ifp, struct sk_buff *skb)
 	int fifo = BRCMF_FWS_FIFO_BCMC;
 	bool multicast = is_multicast_ether_addr(eh->h_dest);
 	bool pae = eh->h_proto == htons(ETH_P_PAE);
+	bool more = skb->xmit_more;
 
 	brcmf_dbg(DATA, "tx proto=0x%X\n", ntohs(eh->h_proto));
 	/* determine the priority */
@@ -1896,7 +1897,6 @@ int brcmf_fws_process_skb(struct brcmf_if *ifp, struct sk_buff *skb)
 		  eh->h_dest, multicast, fifo);
 	if (!brcmf_fws_assign_htod(fws, skb, fifo)) {
 		brcmf_fws_enq(fws, BRCMF_FWS_SKBSTATE_DELAYED, fifo, skb);
-		brcmf_fws_schedule_deq(fws);
 	} else {
 		brcmf_err("drop skb: no hanger slot\n");
 		if (pae) {
@@ -1906,10 +1906,24 @@ int brcmf_fws_process_skb(struct brcmf_if *ifp, struct sk_buff *skb)
 		}
 		brcmu_pkt_buf_free_skb(skb);
 	}
+	/* let the rest of a burst pile up so the dequeue worker pushes it
+	 * to the bus in one go, unless the queue got stopped meanwhile.
+	 */
+	if (!more || netif_queue_stopped(ifp->ndev))
+		brcmf_fws_schedule_deq(fws);
 	brcmf_fws_unlock(fws);
 	return 0;
 }
 
+void brcmf_fws_kick(struct brcmf_pub *drvr)
+{
+	struct brcmf_fws_info *fws = drvr->fws;
+
+	brcmf_fws_lock(fws);
+	brcmf_fws_schedule_deq(fws);
+	brcmf_fws_unlock(fws);
+}
+
 void brcmf_fws_reset_interface(struct brcmf_if *ifp)
 {
 	struct brcmf_fws_mac_descriptor *entry = ifp->fws_desc;
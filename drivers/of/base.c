@@ -19,6 +19,7 @@
  */
 #include <linux/ctype.h>
 #include <linux/cpu.h>
+#include <linux/log2.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_graph.h>
@@ -704,6 +705,204 @@ struct device_node *of_find_node_by_type(struct device_node *from,
 }
 EXPORT_SYMBOL(of_find_node_by_type);
 
+/*
+ * Lookup indices for phandles and compatible strings, built once the tree
+ * has been unflattened.  The first change to the tree disables them for
+ * good and lookups go back to walking of_allnodes.  Both are protected by
+ * devtree_lock.
+ */
+static bool of_index_valid;
+static bool of_index_disabled;
+
+static struct device_node **of_phandle_cache;
+static u32 of_phandle_cache_mask;
+
+struct of_compat_entry {
+	struct of_compat_entry *next;
+	const char *compat;
+	unsigned int nr, alloc;
+	/* in of_allnodes order */
+	struct device_node **nodes;
+};
+
+static struct of_compat_entry **of_compat_index;
+static unsigned int of_compat_index_mask;
+
+/* Must be called with devtree_lock held */
+static void of_index_disable(void)
+{
+	of_index_valid = false;
+	of_index_disabled = true;
+}
+
+/* Compatible strings compare case insensitively, so hash them that way */
+static unsigned int of_compat_hash(const char *compat)
+{
+	unsigned int h = 0;
+
+	while (*compat)
+		h = h * 31 + tolower(*compat++);
+	return h & of_compat_index_mask;
+}
+
+static struct of_compat_entry *of_compat_lookup(const char *compat)
+{
+	struct of_compat_entry *e;
+
+	for (e = of_compat_index[of_compat_hash(compat)]; e; e = e->next)
+		if (of_compat_cmp(e->compat, compat, strlen(compat)) == 0)
+			return e;
+	return NULL;
+}
+
+static int __init of_compat_index_add(const char *compat,
+				      struct device_node *np)
+{
+	struct of_compat_entry *e = of_compat_lookup(compat);
+	struct device_node **nodes;
+
+	if (!e) {
+		e = kzalloc(sizeof(*e), GFP_KERNEL);
+		if (!e)
+			return -ENOMEM;
+		e->compat = compat;
+		e->next = of_compat_index[of_compat_hash(compat)];
+		of_compat_index[of_compat_hash(compat)] = e;
+	}
+
+	/* A node listing the same string twice is only indexed once */
+	if (e->nr && e->nodes[e->nr - 1] == np)
+		return 0;
+
+	if (e->nr == e->alloc) {
+		nodes = krealloc(e->nodes, (e->alloc + 4) * sizeof(*nodes),
+				 GFP_KERNEL);
+		if (!nodes)
+			return -ENOMEM;
+		e->nodes = nodes;
+		e->alloc += 4;
+	}
+	e->nodes[e->nr++] = np;
+	return 0;
+}
+
+static void __init of_index_free(void)
+{
+	struct of_compat_entry *e, *next;
+	unsigned int i;
+
+	if (of_compat_index) {
+		for (i = 0; i <= of_compat_index_mask; i++) {
+			for (e = of_compat_index[i]; e; e = next) {
+				next = e->next;
+				kfree(e->nodes);
+				kfree(e);
+			}
+		}
+	}
+	kfree(of_compat_index);
+	kfree(of_phandle_cache);
+	of_compat_index = NULL;
+	of_phandle_cache = NULL;
+}
+
+static int __init of_index_init(void)
+{
+	struct device_node *np;
+	struct property *prop;
+	const char *cp;
+	unsigned int nphandles = 0, ncompats = 0;
+	unsigned long flags;
+
+	for (np = of_allnodes; np; np = np->allnext) {
+		if (np->phandle)
+			nphandles++;
+		prop = __of_find_property(np, "compatible", NULL);
+		for (cp = of_prop_next_string(prop, NULL); cp;
+		     cp = of_prop_next_string(prop, cp))
+			ncompats++;
+	}
+	if (!nphandles && !ncompats)
+		return 0;
+
+	of_phandle_cache_mask = roundup_pow_of_two(max(nphandles, 1U)) - 1;
+	of_phandle_cache = kcalloc(of_phandle_cache_mask + 1,
+				   sizeof(*of_phandle_cache), GFP_KERNEL);
+	of_compat_index_mask = roundup_pow_of_two(max(ncompats, 1U)) - 1;
+	of_compat_index = kcalloc(of_compat_index_mask + 1,
+				  sizeof(*of_compat_index), GFP_KERNEL);
+	if (!of_phandle_cache || !of_compat_index)
+		goto fail;
+
+	for (np = of_allnodes; np; np = np->allnext) {
+		/* On collisions the first node wins, the rest are walked to */
+		if (np->phandle &&
+		    !of_phandle_cache[np->phandle & of_phandle_cache_mask])
+			of_phandle_cache[np->phandle & of_phandle_cache_mask] = np;
+
+#ifndef CONFIG_SPARC	/* sparc matches compatible prefixes */
+		prop = __of_find_property(np, "compatible", NULL);
+		for (cp = of_prop_next_string(prop, NULL); cp;
+		     cp = of_prop_next_string(prop, cp))
+			if (of_compat_index_add(cp, np))
+				goto fail;
+#endif
+	}
+
+	raw_spin_lock_irqsave(&devtree_lock, flags);
+	of_index_valid = !of_index_disabled;
+	raw_spin_unlock_irqrestore(&devtree_lock, flags);
+	if (!of_index_valid)
+		of_index_free();
+	return 0;
+
+fail:
+	of_index_free();
+	return -ENOMEM;
+}
+core_initcall(of_index_init);
+
+/*
+ * Returns true if the index could answer the query, with the result in
+ * *npp.  Must be called with devtree_lock held.
+ */
+static bool of_compat_index_find(struct device_node *from, const char *type,
+				 const char *compatible,
+				 struct device_node **npp)
+{
+	struct of_compat_entry *e;
+	unsigned int i = 0;
+
+	*npp = NULL;
+	if (IS_ENABLED(CONFIG_SPARC) || !of_index_valid ||
+	    !compatible || !compatible[0])
+		return false;
+
+	e = of_compat_lookup(compatible);
+	if (!e)
+		return true;
+
+	if (from) {
+		for (; i < e->nr; i++)
+			if (e->nodes[i] == from)
+				break;
+		/* @from is not compatible, so where to resume is unknown */
+		if (i == e->nr)
+			return false;
+		i++;
+	}
+
+	for (; i < e->nr; i++) {
+		if (__of_device_is_compatible(e->nodes[i], compatible,
+					      type, NULL) &&
+		    of_node_get(e->nodes[i])) {
+			*npp = e->nodes[i];
+			break;
+		}
+	}
+	return true;
+}
+
 /**
  *	of_find_compatible_node - Find a node based on type and one of the
  *                                tokens in its "compatible" property
@@ -725,12 +924,15 @@ struct device_node *of_find_compatible_node(struct device_node *from,
 	unsigned long flags;
 
 	raw_spin_lock_irqsave(&devtree_lock, flags);
+	if (of_compat_index_find(from, type, compatible, &np))
+		goto out;
 	np = from ? from->allnext : of_allnodes;
 	for (; np; np = np->allnext) {
 		if (__of_device_is_compatible(np, compatible, type, NULL) &&
 		    of_node_get(np))
 			break;
 	}
+out:
 	of_node_put(from);
 	raw_spin_unlock_irqrestore(&devtree_lock, flags);
 	return np;
@@ -895,9 +1097,15 @@ struct device_node *of_find_node_by_phandle(phandle handle)
 	unsigned long flags;
 
 	raw_spin_lock_irqsave(&devtree_lock, flags);
+	if (of_index_valid) {
+		np = of_phandle_cache[handle & of_phandle_cache_mask];
+		if (np && np->phandle == handle)
+			goto out;
+	}
 	for (np = of_allnodes; np; np = np->allnext)
 		if (np->phandle == handle)
 			break;
+out:
 	of_node_get(np);
 	raw_spin_unlock_irqrestore(&devtree_lock, flags);
 	return np;
@@ -1514,6 +1722,7 @@ int of_add_property(struct device_node *np, struct property *prop)
 
 	prop->next = NULL;
 	raw_spin_lock_irqsave(&devtree_lock, flags);
+	of_index_disable();
 	next = &np->properties;
 	while (*next) {
 		if (strcmp(prop->name, (*next)->name) == 0) {
@@ -1555,6 +1764,7 @@ int of_remove_property(struct device_node *np, struct property *prop)
 		return rc;
 
 	raw_spin_lock_irqsave(&devtree_lock, flags);
+	of_index_disable();
 	next = &np->properties;
 	while (*next) {
 		if (*next == prop) {
@@ -1608,6 +1818,7 @@ int of_update_property(struct device_node *np, struct property *newprop)
 		return of_add_property(np, newprop);
 
 	raw_spin_lock_irqsave(&devtree_lock, flags);
+	of_index_disable();
 	next = &np->properties;
 	while (*next) {
 		if (*next == oldprop) {
@@ -1695,6 +1906,7 @@ int of_attach_node(struct device_node *np)
 		return rc;
 
 	raw_spin_lock_irqsave(&devtree_lock, flags);
+	of_index_disable();
 	np->sibling = np->parent->child;
 	np->allnext = of_allnodes;
 	np->parent->child = np;
@@ -1747,6 +1959,7 @@ int of_detach_node(struct device_node *np)
 		return rc;
 	}
 
+	of_index_disable();
 	if (of_allnodes == np)
 		of_allnodes = np->allnext;
 	else {
@@ -54,10 +54,13 @@ static int jz4740_pwm_request(struct pwm_chip *chip, struct pwm_device *pwm)
 
 	/*
 	 * Timers 0 and 1 are used for system tasks, so they are unavailable
-	 * for use as PWMs.
+	 * for use as PWMs. The same goes for the perf sampling timer.
 	 */
 	if (pwm->hwpwm < 2)
 		return -EBUSY;
+	if (IS_ENABLED(CONFIG_JZ4740_TCU_PMU) &&
+	    pwm->hwpwm == JZ4740_TCU_PMU_TIMER)
+		return -EBUSY;
 
 	ret = gpio_request(gpio, pwm->label);
 	if (ret) {
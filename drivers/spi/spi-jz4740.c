@@ -0,0 +1,725 @@
+/*
+ *  JZ4740 SSI (SPI) controller driver
+ *
+ *  Short transfers are done by PIO, refilling the FIFO from the receive
+ *  threshold interrupt; transfers of JZ4740_SPI_DMA_MIN_SIZE bytes and more
+ *  are handed to the DMA controller.  Chip selects are GPIOs, driven by the
+ *  SPI core, since the native ones are deasserted whenever the FIFO runs
+ *  empty.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under  the terms of the GNU General  Public License as published by the
+ *  Free Software Foundation;  either version 2 of the License, or (at your
+ *  option) any later version.
+ *
+ */
+
+#include <linux/clk.h>
+#include <linux/delay.h>
+#include <linux/dmaengine.h>
+#include <linux/err.h>
+#include <linux/gpio.h>
+#include <linux/interrupt.h>
+#include <linux/io.h>
+#include <linux/jiffies.h>
+#include <linux/module.h>
+#include <linux/platform_device.h>
+#include <linux/spi/spi.h>
+
+#include <asm/mach-jz4740/dma.h>
+#include <asm/mach-jz4740/gpio.h>
+#include <asm/mach-jz4740/jz4740_spi.h>
+
+#define JZ_REG_SSI_DATA		0x00
+#define JZ_REG_SSI_CTRL0	0x04
+#define JZ_REG_SSI_CTRL1	0x08
+#define JZ_REG_SSI_STATUS	0x0C
+#define JZ_REG_SSI_ITR		0x10
+#define JZ_REG_SSI_ICR		0x14
+#define JZ_REG_SSI_GR		0x18
+
+#define JZ_SSI_CTRL0_ENABLE		BIT(15)
+#define JZ_SSI_CTRL0_TX_IRQ		BIT(14)
+#define JZ_SSI_CTRL0_RX_IRQ		BIT(13)
+#define JZ_SSI_CTRL0_TX_ERR_IRQ		BIT(12)
+#define JZ_SSI_CTRL0_RX_ERR_IRQ		BIT(11)
+#define JZ_SSI_CTRL0_LOOPBACK		BIT(10)
+#define JZ_SSI_CTRL0_TX_FLUSH		BIT(2)
+#define JZ_SSI_CTRL0_RX_FLUSH		BIT(1)
+#define JZ_SSI_CTRL0_DISABLE_RX		BIT(0)
+
+#define JZ_SSI_CTRL1_TX_TRIG_OFFSET	16
+#define JZ_SSI_CTRL1_RX_TRIG_OFFSET	8
+#define JZ_SSI_CTRL1_RX_TRIG_MASK	(0xf << JZ_SSI_CTRL1_RX_TRIG_OFFSET)
+#define JZ_SSI_CTRL1_FLEN_OFFSET	4
+#define JZ_SSI_CTRL1_FLEN_MASK		(0xf << JZ_SSI_CTRL1_FLEN_OFFSET)
+#define JZ_SSI_CTRL1_LSB_FIRST		BIT(25)
+#define JZ_SSI_CTRL1_CPHA		BIT(1)
+#define JZ_SSI_CTRL1_CPOL		BIT(0)
+
+#define JZ_SSI_STATUS_TX_COUNT(x)	(((x) >> 16) & 0xff)
+#define JZ_SSI_STATUS_RX_COUNT(x)	(((x) >> 8) & 0xff)
+#define JZ_SSI_STATUS_BUSY		BIT(6)
+#define JZ_SSI_STATUS_UNDERRUN		BIT(1)
+#define JZ_SSI_STATUS_OVERRUN		BIT(0)
+
+#define JZ4740_SPI_FIFO_SIZE	16
+#define JZ4740_SPI_MAX_DIV	256
+
+/* Transfers smaller than this are not worth the DMA setup and are done in
+ * PIO mode. Those which fit the FIFO are not worth an interrupt either. */
+#define JZ4740_SPI_DMA_MIN_SIZE	64
+
+struct jz4740_spi {
+	struct spi_master *master;
+	void __iomem *base;
+	struct resource *mem_res;
+	struct clk *clk;
+	int irq;
+
+	u32 speed_hz;
+	u8 bits_per_word;
+
+	/* PIO state, only touched by the interrupt handler once started */
+	const void *tx_buf;
+	void *rx_buf;
+	unsigned int tx_left;
+	unsigned int rx_left;
+	unsigned int word_size;
+
+	bool dma_rx_active;
+};
+
+static inline uint32_t jz4740_spi_read(struct jz4740_spi *spi, unsigned int reg)
+{
+	return readl(spi->base + reg);
+}
+
+static inline void jz4740_spi_write(struct jz4740_spi *spi, unsigned int reg,
+	uint32_t val)
+{
+	writel(val, spi->base + reg);
+}
+
+static void jz4740_spi_ctrl0_update(struct jz4740_spi *spi, uint32_t mask,
+	uint32_t val)
+{
+	uint32_t ctrl0 = jz4740_spi_read(spi, JZ_REG_SSI_CTRL0);
+
+	jz4740_spi_write(spi, JZ_REG_SSI_CTRL0, (ctrl0 & ~mask) | val);
+}
+
+static void jz4740_spi_flush(struct jz4740_spi *spi)
+{
+	jz4740_spi_ctrl0_update(spi, 0,
+		JZ_SSI_CTRL0_TX_FLUSH | JZ_SSI_CTRL0_RX_FLUSH);
+	jz4740_spi_write(spi, JZ_REG_SSI_STATUS, 0);
+}
+
+static int jz4740_spi_wait_idle(struct jz4740_spi *spi)
+{
+	unsigned int timeout = 10000;
+	uint32_t status;
+
+	do {
+		status = jz4740_spi_read(spi, JZ_REG_SSI_STATUS);
+		if (!JZ_SSI_STATUS_TX_COUNT(status) &&
+		    !(status & JZ_SSI_STATUS_BUSY))
+			return 0;
+		udelay(1);
+	} while (--timeout);
+
+	return -ETIMEDOUT;
+}
+
+/* PIO */
+
+static void jz4740_spi_pio_fill(struct jz4740_spi *spi)
+{
+	unsigned int n = JZ4740_SPI_FIFO_SIZE - (spi->rx_left - spi->tx_left);
+	uint32_t val;
+
+	n = min(n, spi->tx_left);
+	spi->tx_left -= n;
+
+	while (n--) {
+		if (spi->word_size == 1)
+			val = *(const u8 *)spi->tx_buf;
+		else
+			val = *(const u16 *)spi->tx_buf;
+		spi->tx_buf += spi->word_size;
+		jz4740_spi_write(spi, JZ_REG_SSI_DATA, val);
+	}
+}
+
+static void jz4740_spi_pio_drain(struct jz4740_spi *spi)
+{
+	uint32_t status = jz4740_spi_read(spi, JZ_REG_SSI_STATUS);
+	unsigned int n = JZ_SSI_STATUS_RX_COUNT(status);
+	uint32_t val;
+
+	n = min(n, spi->rx_left);
+	spi->rx_left -= n;
+
+	while (n--) {
+		val = jz4740_spi_read(spi, JZ_REG_SSI_DATA);
+		if (!spi->rx_buf)
+			continue;
+		if (spi->word_size == 1)
+			*(u8 *)spi->rx_buf = val;
+		else
+			*(u16 *)spi->rx_buf = val;
+		spi->rx_buf += spi->word_size;
+	}
+}
+
+/*
+ * Interrupt once the receive FIFO holds half of what is in flight, or all of
+ * it towards the end of the transfer, so that there is always data left to
+ * shift out while the FIFO is serviced.
+ */
+static void jz4740_spi_pio_set_trigger(struct jz4740_spi *spi)
+{
+	unsigned int in_flight = spi->rx_left - spi->tx_left;
+	unsigned int trig;
+	uint32_t ctrl1;
+
+	trig = spi->tx_left ? in_flight / 2 : in_flight;
+	trig = clamp(trig, 1U, JZ4740_SPI_FIFO_SIZE - 1U);
+
+	ctrl1 = jz4740_spi_read(spi, JZ_REG_SSI_CTRL1);
+	ctrl1 &= ~JZ_SSI_CTRL1_RX_TRIG_MASK;
+	ctrl1 |= trig << JZ_SSI_CTRL1_RX_TRIG_OFFSET;
+	jz4740_spi_write(spi, JZ_REG_SSI_CTRL1, ctrl1);
+}
+
+static irqreturn_t jz4740_spi_irq(int irq, void *devid)
+{
+	struct jz4740_spi *spi = devid;
+
+	jz4740_spi_pio_drain(spi);
+
+	if (!spi->rx_left) {
+		jz4740_spi_ctrl0_update(spi, JZ_SSI_CTRL0_RX_IRQ, 0);
+		spi_finalize_current_transfer(spi->master);
+		return IRQ_HANDLED;
+	}
+
+	jz4740_spi_pio_fill(spi);
+	jz4740_spi_pio_set_trigger(spi);
+
+	return IRQ_HANDLED;
+}
+
+static int jz4740_spi_transfer_pio(struct jz4740_spi *spi,
+	struct spi_transfer *xfer)
+{
+	unsigned int len = xfer->len / spi->word_size;
+	unsigned long timeout;
+
+	spi->tx_buf = xfer->tx_buf;
+	spi->rx_buf = xfer->rx_buf;
+	spi->tx_left = len;
+	spi->rx_left = len;
+
+	jz4740_spi_ctrl0_update(spi, JZ_SSI_CTRL0_DISABLE_RX, 0);
+
+	if (len > JZ4740_SPI_FIFO_SIZE) {
+		jz4740_spi_pio_fill(spi);
+		jz4740_spi_pio_set_trigger(spi);
+		jz4740_spi_ctrl0_update(spi, 0, JZ_SSI_CTRL0_RX_IRQ);
+		return 1;
+	}
+
+	jz4740_spi_pio_fill(spi);
+	timeout = jiffies + msecs_to_jiffies(100);
+	while (spi->rx_left) {
+		if (time_after(jiffies, timeout))
+			return -ETIMEDOUT;
+		jz4740_spi_pio_drain(spi);
+		cpu_relax();
+	}
+
+	return 0;
+}
+
+/* DMA */
+
+static void jz4740_spi_dma_callback(void *data)
+{
+	struct jz4740_spi *spi = data;
+
+	/*
+	 * The transmit channel is done once the last word is in the FIFO, so
+	 * wait for it to be shifted out unless the receive channel, which
+	 * only finishes after that, is running as well.
+	 */
+	if (!spi->dma_rx_active && jz4740_spi_wait_idle(spi))
+		dev_warn(&spi->master->dev, "Timeout waiting for FIFO to drain\n");
+
+	spi_finalize_current_transfer(spi->master);
+}
+
+static int jz4740_spi_config_dma_channel(struct jz4740_spi *spi,
+	struct dma_chan *chan, enum dma_transfer_direction direction)
+{
+	struct dma_slave_config conf = {
+		.direction = direction,
+		.src_addr_width = spi->word_size,
+		.dst_addr_width = spi->word_size,
+		.src_maxburst = spi->word_size,
+		.dst_maxburst = spi->word_size,
+	};
+
+	if (direction == DMA_MEM_TO_DEV) {
+		conf.dst_addr = spi->mem_res->start + JZ_REG_SSI_DATA;
+		conf.slave_id = JZ4740_DMA_TYPE_SPI_TRANSMIT;
+	} else {
+		conf.src_addr = spi->mem_res->start + JZ_REG_SSI_DATA;
+		conf.slave_id = JZ4740_DMA_TYPE_SPI_RECEIVE;
+	}
+
+	return dmaengine_slave_config(chan, &conf);
+}
+
+static struct dma_async_tx_descriptor *jz4740_spi_prep_dma(
+	struct jz4740_spi *spi, struct dma_chan *chan, struct sg_table *sgt,
+	enum dma_transfer_direction direction, bool callback)
+{
+	struct dma_async_tx_descriptor *desc;
+	int ret;
+
+	ret = jz4740_spi_config_dma_channel(spi, chan, direction);
+	if (ret)
+		return NULL;
+
+	desc = dmaengine_prep_slave_sg(chan, sgt->sgl, sgt->nents, direction,
+		callback ? DMA_PREP_INTERRUPT | DMA_CTRL_ACK : DMA_CTRL_ACK);
+	if (!desc)
+		return NULL;
+
+	if (callback) {
+		desc->callback = jz4740_spi_dma_callback;
+		desc->callback_param = spi;
+	}
+
+	return desc;
+}
+
+static int jz4740_spi_transfer_dma(struct jz4740_spi *spi,
+	struct spi_transfer *xfer)
+{
+	struct spi_master *master = spi->master;
+	struct dma_async_tx_descriptor *rx_desc = NULL;
+	struct dma_async_tx_descriptor *tx_desc;
+
+	spi->dma_rx_active = xfer->rx_buf != NULL;
+
+	if (spi->dma_rx_active) {
+		rx_desc = jz4740_spi_prep_dma(spi, master->dma_rx,
+			&xfer->rx_sg, DMA_DEV_TO_MEM, true);
+		if (!rx_desc)
+			return -EIO;
+	}
+
+	tx_desc = jz4740_spi_prep_dma(spi, master->dma_tx, &xfer->tx_sg,
+		DMA_MEM_TO_DEV, !spi->dma_rx_active);
+	if (!tx_desc) {
+		if (rx_desc)
+			dmaengine_terminate_all(master->dma_rx);
+		return -EIO;
+	}
+
+	/* Without a receive buffer there is nobody to empty the FIFO */
+	jz4740_spi_ctrl0_update(spi, JZ_SSI_CTRL0_DISABLE_RX,
+		spi->dma_rx_active ? 0 : JZ_SSI_CTRL0_DISABLE_RX);
+
+	if (rx_desc) {
+		dmaengine_submit(rx_desc);
+		dma_async_issue_pending(master->dma_rx);
+	}
+	dmaengine_submit(tx_desc);
+	dma_async_issue_pending(master->dma_tx);
+
+	return 1;
+}
+
+static bool jz4740_spi_can_dma(struct spi_master *master,
+	struct spi_device *spi_dev, struct spi_transfer *xfer)
+{
+	unsigned int bits = xfer->bits_per_word ?: spi_dev->bits_per_word;
+	unsigned int align = bits > 8 ? 2 : 1;
+
+	if (xfer->len < JZ4740_SPI_DMA_MIN_SIZE)
+		return false;
+
+	return IS_ALIGNED((unsigned long)xfer->tx_buf, align) &&
+		IS_ALIGNED((unsigned long)xfer->rx_buf, align);
+}
+
+/* Transfers */
+
+static void jz4740_spi_set_speed(struct jz4740_spi *spi, u32 speed_hz)
+{
+	unsigned long rate = clk_get_rate(spi->clk);
+	unsigned int div;
+
+	if (speed_hz == spi->speed_hz)
+		return;
+
+	div = DIV_ROUND_UP(rate, 2 * speed_hz);
+	div = clamp(div, 1U, (unsigned int)JZ4740_SPI_MAX_DIV);
+
+	jz4740_spi_write(spi, JZ_REG_SSI_GR, div - 1);
+	spi->speed_hz = speed_hz;
+}
+
+static void jz4740_spi_set_bits_per_word(struct jz4740_spi *spi, u8 bits)
+{
+	uint32_t ctrl1;
+
+	spi->word_size = bits > 8 ? 2 : 1;
+
+	if (bits == spi->bits_per_word)
+		return;
+
+	ctrl1 = jz4740_spi_read(spi, JZ_REG_SSI_CTRL1);
+	ctrl1 &= ~JZ_SSI_CTRL1_FLEN_MASK;
+	ctrl1 |= (bits - 2) << JZ_SSI_CTRL1_FLEN_OFFSET;
+	jz4740_spi_write(spi, JZ_REG_SSI_CTRL1, ctrl1);
+
+	spi->bits_per_word = bits;
+}
+
+static int jz4740_spi_transfer_one(struct spi_master *master,
+	struct spi_device *spi_dev, struct spi_transfer *xfer)
+{
+	struct jz4740_spi *spi = spi_master_get_devdata(master);
+
+	jz4740_spi_set_speed(spi, xfer->speed_hz);
+	jz4740_spi_set_bits_per_word(spi, xfer->bits_per_word);
+	jz4740_spi_flush(spi);
+
+	if (master->can_dma && master->can_dma(master, spi_dev, xfer))
+		return jz4740_spi_transfer_dma(spi, xfer);
+
+	return jz4740_spi_transfer_pio(spi, xfer);
+}
+
+static void jz4740_spi_handle_err(struct jz4740_spi *spi)
+{
+	struct spi_master *master = spi->master;
+
+	jz4740_spi_ctrl0_update(spi, JZ_SSI_CTRL0_RX_IRQ, 0);
+	if (master->can_dma) {
+		dmaengine_terminate_all(master->dma_tx);
+		dmaengine_terminate_all(master->dma_rx);
+	}
+	jz4740_spi_flush(spi);
+}
+
+static int jz4740_spi_unprepare_message(struct spi_master *master,
+	struct spi_message *msg)
+{
+	struct jz4740_spi *spi = spi_master_get_devdata(master);
+
+	if (msg->status)
+		jz4740_spi_handle_err(spi);
+
+	return 0;
+}
+
+static int jz4740_spi_prepare_message(struct spi_master *master,
+	struct spi_message *msg)
+{
+	struct jz4740_spi *spi = spi_master_get_devdata(master);
+	struct spi_device *spi_dev = msg->spi;
+	uint32_t ctrl1;
+
+	ctrl1 = jz4740_spi_read(spi, JZ_REG_SSI_CTRL1);
+	ctrl1 &= ~(JZ_SSI_CTRL1_CPOL | JZ_SSI_CTRL1_CPHA |
+		JZ_SSI_CTRL1_LSB_FIRST);
+
+	if (spi_dev->mode & SPI_CPOL)
+		ctrl1 |= JZ_SSI_CTRL1_CPOL;
+	if (spi_dev->mode & SPI_CPHA)
+		ctrl1 |= JZ_SSI_CTRL1_CPHA;
+	if (spi_dev->mode & SPI_LSB_FIRST)
+		ctrl1 |= JZ_SSI_CTRL1_LSB_FIRST;
+
+	jz4740_spi_write(spi, JZ_REG_SSI_CTRL1, ctrl1);
+
+	return 0;
+}
+
+static int jz4740_spi_prepare_hardware(struct spi_master *master)
+{
+	struct jz4740_spi *spi = spi_master_get_devdata(master);
+	int ret;
+
+	ret = clk_prepare_enable(spi->clk);
+	if (ret)
+		return ret;
+
+	/* The registers are not kept over suspend, start from scratch */
+	jz4740_spi_write(spi, JZ_REG_SSI_CTRL1, 0);
+	jz4740_spi_write(spi, JZ_REG_SSI_CTRL0, JZ_SSI_CTRL0_ENABLE);
+	jz4740_spi_flush(spi);
+	spi->speed_hz = 0;
+	spi->bits_per_word = 0;
+
+	return 0;
+}
+
+static int jz4740_spi_unprepare_hardware(struct spi_master *master)
+{
+	struct jz4740_spi *spi = spi_master_get_devdata(master);
+
+	jz4740_spi_ctrl0_update(spi, JZ_SSI_CTRL0_ENABLE, 0);
+	clk_disable_unprepare(spi->clk);
+
+	return 0;
+}
+
+static int jz4740_spi_setup(struct spi_device *spi_dev)
+{
+	if (!gpio_is_valid(spi_dev->cs_gpio)) {
+		dev_err(&spi_dev->dev, "No chip select GPIO for chip select %d\n",
+			spi_dev->chip_select);
+		return -EINVAL;
+	}
+
+	gpio_set_value(spi_dev->cs_gpio, !(spi_dev->mode & SPI_CS_HIGH));
+
+	return 0;
+}
+
+static void jz4740_spi_release_dma_channels(struct spi_master *master)
+{
+	if (!master->can_dma)
+		return;
+
+	dma_release_channel(master->dma_tx);
+	dma_release_channel(master->dma_rx);
+}
+
+static int jz4740_spi_acquire_dma_channels(struct spi_master *master)
+{
+	dma_cap_mask_t mask;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_SLAVE, mask);
+
+	master->dma_tx = dma_request_channel(mask, NULL, NULL);
+	if (!master->dma_tx) {
+		dev_warn(&master->dev, "Failed to get dma_tx channel\n");
+		return -EBUSY;
+	}
+
+	master->dma_rx = dma_request_channel(mask, NULL, NULL);
+	if (!master->dma_rx) {
+		dev_warn(&master->dev, "Failed to get dma_rx channel\n");
+		dma_release_channel(master->dma_tx);
+		return -EBUSY;
+	}
+
+	master->can_dma = jz4740_spi_can_dma;
+	master->max_dma_len = dma_get_max_seg_size(
+		master->dma_tx->device->dev);
+
+	return 0;
+}
+
+static const struct jz_gpio_bulk_request jz4740_spi_pins[] = {
+	JZ_GPIO_BULK_PIN(SPI_CLK),
+	JZ_GPIO_BULK_PIN(SPI_DT),
+	JZ_GPIO_BULK_PIN(SPI_DR),
+};
+
+static int jz4740_spi_request_chipselects(struct platform_device *pdev,
+	struct spi_master *master, struct jz4740_spi_platform_data *pdata)
+{
+	unsigned int i;
+	int ret;
+
+	master->num_chipselect = pdata->num_chipselect;
+	master->cs_gpios = devm_kcalloc(&pdev->dev, pdata->num_chipselect,
+		sizeof(int), GFP_KERNEL);
+	if (!master->cs_gpios)
+		return -ENOMEM;
+
+	for (i = 0; i < pdata->num_chipselect; i++) {
+		master->cs_gpios[i] = pdata->chipselects[i];
+		if (!gpio_is_valid(pdata->chipselects[i]))
+			continue;
+
+		ret = devm_gpio_request_one(&pdev->dev, pdata->chipselects[i],
+			GPIOF_OUT_INIT_HIGH, dev_name(&pdev->dev));
+		if (ret) {
+			dev_err(&pdev->dev, "Failed to request chip select %u: %d\n",
+				i, ret);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static int jz4740_spi_probe(struct platform_device *pdev)
+{
+	struct jz4740_spi_platform_data *pdata = pdev->dev.platform_data;
+	struct spi_master *master;
+	struct jz4740_spi *spi;
+	unsigned long rate;
+	int ret;
+
+	if (!pdata || !pdata->num_chipselect) {
+		dev_err(&pdev->dev, "No platform data\n");
+		return -EINVAL;
+	}
+
+	master = spi_alloc_master(&pdev->dev, sizeof(*spi));
+	if (!master) {
+		dev_err(&pdev->dev, "Failed to alloc spi master\n");
+		return -ENOMEM;
+	}
+
+	spi = spi_master_get_devdata(master);
+	spi->master = master;
+
+	spi->irq = platform_get_irq(pdev, 0);
+	if (spi->irq < 0) {
+		ret = spi->irq;
+		dev_err(&pdev->dev, "Failed to get platform irq: %d\n", ret);
+		goto err_put_master;
+	}
+
+	spi->clk = devm_clk_get(&pdev->dev, "spi");
+	if (IS_ERR(spi->clk)) {
+		ret = PTR_ERR(spi->clk);
+		dev_err(&pdev->dev, "Failed to get spi clock\n");
+		goto err_put_master;
+	}
+
+	spi->mem_res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+	spi->base = devm_ioremap_resource(&pdev->dev, spi->mem_res);
+	if (IS_ERR(spi->base)) {
+		ret = PTR_ERR(spi->base);
+		goto err_put_master;
+	}
+
+	ret = jz4740_spi_request_chipselects(pdev, master, pdata);
+	if (ret)
+		goto err_put_master;
+
+	ret = jz_gpio_bulk_request(jz4740_spi_pins,
+		ARRAY_SIZE(jz4740_spi_pins));
+	if (ret) {
+		dev_err(&pdev->dev, "Failed to request spi pins: %d\n", ret);
+		goto err_put_master;
+	}
+
+	ret = devm_request_irq(&pdev->dev, spi->irq, jz4740_spi_irq, 0,
+		dev_name(&pdev->dev), spi);
+	if (ret) {
+		dev_err(&pdev->dev, "Failed to request irq: %d\n", ret);
+		goto err_gpio_bulk_free;
+	}
+
+	rate = clk_get_rate(spi->clk);
+
+	master->bus_num = pdev->id;
+	master->mode_bits = SPI_CPOL | SPI_CPHA | SPI_CS_HIGH | SPI_LSB_FIRST;
+	master->bits_per_word_mask = SPI_BPW_RANGE_MASK(2, 16);
+	master->flags = SPI_MASTER_MUST_TX;
+	master->max_speed_hz = rate / 2;
+	master->min_speed_hz = DIV_ROUND_UP(rate, 2 * JZ4740_SPI_MAX_DIV);
+	master->setup = jz4740_spi_setup;
+	master->prepare_transfer_hardware = jz4740_spi_prepare_hardware;
+	master->unprepare_transfer_hardware = jz4740_spi_unprepare_hardware;
+	master->prepare_message = jz4740_spi_prepare_message;
+	master->unprepare_message = jz4740_spi_unprepare_message;
+	master->transfer_one = jz4740_spi_transfer_one;
+
+	if (jz4740_spi_acquire_dma_channels(master))
+		dev_info(&pdev->dev, "Using PIO only\n");
+
+	platform_set_drvdata(pdev, master);
+
+	ret = spi_register_master(master);
+	if (ret) {
+		dev_err(&pdev->dev, "Failed to register spi master: %d\n", ret);
+		goto err_release_dma;
+	}
+
+	return 0;
+
+err_release_dma:
+	jz4740_spi_release_dma_channels(master);
+err_gpio_bulk_free:
+	jz_gpio_bulk_free(jz4740_spi_pins, ARRAY_SIZE(jz4740_spi_pins));
+err_put_master:
+	spi_master_put(master);
+
+	return ret;
+}
+
+static int jz4740_spi_remove(struct platform_device *pdev)
+{
+	struct spi_master *master = spi_master_get(platform_get_drvdata(pdev));
+
+	spi_unregister_master(master);
+	jz4740_spi_release_dma_channels(master);
+	jz_gpio_bulk_free(jz4740_spi_pins, ARRAY_SIZE(jz4740_spi_pins));
+	spi_master_put(master);
+
+	return 0;
+}
+
+#ifdef CONFIG_PM_SLEEP
+
+static int jz4740_spi_suspend(struct device *dev)
+{
+	struct spi_master *master = dev_get_drvdata(dev);
+	int ret;
+
+	ret = spi_master_suspend(master);
+	if (ret)
+		return ret;
+
+	jz_gpio_bulk_suspend(jz4740_spi_pins, ARRAY_SIZE(jz4740_spi_pins));
+
+	return 0;
+}
+
+static int jz4740_spi_resume(struct device *dev)
+{
+	struct spi_master *master = dev_get_drvdata(dev);
+
+	jz_gpio_bulk_resume(jz4740_spi_pins, ARRAY_SIZE(jz4740_spi_pins));
+
+	return spi_master_resume(master);
+}
+
+static SIMPLE_DEV_PM_OPS(jz4740_spi_pm_ops, jz4740_spi_suspend,
+	jz4740_spi_resume);
+#define JZ4740_SPI_PM_OPS (&jz4740_spi_pm_ops)
+#else
+#define JZ4740_SPI_PM_OPS NULL
+#endif
+
+static struct platform_driver jz4740_spi_driver = {
+	.probe = jz4740_spi_probe,
+	.remove = jz4740_spi_remove,
+	.driver = {
+		.name = "jz4740-spi",
+		.owner = THIS_MODULE,
+		.pm = JZ4740_SPI_PM_OPS,
+	},
+};
+
+module_platform_driver(jz4740_spi_driver);
+
+MODULE_DESCRIPTION("JZ4740 SSI (SPI) controller driver");
+MODULE_LICENSE("GPL");
+MODULE_ALIAS("platform:jz4740-spi");
@@ -0,0 +1,292 @@
+/*
+ * JZ4740 board thermal zone
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under  the terms of the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * The JZ4740 has no temperature sensor of its own. Boards can wire a
+ * thermistor next to the SoC to the ADCIN pin of the ADC instead, and the
+ * voltage measured there is turned into a temperature through a curve given
+ * by the board. Above the passive trip point the CPU and memory bus clocks
+ * are throttled, at the critical trip point the system is shut down before
+ * the hardware resets itself.
+ */
+
+#include <linux/completion.h>
+#include <linux/err.h>
+#include <linux/interrupt.h>
+#include <linux/io.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/platform_device.h>
+#include <linux/thermal.h>
+
+#include <linux/mfd/core.h>
+#include <linux/jz4740-adc.h>
+
+#define JZ4740_THERMAL_PASSIVE_DELAY	1000
+#define JZ4740_THERMAL_POLLING_DELAY	5000
+
+enum jz4740_thermal_trip {
+	JZ4740_THERMAL_TRIP_PASSIVE,
+	JZ4740_THERMAL_TRIP_CRITICAL,
+	JZ4740_THERMAL_NUM_TRIPS,
+};
+
+struct jz4740_thermal {
+	struct platform_device *pdev;
+	const struct mfd_cell *cell;
+	const struct jz4740_thermal_platform_data *pdata;
+
+	void __iomem *base;
+	int irq;
+
+	struct completion read_completion;
+	struct mutex lock;
+
+	struct thermal_zone_device *zone;
+};
+
+static irqreturn_t jz4740_thermal_irq(int irq, void *data)
+{
+	struct jz4740_thermal *thermal = data;
+
+	complete(&thermal->read_completion);
+
+	return IRQ_HANDLED;
+}
+
+static int jz4740_thermal_read_mv(struct jz4740_thermal *thermal,
+	unsigned int *mv)
+{
+	struct platform_device *pdev = thermal->pdev;
+	long t;
+	int ret = 0;
+
+	mutex_lock(&thermal->lock);
+
+	reinit_completion(&thermal->read_completion);
+
+	enable_irq(thermal->irq);
+	thermal->cell->enable(pdev);
+
+	t = wait_for_completion_interruptible_timeout(&thermal->read_completion,
+						      HZ);
+	if (t > 0)
+		*mv = ((readw(thermal->base) & 0xfff) * 3300) >> 12;
+	else
+		ret = t ? t : -ETIMEDOUT;
+
+	thermal->cell->disable(pdev);
+	disable_irq(thermal->irq);
+
+	mutex_unlock(&thermal->lock);
+
+	return ret;
+}
+
+/* Linear interpolation between the points of the board's curve */
+static int jz4740_thermal_mv_to_temp(const struct jz4740_thermal_platform_data
+	*pdata, unsigned int mv)
+{
+	const struct jz4740_thermal_point *lo, *hi;
+	unsigned int i;
+
+	if (mv <= pdata->points[0].mv)
+		return pdata->points[0].temp;
+
+	for (i = 1; i < pdata->num_points; ++i) {
+		if (mv <= pdata->points[i].mv)
+			break;
+	}
+	if (i == pdata->num_points)
+		return pdata->points[i - 1].temp;
+
+	lo = &pdata->points[i - 1];
+	hi = &pdata->points[i];
+
+	return lo->temp + (int)(mv - lo->mv) * (hi->temp - lo->temp) /
+		(int)(hi->mv - lo->mv);
+}
+
+static int jz4740_thermal_get_temp(struct thermal_zone_device *zone,
+	unsigned long *temp)
+{
+	struct jz4740_thermal *thermal = zone->devdata;
+	unsigned int mv;
+	int ret;
+
+	ret = jz4740_thermal_read_mv(thermal, &mv);
+	if (ret)
+		return ret;
+
+	/* The thermal core has no notion of temperatures below 0 degrees */
+	*temp = max(jz4740_thermal_mv_to_temp(thermal->pdata, mv), 0);
+
+	return 0;
+}
+
+static int jz4740_thermal_get_trip_type(struct thermal_zone_device *zone,
+	int trip, enum thermal_trip_type *type)
+{
+	switch (trip) {
+	case JZ4740_THERMAL_TRIP_PASSIVE:
+		*type = THERMAL_TRIP_PASSIVE;
+		break;
+	case JZ4740_THERMAL_TRIP_CRITICAL:
+		*type = THERMAL_TRIP_CRITICAL;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int jz4740_thermal_get_trip_temp(struct thermal_zone_device *zone,
+	int trip, unsigned long *temp)
+{
+	struct jz4740_thermal *thermal = zone->devdata;
+
+	switch (trip) {
+	case JZ4740_THERMAL_TRIP_PASSIVE:
+		*temp = thermal->pdata->passive_temp;
+		break;
+	case JZ4740_THERMAL_TRIP_CRITICAL:
+		*temp = thermal->pdata->critical_temp;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int jz4740_thermal_get_crit_temp(struct thermal_zone_device *zone,
+	unsigned long *temp)
+{
+	return jz4740_thermal_get_trip_temp(zone, JZ4740_THERMAL_TRIP_CRITICAL,
+					    temp);
+}
+
+/* The CPU and memory bus clocks are the only things that can be throttled */
+static bool jz4740_thermal_is_cooling_dev(struct thermal_cooling_device *cdev)
+{
+	return !strncmp(cdev->type, "thermal-cpufreq", 15) ||
+		!strcmp(cdev->type, "jz4740-devfreq");
+}
+
+static int jz4740_thermal_bind(struct thermal_zone_device *zone,
+	struct thermal_cooling_device *cdev)
+{
+	if (!jz4740_thermal_is_cooling_dev(cdev))
+		return 0;
+
+	return thermal_zone_bind_cooling_device(zone,
+			JZ4740_THERMAL_TRIP_PASSIVE, cdev, THERMAL_NO_LIMIT,
+			THERMAL_NO_LIMIT);
+}
+
+static int jz4740_thermal_unbind(struct thermal_zone_device *zone,
+	struct thermal_cooling_device *cdev)
+{
+	if (!jz4740_thermal_is_cooling_dev(cdev))
+		return 0;
+
+	return thermal_zone_unbind_cooling_device(zone,
+			JZ4740_THERMAL_TRIP_PASSIVE, cdev);
+}
+
+static struct thermal_zone_device_ops jz4740_thermal_ops = {
+	.bind = jz4740_thermal_bind,
+	.unbind = jz4740_thermal_unbind,
+	.get_temp = jz4740_thermal_get_temp,
+	.get_trip_type = jz4740_thermal_get_trip_type,
+	.get_trip_temp = jz4740_thermal_get_trip_temp,
+	.get_crit_temp = jz4740_thermal_get_crit_temp,
+};
+
+static int jz4740_thermal_probe(struct platform_device *pdev)
+{
+	struct jz4740_thermal *thermal;
+	struct resource *mem;
+	int ret;
+
+	thermal = devm_kzalloc(&pdev->dev, sizeof(*thermal), GFP_KERNEL);
+	if (!thermal)
+		return -ENOMEM;
+
+	thermal->pdev = pdev;
+	thermal->cell = mfd_get_cell(pdev);
+	thermal->pdata = dev_get_platdata(&pdev->dev);
+	if (!thermal->pdata || !thermal->pdata->num_points) {
+		dev_err(&pdev->dev, "No thermistor curve given\n");
+		return -EINVAL;
+	}
+
+	thermal->irq = platform_get_irq(pdev, 0);
+	if (thermal->irq < 0) {
+		dev_err(&pdev->dev, "Failed to get platform irq: %d\n",
+			thermal->irq);
+		return thermal->irq;
+	}
+
+	mem = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+	thermal->base = devm_ioremap_resource(&pdev->dev, mem);
+	if (IS_ERR(thermal->base))
+		return PTR_ERR(thermal->base);
+
+	init_completion(&thermal->read_completion);
+	mutex_init(&thermal->lock);
+
+	platform_set_drvdata(pdev, thermal);
+
+	ret = devm_request_irq(&pdev->dev, thermal->irq, jz4740_thermal_irq, 0,
+			       pdev->name, thermal);
+	if (ret) {
+		dev_err(&pdev->dev, "Failed to request irq: %d\n", ret);
+		return ret;
+	}
+	disable_irq(thermal->irq);
+
+	thermal->zone = thermal_zone_device_register("jz4740-thermal",
+			JZ4740_THERMAL_NUM_TRIPS, 0, thermal,
+			&jz4740_thermal_ops, NULL,
+			JZ4740_THERMAL_PASSIVE_DELAY,
+			JZ4740_THERMAL_POLLING_DELAY);
+	if (IS_ERR(thermal->zone)) {
+		ret = PTR_ERR(thermal->zone);
+		dev_err(&pdev->dev, "Failed to register thermal zone: %d\n",
+			ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+static int jz4740_thermal_remove(struct platform_device *pdev)
+{
+	struct jz4740_thermal *thermal = platform_get_drvdata(pdev);
+
+	thermal_zone_device_unregister(thermal->zone);
+
+	return 0;
+}
+
+static struct platform_driver jz4740_thermal_driver = {
+	.probe	= jz4740_thermal_probe,
+	.remove = jz4740_thermal_remove,
+	.driver = {
+		.name = "jz4740-thermal",
+		.owner = THIS_MODULE,
+	},
+};
+
+module_platform_driver(jz4740_thermal_driver);
+
+MODULE_DESCRIPTION("JZ4740 board thermal zone driver");
+MODULE_LICENSE("GPL");
+MODULE_ALIAS("platform:jz4740-thermal");
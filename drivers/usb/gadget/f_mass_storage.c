@@ -208,6 +208,7 @@
 #include <linux/kref.h>
 #include <linux/kthread.h>
 #include <linux/limits.h>
+#include <linux/pagemap.h>
 #include <linux/rwsem.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
@@ -628,6 +629,40 @@ static int sleep_thread(struct fsg_common *common, bool can_freeze)
 
 /*-------------------------------------------------------------------------*/
 
+/*
+ * The thread copies between the backing file and the USB buffers one
+ * buffer at a time.  Submit the disk I/O for the whole command up front,
+ * so that it overlaps with the transfers of the first buffers, rather than
+ * leaving each vfs_read() to wait for its own piece.
+ */
+static void fsg_lun_readahead(struct fsg_lun *curlun, loff_t offset, u32 len)
+{
+	struct file	*filp = curlun->filp;
+	pgoff_t		first, last;
+
+	len = min((loff_t)len, curlun->file_length - offset);
+	if (!len)
+		return;
+
+	first = offset >> PAGE_CACHE_SHIFT;
+	last = (offset + len - 1) >> PAGE_CACHE_SHIFT;
+	page_cache_sync_readahead(filp->f_mapping, &filp->f_ra, filp,
+				  first, last - first + 1);
+}
+
+/*
+ * Likewise start writeback of what a command wrote as soon as it is done,
+ * instead of letting dirty pages pile up until the thread gets throttled
+ * in the middle of a later command.
+ */
+static void fsg_lun_writebehind(struct fsg_lun *curlun, loff_t offset,
+				loff_t end)
+{
+	if (end > offset && !(curlun->filp->f_flags & O_SYNC))
+		filemap_fdatawrite_range(curlun->filp->f_mapping, offset,
+					 end - 1);
+}
+
 static int do_read(struct fsg_common *common)
 {
 	struct fsg_lun		*curlun = common->curlun;
@@ -669,6 +704,8 @@ static int do_read(struct fsg_common *common)
 	if (unlikely(amount_left == 0))
 		return -EIO;		/* No default reply */
 
+	fsg_lun_readahead(curlun, file_offset, amount_left);
+
 	for (;;) {
 		/*
 		 * Figure out how much we need to read:
@@ -767,6 +804,7 @@ static int do_write(struct fsg_common *common)
 	int			get_some_more;
 	u32			amount_left_to_req, amount_left_to_write;
 	loff_t			usb_offset, file_offset, file_offset_tmp;
+	loff_t			first_offset;
 	unsigned int		amount;
 	ssize_t			nwritten;
 	int			rc;
@@ -812,6 +850,7 @@ static int do_write(struct fsg_common *common)
 	/* Carry out the file writes */
 	get_some_more = 1;
 	file_offset = usb_offset = ((loff_t) lba) << curlun->blkbits;
+	first_offset = file_offset;
 	amount_left_to_req = common->data_size_from_cmnd;
 	amount_left_to_write = common->data_size_from_cmnd;
 
@@ -943,6 +982,7 @@ static int do_write(struct fsg_common *common)
 			return rc;
 	}
 
+	fsg_lun_writebehind(curlun, first_offset, file_offset);
 	return -EIO;		/* No default reply */
 }
 
@@ -2653,13 +2693,15 @@ void fsg_common_put(struct fsg_common *common)
 }
 EXPORT_SYMBOL_GPL(fsg_common_put);
 
+#define FSG_MAX_NUM_BUFFERS	32
+
 /* check if fsg_num_buffers is within a valid range */
 static inline int fsg_num_buffers_validate(unsigned int fsg_num_buffers)
 {
-	if (fsg_num_buffers >= 2 && fsg_num_buffers <= 4)
+	if (fsg_num_buffers >= 2 && fsg_num_buffers <= FSG_MAX_NUM_BUFFERS)
 		return 0;
 	pr_err("fsg_num_buffers %u is out of range (%d to %d)\n",
-	       fsg_num_buffers, 2, 4);
+	       fsg_num_buffers, 2, FSG_MAX_NUM_BUFFERS);
 	return -EINVAL;
 }
 
@@ -48,6 +48,9 @@ enum ncm_notify_state {
 	NCM_NOTIFY_SPEED,		/* issue SPEED_CHANGE next */
 };
 
+/* datagrams per NTB sent to the host */
+#define TX_MAX_NUM_DPE		32
+
 struct f_ncm {
 	struct gether			port;
 	u8				ctrl_id, data_id;
@@ -63,6 +66,16 @@ struct f_ncm {
 	bool				is_crc;
 	u32				ndp_sign;
 
+	/* NTB being filled with datagrams for the host */
+	struct net_device		*netdev;
+	struct sk_buff			*skb_tx_data;
+	struct gether_batch_bufs	ntb_bufs;
+	unsigned			tx_dgram_count;
+	struct {
+		u32			index;
+		u32			len;
+	}				tx_dgram[TX_MAX_NUM_DPE];
+
 	/*
 	 * for notification, it is accessed from both
 	 * callback and ethernet open/close
@@ -87,20 +100,21 @@ static inline unsigned ncm_bitrate(struct usb_gadget *g)
 /*-------------------------------------------------------------------------*/
 
 /*
- * We cannot group frames so use just the minimal size which ok to put
- * one max-size ethernet frame.
- * If the host can group frames, allow it to do that, 16K is selected,
- * because it's used by default by the current linux host driver
+ * Both we and the host group frames into NTBs, 16K is selected,
+ * because it's used by default by the current linux host driver.
+ * Both sizes can be tuned, the host may still ask for smaller
+ * NTBs in its direction.
  */
-#define NTB_DEFAULT_IN_SIZE	USB_CDC_NCM_NTB_MIN_IN_SIZE
+#define NTB_DEFAULT_IN_SIZE	16384
 #define NTB_OUT_SIZE		16384
 
-/*
- * skbs of size less than that will not be aligned
- * to NCM's dwNtbInMaxSize to save bus bandwidth
- */
+static unsigned ntb_in_size = NTB_DEFAULT_IN_SIZE;
+module_param(ntb_in_size, uint, S_IRUGO);
+MODULE_PARM_DESC(ntb_in_size, "max size of NTBs sent to the host");
 
-#define	MAX_TX_NONFIXED		(512 * 3)
+static unsigned ntb_out_size = NTB_OUT_SIZE;
+module_param(ntb_out_size, uint, S_IRUGO);
+MODULE_PARM_DESC(ntb_out_size, "max size of NTBs received from the host");
 
 #define FORMATS_SUPPORTED	(USB_CDC_NCM_NTB16_SUPPORTED |	\
 				 USB_CDC_NCM_NTB32_SUPPORTED)
@@ -445,7 +459,16 @@ static inline void ncm_reset_values(struct f_ncm *ncm)
 	ncm->port.header_len = 0;
 
 	ncm->port.fixed_out_len = le32_to_cpu(ntb_parameters.dwNtbOutMaxSize);
-	ncm->port.fixed_in_len = NTB_DEFAULT_IN_SIZE;
+	ncm->port.fixed_in_len = le32_to_cpu(ntb_parameters.dwNtbInMaxSize);
+}
+
+/* called once the port is disconnected, wrap() can't run any more */
+static inline void ncm_free_ntb(struct f_ncm *ncm)
+{
+	if (ncm->skb_tx_data) {
+		dev_kfree_skb_any(ncm->skb_tx_data);
+		ncm->skb_tx_data = NULL;
+	}
 }
 
 /*
@@ -804,6 +827,7 @@ static int ncm_set_alt(struct usb_function *f, unsigned intf, unsigned alt)
 		if (ncm->port.in_ep->driver_data) {
 			DBG(cdev, "reset ncm\n");
 			gether_disconnect(&ncm->port);
+			ncm_free_ntb(ncm);
 			ncm_reset_values(ncm);
 		}
 
@@ -839,6 +863,7 @@ static int ncm_set_alt(struct usb_function *f, unsigned intf, unsigned alt)
 			net = gether_connect(&ncm->port);
 			if (IS_ERR(net))
 				return PTR_ERR(net);
+			ncm->netdev = net;
 		}
 
 		spin_lock(&ncm->lock);
@@ -865,95 +890,142 @@ static int ncm_get_alt(struct usb_function *f, unsigned intf)
 	return ncm->port.in_ep->driver_data ? 1 : 0;
 }
 
+/* NTB length once the NDP for count datagrams is appended */
+static unsigned ncm_ntb_len(struct f_ncm *ncm, unsigned data_len,
+			    unsigned count)
+{
+	const struct ndp_parser_opts *opts = ncm->parser_opts;
+	int		ndp_align = le16_to_cpu(ntb_parameters.wNdpInAlignment);
+
+	/* datagram entries, plus the zero one terminating the NDP */
+	return ALIGN(data_len, ndp_align) + opts->ndp_size +
+		(count + 1) * 2 * 2 * opts->dgram_item_len;
+}
+
+/* append the NDP to the NTB being filled and hand it out */
+static struct sk_buff *ncm_close_ntb(struct f_ncm *ncm)
+{
+	struct sk_buff	*skb = ncm->skb_tx_data;
+	const struct ndp_parser_opts *opts = ncm->parser_opts;
+	int		ndp_align = le16_to_cpu(ntb_parameters.wNdpInAlignment);
+	unsigned	ndp_index = ALIGN(skb->len, ndp_align);
+	unsigned	ndp_len;
+	__le16		*tmp;
+	unsigned	i;
+
+	ndp_len = ncm_ntb_len(ncm, skb->len, ncm->tx_dgram_count) - ndp_index;
+	memset(skb_put(skb, ndp_index - skb->len), 0, ndp_index - skb->len);
+
+	/* NDP */
+	tmp = (void *) skb_put(skb, ndp_len);
+	memset(tmp, 0, ndp_len);
+
+	put_unaligned_le32(ncm->ndp_sign, tmp); /* dwSignature */
+	tmp += 2;
+	/* wLength */
+	put_unaligned_le16(ndp_len, tmp++);
+
+	tmp += opts->reserved1;
+	tmp += opts->next_fp_index; /* skip reserved (d)wNextFpIndex */
+	tmp += opts->reserved2;
+
+	for (i = 0; i < ncm->tx_dgram_count; i++) {
+		/* (d)wDatagramIndex[i] */
+		put_ncm(&tmp, opts->dgram_item_len, ncm->tx_dgram[i].index);
+		/* (d)wDatagramLength[i] */
+		put_ncm(&tmp, opts->dgram_item_len, ncm->tx_dgram[i].len);
+	}
+	/* the terminating zero entry is already zeroed */
+
+	/* skip dwSignature, wHeaderLength and wSequence of the NTH */
+	tmp = (void *) skb->data + 8;
+	put_ncm(&tmp, opts->block_length, skb->len); /* (d)wBlockLength */
+	put_ncm(&tmp, opts->fp_index, ndp_index); /* (d)wFpIndex */
+
+	ncm->skb_tx_data = NULL;
+	return skb;
+}
+
+/*
+ * Datagrams are collected into one NTB, with the NDP at its end, until
+ * the next one doesn't fit; u_ether flushes partial NTBs by passing a
+ * NULL skb.  Returns the NTB to send next, if any.
+ */
 static struct sk_buff *ncm_wrap_ntb(struct gether *port,
 				    struct sk_buff *skb)
 {
 	struct f_ncm	*ncm = func_to_ncm(&port->func);
-	struct sk_buff	*skb2;
-	int		ncb_len = 0;
+	struct sk_buff	*skb2 = NULL;
 	__le16		*tmp;
 	int		div;
 	int		rem;
-	int		pad;
-	int		ndp_align;
-	int		ndp_pad;
+	unsigned	offset;
+	unsigned	dgram_len;
 	unsigned	max_size = ncm->port.fixed_in_len;
 	const struct ndp_parser_opts *opts = ncm->parser_opts;
 	unsigned	crc_len = ncm->is_crc ? sizeof(uint32_t) : 0;
 
+	if (!skb) {
+		if (ncm->skb_tx_data)
+			skb2 = ncm_close_ntb(ncm);
+		return skb2;
+	}
+
 	div = le16_to_cpu(ntb_parameters.wNdpInDivisor);
 	rem = le16_to_cpu(ntb_parameters.wNdpInPayloadRemainder);
-	ndp_align = le16_to_cpu(ntb_parameters.wNdpInAlignment);
-
-	ncb_len += opts->nth_size;
-	ndp_pad = ALIGN(ncb_len, ndp_align) - ncb_len;
-	ncb_len += ndp_pad;
-	ncb_len += opts->ndp_size;
-	ncb_len += 2 * 2 * opts->dgram_item_len; /* Datagram entry */
-	ncb_len += 2 * 2 * opts->dgram_item_len; /* Zero datagram entry */
-	pad = ALIGN(ncb_len, div) + rem - ncb_len;
-	ncb_len += pad;
-
-	if (ncb_len + skb->len + crc_len > max_size) {
-		dev_kfree_skb_any(skb);
-		return NULL;
+	dgram_len = skb->len + crc_len;
+
+	if (ncm->skb_tx_data) {
+		offset = ALIGN(ncm->skb_tx_data->len, div) + rem;
+		if (ncm->tx_dgram_count == TX_MAX_NUM_DPE ||
+		    ncm_ntb_len(ncm, offset + dgram_len,
+				ncm->tx_dgram_count + 1) > max_size)
+			skb2 = ncm_close_ntb(ncm);
 	}
 
-	skb2 = skb_copy_expand(skb, ncb_len,
-			       max_size - skb->len - ncb_len - crc_len,
-			       GFP_ATOMIC);
-	dev_kfree_skb_any(skb);
-	if (!skb2)
-		return NULL;
-
-	skb = skb2;
+	if (!ncm->skb_tx_data) {
+		offset = ALIGN(opts->nth_size, div) + rem;
+		if (ncm_ntb_len(ncm, offset + dgram_len, 1) > max_size)
+			goto drop;
 
-	tmp = (void *) skb_push(skb, ncb_len);
-	memset(tmp, 0, ncb_len);
-
-	put_unaligned_le32(opts->nth_sign, tmp); /* dwSignature */
-	tmp += 2;
-	/* wHeaderLength */
-	put_unaligned_le16(opts->nth_size, tmp++);
-	tmp++; /* skip wSequence */
-	put_ncm(&tmp, opts->block_length, skb->len); /* (d)wBlockLength */
-	/* (d)wFpIndex */
-	/* the first pointer is right after the NTH + align */
-	put_ncm(&tmp, opts->fp_index, opts->nth_size + ndp_pad);
+		ncm->skb_tx_data = gether_batch_get(&ncm->ntb_bufs, max_size);
+		if (!ncm->skb_tx_data)
+			goto drop;
+		ncm->tx_dgram_count = 0;
 
-	tmp = (void *)tmp + ndp_pad;
+		/* NTH, lengths are filled in by ncm_close_ntb() */
+		tmp = (void *) skb_put(ncm->skb_tx_data, opts->nth_size);
+		memset(tmp, 0, opts->nth_size);
 
-	/* NDP */
-	put_unaligned_le32(ncm->ndp_sign, tmp); /* dwSignature */
-	tmp += 2;
-	/* wLength */
-	put_unaligned_le16(ncb_len - opts->nth_size - pad, tmp++);
+		put_unaligned_le32(opts->nth_sign, tmp); /* dwSignature */
+		tmp += 2;
+		/* wHeaderLength */
+		put_unaligned_le16(opts->nth_size, tmp++);
+	}
 
-	tmp += opts->reserved1;
-	tmp += opts->next_fp_index; /* skip reserved (d)wNextFpIndex */
-	tmp += opts->reserved2;
+	offset = ALIGN(ncm->skb_tx_data->len, div) + rem;
+	memset(skb_put(ncm->skb_tx_data, offset - ncm->skb_tx_data->len),
+	       0, offset - ncm->skb_tx_data->len);
+	memcpy(skb_put(ncm->skb_tx_data, skb->len), skb->data, skb->len);
 
 	if (ncm->is_crc) {
 		uint32_t crc;
 
-		crc = ~crc32_le(~0,
-				skb->data + ncb_len,
-				skb->len - ncb_len);
-		put_unaligned_le32(crc, skb->data + skb->len);
-		skb_put(skb, crc_len);
+		crc = ~crc32_le(~0, skb->data, skb->len);
+		put_unaligned_le32(crc, skb_put(ncm->skb_tx_data, crc_len));
 	}
 
-	/* (d)wDatagramIndex[0] */
-	put_ncm(&tmp, opts->dgram_item_len, ncb_len);
-	/* (d)wDatagramLength[0] */
-	put_ncm(&tmp, opts->dgram_item_len, skb->len - ncb_len);
-	/* (d)wDatagramIndex[1] and  (d)wDatagramLength[1] already zeroed */
+	ncm->tx_dgram[ncm->tx_dgram_count].index = offset;
+	ncm->tx_dgram[ncm->tx_dgram_count].len = dgram_len;
+	ncm->tx_dgram_count++;
 
-	if (skb->len > MAX_TX_NONFIXED)
-		memset(skb_put(skb, max_size - skb->len),
-		       0, max_size - skb->len);
+	dev_kfree_skb_any(skb);
+	return skb2;
 
-	return skb;
+drop:
+	ncm->netdev->stats.tx_dropped++;
+	dev_kfree_skb_any(skb);
+	return skb2;
 }
 
 static int ncm_unwrap_ntb(struct gether *port,
@@ -1097,8 +1169,10 @@ static void ncm_disable(struct usb_function *f)
 
 	DBG(cdev, "ncm deactivated\n");
 
-	if (ncm->port.in_ep->driver_data)
+	if (ncm->port.in_ep->driver_data) {
 		gether_disconnect(&ncm->port);
+		ncm_free_ntb(ncm);
+	}
 
 	if (ncm->notify->driver_data) {
 		usb_ep_disable(ncm->notify);
@@ -1368,6 +1442,7 @@ static void ncm_free(struct usb_function *f)
 
 	ncm = func_to_ncm(f);
 	opts = container_of(f->fi, struct f_ncm_opts, func_inst);
+	gether_batch_bufs_free(&ncm->ntb_bufs);
 	kfree(ncm);
 	mutex_lock(&opts->lock);
 	opts->refcnt--;
@@ -1411,6 +1486,13 @@ static struct usb_function *ncm_alloc(struct usb_function_instance *fi)
 	}
 	ncm_string_defs[STRING_MAC_IDX].s = ncm->ethaddr;
 
+	ntb_parameters.dwNtbInMaxSize = cpu_to_le32(clamp_t(unsigned,
+			ntb_in_size, USB_CDC_NCM_NTB_MIN_IN_SIZE, 0xffff));
+	ntb_parameters.dwNtbOutMaxSize = cpu_to_le32(clamp_t(unsigned,
+			ntb_out_size, USB_CDC_NCM_NTB_MIN_OUT_SIZE, 0xffff));
+	gether_batch_bufs_alloc(&ncm->ntb_bufs,
+			le32_to_cpu(ntb_parameters.dwNtbInMaxSize));
+
 	spin_lock_init(&ncm->lock);
 	ncm_reset_values(ncm);
 	ncm->port.ioport = netdev_priv(opts->net);
@@ -1429,6 +1511,7 @@ static struct usb_function *ncm_alloc(struct usb_function_instance *fi)
 
 	ncm->port.wrap = ncm_wrap_ntb;
 	ncm->port.unwrap = ncm_unwrap_ntb;
+	ncm->port.supports_multi_frame = true;
 
 	return &ncm->port.func;
 }
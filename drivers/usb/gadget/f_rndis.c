@@ -69,6 +69,20 @@
  *   - MS-Windows drivers sometimes emit undocumented requests.
  */
 
+/*
+ * RNDIS lets both sides pack several packet messages into one transfer.
+ * The host is told it may batch up to rx_max_pkts frames, and frames for
+ * the host are batched into transfers of up to tx_max_len bytes, further
+ * limited by the MaxTransferSize the host announces.
+ */
+static unsigned rx_max_pkts = 3;
+module_param(rx_max_pkts, uint, S_IRUGO);
+MODULE_PARM_DESC(rx_max_pkts, "frames the host may batch per transfer");
+
+static unsigned tx_max_len = 16384;
+module_param(tx_max_len, uint, S_IRUGO);
+MODULE_PARM_DESC(tx_max_len, "max size of batched transfers, 0 disables");
+
 struct f_rndis {
 	struct gether			port;
 	u8				ctrl_id, data_id;
@@ -371,14 +385,9 @@ static struct usb_gadget_strings *rndis_strings[] = {
 static struct sk_buff *rndis_add_header(struct gether *port,
 					struct sk_buff *skb)
 {
-	struct sk_buff *skb2;
-
-	skb2 = skb_realloc_headroom(skb, sizeof(struct rndis_packet_msg_type));
-	if (skb2)
-		rndis_add_hdr(skb2);
+	struct f_rndis *rndis = func_to_rndis(&port->func);
 
-	dev_kfree_skb_any(skb);
-	return skb2;
+	return rndis_add_hdr_batch(rndis->config, skb);
 }
 
 static void rndis_response_available(void *_rndis)
@@ -619,6 +628,7 @@ static void rndis_disable(struct usb_function *f)
 
 	rndis_uninit(rndis->config);
 	gether_disconnect(&rndis->port);
+	rndis_free_batch(rndis->config);
 
 	usb_ep_disable(rndis->notify);
 	rndis->notify->driver_data = NULL;
@@ -959,6 +969,8 @@ static struct usb_function *rndis_alloc(struct usb_function_instance *fi)
 	rndis->port.header_len = sizeof(struct rndis_packet_msg_type);
 	rndis->port.wrap = rndis_add_header;
 	rndis->port.unwrap = rndis_rm_hdr;
+	rndis->port.supports_multi_frame = true;
+	rndis->port.rx_max_pkts = max(rx_max_pkts, 1U);
 
 	rndis->port.func.name = "rndis";
 	/* descriptors are per-instance copies */
@@ -975,6 +987,7 @@ static struct usb_function *rndis_alloc(struct usb_function_instance *fi)
 		return ERR_PTR(status);
 	}
 	rndis->config = status;
+	rndis_set_param_max_xfer(rndis->config, rx_max_pkts, tx_max_len);
 
 	return &rndis->port.func;
 }
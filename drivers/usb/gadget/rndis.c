@@ -576,6 +576,9 @@ static int rndis_init_response(int configNr, rndis_init_msg_type *buf)
 		return -ENOMEM;
 	resp = (rndis_init_cmplt_type *)r->buf;
 
+	/* the largest transfer we may send to the host */
+	params->host_max_xfer = le32_to_cpu(buf->MaxTransferSize);
+
 	resp->MessageType = cpu_to_le32(RNDIS_MSG_INIT_C);
 	resp->MessageLength = cpu_to_le32(52);
 	resp->RequestID = buf->RequestID; /* Still LE in msg buffer */
@@ -584,12 +587,12 @@ static int rndis_init_response(int configNr, rndis_init_msg_type *buf)
 	resp->MinorVersion = cpu_to_le32(RNDIS_MINOR_VERSION);
 	resp->DeviceFlags = cpu_to_le32(RNDIS_DF_CONNECTIONLESS);
 	resp->Medium = cpu_to_le32(RNDIS_MEDIUM_802_3);
-	resp->MaxPacketsPerTransfer = cpu_to_le32(1);
-	resp->MaxTransferSize = cpu_to_le32(
+	resp->MaxPacketsPerTransfer = cpu_to_le32(params->rx_max_pkts);
+	resp->MaxTransferSize = cpu_to_le32(params->rx_max_pkts * (
 		  params->dev->mtu
 		+ sizeof(struct ethhdr)
 		+ sizeof(struct rndis_packet_msg_type)
-		+ 22);
+		+ 22));
 	resp->PacketAlignmentFactor = cpu_to_le32(0);
 	resp->AFListOffset = cpu_to_le32(0);
 	resp->AFListSize = cpu_to_le32(0);
@@ -903,6 +906,7 @@ void rndis_deregister(int configNr)
 
 	if (configNr >= RNDIS_MAX_CONFIGS) return;
 	rndis_per_dev_params[configNr].used = 0;
+	gether_batch_bufs_free(&rndis_per_dev_params[configNr].tx_bufs);
 }
 EXPORT_SYMBOL(rndis_deregister);
 
@@ -945,6 +949,22 @@ int rndis_set_param_medium(u8 configNr, u32 medium, u32 speed)
 }
 EXPORT_SYMBOL(rndis_set_param_medium);
 
+int rndis_set_param_max_xfer(u8 configNr, u32 rx_max_pkts, u32 tx_max_len)
+{
+	pr_debug("%s: %u %u\n", __func__, rx_max_pkts, tx_max_len);
+	if (configNr >= RNDIS_MAX_CONFIGS) return -1;
+
+	rndis_per_dev_params[configNr].rx_max_pkts = max(rx_max_pkts, 1U);
+	rndis_per_dev_params[configNr].tx_max_len = tx_max_len;
+
+	gether_batch_bufs_free(&rndis_per_dev_params[configNr].tx_bufs);
+	gether_batch_bufs_alloc(&rndis_per_dev_params[configNr].tx_bufs,
+				tx_max_len);
+
+	return 0;
+}
+EXPORT_SYMBOL(rndis_set_param_max_xfer);
+
 void rndis_add_hdr(struct sk_buff *skb)
 {
 	struct rndis_packet_msg_type *header;
@@ -960,6 +980,77 @@ void rndis_add_hdr(struct sk_buff *skb)
 }
 EXPORT_SYMBOL(rndis_add_hdr);
 
+/*
+ * Packs frames into transfers of up to tx_max_len bytes, or the host's
+ * MaxTransferSize if smaller, as RNDIS allows several packet messages per
+ * transfer.  Returns the transfer to send next, if any; the frame itself
+ * may be held back in the current batch.  A NULL skb flushes the batch.
+ * Callers serialize calls for a configuration.
+ */
+struct sk_buff *rndis_add_hdr_batch(u8 configNr, struct sk_buff *skb)
+{
+	struct rndis_params *params = rndis_per_dev_params + configNr;
+	struct rndis_packet_msg_type *header;
+	struct sk_buff *skb2 = NULL;
+	u32 max_len, len;
+
+	if (!skb) {
+		swap(skb2, params->tx_batch);
+		return skb2;
+	}
+
+	max_len = min(params->tx_max_len, params->host_max_xfer);
+	len = ALIGN(sizeof(*header) + skb->len, 4);
+
+	/* no room for two frames, send them one by one */
+	if (!params->tx_batch && 2 * ALIGN(sizeof(*header) + ETH_HLEN +
+					   params->dev->mtu, 4) > max_len) {
+		skb2 = skb_realloc_headroom(skb, sizeof(*header));
+		if (skb2)
+			rndis_add_hdr(skb2);
+		else
+			params->dev->stats.tx_dropped++;
+		dev_kfree_skb_any(skb);
+		return skb2;
+	}
+
+	if (params->tx_batch && params->tx_batch->len + len > max_len)
+		swap(skb2, params->tx_batch);
+
+	if (!params->tx_batch) {
+		params->tx_batch = gether_batch_get(&params->tx_bufs, max_len);
+		if (!params->tx_batch) {
+			params->dev->stats.tx_dropped++;
+			dev_kfree_skb_any(skb);
+			return skb2;
+		}
+	}
+
+	header = (void *)skb_put(params->tx_batch, len);
+	memset(header, 0, len);
+	header->MessageType = cpu_to_le32(RNDIS_MSG_PACKET);
+	header->MessageLength = cpu_to_le32(len);
+	header->DataOffset = cpu_to_le32(36);
+	header->DataLength = cpu_to_le32(skb->len);
+	memcpy(header + 1, skb->data, skb->len);
+	dev_kfree_skb_any(skb);
+
+	return skb2;
+}
+EXPORT_SYMBOL(rndis_add_hdr_batch);
+
+void rndis_free_batch(u8 configNr)
+{
+	struct rndis_params *params = rndis_per_dev_params + configNr;
+
+	if (params->tx_batch) {
+		dev_kfree_skb_any(params->tx_batch);
+		params->tx_batch = NULL;
+	}
+	params->host_max_xfer = 0;
+}
+EXPORT_SYMBOL(rndis_free_batch);
+
 void rndis_free_response(int configNr, u8 *buf)
 {
 	rndis_resp_t *r;
@@ -1020,26 +1111,54 @@ int rndis_rm_hdr(struct gether *port,
 			struct sk_buff *skb,
 			struct sk_buff_head *list)
 {
-	/* tmp points to a struct rndis_packet_msg_type */
-	__le32 *tmp = (void *)skb->data;
+	/* the host may send several packet messages per transfer */
+	for (;;) {
+		/* tmp points to a struct rndis_packet_msg_type */
+		__le32 *tmp = (void *)skb->data;
+		struct sk_buff *skb2;
+		u32 msg_len, data_offset, data_len;
+
+		if (skb->len < 4 * sizeof(*tmp))
+			goto err_overflow;
+
+		/* MessageType, MessageLength */
+		if (cpu_to_le32(RNDIS_MSG_PACKET)
+				!= get_unaligned(tmp++)) {
+			dev_kfree_skb_any(skb);
+			return -EINVAL;
+		}
+		msg_len = get_unaligned_le32(tmp++);
+
+		/* DataOffset, DataLength */
+		data_offset = get_unaligned_le32(tmp++) + 8;
+		data_len = get_unaligned_le32(tmp++);
+		if (data_offset > skb->len || data_len > skb->len - data_offset)
+			goto err_overflow;
+
+		/* anything shorter than another message is padding */
+		if (msg_len < data_offset + data_len ||
+		    msg_len > skb->len - 4 * sizeof(*tmp)) {
+			skb_pull(skb, data_offset);
+			skb_trim(skb, data_len);
+			skb_queue_tail(list, skb);
+			return 0;
+		}
 
-	/* MessageType, MessageLength */
-	if (cpu_to_le32(RNDIS_MSG_PACKET)
-			!= get_unaligned(tmp++)) {
-		dev_kfree_skb_any(skb);
-		return -EINVAL;
-	}
-	tmp++;
+		skb2 = skb_clone(skb, GFP_ATOMIC);
+		if (!skb2) {
+			dev_kfree_skb_any(skb);
+			return -ENOMEM;
+		}
+		skb_pull(skb2, data_offset);
+		skb_trim(skb2, data_len);
+		skb_queue_tail(list, skb2);
 
-	/* DataOffset, DataLength */
-	if (!skb_pull(skb, get_unaligned_le32(tmp++) + 8)) {
-		dev_kfree_skb_any(skb);
-		return -EOVERFLOW;
+		skb_pull(skb, msg_len);
 	}
-	skb_trim(skb, get_unaligned_le32(tmp++));
 
-	skb_queue_tail(list, skb);
-	return 0;
+err_overflow:
+	dev_kfree_skb_any(skb);
+	return -EOVERFLOW;
 }
 EXPORT_SYMBOL(rndis_rm_hdr);
 
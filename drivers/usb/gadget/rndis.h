@@ -194,6 +194,13 @@ typedef struct rndis_params
 	void			(*resp_avail)(void *v);
 	void			*v;
 	struct list_head	resp_queue;
+
+	/* multi packet transfers */
+	u32			rx_max_pkts;
+	u32			tx_max_len;
+	u32			host_max_xfer;
+	struct sk_buff		*tx_batch;
+	struct gether_batch_bufs tx_bufs;
 } rndis_params;
 
 /* RNDIS Message parser and other useless functions */
@@ -205,7 +212,10 @@ int  rndis_set_param_dev (u8 configNr, struct net_device *dev,
 int  rndis_set_param_vendor (u8 configNr, u32 vendorID,
 			    const char *vendorDescr);
 int  rndis_set_param_medium (u8 configNr, u32 medium, u32 speed);
+int  rndis_set_param_max_xfer(u8 configNr, u32 rx_max_pkts, u32 tx_max_len);
 void rndis_add_hdr (struct sk_buff *skb);
+struct sk_buff *rndis_add_hdr_batch(u8 configNr, struct sk_buff *skb);
+void rndis_free_batch(u8 configNr);
 int rndis_rm_hdr(struct gether *port, struct sk_buff *skb,
 			struct sk_buff_head *list);
 u8   *rndis_get_next_response (int configNr, u32 *length);
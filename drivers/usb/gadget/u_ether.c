@@ -20,7 +20,9 @@
 #include <linux/ctype.h>
 #include <linux/etherdevice.h>
 #include <linux/ethtool.h>
+#include <linux/hrtimer.h>
 #include <linux/if_vlan.h>
+#include <linux/interrupt.h>
 
 #include "u_ether.h"
 
@@ -44,10 +46,21 @@
  * responsible for ensuring that each configuration includes at most one
  * instance of is network link.  (The network layer provides ways for
  * this single "physical" link to be used by multiple virtual links.)
+ *
+ * Functions whose framing can carry several Ethernet frames per USB
+ * transfer (RNDIS, NCM) may batch frames in their wrap() hook, since
+ * per-request overhead dominates on slow (e.g. PIO driven) controllers.
+ * Frames are only held back while earlier transfers are in flight, and
+ * are flushed once the batch is full, or at the latest tx_timeout
+ * microseconds after the batch was started.
  */
 
 #define UETH__VERSION	"29-May-2008"
 
+static unsigned tx_timeout = 300;
+module_param(tx_timeout, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(tx_timeout, "usecs before a partial tx batch is sent");
+
 struct eth_dev {
 	/* lock is held while accessing port_usb
 	 */
@@ -73,6 +86,10 @@ struct eth_dev {
 
 	struct work_struct	work;
 
+	/* flushes frames batched by a multi frame wrap() */
+	struct hrtimer		tx_timer;
+	struct tasklet_struct	tx_tasklet;
+
 	unsigned long		todo;
 #define	WORK_RX_MEMORY		0
 
@@ -222,6 +239,8 @@ rx_submit(struct eth_dev *dev, struct usb_request *req, gfp_t gfp_flags)
 	 */
 	size += sizeof(struct ethhdr) + dev->net->mtu + RX_EXTRA;
 	size += dev->port_usb->header_len;
+	if (dev->port_usb->rx_max_pkts > 1)
+		size *= dev->port_usb->rx_max_pkts;
 	size += out->maxpacket - 1;
 	size -= size % out->maxpacket;
 
@@ -483,12 +502,13 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 					struct net_device *net)
 {
 	struct eth_dev		*dev = netdev_priv(net);
-	int			length = skb->len;
+	int			length;
 	int			retval;
 	struct usb_request	*req = NULL;
 	unsigned long		flags;
 	struct usb_ep		*in;
 	u16			cdc_filter;
+	bool			multi_frame = false;
 
 	spin_lock_irqsave(&dev->lock, flags);
 	if (dev->port_usb) {
@@ -501,12 +521,15 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 	spin_unlock_irqrestore(&dev->lock, flags);
 
 	if (!in) {
-		dev_kfree_skb_any(skb);
+		if (skb)
+			dev_kfree_skb_any(skb);
 		return NETDEV_TX_OK;
 	}
 
-	/* apply outgoing CDC or RNDIS filters */
-	if (!is_promisc(cdc_filter)) {
+	/* apply outgoing CDC or RNDIS filters; a NULL skb is a request to
+	 * flush frames batched by wrap(), see eth_tx_flush()
+	 */
+	if (skb && !is_promisc(cdc_filter)) {
 		u8		*dest = skb->data;
 
 		if (is_multicast_ether_addr(dest)) {
@@ -554,14 +577,32 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 		unsigned long	flags;
 
 		spin_lock_irqsave(&dev->lock, flags);
-		if (dev->port_usb)
+		if (dev->port_usb) {
+			bool	batching;
+
+			multi_frame = dev->port_usb->supports_multi_frame;
+			batching = multi_frame && skb;
 			skb = dev->wrap(dev->port_usb, skb);
+
+			/* nothing in flight, holding frames back won't pay */
+			if (batching && !skb && !atomic_read(&dev->tx_qlen))
+				skb = dev->wrap(dev->port_usb, NULL);
+			else if (batching && !hrtimer_active(&dev->tx_timer))
+				hrtimer_start(&dev->tx_timer,
+					      ktime_set(0, tx_timeout * 1000),
+					      HRTIMER_MODE_REL);
+		}
 		spin_unlock_irqrestore(&dev->lock, flags);
-		if (!skb)
+		if (!skb) {
+			/* held back for a batch, or dropped and counted */
+			if (multi_frame)
+				goto unused;
 			goto drop;
-
-		length = skb->len;
+		}
+	} else if (!skb) {
+		goto unused;
 	}
+	length = skb->len;
 	req->buf = skb->data;
 	req->context = skb;
 	req->complete = tx_complete;
@@ -604,6 +645,7 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 		dev_kfree_skb_any(skb);
 drop:
 		dev->net->stats.tx_dropped++;
+unused:
 		spin_lock_irqsave(&dev->req_lock, flags);
 		if (list_empty(&dev->tx_reqs))
 			netif_start_queue(net);
@@ -613,6 +655,36 @@ drop:
 	return NETDEV_TX_OK;
 }
 
+static enum hrtimer_restart eth_tx_timeout(struct hrtimer *timer)
+{
+	struct eth_dev	*dev = container_of(timer, struct eth_dev, tx_timer);
+
+	tasklet_schedule(&dev->tx_tasklet);
+	return HRTIMER_NORESTART;
+}
+
+static void eth_tx_flush(unsigned long data)
+{
+	struct eth_dev	*dev = (struct eth_dev *)data;
+	netdev_tx_t	status;
+
+	netif_tx_lock(dev->net);
+	status = eth_start_xmit(NULL, dev->net);
+	netif_tx_unlock(dev->net);
+
+	/* no free request yet, try again later */
+	if (status == NETDEV_TX_BUSY && netif_running(dev->net))
+		hrtimer_start(&dev->tx_timer, ktime_set(0, tx_timeout * 1000),
+			      HRTIMER_MODE_REL);
+}
+
+static void eth_tx_init(struct eth_dev *dev)
+{
+	hrtimer_init(&dev->tx_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	dev->tx_timer.function = eth_tx_timeout;
+	tasklet_init(&dev->tx_tasklet, eth_tx_flush, (unsigned long)dev);
+}
+
 /*-------------------------------------------------------------------------*/
 
 static void eth_start(struct eth_dev *dev, gfp_t gfp_flags)
@@ -653,6 +725,15 @@ static int eth_stop(struct net_device *net)
 	VDBG(dev, "%s\n", __func__);
 	netif_stop_queue(net);
 
+	/*
+	 * The flush tasklet rearms the timer while no request is free and
+	 * the timer schedules the tasklet, so stop the tasklet first and
+	 * catch one last run queued by a timer that was already firing.
+	 */
+	tasklet_kill(&dev->tx_tasklet);
+	hrtimer_cancel(&dev->tx_timer);
+	tasklet_kill(&dev->tx_tasklet);
+
 	DBG(dev, "stop stats: rx/tx %ld/%ld, errs %ld/%ld\n",
 		dev->net->stats.rx_packets, dev->net->stats.tx_packets,
 		dev->net->stats.rx_errors, dev->net->stats.tx_errors
@@ -771,6 +852,7 @@ struct eth_dev *gether_setup_name(struct usb_gadget *g,
 	spin_lock_init(&dev->lock);
 	spin_lock_init(&dev->req_lock);
 	INIT_WORK(&dev->work, eth_work);
+	eth_tx_init(dev);
 	INIT_LIST_HEAD(&dev->tx_reqs);
 	INIT_LIST_HEAD(&dev->rx_reqs);
 
@@ -833,6 +915,7 @@ struct net_device *gether_setup_name_default(const char *netname)
 	spin_lock_init(&dev->lock);
 	spin_lock_init(&dev->req_lock);
 	INIT_WORK(&dev->work, eth_work);
+	eth_tx_init(dev);
 	INIT_LIST_HEAD(&dev->tx_reqs);
 	INIT_LIST_HEAD(&dev->rx_reqs);
 
@@ -1016,6 +1099,93 @@ void gether_cleanup(struct eth_dev *dev)
 }
 EXPORT_SYMBOL(gether_cleanup);
 
+static void gether_batch_refill(struct work_struct *work)
+{
+	struct gether_batch_bufs *bufs =
+		container_of(work, struct gether_batch_bufs, refill);
+	struct sk_buff *skb;
+	int i;
+
+	for (i = 0; i < GETHER_BATCH_BUFS; i++) {
+		if (bufs->skb[i])
+			continue;
+		skb = alloc_skb(bufs->size, GFP_KERNEL);
+		if (skb && cmpxchg(&bufs->skb[i], NULL, skb))
+			kfree_skb(skb);
+	}
+}
+
+/**
+ * gether_batch_bufs_alloc - preallocate transfer buffers for batching
+ * @bufs: the buffers, zeroed
+ * @size: largest transfer the buffers have to hold
+ * Context: may sleep
+ *
+ * Failing to allocate them is not fatal, gether_batch_get() then falls
+ * back to allocating every transfer on its own.
+ */
+void gether_batch_bufs_alloc(struct gether_batch_bufs *bufs, unsigned size)
+{
+	bufs->size = size;
+	INIT_WORK(&bufs->refill, gether_batch_refill);
+	gether_batch_refill(&bufs->refill);
+}
+EXPORT_SYMBOL(gether_batch_bufs_alloc);
+
+/**
+ * gether_batch_bufs_free - release preallocated transfer buffers
+ * @bufs: the buffers
+ * Context: may sleep
+ *
+ * Buffers which have been handed out belong to their transfers and are
+ * freed on completion as usual.
+ */
+void gether_batch_bufs_free(struct gether_batch_bufs *bufs)
+{
+	int i;
+
+	if (!bufs->size)
+		return;
+
+	cancel_work_sync(&bufs->refill);
+	for (i = 0; i < GETHER_BATCH_BUFS; i++) {
+		if (bufs->skb[i])
+			kfree_skb(bufs->skb[i]);
+		bufs->skb[i] = NULL;
+	}
+	bufs->size = 0;
+}
+EXPORT_SYMBOL(gether_batch_bufs_free);
+
+/**
+ * gether_batch_get - get an empty transfer buffer for a wrap() hook
+ * @bufs: the preallocated buffers
+ * @size: size of the transfer
+ * Context: any, calls for @bufs must be serialized
+ *
+ * Hands out a preallocated buffer, which then belongs to the caller and
+ * is freed like any other transfer, and has it replaced from process
+ * context.  Only allocates the transfer right here if no preallocated
+ * buffer is left.
+ */
+struct sk_buff *gether_batch_get(struct gether_batch_bufs *bufs, unsigned size)
+{
+	struct sk_buff *skb;
+	int i;
+
+	for (i = 0; size <= bufs->size && i < GETHER_BATCH_BUFS; i++) {
+		skb = xchg(&bufs->skb[i], NULL);
+		if (!skb)
+			continue;
+
+		schedule_work(&bufs->refill);
+		return skb;
+	}
+
+	return alloc_skb(size, GFP_ATOMIC);
+}
+EXPORT_SYMBOL(gether_batch_get);
+
 /**
  * gether_connect - notify network layer that USB link is active
  * @link: the USB link, set up with endpoints, descriptors matching
@@ -16,6 +16,7 @@
 
 #include <linux/err.h>
 #include <linux/if_ether.h>
+#include <linux/workqueue.h>
 #include <linux/usb/composite.h>
 #include <linux/usb/cdc.h>
 
@@ -80,6 +81,16 @@ struct gether {
 						struct sk_buff *skb,
 						struct sk_buff_head *list);
 
+	/* Multi frame transfers.  With supports_multi_frame set, wrap() may
+	 * hold a frame back to batch it with later ones and return NULL; it
+	 * is then called with a NULL skb, once the tx fill timeout expires,
+	 * to hand over whatever it has batched.  rx_max_pkts is the number
+	 * of frames the host may batch into one OUT transfer, for functions
+	 * without fixed size bundles.
+	 */
+	bool				supports_multi_frame;
+	u32				rx_max_pkts;
+
 	/* called on network open/close */
 	void				(*open)(struct gether *);
 	void				(*close)(struct gether *);
@@ -250,6 +261,24 @@ int gether_get_ifname(struct net_device *net, char *name, int len);
 
 void gether_cleanup(struct eth_dev *dev);
 
+/* Transfer buffers for wrap() hooks which batch frames, allocated with
+ * GFP_KERNEL ahead of time instead of once per transfer with GFP_ATOMIC.
+ * Two are enough for one transfer being filled while the previous one is
+ * in flight.
+ */
+#define GETHER_BATCH_BUFS	2
+
+struct gether_batch_bufs {
+	struct sk_buff		*skb[GETHER_BATCH_BUFS];
+	unsigned		size;
+	struct work_struct	refill;
+};
+
+void gether_batch_bufs_alloc(struct gether_batch_bufs *bufs, unsigned size);
+void gether_batch_bufs_free(struct gether_batch_bufs *bufs);
+struct sk_buff *gether_batch_get(struct gether_batch_bufs *bufs,
+				 unsigned size);
+
 /* connect/disconnect is handled by individual functions */
 struct net_device *gether_connect(struct gether *);
 void gether_disconnect(struct gether *);
@@ -53,6 +53,11 @@ static irqreturn_t jz4740_musb_interrupt(int irq, void *__hci)
 
 	spin_unlock_irqrestore(&musb->lock, flags);
 
+	/* DMA completion is signalled on the same interrupt line */
+	if (musb->dma_controller &&
+	    dma_controller_irq(irq, musb->dma_controller) == IRQ_HANDLED)
+		retval = IRQ_HANDLED;
+
 	return retval;
 }
 
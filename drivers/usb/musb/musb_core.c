@@ -2010,8 +2010,10 @@ fail3:
 	cancel_work_sync(&musb->irq_work);
 	cancel_delayed_work_sync(&musb->finish_resume_work);
 	cancel_delayed_work_sync(&musb->deassert_reset_work);
-	if (musb->dma_controller)
+	if (musb->dma_controller) {
 		dma_controller_destroy(musb->dma_controller);
+		musb->dma_controller = NULL;
+	}
 fail2_5:
 	pm_runtime_put_sync(musb->controller);
 
@@ -2069,8 +2071,10 @@ static int musb_remove(struct platform_device *pdev)
 	musb_exit_debugfs(musb);
 	musb_shutdown(pdev);
 
-	if (musb->dma_controller)
+	if (musb->dma_controller) {
 		dma_controller_destroy(musb->dma_controller);
+		musb->dma_controller = NULL;
+	}
 
 	cancel_work_sync(&musb->irq_work);
 	cancel_delayed_work_sync(&musb->finish_resume_work);
@@ -191,4 +191,14 @@ extern struct dma_controller *dma_controller_create(struct musb *, void __iomem
 extern void dma_controller_destroy(struct dma_controller *);
 #endif
 
+#ifdef CONFIG_USB_INVENTRA_DMA
+/* for glue layers which share the DMA interrupt with the core */
+extern irqreturn_t dma_controller_irq(int irq, void *private_data);
+#else
+static inline irqreturn_t dma_controller_irq(int irq, void *private_data)
+{
+	return IRQ_NONE;
+}
+#endif
+
 #endif	/* __MUSB_DMA_H__ */
@@ -236,7 +236,7 @@ static int dma_channel_abort(struct dma_channel *channel)
 	return 0;
 }
 
-static irqreturn_t dma_controller_irq(int irq, void *private_data)
+irqreturn_t dma_controller_irq(int irq, void *private_data)
 {
 	struct musb_dma_controller *controller = private_data;
 	struct musb *musb = controller->private_data;
@@ -355,6 +355,7 @@ done:
 	spin_unlock_irqrestore(&musb->lock, flags);
 	return retval;
 }
+EXPORT_SYMBOL_GPL(dma_controller_irq);
 
 void dma_controller_destroy(struct dma_controller *c)
 {
@@ -372,6 +373,7 @@ void dma_controller_destroy(struct dma_controller *c)
 struct dma_controller *dma_controller_create(struct musb *musb, void __iomem *base)
 {
 	struct musb_dma_controller *controller;
+#ifndef MUSB_HSDMA_SHARED_IRQ
 	struct device *dev = musb->controller;
 	struct platform_device *pdev = to_platform_device(dev);
 	int irq = platform_get_irq_byname(pdev, "dma");
@@ -380,6 +382,7 @@ struct dma_controller *dma_controller_create(struct musb *musb, void __iomem *ba
 		dev_err(dev, "No DMA interrupt line!\n");
 		return NULL;
 	}
+#endif
 
 	controller = kzalloc(sizeof(*controller), GFP_KERNEL);
 	if (!controller)
@@ -394,6 +397,7 @@ struct dma_controller *dma_controller_create(struct musb *musb, void __iomem *ba
 	controller->controller.channel_program = dma_channel_program;
 	controller->controller.channel_abort = dma_channel_abort;
 
+#ifndef MUSB_HSDMA_SHARED_IRQ
 	if (request_irq(irq, dma_controller_irq, 0,
 			dev_name(musb->controller), &controller->controller)) {
 		dev_err(dev, "request_irq %d failed!\n", irq);
@@ -403,6 +407,7 @@ struct dma_controller *dma_controller_create(struct musb *musb, void __iomem *ba
 	}
 
 	controller->irq = irq;
+#endif
 
 	return &controller->controller;
 }
@@ -135,7 +135,15 @@ static inline void musb_write_hsdma_count(void __iomem *mbase,
 #define MUSB_HSDMA_BURSTMODE_INCR8	2
 #define MUSB_HSDMA_BURSTMODE_INCR16	3
 
+#ifdef CONFIG_USB_MUSB_JZ4740
+/* The JZ4740 UDC only implements two channels, and has no interrupt line
+ * of its own for them. The glue layer forwards the UDC interrupt instead.
+ */
+#define MUSB_HSDMA_CHANNELS		2
+#define MUSB_HSDMA_SHARED_IRQ
+#else
 #define MUSB_HSDMA_CHANNELS		8
+#endif
 
 struct musb_dma_controller;
 
@@ -17,18 +17,28 @@
 #include <linux/module.h>
 #include <linux/mutex.h>
 #include <linux/platform_device.h>
+#include <linux/pm_runtime.h>
+#include <linux/interrupt.h>
+#include <linux/uaccess.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
 
 #include <linux/clk.h>
 #include <linux/delay.h>
 
 #include <linux/console.h>
+#include <linux/debugfs.h>
 #include <linux/fb.h>
+#include <linux/seq_file.h>
 
 #include <linux/dma-mapping.h>
 
+#include <asm/mach-jz4740/bus.h>
 #include <asm/mach-jz4740/jz4740_fb.h>
 #include <asm/mach-jz4740/gpio.h>
 
+#include <video/jz4740_fb.h>
+
 #define JZ_REG_LCD_CFG		0x00
 #define JZ_REG_LCD_VSYNC	0x04
 #define JZ_REG_LCD_HSYNC	0x08
@@ -105,8 +115,18 @@
 
 #define JZ_LCD_SYNC_MASK 0x3ff
 
+#define JZ_LCD_STATE_EOF BIT(5)
+#define JZ_LCD_STATE_SOF BIT(4)
 #define JZ_LCD_STATE_DISABLED BIT(0)
 
+#define JZFB_MAX_BUFFERS 3
+
+/* How long smart panel damage is collected before it is sent */
+#define JZFB_DAMAGE_DELAY (HZ / 50)
+
+/* How long an idle controller keeps its clock, in ms */
+#define JZFB_AUTOSUSPEND_DELAY 100
+
 struct jzfb_framedesc {
 	uint32_t next;
 	uint32_t addr;
@@ -127,21 +147,47 @@ struct jzfb {
 	struct jzfb_framedesc *framedesc;
 	dma_addr_t framedesc_phys;
 
+	unsigned int num_buffers;
+	/* The video memory is mapped cached and written back on updates */
+	bool cached;
+
 	struct clk *ldclk;
 	struct clk *lpclk;
 
 	unsigned is_enabled:1;
 	struct mutex lock;
 
+	/* Scanout bandwidth reported to the memory bus, in bytes per second */
+	unsigned long bus_bandwidth;
+	/* Bytes sent to a smart panel */
+	u64 bus_traffic;
+	struct dentry *debugfs;
+
+	int irq;
+	spinlock_t irq_lock;
+	wait_queue_head_t vsync_wait;
+	unsigned int vsync_count;
+
+	/* Smart panels: lines of the virtual framebuffer yet to be sent */
+	struct delayed_work damage_work;
+	unsigned int damage_start;
+	unsigned int damage_end;
+
 	uint32_t pseudo_palette[16];
 };
 
+static bool jzfb_cached;
+module_param_named(cached, jzfb_cached, bool, 0444);
+MODULE_PARM_DESC(cached, "Map the video memory cached. Clients drawing into "
+		 "an mmap()ed framebuffer must then pan, wait for vsync or "
+		 "report damage for their changes to become visible.");
+
 static const struct fb_fix_screeninfo jzfb_fix = {
 	.id		= "JZ4740 FB",
 	.type		= FB_TYPE_PACKED_PIXELS,
 	.visual		= FB_VISUAL_TRUECOLOR,
 	.xpanstep	= 0,
-	.ypanstep	= 0,
+	.ypanstep	= 1,
 	.ywrapstep	= 0,
 	.accel		= FB_ACCEL_NONE,
 };
@@ -289,6 +335,7 @@ static int jzfb_check_var(struct fb_var_screeninfo *var, struct fb_info *fb)
 {
 	struct jzfb *jzfb = fb->par;
 	struct fb_videomode *mode;
+	unsigned int yres_virtual, yoffset;
 
 	if (var->bits_per_pixel != jzfb_get_controller_bpp(jzfb) &&
 		var->bits_per_pixel != jzfb->pdata->bpp)
@@ -298,8 +345,17 @@ static int jzfb_check_var(struct fb_var_screeninfo *var, struct fb_info *fb)
 	if (mode == NULL)
 		return -EINVAL;
 
+	yres_virtual = var->yres_virtual;
+	yoffset = var->yoffset;
+
 	fb_videomode_to_var(var, mode);
 
+	/* The video memory holds up to num_buffers frames to pan between */
+	var->yres_virtual = clamp(yres_virtual, mode->yres,
+				  mode->yres * jzfb->num_buffers);
+	if (yoffset <= var->yres_virtual - mode->yres)
+		var->yoffset = yoffset;
+
 	switch (jzfb->pdata->bpp) {
 	case 8:
 		break;
@@ -347,6 +403,173 @@ static int jzfb_check_var(struct fb_var_screeninfo *var, struct fb_info *fb)
 	return 0;
 }
 
+/*
+ * With cached video memory, the CPU's writes to the given lines have to be
+ * written back before the controller can see them.
+ */
+static void jzfb_writeback(struct jzfb *jzfb, unsigned int y,
+	unsigned int height)
+{
+	unsigned int line_length = jzfb->fb->fix.line_length;
+
+	if (jzfb->cached)
+		dma_cache_sync(&jzfb->pdev->dev, jzfb->vidmem + y * line_length,
+			       height * line_length, DMA_TO_DEVICE);
+}
+
+/*
+ * Smart panels keep their own copy of the frame, so instead of scanning out
+ * continuously the controller is only started to send the lines which have
+ * changed. Damage is collected for a little while and then sent in one go.
+ */
+static void jzfb_damage(struct fb_info *info, unsigned int y,
+	unsigned int height)
+{
+	struct jzfb *jzfb = info->par;
+	unsigned long flags;
+
+	if (y >= info->var.yres_virtual)
+		return;
+
+	height = min(height, info->var.yres_virtual - y);
+	if (!height)
+		return;
+
+	jzfb_writeback(jzfb, y, height);
+
+	if (!jzfb->pdata->smart_panel)
+		return;
+
+	spin_lock_irqsave(&jzfb->irq_lock, flags);
+	if (jzfb->damage_start >= jzfb->damage_end) {
+		jzfb->damage_start = y;
+		jzfb->damage_end = y + height;
+	} else {
+		jzfb->damage_start = min(jzfb->damage_start, y);
+		jzfb->damage_end = max(jzfb->damage_end, y + height);
+	}
+	spin_unlock_irqrestore(&jzfb->irq_lock, flags);
+
+	schedule_delayed_work(&jzfb->damage_work, JZFB_DAMAGE_DELAY);
+}
+
+static int jzfb_wait_state(struct jzfb *jzfb, uint32_t bit, bool atomic)
+{
+	unsigned long timeout = jiffies + HZ / 10;
+
+	while (!(readl(jzfb->base + JZ_REG_LCD_STATE) & bit)) {
+		if (time_after(jiffies, timeout))
+			return -ETIMEDOUT;
+		if (atomic)
+			cpu_relax();
+		else
+			usleep_range(100, 200);
+	}
+
+	return 0;
+}
+
+static void jzfb_set_bus_bandwidth(struct jzfb *jzfb, bool scanout)
+{
+	struct fb_info *info = jzfb->fb;
+	unsigned long bandwidth = 0;
+
+	if (scanout && info->mode)
+		bandwidth = info->fix.line_length * info->mode->yres *
+			info->mode->refresh;
+
+	jz4740_bus_add_bandwidth((long)bandwidth - (long)jzfb->bus_bandwidth);
+	jzfb->bus_bandwidth = bandwidth;
+}
+
+/*
+ * Sends a single frame made of the given visible lines. The display timing
+ * is shrunk to the number of lines sent, and the controller is told to stop
+ * once it has started the frame, so that it finishes with this one.
+ */
+static void jzfb_send_lines(struct jzfb *jzfb, unsigned int y,
+	unsigned int height)
+{
+	struct fb_info *info = jzfb->fb;
+	struct fb_videomode *mode = info->mode;
+	uint16_t ht, vds, vde;
+	uint32_t ctrl;
+
+	if (!jzfb->pdata->set_window) {
+		y = 0;
+		height = info->var.yres;
+	}
+
+	ht = mode->hsync_len + mode->left_margin + mode->xres +
+		mode->right_margin;
+	vds = mode->vsync_len + mode->upper_margin;
+	vde = vds + height;
+
+	jzfb->framedesc->addr = jzfb->vidmem_phys +
+		(info->var.yoffset + y) * info->fix.line_length;
+	jzfb->framedesc->cmd = height * info->fix.line_length / 4;
+	wmb();
+
+	pm_runtime_get_sync(&jzfb->pdev->dev);
+
+	if (jzfb->pdata->set_window)
+		jzfb->pdata->set_window(&jzfb->pdev->dev, y, height);
+
+	writel((vds << 16) | vde, jzfb->base + JZ_REG_LCD_DAV);
+	writel((ht << 16) | (vde + mode->lower_margin),
+		jzfb->base + JZ_REG_LCD_VAT);
+
+	writel(0, jzfb->base + JZ_REG_LCD_STATE);
+	writel(jzfb->framedesc_phys, jzfb->base + JZ_REG_LCD_DA0);
+
+	jz4740_bus_add_traffic(height * info->fix.line_length);
+	jzfb->bus_traffic += height * info->fix.line_length;
+
+	spin_lock_irq(&jzfb->irq_lock);
+	ctrl = readl(jzfb->base + JZ_REG_LCD_CTRL);
+	ctrl |= JZ_LCD_CTRL_ENABLE;
+	ctrl &= ~JZ_LCD_CTRL_DISABLE;
+	writel(ctrl, jzfb->base + JZ_REG_LCD_CTRL);
+	spin_unlock_irq(&jzfb->irq_lock);
+
+	/* The start of frame follows within the vertical blanking period */
+	if (jzfb_wait_state(jzfb, JZ_LCD_STATE_SOF, true))
+		dev_warn(&jzfb->pdev->dev, "Frame did not start\n");
+
+	spin_lock_irq(&jzfb->irq_lock);
+	ctrl = readl(jzfb->base + JZ_REG_LCD_CTRL);
+	writel(ctrl | JZ_LCD_CTRL_DISABLE, jzfb->base + JZ_REG_LCD_CTRL);
+	spin_unlock_irq(&jzfb->irq_lock);
+
+	if (jzfb_wait_state(jzfb, JZ_LCD_STATE_DISABLED, false))
+		dev_warn(&jzfb->pdev->dev, "Frame did not complete\n");
+
+	pm_runtime_mark_last_busy(&jzfb->pdev->dev);
+	pm_runtime_put_autosuspend(&jzfb->pdev->dev);
+}
+
+static void jzfb_damage_work(struct work_struct *work)
+{
+	struct jzfb *jzfb = container_of(work, struct jzfb, damage_work.work);
+	struct fb_info *info = jzfb->fb;
+	unsigned int start, end;
+
+	mutex_lock(&jzfb->lock);
+
+	spin_lock_irq(&jzfb->irq_lock);
+	start = max(jzfb->damage_start, info->var.yoffset);
+	end = min(jzfb->damage_end, info->var.yoffset + info->var.yres);
+	jzfb->damage_start = 0;
+	jzfb->damage_end = 0;
+	spin_unlock_irq(&jzfb->irq_lock);
+
+	/* A disabled panel gets a full frame once it is enabled again */
+	if (jzfb->is_enabled && info->mode && start < end)
+		jzfb_send_lines(jzfb, start - info->var.yoffset, end - start);
+
+	mutex_unlock(&jzfb->lock);
+}
+
 static int jzfb_set_par(struct fb_info *info)
 {
 	struct jzfb *jzfb = info->par;
@@ -436,9 +659,8 @@ static int jzfb_set_par(struct fb_info *info)
 	}
 
 	mutex_lock(&jzfb->lock);
-	if (!jzfb->is_enabled)
-		clk_enable(jzfb->ldclk);
-	else
+	pm_runtime_get_sync(&jzfb->pdev->dev);
+	if (jzfb->is_enabled && !pdata->smart_panel)
 		ctrl |= JZ_LCD_CTRL_ENABLE;
 
 	switch (pdata->lcd_type) {
@@ -468,16 +690,24 @@ static int jzfb_set_par(struct fb_info *info)
 
 	writel(cfg, jzfb->base + JZ_REG_LCD_CFG);
 
+	spin_lock_irq(&jzfb->irq_lock);
+	ctrl |= readl(jzfb->base + JZ_REG_LCD_CTRL) & JZ_LCD_CTRL_EOF_IRQ;
 	writel(ctrl, jzfb->base + JZ_REG_LCD_CTRL);
+	spin_unlock_irq(&jzfb->irq_lock);
 
-	if (!jzfb->is_enabled)
-		clk_disable_unprepare(jzfb->ldclk);
+	pm_runtime_mark_last_busy(&jzfb->pdev->dev);
+	pm_runtime_put_autosuspend(&jzfb->pdev->dev);
+
+	if (jzfb->is_enabled && !pdata->smart_panel)
+		jzfb_set_bus_bandwidth(jzfb, true);
 
 	mutex_unlock(&jzfb->lock);
 
 	clk_set_rate(jzfb->lpclk, rate);
 	clk_set_rate(jzfb->ldclk, rate * 3);
 
+	jzfb_damage(info, var->yoffset, var->yres);
+
 	return 0;
 }
 
@@ -485,36 +715,63 @@ static void jzfb_enable(struct jzfb *jzfb)
 {
 	uint32_t ctrl;
 
-	clk_prepare_enable(jzfb->ldclk);
+	pm_runtime_get_sync(&jzfb->pdev->dev);
 
 	jz_gpio_bulk_resume(jz_lcd_ctrl_pins, jzfb_num_ctrl_pins(jzfb));
 	jz_gpio_bulk_resume(jz_lcd_data_pins, jzfb_num_data_pins(jzfb));
 
 	writel(0, jzfb->base + JZ_REG_LCD_STATE);
 
+	/*
+	 * A smart panel keeps its picture on its own, so the controller only
+	 * needs to be powered while frames are being sent to it.
+	 */
+	if (jzfb->pdata->smart_panel) {
+		pm_runtime_mark_last_busy(&jzfb->pdev->dev);
+		pm_runtime_put_autosuspend(&jzfb->pdev->dev);
+		jzfb_damage(jzfb->fb, jzfb->fb->var.yoffset,
+			jzfb->fb->var.yres);
+		return;
+	}
+
 	writel(jzfb->framedesc->next, jzfb->base + JZ_REG_LCD_DA0);
 
+	spin_lock_irq(&jzfb->irq_lock);
 	ctrl = readl(jzfb->base + JZ_REG_LCD_CTRL);
 	ctrl |= JZ_LCD_CTRL_ENABLE;
 	ctrl &= ~JZ_LCD_CTRL_DISABLE;
 	writel(ctrl, jzfb->base + JZ_REG_LCD_CTRL);
+	spin_unlock_irq(&jzfb->irq_lock);
+
+	jzfb_set_bus_bandwidth(jzfb, true);
 }
 
 static void jzfb_disable(struct jzfb *jzfb)
 {
 	uint32_t ctrl;
 
+	if (jzfb->pdata->smart_panel)
+		pm_runtime_get_sync(&jzfb->pdev->dev);
+
+	spin_lock_irq(&jzfb->irq_lock);
 	ctrl = readl(jzfb->base + JZ_REG_LCD_CTRL);
 	ctrl |= JZ_LCD_CTRL_DISABLE;
+	ctrl &= ~JZ_LCD_CTRL_EOF_IRQ;
 	writel(ctrl, jzfb->base + JZ_REG_LCD_CTRL);
-	do {
-		ctrl = readl(jzfb->base + JZ_REG_LCD_STATE);
-	} while (!(ctrl & JZ_LCD_STATE_DISABLED));
+	spin_unlock_irq(&jzfb->irq_lock);
+
+	/* A smart panel's frames are sent to completion under the lock */
+	if (!jzfb->pdata->smart_panel) {
+		do {
+			ctrl = readl(jzfb->base + JZ_REG_LCD_STATE);
+		} while (!(ctrl & JZ_LCD_STATE_DISABLED));
+	}
 
 	jz_gpio_bulk_suspend(jz_lcd_ctrl_pins, jzfb_num_ctrl_pins(jzfb));
 	jz_gpio_bulk_suspend(jz_lcd_data_pins, jzfb_num_data_pins(jzfb));
 
-	clk_disable_unprepare(jzfb->ldclk);
+	jzfb_set_bus_bandwidth(jzfb, false);
+	pm_runtime_put_sync_suspend(&jzfb->pdev->dev);
 }
 
 static int jzfb_blank(int blank_mode, struct fb_info *info)
@@ -551,10 +808,135 @@ static int jzfb_blank(int blank_mode, struct fb_info *info)
 	return 0;
 }
 
+/*
+ * The controller fetches the frame descriptor anew at the start of every
+ * frame, since it points back to itself. Updating its buffer address thus
+ * takes effect at the end of the frame which is currently being scanned out.
+ */
+static int jzfb_pan_display(struct fb_var_screeninfo *var, struct fb_info *info)
+{
+	struct jzfb *jzfb = info->par;
+
+	jzfb->framedesc->addr = jzfb->vidmem_phys +
+				var->yoffset * info->fix.line_length;
+	wmb();
+
+	jzfb_damage(info, var->yoffset, var->yres);
+
+	return 0;
+}
+
+static irqreturn_t jzfb_irq_handler(int irq, void *devid)
+{
+	struct jzfb *jzfb = devid;
+	uint32_t state, ctrl;
+
+	state = readl(jzfb->base + JZ_REG_LCD_STATE);
+	if (!(state & JZ_LCD_STATE_EOF))
+		return IRQ_NONE;
+
+	writel(state & ~JZ_LCD_STATE_EOF, jzfb->base + JZ_REG_LCD_STATE);
+
+	/* The interrupt is only needed as long as somebody waits for it */
+	spin_lock(&jzfb->irq_lock);
+	ctrl = readl(jzfb->base + JZ_REG_LCD_CTRL);
+	writel(ctrl & ~JZ_LCD_CTRL_EOF_IRQ, jzfb->base + JZ_REG_LCD_CTRL);
+	++jzfb->vsync_count;
+	spin_unlock(&jzfb->irq_lock);
+
+	wake_up_interruptible_all(&jzfb->vsync_wait);
+
+	return IRQ_HANDLED;
+}
+
+static int jzfb_wait_for_vsync(struct jzfb *jzfb)
+{
+	unsigned int count;
+	uint32_t ctrl;
+	int ret;
+
+	if (jzfb->irq < 0)
+		return -ENODEV;
+
+	if (!jzfb->is_enabled)
+		return -EBUSY;
+
+	/* Whatever was drawn into the visible frame should be in this one */
+	jzfb_writeback(jzfb, jzfb->fb->var.yoffset, jzfb->fb->var.yres);
+
+	/* Smart panels only get a frame when there is pending damage */
+	if (jzfb->pdata->smart_panel) {
+		flush_delayed_work(&jzfb->damage_work);
+		return 0;
+	}
+
+	spin_lock_irq(&jzfb->irq_lock);
+	count = jzfb->vsync_count;
+	ctrl = readl(jzfb->base + JZ_REG_LCD_CTRL);
+	writel(ctrl | JZ_LCD_CTRL_EOF_IRQ, jzfb->base + JZ_REG_LCD_CTRL);
+	spin_unlock_irq(&jzfb->irq_lock);
+
+	ret = wait_event_interruptible_timeout(jzfb->vsync_wait,
+			ACCESS_ONCE(jzfb->vsync_count) != count, HZ / 10);
+	if (ret == 0)
+		return -ETIMEDOUT;
+
+	return ret < 0 ? ret : 0;
+}
+
+static int jzfb_ioctl(struct fb_info *info, unsigned int cmd,
+	unsigned long arg)
+{
+	struct jzfb *jzfb = info->par;
+	struct jzfb_damage_rect rect;
+
+	switch (cmd) {
+	case FBIO_WAITFORVSYNC:
+		return jzfb_wait_for_vsync(jzfb);
+	case JZFB_IOCTL_DAMAGE:
+		if (copy_from_user(&rect, (void __user *)arg, sizeof(rect)))
+			return -EFAULT;
+
+		jzfb_damage(info, rect.y, rect.height);
+		if (jzfb->pdata->smart_panel)
+			flush_delayed_work(&jzfb->damage_work);
+		return 0;
+	default:
+		return -ENOTTY;
+	}
+}
+
+/*
+ * Same layout as the default fb_mmap(), the registers follow the video
+ * memory, but the video memory is only mapped uncached when it is so in the
+ * kernel too.
+ */
+static int jzfb_mmap(struct fb_info *info, struct vm_area_struct *vma)
+{
+	struct jzfb *jzfb = info->par;
+	unsigned long mmio_pgoff = PAGE_ALIGN(info->fix.smem_len) >> PAGE_SHIFT;
+	phys_addr_t start = info->fix.smem_start;
+	unsigned long len = info->fix.smem_len;
+	bool cached = jzfb->cached;
+
+	if (vma->vm_pgoff >= mmio_pgoff) {
+		vma->vm_pgoff -= mmio_pgoff;
+		start = info->fix.mmio_start;
+		len = info->fix.mmio_len;
+		cached = false;
+	}
+
+	if (!cached)
+		vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+
+	return vm_iomap_memory(vma, start, len);
+}
+
 static int jzfb_alloc_devmem(struct jzfb *jzfb)
 {
 	int max_videosize = 0;
 	struct fb_videomode *mode = jzfb->pdata->modes;
+	DEFINE_DMA_ATTRS(attrs);
 	void *page;
 	int i;
 
@@ -572,10 +954,12 @@ static int jzfb_alloc_devmem(struct jzfb *jzfb)
 	if (!jzfb->framedesc)
 		return -ENOMEM;
 
-	jzfb->vidmem_size = PAGE_ALIGN(max_videosize);
-	jzfb->vidmem = dma_alloc_coherent(&jzfb->pdev->dev,
-					jzfb->vidmem_size,
-					&jzfb->vidmem_phys, GFP_KERNEL);
+	if (jzfb->cached)
+		dma_set_attr(DMA_ATTR_NON_CONSISTENT, &attrs);
+
+	jzfb->vidmem_size = PAGE_ALIGN(max_videosize * jzfb->num_buffers);
+	jzfb->vidmem = dma_alloc_attrs(&jzfb->pdev->dev, jzfb->vidmem_size,
+				       &jzfb->vidmem_phys, GFP_KERNEL, &attrs);
 
 	if (!jzfb->vidmem)
 		goto err_free_framedesc;
@@ -602,23 +986,121 @@ err_free_framedesc:
 
 static void jzfb_free_devmem(struct jzfb *jzfb)
 {
-	dma_free_coherent(&jzfb->pdev->dev, jzfb->vidmem_size,
-				jzfb->vidmem, jzfb->vidmem_phys);
+	DEFINE_DMA_ATTRS(attrs);
+
+	if (jzfb->cached)
+		dma_set_attr(DMA_ATTR_NON_CONSISTENT, &attrs);
+
+	dma_free_attrs(&jzfb->pdev->dev, jzfb->vidmem_size, jzfb->vidmem,
+		       jzfb->vidmem_phys, &attrs);
 	dma_free_coherent(&jzfb->pdev->dev, sizeof(*jzfb->framedesc),
 				jzfb->framedesc, jzfb->framedesc_phys);
 }
 
+static void jzfb_pm_runtime_teardown(struct jzfb *jzfb)
+{
+	struct device *dev = &jzfb->pdev->dev;
+
+	pm_runtime_disable(dev);
+	if (!pm_runtime_status_suspended(dev))
+		clk_disable_unprepare(jzfb->ldclk);
+	pm_runtime_set_suspended(dev);
+	pm_runtime_dont_use_autosuspend(dev);
+}
+
+static void jzfb_fillrect(struct fb_info *info, const struct fb_fillrect *rect)
+{
+	sys_fillrect(info, rect);
+	jzfb_damage(info, rect->dy, rect->height);
+}
+
+static void jzfb_copyarea(struct fb_info *info, const struct fb_copyarea *area)
+{
+	sys_copyarea(info, area);
+	jzfb_damage(info, area->dy, area->height);
+}
+
+static void jzfb_imageblit(struct fb_info *info, const struct fb_image *image)
+{
+	sys_imageblit(info, image);
+	jzfb_damage(info, image->dy, image->height);
+}
+
+static ssize_t jzfb_write(struct fb_info *info, const char __user *buf,
+	size_t count, loff_t *ppos)
+{
+	unsigned int line_length = info->fix.line_length;
+	unsigned long pos = *ppos;
+	ssize_t ret;
+
+	ret = fb_sys_write(info, buf, count, ppos);
+	if (ret > 0) {
+		jzfb_damage(info, pos / line_length,
+			DIV_ROUND_UP(pos + ret, line_length) - pos / line_length);
+	}
+
+	return ret;
+}
+
 static struct  fb_ops jzfb_ops = {
 	.owner = THIS_MODULE,
 	.fb_check_var = jzfb_check_var,
 	.fb_set_par = jzfb_set_par,
 	.fb_blank = jzfb_blank,
-	.fb_fillrect	= sys_fillrect,
-	.fb_copyarea	= sys_copyarea,
-	.fb_imageblit	= sys_imageblit,
+	.fb_pan_display = jzfb_pan_display,
+	.fb_ioctl = jzfb_ioctl,
+	.fb_mmap = jzfb_mmap,
+	.fb_write	= jzfb_write,
+	.fb_fillrect	= jzfb_fillrect,
+	.fb_copyarea	= jzfb_copyarea,
+	.fb_imageblit	= jzfb_imageblit,
 	.fb_setcolreg = jzfb_setcolreg,
 };
 
+#ifdef CONFIG_DEBUG_FS
+static int jzfb_bandwidth_show(struct seq_file *s, void *unused)
+{
+	struct jzfb *jzfb = s->private;
+
+	mutex_lock(&jzfb->lock);
+	seq_printf(s, "scanout: %lu bytes/s\n", jzfb->bus_bandwidth);
+	seq_printf(s, "panel updates: %llu bytes\n", jzfb->bus_traffic);
+	mutex_unlock(&jzfb->lock);
+
+	return 0;
+}
+
+static int jzfb_bandwidth_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, jzfb_bandwidth_show, inode->i_private);
+}
+
+static const struct file_operations jzfb_bandwidth_fops = {
+	.open = jzfb_bandwidth_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void jzfb_debugfs_init(struct jzfb *jzfb)
+{
+	jzfb->debugfs = debugfs_create_dir(dev_name(&jzfb->pdev->dev), NULL);
+	if (IS_ERR_OR_NULL(jzfb->debugfs))
+		return;
+
+	debugfs_create_file("bandwidth", S_IRUGO, jzfb->debugfs, jzfb,
+		&jzfb_bandwidth_fops);
+}
+
+static void jzfb_debugfs_exit(struct jzfb *jzfb)
+{
+	debugfs_remove_recursive(jzfb->debugfs);
+}
+#else
+static inline void jzfb_debugfs_init(struct jzfb *jzfb) {}
+static inline void jzfb_debugfs_exit(struct jzfb *jzfb) {}
+#endif
+
 static int jzfb_probe(struct platform_device *pdev)
 {
 	int ret;
@@ -642,6 +1124,7 @@ static int jzfb_probe(struct platform_device *pdev)
 	fb->flags = FBINFO_DEFAULT;
 
 	jzfb = fb->par;
+	jzfb->fb = fb;
 	jzfb->pdev = pdev;
 	jzfb->pdata = pdata;
 
@@ -669,17 +1152,35 @@ static int jzfb_probe(struct platform_device *pdev)
 	platform_set_drvdata(pdev, jzfb);
 
 	mutex_init(&jzfb->lock);
+	spin_lock_init(&jzfb->irq_lock);
+	init_waitqueue_head(&jzfb->vsync_wait);
+	INIT_DELAYED_WORK(&jzfb->damage_work, jzfb_damage_work);
+
+	jzfb->num_buffers = clamp(pdata->num_buffers, 1U, JZFB_MAX_BUFFERS);
+	jzfb->cached = jzfb_cached;
+
+	/* Without the interrupt everything but FBIO_WAITFORVSYNC still works */
+	jzfb->irq = platform_get_irq(pdev, 0);
+	if (jzfb->irq >= 0) {
+		ret = request_irq(jzfb->irq, jzfb_irq_handler, 0,
+				  dev_name(&pdev->dev), jzfb);
+		if (ret) {
+			dev_err(&pdev->dev, "Failed to request irq: %d\n", ret);
+			goto err_framebuffer_release;
+		}
+	}
 
 	fb_videomode_to_modelist(pdata->modes, pdata->num_modes,
 				 &fb->modelist);
 	fb_videomode_to_var(&fb->var, pdata->modes);
 	fb->var.bits_per_pixel = pdata->bpp;
+	fb->var.yres_virtual = fb->var.yres * jzfb->num_buffers;
 	jzfb_check_var(&fb->var, fb);
 
 	ret = jzfb_alloc_devmem(jzfb);
 	if (ret) {
 		dev_err(&pdev->dev, "Failed to allocate video memory\n");
-		goto err_framebuffer_release;
+		goto err_free_irq;
 	}
 
 	fb->fix = jzfb_fix;
@@ -687,20 +1188,30 @@ static int jzfb_probe(struct platform_device *pdev)
 	fb->fix.mmio_start = mem->start;
 	fb->fix.mmio_len = resource_size(mem);
 	fb->fix.smem_start = jzfb->vidmem_phys;
-	fb->fix.smem_len =  fb->fix.line_length * fb->var.yres;
+	fb->fix.smem_len = fb->fix.line_length * fb->var.yres_virtual;
 	fb->screen_base = jzfb->vidmem;
 	fb->pseudo_palette = jzfb->pseudo_palette;
 
 	fb_alloc_cmap(&fb->cmap, 256, 0);
 
+	/* The panel starts out enabled, which holds a runtime PM reference */
 	clk_prepare_enable(jzfb->ldclk);
+	pm_runtime_set_active(&pdev->dev);
+	pm_runtime_set_autosuspend_delay(&pdev->dev, JZFB_AUTOSUSPEND_DELAY);
+	pm_runtime_use_autosuspend(&pdev->dev);
+	pm_runtime_get_noresume(&pdev->dev);
+	pm_runtime_enable(&pdev->dev);
 	jzfb->is_enabled = 1;
 
-	writel(jzfb->framedesc->next, jzfb->base + JZ_REG_LCD_DA0);
+	if (!pdata->smart_panel)
+		writel(jzfb->framedesc->next, jzfb->base + JZ_REG_LCD_DA0);
 
 	fb->mode = NULL;
 	jzfb_set_par(fb);
 
+	if (pdata->smart_panel)
+		pm_runtime_put_autosuspend(&pdev->dev);
+
 	jz_gpio_bulk_request(jz_lcd_ctrl_pins, jzfb_num_ctrl_pins(jzfb));
 	jz_gpio_bulk_request(jz_lcd_data_pins, jzfb_num_data_pins(jzfb));
 
@@ -710,16 +1221,24 @@ static int jzfb_probe(struct platform_device *pdev)
 		goto err_free_devmem;
 	}
 
-	jzfb->fb = fb;
+	jzfb_debugfs_init(jzfb);
 
 	return 0;
 
 err_free_devmem:
+	cancel_delayed_work_sync(&jzfb->damage_work);
+	jzfb_set_bus_bandwidth(jzfb, false);
+	if (!pdata->smart_panel)
+		pm_runtime_put_noidle(&pdev->dev);
+	jzfb_pm_runtime_teardown(jzfb);
 	jz_gpio_bulk_free(jz_lcd_ctrl_pins, jzfb_num_ctrl_pins(jzfb));
 	jz_gpio_bulk_free(jz_lcd_data_pins, jzfb_num_data_pins(jzfb));
 
 	fb_dealloc_cmap(&fb->cmap);
 	jzfb_free_devmem(jzfb);
+err_free_irq:
+	if (jzfb->irq >= 0)
+		free_irq(jzfb->irq, jzfb);
 err_framebuffer_release:
 	framebuffer_release(fb);
 	return ret;
@@ -729,11 +1248,17 @@ static int jzfb_remove(struct platform_device *pdev)
 {
 	struct jzfb *jzfb = platform_get_drvdata(pdev);
 
+	jzfb_debugfs_exit(jzfb);
 	jzfb_blank(FB_BLANK_POWERDOWN, jzfb->fb);
+	cancel_delayed_work_sync(&jzfb->damage_work);
+	jzfb_pm_runtime_teardown(jzfb);
 
 	jz_gpio_bulk_free(jz_lcd_ctrl_pins, jzfb_num_ctrl_pins(jzfb));
 	jz_gpio_bulk_free(jz_lcd_data_pins, jzfb_num_data_pins(jzfb));
 
+	if (jzfb->irq >= 0)
+		free_irq(jzfb->irq, jzfb);
+
 	fb_dealloc_cmap(&jzfb->fb->cmap);
 	jzfb_free_devmem(jzfb);
 
@@ -742,6 +1267,15 @@ static int jzfb_remove(struct platform_device *pdev)
 	return 0;
 }
 
+/* Stops the scanout, which would otherwise keep reading from memory */
+static void jzfb_shutdown(struct platform_device *pdev)
+{
+	struct jzfb *jzfb = platform_get_drvdata(pdev);
+
+	cancel_delayed_work_sync(&jzfb->damage_work);
+	jzfb_blank(FB_BLANK_POWERDOWN, jzfb->fb);
+}
+
 #ifdef CONFIG_PM
 
 static int jzfb_suspend(struct device *dev)
@@ -752,18 +1286,26 @@ static int jzfb_suspend(struct device *dev)
 	fb_set_suspend(jzfb->fb, 1);
 	console_unlock();
 
+	cancel_delayed_work_sync(&jzfb->damage_work);
+
 	mutex_lock(&jzfb->lock);
 	if (jzfb->is_enabled)
 		jzfb_disable(jzfb);
 	mutex_unlock(&jzfb->lock);
 
+	/* Without runtime PM the clock is still running at this point */
+	if (!pm_runtime_status_suspended(dev))
+		clk_disable_unprepare(jzfb->ldclk);
+
 	return 0;
 }
 
 static int jzfb_resume(struct device *dev)
 {
 	struct jzfb *jzfb = dev_get_drvdata(dev);
-	clk_prepare_enable(jzfb->ldclk);
+
+	if (!pm_runtime_status_suspended(dev))
+		clk_prepare_enable(jzfb->ldclk);
 
 	mutex_lock(&jzfb->lock);
 	if (jzfb->is_enabled)
@@ -777,11 +1319,30 @@ static int jzfb_resume(struct device *dev)
 	return 0;
 }
 
+#ifdef CONFIG_PM_RUNTIME
+static int jzfb_runtime_suspend(struct device *dev)
+{
+	struct jzfb *jzfb = dev_get_drvdata(dev);
+
+	clk_disable_unprepare(jzfb->ldclk);
+
+	return 0;
+}
+
+static int jzfb_runtime_resume(struct device *dev)
+{
+	struct jzfb *jzfb = dev_get_drvdata(dev);
+
+	return clk_prepare_enable(jzfb->ldclk);
+}
+#endif
+
 static const struct dev_pm_ops jzfb_pm_ops = {
 	.suspend	= jzfb_suspend,
 	.resume		= jzfb_resume,
 	.poweroff	= jzfb_suspend,
 	.restore	= jzfb_resume,
+	SET_RUNTIME_PM_OPS(jzfb_runtime_suspend, jzfb_runtime_resume, NULL)
 };
 
 #define JZFB_PM_OPS (&jzfb_pm_ops)
@@ -793,6 +1354,7 @@ static const struct dev_pm_ops jzfb_pm_ops = {
 static struct platform_driver jzfb_driver = {
 	.probe = jzfb_probe,
 	.remove = jzfb_remove,
+	.shutdown = jzfb_shutdown,
 	.driver = {
 		.name = "jz4740-fb",
 		.pm = JZFB_PM_OPS,
@@ -40,6 +40,7 @@
 #include <linux/ramfs.h>
 #include <linux/percpu-refcount.h>
 #include <linux/mount.h>
+#include <linux/pagemap.h>
 
 #include <asm/kmap_types.h>
 #include <asm/uaccess.h>
@@ -149,8 +150,23 @@ struct kioctx {
 	struct file		*aio_ring_file;
 
 	unsigned		id;
+
+	/* Buffered reads currently handed off to aio_wq */
+	atomic_t		nr_punted;
 };
 
+/*
+ * Buffered reads that would have to wait for the page cache to be filled
+ * are handed off to a worker, so that io_submit() does not block.  A
+ * context can have at most AIO_MAX_PUNTED of them in flight, beyond that
+ * reads are run in the submitter as before.  Ranges larger than
+ * AIO_PUNT_CHECK_PAGES are always handed off.
+ */
+#define AIO_MAX_PUNTED		16
+#define AIO_PUNT_CHECK_PAGES	16
+
+static struct workqueue_struct *aio_wq;
+
 /*------ sysctl variables----*/
 static DEFINE_SPINLOCK(aio_nr_lock);
 unsigned long aio_nr;		/* current system wide number of aio requests */
@@ -237,6 +253,10 @@ static int __init aio_setup(void)
 	kiocb_cachep = KMEM_CACHE(kiocb, SLAB_HWCACHE_ALIGN|SLAB_PANIC);
 	kioctx_cachep = KMEM_CACHE(kioctx,SLAB_HWCACHE_ALIGN|SLAB_PANIC);
 
+	aio_wq = alloc_workqueue("aio", WQ_UNBOUND, 0);
+	if (!aio_wq)
+		panic("Failed to create aio workqueue.");
+
 	pr_debug("sizeof(struct page) = %zu\n", sizeof(struct page));
 
 	return 0;
@@ -1339,6 +1359,124 @@ SYSCALL_DEFINE1(io_destroy, aio_context_t, ctx)
 typedef ssize_t (aio_rw_op)(struct kiocb *, const struct iovec *,
 			    unsigned long, loff_t);
 
+struct aio_punt {
+	struct work_struct	work;
+	struct kiocb		*req;
+	aio_rw_op		*rw_op;
+	struct mm_struct	*mm;
+	struct iovec		*iovec;
+	unsigned long		nr_segs;
+	struct iovec		inline_vec;
+};
+
+static ssize_t aio_fixup_ret(ssize_t ret)
+{
+	/*
+	 * There's no easy way to restart the syscall since other AIO's
+	 * may be already running. Just fail this IO with EINTR.
+	 */
+	if (unlikely(ret == -ERESTARTSYS || ret == -ERESTARTNOINTR ||
+		     ret == -ERESTARTNOHAND ||
+		     ret == -ERESTART_RESTARTBLOCK))
+		ret = -EINTR;
+	return ret;
+}
+
+/*
+ * Would a buffered read of this range have to wait for I/O?  Only regular
+ * files and block devices are considered: reads from pipes or sockets can
+ * block indefinitely and must not tie up a worker.
+ */
+static bool aio_read_would_block(struct kiocb *req)
+{
+	struct file *file = req->ki_filp;
+	struct address_space *mapping = file->f_mapping;
+	umode_t mode = file_inode(file)->i_mode;
+	pgoff_t index, last;
+	struct page *page;
+	bool uptodate;
+
+	if ((file->f_flags & O_DIRECT) || !req->ki_nbytes ||
+	    !(S_ISREG(mode) || S_ISBLK(mode)))
+		return false;
+
+	index = req->ki_pos >> PAGE_CACHE_SHIFT;
+	last = (req->ki_pos + req->ki_nbytes - 1) >> PAGE_CACHE_SHIFT;
+	if (last - index >= AIO_PUNT_CHECK_PAGES)
+		return true;
+
+	for (; index <= last; index++) {
+		page = find_get_page(mapping, index);
+		if (!page)
+			return true;
+		uptodate = PageUptodate(page);
+		page_cache_release(page);
+		if (!uptodate)
+			return true;
+	}
+	return false;
+}
+
+static void aio_punt_work(struct work_struct *work)
+{
+	struct aio_punt *punt = container_of(work, struct aio_punt, work);
+	struct kiocb *req = punt->req;
+	ssize_t ret;
+
+	use_mm(punt->mm);
+	ret = punt->rw_op(req, punt->iovec, punt->nr_segs, req->ki_pos);
+	unuse_mm(punt->mm);
+
+	/* The context may go away as soon as the request completes */
+	atomic_dec(&req->ki_ctx->nr_punted);
+	if (ret != -EIOCBQUEUED)
+		aio_complete(req, aio_fixup_ret(ret), 0);
+
+	mmput(punt->mm);
+	if (punt->iovec != &punt->inline_vec)
+		kfree(punt->iovec);
+	kfree(punt);
+}
+
+/*
+ * Hand a buffered read off to aio_wq.  On success the iovec is owned by
+ * the worker, which completes the request.
+ */
+static int aio_punt_read(struct kiocb *req, aio_rw_op *rw_op,
+			 struct iovec *iovec, unsigned long nr_segs,
+			 struct iovec *inline_vec)
+{
+	struct kioctx *ctx = req->ki_ctx;
+	struct aio_punt *punt;
+
+	if (atomic_inc_return(&ctx->nr_punted) > AIO_MAX_PUNTED)
+		goto out_dec;
+
+	punt = kmalloc(sizeof(*punt), GFP_KERNEL);
+	if (!punt)
+		goto out_dec;
+
+	INIT_WORK(&punt->work, aio_punt_work);
+	punt->req = req;
+	punt->rw_op = rw_op;
+	punt->nr_segs = nr_segs;
+	if (iovec == inline_vec) {
+		punt->inline_vec = *inline_vec;
+		punt->iovec = &punt->inline_vec;
+	} else {
+		punt->iovec = iovec;
+	}
+	punt->mm = current->mm;
+	atomic_inc(&punt->mm->mm_users);
+
+	queue_work(aio_wq, &punt->work);
+	return 0;
+
+out_dec:
+	atomic_dec(&ctx->nr_punted);
+	return -EAGAIN;
+}
+
 static ssize_t aio_setup_vectored_rw(struct kiocb *kiocb,
 				     int rw, char __user *buf,
 				     unsigned long *nr_segs,
@@ -1441,6 +1579,10 @@ rw_common:
 			break;
 		}
 
+		if (rw == READ && aio_read_would_block(req) &&
+		    !aio_punt_read(req, rw_op, iovec, nr_segs, &inline_vec))
+			return 0;
+
 		if (rw == WRITE)
 			file_start_write(file);
 
@@ -1472,17 +1614,8 @@ rw_common:
 	if (iovec != &inline_vec)
 		kfree(iovec);
 
-	if (ret != -EIOCBQUEUED) {
-		/*
-		 * There's no easy way to restart the syscall since other AIO's
-		 * may be already running. Just fail this IO with EINTR.
-		 */
-		if (unlikely(ret == -ERESTARTSYS || ret == -ERESTARTNOINTR ||
-			     ret == -ERESTARTNOHAND ||
-			     ret == -ERESTART_RESTARTBLOCK))
-			ret = -EINTR;
-		aio_complete(req, ret, 0);
-	}
+	if (ret != -EIOCBQUEUED)
+		aio_complete(req, aio_fixup_ret(ret), 0);
 
 	return 0;
 }
@@ -381,6 +381,31 @@ static unsigned long total_mapping_size(struct elf_phdr *cmds, int nr)
 				ELF_PAGESTART(cmds[first_idx].p_vaddr);
 }
 
+/*
+ * Reads the program headers, whose number the caller has checked. Returns
+ * them in a buffer which must be freed with kfree().
+ */
+static struct elf_phdr *load_elf_phdrs(struct elfhdr *elf_ex,
+		struct file *elf_file)
+{
+	struct elf_phdr *elf_phdata;
+	int retval, size;
+
+	size = sizeof(struct elf_phdr) * elf_ex->e_phnum;
+	elf_phdata = kmalloc(size, GFP_KERNEL);
+	if (!elf_phdata)
+		return ERR_PTR(-ENOMEM);
+
+	retval = kernel_read(elf_file, elf_ex->e_phoff, (char *)elf_phdata,
+			     size);
+	if (retval != size) {
+		kfree(elf_phdata);
+		return ERR_PTR(retval < 0 ? retval : -EIO);
+	}
+
+	return elf_phdata;
+}
+
 
 /* This is much more generalized than the library routine read function,
    so we keep this separate.  Technically the library read function
@@ -398,7 +423,7 @@ static unsigned long load_elf_interp(struct elfhdr *interp_elf_ex,
 	unsigned long last_bss = 0, elf_bss = 0;
 	unsigned long error = ~0UL;
 	unsigned long total_size;
-	int retval, i, size;
+	int i, size;
 
 	/* First of all, some simple consistency checks */
 	if (interp_elf_ex->e_type != ET_EXEC &&
@@ -423,17 +448,10 @@ static unsigned long load_elf_interp(struct elfhdr *interp_elf_ex,
 	size = sizeof(struct elf_phdr) * interp_elf_ex->e_phnum;
 	if (size > ELF_MIN_ALIGN)
 		goto out;
-	elf_phdata = kmalloc(size, GFP_KERNEL);
-	if (!elf_phdata)
+	elf_phdata = load_elf_phdrs(interp_elf_ex, interpreter);
+	if (IS_ERR(elf_phdata)) {
+		error = PTR_ERR(elf_phdata);
 		goto out;
-
-	retval = kernel_read(interpreter, interp_elf_ex->e_phoff,
-			     (char *)elf_phdata, size);
-	error = -EIO;
-	if (retval != size) {
-		if (retval < 0)
-			error = retval;	
-		goto out_close;
 	}
 
 	total_size = total_mapping_size(elf_phdata, interp_elf_ex->e_phnum);
@@ -573,7 +591,6 @@ static int load_elf_binary(struct linux_binprm *bprm)
 	struct elf_phdr *elf_ppnt, *elf_phdata;
 	unsigned long elf_bss, elf_brk;
 	int retval, i;
-	unsigned int size;
 	unsigned long elf_entry;
 	unsigned long interp_load_addr = 0;
 	unsigned long start_code, end_code, start_data, end_data;
@@ -613,18 +630,10 @@ static int load_elf_binary(struct linux_binprm *bprm)
 	if (loc->elf_ex.e_phnum < 1 ||
 	 	loc->elf_ex.e_phnum > 65536U / sizeof(struct elf_phdr))
 		goto out;
-	size = loc->elf_ex.e_phnum * sizeof(struct elf_phdr);
-	retval = -ENOMEM;
-	elf_phdata = kmalloc(size, GFP_KERNEL);
-	if (!elf_phdata)
+	elf_phdata = load_elf_phdrs(&loc->elf_ex, bprm->file);
+	if (IS_ERR(elf_phdata)) {
+		retval = PTR_ERR(elf_phdata);
 		goto out;
-
-	retval = kernel_read(bprm->file, loc->elf_ex.e_phoff,
-			     (char *)elf_phdata, size);
-	if (retval != size) {
-		if (retval >= 0)
-			retval = -EIO;
-		goto out_free_ph;
 	}
 
 	elf_ppnt = elf_phdata;
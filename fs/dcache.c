@@ -38,6 +38,7 @@
 #include <linux/prefetch.h>
 #include <linux/ratelimit.h>
 #include <linux/list_lru.h>
+#include <linux/workqueue.h>
 #include "internal.h"
 #include "mount.h"
 
@@ -117,6 +118,17 @@ struct dentry_stat_t dentry_stat = {
 static DEFINE_PER_CPU(long, nr_dentry);
 static DEFINE_PER_CPU(long, nr_dentry_unused);
 
+/*
+ * Upper bound on the unused negative dentries kept on each superblock's
+ * LRU; 0 leaves them to the generic shrinker.  Lookups of nonexistent
+ * paths (PATH and library searches) otherwise fill small machines with
+ * dentries that are only reclaimed under memory pressure.
+ */
+unsigned long sysctl_negative_dentry_limit __read_mostly;
+
+static void prune_negative_dentries(struct work_struct *work);
+static DECLARE_WORK(negative_dentry_work, prune_negative_dentries);
+
 #if defined(CONFIG_SYSCTL) && defined(CONFIG_PROC_FS)
 
 /*
@@ -302,6 +314,8 @@ static void dentry_iput(struct dentry * dentry)
 	}
 }
 
+static void d_negative_count(struct dentry *dentry);
+
 /*
  * Release the dentry's inode, using the filesystem
  * d_iput() operation if defined. dentry remains in-use.
@@ -313,6 +327,9 @@ static void dentry_unlink_inode(struct dentry * dentry)
 	struct inode *inode = dentry->d_inode;
 	__d_clear_type(dentry);
 	dentry->d_inode = NULL;
+	if ((dentry->d_flags & (DCACHE_LRU_LIST | DCACHE_SHRINK_LIST)) ==
+	    DCACHE_LRU_LIST)
+		d_negative_count(dentry);
 	hlist_del_init(&dentry->d_alias);
 	dentry_rcuwalk_barrier(dentry);
 	spin_unlock(&dentry->d_lock);
@@ -336,21 +353,49 @@ static void dentry_unlink_inode(struct dentry * dentry)
  * The per-cpu "nr_dentry_unused" counters are updated with
  * the DCACHE_LRU_LIST bit.
  *
+ * The DCACHE_NEGATIVE_LRU bit is set while a negative dentry sits
+ * on the superblock LRU (not a shrink list) and is accounted in
+ * sb->s_nr_negative_dentry.
+ *
  * These helper functions make sure we always follow the
  * rules. d_lock must be held by the caller.
  */
 #define D_FLAG_VERIFY(dentry,x) WARN_ON_ONCE(((dentry)->d_flags & (DCACHE_LRU_LIST | DCACHE_SHRINK_LIST)) != (x))
+static void d_negative_count(struct dentry *dentry)
+{
+	struct super_block *sb = dentry->d_sb;
+	unsigned long limit = sysctl_negative_dentry_limit;
+	long nr;
+
+	if (dentry->d_inode || (dentry->d_flags & DCACHE_NEGATIVE_LRU))
+		return;
+	dentry->d_flags |= DCACHE_NEGATIVE_LRU;
+	nr = atomic_long_inc_return(&sb->s_nr_negative_dentry);
+	if (limit && (unsigned long)nr > limit)
+		schedule_work(&negative_dentry_work);
+}
+
+static void d_negative_uncount(struct dentry *dentry)
+{
+	if (dentry->d_flags & DCACHE_NEGATIVE_LRU) {
+		dentry->d_flags &= ~DCACHE_NEGATIVE_LRU;
+		atomic_long_dec(&dentry->d_sb->s_nr_negative_dentry);
+	}
+}
+
 static void d_lru_add(struct dentry *dentry)
 {
 	D_FLAG_VERIFY(dentry, 0);
 	dentry->d_flags |= DCACHE_LRU_LIST;
 	this_cpu_inc(nr_dentry_unused);
 	WARN_ON_ONCE(!list_lru_add(&dentry->d_sb->s_dentry_lru, &dentry->d_lru));
+	d_negative_count(dentry);
 }
 
 static void d_lru_del(struct dentry *dentry)
 {
 	D_FLAG_VERIFY(dentry, DCACHE_LRU_LIST);
+	d_negative_uncount(dentry);
 	dentry->d_flags &= ~DCACHE_LRU_LIST;
 	this_cpu_dec(nr_dentry_unused);
 	WARN_ON_ONCE(!list_lru_del(&dentry->d_sb->s_dentry_lru, &dentry->d_lru));
@@ -381,6 +426,7 @@ static void d_shrink_add(struct dentry *dentry, struct list_head *list)
 static void d_lru_isolate(struct dentry *dentry)
 {
 	D_FLAG_VERIFY(dentry, DCACHE_LRU_LIST);
+	d_negative_uncount(dentry);
 	dentry->d_flags &= ~DCACHE_LRU_LIST;
 	this_cpu_dec(nr_dentry_unused);
 	list_del_init(&dentry->d_lru);
@@ -389,6 +435,7 @@ static void d_lru_isolate(struct dentry *dentry)
 static void d_lru_shrink_move(struct dentry *dentry, struct list_head *list)
 {
 	D_FLAG_VERIFY(dentry, DCACHE_LRU_LIST);
+	d_negative_uncount(dentry);
 	dentry->d_flags |= DCACHE_SHRINK_LIST;
 	list_move_tail(&dentry->d_lru, list);
 }
@@ -1037,6 +1084,64 @@ void shrink_dcache_sb(struct super_block *sb)
 }
 EXPORT_SYMBOL(shrink_dcache_sb);
 
+struct negative_prune {
+	struct list_head	dispose;
+	long			nr;
+};
+
+static enum lru_status dentry_lru_isolate_negative(struct list_head *item,
+						spinlock_t *lru_lock, void *arg)
+{
+	struct negative_prune *np = arg;
+	struct dentry	*dentry = container_of(item, struct dentry, d_lru);
+
+	if (np->nr <= 0)
+		return LRU_SKIP;
+
+	if (!spin_trylock(&dentry->d_lock))
+		return LRU_SKIP;
+
+	/*
+	 * Only unused negative dentries go; DCACHE_REFERENCED is ignored
+	 * on purpose so that repeated misses cannot pin them past the cap.
+	 */
+	if (dentry->d_inode || dentry->d_lockref.count) {
+		spin_unlock(&dentry->d_lock);
+		return LRU_SKIP;
+	}
+
+	d_lru_shrink_move(dentry, &np->dispose);
+	spin_unlock(&dentry->d_lock);
+	np->nr--;
+
+	return LRU_REMOVED;
+}
+
+static void prune_negative_sb(struct super_block *sb, void *arg)
+{
+	unsigned long limit = sysctl_negative_dentry_limit;
+	struct negative_prune np;
+	long excess;
+
+	if (!limit)
+		return;
+	excess = atomic_long_read(&sb->s_nr_negative_dentry) - limit;
+	if (excess <= 0)
+		return;
+
+	/* trim below the limit so we are not rescheduled on every miss */
+	INIT_LIST_HEAD(&np.dispose);
+	np.nr = excess + limit / 8;
+	list_lru_walk(&sb->s_dentry_lru, dentry_lru_isolate_negative, &np,
+		      list_lru_count(&sb->s_dentry_lru));
+	shrink_dentry_list(&np.dispose);
+}
+
+static void prune_negative_dentries(struct work_struct *work)
+{
+	iterate_supers(prune_negative_sb, NULL);
+}
+
 /**
  * enum d_walk_ret - action to talke during tree walk
  * @D_WALK_CONTINUE:	contrinue walk
@@ -1647,8 +1752,10 @@ static void __d_instantiate(struct dentry *dentry, struct inode *inode)
 
 	spin_lock(&dentry->d_lock);
 	__d_set_type(dentry, add_flags);
-	if (inode)
+	if (inode) {
 		hlist_add_head(&dentry->d_alias, &inode->i_dentry);
+		d_negative_uncount(dentry);
+	}
 	dentry->d_inode = inode;
 	dentry_rcuwalk_barrier(dentry);
 	spin_unlock(&dentry->d_lock);
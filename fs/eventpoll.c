@@ -103,6 +103,10 @@
 
 #define EP_ITEM_COST (sizeof(struct epitem) + sizeof(struct eppoll_entry))
 
+/* Upper bounds for the EPIOCSBATCH parameters */
+#define EP_MAX_BATCH 64
+#define EP_MAX_BATCH_DELAY_US USEC_PER_SEC
+
 struct epoll_filefd {
 	struct file *file;
 	int fd;
@@ -219,6 +223,18 @@ struct eventpoll {
 	/* used to optimize loop detection check */
 	int visited;
 	struct list_head visited_list_link;
+
+	/*
+	 * Wakeup coalescing set through EPIOCSBATCH: a waiter that has some
+	 * events ready holds on until @batch_min are ready or @batch_delay_us
+	 * has passed.  @batch_want is the threshold of the current batching
+	 * waiters, below which ep_poll_callback() does not wake them.
+	 * Protected by ->lock.
+	 */
+	unsigned int batch_min;
+	unsigned int batch_delay_us;
+	unsigned int batch_want;
+	unsigned int batch_waiters;
 };
 
 /* Wait structure used by the poll hooks */
@@ -379,6 +395,21 @@ static inline int ep_events_available(struct eventpoll *ep)
 	return !list_empty(&ep->rdllist) || ep->ovflist != EP_UNACTIVE_PTR;
 }
 
+/*
+ * Count the items on the ready list, stopping at @max.  Must be called
+ * with ->lock held.
+ */
+static inline int ep_ready_count(struct eventpoll *ep, int max)
+{
+	struct list_head *pos;
+	int n = 0;
+
+	list_for_each(pos, &ep->rdllist)
+		if (++n >= max)
+			break;
+	return n;
+}
+
 /**
  * ep_call_nested - Perform a bound (possibly) nested call, by checking
  *                  that the recursion limit is not exceeded, and that
@@ -893,12 +924,56 @@ static int ep_show_fdinfo(struct seq_file *m, struct file *f)
 #endif
 
 /* File callbacks that implement the eventpoll file behaviour */
+static long ep_eventpoll_ioctl(struct file *file, unsigned int cmd,
+			       unsigned long arg)
+{
+	struct eventpoll *ep = file->private_data;
+	void __user *uarg = (void __user *) arg;
+	struct epoll_batch_params params;
+
+	switch (cmd) {
+	case EPIOCSBATCH:
+		if (copy_from_user(&params, uarg, sizeof(params)))
+			return -EFAULT;
+		if (params.min_events > EP_MAX_BATCH ||
+		    params.max_delay_us > EP_MAX_BATCH_DELAY_US)
+			return -EINVAL;
+		spin_lock_irq(&ep->lock);
+		ep->batch_min = params.min_events;
+		ep->batch_delay_us = params.max_delay_us;
+		spin_unlock_irq(&ep->lock);
+		return 0;
+	case EPIOCGBATCH:
+		spin_lock_irq(&ep->lock);
+		params.min_events = ep->batch_min;
+		params.max_delay_us = ep->batch_delay_us;
+		spin_unlock_irq(&ep->lock);
+		if (copy_to_user(uarg, &params, sizeof(params)))
+			return -EFAULT;
+		return 0;
+	default:
+		return -ENOTTY;
+	}
+}
+
+#ifdef CONFIG_COMPAT
+static long ep_eventpoll_compat_ioctl(struct file *file, unsigned int cmd,
+				      unsigned long arg)
+{
+	return ep_eventpoll_ioctl(file, cmd, (unsigned long) compat_ptr(arg));
+}
+#endif
+
 static const struct file_operations eventpoll_fops = {
 #ifdef CONFIG_PROC_FS
 	.show_fdinfo	= ep_show_fdinfo,
 #endif
 	.release	= ep_eventpoll_release,
 	.poll		= ep_eventpoll_poll,
+	.unlocked_ioctl	= ep_eventpoll_ioctl,
+#ifdef CONFIG_COMPAT
+	.compat_ioctl	= ep_eventpoll_compat_ioctl,
+#endif
 	.llseek		= noop_llseek,
 };
 
@@ -1067,9 +1142,12 @@ static int ep_poll_callback(wait_queue_t *wait, unsigned mode, int sync, void *k
 
 	/*
 	 * Wake up ( if active ) both the eventpoll wait list and the ->poll()
-	 * wait list.
+	 * wait list.  Batching waiters are only woken once their batch is
+	 * complete, their own timer covers the deadline.
 	 */
-	if (waitqueue_active(&ep->wq))
+	if (waitqueue_active(&ep->wq) &&
+	    (!ep->batch_want ||
+	     ep_ready_count(ep, ep->batch_want) >= ep->batch_want))
 		wake_up_locked(&ep->wq);
 	if (waitqueue_active(&ep->poll_wait))
 		pwake++;
@@ -1646,6 +1724,51 @@ fetch_events:
 
 		set_current_state(TASK_RUNNING);
 	}
+
+	/*
+	 * Events are available.  If the caller asked for wakeup coalescing,
+	 * hold on until enough of them have accumulated or the coalescing
+	 * delay, capped by the caller's own timeout, has passed.
+	 */
+	if (!res && !timed_out && ep->batch_min > 1 && ep->batch_delay_us &&
+	    ep_events_available(ep)) {
+		int want = min_t(int, ep->batch_min, maxevents);
+		int capped = 0, expired = 0;
+		ktime_t batch_to;
+
+		if (ep_ready_count(ep, want) < want) {
+			batch_to = ktime_add_us(ktime_get(), ep->batch_delay_us);
+			if (to && ktime_compare(*to, batch_to) < 0) {
+				batch_to = *to;
+				capped = 1;
+			}
+
+			ep->batch_want = want;
+			ep->batch_waiters++;
+			init_waitqueue_entry(&wait, current);
+			__add_wait_queue_exclusive(&ep->wq, &wait);
+
+			for (;;) {
+				set_current_state(TASK_INTERRUPTIBLE);
+				if (expired || signal_pending(current) ||
+				    ep_ready_count(ep, want) >= want)
+					break;
+
+				spin_unlock_irqrestore(&ep->lock, flags);
+				if (!schedule_hrtimeout_range(&batch_to, slack,
+							      HRTIMER_MODE_ABS))
+					expired = 1;
+				spin_lock_irqsave(&ep->lock, flags);
+			}
+			__remove_wait_queue(&ep->wq, &wait);
+			if (!--ep->batch_waiters)
+				ep->batch_want = 0;
+
+			set_current_state(TASK_RUNNING);
+			if (expired && capped)
+				timed_out = 1;
+		}
+	}
 check_events:
 	/* Is it worth to try to dig for events ? */
 	eavail = ep_events_available(ep);
@@ -56,6 +56,7 @@
 #include <linux/pipe_fs_i.h>
 #include <linux/oom.h>
 #include <linux/compat.h>
+#include <linux/task_work.h>
 
 #include <asm/uaccess.h>
 #include <asm/mmu_context.h>
@@ -1629,3 +1630,122 @@ asmlinkage long compat_sys_execve(const char __user * filename,
 	return compat_do_execve(getname(filename), argv, envp);
 }
 #endif
+
+/*
+ * spawn() starts a new program in a child process, like vfork() followed by
+ * execve() in the child. The exec runs in the child before it ever returns
+ * to user space, so neither the parent's page tables are copied as by
+ * fork(), nor does the child run on the parent's stack as after vfork().
+ */
+struct spawn_request {
+	struct callback_head work;
+	atomic_t users;
+	const char __user *filename;
+	struct user_arg_ptr argv;
+	struct user_arg_ptr envp;
+	sigset_t blocked;
+	int error;
+};
+
+static void spawn_put(struct spawn_request *req)
+{
+	if (atomic_dec_and_test(&req->users))
+		kfree(req);
+}
+
+static void spawn_exec(struct callback_head *work)
+{
+	struct spawn_request *req = container_of(work, struct spawn_request,
+						 work);
+	int error;
+
+	/* Killed before it got to run */
+	if (current->flags & PF_EXITING) {
+		spawn_put(req);
+		return;
+	}
+
+	error = do_execve_common(getname(req->filename), req->argv,
+				 req->envp);
+	if (error) {
+		/* Seen by the parent once the child has released the mm */
+		req->error = error;
+		spawn_put(req);
+		do_exit(127 << 8);
+	}
+
+	/* The new program runs with the parent's signal mask */
+	set_current_blocked(&req->blocked);
+	spawn_put(req);
+}
+
+static long do_spawn(const char __user *filename, struct user_arg_ptr argv,
+		     struct user_arg_ptr envp)
+{
+	struct spawn_request *req;
+	sigset_t all;
+	long pid;
+
+	req = kzalloc(sizeof(*req), GFP_KERNEL);
+	if (!req)
+		return -ENOMEM;
+
+	init_task_work(&req->work, spawn_exec);
+	atomic_set(&req->users, 2);
+	req->filename = filename;
+	req->argv = argv;
+	req->envp = envp;
+
+	/*
+	 * The child inherits a full signal mask, so no handler of the parent
+	 * runs in it before the exec has reset them. SIGKILL and SIGSTOP must
+	 * stay deliverable, sigprocmask() does not filter them out.
+	 */
+	sigfillset(&all);
+	sigdelsetmask(&all, sigmask(SIGKILL) | sigmask(SIGSTOP));
+	sigprocmask(SIG_SETMASK, &all, &req->blocked);
+
+	pid = do_vfork_work(&req->work);
+
+	set_current_blocked(&req->blocked);
+
+	if (pid < 0) {
+		/* The child was never created */
+		spawn_put(req);
+	} else if (req->error) {
+		sys_wait4(pid, NULL, 0, NULL);
+		pid = req->error;
+	}
+
+	spawn_put(req);
+
+	return pid;
+}
+
+SYSCALL_DEFINE3(spawn,
+		const char __user *, filename,
+		const char __user *const __user *, argv,
+		const char __user *const __user *, envp)
+{
+	struct user_arg_ptr uargv = { .ptr.native = argv };
+	struct user_arg_ptr uenvp = { .ptr.native = envp };
+
+	return do_spawn(filename, uargv, uenvp);
+}
+#ifdef CONFIG_COMPAT
+asmlinkage long compat_sys_spawn(const char __user * filename,
+	const compat_uptr_t __user * argv,
+	const compat_uptr_t __user * envp)
+{
+	struct user_arg_ptr uargv = {
+		.is_compat = true,
+		.ptr.compat = argv,
+	};
+	struct user_arg_ptr uenvp = {
+		.is_compat = true,
+		.ptr.compat = envp,
+	};
+
+	return do_spawn(filename, uargv, uenvp);
+}
+#endif
@@ -2591,6 +2591,11 @@ retry:
 		 */
 		mapping->writeback_index = mpd.first_page;
 
+	/* Let the journal commit ride along with background writeback */
+	if (test_opt(inode->i_sb, FLASH) && wbc->sync_mode == WB_SYNC_NONE &&
+	    sbi->s_journal)
+		jbd2_journal_commit_due(sbi->s_journal);
+
 out_writepages:
 	trace_ext4_writepages_result(inode, wbc, ret,
 				     nr_to_write - wbc->nr_to_write);
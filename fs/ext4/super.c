@@ -39,6 +39,7 @@
 #include <linux/log2.h>
 #include <linux/crc16.h>
 #include <linux/cleancache.h>
+#include <linux/writeback.h>
 #include <asm/uaccess.h>
 
 #include <linux/kthread.h>
@@ -1160,7 +1161,7 @@ enum {
 	Opt_inode_readahead_blks, Opt_journal_ioprio,
 	Opt_dioread_nolock, Opt_dioread_lock,
 	Opt_discard, Opt_nodiscard, Opt_init_itable, Opt_noinit_itable,
-	Opt_max_dir_size_kb,
+	Opt_max_dir_size_kb, Opt_flash, Opt_noflash,
 };
 
 static const match_table_t tokens = {
@@ -1235,6 +1236,8 @@ static const match_table_t tokens = {
 	{Opt_init_itable, "init_itable=%u"},
 	{Opt_init_itable, "init_itable"},
 	{Opt_noinit_itable, "noinit_itable"},
+	{Opt_flash, "flash"},
+	{Opt_noflash, "noflash"},
 	{Opt_max_dir_size_kb, "max_dir_size_kb=%u"},
 	{Opt_removed, "check=none"},	/* mount option from ext2/3 */
 	{Opt_removed, "nocheck"},	/* mount option from ext2/3 */
@@ -1393,6 +1396,8 @@ static const struct mount_opts {
 	{Opt_noauto_da_alloc, EXT4_MOUNT_NO_AUTO_DA_ALLOC, MOPT_SET},
 	{Opt_auto_da_alloc, EXT4_MOUNT_NO_AUTO_DA_ALLOC, MOPT_CLEAR},
 	{Opt_noinit_itable, EXT4_MOUNT_INIT_INODE_TABLE, MOPT_CLEAR},
+	{Opt_flash, EXT4_MOUNT_FLASH, MOPT_EXT4_ONLY | MOPT_SET},
+	{Opt_noflash, EXT4_MOUNT_FLASH, MOPT_EXT4_ONLY | MOPT_CLEAR},
 	{Opt_commit, 0, MOPT_GTE0},
 	{Opt_max_batch_time, 0, MOPT_GTE0},
 	{Opt_min_batch_time, 0, MOPT_GTE0},
@@ -2819,6 +2824,26 @@ static void print_daily_error_info(unsigned long arg)
 	mod_timer(&sbi->s_err_report, jiffies + 24*60*60*HZ);  /* Once a day */
 }
 
+/*
+ * Check whether the device has been serving other I/O since the last
+ * lazyinit run: either requests are in flight, or it was busy for more
+ * than a quarter of the elapsed time.  Our own zeroing stays well below
+ * that thanks to s_li_wait_mult.
+ */
+static int ext4_li_device_busy(struct ext4_li_request *elr)
+{
+	struct hd_struct *part = &elr->lr_super->s_bdev->bd_disk->part0;
+	unsigned long ticks = part_stat_read(part, io_ticks);
+	unsigned long elapsed = jiffies - elr->lr_io_stamp;
+	int busy;
+
+	busy = part_in_flight(part) ||
+	       (elr->lr_io_stamp && (ticks - elr->lr_io_ticks) * 4 > elapsed);
+	elr->lr_io_ticks = ticks;
+	elr->lr_io_stamp = jiffies;
+	return busy;
+}
+
 /* Find next suitable group and run ext4_init_inode_table */
 static int ext4_run_li_request(struct ext4_li_request *elr)
 {
@@ -2831,6 +2856,13 @@ static int ext4_run_li_request(struct ext4_li_request *elr)
 	sb = elr->lr_super;
 	ngroups = EXT4_SB(sb)->s_groups_count;
 
+	/* On flash, zeroing competes badly with foreground writes */
+	if (test_opt(sb, FLASH) && ext4_li_device_busy(elr)) {
+		elr->lr_next_sched = jiffies +
+			max_t(unsigned long, elr->lr_timeout, HZ);
+		return 0;
+	}
+
 	sb_start_write(sb);
 	for (group = elr->lr_next_group; group < ngroups; group++) {
 		gdp = ext4_get_group_desc(sb, group, NULL);
@@ -4244,6 +4276,21 @@ static void ext4_init_journal_params(struct super_block *sb, journal_t *journal)
 	journal->j_min_batch_time = sbi->s_min_batch_time;
 	journal->j_max_batch_time = sbi->s_max_batch_time;
 
+	/*
+	 * On flash, let commits ride along with the flusher's writeback and
+	 * keep each commit within one erase unit of the journal device.
+	 */
+	if (test_opt(sb, FLASH)) {
+		journal->j_commit_slack = min_t(unsigned long,
+				msecs_to_jiffies(dirty_writeback_interval * 10),
+				sbi->s_commit_interval / 2);
+		journal->j_align = bdev_io_opt(journal->j_dev) /
+				   journal->j_blocksize;
+	} else {
+		journal->j_commit_slack = 0;
+		journal->j_align = 0;
+	}
+
 	write_lock(&journal->j_state_lock);
 	if (test_opt(sb, BARRIER))
 		journal->j_flags |= JBD2_BARRIER;
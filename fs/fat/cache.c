@@ -15,6 +15,11 @@
 
 /* this must be > 0. */
 #define FAT_MAX_CACHE	8
+/*
+ * Regular files get more extents, so seeking in a large, fragmented
+ * media file does not keep walking the FAT from the start.
+ */
+#define FAT_MAX_CACHE_FILE	64
 
 struct fat_cache {
 	struct list_head cache_list;
@@ -32,6 +37,8 @@ struct fat_cache_id {
 
 static inline int fat_max_cache(struct inode *inode)
 {
+	if (S_ISREG(inode->i_mode))
+		return FAT_MAX_CACHE_FILE;
 	return FAT_MAX_CACHE;
 }
 
@@ -7,6 +7,7 @@
 #include <linux/fs.h>
 #include <linux/msdos_fs.h>
 #include <linux/blkdev.h>
+#include <linux/vmalloc.h>
 #include "fat.h"
 
 struct fatent_operations {
@@ -488,6 +489,17 @@ int fat_alloc_clusters(struct inode *inode, int *cluster, int nr_cluster)
 	while (count < sbi->max_cluster) {
 		if (fatent.entry >= sbi->max_cluster)
 			fatent.entry = FAT_START_ENT;
+		if (sbi->free_map) {
+			/* skip clusters the bitmap knows are in use */
+			int next = find_next_zero_bit(sbi->free_map,
+						      sbi->max_cluster,
+						      fatent.entry);
+
+			count += next - fatent.entry;
+			fatent.entry = next;
+			if (next >= sbi->max_cluster)
+				continue;
+		}
 		fatent_set_entry(&fatent, fatent.entry);
 		err = fat_ent_read_block(sb, &fatent);
 		if (err)
@@ -505,6 +517,8 @@ int fat_alloc_clusters(struct inode *inode, int *cluster, int nr_cluster)
 
 				fat_collect_bhs(bhs, &nr_bhs, &fatent);
 
+				if (sbi->free_map)
+					__set_bit(entry, sbi->free_map);
 				sbi->prev_free = entry;
 				if (sbi->free_clusters != -1)
 					sbi->free_clusters--;
@@ -594,6 +608,8 @@ int fat_free_clusters(struct inode *inode, int cluster)
 		}
 
 		ops->ent_put(&fatent, FAT_ENT_FREE);
+		if (sbi->free_map)
+			__clear_bit(fatent.entry, sbi->free_map);
 		if (sbi->free_clusters != -1) {
 			sbi->free_clusters++;
 			dirty_fsinfo = 1;
@@ -649,7 +665,12 @@ static void fat_ent_reada(struct super_block *sb, struct fat_entry *fatent,
 		sb_breadahead(sb, blocknr + i);
 }
 
-int fat_count_free_clusters(struct super_block *sb)
+/*
+ * Walk the whole FAT and count the free entries.  If @map is given, the
+ * in-use entries are also marked in it.  Called with lock_fat() held.
+ */
+static int fat_scan_clusters(struct super_block *sb, unsigned long *map,
+			     int *nr_free)
 {
 	struct msdos_sb_info *sbi = MSDOS_SB(sb);
 	struct fatent_operations *ops = sbi->fatent_ops;
@@ -657,10 +678,6 @@ int fat_count_free_clusters(struct super_block *sb)
 	unsigned long reada_blocks, reada_mask, cur_block;
 	int err = 0, free;
 
-	lock_fat(sbi);
-	if (sbi->free_clusters != -1 && sbi->free_clus_valid)
-		goto out;
-
 	reada_blocks = FAT_READA_SIZE >> sb->s_blocksize_bits;
 	reada_mask = reada_blocks - 1;
 	cur_block = 0;
@@ -677,19 +694,180 @@ int fat_count_free_clusters(struct super_block *sb)
 		cur_block++;
 
 		err = fat_ent_read_block(sb, &fatent);
-		if (err)
-			goto out;
+		if (err) {
+			fatent_brelse(&fatent);
+			return err;
+		}
 
 		do {
 			if (ops->ent_get(&fatent) == FAT_ENT_FREE)
 				free++;
+			else if (map)
+				__set_bit(fatent.entry, map);
 		} while (fat_ent_next(sbi, &fatent));
 	}
+	fatent_brelse(&fatent);
+	*nr_free = free;
+	return 0;
+}
+
+int fat_count_free_clusters(struct super_block *sb)
+{
+	struct msdos_sb_info *sbi = MSDOS_SB(sb);
+	int err = 0, free;
+
+	lock_fat(sbi);
+	if (sbi->free_clusters != -1 && sbi->free_clus_valid)
+		goto out;
+
+	err = fat_scan_clusters(sb, NULL, &free);
+	if (err)
+		goto out;
 	sbi->free_clusters = free;
 	sbi->free_clus_valid = 1;
 	mark_fsinfo_dirty(sb);
-	fatent_brelse(&fatent);
 out:
 	unlock_fat(sbi);
 	return err;
 }
+
+/*
+ * Build the in-use cluster bitmap that lets fat_alloc_clusters() skip
+ * allocated clusters without reading their FAT blocks.  The bitmap is a
+ * hint only: a clear bit is still checked against the FAT, and every
+ * free goes through fat_free_clusters(), which clears it again.
+ *
+ * Run from a work item after mount, so the one full FAT scan does not
+ * hold up mount or the first write.
+ */
+void fat_free_map_workfn(struct work_struct *work)
+{
+	struct msdos_sb_info *sbi = container_of(work, struct msdos_sb_info,
+						 free_map_work);
+	struct super_block *sb = sbi->fat_inode->i_sb;
+	unsigned long *map;
+	int err, free;
+
+	map = vzalloc(BITS_TO_LONGS(sbi->max_cluster) * sizeof(long));
+	if (!map)
+		return;
+
+	lock_fat(sbi);
+	err = fat_scan_clusters(sb, map, &free);
+	if (!err) {
+		sbi->free_map = map;
+		map = NULL;
+		if (sbi->free_clusters != free || !sbi->free_clus_valid) {
+			sbi->free_clusters = free;
+			sbi->free_clus_valid = 1;
+			mark_fsinfo_dirty(sb);
+		}
+	}
+	unlock_fat(sbi);
+
+	vfree(map);
+}
+
+static int fat_trim_clusters(struct super_block *sb, u32 clus, u32 nr_clus)
+{
+	struct msdos_sb_info *sbi = MSDOS_SB(sb);
+
+	return sb_issue_discard(sb, fat_clus_to_blknr(sbi, clus),
+				nr_clus * sbi->sec_per_clus, GFP_NOFS, 0);
+}
+
+/*
+ * Discard every run of free clusters in @range that is at least
+ * range->minlen long (FITRIM).  On return range->len holds the number
+ * of bytes trimmed.
+ */
+int fat_trim_fs(struct inode *inode, struct fstrim_range *range)
+{
+	struct super_block *sb = inode->i_sb;
+	struct msdos_sb_info *sbi = MSDOS_SB(sb);
+	struct fatent_operations *ops = sbi->fatent_ops;
+	struct fat_entry fatent;
+	u64 ent_start, ent_end, minlen, trimmed = 0;
+	u32 free = 0;
+	unsigned long reada_blocks, reada_mask, cur_block = 0;
+	int err = 0;
+
+	/*
+	 * FAT data is organised in clusters, so trim at cluster
+	 * granularity and treat everything before the data area as used.
+	 */
+	ent_start = max_t(u64, range->start >> sbi->cluster_bits,
+			  FAT_START_ENT);
+	ent_end = ent_start + (range->len >> sbi->cluster_bits) - 1;
+	minlen = range->minlen >> sbi->cluster_bits;
+
+	if (ent_start >= sbi->max_cluster || range->len < sbi->cluster_size)
+		return -EINVAL;
+	if (ent_end >= sbi->max_cluster)
+		ent_end = sbi->max_cluster - 1;
+
+	reada_blocks = FAT_READA_SIZE >> sb->s_blocksize_bits;
+	reada_mask = reada_blocks - 1;
+
+	fatent_init(&fatent);
+	lock_fat(sbi);
+	fatent_set_entry(&fatent, ent_start);
+	while (fatent.entry <= ent_end) {
+		/* readahead of fat blocks */
+		if ((cur_block & reada_mask) == 0) {
+			unsigned long rest = sbi->fat_length - cur_block;
+			fat_ent_reada(sb, &fatent, min(reada_blocks, rest));
+		}
+		cur_block++;
+
+		err = fat_ent_read_block(sb, &fatent);
+		if (err)
+			goto error;
+		do {
+			if (ops->ent_get(&fatent) == FAT_ENT_FREE) {
+				free++;
+			} else if (free) {
+				if (free >= minlen) {
+					u32 clus = fatent.entry - free;
+
+					err = fat_trim_clusters(sb, clus, free);
+					if (err && err != -EOPNOTSUPP)
+						goto error;
+					if (!err)
+						trimmed += free;
+					err = 0;
+				}
+				free = 0;
+			}
+		} while (fat_ent_next(sbi, &fatent) && fatent.entry <= ent_end);
+
+		if (fatal_signal_pending(current)) {
+			err = -ERESTARTSYS;
+			goto error;
+		}
+
+		if (need_resched()) {
+			fatent_brelse(&fatent);
+			unlock_fat(sbi);
+			cond_resched();
+			lock_fat(sbi);
+		}
+	}
+	/* the range may end in a run of free clusters */
+	if (free && free >= minlen) {
+		u32 clus = fatent.entry - free;
+
+		err = fat_trim_clusters(sb, clus, free);
+		if (err && err != -EOPNOTSUPP)
+			goto error;
+		if (!err)
+			trimmed += free;
+		err = 0;
+	}
+
+error:
+	unlock_fat(sbi);
+	fatent_brelse(&fatent);
+	range->len = trimmed << sbi->cluster_bits;
+	return err;
+}
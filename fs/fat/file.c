@@ -17,8 +17,13 @@
 #include <linux/blkdev.h>
 #include <linux/fsnotify.h>
 #include <linux/security.h>
+#include <linux/falloc.h>
+#include <linux/aio.h>
 #include "fat.h"
 
+static long fat_fallocate(struct file *file, int mode,
+			  loff_t offset, loff_t len);
+
 static int fat_ioctl_get_attributes(struct inode *inode, u32 __user *user_attr)
 {
 	u32 attr;
@@ -120,6 +125,37 @@ static int fat_ioctl_get_volume_id(struct inode *inode, u32 __user *user_attr)
 	return put_user(sbi->vol_id, user_attr);
 }
 
+static int fat_ioctl_fitrim(struct inode *inode, unsigned long arg)
+{
+	struct super_block *sb = inode->i_sb;
+	struct fstrim_range __user *user_range;
+	struct fstrim_range range;
+	struct request_queue *q = bdev_get_queue(sb->s_bdev);
+	int err;
+
+	if (!capable(CAP_SYS_ADMIN))
+		return -EPERM;
+
+	if (!blk_queue_discard(q))
+		return -EOPNOTSUPP;
+
+	user_range = (struct fstrim_range __user *)arg;
+	if (copy_from_user(&range, user_range, sizeof(range)))
+		return -EFAULT;
+
+	range.minlen = max_t(unsigned int, range.minlen,
+			     q->limits.discard_granularity);
+
+	err = fat_trim_fs(inode, &range);
+	if (err < 0)
+		return err;
+
+	if (copy_to_user(user_range, &range, sizeof(range)))
+		return -EFAULT;
+
+	return 0;
+}
+
 long fat_generic_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 {
 	struct inode *inode = file_inode(filp);
@@ -132,6 +168,8 @@ long fat_generic_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 		return fat_ioctl_set_attributes(filp, user_attr);
 	case FAT_IOCTL_GET_VOLUME_ID:
 		return fat_ioctl_get_volume_id(inode, user_attr);
+	case FITRIM:
+		return fat_ioctl_fitrim(inode, arg);
 	default:
 		return -ENOTTY;	/* Inappropriate ioctl for device */
 	}
@@ -156,6 +194,47 @@ static int fat_file_release(struct inode *inode, struct file *filp)
 	return 0;
 }
 
+/*
+ * Allocate the clusters a write will need up front, so a large write gets
+ * one contiguous run and batched FAT updates instead of one cluster per
+ * ->get_block() call.  Anything left unused is freed on eviction, or on
+ * a failed write by fat_write_failed().
+ */
+static void fat_prealloc_write(struct inode *inode, loff_t end)
+{
+	struct msdos_sb_info *sbi = MSDOS_SB(inode->i_sb);
+	loff_t ondisksize;
+	int nr_cluster;
+
+	mutex_lock(&inode->i_mutex);
+	ondisksize = inode->i_blocks << 9;
+	if (end > ondisksize) {
+		nr_cluster = (end - ondisksize + sbi->cluster_size - 1) >>
+			sbi->cluster_bits;
+		/* a single cluster gains nothing over ->get_block() */
+		if (nr_cluster > 1)
+			fat_add_clusters(inode, nr_cluster);
+	}
+	mutex_unlock(&inode->i_mutex);
+}
+
+static ssize_t fat_file_aio_write(struct kiocb *iocb, const struct iovec *iov,
+				  unsigned long nr_segs, loff_t pos)
+{
+	struct file *file = iocb->ki_filp;
+	struct inode *inode = file_inode(file);
+	size_t count = iov_length(iov, nr_segs);
+	loff_t end = pos + count;
+
+	if (file->f_flags & O_APPEND)
+		end = i_size_read(inode) + count;
+	if (count > MSDOS_SB(inode->i_sb)->cluster_size &&
+	    !(file->f_flags & O_DIRECT))
+		fat_prealloc_write(inode, end);
+
+	return generic_file_aio_write(iocb, iov, nr_segs, pos);
+}
+
 int fat_file_fsync(struct file *filp, loff_t start, loff_t end, int datasync)
 {
 	struct inode *inode = filp->f_mapping->host;
@@ -173,7 +252,7 @@ const struct file_operations fat_file_operations = {
 	.read		= do_sync_read,
 	.write		= do_sync_write,
 	.aio_read	= generic_file_aio_read,
-	.aio_write	= generic_file_aio_write,
+	.aio_write	= fat_file_aio_write,
 	.mmap		= generic_file_mmap,
 	.release	= fat_file_release,
 	.unlocked_ioctl	= fat_generic_ioctl,
@@ -182,6 +261,7 @@ const struct file_operations fat_file_operations = {
 #endif
 	.fsync		= fat_file_fsync,
 	.splice_read	= generic_file_splice_read,
+	.fallocate	= fat_fallocate,
 };
 
 static int fat_cont_expand(struct inode *inode, loff_t size)
@@ -220,6 +300,46 @@ out:
 	return err;
 }
 
+/*
+ * Preallocate space for a file.  With FALLOC_FL_KEEP_SIZE the clusters
+ * are only chained to the file and the size is untouched; otherwise the
+ * file is extended and the new range zeroed like an expanding truncate.
+ */
+static long fat_fallocate(struct file *file, int mode,
+			  loff_t offset, loff_t len)
+{
+	struct inode *inode = file->f_mapping->host;
+	struct msdos_sb_info *sbi = MSDOS_SB(inode->i_sb);
+	loff_t ondisksize;
+	int nr_cluster;
+	int err = 0;
+
+	/* No support for hole punch or other fallocate flags. */
+	if (mode & ~FALLOC_FL_KEEP_SIZE)
+		return -EOPNOTSUPP;
+
+	if (!S_ISREG(inode->i_mode))
+		return -EOPNOTSUPP;
+
+	mutex_lock(&inode->i_mutex);
+	ondisksize = inode->i_blocks << 9;
+	if (offset + len > ondisksize) {
+		nr_cluster = (offset + len - ondisksize +
+			      sbi->cluster_size - 1) >> sbi->cluster_bits;
+		/* The clusters are not zeroed, reads stop at i_size */
+		err = fat_add_clusters(inode, nr_cluster);
+		if (err)
+			goto out;
+	}
+
+	if (!(mode & FALLOC_FL_KEEP_SIZE) &&
+	    offset + len > i_size_read(inode))
+		err = fat_cont_expand(inode, offset + len);
+out:
+	mutex_unlock(&inode->i_mutex);
+	return err;
+}
+
 /* Free all clusters after the skip'th cluster. */
 static int fat_free(struct inode *inode, int skip)
 {
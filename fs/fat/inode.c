@@ -27,6 +27,7 @@
 #include <linux/log2.h>
 #include <linux/hash.h>
 #include <linux/blkdev.h>
+#include <linux/vmalloc.h>
 #include <asm/unaligned.h>
 #include "fat.h"
 
@@ -39,19 +40,30 @@ static int fat_default_codepage = CONFIG_FAT_DEFAULT_CODEPAGE;
 static char fat_default_iocharset[] = CONFIG_FAT_DEFAULT_IOCHARSET;
 
 
-static int fat_add_cluster(struct inode *inode)
+/*
+ * Append @nr_cluster clusters to the chain of @inode.  They are allocated
+ * in runs, so the FAT is updated a block at a time and the new clusters
+ * come out contiguous when the free space allows.
+ */
+int fat_add_clusters(struct inode *inode, int nr_cluster)
 {
-	int err, cluster;
+	int err, n, cluster[MAX_BUF_PER_PAGE / 2];
 
-	err = fat_alloc_clusters(inode, &cluster, 1);
-	if (err)
-		return err;
-	/* FIXME: this cluster should be added after data of this
-	 * cluster is writed */
-	err = fat_chain_add(inode, cluster, 1);
-	if (err)
-		fat_free_clusters(inode, cluster);
-	return err;
+	while (nr_cluster > 0) {
+		n = min_t(int, nr_cluster, ARRAY_SIZE(cluster));
+		err = fat_alloc_clusters(inode, cluster, n);
+		if (err)
+			return err;
+		/* FIXME: this cluster should be added after data of this
+		 * cluster is writed */
+		err = fat_chain_add(inode, cluster[0], n);
+		if (err) {
+			fat_free_clusters(inode, cluster[0]);
+			return err;
+		}
+		nr_cluster -= n;
+	}
+	return 0;
 }
 
 static inline int __fat_get_block(struct inode *inode, sector_t iblock,
@@ -61,7 +73,7 @@ static inline int __fat_get_block(struct inode *inode, sector_t iblock,
 	struct super_block *sb = inode->i_sb;
 	struct msdos_sb_info *sbi = MSDOS_SB(sb);
 	unsigned long mapped_blocks;
-	sector_t phys;
+	sector_t phys, last_block;
 	int err, offset;
 
 	err = fat_bmap(inode, iblock, &phys, &mapped_blocks, create);
@@ -81,10 +93,11 @@ static inline int __fat_get_block(struct inode *inode, sector_t iblock,
 		return -EIO;
 	}
 
+	/* clusters past mmu_private may already be preallocated */
+	last_block = inode->i_blocks >> (sb->s_blocksize_bits - 9);
 	offset = (unsigned long)iblock & (sbi->sec_per_clus - 1);
-	if (!offset) {
-		/* TODO: multiple cluster allocation would be desirable. */
-		err = fat_add_cluster(inode);
+	if (!offset && iblock >= last_block) {
+		err = fat_add_clusters(inode, 1);
 		if (err)
 			return err;
 	}
@@ -488,13 +501,39 @@ out:
 
 EXPORT_SYMBOL_GPL(fat_build_inode);
 
+static int __fat_write_inode(struct inode *inode, int wait);
+
+/*
+ * Release clusters that were preallocated past the end of the data, by
+ * fallocate(FALLOC_FL_KEEP_SIZE) or a batched write, but never written.
+ */
+static void fat_free_eofblocks(struct inode *inode)
+{
+	struct msdos_sb_info *sbi = MSDOS_SB(inode->i_sb);
+
+	if ((inode->i_blocks << 9) >
+	    round_up(MSDOS_I(inode)->mmu_private, sbi->cluster_size)) {
+		fat_truncate_blocks(inode, MSDOS_I(inode)->mmu_private);
+		/*
+		 * Preallocating into an empty file set i_start, so write
+		 * the inode back now or the dirent points at freed
+		 * clusters.
+		 */
+		if (__fat_write_inode(inode, inode_needs_sync(inode)))
+			fat_msg(inode->i_sb, KERN_WARNING,
+				"failed to release preallocated clusters, "
+				"please run fsck");
+	}
+}
+
 static void fat_evict_inode(struct inode *inode)
 {
 	truncate_inode_pages(&inode->i_data, 0);
 	if (!inode->i_nlink) {
 		inode->i_size = 0;
 		fat_truncate_blocks(inode, 0);
-	}
+	} else
+		fat_free_eofblocks(inode);
 	invalidate_inode_buffers(inode);
 	clear_inode(inode);
 	fat_cache_inval_inode(inode);
@@ -564,6 +603,9 @@ static void fat_put_super(struct super_block *sb)
 
 	fat_set_state(sb, 0, 0);
 
+	cancel_work_sync(&sbi->free_map_work);
+	vfree(sbi->free_map);
+
 	iput(sbi->fsinfo_inode);
 	iput(sbi->fat_inode);
 
@@ -1279,6 +1321,7 @@ int fat_fill_super(struct super_block *sb, void *data, int silent, int isvfat,
 	sb->s_op = &fat_sops;
 	sb->s_export_op = &fat_export_ops;
 	mutex_init(&sbi->nfs_build_inode_lock);
+	INIT_WORK(&sbi->free_map_work, fat_free_map_workfn);
 	ratelimit_state_init(&sbi->ratelimit, DEFAULT_RATELIMIT_INTERVAL,
 			     DEFAULT_RATELIMIT_BURST);
 
@@ -1556,6 +1599,8 @@ int fat_fill_super(struct super_block *sb, void *data, int silent, int isvfat,
 	}
 
 	fat_set_state(sb, 1, 0);
+	if (!(sb->s_flags & MS_RDONLY))
+		queue_work(system_long_wq, &sbi->free_map_work);
 	return 0;
 
 out_invalid:
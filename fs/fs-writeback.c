@@ -576,11 +576,14 @@ static long writeback_chunk_size(struct backing_dev_info *bdi,
 	if (work->sync_mode == WB_SYNC_ALL || work->tagged_writepages)
 		pages = LONG_MAX;
 	else {
+		/* Smaller chunks while reads on this bdi are too slow */
+		unsigned int shift = bdi_wb_depth_shift(bdi);
+		long min_pages = MIN_WRITEBACK_PAGES >> shift;
+
 		pages = min(bdi->avg_write_bandwidth / 2,
 			    global_dirty_limit / DIRTY_SCOPE);
-		pages = min(pages, work->nr_pages);
-		pages = round_down(pages + MIN_WRITEBACK_PAGES,
-				   MIN_WRITEBACK_PAGES);
+		pages = min(pages >> shift, work->nr_pages);
+		pages = round_down(pages + min_pages, min_pages);
 	}
 
 	return pages;
@@ -863,6 +866,18 @@ static long wb_writeback(struct bdi_writeback *wb,
 
 		wb_update_bandwidth(wb, wb_start);
 
+		/*
+		 * Give queued reads a chance to get through before the
+		 * next chunk if they are already over their latency target.
+		 */
+		if (progress && work->sync_mode == WB_SYNC_NONE &&
+		    bdi_read_latency_exceeded(wb->bdi)) {
+			spin_unlock(&wb->list_lock);
+			schedule_timeout_interruptible(
+				msecs_to_jiffies(wb->bdi->read_lat_target));
+			spin_lock(&wb->list_lock);
+		}
+
 		/*
 		 * Did we write something? Try for more
 		 *
@@ -556,6 +556,8 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 		jbd2_journal_abort(journal, err);
 
 	blk_start_plug(&plug);
+	jbd2_journal_align_log(journal, commit_transaction, &log_bufs,
+			       WRITE_SYNC);
 	jbd2_journal_write_revoke_records(journal, commit_transaction,
 					  &log_bufs, WRITE_SYNC);
 	blk_finish_plug(&plug);
@@ -87,6 +87,7 @@ EXPORT_SYMBOL(jbd2_journal_ack_err);
 EXPORT_SYMBOL(jbd2_journal_clear_err);
 EXPORT_SYMBOL(jbd2_log_wait_commit);
 EXPORT_SYMBOL(jbd2_log_start_commit);
+EXPORT_SYMBOL(jbd2_journal_commit_due);
 EXPORT_SYMBOL(jbd2_journal_start_commit);
 EXPORT_SYMBOL(jbd2_journal_force_commit_nested);
 EXPORT_SYMBOL(jbd2_journal_wipe);
@@ -547,6 +548,31 @@ int jbd2_log_start_commit(journal_t *journal, tid_t tid)
 	return ret;
 }
 
+/*
+ * Start a commit of the running transaction if it is within j_commit_slack
+ * of its expiry anyway.  This lets the client line commits up with its own
+ * writeback rather than waking the device again from the commit timer.
+ * Returns 1 if a commit was started.
+ */
+int jbd2_journal_commit_due(journal_t *journal)
+{
+	transaction_t *transaction;
+	tid_t tid = 0;
+	int due = 0;
+
+	read_lock(&journal->j_state_lock);
+	transaction = journal->j_running_transaction;
+	if (transaction && journal->j_commit_slack &&
+	    time_after_eq(jiffies + journal->j_commit_slack,
+			  transaction->t_expires)) {
+		tid = transaction->t_tid;
+		due = 1;
+	}
+	read_unlock(&journal->j_state_lock);
+
+	return due ? jbd2_log_start_commit(journal, tid) : 0;
+}
+
 /*
  * Force and wait any uncommitted transactions.  We can only force the running
  * transaction if we don't have an active handle, otherwise, we will deadlock.
@@ -681,6 +681,64 @@ static void flush_descriptor(journal_t *journal,
 	set_buffer_dirty(descriptor);
 	write_dirty_buffer(descriptor, write_op);
 }
+
+/*
+ * Pad the log with empty revoke blocks up to the next j_align boundary
+ * when that keeps the committing transaction from straddling it.  A
+ * revoke block without records is a no-op for recovery, so the journal
+ * stays replayable by any jbd2.  Padding is only done when it is short
+ * and the log has plenty of room left.
+ */
+void jbd2_journal_align_log(journal_t *journal, transaction_t *transaction,
+			    struct list_head *log_bufs, int write_op)
+{
+	struct buffer_head *descriptor;
+	journal_header_t *header;
+	unsigned long long blocknr;
+	unsigned long head;
+	int nblocks, pad;
+
+	if (!journal->j_align || is_journal_aborted(journal))
+		return;
+
+	/* Only the commit thread advances j_head */
+	read_lock(&journal->j_state_lock);
+	head = journal->j_head;
+	read_unlock(&journal->j_state_lock);
+	if (jbd2_journal_bmap(journal, head, &blocknr))
+		return;
+	pad = journal->j_align - do_div(blocknr, journal->j_align);
+
+	/* Metadata blocks, their descriptors and the commit block */
+	nblocks = transaction->t_nr_buffers +
+		(transaction->t_nr_buffers >> JBD2_CONTROL_BLOCKS_SHIFT) + 2;
+	if (pad == journal->j_align || nblocks <= pad ||
+	    nblocks > journal->j_align || pad > journal->j_align / 4 ||
+	    head + pad > journal->j_last)
+		return;
+
+	read_lock(&journal->j_state_lock);
+	if (jbd2_log_space_left(journal) <
+	    pad + journal->j_max_transaction_buffers)
+		pad = 0;
+	read_unlock(&journal->j_state_lock);
+
+	jbd_debug(3, "JBD2: padding log with %d blocks\n", pad);
+	while (pad--) {
+		descriptor = jbd2_journal_get_descriptor_buffer(journal);
+		if (!descriptor)
+			return;
+		header = (journal_header_t *)descriptor->b_data;
+		header->h_magic     = cpu_to_be32(JBD2_MAGIC_NUMBER);
+		header->h_blocktype = cpu_to_be32(JBD2_REVOKE_BLOCK);
+		header->h_sequence  = cpu_to_be32(transaction->t_tid);
+
+		BUFFER_TRACE(descriptor, "file in log_bufs");
+		jbd2_file_log_bh(log_bufs, descriptor);
+		flush_descriptor(journal, descriptor,
+				 sizeof(jbd2_journal_revoke_header_t), write_op);
+	}
+}
 #endif
 
 /*
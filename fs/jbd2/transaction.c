@@ -96,7 +96,8 @@ jbd2_get_transaction(journal_t *journal, transaction_t *transaction)
 	INIT_LIST_HEAD(&transaction->t_private_list);
 
 	/* Set up the commit timer for the new transaction. */
-	journal->j_commit_timer.expires = round_jiffies_up(transaction->t_expires);
+	journal->j_commit_timer.expires =
+		round_jiffies_up(transaction->t_expires + journal->j_commit_slack);
 	add_timer(&journal->j_commit_timer);
 
 	J_ASSERT(journal->j_running_transaction == NULL);
@@ -0,0 +1,117 @@
+/*
+ * JFFS2 -- Journalling Flash File System, Version 2.
+ *
+ * LZ4 compressor, derived from compr_lzo.c:
+ *
+ * Copyright © 2007 Nokia Corporation. All rights reserved.
+ * Copyright © 2004-2010 David Woodhouse <dwmw2@infradead.org>
+ *
+ * Created by Richard Purdie <rpurdie@openedhand.com>
+ *
+ * For licensing information, see the file 'LICENCE' in this directory.
+ *
+ */
+
+#include <linux/kernel.h>
+#include <linux/sched.h>
+#include <linux/vmalloc.h>
+#include <linux/init.h>
+#include <linux/lz4.h>
+#include "compr.h"
+
+static void *lz4_mem;
+static void *lz4_compress_buf;
+static DEFINE_MUTEX(lz4_mutex);	/* for lz4_mem and lz4_compress_buf */
+
+static void free_workspace(void)
+{
+	vfree(lz4_mem);
+	vfree(lz4_compress_buf);
+}
+
+static int __init alloc_workspace(void)
+{
+	lz4_mem = vmalloc(LZ4_MEM_COMPRESS);
+	lz4_compress_buf = vmalloc(lz4_compressbound(PAGE_SIZE));
+
+	if (!lz4_mem || !lz4_compress_buf) {
+		free_workspace();
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static int jffs2_lz4_compress(unsigned char *data_in, unsigned char *cpage_out,
+			      uint32_t *sourcelen, uint32_t *dstlen)
+{
+	size_t compress_size;
+	int ret;
+
+	/* JFFS2 never hands us more than a page, but be safe */
+	if (*sourcelen > PAGE_SIZE)
+		return -1;
+
+	mutex_lock(&lz4_mutex);
+	ret = lz4_compress(data_in, *sourcelen, lz4_compress_buf,
+			   &compress_size, lz4_mem);
+	if (ret)
+		goto fail;
+
+	if (compress_size > *dstlen)
+		goto fail;
+
+	memcpy(cpage_out, lz4_compress_buf, compress_size);
+	mutex_unlock(&lz4_mutex);
+
+	*dstlen = compress_size;
+	return 0;
+
+ fail:
+	mutex_unlock(&lz4_mutex);
+	return -1;
+}
+
+static int jffs2_lz4_decompress(unsigned char *data_in, unsigned char *cpage_out,
+				uint32_t srclen, uint32_t destlen)
+{
+	size_t dl = destlen;
+	int ret;
+
+	ret = lz4_decompress_unknownoutputsize(data_in, srclen, cpage_out, &dl);
+
+	if (ret || dl != destlen)
+		return -1;
+
+	return 0;
+}
+
+static struct jffs2_compressor jffs2_lz4_comp = {
+	.priority = JFFS2_LZ4_PRIORITY,
+	.name = "lz4",
+	.compr = JFFS2_COMPR_LZ4,
+	.compress = &jffs2_lz4_compress,
+	.decompress = &jffs2_lz4_decompress,
+	.disabled = 0,
+};
+
+int __init jffs2_lz4_init(void)
+{
+	int ret;
+
+	ret = alloc_workspace();
+	if (ret < 0)
+		return ret;
+
+	ret = jffs2_register_compressor(&jffs2_lz4_comp);
+	if (ret)
+		free_workspace();
+
+	return ret;
+}
+
+void jffs2_lz4_exit(void)
+{
+	jffs2_unregister_compressor(&jffs2_lz4_comp);
+	free_workspace();
+}
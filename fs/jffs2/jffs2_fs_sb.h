@@ -28,6 +28,7 @@
 #define JFFS2_SB_FLAG_BUILDING 4 /* File system building is in progress */
 
 struct jffs2_inodirty;
+struct jffs2_scan_ahead;
 
 struct jffs2_mount_opts {
 	bool override_compr;
@@ -39,6 +40,9 @@ struct jffs2_mount_opts {
 	 * latter users to write to the file system if the amount if the
 	 * available space is less then 'rp_size'. */
 	unsigned int rp_size;
+
+	/* Write summaries for blocks found without one while mounting */
+	bool sum_upgrade;
 };
 
 /* A struct for the overall file system control.  Pointers to
@@ -140,6 +144,7 @@ struct jffs2_sb_info {
 #endif
 
 	struct jffs2_summary *summary;		/* Summary information */
+	struct jffs2_scan_ahead *scan_ahead;	/* Read-ahead of the mount scan */
 	struct jffs2_mount_opts mount_opts;
 
 #ifdef CONFIG_JFFS2_FS_XATTR
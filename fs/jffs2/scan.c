@@ -18,6 +18,8 @@
 #include <linux/pagemap.h>
 #include <linux/crc32.h>
 #include <linux/compiler.h>
+#include <linux/workqueue.h>
+#include <linux/completion.h>
 #include "nodelist.h"
 #include "summary.h"
 #include "debug.h"
@@ -88,13 +90,193 @@ static int file_dirty(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb)
 	return 0;
 }
 
+/*
+ * Read-ahead for the mount scan: while one eraseblock is parsed, a worker
+ * reads the next one into a second buffer, so the flash stays busy during
+ * the CRC checks and space accounting. jffs2_fill_scan_buf() copies from
+ * there when it can. Only the summary of a summarized block is read, and
+ * only the start of a block which looks erased, as that's all the scan
+ * will look at.
+ */
+struct jffs2_scan_ahead {
+	struct jffs2_sb_info *c;
+	struct work_struct work;
+	struct completion done;
+	bool pending;
+
+	/* Buffer of the block being scanned; the other one is read ahead */
+	int cur;
+	unsigned char *buf[2];
+	uint32_t block[2];
+	/* Valid data is [0, head) and [tail, sector_size) of the block */
+	uint32_t head[2];
+	uint32_t tail[2];
+};
+
+static int jffs2_scan_ahead_read(struct jffs2_sb_info *c, unsigned char *buf,
+				 uint32_t ofs, uint32_t len)
+{
+	size_t retlen;
+	int ret;
+
+	ret = jffs2_flash_read(c, ofs, len, &retlen, buf);
+	if (ret || retlen < len)
+		return -EIO;
+	return 0;
+}
+
+/* Nothing but a cleanmarker and erased flash at the start of the block */
+static bool jffs2_scan_ahead_empty(struct jffs2_sb_info *c, unsigned char *buf,
+				   uint32_t len)
+{
+	uint32_t ofs;
+
+	for (ofs = PAD(c->cleanmarker_size); ofs < len; ofs += 4)
+		if (*(uint32_t *)(&buf[ofs]) != 0xFFFFFFFF)
+			return false;
+	return true;
+}
+
+static void jffs2_scan_ahead_work(struct work_struct *work)
+{
+	struct jffs2_scan_ahead *ra = container_of(work, struct jffs2_scan_ahead, work);
+	struct jffs2_sb_info *c = ra->c;
+	int next = !ra->cur;
+	unsigned char *buf = ra->buf[next];
+	uint32_t block = ra->block[next];
+	uint32_t head;
+
+	ra->head[next] = 0;
+	ra->tail[next] = c->sector_size;
+
+	if (jffs2_cleanmarker_oob(c) && mtd_block_isbad(c->mtd, block))
+		goto out;
+
+	if (jffs2_sum_active()) {
+		struct jffs2_sum_marker *sm;
+		uint32_t len, sum_ofs;
+
+		/* Same read as the summary lookup in jffs2_scan_eraseblock() */
+		len = c->wbuf_pagesize ? c->wbuf_pagesize : sizeof(*sm);
+		if (jffs2_scan_ahead_read(c, buf + c->sector_size - len,
+					  block + c->sector_size - len, len))
+			goto out;
+		ra->tail[next] = c->sector_size - len;
+
+		sm = (void *)buf + c->sector_size - sizeof(*sm);
+		sum_ofs = je32_to_cpu(sm->offset);
+		if (je32_to_cpu(sm->magic) == JFFS2_SUM_MAGIC &&
+		    sum_ofs < c->sector_size - sizeof(*sm)) {
+			if (sum_ofs < ra->tail[next]) {
+				if (jffs2_scan_ahead_read(c, buf + sum_ofs, block + sum_ofs,
+							  ra->tail[next] - sum_ofs))
+					goto out;
+				ra->tail[next] = sum_ofs;
+			}
+			goto out;
+		}
+	}
+
+	head = EMPTY_SCAN_SIZE(c->sector_size);
+	if (jffs2_scan_ahead_read(c, buf, block, head))
+		goto out;
+	ra->head[next] = head;
+
+	if (jffs2_scan_ahead_empty(c, buf, head))
+		goto out;
+
+	if (ra->tail[next] > head &&
+	    jffs2_scan_ahead_read(c, buf + head, block + head, ra->tail[next] - head))
+		goto out;
+	ra->head[next] = c->sector_size;
+ out:
+	complete(&ra->done);
+}
+
+static struct jffs2_scan_ahead *jffs2_scan_ahead_alloc(struct jffs2_sb_info *c)
+{
+	struct jffs2_scan_ahead *ra;
+
+	ra = kzalloc(sizeof(*ra), GFP_KERNEL);
+	if (!ra)
+		return NULL;
+
+	/* Not worth pushing the system for, the scan works without */
+	ra->buf[0] = kmalloc(c->sector_size, GFP_KERNEL | __GFP_NORETRY | __GFP_NOWARN);
+	ra->buf[1] = kmalloc(c->sector_size, GFP_KERNEL | __GFP_NORETRY | __GFP_NOWARN);
+	if (!ra->buf[0] || !ra->buf[1]) {
+		kfree(ra->buf[0]);
+		kfree(ra->buf[1]);
+		kfree(ra);
+		return NULL;
+	}
+
+	ra->c = c;
+	INIT_WORK(&ra->work, jffs2_scan_ahead_work);
+	init_completion(&ra->done);
+	ra->tail[0] = ra->tail[1] = c->sector_size;
+
+	return ra;
+}
+
+static void jffs2_scan_ahead_free(struct jffs2_scan_ahead *ra)
+{
+	if (ra->pending)
+		wait_for_completion(&ra->done);
+
+	kfree(ra->buf[0]);
+	kfree(ra->buf[1]);
+	kfree(ra);
+}
+
+/* Pick up the read-ahead of block @i, and start reading the one after it */
+static void jffs2_scan_ahead_next(struct jffs2_scan_ahead *ra, int i)
+{
+	struct jffs2_sb_info *c = ra->c;
+	int next;
+
+	if (ra->pending) {
+		wait_for_completion(&ra->done);
+		ra->pending = false;
+		ra->cur = !ra->cur;
+	}
+
+	if (i + 1 >= c->nr_blocks)
+		return;
+
+	next = !ra->cur;
+	ra->block[next] = c->blocks[i + 1].offset;
+	reinit_completion(&ra->done);
+	ra->pending = true;
+	queue_work(system_unbound_wq, &ra->work);
+}
+
+static bool jffs2_scan_ahead_copy(struct jffs2_scan_ahead *ra, void *buf,
+				  uint32_t ofs, uint32_t len)
+{
+	int i = ra->cur;
+	uint32_t rel;
+
+	if (ofs < ra->block[i] || ofs + len > ra->block[i] + ra->c->sector_size)
+		return false;
+
+	rel = ofs - ra->block[i];
+	if (rel + len > ra->head[i] && rel < ra->tail[i])
+		return false;
+
+	memcpy(buf, ra->buf[i] + rel, len);
+	return true;
+}
+
 int jffs2_scan_medium(struct jffs2_sb_info *c)
 {
 	int i, ret;
-	uint32_t empty_blocks = 0, bad_blocks = 0;
+	uint32_t empty_blocks = 0, bad_blocks = 0, upgraded_blocks = 0;
 	unsigned char *flashbuf = NULL;
 	uint32_t buf_size = 0;
 	struct jffs2_summary *s = NULL; /* summary info collected by the scan process */
+	struct jffs2_scan_ahead *ra = NULL;
+	bool sum_upgrade;
 #ifndef __ECOS
 	size_t pointlen, try_size;
 
@@ -140,11 +322,22 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 		}
 	}
 
+	sum_upgrade = s && c->mount_opts.sum_upgrade && !jffs2_is_readonly(c);
+
+	/* Nothing to read ahead if the flash is mapped */
+	if (buf_size) {
+		ra = jffs2_scan_ahead_alloc(c);
+		c->scan_ahead = ra;
+	}
+
 	for (i=0; i<c->nr_blocks; i++) {
 		struct jffs2_eraseblock *jeb = &c->blocks[i];
 
 		cond_resched();
 
+		if (ra)
+			jffs2_scan_ahead_next(ra, i);
+
 		/* reset summary info for next eraseblock scan */
 		jffs2_sum_reset_collected(s);
 
@@ -154,6 +347,21 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 		if (ret < 0)
 			goto out;
 
+		/* Give blocks scanned node by node a summary for next time */
+		if (sum_upgrade &&
+		    (ret == BLK_STATE_CLEAN || ret == BLK_STATE_PARTDIRTY)) {
+			int err = jffs2_sum_write_upgrade(c, jeb, s);
+
+			if (err < 0) {
+				ret = err;
+				goto out;
+			}
+			if (err) {
+				upgraded_blocks++;
+				ret = jffs2_scan_classify_jeb(c, jeb);
+			}
+		}
+
 		jffs2_dbg_acct_paranoia_check_nolock(c, jeb);
 
 		/* Now decide which list to put it on */
@@ -272,8 +480,14 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 		jffs2_garbage_collect_trigger(c);
 		spin_unlock(&c->erase_completion_lock);
 	}
+	if (upgraded_blocks)
+		pr_info("Wrote summaries for %u eraseblocks\n", upgraded_blocks);
 	ret = 0;
  out:
+	if (ra) {
+		c->scan_ahead = NULL;
+		jffs2_scan_ahead_free(ra);
+	}
 	if (buf_size)
 		kfree(flashbuf);
 #ifndef __ECOS
@@ -290,6 +504,9 @@ static int jffs2_fill_scan_buf(struct jffs2_sb_info *c, void *buf,
 	int ret;
 	size_t retlen;
 
+	if (c->scan_ahead && jffs2_scan_ahead_copy(c->scan_ahead, buf, ofs, len))
+		return 0;
+
 	ret = jffs2_flash_read(c, ofs, len, &retlen, buf);
 	if (ret) {
 		jffs2_dbg(1, "mtd->read(0x%x bytes from 0x%x) returned %d\n",
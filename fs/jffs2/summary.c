@@ -669,54 +669,14 @@ crc_err:
 	return 0;
 }
 
-/* Write summary data to flash - helper function for jffs2_sum_write_sumnode() */
+/* Serialize the collected summary entries of @s into @wpage, freeing them */
 
-static int jffs2_sum_write_data(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
-				uint32_t infosize, uint32_t datasize, int padsize)
+static void *jffs2_sum_dump_collected(struct jffs2_summary *s, void *wpage)
 {
-	struct jffs2_raw_summary isum;
 	union jffs2_sum_mem *temp;
-	struct jffs2_sum_marker *sm;
-	struct kvec vecs[2];
-	uint32_t sum_ofs;
-	void *wpage;
-	int ret;
-	size_t retlen;
-
-	if (padsize + datasize > MAX_SUMMARY_SIZE) {
-		/* It won't fit in the buffer. Abort summary for this jeb */
-		jffs2_sum_disable_collecting(c->summary);
-
-		JFFS2_WARNING("Summary too big (%d data, %d pad) in eraseblock at %08x\n",
-			      datasize, padsize, jeb->offset);
-		/* Non-fatal */
-		return 0;
-	}
-	/* Is there enough space for summary? */
-	if (padsize < 0) {
-		/* don't try to write out summary for this jeb */
-		jffs2_sum_disable_collecting(c->summary);
-
-		JFFS2_WARNING("Not enough space for summary, padsize = %d\n",
-			      padsize);
-		/* Non-fatal */
-		return 0;
-	}
 
-	memset(c->summary->sum_buf, 0xff, datasize);
-	memset(&isum, 0, sizeof(isum));
-
-	isum.magic = cpu_to_je16(JFFS2_MAGIC_BITMASK);
-	isum.nodetype = cpu_to_je16(JFFS2_NODETYPE_SUMMARY);
-	isum.totlen = cpu_to_je32(infosize);
-	isum.hdr_crc = cpu_to_je32(crc32(0, &isum, sizeof(struct jffs2_unknown_node) - 4));
-	isum.padded = cpu_to_je32(c->summary->sum_padded);
-	isum.cln_mkr = cpu_to_je32(c->cleanmarker_size);
-	isum.sum_num = cpu_to_je32(c->summary->sum_num);
-	wpage = c->summary->sum_buf;
-
-	while (c->summary->sum_num) {
-		temp = c->summary->sum_list_head;
+	while (s->sum_num) {
+		temp = s->sum_list_head;
 
 		switch (je16_to_cpu(temp->u.nodetype)) {
 			case JFFS2_NODETYPE_INODE: {
@@ -756,7 +716,7 @@ static int jffs2_sum_write_data(struct jffs2_sb_info *c, struct jffs2_eraseblock
 			case JFFS2_NODETYPE_XATTR: {
 				struct jffs2_sum_xattr_flash *sxattr_ptr = wpage;
 
-				temp = c->summary->sum_list_head;
+				temp = s->sum_list_head;
 				sxattr_ptr->nodetype = temp->x.nodetype;
 				sxattr_ptr->xid = temp->x.xid;
 				sxattr_ptr->version = temp->x.version;
@@ -769,7 +729,7 @@ static int jffs2_sum_write_data(struct jffs2_sb_info *c, struct jffs2_eraseblock
 			case JFFS2_NODETYPE_XREF: {
 				struct jffs2_sum_xref_flash *sxref_ptr = wpage;
 
-				temp = c->summary->sum_list_head;
+				temp = s->sum_list_head;
 				sxref_ptr->nodetype = temp->r.nodetype;
 				sxref_ptr->offset = temp->r.offset;
 
@@ -782,19 +742,67 @@ static int jffs2_sum_write_data(struct jffs2_sb_info *c, struct jffs2_eraseblock
 				    == JFFS2_FEATURE_RWCOMPAT_COPY) {
 					dbg_summary("Writing unknown RWCOMPAT_COPY node type %x\n",
 						    je16_to_cpu(temp->u.nodetype));
-					jffs2_sum_disable_collecting(c->summary);
+					jffs2_sum_disable_collecting(s);
 				} else {
 					BUG();	/* unknown node in summary information */
 				}
 			}
 		}
 
-		c->summary->sum_list_head = temp->u.next;
+		s->sum_list_head = temp->u.next;
 		kfree(temp);
 
-		c->summary->sum_num--;
+		s->sum_num--;
+	}
+
+	return wpage;
+}
+
+/* Write summary data to flash - helper function for jffs2_sum_write_sumnode() */
+
+static int jffs2_sum_write_data(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+				uint32_t infosize, uint32_t datasize, int padsize)
+{
+	struct jffs2_raw_summary isum;
+	struct jffs2_sum_marker *sm;
+	struct kvec vecs[2];
+	uint32_t sum_ofs;
+	void *wpage;
+	int ret;
+	size_t retlen;
+
+	if (padsize + datasize > MAX_SUMMARY_SIZE) {
+		/* It won't fit in the buffer. Abort summary for this jeb */
+		jffs2_sum_disable_collecting(c->summary);
+
+		JFFS2_WARNING("Summary too big (%d data, %d pad) in eraseblock at %08x\n",
+			      datasize, padsize, jeb->offset);
+		/* Non-fatal */
+		return 0;
+	}
+	/* Is there enough space for summary? */
+	if (padsize < 0) {
+		/* don't try to write out summary for this jeb */
+		jffs2_sum_disable_collecting(c->summary);
+
+		JFFS2_WARNING("Not enough space for summary, padsize = %d\n",
+			      padsize);
+		/* Non-fatal */
+		return 0;
 	}
 
+	memset(c->summary->sum_buf, 0xff, datasize);
+	memset(&isum, 0, sizeof(isum));
+
+	isum.magic = cpu_to_je16(JFFS2_MAGIC_BITMASK);
+	isum.nodetype = cpu_to_je16(JFFS2_NODETYPE_SUMMARY);
+	isum.totlen = cpu_to_je32(infosize);
+	isum.hdr_crc = cpu_to_je32(crc32(0, &isum, sizeof(struct jffs2_unknown_node) - 4));
+	isum.padded = cpu_to_je32(c->summary->sum_padded);
+	isum.cln_mkr = cpu_to_je32(c->cleanmarker_size);
+	isum.sum_num = cpu_to_je32(c->summary->sum_num);
+	wpage = jffs2_sum_dump_collected(c->summary, c->summary->sum_buf);
+
 	jffs2_sum_reset_collected(c->summary);
 
 	wpage += padsize;
@@ -871,3 +879,103 @@ int jffs2_sum_write_sumnode(struct jffs2_sb_info *c)
 	spin_lock(&c->erase_completion_lock);
 	return ret;
 }
+
+/*
+ * Write out the summary collected by the scan for a block which was written
+ * without one - called from jffs2_scan_medium() in sum_upgrade mode.
+ *
+ * The summary has to go at the very end of the block, so this only works
+ * when the erased space left there can hold it. Blocks with a lot of free
+ * space are left alone rather than closed, as would the summary padding eat
+ * that space. Returns 1 if the block got a summary, 0 if it was skipped.
+ */
+
+int jffs2_sum_write_upgrade(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+			    struct jffs2_summary *s)
+{
+	struct jffs2_raw_summary *isum;
+	struct jffs2_sum_marker *sm;
+	uint32_t infosize, datasize, sum_ofs;
+	int padsize, ret;
+	size_t retlen;
+	void *buf;
+
+	if (!s->sum_num || jffs2_sum_is_disabled(s))
+		return 0;
+
+	datasize = s->sum_size + sizeof(struct jffs2_sum_marker);
+	infosize = sizeof(struct jffs2_raw_summary) + datasize;
+	padsize = jeb->free_size - infosize;
+	sum_ofs = jeb->offset + c->sector_size - jeb->free_size;
+
+	if (padsize < 0 || padsize > JFFS2_SUM_UPGRADE_MAX_PAD(c) ||
+	    padsize + datasize > MAX_SUMMARY_SIZE)
+		return 0;
+
+	/* Partially programmed pages can't be written again */
+	if (c->wbuf_pagesize && (sum_ofs % c->wbuf_pagesize))
+		return 0;
+
+	ret = jffs2_prealloc_raw_node_refs(c, jeb, 1);
+	if (ret)
+		return ret;
+
+	infosize += padsize;
+	datasize += padsize;
+
+	buf = kmalloc(infosize, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+	memset(buf, 0xff, infosize);
+
+	isum = buf;
+	memset(isum, 0, sizeof(*isum));
+	isum->magic = cpu_to_je16(JFFS2_MAGIC_BITMASK);
+	isum->nodetype = cpu_to_je16(JFFS2_NODETYPE_SUMMARY);
+	isum->totlen = cpu_to_je32(infosize);
+	isum->hdr_crc = cpu_to_je32(crc32(0, isum, sizeof(struct jffs2_unknown_node) - 4));
+	isum->padded = cpu_to_je32(s->sum_padded);
+	isum->cln_mkr = cpu_to_je32(c->cleanmarker_size);
+	isum->sum_num = cpu_to_je32(s->sum_num);
+
+	jffs2_sum_dump_collected(s, isum + 1);
+	if (jffs2_sum_is_disabled(s)) {
+		/* Found a node the summary can't describe */
+		kfree(buf);
+		return 0;
+	}
+	jffs2_sum_reset_collected(s);
+
+	sm = buf + infosize - sizeof(*sm);
+	sm->offset = cpu_to_je32(c->sector_size - jeb->free_size);
+	sm->magic = cpu_to_je32(JFFS2_SUM_MAGIC);
+
+	isum->sum_crc = cpu_to_je32(crc32(0, isum + 1, datasize));
+	isum->node_crc = cpu_to_je32(crc32(0, isum, sizeof(*isum) - 8));
+
+	dbg_summary("writing out upgrade summary to flash to pos : 0x%08x\n", sum_ofs);
+
+	/* The write buffer is not set up for this block, go to the MTD */
+	ret = mtd_write(c->mtd, sum_ofs, infosize, &retlen, buf);
+	kfree(buf);
+
+	if (ret || (retlen != infosize)) {
+		JFFS2_WARNING("Write of %u bytes at 0x%08x failed. returned %d, retlen %zd\n",
+			      infosize, sum_ofs, ret, retlen);
+
+		if (retlen) {
+			/* Waste remaining space */
+			spin_lock(&c->erase_completion_lock);
+			jffs2_link_node_ref(c, jeb, sum_ofs | REF_OBSOLETE, infosize, NULL);
+			spin_unlock(&c->erase_completion_lock);
+		}
+		/* Non-fatal */
+		return 0;
+	}
+
+	spin_lock(&c->erase_completion_lock);
+	jffs2_link_node_ref(c, jeb, sum_ofs | REF_NORMAL, infosize, NULL);
+	spin_unlock(&c->erase_completion_lock);
+
+	return 1;
+}
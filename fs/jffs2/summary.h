@@ -169,6 +169,9 @@ struct jffs2_sum_marker
 
 #define JFFS2_SUMMARY_FRAME_SIZE (sizeof(struct jffs2_raw_summary) + sizeof(struct jffs2_sum_marker))
 
+/* Most free space a block may lose to padding when upgraded at mount */
+#define JFFS2_SUM_UPGRADE_MAX_PAD(c) ((c)->sector_size / 16)
+
 #ifdef CONFIG_JFFS2_SUMMARY	/* SUMMARY SUPPORT ENABLED */
 
 #define jffs2_sum_active() (1)
@@ -181,6 +184,8 @@ void jffs2_sum_move_collected(struct jffs2_sb_info *c, struct jffs2_summary *s);
 int jffs2_sum_add_kvec(struct jffs2_sb_info *c, const struct kvec *invecs,
 			unsigned long count,  uint32_t to);
 int jffs2_sum_write_sumnode(struct jffs2_sb_info *c);
+int jffs2_sum_write_upgrade(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+			    struct jffs2_summary *s);
 int jffs2_sum_add_padding_mem(struct jffs2_summary *s, uint32_t size);
 int jffs2_sum_add_inode_mem(struct jffs2_summary *s, struct jffs2_raw_inode *ri, uint32_t ofs);
 int jffs2_sum_add_dirent_mem(struct jffs2_summary *s, struct jffs2_raw_dirent *rd, uint32_t ofs);
@@ -201,6 +206,7 @@ int jffs2_sum_scan_sumnode(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb
 #define jffs2_sum_add_kvec(a,b,c,d) (0)
 #define jffs2_sum_move_collected(a,b)
 #define jffs2_sum_write_sumnode(a) (0)
+#define jffs2_sum_write_upgrade(a,b,c) (0)
 #define jffs2_sum_add_padding_mem(a,b)
 #define jffs2_sum_add_inode_mem(a,b,c)
 #define jffs2_sum_add_dirent_mem(a,b,c)
@@ -72,6 +72,10 @@ static const char *jffs2_compr_name(unsigned int compr)
 	case JFFS2_COMPR_MODE_FORCELZO:
 		return "lzo";
 #endif
+#ifdef CONFIG_JFFS2_LZ4
+	case JFFS2_COMPR_MODE_FORCELZ4:
+		return "lz4";
+#endif
 #ifdef CONFIG_JFFS2_ZLIB
 	case JFFS2_COMPR_MODE_FORCEZLIB:
 		return "zlib";
@@ -92,6 +96,8 @@ static int jffs2_show_options(struct seq_file *s, struct dentry *root)
 		seq_printf(s, ",compr=%s", jffs2_compr_name(opts->compr));
 	if (opts->rp_size)
 		seq_printf(s, ",rp_size=%u", opts->rp_size / 1024);
+	if (opts->sum_upgrade)
+		seq_puts(s, ",sum_upgrade");
 
 	return 0;
 }
@@ -161,17 +167,20 @@ static const struct export_operations jffs2_export_ops = {
  *
  * Opt_override_compr: override default compressor
  * Opt_rp_size: size of reserved pool in KiB
+ * Opt_sum_upgrade: write summaries for blocks scanned without one
  * Opt_err: just end of array marker
  */
 enum {
 	Opt_override_compr,
 	Opt_rp_size,
+	Opt_sum_upgrade,
 	Opt_err,
 };
 
 static const match_table_t tokens = {
 	{Opt_override_compr, "compr=%s"},
 	{Opt_rp_size, "rp_size=%u"},
+	{Opt_sum_upgrade, "sum_upgrade"},
 	{Opt_err, NULL},
 };
 
@@ -203,6 +212,10 @@ static int jffs2_parse_options(struct jffs2_sb_info *c, char *data)
 			else if (!strcmp(name, "lzo"))
 				c->mount_opts.compr = JFFS2_COMPR_MODE_FORCELZO;
 #endif
+#ifdef CONFIG_JFFS2_LZ4
+			else if (!strcmp(name, "lz4"))
+				c->mount_opts.compr = JFFS2_COMPR_MODE_FORCELZ4;
+#endif
 #ifdef CONFIG_JFFS2_ZLIB
 			else if (!strcmp(name, "zlib"))
 				c->mount_opts.compr =
@@ -228,6 +241,13 @@ static int jffs2_parse_options(struct jffs2_sb_info *c, char *data)
 			}
 			c->mount_opts.rp_size = opt;
 			break;
+		case Opt_sum_upgrade:
+			if (!jffs2_sum_active()) {
+				pr_err("Error: sum_upgrade needs summary support\n");
+				return -EINVAL;
+			}
+			c->mount_opts.sum_upgrade = true;
+			break;
 		default:
 			pr_err("Error: unrecognized mount option '%s' or missing value\n",
 			       p);
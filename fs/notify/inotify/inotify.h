@@ -13,6 +13,7 @@ struct inotify_event_info {
 struct inotify_inode_mark {
 	struct fsnotify_mark fsn_mark;
 	int wd;
+	bool coalesce;		/* IN_COALESCE */
 };
 
 static inline struct inotify_event_info *INOTIFY_E(struct fsnotify_event *fse)
@@ -20,6 +21,17 @@ static inline struct inotify_event_info *INOTIFY_E(struct fsnotify_event *fse)
 	return container_of(fse, struct inotify_event_info, fse);
 }
 
+/* what read() hands to userspace for this event */
+static inline unsigned int inotify_event_bytes(struct inotify_event_info *event)
+{
+	unsigned int size = sizeof(struct inotify_event);
+
+	if (event->name_len)
+		size += roundup(event->name_len + 1,
+				sizeof(struct inotify_event));
+	return size;
+}
+
 extern void inotify_ignored_and_remove_idr(struct fsnotify_mark *fsn_mark,
 					   struct fsnotify_group *group);
 extern int inotify_handle_event(struct fsnotify_group *group,
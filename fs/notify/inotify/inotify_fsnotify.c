@@ -33,24 +33,60 @@
 
 #include "inotify.h"
 
+/* events an IN_COALESCE watch folds into one pending event */
+#define INOTIFY_COALESCE_EVENTS	(FS_MODIFY | FS_ATTRIB)
+/* how far back in the queue to look for a pending event to fold into */
+#define INOTIFY_COALESCE_SCAN	64
+
+/*
+ * Check if 2 events are about the same object.
+ */
+static bool event_same_object(struct fsnotify_event *old_fsn,
+			      struct fsnotify_event *new_fsn)
+{
+	struct inotify_event_info *old, *new;
+
+	old = INOTIFY_E(old_fsn);
+	new = INOTIFY_E(new_fsn);
+	return (old_fsn->inode == new_fsn->inode) &&
+	       (old->wd == new->wd) &&
+	       (old->name_len == new->name_len) &&
+	       (!old->name_len || !strcmp(old->name, new->name));
+}
+
 /*
  * Check if 2 events contain the same information.
  */
 static bool event_compare(struct fsnotify_event *old_fsn,
 			  struct fsnotify_event *new_fsn)
 {
-	struct inotify_event_info *old, *new;
-
 	if (old_fsn->mask & FS_IN_IGNORED)
 		return false;
-	old = INOTIFY_E(old_fsn);
-	new = INOTIFY_E(new_fsn);
-	if ((old_fsn->mask == new_fsn->mask) &&
-	    (old_fsn->inode == new_fsn->inode) &&
-	    (old->name_len == new->name_len) &&
-	    (!old->name_len || !strcmp(old->name, new->name)))
-		return true;
-	return false;
+	return (old_fsn->mask == new_fsn->mask) &&
+	       event_same_object(old_fsn, new_fsn);
+}
+
+/*
+ * Apply the group's byte limit to an event that is about to be queued.
+ * Returning 2 makes inotify_handle_event() report an overflow instead.
+ */
+static int inotify_queue_full(struct list_head *list,
+			      struct fsnotify_event *event)
+{
+	struct fsnotify_group *group;
+	unsigned int max_bytes;
+	int queued;
+
+	group = container_of(list, struct fsnotify_group, notification_list);
+	max_bytes = group->inotify_data.max_bytes;
+	if (!max_bytes)
+		return 0;
+
+	/* a reader may briefly take the count below zero */
+	queued = max(atomic_read(&group->inotify_data.q_bytes), 0);
+	if (queued + inotify_event_bytes(INOTIFY_E(event)) > max_bytes)
+		return 2;
+	return 0;
 }
 
 static int inotify_merge(struct list_head *list,
@@ -59,7 +95,36 @@ static int inotify_merge(struct list_head *list,
 	struct fsnotify_event *last_event;
 
 	last_event = list_entry(list->prev, struct fsnotify_event, list);
-	return event_compare(last_event, event);
+	if (event_compare(last_event, event))
+		return 1;
+	return inotify_queue_full(list, event);
+}
+
+/*
+ * Fold @event into the latest pending event for the same object if that
+ * one carries nothing but coalescible bits, so a file being written
+ * continuously costs the reader one event until it reads the queue.
+ */
+static int inotify_merge_coalesce(struct list_head *list,
+				  struct fsnotify_event *event)
+{
+	struct fsnotify_event *old;
+	int scan = INOTIFY_COALESCE_SCAN;
+
+	list_for_each_entry_reverse(old, list, list) {
+		if (!scan--)
+			break;
+		if (old->mask & (FS_Q_OVERFLOW | FS_IN_IGNORED))
+			continue;
+		if (!event_same_object(old, event))
+			continue;
+		if (old->mask & ~(INOTIFY_COALESCE_EVENTS | FS_ISDIR |
+				  FS_EVENT_ON_CHILD))
+			break;
+		old->mask |= event->mask;
+		return 1;
+	}
+	return inotify_queue_full(list, event);
 }
 
 int inotify_handle_event(struct fsnotify_group *group,
@@ -72,6 +137,8 @@ int inotify_handle_event(struct fsnotify_group *group,
 	struct inotify_inode_mark *i_mark;
 	struct inotify_event_info *event;
 	struct fsnotify_event *fsn_event;
+	int (*merge)(struct list_head *, struct fsnotify_event *);
+	unsigned int bytes;
 	int ret;
 	int len = 0;
 	int alloc_len = sizeof(struct inotify_event_info);
@@ -108,10 +175,24 @@ int inotify_handle_event(struct fsnotify_group *group,
 	if (len)
 		strcpy(event->name, file_name);
 
-	ret = fsnotify_add_notify_event(group, fsn_event, inotify_merge);
+	/* the event may be read and freed as soon as it is queued */
+	bytes = inotify_event_bytes(event);
+
+	merge = inotify_merge;
+	if (i_mark->coalesce &&
+	    !(mask & ~(INOTIFY_COALESCE_EVENTS | FS_ISDIR | FS_EVENT_ON_CHILD)))
+		merge = inotify_merge_coalesce;
+
+	ret = fsnotify_add_notify_event(group, fsn_event, merge);
 	if (ret) {
 		/* Our event wasn't used in the end. Free it. */
 		fsnotify_destroy_event(group, fsn_event);
+		/* over the byte limit, report it like a full queue */
+		if (ret == 2)
+			fsnotify_add_notify_event(group, group->overflow_event,
+						  NULL);
+	} else {
+		atomic_add(bytes, &group->inotify_data.q_bytes);
 	}
 
 	if (inode_mark->mask & IN_ONESHOT)
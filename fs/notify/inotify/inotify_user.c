@@ -47,6 +47,7 @@
 /* these are configurable via /proc/sys/fs/inotify/ */
 static int inotify_max_user_instances __read_mostly;
 static int inotify_max_queued_events __read_mostly;
+static int inotify_max_queued_bytes __read_mostly;
 static int inotify_max_user_watches __read_mostly;
 
 static struct kmem_cache *inotify_inode_mark_cachep __read_mostly;
@@ -82,6 +83,14 @@ ctl_table inotify_table[] = {
 		.proc_handler	= proc_dointvec_minmax,
 		.extra1		= &zero
 	},
+	{
+		.procname	= "max_queued_bytes",
+		.data		= &inotify_max_queued_bytes,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero
+	},
 	{ }
 };
 #endif /* CONFIG_SYSCTL */
@@ -160,6 +169,8 @@ static struct fsnotify_event *get_one_event(struct fsnotify_group *group,
 	/* held the notification_mutex the whole time, so this is the
 	 * same event we peeked above */
 	fsnotify_remove_notify_event(group);
+	if (event != group->overflow_event)
+		atomic_sub(event_size, &group->inotify_data.q_bytes);
 
 	return event;
 }
@@ -536,10 +547,13 @@ static int inotify_update_existing_watch(struct fsnotify_group *group,
 	spin_lock(&fsn_mark->lock);
 
 	old_mask = fsn_mark->mask;
-	if (add)
+	if (add) {
 		fsnotify_set_mark_mask_locked(fsn_mark, (fsn_mark->mask | mask));
-	else
+		i_mark->coalesce |= !!(arg & IN_COALESCE);
+	} else {
 		fsnotify_set_mark_mask_locked(fsn_mark, mask);
+		i_mark->coalesce = !!(arg & IN_COALESCE);
+	}
 	new_mask = fsn_mark->mask;
 
 	spin_unlock(&fsn_mark->lock);
@@ -584,6 +598,7 @@ static int inotify_new_watch(struct fsnotify_group *group,
 	fsnotify_init_mark(&tmp_i_mark->fsn_mark, inotify_free_mark);
 	tmp_i_mark->fsn_mark.mask = mask;
 	tmp_i_mark->wd = -1;
+	tmp_i_mark->coalesce = !!(arg & IN_COALESCE);
 
 	ret = -ENOSPC;
 	if (atomic_read(&group->inotify_data.user->inotify_watches) >= inotify_max_user_watches)
@@ -651,6 +666,7 @@ static struct fsnotify_group *inotify_new_group(unsigned int max_events)
 	oevent->name_len = 0;
 
 	group->max_events = max_events;
+	group->inotify_data.max_bytes = inotify_max_queued_bytes;
 
 	spin_lock_init(&group->inotify_data.idr_lock);
 	idr_init(&group->inotify_data.idr);
@@ -803,7 +819,7 @@ static int __init inotify_user_setup(void)
 	BUILD_BUG_ON(IN_ISDIR != FS_ISDIR);
 	BUILD_BUG_ON(IN_ONESHOT != FS_IN_ONESHOT);
 
-	BUG_ON(hweight32(ALL_INOTIFY_BITS) != 21);
+	BUG_ON(hweight32(ALL_INOTIFY_BITS) != 22);
 
 	inotify_inode_mark_cachep = KMEM_CACHE(inotify_inode_mark, SLAB_PANIC);
 
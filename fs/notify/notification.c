@@ -81,7 +81,9 @@ void fsnotify_destroy_event(struct fsnotify_group *group,
  * Add an event to the group notification queue.  The group can later pull this
  * event off the queue to deal with.  The function returns 0 if the event was
  * added to the queue, 1 if the event was merged with some other queued event,
- * 2 if the queue of events has overflown.
+ * 2 if the queue of events has overflown.  Passing group->overflow_event
+ * queues it unless it is already pending, for groups that apply limits of
+ * their own.
  */
 int fsnotify_add_notify_event(struct fsnotify_group *group,
 			      struct fsnotify_event *event,
@@ -95,7 +97,8 @@ int fsnotify_add_notify_event(struct fsnotify_group *group,
 
 	mutex_lock(&group->notification_mutex);
 
-	if (group->q_len >= group->max_events) {
+	if (group->q_len >= group->max_events ||
+	    event == group->overflow_event) {
 		ret = 2;
 		/* Queue overflow event only if it isn't already queued */
 		if (!list_empty(&group->overflow_event->list)) {
@@ -0,0 +1,360 @@
+/*
+ * Save and restore the set of cached file pages across a reboot.
+ *
+ * Reading /proc/pagecache_snapshot lists the page cache of every file
+ * visible to the reader, one "<first page> <nr pages> <path>" range per
+ * line.  Writing such lines back queues them for an asynchronous
+ * readahead, so a shutdown script can save the list and an early boot
+ * script can replay it while the rest of userspace comes up.
+ */
+
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/fs_struct.h>
+#include <linux/mount.h>
+#include <linux/dcache.h>
+#include <linux/mm.h>
+#include <linux/pagemap.h>
+#include <linux/pagevec.h>
+#include <linux/backing-dev.h>
+#include <linux/proc_fs.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+#include <linux/uaccess.h>
+#include <linux/init.h>
+#include "internal.h"
+
+/* Don't let a huge page cache turn into a huge snapshot */
+#define PCS_MAX_SIZE	(8 << 20)
+
+struct pcs_buf {
+	char *data;
+	size_t len;
+	size_t alloc;
+	int err;
+};
+
+struct pcs_walk {
+	struct pcs_buf *buf;
+	struct super_block **sbs;
+	unsigned int nr_sbs;
+	char *path;
+};
+
+static __printf(2, 3) void pcs_printf(struct pcs_buf *buf, const char *fmt, ...)
+{
+	va_list args;
+	size_t len;
+	char *p;
+
+	if (buf->err)
+		return;
+
+	va_start(args, fmt);
+	len = vsnprintf(NULL, 0, fmt, args);
+	va_end(args);
+
+	if (buf->len + len + 1 > buf->alloc) {
+		size_t alloc = max(buf->alloc * 2, buf->len + len + 1);
+
+		if (alloc > PCS_MAX_SIZE) {
+			buf->err = -EFBIG;
+			return;
+		}
+		p = vmalloc(alloc);
+		if (!p) {
+			buf->err = -ENOMEM;
+			return;
+		}
+		memcpy(p, buf->data, buf->len);
+		vfree(buf->data);
+		buf->data = p;
+		buf->alloc = alloc;
+	}
+
+	va_start(args, fmt);
+	buf->len += vsnprintf(buf->data + buf->len, len + 1, fmt, args);
+	va_end(args);
+}
+
+static void pcs_dump_mapping(struct pcs_buf *buf, struct address_space *mapping,
+			     const char *path)
+{
+	struct pagevec pvec;
+	pgoff_t index = 0, start = 0, next = 0;
+	bool in_range = false;
+	unsigned int i;
+
+	pagevec_init(&pvec, 0);
+	while (!buf->err && pagevec_lookup(&pvec, mapping, index,
+					   PAGEVEC_SIZE)) {
+		for (i = 0; i < pagevec_count(&pvec); i++) {
+			struct page *page = pvec.pages[i];
+
+			if (in_range && page->index != next) {
+				pcs_printf(buf, "%lu %lu %s\n", start,
+					   next - start, path);
+				in_range = false;
+			}
+			if (!in_range) {
+				start = page->index;
+				in_range = true;
+			}
+			next = page->index + 1;
+		}
+		index = next;
+		pagevec_release(&pvec);
+		cond_resched();
+	}
+	if (in_range)
+		pcs_printf(buf, "%lu %lu %s\n", start, next - start, path);
+}
+
+static void pcs_dump_inode(struct pcs_walk *walk, struct vfsmount *mnt,
+			   struct inode *inode)
+{
+	struct dentry *dentry;
+	struct path path;
+	char *p;
+
+	dentry = d_find_alias(inode);
+	if (!dentry)
+		return;
+
+	if (is_subdir(dentry, mnt->mnt_root)) {
+		path.mnt = mnt;
+		path.dentry = dentry;
+		p = d_path(&path, walk->path, PATH_MAX);
+		/* The format is line based */
+		if (!IS_ERR(p) && !strchr(p, '\n'))
+			pcs_dump_mapping(walk->buf, inode->i_mapping, p);
+	}
+	dput(dentry);
+}
+
+static int pcs_dump_mount(struct vfsmount *mnt, void *arg)
+{
+	struct pcs_walk *walk = arg;
+	struct super_block *sb = mnt->mnt_sb;
+	struct inode *inode, *toput_inode = NULL;
+	struct super_block **sbs;
+	unsigned int i;
+
+	/* Bind mounts would list the same pages again */
+	for (i = 0; i < walk->nr_sbs; i++)
+		if (walk->sbs[i] == sb)
+			return 0;
+	sbs = krealloc(walk->sbs, (walk->nr_sbs + 1) * sizeof(*sbs),
+		       GFP_KERNEL);
+	if (!sbs)
+		return -ENOMEM;
+	sbs[walk->nr_sbs++] = sb;
+	walk->sbs = sbs;
+
+	spin_lock(&inode_sb_list_lock);
+	list_for_each_entry(inode, &sb->s_inodes, i_sb_list) {
+		spin_lock(&inode->i_lock);
+		/* Pages that can't be read back in are not worth saving */
+		if ((inode->i_state & (I_FREEING|I_WILL_FREE|I_NEW)) ||
+		    !S_ISREG(inode->i_mode) ||
+		    inode->i_mapping->nrpages == 0 ||
+		    !mapping_cap_account_dirty(inode->i_mapping)) {
+			spin_unlock(&inode->i_lock);
+			continue;
+		}
+		__iget(inode);
+		spin_unlock(&inode->i_lock);
+		spin_unlock(&inode_sb_list_lock);
+
+		pcs_dump_inode(walk, mnt, inode);
+
+		iput(toput_inode);
+		toput_inode = inode;
+		spin_lock(&inode_sb_list_lock);
+		if (walk->buf->err)
+			break;
+	}
+	spin_unlock(&inode_sb_list_lock);
+	iput(toput_inode);
+
+	return walk->buf->err;
+}
+
+static int pcs_open(struct inode *inode, struct file *file)
+{
+	struct pcs_walk walk = { };
+	struct vfsmount *mnts;
+	struct pcs_buf *buf;
+	struct path root;
+	int err;
+
+	if (!(file->f_mode & FMODE_READ))
+		return 0;
+
+	buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+	walk.path = __getname();
+	if (!buf || !walk.path) {
+		err = -ENOMEM;
+		goto out;
+	}
+	walk.buf = buf;
+
+	get_fs_root(current->fs, &root);
+	mnts = collect_mounts(&root);
+	path_put(&root);
+	if (IS_ERR(mnts)) {
+		err = PTR_ERR(mnts);
+		goto out;
+	}
+	err = iterate_mounts(pcs_dump_mount, &walk, mnts);
+	drop_collected_mounts(mnts);
+
+out:
+	if (walk.path)
+		__putname(walk.path);
+	kfree(walk.sbs);
+	if (err && buf) {
+		vfree(buf->data);
+		kfree(buf);
+		return err;
+	}
+	file->private_data = buf;
+	return 0;
+}
+
+static ssize_t pcs_read(struct file *file, char __user *ubuf, size_t count,
+			loff_t *ppos)
+{
+	struct pcs_buf *buf = file->private_data;
+
+	return simple_read_from_buffer(ubuf, count, ppos, buf->data, buf->len);
+}
+
+static int pcs_release(struct inode *inode, struct file *file)
+{
+	struct pcs_buf *buf = file->private_data;
+
+	if (buf) {
+		vfree(buf->data);
+		kfree(buf);
+	}
+	return 0;
+}
+
+struct pcs_entry {
+	struct list_head list;
+	pgoff_t start;
+	unsigned long nr;
+	char path[];
+};
+
+static LIST_HEAD(pcs_queue);
+static DEFINE_SPINLOCK(pcs_queue_lock);
+
+static void pcs_replay(struct work_struct *work)
+{
+	struct pcs_entry *e;
+	struct file *file;
+
+	for (;;) {
+		spin_lock(&pcs_queue_lock);
+		e = list_first_entry_or_null(&pcs_queue, struct pcs_entry,
+					     list);
+		if (e)
+			list_del(&e->list);
+		spin_unlock(&pcs_queue_lock);
+		if (!e)
+			break;
+
+		file = filp_open(e->path, O_RDONLY | O_LARGEFILE, 0);
+		if (!IS_ERR(file)) {
+			force_page_cache_readahead(file->f_mapping, file,
+						   e->start, e->nr);
+			fput(file);
+		}
+		kfree(e);
+		cond_resched();
+	}
+}
+static DECLARE_WORK(pcs_replay_work, pcs_replay);
+
+static int pcs_queue_line(char *line)
+{
+	struct pcs_entry *e;
+	unsigned long start, nr;
+	int off = 0;
+
+	if (sscanf(line, "%lu %lu %n", &start, &nr, &off) != 2 || !off ||
+	    line[off] != '/')
+		return -EINVAL;
+
+	e = kmalloc(sizeof(*e) + strlen(line + off) + 1, GFP_KERNEL);
+	if (!e)
+		return -ENOMEM;
+	e->start = start;
+	e->nr = nr;
+	strcpy(e->path, line + off);
+
+	spin_lock(&pcs_queue_lock);
+	list_add_tail(&e->list, &pcs_queue);
+	spin_unlock(&pcs_queue_lock);
+	return 0;
+}
+
+/* Only whole lines are consumed, the caller writes the rest again */
+static ssize_t pcs_write(struct file *file, const char __user *ubuf,
+			 size_t count, loff_t *ppos)
+{
+	size_t len = min_t(size_t, count, PAGE_SIZE);
+	char *buf, *line, *end, *nl;
+	ssize_t ret;
+
+	buf = kmalloc(len + 1, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+	if (copy_from_user(buf, ubuf, len)) {
+		ret = -EFAULT;
+		goto out;
+	}
+	buf[len] = '\0';
+
+	end = strrchr(buf, '\n');
+	if (!end) {
+		ret = -EINVAL;
+		goto out;
+	}
+	*end = '\0';
+
+	for (line = buf; line; line = nl) {
+		nl = strchr(line, '\n');
+		if (nl)
+			*nl++ = '\0';
+		if (!*line)
+			continue;
+		ret = pcs_queue_line(line);
+		if (ret)
+			goto out;
+	}
+	ret = end - buf + 1;
+
+out:
+	queue_work(system_unbound_wq, &pcs_replay_work);
+	kfree(buf);
+	return ret;
+}
+
+static const struct file_operations pcs_fops = {
+	.open		= pcs_open,
+	.read		= pcs_read,
+	.write		= pcs_write,
+	.llseek		= default_llseek,
+	.release	= pcs_release,
+};
+
+static int __init pcs_init(void)
+{
+	proc_create("pagecache_snapshot", S_IRUSR | S_IWUSR, NULL, &pcs_fops);
+	return 0;
+}
+fs_initcall(pcs_init);
@@ -209,22 +209,85 @@ static void iov_fault_in_pages_read(struct iovec *iov, unsigned long len)
 	}
 }
 
-static void anon_pipe_buf_release(struct pipe_inode_info *pipe,
-				  struct pipe_buffer *buf)
+/*
+ * Large pipes are filled with multi-page buffers of this order at most,
+ * so a big write takes fewer slots and the reader fewer wakeups.
+ */
+#define PIPE_MAX_BUF_ORDER	2
+
+/*
+ * A writer only starts a new buffer while a full-sized one still fits in
+ * the pipe's capacity.
+ */
+static inline bool pipe_has_room(const struct pipe_inode_info *pipe,
+				 unsigned int nrbufs)
 {
-	struct page *page = buf->page;
+	return ((nrbufs + 1) << pipe->buf_order) <= pipe->buffers;
+}
 
-	/*
-	 * If nobody else uses this page, and we don't already have a
-	 * temporary page, let's keep track of it as a one-deep
-	 * allocation cache. (Otherwise just release our reference to it)
-	 */
-	if (page_count(page) == 1 && !pipe->tmp_page)
-		pipe->tmp_page = page;
-	else
+static inline unsigned int anon_pipe_buf_size(const struct pipe_buffer *buf)
+{
+	return PAGE_SIZE << compound_order(buf->page);
+}
+
+/*
+ * Get a page for pipe_write(), preferably one a reader released earlier.
+ * Multi-page buffers come from lowmem so that kmap() covers all of them;
+ * if they cannot be had cheaply we fall back to a single page.
+ */
+static struct page *pipe_get_tmp_page(struct pipe_inode_info *pipe)
+{
+	struct page *page;
+
+	if (pipe->nr_tmp_pages) {
+		page = list_first_entry(&pipe->tmp_pages, struct page, lru);
+		list_del(&page->lru);
+		pipe->nr_tmp_pages--;
+		return page;
+	}
+
+	if (pipe->buf_order) {
+		page = alloc_pages(GFP_USER | __GFP_COMP | __GFP_NOWARN |
+				   __GFP_NORETRY, pipe->buf_order);
+		if (page)
+			return page;
+	}
+
+	return alloc_page(GFP_HIGHUSER);
+}
+
+/*
+ * Keep an unshared page for the next write.  The pool together with the
+ * buffers still queued never holds more than the pipe's capacity.
+ */
+static void pipe_put_tmp_page(struct pipe_inode_info *pipe, struct page *page)
+{
+	if (page_count(page) == 1 &&
+	    compound_order(page) == pipe->buf_order &&
+	    pipe->nr_tmp_pages + pipe->nrbufs <=
+	    (pipe->buffers >> pipe->buf_order)) {
+		list_add(&page->lru, &pipe->tmp_pages);
+		pipe->nr_tmp_pages++;
+	} else
 		page_cache_release(page);
 }
 
+static void pipe_free_tmp_pages(struct pipe_inode_info *pipe)
+{
+	struct page *page, *next;
+
+	list_for_each_entry_safe(page, next, &pipe->tmp_pages, lru)
+		page_cache_release(page);
+	INIT_LIST_HEAD(&pipe->tmp_pages);
+	pipe->nr_tmp_pages = 0;
+}
+
+static void anon_pipe_buf_release(struct pipe_inode_info *pipe,
+				  struct pipe_buffer *buf)
+{
+	pipe_put_tmp_page(pipe, buf->page);
+}
+
 /**
  * generic_pipe_buf_map - virtually map a pipe buffer
  * @pipe:	the pipe that the buffer belongs to
@@ -349,13 +412,25 @@ void generic_pipe_buf_release(struct pipe_inode_info *pipe,
 }
 EXPORT_SYMBOL(generic_pipe_buf_release);
 
+/*
+ * Multi-page buffers cannot be moved into the page cache as they are.
+ */
+static int anon_pipe_buf_steal(struct pipe_inode_info *pipe,
+			       struct pipe_buffer *buf)
+{
+	if (PageCompound(buf->page))
+		return 1;
+
+	return generic_pipe_buf_steal(pipe, buf);
+}
+
 static const struct pipe_buf_operations anon_pipe_buf_ops = {
 	.can_merge = 1,
 	.map = generic_pipe_buf_map,
 	.unmap = generic_pipe_buf_unmap,
 	.confirm = generic_pipe_buf_confirm,
 	.release = anon_pipe_buf_release,
-	.steal = generic_pipe_buf_steal,
+	.steal = anon_pipe_buf_steal,
 	.get = generic_pipe_buf_get,
 };
 
@@ -365,7 +440,7 @@ static const struct pipe_buf_operations packet_pipe_buf_ops = {
 	.unmap = generic_pipe_buf_unmap,
 	.confirm = generic_pipe_buf_confirm,
 	.release = anon_pipe_buf_release,
-	.steal = generic_pipe_buf_steal,
+	.steal = anon_pipe_buf_steal,
 	.get = generic_pipe_buf_get,
 };
 
@@ -528,7 +603,7 @@ pipe_write(struct kiocb *iocb, const struct iovec *_iov,
 		const struct pipe_buf_operations *ops = buf->ops;
 		int offset = buf->offset + buf->len;
 
-		if (ops->can_merge && offset + chars <= PAGE_SIZE) {
+		if (ops->can_merge && offset + chars <= anon_pipe_buf_size(buf)) {
 			int error, atomic = 1;
 			void *addr;
 
@@ -569,20 +644,17 @@ redo1:
 			break;
 		}
 		bufs = pipe->nrbufs;
-		if (bufs < pipe->buffers) {
+		if (pipe_has_room(pipe, bufs)) {
 			int newbuf = (pipe->curbuf + bufs) & (pipe->buffers-1);
 			struct pipe_buffer *buf = pipe->bufs + newbuf;
-			struct page *page = pipe->tmp_page;
+			struct page *page;
 			char *src;
 			int error, atomic = 1;
 
-			if (!page) {
-				page = alloc_page(GFP_HIGHUSER);
-				if (unlikely(!page)) {
-					ret = ret ? : -ENOMEM;
-					break;
-				}
-				pipe->tmp_page = page;
+			page = pipe_get_tmp_page(pipe);
+			if (unlikely(!page)) {
+				ret = ret ? : -ENOMEM;
+				break;
 			}
 			/* Always wake up, even if the copy fails. Otherwise
 			 * we lock up (O_NONBLOCK-)readers that sleep due to
@@ -590,7 +662,10 @@ redo1:
 			 * FIXME! Is this really true?
 			 */
 			do_wakeup = 1;
-			chars = PAGE_SIZE;
+			chars = PAGE_SIZE << compound_order(page);
+			/* Packets stay one page at most, whatever the buffer size */
+			if (is_packetized(filp))
+				chars = PAGE_SIZE;
 			if (chars > total_len)
 				chars = total_len;
 
@@ -613,6 +688,7 @@ redo2:
 					atomic = 0;
 					goto redo2;
 				}
+				pipe_put_tmp_page(pipe, page);
 				if (!ret)
 					ret = error;
 				break;
@@ -630,13 +706,12 @@ redo2:
 				buf->flags = PIPE_BUF_FLAG_PACKET;
 			}
 			pipe->nrbufs = ++bufs;
-			pipe->tmp_page = NULL;
 
 			total_len -= chars;
 			if (!total_len)
 				break;
 		}
-		if (bufs < pipe->buffers)
+		if (pipe_has_room(pipe, bufs))
 			continue;
 		if (filp->f_flags & O_NONBLOCK) {
 			if (!ret)
@@ -715,7 +790,7 @@ pipe_poll(struct file *filp, poll_table *wait)
 	}
 
 	if (filp->f_mode & FMODE_WRITE) {
-		mask |= (nrbufs < pipe->buffers) ? POLLOUT | POLLWRNORM : 0;
+		mask |= pipe_has_room(pipe, nrbufs) ? POLLOUT | POLLWRNORM : 0;
 		/*
 		 * Most Unices do not set POLLERR for FIFOs but on Linux they
 		 * behave exactly like pipes for poll().
@@ -792,6 +867,7 @@ struct pipe_inode_info *alloc_pipe_info(void)
 		pipe->bufs = kzalloc(sizeof(struct pipe_buffer) * PIPE_DEF_BUFFERS, GFP_KERNEL);
 		if (pipe->bufs) {
 			init_waitqueue_head(&pipe->wait);
+			INIT_LIST_HEAD(&pipe->tmp_pages);
 			pipe->r_counter = pipe->w_counter = 1;
 			pipe->buffers = PIPE_DEF_BUFFERS;
 			mutex_init(&pipe->mutex);
@@ -812,8 +888,7 @@ void free_pipe_info(struct pipe_inode_info *pipe)
 		if (buf->ops)
 			buf->ops->release(pipe, buf);
 	}
-	if (pipe->tmp_page)
-		__free_page(pipe->tmp_page);
+	pipe_free_tmp_pages(pipe);
 	kfree(pipe->bufs);
 	kfree(pipe);
 }
@@ -1201,6 +1276,18 @@ static long pipe_set_size(struct pipe_inode_info *pipe, unsigned long nr_pages)
 	kfree(pipe->bufs);
 	pipe->bufs = bufs;
 	pipe->buffers = nr_pages;
+
+	/*
+	 * Pipes bigger than the default get multi-page buffers, keeping
+	 * roughly PIPE_DEF_BUFFERS of them.  Pooled pages are sized for the
+	 * old layout, so drop them.
+	 */
+	pipe_free_tmp_pages(pipe);
+	pipe->buf_order = 0;
+	while (pipe->buf_order < PIPE_MAX_BUF_ORDER &&
+	       (nr_pages >> (pipe->buf_order + 1)) >= PIPE_DEF_BUFFERS)
+		pipe->buf_order++;
+
 	return nr_pages * PAGE_SIZE;
 }
 
@@ -82,6 +82,7 @@
 #include <linux/ptrace.h>
 #include <linux/tracehook.h>
 #include <linux/user_namespace.h>
+#include <linux/proc_tasks.h>
 
 #include <asm/pgtable.h>
 #include <asm/processor.h>
@@ -541,6 +542,47 @@ static int do_task_stat(struct seq_file *m, struct pid_namespace *ns,
 	return 0;
 }
 
+/*
+ * Fill in the /proc/taskinfo record of a task.  Called under
+ * rcu_read_lock(), so this must not sleep.
+ */
+void proc_task_record(struct task_struct *task, struct pid_namespace *ns,
+		      struct proc_task_record *rec)
+{
+	struct mm_struct *mm;
+	cputime_t utime, stime;
+
+	memset(rec, 0, sizeof(*rec));
+	rec->size = sizeof(*rec);
+	rec->pid = task_pid_nr_ns(task, ns);
+	rec->tgid = task_tgid_nr_ns(task, ns);
+	if (pid_alive(task))
+		rec->ppid = task_tgid_nr_ns(rcu_dereference(task->real_parent),
+					    ns);
+	rec->state = *get_task_state(task);
+	rec->nice = task_nice(task);
+	rec->policy = task->policy;
+	rec->cpu = task_cpu(task);
+	rec->nr_threads = get_nr_threads(task);
+
+	task_cputime_adjusted(task, &utime, &stime);
+	rec->utime_us = cputime_to_usecs(utime);
+	rec->stime_us = cputime_to_usecs(stime);
+	rec->start_time_ns = timespec_to_ns(&task->real_start_time);
+	rec->min_flt = task->min_flt;
+	rec->maj_flt = task->maj_flt;
+
+	/* task_lock() keeps ->mm from going away under us */
+	task_lock(task);
+	mm = task->mm;
+	if (mm && !(task->flags & PF_KTHREAD)) {
+		rec->vsize = task_vsize(mm);
+		rec->rss = get_mm_rss(mm);
+	}
+	strncpy(rec->comm, task->comm, sizeof(rec->comm));
+	task_unlock(task);
+}
+
 int proc_tid_stat(struct seq_file *m, struct pid_namespace *ns,
 			struct pid *pid, struct task_struct *task)
 {
@@ -155,6 +155,9 @@ extern int proc_pid_status(struct seq_file *, struct pid_namespace *,
 			   struct pid *, struct task_struct *);
 extern int proc_pid_statm(struct seq_file *, struct pid_namespace *,
 			  struct pid *, struct task_struct *);
+struct proc_task_record;
+extern void proc_task_record(struct task_struct *, struct pid_namespace *,
+			     struct proc_task_record *);
 
 /*
  * base.c
@@ -168,6 +171,7 @@ extern int pid_delete_dentry(const struct dentry *);
 extern int proc_pid_readdir(struct file *, struct dir_context *);
 extern struct dentry *proc_pid_lookup(struct inode *, struct dentry *, unsigned int);
 extern loff_t mem_lseek(struct file *, loff_t, int);
+extern bool has_pid_permissions(struct pid_namespace *, struct task_struct *, int);
 
 /* Lookups */
 typedef int instantiate_t(struct inode *, struct dentry *,
@@ -0,0 +1,92 @@
+#include <linux/fs.h>
+#include <linux/init.h>
+#include <linux/pid_namespace.h>
+#include <linux/proc_fs.h>
+#include <linux/proc_tasks.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include "internal.h"
+
+/*
+ * The position is the next pid number to look at, so a read that resumes
+ * after tasks came and went neither repeats nor skips any that stayed.
+ */
+static struct task_struct *taskinfo_find(struct seq_file *m, loff_t *pos)
+{
+	struct pid_namespace *ns = m->private;
+	struct task_struct *t;
+	struct pid *pid;
+
+	while (*pos < PID_MAX_LIMIT && (pid = find_ge_pid(*pos, ns))) {
+		*pos = pid_nr_ns(pid, ns);
+		t = pid_task(pid, PIDTYPE_PID);
+		/* Same rule as reading /proc/<pid>/stat under hidepid= */
+		if (t && has_pid_permissions(ns, t, 1))
+			return t;
+		++*pos;
+	}
+	return NULL;
+}
+
+static void *taskinfo_start(struct seq_file *m, loff_t *pos)
+	__acquires(RCU)
+{
+	rcu_read_lock();
+	return taskinfo_find(m, pos);
+}
+
+static void *taskinfo_next(struct seq_file *m, void *v, loff_t *pos)
+{
+	++*pos;
+	return taskinfo_find(m, pos);
+}
+
+static void taskinfo_stop(struct seq_file *m, void *v)
+	__releases(RCU)
+{
+	rcu_read_unlock();
+}
+
+static int taskinfo_show(struct seq_file *m, void *v)
+{
+	struct proc_task_record rec;
+
+	proc_task_record(v, m->private, &rec);
+	seq_write(m, &rec, sizeof(rec));
+	return 0;
+}
+
+static const struct seq_operations taskinfo_seq_ops = {
+	.start	= taskinfo_start,
+	.next	= taskinfo_next,
+	.stop	= taskinfo_stop,
+	.show	= taskinfo_show,
+};
+
+static int taskinfo_open(struct inode *inode, struct file *file)
+{
+	struct seq_file *m;
+	int ret;
+
+	ret = seq_open(file, &taskinfo_seq_ops);
+	if (ret)
+		return ret;
+
+	m = file->private_data;
+	m->private = inode->i_sb->s_fs_info;
+	return 0;
+}
+
+static const struct file_operations taskinfo_proc_fops = {
+	.open		= taskinfo_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= seq_release,
+};
+
+static int __init proc_taskinfo_init(void)
+{
+	proc_create("taskinfo", 0, NULL, &taskinfo_proc_fops);
+	return 0;
+}
+fs_initcall(proc_taskinfo_init);
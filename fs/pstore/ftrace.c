@@ -112,7 +112,7 @@ void pstore_register_ftrace(void)
 	if (!psinfo->write_buf)
 		return;
 
-	dir = debugfs_create_dir("pstore", NULL);
+	dir = pstore_debugfs_dir();
 	if (!dir) {
 		pr_err("%s: unable to create pstore directory\n", __func__);
 		return;
@@ -120,12 +120,6 @@ void pstore_register_ftrace(void)
 
 	file = debugfs_create_file("record_ftrace", 0600, dir, NULL,
 				   &pstore_knob_fops);
-	if (!file) {
+	if (!file)
 		pr_err("%s: unable to create record_ftrace file\n", __func__);
-		goto err_file;
-	}
-
-	return;
-err_file:
-	debugfs_remove(dir);
 }
@@ -324,6 +324,9 @@ int pstore_mkfile(enum pstore_type_id type, char *psname, u64 id, int count,
 	case PSTORE_TYPE_FTRACE:
 		sprintf(name, "ftrace-%s-%lld", psname, id);
 		break;
+	case PSTORE_TYPE_TRACE:
+		sprintf(name, "trace-%s-%lld", psname, id);
+		break;
 	case PSTORE_TYPE_MCE:
 		sprintf(name, "mce-%s-%lld", psname, id);
 		break;
@@ -45,6 +45,18 @@ extern void pstore_register_ftrace(void);
 static inline void pstore_register_ftrace(void) {}
 #endif
 
+#ifdef CONFIG_PSTORE_TRACE_RECORDER
+extern void pstore_register_trace_recorder(void);
+extern void pstore_trace_recorder_dump(enum kmsg_dump_reason reason);
+#else
+static inline void pstore_register_trace_recorder(void) {}
+static inline void
+pstore_trace_recorder_dump(enum kmsg_dump_reason reason) {}
+#endif
+
+struct dentry;
+extern struct dentry *pstore_debugfs_dir(void);
+
 extern struct pstore_info *psinfo;
 
 extern void	pstore_set_kmsg_bytes(int);
@@ -26,7 +26,12 @@
 #include <linux/console.h>
 #include <linux/module.h>
 #include <linux/pstore.h>
+#ifdef CONFIG_PSTORE_ZLIB_COMPRESS
 #include <linux/zlib.h>
+#endif
+#ifdef CONFIG_PSTORE_LZ4_COMPRESS
+#include <linux/lz4.h>
+#endif
 #include <linux/string.h>
 #include <linux/timer.h>
 #include <linux/slab.h>
@@ -34,6 +39,7 @@
 #include <linux/hardirq.h>
 #include <linux/jiffies.h>
 #include <linux/workqueue.h>
+#include <linux/debugfs.h>
 
 #include "internal.h"
 
@@ -66,12 +72,6 @@ struct pstore_info *psinfo;
 
 static char *backend;
 
-/* Compression parameters */
-#define COMPR_LEVEL 6
-#define WINDOW_BITS 12
-#define MEM_LEVEL 4
-static struct z_stream_s stream;
-
 static char *big_oops_buf;
 static size_t big_oops_buf_sz;
 
@@ -127,6 +127,13 @@ bool pstore_cannot_block_path(enum kmsg_dump_reason reason)
 }
 EXPORT_SYMBOL_GPL(pstore_cannot_block_path);
 
+#ifdef CONFIG_PSTORE_ZLIB_COMPRESS
+/* Compression parameters */
+#define COMPR_LEVEL 6
+#define WINDOW_BITS 12
+#define MEM_LEVEL 4
+static struct z_stream_s stream;
+
 /* Derived from logfs_compress() */
 static int pstore_compress(const void *in, void *out, size_t inlen,
 							size_t outlen)
@@ -236,6 +243,62 @@ static void allocate_buf_for_compression(void)
 	}
 
 }
+#endif
+
+#ifdef CONFIG_PSTORE_LZ4_COMPRESS
+/*
+ * LZ4 always compresses into a buffer large enough for the worst case, the
+ * result is only used if it fits the record.
+ */
+static void *lz4_workspace;
+static void *lz4_out_buf;
+static size_t lz4_out_buf_sz;
+
+static int pstore_compress(const void *in, void *out, size_t inlen,
+							size_t outlen)
+{
+	size_t len;
+
+	if (lz4_compress(in, inlen, lz4_out_buf, &len, lz4_workspace))
+		return -EIO;
+
+	if (len > outlen || len >= inlen)
+		return -EIO;
+
+	memcpy(out, lz4_out_buf, len);
+
+	return len;
+}
+
+static int pstore_decompress(void *in, void *out, size_t inlen, size_t outlen)
+{
+	size_t len = outlen;
+
+	if (lz4_decompress_unknownoutputsize(in, inlen, out, &len))
+		return -EIO;
+
+	return len;
+}
+
+static void allocate_buf_for_compression(void)
+{
+	/* Kernel logs typically shrink to less than half their size */
+	big_oops_buf_sz = (psinfo->bufsize * 100) / 45;
+	lz4_out_buf_sz = lz4_compressbound(big_oops_buf_sz);
+
+	big_oops_buf = kmalloc(big_oops_buf_sz, GFP_KERNEL);
+	lz4_out_buf = kmalloc(lz4_out_buf_sz, GFP_KERNEL);
+	lz4_workspace = kmalloc(LZ4_MEM_COMPRESS, GFP_KERNEL);
+	if (!big_oops_buf || !lz4_out_buf || !lz4_workspace) {
+		pr_err("pstore: No memory for compression buffers; "
+			"skipping compression\n");
+		kfree(lz4_workspace);
+		kfree(lz4_out_buf);
+		kfree(big_oops_buf);
+		big_oops_buf = NULL;
+	}
+}
+#endif
 
 /*
  * Called when compression fails, since the printk buffer
@@ -347,6 +410,8 @@ static void pstore_dump(struct kmsg_dumper *dumper,
 			spin_unlock_irqrestore(&psinfo->buf_lock, flags);
 	} else
 		spin_unlock_irqrestore(&psinfo->buf_lock, flags);
+
+	pstore_trace_recorder_dump(reason);
 }
 
 static struct kmsg_dumper pstore_dumper = {
@@ -394,6 +459,16 @@ static void pstore_register_console(void)
 static void pstore_register_console(void) {}
 #endif
 
+/* Directory holding the debugfs knobs of the front ends */
+struct dentry *pstore_debugfs_dir(void)
+{
+	static struct dentry *dir;
+
+	if (!dir)
+		dir = debugfs_create_dir("pstore", NULL);
+	return dir;
+}
+
 static int pstore_write_compat(enum pstore_type_id type,
 			       enum kmsg_dump_reason reason,
 			       u64 *id, unsigned int part, int count,
@@ -447,6 +522,7 @@ int pstore_register(struct pstore_info *psi)
 	if ((psi->flags & PSTORE_FLAGS_FRAGILE) == 0) {
 		pstore_register_console();
 		pstore_register_ftrace();
+		pstore_register_trace_recorder();
 	}
 
 	if (pstore_update_ms >= 0) {
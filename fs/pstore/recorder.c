@@ -0,0 +1,182 @@
+/*
+ * Persistent trace event recorder
+ *
+ * A trace instance (tracing/instances/<name>) keeps recording the events
+ * enabled in it into its per-CPU ring buffers, which overwrite the oldest
+ * entries when full. Once the instance is attached here, its contents are
+ * written to the persistent store on oops or panic, so the events leading
+ * up to a crash can be read back from the pstore filesystem after reboot.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <linux/kernel.h>
+#include <linux/atomic.h>
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/ftrace.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
+#include "internal.h"
+
+#define PSTORE_TRACE_BATCH	1024
+
+static DEFINE_MUTEX(pstore_trace_lock);
+static struct trace_array *pstore_trace_tr;
+static char *pstore_trace_name;
+static atomic_t pstore_trace_dumped;
+
+/* Lines are collected here and handed to the backend a batch at a time */
+static struct pstore_trace_batch {
+	unsigned int part;
+	size_t len;
+	char buf[PSTORE_TRACE_BATCH];
+} pstore_trace_batch;
+
+static void pstore_trace_emit(struct pstore_trace_batch *b, const char *buf,
+			      size_t len)
+{
+	u64 id;
+
+	/* The first part carries the record header */
+	psinfo->write_buf(PSTORE_TYPE_TRACE, 0, &id, b->part++, buf, 0, len,
+			  psinfo);
+}
+
+static void pstore_trace_flush(struct pstore_trace_batch *b)
+{
+	if (b->len)
+		pstore_trace_emit(b, b->buf, b->len);
+	b->len = 0;
+}
+
+static void pstore_trace_write(const char *buf, size_t len, void *data)
+{
+	struct pstore_trace_batch *b = data;
+
+	if (b->len + len > sizeof(b->buf))
+		pstore_trace_flush(b);
+	if (len > sizeof(b->buf)) {
+		pstore_trace_emit(b, buf, len);
+		return;
+	}
+	memcpy(b->buf + b->len, buf, len);
+	b->len += len;
+}
+
+void pstore_trace_recorder_dump(enum kmsg_dump_reason reason)
+{
+	struct trace_array *tr = ACCESS_ONCE(pstore_trace_tr);
+	struct pstore_trace_batch *b = &pstore_trace_batch;
+
+	if (reason != KMSG_DUMP_OOPS && reason != KMSG_DUMP_PANIC)
+		return;
+
+	/* Dumping consumes the buffer, so only the first crash is kept */
+	if (!tr || atomic_xchg(&pstore_trace_dumped, 1))
+		return;
+
+	b->part = 1;
+	b->len = 0;
+	trace_array_dump(tr, pstore_trace_write, b);
+	pstore_trace_flush(b);
+}
+
+static ssize_t pstore_trace_knob_write(struct file *f, const char __user *buf,
+				       size_t count, loff_t *ppos)
+{
+	struct trace_array *tr = NULL, *old_tr;
+	char *kbuf, *name = NULL, *old_name;
+	ssize_t ret;
+
+	if (count >= NAME_MAX)
+		return -EINVAL;
+
+	kbuf = kmalloc(count + 1, GFP_KERNEL);
+	if (!kbuf)
+		return -ENOMEM;
+
+	ret = -EFAULT;
+	if (copy_from_user(kbuf, buf, count))
+		goto out;
+	kbuf[count] = '\0';
+
+	/* An empty name detaches the current instance */
+	if (*strim(kbuf)) {
+		ret = -ENOMEM;
+		name = kstrdup(strim(kbuf), GFP_KERNEL);
+		if (!name)
+			goto out;
+
+		ret = -ENOENT;
+		tr = trace_array_get_by_name(name);
+		if (!tr) {
+			kfree(name);
+			goto out;
+		}
+	}
+
+	mutex_lock(&pstore_trace_lock);
+	old_tr = pstore_trace_tr;
+	old_name = pstore_trace_name;
+	pstore_trace_tr = tr;
+	pstore_trace_name = name;
+	mutex_unlock(&pstore_trace_lock);
+
+	if (old_tr)
+		trace_array_put(old_tr);
+	kfree(old_name);
+
+	ret = count;
+out:
+	kfree(kbuf);
+	return ret;
+}
+
+static ssize_t pstore_trace_knob_read(struct file *f, char __user *buf,
+				      size_t count, loff_t *ppos)
+{
+	char val[NAME_MAX + 1];
+	int len;
+
+	mutex_lock(&pstore_trace_lock);
+	len = scnprintf(val, sizeof(val), "%s\n",
+			pstore_trace_name ? pstore_trace_name : "");
+	mutex_unlock(&pstore_trace_lock);
+
+	return simple_read_from_buffer(buf, count, ppos, val, len);
+}
+
+static const struct file_operations pstore_trace_knob_fops = {
+	.open	= simple_open,
+	.read	= pstore_trace_knob_read,
+	.write	= pstore_trace_knob_write,
+};
+
+void pstore_register_trace_recorder(void)
+{
+	struct dentry *dir;
+
+	if (!psinfo->write_buf)
+		return;
+
+	dir = pstore_debugfs_dir();
+	if (!dir) {
+		pr_err("%s: unable to create pstore directory\n", __func__);
+		return;
+	}
+
+	if (!debugfs_create_file("record_trace_instance", 0600, dir, NULL,
+				 &pstore_trace_knob_fops))
+		pr_err("%s: unable to create record_trace_instance file\n",
+		       __func__);
+}
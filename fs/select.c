@@ -129,7 +129,18 @@ EXPORT_SYMBOL(poll_initwait);
 
 static void free_poll_entry(struct poll_table_entry *entry)
 {
-	remove_wait_queue(entry->wait_address, &entry->wait);
+	wait_queue_head_t *whead;
+
+	/* already retired by the poll cache */
+	if (!entry->filp)
+		return;
+
+	rcu_read_lock();
+	/* If it is cleared by POLLFREE, it should be rcu-safe */
+	whead = ACCESS_ONCE(entry->wait_address);
+	if (whead)
+		remove_wait_queue(whead, &entry->wait);
+	rcu_read_unlock();
 	fput(entry->filp);
 }
 
@@ -258,6 +269,220 @@ int poll_schedule_timeout(struct poll_wqueues *pwq, int state,
 }
 EXPORT_SYMBOL(poll_schedule_timeout);
 
+/*
+ * Persistent poll registration.
+ *
+ * Programs that poll() the same descriptors in a loop spend much of each
+ * call adding and removing wait queue entries.  With fs.poll-cache set, a
+ * task whose file table is not shared keeps its entries registered
+ * between calls.  The first pass of the next call re-uses every entry
+ * the ->poll methods ask for again, adds the new ones and retires the
+ * rest.  While the task is outside poll() the entries only record that
+ * a wakeup happened.
+ *
+ * The entries pin their files, so the cache is dropped whenever the task
+ * closes a descriptor, execs, shares its file table or exits.
+ */
+int sysctl_poll_cache __read_mostly;
+
+#define POLL_CACHE_MAX_FDS	1024
+#define POLL_CACHE_MIN_ENTS	16
+
+struct poll_cache {
+	struct poll_wqueues	wq;
+	bool			parked;
+	struct poll_table_entry	**ents;		/* live, in registration order */
+	struct poll_table_entry	**next;		/* collected by this pass */
+	unsigned int		nr_ents;
+	unsigned int		nr_next;
+	unsigned int		max_ents;
+	unsigned int		cursor;
+	unsigned int		nr_alloc;	/* entries taken from wq */
+};
+
+static int pollwake_cached(wait_queue_t *wait, unsigned mode, int sync,
+			   void *key)
+{
+	struct poll_table_entry *entry;
+	struct poll_cache *pc;
+
+	entry = container_of(wait, struct poll_table_entry, wait);
+
+	/*
+	 * The wait queue is going away while the entry may stay cached
+	 * across calls.  Unhook it here, as epoll does, so that it is
+	 * neither matched again nor removed from the freed queue later.
+	 * A racing free_poll_entry() may still remove it once more, which
+	 * list_del_init() keeps harmless; the caller holds the queue lock.
+	 */
+	if ((unsigned long)key & POLLFREE) {
+		ACCESS_ONCE(entry->wait_address) = NULL;
+		list_del_init(&wait->task_list);
+	}
+
+	if (key && !((unsigned long)key & entry->key))
+		return 0;
+
+	/* pairs with the barrier in poll_cache_get() */
+	smp_mb();
+	pc = container_of((struct poll_wqueues *)wait->private,
+			  struct poll_cache, wq);
+	if (ACCESS_ONCE(pc->parked)) {
+		pc->wq.triggered = 1;
+		return 0;
+	}
+	return __pollwake(wait, mode, sync, key);
+}
+
+static int poll_cache_grow(struct poll_cache *pc)
+{
+	unsigned int max = max_t(unsigned int, pc->max_ents * 2,
+				 POLL_CACHE_MIN_ENTS);
+	struct poll_table_entry **ents, **next;
+
+	ents = krealloc(pc->ents, max * sizeof(*ents), GFP_KERNEL);
+	if (!ents)
+		return -ENOMEM;
+	pc->ents = ents;
+	next = krealloc(pc->next, max * sizeof(*next), GFP_KERNEL);
+	if (!next)
+		return -ENOMEM;
+	pc->next = next;
+	pc->max_ents = max;
+	return 0;
+}
+
+static inline bool poll_cache_match(struct poll_table_entry *entry,
+				    struct file *filp,
+				    wait_queue_head_t *wait_address,
+				    unsigned long key)
+{
+	return entry && entry->filp == filp &&
+	       entry->wait_address == wait_address && entry->key == key;
+}
+
+/*
+ * ->poll methods register in the same order from one call to the next,
+ * so the search normally succeeds right at the cursor.
+ */
+static void __pollwait_cached(struct file *filp,
+			      wait_queue_head_t *wait_address, poll_table *p)
+{
+	struct poll_cache *pc = container_of(p, struct poll_cache, wq.pt);
+	struct poll_table_entry *entry;
+	unsigned int i;
+
+	if (pc->nr_next == pc->max_ents && poll_cache_grow(pc)) {
+		pc->wq.error = -ENOMEM;
+		return;
+	}
+
+	for (i = pc->cursor; i < pc->nr_ents; i++)
+		if (poll_cache_match(pc->ents[i], filp, wait_address, p->_key))
+			goto found;
+	for (i = 0; i < pc->cursor; i++)
+		if (poll_cache_match(pc->ents[i], filp, wait_address, p->_key))
+			goto found;
+
+	entry = poll_get_entry(&pc->wq);
+	if (!entry)
+		return;
+	pc->nr_alloc++;
+	entry->filp = get_file(filp);
+	entry->wait_address = wait_address;
+	entry->key = p->_key;
+	init_waitqueue_func_entry(&entry->wait, pollwake_cached);
+	entry->wait.private = &pc->wq;
+	add_wait_queue(wait_address, &entry->wait);
+	pc->next[pc->nr_next++] = entry;
+	return;
+
+found:
+	pc->next[pc->nr_next++] = pc->ents[i];
+	pc->ents[i] = NULL;
+	pc->cursor = i + 1;
+}
+
+/* Retire the entries the last registration pass did not ask for. */
+static void poll_cache_sweep(struct poll_cache *pc)
+{
+	unsigned int i;
+
+	for (i = 0; i < pc->nr_ents; i++) {
+		struct poll_table_entry *entry = pc->ents[i];
+
+		if (entry) {
+			free_poll_entry(entry);
+			entry->filp = NULL;
+		}
+	}
+	swap(pc->ents, pc->next);
+	pc->nr_ents = pc->nr_next;
+	pc->nr_next = 0;
+	pc->cursor = 0;
+}
+
+static void poll_cache_reset(struct poll_cache *pc)
+{
+	poll_freewait(&pc->wq);
+	poll_initwait(&pc->wq);
+	pc->nr_ents = 0;
+	pc->nr_next = 0;
+	pc->cursor = 0;
+	pc->nr_alloc = 0;
+}
+
+static struct poll_cache *poll_cache_get(unsigned int nfds)
+{
+	struct poll_cache *pc = current->poll_cache;
+
+	if (!sysctl_poll_cache || !nfds || nfds > POLL_CACHE_MAX_FDS ||
+	    atomic_read(&current->files->count) != 1) {
+		poll_cache_drop();
+		return NULL;
+	}
+
+	if (!pc) {
+		pc = kzalloc(sizeof(*pc), GFP_KERNEL);
+		if (!pc)
+			return NULL;
+		poll_initwait(&pc->wq);
+		current->poll_cache = pc;
+	} else if (pc->nr_alloc > 2 * pc->nr_ents + N_INLINE_POLL_ENTRIES) {
+		/* retired entries have piled up in the storage */
+		poll_cache_reset(pc);
+	}
+
+	init_poll_funcptr(&pc->wq.pt, __pollwait_cached);
+	pc->wq.error = 0;
+	pc->parked = false;
+	/* order the unpark against the ->poll checks, see pollwake_cached() */
+	smp_mb();
+	return pc;
+}
+
+static void poll_cache_put(struct poll_cache *pc)
+{
+	if (pc->wq.error) {
+		poll_cache_drop();
+		return;
+	}
+	pc->parked = true;
+}
+
+void poll_cache_drop(void)
+{
+	struct poll_cache *pc = current->poll_cache;
+
+	if (likely(!pc))
+		return;
+	current->poll_cache = NULL;
+	poll_freewait(&pc->wq);
+	kfree(pc->ents);
+	kfree(pc->next);
+	kfree(pc);
+}
+
 /**
  * poll_select_set_timeout - helper function to setup the timeout value
  * @to:		pointer to timespec variable for the final timeout
@@ -779,7 +1004,8 @@ static inline unsigned int do_pollfd(struct pollfd *pollfd, poll_table *pwait,
 }
 
 static int do_poll(unsigned int nfds,  struct poll_list *list,
-		   struct poll_wqueues *wait, struct timespec *end_time)
+		   struct poll_wqueues *wait, struct timespec *end_time,
+		   struct poll_cache *pc)
 {
 	poll_table* pt = &wait->pt;
 	ktime_t expire, *to = NULL;
@@ -812,12 +1038,15 @@ static int do_poll(unsigned int nfds,  struct poll_list *list,
 				 * and kill poll_table->_qproc, so we don't
 				 * needlessly register any other waiters after
 				 * this. They'll get immediately deregistered
-				 * when we break out and return.
+				 * when we break out and return.  The poll
+				 * cache keeps registering, anything it does
+				 * not see in this pass gets retired.
 				 */
 				if (do_pollfd(pfd, pt, &can_busy_loop,
 					      busy_flag)) {
 					count++;
-					pt->_qproc = NULL;
+					if (!pc)
+						pt->_qproc = NULL;
 					/* found something, stop busy polling */
 					busy_flag = 0;
 					can_busy_loop = false;
@@ -828,6 +1057,8 @@ static int do_poll(unsigned int nfds,  struct poll_list *list,
 		 * All waiters have already been registered, so don't provide
 		 * a poll_table->_qproc to them on the next loop iteration.
 		 */
+		if (pc && pt->_qproc)
+			poll_cache_sweep(pc);
 		pt->_qproc = NULL;
 		if (!count) {
 			count = wait->error;
@@ -871,6 +1102,7 @@ int do_sys_poll(struct pollfd __user *ufds, unsigned int nfds,
 		struct timespec *end_time)
 {
 	struct poll_wqueues table;
+	struct poll_cache *pc;
  	int err = -EFAULT, fdcount, len, size;
 	/* Allocate small arguments on the stack to save memory and be
 	   faster - use long to make sure the buffer is aligned properly
@@ -907,9 +1139,15 @@ int do_sys_poll(struct pollfd __user *ufds, unsigned int nfds,
 		}
 	}
 
-	poll_initwait(&table);
-	fdcount = do_poll(nfds, head, &table, end_time);
-	poll_freewait(&table);
+	pc = poll_cache_get(nfds);
+	if (pc) {
+		fdcount = do_poll(nfds, head, &pc->wq, end_time, pc);
+		poll_cache_put(pc);
+	} else {
+		poll_initwait(&table);
+		fdcount = do_poll(nfds, head, &table, end_time, NULL);
+		poll_freewait(&table);
+	}
 
 	for (walk = head; walk; walk = walk->next) {
 		struct pollfd *fds = walk->entries;
@@ -32,6 +32,12 @@
  * To avoid out of memory and fragmentation issues with vmalloc the cache
  * uses sequences of kmalloced PAGE_CACHE_SIZE buffers.
  *
+ * A cache may have more entries than it keeps buffers for.  The first
+ * "reserved" entries are allocated at mount, the others only get buffers
+ * when they are first needed and memory is available without reclaim.  A
+ * shrinker frees the buffers of unused entries beyond the reserved ones
+ * again when memory gets tight.
+ *
  * It should be noted that the cache is not used for file datablocks, these
  * are decompressed and cached in the page-cache in the normal way.  The
  * cache is only used to temporarily cache fragment and metadata blocks
@@ -58,6 +64,100 @@
 #include "squashfs.h"
 #include "page_actor.h"
 
+/*
+ * Allocate the buffers of a cache entry, returns 0 on success.
+ */
+static int squashfs_cache_populate(struct squashfs_cache *cache,
+	struct squashfs_cache_entry *entry, gfp_t gfp)
+{
+	int j;
+
+	for (j = 0; j < cache->pages; j++) {
+		entry->data[j] = kmalloc(PAGE_CACHE_SIZE, gfp);
+		if (entry->data[j] == NULL)
+			goto failed;
+	}
+
+	return 0;
+
+failed:
+	while (j--) {
+		kfree(entry->data[j]);
+		entry->data[j] = NULL;
+	}
+	return -ENOMEM;
+}
+
+
+static void squashfs_cache_depopulate(struct squashfs_cache *cache,
+	struct squashfs_cache_entry *entry)
+{
+	int j;
+
+	for (j = 0; j < cache->pages; j++) {
+		kfree(entry->data[j]);
+		entry->data[j] = NULL;
+	}
+}
+
+
+/*
+ * Return an unused cache entry which has buffers, or NULL if there is none.
+ * Called with the cache lock held, or locklessly as a wait condition.
+ */
+static struct squashfs_cache_entry *squashfs_cache_spare(
+	struct squashfs_cache *cache)
+{
+	int i;
+
+	for (i = 0; i < cache->entries; i++) {
+		struct squashfs_cache_entry *entry = &cache->entry[i];
+
+		if (entry->refcount == 0 && entry->data[0])
+			return entry;
+	}
+
+	return NULL;
+}
+
+
+/*
+ * Give buffers to @entry, which has been chosen for filling but has none.
+ * The buffers are allocated if that's possible without reclaim, otherwise
+ * they are taken from an unused entry, waiting for one if necessary.  The
+ * reserved entries always have buffers, so this makes progress as long as
+ * the cache would have without the extra entries.
+ */
+static void squashfs_cache_grow(struct squashfs_cache *cache,
+	struct squashfs_cache_entry *entry)
+{
+	struct squashfs_cache_entry *spare;
+	int j;
+
+	if (squashfs_cache_populate(cache, entry,
+			GFP_KERNEL | __GFP_NORETRY | __GFP_NOWARN) == 0) {
+		spin_lock(&cache->lock);
+		cache->populated++;
+		spin_unlock(&cache->lock);
+		return;
+	}
+
+	spin_lock(&cache->lock);
+	while ((spare = squashfs_cache_spare(cache)) == NULL) {
+		cache->num_waiters++;
+		spin_unlock(&cache->lock);
+		wait_event(cache->wait_queue, squashfs_cache_spare(cache));
+		spin_lock(&cache->lock);
+		cache->num_waiters--;
+	}
+
+	spare->block = SQUASHFS_INVALID_BLK;
+	for (j = 0; j < cache->pages; j++)
+		swap(entry->data[j], spare->data[j]);
+	spin_unlock(&cache->lock);
+}
+
+
 /*
  * Look-up block in cache, and increment usage count.  If not in cache, read
  * and decompress it from disk.
@@ -120,6 +220,9 @@ struct squashfs_cache_entry *squashfs_cache_get(struct super_block *sb,
 			entry->error = 0;
 			spin_unlock(&cache->lock);
 
+			if (entry->data[0] == NULL)
+				squashfs_cache_grow(cache, entry);
+
 			entry->length = squashfs_read_data(sb, block, length,
 				&entry->next_index, entry->actor);
 
@@ -204,20 +307,64 @@ void squashfs_cache_put(struct squashfs_cache_entry *entry)
 	spin_unlock(&cache->lock);
 }
 
+static unsigned long squashfs_cache_count(struct shrinker *shrink,
+	struct shrink_control *sc)
+{
+	struct squashfs_cache *cache = container_of(shrink,
+		struct squashfs_cache, shrinker);
+
+	return (cache->populated - cache->reserved) * cache->pages;
+}
+
+
+/*
+ * Free the buffers of unused entries beyond the reserved ones, starting
+ * with the entry that would be evicted next.
+ */
+static unsigned long squashfs_cache_scan(struct shrinker *shrink,
+	struct shrink_control *sc)
+{
+	struct squashfs_cache *cache = container_of(shrink,
+		struct squashfs_cache, shrinker);
+	unsigned long freed = 0;
+	int i, n;
+
+	spin_lock(&cache->lock);
+	for (i = cache->next_blk, n = 0; n < cache->entries &&
+			freed < sc->nr_to_scan &&
+			cache->populated > cache->reserved; n++) {
+		struct squashfs_cache_entry *entry = &cache->entry[i];
+
+		if (entry->refcount == 0 && entry->data[0]) {
+			entry->block = SQUASHFS_INVALID_BLK;
+			squashfs_cache_depopulate(cache, entry);
+			cache->populated--;
+			freed += cache->pages;
+		}
+		i = (i + 1) % cache->entries;
+	}
+	spin_unlock(&cache->lock);
+
+	return freed;
+}
+
+
 /*
  * Delete cache reclaiming all kmalloced buffers.
  */
 void squashfs_cache_delete(struct squashfs_cache *cache)
 {
-	int i, j;
+	int i;
 
 	if (cache == NULL)
 		return;
 
+	if (cache->shrinker.count_objects)
+		unregister_shrinker(&cache->shrinker);
+
 	for (i = 0; i < cache->entries; i++) {
 		if (cache->entry[i].data) {
-			for (j = 0; j < cache->pages; j++)
-				kfree(cache->entry[i].data[j]);
+			squashfs_cache_depopulate(cache, &cache->entry[i]);
 			kfree(cache->entry[i].data);
 		}
 		kfree(cache->entry[i].actor);
@@ -229,14 +376,15 @@ void squashfs_cache_delete(struct squashfs_cache *cache)
 
 
 /*
- * Initialise cache allocating the specified number of entries, each of
- * size block_size.  To avoid vmalloc fragmentation issues each entry
- * is allocated as a sequence of kmalloced PAGE_CACHE_SIZE buffers.
+ * Initialise cache with the specified number of entries, each of size
+ * block_size.  Buffers are allocated for the first reserved entries, the
+ * others get theirs on demand.  To avoid vmalloc fragmentation issues each
+ * entry is allocated as a sequence of kmalloced PAGE_CACHE_SIZE buffers.
  */
 struct squashfs_cache *squashfs_cache_init(char *name, int entries,
-	int block_size)
+	int reserved, int block_size)
 {
-	int i, j;
+	int i;
 	struct squashfs_cache *cache = kzalloc(sizeof(*cache), GFP_KERNEL);
 
 	if (cache == NULL) {
@@ -254,6 +402,8 @@ struct squashfs_cache *squashfs_cache_init(char *name, int entries,
 	cache->next_blk = 0;
 	cache->unused = entries;
 	cache->entries = entries;
+	cache->reserved = min(reserved, entries);
+	cache->populated = cache->reserved;
 	cache->block_size = block_size;
 	cache->pages = block_size >> PAGE_CACHE_SHIFT;
 	cache->pages = cache->pages ? cache->pages : 1;
@@ -274,12 +424,10 @@ struct squashfs_cache *squashfs_cache_init(char *name, int entries,
 			goto cleanup;
 		}
 
-		for (j = 0; j < cache->pages; j++) {
-			entry->data[j] = kmalloc(PAGE_CACHE_SIZE, GFP_KERNEL);
-			if (entry->data[j] == NULL) {
-				ERROR("Failed to allocate %s buffer\n", name);
-				goto cleanup;
-			}
+		if (i < cache->reserved && squashfs_cache_populate(cache, entry,
+							GFP_KERNEL)) {
+			ERROR("Failed to allocate %s buffer\n", name);
+			goto cleanup;
 		}
 
 		entry->actor = squashfs_page_actor_init(entry->data,
@@ -290,6 +438,16 @@ struct squashfs_cache *squashfs_cache_init(char *name, int entries,
 		}
 	}
 
+	if (entries > cache->reserved) {
+		cache->shrinker.count_objects = squashfs_cache_count;
+		cache->shrinker.scan_objects = squashfs_cache_scan;
+		cache->shrinker.seeks = DEFAULT_SEEKS;
+		if (register_shrinker(&cache->shrinker)) {
+			cache->shrinker.count_objects = NULL;
+			goto cleanup;
+		}
+	}
+
 	return cache;
 
 cleanup:
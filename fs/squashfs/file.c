@@ -332,7 +332,7 @@ failed:
  * Get the on-disk location and compressed size of the datablock
  * specified by index.  Fill_meta_index() does most of the work.
  */
-static int read_blocklist(struct inode *inode, int index, u64 *block)
+int squashfs_read_blocklist(struct inode *inode, int index, u64 *block)
 {
 	u64 start;
 	long long blks;
@@ -340,7 +340,7 @@ static int read_blocklist(struct inode *inode, int index, u64 *block)
 	__le32 size;
 	int res = fill_meta_index(inode, index, &start, &offset, block);
 
-	TRACE("read_blocklist: res %d, index %d, start 0x%llx, offset"
+	TRACE("squashfs_read_blocklist: res %d, index %d, start 0x%llx, offset"
 		       " 0x%x, block 0x%llx\n", res, index, start, offset,
 			*block);
 
@@ -450,7 +450,36 @@ static int squashfs_readpage_sparse(struct page *page, int index, int file_end)
 	return 0;
 }
 
-static int squashfs_readpage(struct file *file, struct page *page)
+/*
+ * Get the locked page cache page at @index for filling in.  If one of the
+ * pages handed in by readahead has that index it is used, otherwise a page
+ * is grabbed from the page cache without blocking.  Returns NULL if no page
+ * could be had, in which case the caller skips it.
+ */
+struct page *squashfs_grab_page(struct address_space *mapping,
+	struct list_head *readahead, pgoff_t index)
+{
+	struct page *page;
+
+	if (readahead) {
+		list_for_each_entry(page, readahead, lru) {
+			if (page->index != index)
+				continue;
+
+			list_del(&page->lru);
+			if (!add_to_page_cache_lru(page, mapping, index,
+							GFP_KERNEL))
+				return page;
+
+			page_cache_release(page);
+			break;
+		}
+	}
+
+	return grab_cache_page_nowait(mapping, index);
+}
+
+static int __squashfs_readpage(struct page *page, struct list_head *readahead)
 {
 	struct inode *inode = page->mapping->host;
 	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
@@ -469,14 +498,15 @@ static int squashfs_readpage(struct file *file, struct page *page)
 	if (index < file_end || squashfs_i(inode)->fragment_block ==
 					SQUASHFS_INVALID_BLK) {
 		u64 block = 0;
-		int bsize = read_blocklist(inode, index, &block);
+		int bsize = squashfs_read_blocklist(inode, index, &block);
 		if (bsize < 0)
 			goto error_out;
 
 		if (bsize == 0)
 			res = squashfs_readpage_sparse(page, index, file_end);
 		else
-			res = squashfs_readpage_block(page, block, bsize);
+			res = squashfs_readpage_block(page, block, bsize,
+								readahead);
 	} else
 		res = squashfs_readpage_fragment(page);
 
@@ -497,7 +527,38 @@ out:
 	return 0;
 }
 
+static int squashfs_readpage(struct file *file, struct page *page)
+{
+	return __squashfs_readpage(page, NULL);
+}
+
+/*
+ * Readahead hands in a list of pages not yet in the page cache.  Rather than
+ * adding and reading them one at a time, which makes each datablock read
+ * allocate its pages afresh, the pages are given to the datablock read so it
+ * can decompress straight into them.  The list is in reverse index order.
+ */
+static int squashfs_readpages(struct file *file, struct address_space *mapping,
+	struct list_head *pages, unsigned nr_pages)
+{
+	struct page *page;
+
+	while (!list_empty(pages)) {
+		page = list_entry(pages->prev, struct page, lru);
+		list_del(&page->lru);
+
+		if (!add_to_page_cache_lru(page, mapping, page->index,
+							GFP_KERNEL))
+			__squashfs_readpage(page, pages);
+
+		page_cache_release(page);
+	}
+
+	return 0;
+}
+
 
 const struct address_space_operations squashfs_aops = {
-	.readpage = squashfs_readpage
+	.readpage = squashfs_readpage,
+	.readpages = squashfs_readpages
 };
@@ -23,8 +23,12 @@
 static int squashfs_read_cache(struct page *target_page, u64 block, int bsize,
 	int pages, struct page **page);
 
-/* Read separately compressed datablock directly into page cache */
-int squashfs_readpage_block(struct page *target_page, u64 block, int bsize)
+/*
+ * Read separately compressed datablock directly into page cache.  Pages
+ * of the datablock that are on the @readahead list are used in place.
+ */
+int squashfs_readpage_block(struct page *target_page, u64 block, int bsize,
+	struct list_head *readahead)
 
 {
 	struct inode *inode = target_page->mapping->host;
@@ -59,7 +63,7 @@ int squashfs_readpage_block(struct page *target_page, u64 block, int bsize)
 	/* Try to grab all the pages covered by the Squashfs block */
 	for (missing_pages = 0, i = 0, n = start_index; i < pages; i++, n++) {
 		page[i] = (n == target_page->index) ? target_page :
-			grab_cache_page_nowait(target_page->mapping, n);
+			squashfs_grab_page(target_page->mapping, readahead, n);
 
 		if (page[i] == NULL) {
 			missing_pages++;
@@ -48,6 +48,19 @@
 #include "squashfs.h"
 #include "xattr.h"
 
+/*
+ * Regular files of a filesystem mounted with the xip option are mapped
+ * straight from the device where possible.
+ */
+static const struct file_operations *squashfs_file_fops(struct super_block *sb)
+{
+	struct squashfs_sb_info *msblk = sb->s_fs_info;
+
+	if (IS_ENABLED(CONFIG_SQUASHFS_XIP) && msblk->xip)
+		return &squashfs_xip_file_ops;
+	return &generic_ro_fops;
+}
+
 /*
  * Initialise VFS inode with the base inode information common to all
  * Squashfs inode types.  Sqsh_ino contains the unswapped base inode
@@ -165,7 +178,7 @@ int squashfs_read_inode(struct inode *inode, long long ino)
 
 		set_nlink(inode, 1);
 		inode->i_size = le32_to_cpu(sqsh_ino->file_size);
-		inode->i_fop = &generic_ro_fops;
+		inode->i_fop = squashfs_file_fops(sb);
 		inode->i_mode |= S_IFREG;
 		inode->i_blocks = ((inode->i_size - 1) >> 9) + 1;
 		squashfs_i(inode)->fragment_block = frag_blk;
@@ -210,7 +223,7 @@ int squashfs_read_inode(struct inode *inode, long long ino)
 		set_nlink(inode, le32_to_cpu(sqsh_ino->nlink));
 		inode->i_size = le64_to_cpu(sqsh_ino->file_size);
 		inode->i_op = &squashfs_inode_ops;
-		inode->i_fop = &generic_ro_fops;
+		inode->i_fop = squashfs_file_fops(sb);
 		inode->i_mode |= S_IFREG;
 		inode->i_blocks = (inode->i_size -
 				le64_to_cpu(sqsh_ino->sparse) + 511) >> 9;
@@ -32,11 +32,14 @@ struct squashfs_cache {
 	int			next_blk;
 	int			num_waiters;
 	int			unused;
+	int			reserved;
+	int			populated;
 	int			block_size;
 	int			pages;
 	spinlock_t		lock;
 	wait_queue_head_t	wait_queue;
 	struct squashfs_cache_entry *entry;
+	struct shrinker		shrinker;
 };
 
 struct squashfs_cache_entry {
@@ -76,5 +79,8 @@ struct squashfs_sb_info {
 	long long				bytes_used;
 	unsigned int				inodes;
 	int					xattr_ids;
+	int					meta_cache_entries;
+	int					frag_cache_entries;
+	int					xip;
 };
 #endif
@@ -36,6 +36,8 @@
 #include <linux/module.h>
 #include <linux/magic.h>
 #include <linux/xattr.h>
+#include <linux/parser.h>
+#include <linux/seq_file.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -74,6 +76,77 @@ static const struct squashfs_decompressor *supported_squashfs_filesystem(short
 }
 
 
+enum {
+	Opt_meta_cache,
+	Opt_frag_cache,
+	Opt_xip,
+	Opt_err,
+};
+
+static const match_table_t tokens = {
+	{Opt_meta_cache, "meta_cache=%u"},
+	{Opt_frag_cache, "frag_cache=%u"},
+	{Opt_xip, "xip"},
+	{Opt_err, NULL},
+};
+
+/*
+ * The meta_cache and frag_cache options set the number of entries the
+ * metadata and fragment caches may grow to.  The compiled in sizes stay
+ * allocated, entries beyond them are only filled while memory allows.
+ * The xip option maps uncompressed file pages straight from the device into
+ * userspace, it needs a device that supports direct access.
+ */
+static int squashfs_parse_options(struct squashfs_sb_info *msblk, char *options)
+{
+	substring_t args[MAX_OPT_ARGS];
+	char *p;
+	int n;
+
+	msblk->meta_cache_entries = SQUASHFS_CACHED_BLKS;
+	msblk->frag_cache_entries = SQUASHFS_CACHED_FRAGMENTS;
+
+	if (!options)
+		return 0;
+
+	while ((p = strsep(&options, ",")) != NULL) {
+		if (!*p)
+			continue;
+
+		switch (match_token(p, tokens, args)) {
+		case Opt_meta_cache:
+			if (match_int(&args[0], &n) || n < SQUASHFS_CACHED_BLKS ||
+					n > SQUASHFS_MAX_CACHE_ENTRIES) {
+				ERROR("Invalid meta_cache value\n");
+				return -EINVAL;
+			}
+			msblk->meta_cache_entries = n;
+			break;
+		case Opt_frag_cache:
+			if (match_int(&args[0], &n) || n < 1 ||
+					n > SQUASHFS_MAX_CACHE_ENTRIES) {
+				ERROR("Invalid frag_cache value\n");
+				return -EINVAL;
+			}
+			msblk->frag_cache_entries = n;
+			break;
+		case Opt_xip:
+			if (!IS_ENABLED(CONFIG_SQUASHFS_XIP)) {
+				ERROR("XIP support not built in\n");
+				return -EINVAL;
+			}
+			msblk->xip = 1;
+			break;
+		default:
+			ERROR("Unrecognized mount option \"%s\"\n", p);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+
 static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 {
 	struct squashfs_sb_info *msblk;
@@ -100,6 +173,24 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 
 	mutex_init(&msblk->meta_index_mutex);
 
+	err = squashfs_parse_options(msblk, data);
+	if (err)
+		goto failed_mount;
+
+	if (msblk->xip) {
+		const struct block_device_operations *ops =
+			sb->s_bdev->bd_disk->fops;
+		unsigned long pfn;
+		void *kaddr;
+
+		if (!ops->direct_access ||
+				ops->direct_access(sb->s_bdev, 0, &kaddr, &pfn)) {
+			ERROR("Device does not support XIP\n");
+			err = -EINVAL;
+			goto failed_mount;
+		}
+	}
+
 	/*
 	 * msblk->bytes_used is checked in squashfs_read_table to ensure reads
 	 * are not beyond filesystem end.  But as we're using
@@ -200,13 +291,15 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 	err = -ENOMEM;
 
 	msblk->block_cache = squashfs_cache_init("metadata",
-			SQUASHFS_CACHED_BLKS, SQUASHFS_METADATA_SIZE);
+			msblk->meta_cache_entries, SQUASHFS_CACHED_BLKS,
+			SQUASHFS_METADATA_SIZE);
 	if (msblk->block_cache == NULL)
 		goto failed_mount;
 
 	/* Allocate read_page block */
 	msblk->read_page = squashfs_cache_init("data",
-		squashfs_max_decompressors(), msblk->block_size);
+		squashfs_max_decompressors(), squashfs_max_decompressors(),
+		msblk->block_size);
 	if (msblk->read_page == NULL) {
 		ERROR("Failed to allocate read_page block\n");
 		goto failed_mount;
@@ -276,7 +369,8 @@ handle_fragments:
 		goto check_directory_table;
 
 	msblk->fragment_cache = squashfs_cache_init("fragment",
-		SQUASHFS_CACHED_FRAGMENTS, msblk->block_size);
+		msblk->frag_cache_entries, SQUASHFS_CACHED_FRAGMENTS,
+		msblk->block_size);
 	if (msblk->fragment_cache == NULL) {
 		err = -ENOMEM;
 		goto failed_mount;
@@ -369,6 +463,19 @@ static int squashfs_statfs(struct dentry *dentry, struct kstatfs *buf)
 }
 
 
+static int squashfs_show_options(struct seq_file *s, struct dentry *root)
+{
+	struct squashfs_sb_info *msblk = root->d_sb->s_fs_info;
+
+	if (msblk->meta_cache_entries != SQUASHFS_CACHED_BLKS)
+		seq_printf(s, ",meta_cache=%d", msblk->meta_cache_entries);
+	if (msblk->frag_cache_entries != SQUASHFS_CACHED_FRAGMENTS)
+		seq_printf(s, ",frag_cache=%d", msblk->frag_cache_entries);
+
+	return 0;
+}
+
+
 static int squashfs_remount(struct super_block *sb, int *flags, char *data)
 {
 	*flags |= MS_RDONLY;
@@ -495,6 +602,7 @@ static const struct super_operations squashfs_super_ops = {
 	.alloc_inode = squashfs_alloc_inode,
 	.destroy_inode = squashfs_destroy_inode,
 	.statfs = squashfs_statfs,
+	.show_options = squashfs_show_options,
 	.put_super = squashfs_put_super,
 	.remount_fs = squashfs_remount
 };
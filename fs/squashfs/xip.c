@@ -0,0 +1,124 @@
+/*
+ * Squashfs - a compressed read-only filesystem for Linux
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * xip.c
+ */
+
+/*
+ * Execute in place for filesystems on memory mapped flash.
+ *
+ * When mounted with the xip option, file mappings are populated straight
+ * from the flash for every page which is stored uncompressed, lies page
+ * aligned on the device and is entirely inside the file.  Everything else
+ * (compressed and sparse blocks, fragments and the partial page at the end
+ * of the file) goes through the page cache as usual, so a mapping may mix
+ * both kinds of pages.  read() always uses the page cache.
+ */
+
+#include <linux/fs.h>
+#include <linux/vfs.h>
+#include <linux/mm.h>
+#include <linux/blkdev.h>
+#include <linux/pagemap.h>
+
+#include "squashfs_fs.h"
+#include "squashfs_fs_sb.h"
+#include "squashfs_fs_i.h"
+#include "squashfs.h"
+
+/*
+ * Find the flash page backing page @pgoff of @inode.  Returns 0 and the pfn
+ * if the page can be mapped directly, or a non-zero value if it has to be
+ * read into the page cache.
+ */
+static int squashfs_xip_pfn(struct inode *inode, pgoff_t pgoff,
+	unsigned long *pfn)
+{
+	struct super_block *sb = inode->i_sb;
+	struct squashfs_sb_info *msblk = sb->s_fs_info;
+	int index = pgoff >> (msblk->block_log - PAGE_CACHE_SHIFT);
+	int offset = (pgoff << PAGE_CACHE_SHIFT) & (msblk->block_size - 1);
+	u64 block = 0;
+	void *kaddr;
+	int bsize;
+
+	if (((u64) pgoff + 1) << PAGE_CACHE_SHIFT > i_size_read(inode))
+		return -ERANGE;
+
+	/* The tail end of the file may be packed into a fragment */
+	if (index >= i_size_read(inode) >> msblk->block_log &&
+			squashfs_i(inode)->fragment_block !=
+			SQUASHFS_INVALID_BLK)
+		return -ERANGE;
+
+	bsize = squashfs_read_blocklist(inode, index, &block);
+	if (bsize <= 0 || SQUASHFS_COMPRESSED_BLOCK(bsize))
+		return -EINVAL;
+
+	if (offset + PAGE_CACHE_SIZE > SQUASHFS_COMPRESSED_SIZE_BLOCK(bsize))
+		return -EINVAL;
+
+	block += offset;
+	if (block & (PAGE_CACHE_SIZE - 1))
+		return -EINVAL;
+
+	return sb->s_bdev->bd_disk->fops->direct_access(sb->s_bdev, block >> 9,
+			&kaddr, pfn);
+}
+
+static int squashfs_xip_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
+{
+	struct inode *inode = file_inode(vma->vm_file);
+	unsigned long pfn;
+	int err;
+
+	if (squashfs_xip_pfn(inode, vmf->pgoff, &pfn))
+		return filemap_fault(vma, vmf);
+
+	err = vm_insert_mixed(vma, (unsigned long)vmf->virtual_address, pfn);
+	if (err == -ENOMEM)
+		return VM_FAULT_OOM;
+	/* -EBUSY means another thread mapped the page first */
+	if (err && err != -EBUSY)
+		return VM_FAULT_SIGBUS;
+
+	return VM_FAULT_NOPAGE;
+}
+
+static const struct vm_operations_struct squashfs_xip_vm_ops = {
+	.fault		= squashfs_xip_fault,
+	.remap_pages	= generic_file_remap_pages,
+};
+
+static int squashfs_xip_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	if ((vma->vm_flags & VM_SHARED) && (vma->vm_flags & VM_MAYWRITE))
+		return -EINVAL;
+
+	file_accessed(file);
+	vma->vm_ops = &squashfs_xip_vm_ops;
+	vma->vm_flags |= VM_MIXEDMAP;
+	return 0;
+}
+
+const struct file_operations squashfs_xip_file_ops = {
+	.llseek		= generic_file_llseek,
+	.read		= do_sync_read,
+	.aio_read	= generic_file_aio_read,
+	.mmap		= squashfs_xip_mmap,
+	.splice_read	= generic_file_splice_read,
+};
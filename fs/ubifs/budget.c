@@ -33,6 +33,7 @@
 #include "ubifs.h"
 #include <linux/writeback.h>
 #include <linux/math64.h>
+#include <trace/events/ubifs.h>
 
 /*
  * When pessimistic budget calculations say that there is no enough space,
@@ -439,6 +440,7 @@ int ubifs_budget_space(struct ubifs_info *c, struct ubifs_budget_req *req)
 {
 	int uninitialized_var(cmt_retries), uninitialized_var(wb_retries);
 	int err, idx_growth, data_growth, dd_growth, retried = 0;
+	ktime_t start;
 
 	ubifs_assert(req->new_page <= 1);
 	ubifs_assert(req->dirtied_page <= 1);
@@ -493,7 +495,9 @@ again:
 		return err;
 	}
 
+	start = ktime_get();
 	err = make_free_space(c);
+	trace_ubifs_budget_stall(c->vi.ubi_num, c->vi.vol_id, err, start);
 	cond_resched();
 	if (err == -EAGAIN) {
 		dbg_budg("try again");
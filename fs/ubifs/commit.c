@@ -48,6 +48,9 @@
 #include <linux/slab.h>
 #include "ubifs.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/ubifs.h>
+
 /*
  * nothing_to_commit - check if there is nothing to commit.
  * @c: UBIFS file-system description object
@@ -111,8 +114,10 @@ static int do_commit(struct ubifs_info *c)
 	int err, new_ltail_lnum, old_ltail_lnum, i;
 	struct ubifs_zbranch zroot;
 	struct ubifs_lp_stats lst;
+	ktime_t start = ktime_get();
 
 	dbg_cmt("start");
+	trace_ubifs_commit_start(c->vi.ubi_num, c->vi.vol_id);
 	ubifs_assert(!c->ro_media && !c->ro_mount);
 
 	if (c->ro_error) {
@@ -220,12 +225,14 @@ out_cancel:
 	wake_up(&c->cmt_wq);
 	dbg_cmt("commit end");
 	spin_unlock(&c->cs_lock);
+	trace_ubifs_commit_end(c->vi.ubi_num, c->vi.vol_id, 0, start);
 	return 0;
 
 out_up:
 	up_write(&c->commit_sem);
 out:
 	ubifs_err("commit failed, error %d", err);
+	trace_ubifs_commit_end(c->vi.ubi_num, c->vi.vol_id, err, start);
 	spin_lock(&c->cs_lock);
 	c->cmt_state = COMMIT_BROKEN;
 	wake_up(&c->cmt_wq);
@@ -272,6 +279,68 @@ out:
 	return 0;
 }
 
+/**
+ * bg_gc_needed - check whether to garbage-collect in background.
+ * @c: UBIFS file-system description object
+ *
+ * This function returns non-zero if there are less empty LEBs than the
+ * background garbage collection watermark and there is at least one LEB worth
+ * of dirty space to reclaim.
+ */
+static int bg_gc_needed(struct ubifs_info *c)
+{
+	int ret;
+
+	if (!c->bg_gc_wm || c->ro_error)
+		return 0;
+
+	spin_lock(&c->space_lock);
+	ret = c->lst.empty_lebs < c->bg_gc_wm &&
+	      c->lst.total_dirty + c->lst.total_dead >= c->leb_size;
+	spin_unlock(&c->space_lock);
+
+	return ret;
+}
+
+/**
+ * run_bg_gc - garbage-collect one LEB in background.
+ * @c: UBIFS file-system description object
+ *
+ * This function garbage-collects one LEB, so that writers find an empty LEB
+ * instead of having to run the garbage collector themselves. Returns non-zero
+ * if more background garbage collection is needed.
+ */
+static int run_bg_gc(struct ubifs_info *c)
+{
+	int err, lnum;
+
+	down_read(&c->commit_sem);
+	lnum = ubifs_garbage_collect(c, 1);
+	up_read(&c->commit_sem);
+
+	if (lnum == -EAGAIN) {
+		/* Commit first, then try again */
+		ubifs_request_bg_commit(c);
+		return 1;
+	}
+	if (lnum == -ENOSPC)
+		/* Nothing to collect, wait until something is written */
+		return 0;
+	if (lnum < 0) {
+		ubifs_ro_mode(c, lnum);
+		return 0;
+	}
+
+	dbg_cmt("background GC freed LEB %d", lnum);
+	err = ubifs_return_leb(c, lnum);
+	if (err) {
+		ubifs_ro_mode(c, err);
+		return 0;
+	}
+
+	return bg_gc_needed(c);
+}
+
 /**
  * ubifs_bg_thread - UBIFS background thread function.
  * @info: points to the file-system description object
@@ -279,19 +348,22 @@ out:
  * This function implements various file-system background activities:
  * o when a write-buffer timer expires it synchronizes the appropriate
  *   write-buffer;
- * o when the journal is about to be full, it starts in-advance commit.
+ * o when the journal is about to be full, it starts in-advance commit;
+ * o when there are less empty LEBs than the "bg_gc" mount option asks for,
+ *   it garbage-collects at most "bg_gc_rate" LEBs per second, while there is
+ *   no foreground I/O on the UBI device.
  *
- * Note, other stuff like background garbage collection may be added here in
- * future.
+ * All I/O of this thread counts as background I/O for UBI.
  */
 int ubifs_bg_thread(void *info)
 {
-	int err;
+	int err, gc_pending = 0;
 	struct ubifs_info *c = info;
 
 	ubifs_msg("background thread \"%s\" started, PID %d",
 		  c->bgt_name, current->pid);
 	set_freezable();
+	ubi_io_set_background();
 
 	while (1) {
 		if (kthread_should_stop())
@@ -310,7 +382,19 @@ int ubifs_bg_thread(void *info)
 			 */
 			if (kthread_should_stop())
 				break;
-			schedule();
+			if (!gc_pending) {
+				schedule();
+				continue;
+			}
+			/*
+			 * Collect garbage unless woken up for something else
+			 * or foreground I/O is going on, then try again later
+			 */
+			if (!schedule_timeout(max(HZ / c->bg_gc_rate, 1)) &&
+			    !ubi_io_busy(c->ubi)) {
+				ubi_io_throttle(c->ubi);
+				gc_pending = run_bg_gc(c);
+			}
 			continue;
 		} else
 			__set_current_state(TASK_RUNNING);
@@ -321,6 +405,7 @@ int ubifs_bg_thread(void *info)
 			ubifs_ro_mode(c, err);
 
 		run_bg_commit(c);
+		gc_pending = bg_gc_needed(c);
 		cond_resched();
 	}
 
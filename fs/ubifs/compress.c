@@ -28,6 +28,7 @@
  */
 
 #include <linux/crypto.h>
+#include <linux/percpu.h>
 #include "ubifs.h"
 
 /* Fake description object for the "none" compressor */
@@ -38,11 +39,8 @@ static struct ubifs_compressor none_compr = {
 };
 
 #ifdef CONFIG_UBIFS_FS_LZO
-static DEFINE_MUTEX(lzo_mutex);
-
 static struct ubifs_compressor lzo_compr = {
 	.compr_type = UBIFS_COMPR_LZO,
-	.comp_mutex = &lzo_mutex,
 	.name = "lzo",
 	.capi_name = "lzo",
 };
@@ -54,13 +52,8 @@ static struct ubifs_compressor lzo_compr = {
 #endif
 
 #ifdef CONFIG_UBIFS_FS_ZLIB
-static DEFINE_MUTEX(deflate_mutex);
-static DEFINE_MUTEX(inflate_mutex);
-
 static struct ubifs_compressor zlib_compr = {
 	.compr_type = UBIFS_COMPR_ZLIB,
-	.comp_mutex = &deflate_mutex,
-	.decomp_mutex = &inflate_mutex,
 	.name = "zlib",
 	.capi_name = "deflate",
 };
@@ -71,6 +64,19 @@ static struct ubifs_compressor zlib_compr = {
 };
 #endif
 
+#ifdef CONFIG_UBIFS_FS_LZ4
+static struct ubifs_compressor lz4_compr = {
+	.compr_type = UBIFS_COMPR_LZ4,
+	.name = "lz4",
+	.capi_name = "lz4",
+};
+#else
+static struct ubifs_compressor lz4_compr = {
+	.compr_type = UBIFS_COMPR_LZ4,
+	.name = "lz4",
+};
+#endif
+
 /* All UBIFS compressors */
 struct ubifs_compressor *ubifs_compressors[UBIFS_COMPR_TYPES_CNT];
 
@@ -105,12 +111,9 @@ void ubifs_compress(const void *in_buf, int in_len, void *out_buf, int *out_len,
 	if (in_len < UBIFS_MIN_COMPR_LEN)
 		goto no_compr;
 
-	if (compr->comp_mutex)
-		mutex_lock(compr->comp_mutex);
-	err = crypto_comp_compress(compr->cc, in_buf, in_len, out_buf,
-				   (unsigned int *)out_len);
-	if (compr->comp_mutex)
-		mutex_unlock(compr->comp_mutex);
+	err = crypto_comp_compress(*get_cpu_ptr(compr->cc), in_buf, in_len,
+				   out_buf, (unsigned int *)out_len);
+	put_cpu_ptr(compr->cc);
 	if (unlikely(err)) {
 		ubifs_warn("cannot compress %d bytes, compressor %s, error %d, leave data uncompressed",
 			   in_len, compr->name, err);
@@ -168,12 +171,9 @@ int ubifs_decompress(const void *in_buf, int in_len, void *out_buf,
 		return 0;
 	}
 
-	if (compr->decomp_mutex)
-		mutex_lock(compr->decomp_mutex);
-	err = crypto_comp_decompress(compr->cc, in_buf, in_len, out_buf,
-				     (unsigned int *)out_len);
-	if (compr->decomp_mutex)
-		mutex_unlock(compr->decomp_mutex);
+	err = crypto_comp_decompress(*get_cpu_ptr(compr->cc), in_buf, in_len,
+				     out_buf, (unsigned int *)out_len);
+	put_cpu_ptr(compr->cc);
 	if (err)
 		ubifs_err("cannot decompress %d bytes, compressor %s, error %d",
 			  in_len, compr->name, err);
@@ -181,21 +181,55 @@ int ubifs_decompress(const void *in_buf, int in_len, void *out_buf,
 	return err;
 }
 
+/**
+ * compr_exit - de-initialize a compressor.
+ * @compr: compressor description object
+ */
+static void compr_exit(struct ubifs_compressor *compr)
+{
+	struct crypto_comp *cc;
+	int cpu;
+
+	if (!compr->capi_name || !compr->cc)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		cc = *per_cpu_ptr(compr->cc, cpu);
+		if (cc)
+			crypto_free_comp(cc);
+	}
+
+	free_percpu(compr->cc);
+	compr->cc = NULL;
+}
+
 /**
  * compr_init - initialize a compressor.
  * @compr: compressor description object
  *
  * This function initializes the requested compressor and returns zero in case
- * of success or a negative error code in case of failure.
+ * of success or a negative error code in case of failure. A compressor handle
+ * is allocated for every possible CPU.
  */
 static int __init compr_init(struct ubifs_compressor *compr)
 {
+	struct crypto_comp *cc;
+	int cpu;
+
 	if (compr->capi_name) {
-		compr->cc = crypto_alloc_comp(compr->capi_name, 0, 0);
-		if (IS_ERR(compr->cc)) {
-			ubifs_err("cannot initialize compressor %s, error %ld",
-				  compr->name, PTR_ERR(compr->cc));
-			return PTR_ERR(compr->cc);
+		compr->cc = alloc_percpu(struct crypto_comp *);
+		if (!compr->cc)
+			return -ENOMEM;
+
+		for_each_possible_cpu(cpu) {
+			cc = crypto_alloc_comp(compr->capi_name, 0, 0);
+			if (IS_ERR(cc)) {
+				ubifs_err("cannot initialize compressor %s, error %ld",
+					  compr->name, PTR_ERR(cc));
+				compr_exit(compr);
+				return PTR_ERR(cc);
+			}
+			*per_cpu_ptr(compr->cc, cpu) = cc;
 		}
 	}
 
@@ -203,17 +237,6 @@ static int __init compr_init(struct ubifs_compressor *compr)
 	return 0;
 }
 
-/**
- * compr_exit - de-initialize a compressor.
- * @compr: compressor description object
- */
-static void compr_exit(struct ubifs_compressor *compr)
-{
-	if (compr->capi_name)
-		crypto_free_comp(compr->cc);
-	return;
-}
-
 /**
  * ubifs_compressors_init - initialize UBIFS compressors.
  *
@@ -232,9 +255,15 @@ int __init ubifs_compressors_init(void)
 	if (err)
 		goto out_lzo;
 
+	err = compr_init(&lz4_compr);
+	if (err)
+		goto out_zlib;
+
 	ubifs_compressors[UBIFS_COMPR_NONE] = &none_compr;
 	return 0;
 
+out_zlib:
+	compr_exit(&zlib_compr);
 out_lzo:
 	compr_exit(&lzo_compr);
 	return err;
@@ -247,4 +276,5 @@ void ubifs_compressors_exit(void)
 {
 	compr_exit(&lzo_compr);
 	compr_exit(&zlib_compr);
+	compr_exit(&lz4_compr);
 }
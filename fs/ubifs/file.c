@@ -817,8 +817,12 @@ out_bu_off:
  * bulk-read facility is designed to take advantage of that, by reading in one
  * go consecutive data nodes that are also located consecutively in the same
  * LEB. This function returns %1 if a bulk-read is done and %0 otherwise.
+ *
+ * If @readahead is non-zero, the page is part of a readahead window and the
+ * access pattern is known to be sequential, so bulk-read is switched on right
+ * away instead of after three reads in a row.
  */
-static int ubifs_bulk_read(struct page *page)
+static int ubifs_bulk_read(struct page *page, int readahead)
 {
 	struct inode *inode = page->mapping->host;
 	struct ubifs_info *c = inode->i_sb->s_fs_info;
@@ -838,7 +842,9 @@ static int ubifs_bulk_read(struct page *page)
 	if (!mutex_trylock(&ui->ui_mutex))
 		return 0;
 
-	if (index != last_page_read + 1) {
+	if (readahead)
+		ui->bulk_read = 1;
+	else if (index != last_page_read + 1) {
 		/* Turn off bulk-read if we stop reading sequentially */
 		ui->read_in_a_row = 1;
 		if (ui->bulk_read)
@@ -886,13 +892,57 @@ out_unlock:
 
 static int ubifs_readpage(struct file *file, struct page *page)
 {
-	if (ubifs_bulk_read(page))
+	if (ubifs_bulk_read(page, 0))
 		return 0;
 	do_readpage(page);
 	unlock_page(page);
 	return 0;
 }
 
+/*
+ * Read a readahead window. Every page is inserted into the page cache only
+ * when we get to it, because bulk-read populates the pages following the one
+ * it was started for by itself. Those pages then fail to be inserted and are
+ * dropped, but the readahead marker has to be moved over to the cached page,
+ * otherwise the next window would not be started asynchronously.
+ */
+static int ubifs_readpages(struct file *file, struct address_space *mapping,
+			   struct list_head *pages, unsigned nr_pages)
+{
+	struct ubifs_info *c = mapping->host->i_sb->s_fs_info;
+	unsigned int page_idx;
+	struct page *cached;
+
+	/*
+	 * Throttle before any of the pages is locked and visible in the page
+	 * cache, other tasks may be waiting for them. '->readpage()' is called
+	 * with the page locked and is never throttled.
+	 */
+	ubi_io_throttle(c->ubi);
+
+	for (page_idx = 0; page_idx < nr_pages; page_idx++) {
+		struct page *page = list_entry(pages->prev, struct page, lru);
+
+		list_del(&page->lru);
+		if (!add_to_page_cache_lru(page, mapping, page->index,
+					   GFP_NOFS)) {
+			if (!ubifs_bulk_read(page, 1)) {
+				do_readpage(page);
+				unlock_page(page);
+			}
+		} else if (PageReadahead(page)) {
+			cached = find_get_page(mapping, page->index);
+			if (cached) {
+				SetPageReadahead(cached);
+				page_cache_release(cached);
+			}
+		}
+		page_cache_release(page);
+	}
+
+	return 0;
+}
+
 static int do_writepage(struct page *page, int len)
 {
 	int err = 0, i, blen;
@@ -1321,6 +1371,8 @@ int ubifs_fsync(struct file *file, loff_t start, loff_t end, int datasync)
 		 */
 		return 0;
 
+	ubi_io_throttle(c->ubi);
+
 	err = filemap_write_and_wait_range(inode->i_mapping, start, end);
 	if (err)
 		return err;
@@ -1537,6 +1589,7 @@ out_unlock:
 
 static const struct vm_operations_struct ubifs_file_vm_ops = {
 	.fault        = filemap_fault,
+	.map_pages    = filemap_map_pages,
 	.page_mkwrite = ubifs_vm_page_mkwrite,
 	.remap_pages = generic_file_remap_pages,
 };
@@ -1554,6 +1607,7 @@ static int ubifs_file_mmap(struct file *file, struct vm_area_struct *vma)
 
 const struct address_space_operations ubifs_file_address_operations = {
 	.readpage       = ubifs_readpage,
+	.readpages      = ubifs_readpages,
 	.writepage      = ubifs_writepage,
 	.write_begin    = ubifs_write_begin,
 	.write_end      = ubifs_write_end,
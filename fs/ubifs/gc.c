@@ -57,6 +57,7 @@
 #include <linux/pagemap.h>
 #include <linux/list_sort.h>
 #include "ubifs.h"
+#include <trace/events/ubifs.h>
 
 /*
  * GC may need to move more than one LEB to make progress. The below constants
@@ -650,6 +651,7 @@ int ubifs_garbage_collect(struct ubifs_info *c, int anyway)
 	int i, err, ret, min_space = c->dead_wm;
 	struct ubifs_lprops lp;
 	struct ubifs_wbuf *wbuf = &c->jheads[GCHD].wbuf;
+	ktime_t start;
 
 	ubifs_assert_cmt_locked(c);
 	ubifs_assert(!c->ro_media && !c->ro_mount);
@@ -658,6 +660,8 @@ int ubifs_garbage_collect(struct ubifs_info *c, int anyway)
 		return -EAGAIN;
 
 	mutex_lock_nested(&wbuf->io_mutex, wbuf->jhead);
+	start = ktime_get();
+	trace_ubifs_gc_start(c->vi.ubi_num, c->vi.vol_id);
 
 	if (c->ro_error) {
 		ret = -EROFS;
@@ -812,6 +816,7 @@ int ubifs_garbage_collect(struct ubifs_info *c, int anyway)
 		goto out;
 	}
 out_unlock:
+	trace_ubifs_gc_end(c->vi.ubi_num, c->vi.vol_id, ret, start);
 	mutex_unlock(&wbuf->io_mutex);
 	return ret;
 
@@ -820,6 +825,7 @@ out:
 	ubifs_assert(ret != -ENOSPC && ret != -EAGAIN);
 	ubifs_wbuf_sync_nolock(wbuf);
 	ubifs_ro_mode(c, ret);
+	trace_ubifs_gc_end(c->vi.ubi_num, c->vi.vol_id, ret, start);
 	mutex_unlock(&wbuf->io_mutex);
 	ubifs_return_leb(c, lp.lnum);
 	return ret;
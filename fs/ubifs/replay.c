@@ -1024,6 +1024,17 @@ int ubifs_replay_journal(struct ubifs_info *c)
 
 	dbg_mnt("start replaying the journal");
 	c->replaying = 1;
+
+	/*
+	 * Replay looks up lots of keys, and the index nodes it has to read
+	 * for that tend to be close to each other. The index does not change
+	 * on the media until the first commit, so it is safe to read it in
+	 * bigger chunks and keep the last one around. This is only an
+	 * optimization, so do not fail if the buffer cannot be allocated.
+	 */
+	c->idx_ra_buf = kmalloc(ALIGN(UBIFS_IDX_RA_SIZE, c->min_io_size),
+				GFP_KERNEL | __GFP_NOWARN);
+	c->idx_ra_lnum = -1;
 	lnum = c->ltail_lnum = c->lhead_lnum;
 
 	do {
@@ -1062,6 +1073,8 @@ int ubifs_replay_journal(struct ubifs_info *c)
 		c->lhead_lnum, c->lhead_offs, c->max_sqnum,
 		(unsigned long)c->highest_inum);
 out:
+	kfree(c->idx_ra_buf);
+	c->idx_ra_buf = NULL;
 	destroy_replay_list(c);
 	destroy_bud_list(c);
 	c->replaying = 0;
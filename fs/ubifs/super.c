@@ -443,6 +443,11 @@ static int ubifs_show_options(struct seq_file *s, struct dentry *root)
 			   ubifs_compr_name(c->mount_opts.compr_type));
 	}
 
+	if (c->bg_gc_wm)
+		seq_printf(s, ",bg_gc=%d", c->bg_gc_wm);
+	if (c->bg_gc_rate != UBIFS_BG_GC_RATE)
+		seq_printf(s, ",bg_gc_rate=%d", c->bg_gc_rate);
+
 	return 0;
 }
 
@@ -918,6 +923,9 @@ static int check_volume_empty(struct ubifs_info *c)
  * Opt_chk_data_crc: check CRCs when reading data nodes
  * Opt_no_chk_data_crc: do not check CRCs when reading data nodes
  * Opt_override_compr: override default compressor
+ * Opt_bg_gc: number of empty LEBs to maintain by background garbage collection
+ * Opt_bg_gc_rate: maximum number of LEBs to garbage-collect per second in
+ *                 background
  * Opt_err: just end of array marker
  */
 enum {
@@ -928,6 +936,8 @@ enum {
 	Opt_chk_data_crc,
 	Opt_no_chk_data_crc,
 	Opt_override_compr,
+	Opt_bg_gc,
+	Opt_bg_gc_rate,
 	Opt_err,
 };
 
@@ -939,6 +949,8 @@ static const match_table_t tokens = {
 	{Opt_chk_data_crc, "chk_data_crc"},
 	{Opt_no_chk_data_crc, "no_chk_data_crc"},
 	{Opt_override_compr, "compr=%s"},
+	{Opt_bg_gc, "bg_gc=%d"},
+	{Opt_bg_gc_rate, "bg_gc_rate=%d"},
 	{Opt_err, NULL},
 };
 
@@ -1028,6 +1040,8 @@ static int ubifs_parse_options(struct ubifs_info *c, char *options,
 				c->mount_opts.compr_type = UBIFS_COMPR_LZO;
 			else if (!strcmp(name, "zlib"))
 				c->mount_opts.compr_type = UBIFS_COMPR_ZLIB;
+			else if (!strcmp(name, "lz4"))
+				c->mount_opts.compr_type = UBIFS_COMPR_LZ4;
 			else {
 				ubifs_err("unknown compressor \"%s\"", name);
 				kfree(name);
@@ -1038,6 +1052,28 @@ static int ubifs_parse_options(struct ubifs_info *c, char *options,
 			c->default_compr = c->mount_opts.compr_type;
 			break;
 		}
+		case Opt_bg_gc:
+		{
+			int wm;
+
+			if (match_int(&args[0], &wm) || wm < 0) {
+				ubifs_err("bad background GC watermark");
+				return -EINVAL;
+			}
+			c->bg_gc_wm = wm;
+			break;
+		}
+		case Opt_bg_gc_rate:
+		{
+			int rate;
+
+			if (match_int(&args[0], &rate) || rate <= 0) {
+				ubifs_err("bad background GC rate");
+				return -EINVAL;
+			}
+			c->bg_gc_rate = rate;
+			break;
+		}
 		default:
 		{
 			unsigned long flag;
@@ -1978,6 +2014,7 @@ static struct ubifs_info *alloc_ubifs_info(struct ubi_volume_desc *ubi)
 		INIT_LIST_HEAD(&c->orph_list);
 		INIT_LIST_HEAD(&c->orph_new);
 		c->no_chk_data_crc = 1;
+		c->bg_gc_rate = UBIFS_BG_GC_RATE;
 
 		c->highest_inum = UBIFS_FIRST_INO;
 		c->lhead_lnum = c->ltail_lnum = UBIFS_LOG_LNUM;
@@ -256,6 +256,78 @@ long ubifs_destroy_tnc_subtree(struct ubifs_znode *znode)
 	}
 }
 
+/**
+ * read_idx_node - read an indexing node, using the replay read-ahead buffer.
+ * @c: UBIFS file-system description object
+ * @idx: buffer to read the node to
+ * @len: node length
+ * @lnum: LEB number of the node
+ * @offs: offset of the node
+ *
+ * During journal replay, index nodes are read in chunks of
+ * %UBIFS_IDX_RA_SIZE bytes which are kept in @c->idx_ra_buf, so that nearby
+ * index nodes do not have to be read from the media again. Otherwise, and if
+ * the node does not fit into a chunk, this is the same as 'ubifs_read_node()'.
+ * Returns zero in case of success and a negative error code in case of
+ * failure.
+ */
+static int read_idx_node(struct ubifs_info *c, struct ubifs_idx_node *idx,
+			 int len, int lnum, int offs)
+{
+	struct ubifs_ch *ch = &idx->ch;
+	int err, ra_offs, ra_len;
+
+	if (!c->idx_ra_buf)
+		return ubifs_read_node(c, idx, UBIFS_IDX_NODE, len, lnum, offs);
+
+	if (lnum != c->idx_ra_lnum || offs < c->idx_ra_offs ||
+	    offs + len > c->idx_ra_offs + c->idx_ra_len) {
+		ra_offs = round_down(offs, c->min_io_size);
+		ra_len = min(ALIGN(UBIFS_IDX_RA_SIZE, c->min_io_size),
+			     c->leb_size - ra_offs);
+		if (offs + len > ra_offs + ra_len)
+			return ubifs_read_node(c, idx, UBIFS_IDX_NODE, len,
+					       lnum, offs);
+
+		c->idx_ra_lnum = -1;
+		err = ubifs_leb_read(c, lnum, c->idx_ra_buf, ra_offs, ra_len, 0);
+		if (err && err != -EBADMSG)
+			return err;
+
+		c->idx_ra_lnum = lnum;
+		c->idx_ra_offs = ra_offs;
+		c->idx_ra_len = ra_len;
+	}
+
+	memcpy(idx, c->idx_ra_buf + offs - c->idx_ra_offs, len);
+
+	if (ch->node_type != UBIFS_IDX_NODE) {
+		ubifs_err("bad node type (%d but expected %d)",
+			  ch->node_type, UBIFS_IDX_NODE);
+		goto out;
+	}
+
+	err = ubifs_check_node(c, idx, lnum, offs, 0, 0);
+	if (err) {
+		ubifs_err("expected node type %d", UBIFS_IDX_NODE);
+		return err;
+	}
+
+	if (le32_to_cpu(ch->len) != len) {
+		ubifs_err("bad node length %d, expected %d",
+			  le32_to_cpu(ch->len), len);
+		goto out;
+	}
+
+	return 0;
+
+out:
+	ubifs_err("bad node at LEB %d:%d", lnum, offs);
+	ubifs_dump_node(c, idx);
+	dump_stack();
+	return -EINVAL;
+}
+
 /**
  * read_znode - read an indexing node from flash and fill znode.
  * @c: UBIFS file-system description object
@@ -280,7 +352,7 @@ static int read_znode(struct ubifs_info *c, int lnum, int offs, int len,
 	if (!idx)
 		return -ENOMEM;
 
-	err = ubifs_read_node(c, idx, UBIFS_IDX_NODE, len, lnum, offs);
+	err = read_idx_node(c, idx, len, lnum, offs);
 	if (err < 0) {
 		kfree(idx);
 		return err;
@@ -332,12 +332,18 @@ enum {
  * UBIFS_COMPR_NONE: no compression
  * UBIFS_COMPR_LZO: LZO compression
  * UBIFS_COMPR_ZLIB: ZLIB compression
+ * UBIFS_COMPR_LZ4: LZ4 compression
  * UBIFS_COMPR_TYPES_CNT: count of supported compression types
+ *
+ * Note, UBIFS_COMPR_LZ4 is private to this tree. Mainline UBIFS defines no
+ * LZ4 type and gives the value 3 to zstd, so media using it must be created
+ * with a matching mkfs.ubifs and can not be read by mainline kernels.
  */
 enum {
 	UBIFS_COMPR_NONE,
 	UBIFS_COMPR_LZO,
 	UBIFS_COMPR_ZLIB,
+	UBIFS_COMPR_LZ4,
 	UBIFS_COMPR_TYPES_CNT,
 };
 
@@ -157,7 +157,13 @@
 #define BOTTOM_UP_HEIGHT 64
 
 /* Maximum number of data nodes to bulk-read */
-#define UBIFS_MAX_BULK_READ 32
+#define UBIFS_MAX_BULK_READ 64
+
+/* How much of an index LEB to read at once during journal replay */
+#define UBIFS_IDX_RA_SIZE 8192
+
+/* Default maximum number of LEBs garbage-collected per second in background */
+#define UBIFS_BG_GC_RATE 10
 
 /*
  * Lockdep classes for UBIFS inode @ui_mutex.
@@ -818,17 +824,16 @@ struct ubifs_node_range {
 /**
  * struct ubifs_compressor - UBIFS compressor description structure.
  * @compr_type: compressor type (%UBIFS_COMPR_LZO, etc)
- * @cc: cryptoapi compressor handle
- * @comp_mutex: mutex used during compression
- * @decomp_mutex: mutex used during decompression
+ * @cc: per-CPU cryptoapi compressor handles
  * @name: compressor name
  * @capi_name: cryptoapi compressor name
+ *
+ * Every CPU has its own compressor handle, so compression and decompression
+ * on different CPUs do not serialize on each other.
  */
 struct ubifs_compressor {
 	int compr_type;
-	struct crypto_comp *cc;
-	struct mutex *comp_mutex;
-	struct mutex *decomp_mutex;
+	struct crypto_comp * __percpu *cc;
 	const char *name;
 	const char *capi_name;
 };
@@ -1022,6 +1027,10 @@ struct ubifs_debug_info;
  * @bulk_read: enable bulk-reads
  * @default_compr: default compression algorithm (%UBIFS_COMPR_LZO, etc)
  * @rw_incompat: the media is not R/W compatible
+ * @bg_gc_wm: the background thread garbage-collects while there are less
+ *            empty LEBs than this, %0 disables background garbage collection
+ * @bg_gc_rate: maximum number of LEBs to garbage-collect per second in
+ *              background
  *
  * @tnc_mutex: protects the Tree Node Cache (TNC), @zroot, @cnext, @enext, and
  *             @calc_idx_sz
@@ -1213,6 +1222,10 @@ struct ubifs_debug_info;
  * @replay_buds: list of buds to replay
  * @cs_sqnum: sequence number of first node in the log (commit start node)
  * @replay_sqnum: sequence number of node currently being replayed
+ * @idx_ra_buf: index read-ahead buffer, only used during journal replay
+ * @idx_ra_lnum: LEB number of the data in @idx_ra_buf, %-1 if none
+ * @idx_ra_offs: offset of the data in @idx_ra_buf
+ * @idx_ra_len: length of the data in @idx_ra_buf
  * @unclean_leb_list: LEBs to recover when re-mounting R/O mounted FS to R/W
  *                    mode
  * @rcvrd_mst_node: recovered master node to write when re-mounting R/O mounted
@@ -1262,6 +1275,8 @@ struct ubifs_info {
 	unsigned int bulk_read:1;
 	unsigned int default_compr:2;
 	unsigned int rw_incompat:1;
+	int bg_gc_wm;
+	int bg_gc_rate;
 
 	struct mutex tnc_mutex;
 	struct ubifs_zbranch zroot;
@@ -1443,6 +1458,10 @@ struct ubifs_info {
 	struct list_head replay_buds;
 	unsigned long long cs_sqnum;
 	unsigned long long replay_sqnum;
+	void *idx_ra_buf;
+	int idx_ra_lnum;
+	int idx_ra_offs;
+	int idx_ra_len;
 	struct list_head unclean_leb_list;
 	struct ubifs_mst_node *rcvrd_mst_node;
 	struct rb_root size_tree;
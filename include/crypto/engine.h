@@ -0,0 +1,101 @@
+/*
+ * Crypto engine API
+ *
+ * Queues asynchronous requests for a hardware crypto block and hands
+ * them to the driver in batches, so that the driver can chain several
+ * requests into one DMA descriptor list.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ */
+#ifndef _CRYPTO_ENGINE_H
+#define _CRYPTO_ENGINE_H
+
+#include <crypto/algapi.h>
+#include <crypto/hash.h>
+#include <linux/kthread.h>
+#include <linux/spinlock.h>
+
+#define ENGINE_NAME_LEN	30
+
+struct device;
+
+/**
+ * struct crypto_engine - crypto hardware engine
+ * @name: name of the engine, used for the kthread
+ * @dev: device the engine belongs to
+ * @queue_lock: protects the queue and the in-flight batch
+ * @queue: requests waiting for the hardware
+ * @running: the engine accepts and processes requests
+ * @idling: the hardware has been unprepared, or the engine is stopping
+ * @in_flight: requests of the current batch not yet finalized
+ * @max_batch: most requests handed to @do_batch at once
+ * @rt: run the kthread with realtime priority
+ * @prepare_crypt_hardware: called before the first batch after idling
+ * @unprepare_crypt_hardware: called once the queue has run empty
+ * @do_batch: start @nreqs requests on the hardware.  Each one must later
+ *	be passed to crypto_finalize_request().  If an error is returned,
+ *	none of them may have been started and the engine finalizes the
+ *	whole batch with it
+ * @kworker: kthread worker running @pump_requests
+ * @kworker_task: task of @kworker
+ * @pump_requests: work item feeding the hardware
+ * @priv_data: driver private data
+ * @batch: requests of the current batch
+ * @backlog: backlogged requests to notify when the batch is started
+ */
+struct crypto_engine {
+	char			name[ENGINE_NAME_LEN];
+	struct device		*dev;
+
+	spinlock_t		queue_lock;
+	struct crypto_queue	queue;
+
+	bool			running;
+	bool			idling;
+	unsigned int		in_flight;
+	unsigned int		max_batch;
+	bool			rt;
+
+	int (*prepare_crypt_hardware)(struct crypto_engine *engine);
+	int (*unprepare_crypt_hardware)(struct crypto_engine *engine);
+	int (*do_batch)(struct crypto_engine *engine,
+			struct crypto_async_request **reqs,
+			unsigned int nreqs);
+
+	struct kthread_worker	kworker;
+	struct task_struct	*kworker_task;
+	struct kthread_work	pump_requests;
+
+	void			*priv_data;
+	struct crypto_async_request **batch;
+	struct crypto_async_request **backlog;
+};
+
+struct crypto_engine *crypto_engine_alloc_init(struct device *dev, bool rt,
+					       unsigned int max_batch);
+int crypto_engine_start(struct crypto_engine *engine);
+int crypto_engine_stop(struct crypto_engine *engine);
+int crypto_engine_exit(struct crypto_engine *engine);
+
+int crypto_transfer_request_to_engine(struct crypto_engine *engine,
+				      struct crypto_async_request *req);
+void crypto_finalize_request(struct crypto_engine *engine,
+			     struct crypto_async_request *req, int err);
+
+static inline int crypto_transfer_ablkcipher_request_to_engine(
+	struct crypto_engine *engine, struct ablkcipher_request *req)
+{
+	return crypto_transfer_request_to_engine(engine, &req->base);
+}
+
+static inline int crypto_transfer_hash_request_to_engine(
+	struct crypto_engine *engine, struct ahash_request *req)
+{
+	return crypto_transfer_request_to_engine(engine, &req->base);
+}
+
+#endif /* _CRYPTO_ENGINE_H */
@@ -324,10 +324,17 @@ static inline void *shash_desc_ctx(struct shash_desc *desc)
 	return desc->__ctx;
 }
 
+#define SHASH_DESC_ON_STACK(shash, ctx)					  \
+	char __##shash##_desc[sizeof(struct shash_desc) +		  \
+		crypto_shash_descsize(ctx)] CRYPTO_MINALIGN_ATTR;	  \
+	struct shash_desc *shash = (struct shash_desc *)__##shash##_desc
+
 int crypto_shash_setkey(struct crypto_shash *tfm, const u8 *key,
 			unsigned int keylen);
 int crypto_shash_digest(struct shash_desc *desc, const u8 *data,
 			unsigned int len, u8 *out);
+int crypto_shash_tfm_digest(struct crypto_shash *tfm, const u8 *data,
+			    unsigned int len, u8 *out);
 
 static inline int crypto_shash_export(struct shash_desc *desc, void *out)
 {
@@ -91,6 +91,16 @@ struct backing_dev_info {
 	struct fprop_local_percpu completions;
 	int dirty_exceeded;
 
+	/*
+	 * Read latency feedback for the flusher: while recent reads take
+	 * longer than @read_lat_target ms, writeback chunks are shrunk by
+	 * @wb_depth_shift and the flusher backs off between chunks.
+	 */
+	unsigned int read_lat_target;	/* 0 disables the feedback */
+	unsigned int read_lat_avg;	/* smoothed read latency in ms */
+	unsigned long read_lat_stamp;	/* jiffies of the last read sample */
+	unsigned int wb_depth_shift;
+
 	unsigned int min_ratio;
 	unsigned int max_ratio, max_prop_frac;
 
@@ -218,6 +228,29 @@ static inline unsigned long bdi_stat_error(struct backing_dev_info *bdi)
 int bdi_set_min_ratio(struct backing_dev_info *bdi, unsigned int min_ratio);
 int bdi_set_max_ratio(struct backing_dev_info *bdi, unsigned int max_ratio);
 
+void bdi_update_read_latency(struct backing_dev_info *bdi,
+			     unsigned long duration);
+
+/*
+ * Reads older than this no longer say anything about the device.
+ */
+#define BDI_READ_LAT_WINDOW	HZ
+
+static inline bool bdi_read_latency_exceeded(struct backing_dev_info *bdi)
+{
+	return bdi->read_lat_target &&
+	       bdi->read_lat_avg > bdi->read_lat_target &&
+	       time_before(jiffies, bdi->read_lat_stamp + BDI_READ_LAT_WINDOW);
+}
+
+static inline unsigned int bdi_wb_depth_shift(struct backing_dev_info *bdi)
+{
+	if (!bdi->read_lat_target ||
+	    time_after_eq(jiffies, bdi->read_lat_stamp + BDI_READ_LAT_WINDOW))
+		return 0;
+	return bdi->wb_depth_shift;
+}
+
 /*
  * Flags in backing_dev_info::capability
  *
@@ -0,0 +1,48 @@
+#ifndef _LINUX_BOOT_TIMELINE_H
+#define _LINUX_BOOT_TIMELINE_H
+
+/*
+ * Structured boot timeline, see kernel/boot_timeline.c.
+ */
+
+#include <linux/types.h>
+#include <linux/sched.h>
+
+enum boot_tl_type {
+	BOOT_TL_INITCALL,
+	BOOT_TL_PROBE,
+	BOOT_TL_ASYNC_WAIT,
+	BOOT_TL_FIRMWARE,
+	BOOT_TL_MOUNT_ROOT,
+	BOOT_TL_EXEC,
+	BOOT_TL_NR_TYPES,
+};
+
+#ifdef CONFIG_BOOT_TIMELINE
+extern bool boot_timeline_active;
+
+/* Returns the start stamp to pass to boot_timeline_end(), 0 if off. */
+static inline u64 boot_timeline_start(void)
+{
+	if (!boot_timeline_active)
+		return 0;
+	return local_clock() ? : 1;
+}
+
+extern __printf(3, 4)
+void boot_timeline_end(enum boot_tl_type type, u64 start,
+		       const char *fmt, ...);
+#else
+static inline u64 boot_timeline_start(void)
+{
+	return 0;
+}
+
+static inline __printf(3, 4)
+void boot_timeline_end(enum boot_tl_type type, u64 start,
+		       const char *fmt, ...)
+{
+}
+#endif
+
+#endif /* _LINUX_BOOT_TIMELINE_H */
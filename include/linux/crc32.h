@@ -11,6 +11,10 @@
 extern u32  crc32_le(u32 crc, unsigned char const *p, size_t len);
 extern u32  crc32_be(u32 crc, unsigned char const *p, size_t len);
 
+struct scatterlist;
+extern u32  crc32_le_sg(u32 crc, struct scatterlist *sgl, unsigned int nents,
+			size_t len);
+
 /**
  * crc32_le_combine - Combine two crc32 check values into one. For two
  * 		      sequences of bytes, seq1 and seq2 with lengths len1
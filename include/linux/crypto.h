@@ -499,6 +499,17 @@ static inline void crypto_free_tfm(struct crypto_tfm *tfm)
 
 int alg_test(const char *driver, const char *alg, u32 type, u32 mask);
 
+/*
+ * Scratch space for the request, IV and scatterlists of one operation.
+ * Synchronous transforms are handed a per-cpu buffer with bottom halves
+ * disabled until crypto_scratch_free(), everything else gets kmalloc().
+ */
+#define CRYPTO_SCRATCH_SIZE	1024
+
+void *crypto_scratch_alloc(struct crypto_tfm *tfm, unsigned int len,
+			   gfp_t gfp);
+void crypto_scratch_free(void *p);
+
 /*
  * Transform helpers which query the underlying algorithm.
  */
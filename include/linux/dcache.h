@@ -64,6 +64,7 @@ struct dentry_stat_t {
 	long dummy[2];
 };
 extern struct dentry_stat_t dentry_stat;
+extern unsigned long sysctl_negative_dentry_limit;
 
 /* Name hashing routines. Initial hash value */
 /* Hash courtesy of the R5 hash in reiserfs modulo sign bits */
@@ -221,6 +222,9 @@ struct dentry_operations {
 #define DCACHE_SYMLINK_TYPE		0x00300000 /* Symlink */
 #define DCACHE_FILE_TYPE		0x00400000 /* Other file type */
 
+#define DCACHE_NEGATIVE_LRU		0x00800000
+     /* negative dentry counted in sb->s_nr_negative_dentry */
+
 extern seqlock_t rename_lock;
 
 static inline int dname_external(const struct dentry *dentry)
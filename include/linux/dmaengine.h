@@ -202,6 +202,9 @@ enum dma_ctrl_flags {
  * command.
  * @FSLDMA_EXTERNAL_START: this command will put the Freescale DMA controller
  * into external start mode.
+ * @JZ4740_DMA_COALESCE: this command sets up completion coalescing on a JZ4740
+ * DMA channel. An additional argument of struct jz4740_dma_coalesce must be
+ * passed in with this command.
  */
 enum dma_ctrl_cmd {
 	DMA_TERMINATE_ALL,
@@ -209,6 +212,7 @@ enum dma_ctrl_cmd {
 	DMA_RESUME,
 	DMA_SLAVE_CONFIG,
 	FSLDMA_EXTERNAL_START,
+	JZ4740_DMA_COALESCE,
 };
 
 /**
@@ -240,12 +244,14 @@ typedef struct { DECLARE_BITMAP(bits, DMA_TX_TYPE_END); } dma_cap_mask_t;
  * struct dma_chan_percpu - the per-CPU part of struct dma_chan
  * @memcpy_count: transaction counter
  * @bytes_transferred: byte counter
+ * @busy_ns: time spent transferring, if accounted by the driver
  */
 
 struct dma_chan_percpu {
 	/* stats */
 	unsigned long memcpy_count;
 	unsigned long bytes_transferred;
+	u64 busy_ns;
 };
 
 /**
@@ -260,6 +266,8 @@ struct dma_chan_percpu {
  * @client_count: how many clients are using this channel
  * @table_count: number of appearances in the mem-to-mem allocation table
  * @private: private data for certain client-channel associations
+ * @client: device of the exclusive user, if it requested the channel by device
+ * @requester: code location that requested the channel exclusively
  */
 struct dma_chan {
 	struct dma_device *device;
@@ -275,6 +283,10 @@ struct dma_chan {
 	int client_count;
 	int table_count;
 	void *private;
+
+	/* debugfs */
+	struct device *client;
+	const void *requester;
 };
 
 /**
@@ -1116,6 +1128,7 @@ void dma_async_device_unregister(struct dma_device *device);
 void dma_run_dependencies(struct dma_async_tx_descriptor *tx);
 struct dma_chan *dma_get_slave_channel(struct dma_chan *chan);
 struct dma_chan *dma_get_any_slave_channel(struct dma_device *device);
+void dma_chan_account(struct dma_chan *chan, size_t bytes, u64 busy_ns);
 struct dma_chan *net_dma_find_channel(void);
 #define dma_request_channel(mask, x, y) __dma_request_channel(&(mask), x, y)
 #define dma_request_slave_channel_compat(mask, x, y, dev, name) \
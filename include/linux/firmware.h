@@ -46,6 +46,11 @@ int request_firmware_nowait(
 	const char *name, struct device *device, gfp_t gfp, void *context,
 	void (*cont)(const struct firmware *fw, void *context));
 
+int request_firmware_stream(const char *name, struct device *device,
+			    int (*consume)(void *context, const u8 *data,
+					   size_t len),
+			    void *context);
+
 void release_firmware(const struct firmware *fw);
 #else
 static inline int request_firmware(const struct firmware **fw,
@@ -62,6 +67,16 @@ static inline int request_firmware_nowait(
 	return -EINVAL;
 }
 
+static inline int request_firmware_stream(const char *name,
+					  struct device *device,
+					  int (*consume)(void *context,
+							 const u8 *data,
+							 size_t len),
+					  void *context)
+{
+	return -EINVAL;
+}
+
 static inline void release_firmware(const struct firmware *fw)
 {
 }
@@ -172,6 +172,8 @@ struct fsnotify_group {
 			spinlock_t	idr_lock;
 			struct idr      idr;
 			struct user_struct      *user;
+			atomic_t	q_bytes;	/* bytes read() would return */
+			unsigned int	max_bytes;	/* 0 means no limit */
 		} inotify_data;
 #endif
 #ifdef CONFIG_FANOTIFY
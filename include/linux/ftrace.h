@@ -825,6 +825,14 @@ enum ftrace_dump_mode;
 
 extern enum ftrace_dump_mode ftrace_dump_on_oops;
 
+struct trace_array;
+extern struct trace_array *trace_array_get_by_name(const char *name);
+extern void trace_array_put(struct trace_array *tr);
+extern void trace_array_dump(struct trace_array *tr,
+			     void (*write)(const char *buf, size_t len,
+					   void *data),
+			     void *data);
+
 extern void disable_trace_on_warning(void);
 extern int __disable_trace_on_warning;
 
@@ -68,4 +68,25 @@ static inline void exit_pi_state_list(struct task_struct *curr)
 {
 }
 #endif
+
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+extern void futex_mm_init(struct mm_struct *mm);
+extern void futex_mm_clone_thread(struct mm_struct *mm);
+extern void futex_mm_free(struct mm_struct *mm);
+extern int futex_hash_prctl(unsigned long cmd, unsigned long slots);
+#else
+static inline void futex_mm_init(struct mm_struct *mm)
+{
+}
+static inline void futex_mm_clone_thread(struct mm_struct *mm)
+{
+}
+static inline void futex_mm_free(struct mm_struct *mm)
+{
+}
+static inline int futex_hash_prctl(unsigned long cmd, unsigned long slots)
+{
+	return -EINVAL;
+}
+#endif
 #endif
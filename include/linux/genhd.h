@@ -78,6 +78,11 @@ struct partition {
 	__le32 nr_sects;		/* nr of sectors in partition */
 } __attribute__((packed));
 
+#ifdef CONFIG_BLK_DEV_LATENCY_HIST
+/* bucket n counts completions in [2^n, 2^(n+1)) us, the last is open */
+#define DISK_LAT_BUCKETS	24
+#endif
+
 struct disk_stats {
 	unsigned long sectors[2];	/* READs and WRITEs */
 	unsigned long ios[2];
@@ -85,6 +90,9 @@ struct disk_stats {
 	unsigned long ticks[2];
 	unsigned long io_ticks;
 	unsigned long time_in_queue;
+#ifdef CONFIG_BLK_DEV_LATENCY_HIST
+	unsigned long lat_hist[2][DISK_LAT_BUCKETS];
+#endif
 };
 
 #define PARTITION_META_INFO_VOLNAMELTH	64
@@ -632,6 +640,10 @@ extern ssize_t part_stat_show(struct device *dev,
 			      struct device_attribute *attr, char *buf);
 extern ssize_t part_inflight_show(struct device *dev,
 			      struct device_attribute *attr, char *buf);
+#ifdef CONFIG_BLK_DEV_LATENCY_HIST
+extern ssize_t part_latency_hist_show(struct device *dev,
+			      struct device_attribute *attr, char *buf);
+#endif
 #ifdef CONFIG_FAIL_MAKE_REQUEST
 extern ssize_t part_fail_show(struct device *dev,
 			      struct device_attribute *attr, char *buf);
@@ -22,6 +22,7 @@
 #include <linux/device.h>
 #include <linux/fs.h>
 #include <linux/timer.h>
+#include <linux/ktime.h>
 #include <linux/mod_devicetable.h>
 
 /**
@@ -115,6 +116,8 @@ struct input_value {
  * @num_vals: number of values queued in the current frame
  * @max_vals: maximum number of values queued in a frame
  * @vals: array of values queued in the current frame
+ * @timestamp: time the current frame was captured, as set by the driver
+ *	through input_set_timestamp(); zero if it was not set
  * @devres_managed: indicates that devices is managed with devres framework
  *	and needs not be explicitly unregistered or freed.
  */
@@ -186,6 +189,8 @@ struct input_dev {
 	unsigned int max_vals;
 	struct input_value *vals;
 
+	ktime_t timestamp;
+
 	bool devres_managed;
 };
 #define to_input_dev(d) container_of(d, struct input_dev, dev)
@@ -421,6 +426,21 @@ static inline void input_mt_sync(struct input_dev *dev)
 
 void input_set_capability(struct input_dev *dev, unsigned int type, unsigned int code);
 
+/**
+ * input_set_timestamp - set the capture time of the current frame
+ * @dev: the input device used by the driver
+ * @timestamp: CLOCK_MONOTONIC time, typically taken in the hard interrupt
+ *
+ * Handlers stamp the events of the frame with this time instead of the
+ * time they are reported at, which for devices read out from a threaded
+ * interrupt or after debouncing can be considerably later.  It is reset
+ * by input_sync().
+ */
+static inline void input_set_timestamp(struct input_dev *dev, ktime_t timestamp)
+{
+	dev->timestamp = timestamp;
+}
+
 /**
  * input_set_events_per_packet - tell handlers about the driver event rate
  * @dev: the input device used by the driver
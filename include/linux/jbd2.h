@@ -736,6 +736,8 @@ jbd2_time_diff(unsigned long start, unsigned long end)
  * @j_commit_interval: What is the maximum transaction lifetime before we begin
  *  a commit?
  * @j_commit_timer:  The timer used to wakeup the commit thread
+ * @j_commit_slack: How late the commit timer may fire, so that the client
+ *  can start the commit from its own writeback instead
  * @j_revoke_lock: Protect the revoke table
  * @j_revoke: The revoke table - maintains the list of revoked blocks in the
  *     current transaction.
@@ -743,6 +745,7 @@ jbd2_time_diff(unsigned long start, unsigned long end)
  * @j_wbuf: array of buffer_heads for jbd2_journal_commit_transaction
  * @j_wbufsize: maximum number of buffer_heads allowed in j_wbuf, the
  *	number that will fit in j_blocksize
+ * @j_align: preferred alignment of commits in the log, in journal blocks
  * @j_last_sync_writer: most recent pid which did a synchronous write
  * @j_history: Buffer storing the transactions statistics history
  * @j_history_max: Maximum number of transactions in the statistics history
@@ -934,6 +937,13 @@ struct journal_s
 	/* The timer used to wakeup the commit thread: */
 	struct timer_list	j_commit_timer;
 
+	/*
+	 * How much later than the commit interval the commit timer may fire.
+	 * Within this slack the client may start the commit itself, see
+	 * jbd2_journal_commit_due().
+	 */
+	unsigned long		j_commit_slack;
+
 	/*
 	 * The revoke table: maintains the list of revoked blocks in the
 	 * current transaction.  [j_revoke_lock]
@@ -948,6 +958,12 @@ struct journal_s
 	struct buffer_head	**j_wbuf;
 	int			j_wbufsize;
 
+	/*
+	 * Preferred alignment of commits in the log, in journal blocks, or
+	 * zero.  Typically the erase unit of the underlying flash device.
+	 */
+	unsigned int		j_align;
+
 	/*
 	 * this is the pid of hte last person to run a synchronous operation
 	 * through the journal
@@ -1224,6 +1240,10 @@ extern void	   jbd2_journal_write_revoke_records(journal_t *journal,
 						     transaction_t *transaction,
 						     struct list_head *log_bufs,
 						     int write_op);
+extern void	   jbd2_journal_align_log(journal_t *journal,
+					  transaction_t *transaction,
+					  struct list_head *log_bufs,
+					  int write_op);
 
 /* Recovery revoke support */
 extern int	jbd2_journal_set_revoke(journal_t *, unsigned long long, tid_t);
@@ -1241,6 +1261,7 @@ extern void	jbd2_clear_buffer_revoked_flags(journal_t *journal);
 
 int jbd2_log_start_commit(journal_t *journal, tid_t tid);
 int __jbd2_log_start_commit(journal_t *journal, tid_t tid);
+int jbd2_journal_commit_due(journal_t *journal);
 int jbd2_journal_start_commit(journal_t *journal, tid_t *tid);
 int jbd2_log_wait_commit(journal_t *journal, tid_t tid);
 int jbd2_complete_transaction(journal_t *journal, tid_t tid);
@@ -3,6 +3,40 @@
 #define __LINUX_JZ4740_ADC
 
 struct device;
+struct platform_device;
+
+/**
+ * struct jz4740_thermal_point - Point of a thermistor voltage curve
+ * @mv: Voltage at the ADCIN pin in millivolts
+ * @temp: Temperature in millidegrees Celsius
+ */
+struct jz4740_thermal_point {
+	unsigned int mv;
+	int temp;
+};
+
+/**
+ * struct jz4740_thermal_platform_data - Thermistor wired to the ADCIN pin
+ * @points: Voltage to temperature curve, sorted by increasing voltage
+ * @num_points: Number of entries in @points
+ * @passive_temp: Temperature above which the clocks get throttled
+ * @critical_temp: Temperature at which the system is shut down
+ */
+struct jz4740_thermal_platform_data {
+	const struct jz4740_thermal_point *points;
+	unsigned int num_points;
+	int passive_temp;
+	int critical_temp;
+};
+
+/**
+ * struct jz4740_adc_platform_data - JZ4740 ADC board configuration
+ * @thermal: If set, the ADCIN pin is used by the jz4740-thermal driver
+ *	instead of the jz4740-hwmon driver.
+ */
+struct jz4740_adc_platform_data {
+	const struct jz4740_thermal_platform_data *thermal;
+};
 
 /*
  * jz4740_adc_set_config - Configure a JZ4740 adc device
@@ -15,6 +49,16 @@ struct device;
 */
 int jz4740_adc_set_config(struct device *dev, uint32_t mask, uint32_t val);
 
+/*
+ * jz4740_adc_cell_trigger - Start another conversion on an enabled cell
+ * @pdev: Pointer to the JZ4740 ADC mfd cell device
+ *
+ * The engine enable bit clears itself once a conversion has finished. This
+ * function sets it again without touching the clock and is thus safe to be
+ * called from atomic context, as long as the cell has been enabled before.
+*/
+int jz4740_adc_cell_trigger(struct platform_device *pdev);
+
 #define JZ_ADC_CONFIG_SPZZ		BIT(31)
 #define JZ_ADC_CONFIG_EX_IN		BIT(30)
 #define JZ_ADC_CONFIG_DNUM_MASK		(0x7 << 16)
@@ -405,6 +405,10 @@ struct mm_struct {
 	spinlock_t			ioctx_lock;
 	struct kioctx_table __rcu	*ioctx_table;
 #endif
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+	/* Hash table for this mm's private futexes, or NULL */
+	struct futex_private_hash	*futex_phash;
+#endif
 #ifdef CONFIG_MM_OWNER
 	/*
 	 * "owner" points to a task that is regarded as the canonical
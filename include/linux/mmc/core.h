@@ -135,6 +135,8 @@ struct mmc_request {
 	struct completion	completion;
 	void			(*done)(struct mmc_request *);/* completion function */
 	struct mmc_host		*host;
+
+	ktime_t			start_time;	/* for the request latency */
 };
 
 struct mmc_card;
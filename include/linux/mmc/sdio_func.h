@@ -15,10 +15,12 @@
 #include <linux/device.h>
 #include <linux/mod_devicetable.h>
 
+#include <linux/mmc/host.h>
 #include <linux/mmc/pm.h>
 
 struct mmc_card;
 struct sdio_func;
+struct scatterlist;
 
 typedef void (sdio_irq_handler_t)(struct sdio_func *);
 
@@ -153,6 +155,29 @@ extern int sdio_memcpy_toio(struct sdio_func *func, unsigned int addr,
 extern int sdio_writesb(struct sdio_func *func, unsigned int addr,
 	void *src, int count);
 
+/*
+ * Queued IO_RW_EXTENDED transfers
+ *
+ * A request set up with sdio_init_ext_req() is handed to sdio_queue_ext_req(),
+ * which prepares it while the previously queued one is still on the bus.
+ * The caller keeps the request, and the buffers described by its
+ * scatterlist, alive until the request after it has been queued or
+ * sdio_finish_ext_reqs() has returned.  No other I/O may be done on the
+ * host before that.
+ */
+struct sdio_ext_req {
+	struct mmc_async_req	areq;
+	struct mmc_request	mrq;
+	struct mmc_command	cmd;
+	struct mmc_data		data;
+};
+
+extern int sdio_init_ext_req(struct sdio_func *func, struct sdio_ext_req *req,
+	int write, unsigned int addr, int incr_addr, struct scatterlist *sg,
+	unsigned int sg_len, unsigned int blocks);
+extern int sdio_queue_ext_req(struct sdio_func *func, struct sdio_ext_req *req);
+extern int sdio_finish_ext_reqs(struct sdio_func *func);
+
 extern unsigned char sdio_f0_readb(struct sdio_func *func,
 	unsigned int addr, int *err_ret);
 extern void sdio_f0_writeb(struct sdio_func *func, unsigned char b,
@@ -0,0 +1,71 @@
+/*
+ * Lockless multi-producer, single-consumer ring of fixed size records
+ *
+ * Producers may run on any CPU, in any context including hard interrupts,
+ * and never take a lock.  The consumer is either the kernel, reading
+ * records in batches, or a user space process which mmap()s the ring
+ * and follows the protocol in <uapi/linux/mpring.h>.
+ *
+ * Blocking readers and poll() are woken once watermark records, 1 by
+ * default, are queued.  Set it before the ring is in use.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#ifndef _LINUX_MPRING_H
+#define _LINUX_MPRING_H
+
+#include <linux/atomic.h>
+#include <linux/fs.h>
+#include <linux/miscdevice.h>
+#include <linux/mutex.h>
+#include <linux/wait.h>
+#include <uapi/linux/mpring.h>
+
+struct mpring {
+	struct mpring_header	*hdr;
+	void			*slots;
+	size_t			size;
+	u32			mask;
+	u32			record_size;
+	u32			slot_size;
+	unsigned int		watermark;
+	atomic_t		dropped;
+	wait_queue_head_t	wait;
+	struct mutex		read_mutex;
+};
+
+struct mpring *mpring_alloc(unsigned int nr_records, unsigned int record_size);
+void mpring_free(struct mpring *ring);
+void mpring_reset(struct mpring *ring);
+
+int mpring_write(struct mpring *ring, const void *rec);
+unsigned int mpring_read(struct mpring *ring, void *buf, unsigned int max);
+unsigned int mpring_consume(struct mpring *ring, unsigned int max);
+unsigned int mpring_count(struct mpring *ring);
+
+int mpring_mmap(struct mpring *ring, struct vm_area_struct *vma);
+
+/**
+ * struct mpring_miscdev - character device exporting a ring
+ * @misc: the misc device, fill in .name (and .minor, .mode if needed)
+ * @ring: the ring to export
+ * @open: optional, called on every open(), may refuse it
+ * @release: optional, called on the last close() of an open file
+ *
+ * read() copies out as many whole records as fit the buffer, blocking
+ * for the watermark unless O_NONBLOCK is set; poll(), a read-only mmap()
+ * and the MPRING_IOC_CONSUME ioctl are supported as well.
+ */
+struct mpring_miscdev {
+	struct miscdevice	misc;
+	struct mpring		*ring;
+	int			(*open)(struct mpring_miscdev *mdev);
+	void			(*release)(struct mpring_miscdev *mdev);
+};
+
+int mpring_misc_register(struct mpring_miscdev *mdev);
+void mpring_misc_deregister(struct mpring_miscdev *mdev);
+
+#endif /* _LINUX_MPRING_H */
@@ -101,6 +101,8 @@ extern int nand_unlock(struct mtd_info *mtd, loff_t ofs, uint64_t len);
 
 /* Extended commands for large page devices */
 #define NAND_CMD_READSTART	0x30
+#define NAND_CMD_READCACHESEQ	0x31
+#define NAND_CMD_READCACHEEND	0x3f
 #define NAND_CMD_RNDOUTSTART	0xE0
 #define NAND_CMD_CACHEDPROG	0x15
 
@@ -147,6 +149,8 @@ typedef enum {
 #define NAND_BUSWIDTH_16	0x00000002
 /* Chip has cache program function */
 #define NAND_CACHEPRG		0x00000008
+/* Chip has sequential cache read function */
+#define NAND_CACHERD		0x00000010
 /*
  * Chip requires ready check on read (for auto-incremented sequential read).
  * True only for small page devices; large page devices do not support
@@ -171,6 +175,7 @@ typedef enum {
 
 /* Macros to identify the above */
 #define NAND_HAS_CACHEPROG(chip) ((chip->options & NAND_CACHEPRG))
+#define NAND_HAS_CACHERD(chip) ((chip->options & NAND_CACHERD))
 #define NAND_HAS_SUBPAGE_READ(chip) ((chip->options & NAND_SUBPAGE_READ))
 
 /* Non chip related options */
@@ -190,6 +195,17 @@ typedef enum {
  * before calling nand_scan_tail.
  */
 #define NAND_BUSWIDTH_AUTO      0x00080000
+/*
+ * Use cache program and sequential cache read for reads and writes spanning
+ * multiple pages, if the chip supports them. Drivers setting this must not
+ * issue READ0 from their read_page method while a cache read is in progress.
+ */
+#define NAND_USE_CACHE_OPS	0x00100000
+
+#define NAND_USE_CACHEPROG(chip) \
+	(NAND_HAS_CACHEPROG(chip) && (chip->options & NAND_USE_CACHE_OPS))
+#define NAND_USE_CACHERD(chip) \
+	(NAND_HAS_CACHERD(chip) && (chip->options & NAND_USE_CACHE_OPS))
 
 /* Options set by nand scan */
 /* Nand scan has allocated controller struct */
@@ -225,7 +241,9 @@ struct nand_chip;
 /* ONFI subfeature parameters length */
 #define ONFI_SUBFEATURE_PARAM_LEN	4
 
-/* ONFI optional commands SET/GET FEATURES supported? */
+/* ONFI optional commands supported? */
+#define ONFI_OPT_CMD_PAGE_CACHE_PROG	(1 << 0)
+#define ONFI_OPT_CMD_READ_CACHE		(1 << 1)
 #define ONFI_OPT_CMD_SET_GET_FEATURES	(1 << 2)
 
 struct nand_onfi_params {
@@ -526,6 +544,8 @@ struct nand_buffers {
  * @onfi_params:	[INTERN] holds the ONFI page parameter when ONFI is
  *			supported, 0 otherwise.
  * @read_retries:	[INTERN] the number of read retry modes supported
+ * @cache_read:		[INTERN] a sequential cache read is in progress, the
+ *			page data has to be fetched without a new READ0.
  * @onfi_set_features:	[REPLACEABLE] set the features for ONFI nand
  * @onfi_get_features:	[REPLACEABLE] get the features for ONFI nand
  * @bbt:		[INTERN] bad block table pointer
@@ -600,6 +620,7 @@ struct nand_chip {
 	struct nand_onfi_params	onfi_params;
 
 	int read_retries;
+	int cache_read;
 
 	flstate_t state;
 
@@ -220,6 +220,9 @@ int ubi_leb_map(struct ubi_volume_desc *desc, int lnum);
 int ubi_is_mapped(struct ubi_volume_desc *desc, int lnum);
 int ubi_sync(int ubi_num);
 int ubi_flush(int ubi_num, int vol_id, int lnum);
+int ubi_io_busy(struct ubi_volume_desc *desc);
+void ubi_io_throttle(struct ubi_volume_desc *desc);
+void ubi_io_set_background(void);
 
 /*
  * This function is the same as the 'ubi_leb_read()' function, but it does not
@@ -73,6 +73,9 @@ struct mutex {
 struct mutex_waiter {
 	struct list_head	list;
 	struct task_struct	*task;
+#ifndef CONFIG_SMP
+	bool			handoff;	/* unlocker passed us the lock */
+#endif
 #ifdef CONFIG_DEBUG_MUTEXES
 	void			*magic;
 #endif
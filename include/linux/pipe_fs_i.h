@@ -32,7 +32,9 @@ struct pipe_buffer {
  *	@nrbufs: the number of non-empty pipe buffers in this pipe
  *	@buffers: total number of buffers (should be a power of 2)
  *	@curbuf: the current pipe buffer entry
- *	@tmp_page: cached released page
+ *	@tmp_pages: pool of released pages kept for the next write
+ *	@nr_tmp_pages: number of pages in @tmp_pages
+ *	@buf_order: allocation order of the buffers pipe_write() fills
  *	@readers: number of current readers of this pipe
  *	@writers: number of current writers of this pipe
  *	@files: number of struct file refering this pipe (protected by ->i_lock)
@@ -53,7 +55,9 @@ struct pipe_inode_info {
 	unsigned int waiting_writers;
 	unsigned int r_counter;
 	unsigned int w_counter;
-	struct page *tmp_page;
+	struct list_head tmp_pages;
+	unsigned int nr_tmp_pages;
+	unsigned int buf_order;
 	struct fasync_struct *fasync_readers;
 	struct fasync_struct *fasync_writers;
 	struct pipe_buffer *bufs;
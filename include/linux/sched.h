@@ -58,6 +58,7 @@ struct sched_param {
 #include <asm/processor.h>
 
 #define SCHED_ATTR_SIZE_VER0	48	/* sizeof first published struct */
+#define SCHED_ATTR_SIZE_VER1	56	/* add: sched_latency_nice */
 
 #define VMACACHE_BITS 2
 #define VMACACHE_SIZE (1U << VMACACHE_BITS)
@@ -98,6 +99,8 @@ struct sched_param {
  *  @sched_deadline	representative of the task's deadline
  *  @sched_runtime	representative of the task's runtime
  *  @sched_period	representative of the task's period
+ *  @sched_latency_nice	wakeup latency hint    (SCHED_NORMAL/BATCH),
+ *			only applied with SCHED_FLAG_LATENCY_NICE
  *
  * Given this task model, there are a multiplicity of scheduling algorithms
  * and policies, that can be used to ensure all the tasks will make their
@@ -123,6 +126,9 @@ struct sched_attr {
 	u64 sched_runtime;
 	u64 sched_deadline;
 	u64 sched_period;
+
+	/* SCHED_NORMAL, SCHED_BATCH */
+	s32 sched_latency_nice;
 };
 
 struct exec_domain;
@@ -130,6 +136,7 @@ struct futex_pi_state;
 struct robust_list_head;
 struct bio_list;
 struct fs_struct;
+struct poll_cache;
 struct perf_event_context;
 struct blk_plug;
 struct filename;
@@ -793,6 +800,23 @@ struct sched_info {
 };
 #endif /* defined(CONFIG_SCHEDSTATS) || defined(CONFIG_TASK_DELAY_ACCT) */
 
+#ifdef CONFIG_SCHED_LAT_HIST
+/*
+ * Wakeup-to-run latency histogram: bucket 0 counts waits below 1024ns,
+ * bucket i waits in [2^(9+i), 2^(10+i)) ns, the last one is open ended.
+ */
+#define SCHED_LAT_BUCKETS	20
+
+struct sched_lat_hist {
+	u64		wake_stamp;	/* rq clock at wakeup, 0 if none */
+	unsigned int	bucket[SCHED_LAT_BUCKETS];
+};
+
+extern void proc_sched_lat_show_task(struct task_struct *p,
+				     struct seq_file *m);
+extern void proc_sched_lat_reset_task(struct task_struct *p);
+#endif
+
 #ifdef CONFIG_TASK_DELAY_ACCT
 struct task_delay_info {
 	spinlock_t	lock;
@@ -1076,6 +1100,9 @@ struct sched_entity {
 
 	u64			nr_migrations;
 
+	/* [-20 .. 19], lower means woken up and preempting sooner */
+	int			latency_nice;
+
 #ifdef CONFIG_SCHEDSTATS
 	struct sched_statistics statistics;
 #endif
@@ -1221,6 +1248,9 @@ struct task_struct {
 #if defined(CONFIG_SCHEDSTATS) || defined(CONFIG_TASK_DELAY_ACCT)
 	struct sched_info sched_info;
 #endif
+#ifdef CONFIG_SCHED_LAT_HIST
+	struct sched_lat_hist lat_hist;
+#endif
 
 	struct list_head tasks;
 #ifdef CONFIG_SMP
@@ -1344,6 +1374,8 @@ struct task_struct {
 	struct fs_struct *fs;
 /* open file information */
 	struct files_struct *files;
+/* poll() wait entries kept between calls */
+	struct poll_cache *poll_cache;
 /* namespaces */
 	struct nsproxy *nsproxy;
 /* signal handlers */
@@ -1581,6 +1613,10 @@ struct task_struct {
 		unsigned int may_oom:1;
 	} memcg_oom;
 #endif
+#ifdef CONFIG_MMU
+	struct task_struct *oom_reaper_list;
+	u64 oom_kill_time;	/* local_clock() when OOM killed */
+#endif
 #ifdef CONFIG_UPROBES
 	struct uprobe_task *utask;
 #endif
@@ -2343,6 +2379,7 @@ extern int do_execve(struct filename *,
 		     const char __user * const __user *,
 		     const char __user * const __user *);
 extern long do_fork(unsigned long, unsigned long, unsigned long, int __user *, int __user *);
+extern long do_vfork_work(struct callback_head *);
 struct task_struct *fork_idle(int);
 extern pid_t kernel_thread(int (*fn)(void *), void *arg, unsigned long flags);
 
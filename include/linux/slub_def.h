@@ -83,6 +83,8 @@ struct kmem_cache {
 	struct list_head list;	/* List of slab caches */
 #ifdef CONFIG_SYSFS
 	struct kobject kobj;	/* For sysfs */
+	unsigned int profile_rate;	/* Sample 1 in profile_rate slowpaths */
+	struct slab_profile *profile;	/* Sampled slowpath callers */
 #endif
 #ifdef CONFIG_MEMCG_KMEM
 	struct memcg_cache_params *memcg_params;
@@ -179,6 +179,8 @@ extern int mod_timer_pinned(struct timer_list *timer, unsigned long expires);
 
 extern void set_timer_slack(struct timer_list *time, int slack_hz);
 
+extern unsigned int sysctl_timer_coalesce_ms;
+
 #define TIMER_NOT_PINNED	0
 #define TIMER_PINNED		1
 /*
@@ -9,6 +9,14 @@
 #include <linux/cgroup.h>
 #include <linux/eventfd.h>
 
+enum vmpressure_levels {
+	VMPRESSURE_LOW = 0,
+	VMPRESSURE_MEDIUM,
+	VMPRESSURE_SUSTAINED,
+	VMPRESSURE_CRITICAL,
+	VMPRESSURE_NUM_LEVELS,
+};
+
 struct vmpressure {
 	unsigned long scanned;
 	unsigned long reclaimed;
@@ -20,18 +28,35 @@ struct vmpressure {
 	/* Have to grab the lock on events traversal or modifications. */
 	struct mutex events_lock;
 
+	/*
+	 * The level last reported, when a window last reached it, and
+	 * since when the windows have been at medium or above, if they
+	 * are. Only the work updates them.
+	 */
+	enum vmpressure_levels level;
+	unsigned long level_stamp;
+	unsigned long medium_since;
+	bool medium;
+
 	struct work_struct work;
 };
 
 struct mem_cgroup;
 
-#ifdef CONFIG_MEMCG
+extern int vmpressure_level_med;
+extern int vmpressure_level_critical;
+extern int vmpressure_hysteresis_ms;
+extern int vmpressure_sustained_ms;
+extern int vmpressure_ratelimit_ms[VMPRESSURE_NUM_LEVELS];
+
 extern void vmpressure(gfp_t gfp, struct mem_cgroup *memcg,
 		       unsigned long scanned, unsigned long reclaimed);
 extern void vmpressure_prio(gfp_t gfp, struct mem_cgroup *memcg, int prio);
 
 extern void vmpressure_init(struct vmpressure *vmpr);
 extern void vmpressure_cleanup(struct vmpressure *vmpr);
+
+#ifdef CONFIG_MEMCG
 extern struct vmpressure *memcg_to_vmpressure(struct mem_cgroup *memcg);
 extern struct cgroup_subsys_state *vmpressure_to_css(struct vmpressure *vmpr);
 extern int vmpressure_register_event(struct mem_cgroup *memcg,
@@ -39,10 +64,5 @@ extern int vmpressure_register_event(struct mem_cgroup *memcg,
 				     const char *args);
 extern void vmpressure_unregister_event(struct mem_cgroup *memcg,
 					struct eventfd_ctx *eventfd);
-#else
-static inline void vmpressure(gfp_t gfp, struct mem_cgroup *memcg,
-			      unsigned long scanned, unsigned long reclaimed) {}
-static inline void vmpressure_prio(gfp_t gfp, struct mem_cgroup *memcg,
-				   int prio) {}
 #endif /* CONFIG_MEMCG */
 #endif /* __LINUX_VMPRESSURE_H */
@@ -78,6 +78,7 @@ struct Qdisc {
 	struct gnet_stats_rate_est64	rate_est;
 	struct Qdisc		*next_sched;
 	struct sk_buff		*gso_skb;
+	struct sk_buff		*gso_next_skb;	/* look-ahead skb behind gso_skb */
 	/*
 	 * For performance sake on SMP, we put highly modified fields at the end
 	 */
@@ -104,6 +104,23 @@ void snd_dmaengine_pcm_set_config_from_dai_data(
  * The PCM streams have custom channel names specified.
  */
 #define SND_DMAENGINE_PCM_FLAG_CUSTOM_CHANNEL_NAME BIT(4)
+/*
+ * The platforms dmaengine driver leaves out the period interrupts of a cyclic
+ * transfer prepared without DMA_PREP_INTERRUPT, so the PCM supports
+ * SNDRV_PCM_HW_PARAMS_NO_PERIOD_WAKEUP. Ignored with
+ * SND_DMAENGINE_PCM_FLAG_NO_RESIDUE, since the position is then only updated
+ * by the period interrupts.
+ */
+#define SND_DMAENGINE_PCM_FLAG_NO_PERIOD_WAKEUP BIT(5)
+/*
+ * The capture buffer is normal cached memory instead of a coherent DMA
+ * allocation, so the CPU and user space mappings of it read at full speed.
+ * The part of the buffer the DMA has filled is invalidated whenever the
+ * position is updated, which includes every period interrupt. Only for
+ * platforms whose data cache has no aliases, since the user space mapping is
+ * not invalidated separately.
+ */
+#define SND_DMAENGINE_PCM_FLAG_CACHED_CAPTURE BIT(6)
 
 /**
  * struct snd_dmaengine_pcm_config - Configuration data for dmaengine based PCM
@@ -0,0 +1,80 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM mmc
+
+#if !defined(_TRACE_MMC_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_MMC_H
+
+#include <linux/ktime.h>
+#include <linux/mmc/core.h>
+#include <linux/mmc/host.h>
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(mmc_request_start,
+
+	TP_PROTO(struct mmc_host *host, struct mmc_request *mrq),
+
+	TP_ARGS(host, mrq),
+
+	TP_STRUCT__entry(
+		__string(	name,		mmc_hostname(host)	)
+		__field(	u32,		opcode			)
+		__field(	u32,		arg			)
+		__field(	unsigned int,	blocks			)
+		__field(	unsigned int,	blksz			)
+		__field(	bool,		write			)
+		__field(	bool,		sbc			)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, mmc_hostname(host));
+		__entry->opcode = mrq->cmd->opcode;
+		__entry->arg = mrq->cmd->arg;
+		__entry->blocks = mrq->data ? mrq->data->blocks : 0;
+		__entry->blksz = mrq->data ? mrq->data->blksz : 0;
+		__entry->write = mrq->data &&
+			(mrq->data->flags & MMC_DATA_WRITE);
+		__entry->sbc = mrq->sbc != NULL;
+	),
+
+	TP_printk("%s: CMD%u arg %08x blocks %u blksz %u %s%s",
+		__get_str(name), __entry->opcode, __entry->arg,
+		__entry->blocks, __entry->blksz,
+		__entry->blocks ? (__entry->write ? "write" : "read") : "-",
+		__entry->sbc ? " sbc" : "")
+);
+
+TRACE_EVENT(mmc_request_done,
+
+	TP_PROTO(struct mmc_host *host, struct mmc_request *mrq),
+
+	TP_ARGS(host, mrq),
+
+	TP_STRUCT__entry(
+		__string(	name,		mmc_hostname(host)	)
+		__field(	u32,		opcode			)
+		__field(	int,		cmd_err			)
+		__field(	int,		data_err		)
+		__field(	unsigned int,	bytes_xfered		)
+		__field(	s64,		latency_us		)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, mmc_hostname(host));
+		__entry->opcode = mrq->cmd->opcode;
+		__entry->cmd_err = mrq->cmd->error;
+		__entry->data_err = mrq->data ? mrq->data->error : 0;
+		__entry->bytes_xfered = mrq->data ? mrq->data->bytes_xfered : 0;
+		__entry->latency_us = ktime_us_delta(ktime_get(),
+				mrq->start_time);
+	),
+
+	TP_printk("%s: CMD%u err %d data err %d bytes %u latency %lld us",
+		__get_str(name), __entry->opcode, __entry->cmd_err,
+		__entry->data_err, __entry->bytes_xfered,
+		(long long)__entry->latency_us)
+);
+
+#endif /* _TRACE_MMC_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
@@ -27,6 +27,35 @@ TRACE_EVENT(oom_score_adj_update,
 		__entry->pid, __entry->comm, __entry->oom_score_adj)
 );
 
+TRACE_EVENT(oom_reap_task,
+
+	TP_PROTO(struct task_struct *task, u64 delay_ns, unsigned long freed,
+		 bool reaped),
+
+	TP_ARGS(task, delay_ns, freed, reaped),
+
+	TP_STRUCT__entry(
+		__field(	pid_t,		pid)
+		__array(	char,		comm,	TASK_COMM_LEN )
+		__field(	u64,		delay_ns)
+		__field(	unsigned long,	freed)
+		__field(	bool,		reaped)
+	),
+
+	TP_fast_assign(
+		__entry->pid = task->pid;
+		memcpy(__entry->comm, task->comm, TASK_COMM_LEN);
+		__entry->delay_ns = delay_ns;
+		__entry->freed = freed;
+		__entry->reaped = reaped;
+	),
+
+	TP_printk("pid=%d comm=%s delay_us=%llu freed=%lu reaped=%d",
+		__entry->pid, __entry->comm,
+		(unsigned long long)__entry->delay_ns / NSEC_PER_USEC,
+		__entry->freed, __entry->reaped)
+);
+
 #endif
 
 /* This part must be outside protection */
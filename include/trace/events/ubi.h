@@ -0,0 +1,153 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM ubi
+
+#if !defined(_TRACE_UBI_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_UBI_H
+
+#include <linux/ktime.h>
+#include <linux/tracepoint.h>
+
+DECLARE_EVENT_CLASS(ubi_io,
+
+	TP_PROTO(int ubi_num, int pnum, int offset, int len, int err,
+		 ktime_t start),
+
+	TP_ARGS(ubi_num, pnum, offset, len, err, start),
+
+	TP_STRUCT__entry(
+		__field(	int,		ubi_num		)
+		__field(	int,		pnum		)
+		__field(	int,		offset		)
+		__field(	int,		len		)
+		__field(	int,		err		)
+		__field(	s64,		latency_us	)
+	),
+
+	TP_fast_assign(
+		__entry->ubi_num = ubi_num;
+		__entry->pnum = pnum;
+		__entry->offset = offset;
+		__entry->len = len;
+		__entry->err = err;
+		__entry->latency_us = ktime_us_delta(ktime_get(), start);
+	),
+
+	TP_printk("ubi%d PEB %d:%d len %d err %d latency %lld us",
+		  __entry->ubi_num, __entry->pnum, __entry->offset,
+		  __entry->len, __entry->err, (long long)__entry->latency_us)
+);
+
+DEFINE_EVENT(ubi_io, ubi_io_read,
+
+	TP_PROTO(int ubi_num, int pnum, int offset, int len, int err,
+		 ktime_t start),
+
+	TP_ARGS(ubi_num, pnum, offset, len, err, start)
+);
+
+DEFINE_EVENT(ubi_io, ubi_io_write,
+
+	TP_PROTO(int ubi_num, int pnum, int offset, int len, int err,
+		 ktime_t start),
+
+	TP_ARGS(ubi_num, pnum, offset, len, err, start)
+);
+
+TRACE_EVENT(ubi_io_erase,
+
+	TP_PROTO(int ubi_num, int pnum, int err, ktime_t start),
+
+	TP_ARGS(ubi_num, pnum, err, start),
+
+	TP_STRUCT__entry(
+		__field(	int,		ubi_num		)
+		__field(	int,		pnum		)
+		__field(	int,		err		)
+		__field(	s64,		latency_us	)
+	),
+
+	TP_fast_assign(
+		__entry->ubi_num = ubi_num;
+		__entry->pnum = pnum;
+		__entry->err = err;
+		__entry->latency_us = ktime_us_delta(ktime_get(), start);
+	),
+
+	TP_printk("ubi%d PEB %d err %d latency %lld us",
+		  __entry->ubi_num, __entry->pnum, __entry->err,
+		  (long long)__entry->latency_us)
+);
+
+TRACE_EVENT(ubi_wl_schedule,
+
+	TP_PROTO(int ubi_num, bool scrub),
+
+	TP_ARGS(ubi_num, scrub),
+
+	TP_STRUCT__entry(
+		__field(	int,		ubi_num		)
+		__field(	bool,		scrub		)
+	),
+
+	TP_fast_assign(
+		__entry->ubi_num = ubi_num;
+		__entry->scrub = scrub;
+	),
+
+	TP_printk("ubi%d %s", __entry->ubi_num,
+		  __entry->scrub ? "scrubbing" : "wear-leveling")
+);
+
+TRACE_EVENT(ubi_wl_move,
+
+	TP_PROTO(int ubi_num, const char *reason, int from_pnum, int from_ec,
+		 int to_pnum, int to_ec),
+
+	TP_ARGS(ubi_num, reason, from_pnum, from_ec, to_pnum, to_ec),
+
+	TP_STRUCT__entry(
+		__field(	int,		ubi_num		)
+		__string(	reason,		reason		)
+		__field(	int,		from_pnum	)
+		__field(	int,		from_ec		)
+		__field(	int,		to_pnum		)
+		__field(	int,		to_ec		)
+	),
+
+	TP_fast_assign(
+		__entry->ubi_num = ubi_num;
+		__assign_str(reason, reason);
+		__entry->from_pnum = from_pnum;
+		__entry->from_ec = from_ec;
+		__entry->to_pnum = to_pnum;
+		__entry->to_ec = to_ec;
+	),
+
+	TP_printk("ubi%d %s PEB %d EC %d to PEB %d EC %d",
+		  __entry->ubi_num, __get_str(reason), __entry->from_pnum,
+		  __entry->from_ec, __entry->to_pnum, __entry->to_ec)
+);
+
+TRACE_EVENT(ubi_wl_scrub_peb,
+
+	TP_PROTO(int ubi_num, int pnum),
+
+	TP_ARGS(ubi_num, pnum),
+
+	TP_STRUCT__entry(
+		__field(	int,		ubi_num		)
+		__field(	int,		pnum		)
+	),
+
+	TP_fast_assign(
+		__entry->ubi_num = ubi_num;
+		__entry->pnum = pnum;
+	),
+
+	TP_printk("ubi%d PEB %d", __entry->ubi_num, __entry->pnum)
+);
+
+#endif /* _TRACE_UBI_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
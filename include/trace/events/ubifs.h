@@ -0,0 +1,97 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM ubifs
+
+#if !defined(_TRACE_UBIFS_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_UBIFS_H
+
+#include <linux/ktime.h>
+#include <linux/tracepoint.h>
+
+DECLARE_EVENT_CLASS(ubifs_start,
+
+	TP_PROTO(int ubi_num, int vol_id),
+
+	TP_ARGS(ubi_num, vol_id),
+
+	TP_STRUCT__entry(
+		__field(	int,		ubi_num		)
+		__field(	int,		vol_id		)
+	),
+
+	TP_fast_assign(
+		__entry->ubi_num = ubi_num;
+		__entry->vol_id = vol_id;
+	),
+
+	TP_printk("ubi%d_%d", __entry->ubi_num, __entry->vol_id)
+);
+
+DECLARE_EVENT_CLASS(ubifs_end,
+
+	TP_PROTO(int ubi_num, int vol_id, int ret, ktime_t start),
+
+	TP_ARGS(ubi_num, vol_id, ret, start),
+
+	TP_STRUCT__entry(
+		__field(	int,		ubi_num		)
+		__field(	int,		vol_id		)
+		__field(	int,		ret		)
+		__field(	s64,		latency_us	)
+	),
+
+	TP_fast_assign(
+		__entry->ubi_num = ubi_num;
+		__entry->vol_id = vol_id;
+		__entry->ret = ret;
+		__entry->latency_us = ktime_us_delta(ktime_get(), start);
+	),
+
+	TP_printk("ubi%d_%d ret %d latency %lld us", __entry->ubi_num,
+		  __entry->vol_id, __entry->ret, (long long)__entry->latency_us)
+);
+
+DEFINE_EVENT(ubifs_start, ubifs_commit_start,
+
+	TP_PROTO(int ubi_num, int vol_id),
+
+	TP_ARGS(ubi_num, vol_id)
+);
+
+/* ret is zero or a negative error code */
+DEFINE_EVENT(ubifs_end, ubifs_commit_end,
+
+	TP_PROTO(int ubi_num, int vol_id, int ret, ktime_t start),
+
+	TP_ARGS(ubi_num, vol_id, ret, start)
+);
+
+DEFINE_EVENT(ubifs_start, ubifs_gc_start,
+
+	TP_PROTO(int ubi_num, int vol_id),
+
+	TP_ARGS(ubi_num, vol_id)
+);
+
+/* ret is the LEB which was freed or a negative error code */
+DEFINE_EVENT(ubifs_end, ubifs_gc_end,
+
+	TP_PROTO(int ubi_num, int vol_id, int ret, ktime_t start),
+
+	TP_ARGS(ubi_num, vol_id, ret, start)
+);
+
+/*
+ * A budget request which did not fit and had to wait for write-back, GC or
+ * a commit. ret is -EAGAIN if space was made and the budget is retried.
+ */
+DEFINE_EVENT(ubifs_end, ubifs_budget_stall,
+
+	TP_PROTO(int ubi_num, int vol_id, int ret, ktime_t start),
+
+	TP_ARGS(ubi_num, vol_id, ret, start)
+);
+
+#endif /* _TRACE_UBIFS_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
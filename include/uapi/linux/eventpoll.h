@@ -17,6 +17,7 @@
 /* For O_CLOEXEC */
 #include <linux/fcntl.h>
 #include <linux/types.h>
+#include <linux/ioctl.h>
 
 /* Flags for epoll_create1.  */
 #define EPOLL_CLOEXEC O_CLOEXEC
@@ -61,6 +62,21 @@ struct epoll_event {
 	__u64 data;
 } EPOLL_PACKED;
 
+/*
+ * Wakeup coalescing for an epoll instance: once at least one event is
+ * ready, epoll_wait() holds off returning until @min_events are ready or
+ * @max_delay_us microseconds have passed.  A @min_events of 0 or 1, or a
+ * @max_delay_us of 0, disables coalescing.
+ */
+struct epoll_batch_params {
+	__u32 min_events;
+	__u32 max_delay_us;
+};
+
+#define EPOLL_IOC_TYPE 0x8A
+#define EPIOCSBATCH _IOW(EPOLL_IOC_TYPE, 0x01, struct epoll_batch_params)
+#define EPIOCGBATCH _IOR(EPOLL_IOC_TYPE, 0x02, struct epoll_batch_params)
+
 #ifdef CONFIG_PM_SLEEP
 static inline void ep_take_care_of_epollwakeup(struct epoll_event *epev)
 {
@@ -0,0 +1,34 @@
+/*
+ * Access to several exported GPIOs in one call through /dev/gpio
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published by
+ * the Free Software Foundation.
+ */
+#ifndef _UAPI_GPIO_H_
+#define _UAPI_GPIO_H_
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+#define GPIO_MULTI_MAX		64
+
+/**
+ * struct gpio_multi - values of several GPIOs
+ * @count: number of valid entries in @gpio and @value
+ * @gpio: GPIO numbers, each must be exported through sysfs
+ * @value: logical values, read or to be written
+ *
+ * Runs of GPIOs on the same controller are read or written together when
+ * the controller supports it, so list them in port order for speed.
+ */
+struct gpio_multi {
+	__u32	count;
+	__u32	gpio[GPIO_MULTI_MAX];
+	__u8	value[GPIO_MULTI_MAX];
+};
+
+#define GPIO_MULTI_GET		_IOWR(0xB4, 0x01, struct gpio_multi)
+#define GPIO_MULTI_SET		_IOW(0xB4, 0x02, struct gpio_multi)
+
+#endif /* _UAPI_GPIO_H_ */
@@ -155,6 +155,7 @@ struct input_keymap_entry {
 #define EVIOCREVOKE		_IOW('E', 0x91, int)			/* Revoke device access */
 
 #define EVIOCSCLOCKID		_IOW('E', 0xa0, int)			/* Set clockid to be used for timestamps */
+#define EVIOCSBATCH		_IOW('E', 0xa1, int)			/* Set wakeup batching latency in usecs */
 
 /*
  * Device properties and quirks
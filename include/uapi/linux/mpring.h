@@ -0,0 +1,40 @@
+/*
+ * Multi-producer record ring, as mapped to user space
+ *
+ * The mapping starts with struct mpring_header, followed at data_offset
+ * by (mask + 1) slots of slot_size bytes each.  A slot begins with its
+ * sequence number, followed by record_size bytes of record.
+ *
+ * Record n lives in slot (n & mask) and is ready for the consumer once
+ * that slot's seq equals n + 1.  The mapping is read-only: once done
+ * with records tail onwards, the consumer hands their slots back to the
+ * producers with the MPRING_IOC_CONSUME ioctl, passing the number of
+ * records.  It returns how many were ready and have been dropped.
+ */
+#ifndef _UAPI_LINUX_MPRING_H
+#define _UAPI_LINUX_MPRING_H
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+struct mpring_header {
+	__u32	head;		/* next record to be reserved by a producer */
+	__u32	__pad0[15];
+	__u32	tail;		/* next record to be consumed */
+	__u32	__pad1[15];
+	__u32	mask;		/* number of slots - 1 */
+	__u32	record_size;
+	__u32	slot_size;
+	__u32	data_offset;
+	__u32	dropped;	/* records lost because the ring was full */
+};
+
+struct mpring_slot {
+	__u32	seq;
+	__u32	__pad;
+	__u8	data[];
+};
+
+#define MPRING_IOC_CONSUME	_IO(0xB5, 0x01)
+
+#endif /* _UAPI_LINUX_MPRING_H */
@@ -707,6 +707,7 @@ enum {
 	TCA_FQ_CODEL_ECN,
 	TCA_FQ_CODEL_FLOWS,
 	TCA_FQ_CODEL_QUANTUM,
+	TCA_FQ_CODEL_MEMORY_LIMIT,
 	__TCA_FQ_CODEL_MAX
 };
 
@@ -730,6 +731,8 @@ struct tc_fq_codel_qd_stats {
 				 */
 	__u32	new_flows_len;	/* count of flows in new list */
 	__u32	old_flows_len;	/* count of flows in old list */
+	__u32	memory_usage;	/* truesize of queued packets, in bytes */
+	__u32	drop_overmemory; /* number of time memory_limit was hit */
 };
 
 struct tc_fq_codel_cl_stats {
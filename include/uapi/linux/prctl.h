@@ -149,4 +149,9 @@
 
 #define PR_GET_TID_ADDRESS	40
 
+/* Private futex hash table of the process */
+#define PR_FUTEX_HASH			78
+# define PR_FUTEX_HASH_SET_SLOTS	1
+# define PR_FUTEX_HASH_GET_SLOTS	2
+
 #endif /* _LINUX_PRCTL_H */
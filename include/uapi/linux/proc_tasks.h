@@ -0,0 +1,36 @@
+#ifndef _UAPI_LINUX_PROC_TASKS_H
+#define _UAPI_LINUX_PROC_TASKS_H
+
+#include <linux/types.h>
+
+/*
+ * Record format of /proc/taskinfo.  Reading the file returns one record per
+ * task (thread) visible in the reader's pid namespace, in pid order.  Each
+ * record is taken as it is read; tasks that exist throughout a read of the
+ * whole file are reported exactly once.
+ *
+ * @size is the size of a record; new fields are only ever appended.
+ */
+struct proc_task_record {
+	__u32	size;
+	__s32	pid;
+	__s32	tgid;
+	__s32	ppid;
+	__u8	state;		/* as in /proc/<pid>/stat: 'R', 'S', 'D'... */
+	__s8	nice;
+	__u8	policy;
+	__u8	__pad;
+	__u32	cpu;		/* CPU the task last ran on */
+	__u32	nr_threads;	/* threads in the task's thread group */
+	__u32	__reserved;
+	__u64	utime_us;	/* user CPU time */
+	__u64	stime_us;	/* system CPU time */
+	__u64	start_time_ns;	/* since boot */
+	__u64	min_flt;
+	__u64	maj_flt;
+	__u64	vsize;		/* bytes */
+	__u64	rss;		/* pages */
+	char	comm[16];
+};
+
+#endif /* _UAPI_LINUX_PROC_TASKS_H */
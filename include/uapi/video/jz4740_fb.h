@@ -0,0 +1,31 @@
+/*
+ * JZ4740 SoC LCD framebuffer driver, ioctl interface
+ *
+ * For smart panels, which keep their own copy of the frame, the driver
+ * only sends the lines that have changed.  Drawing through the console
+ * and write() is tracked by the driver; clients drawing into an mmap()ed
+ * framebuffer report what they have touched with JZFB_IOCTL_DAMAGE.
+ * On other panels the ioctl only matters when the driver maps the
+ * framebuffer cached, where it writes the region back to memory.
+ */
+#ifndef _UAPI_VIDEO_JZ4740_FB_H
+#define _UAPI_VIDEO_JZ4740_FB_H
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/*
+ * A changed region, in pixels of the virtual framebuffer.  Panels are
+ * updated in whole lines, so x and width are currently not used.
+ */
+struct jzfb_damage_rect {
+	__u32 x;
+	__u32 y;
+	__u32 width;
+	__u32 height;
+};
+
+/* Sends the region, along with any pending damage, and waits for it */
+#define JZFB_IOCTL_DAMAGE	_IOW('F', 0x80, struct jzfb_damage_rect)
+
+#endif /* _UAPI_VIDEO_JZ4740_FB_H */
@@ -18,6 +18,8 @@
 #include <linux/dirent.h>
 #include <linux/syscalls.h>
 #include <linux/utime.h>
+#include <linux/async.h>
+#include <linux/initrd.h>
 
 static __initdata char *message;
 static void __init error(char *x)
@@ -495,7 +497,6 @@ __setup("retain_initrd", retain_initrd_param);
 
 extern char __initramfs_start[];
 extern unsigned long __initramfs_size;
-#include <linux/initrd.h>
 #include <linux/kexec.h>
 
 static void __init free_initrd(void)
@@ -579,9 +580,38 @@ static void __init clean_rootfs(void)
 }
 #endif
 
-static int __init populate_rootfs(void)
+/*
+ * With "initramfs_async" the archive is unpacked from an async worker while
+ * the remaining initcalls run.  Anything that needs the contents of rootfs
+ * (the firmware loader, usermode helpers and init itself) must call
+ * wait_for_initramfs() first.
+ */
+static bool initramfs_async;
+static ASYNC_DOMAIN(initramfs_domain);
+static async_cookie_t initramfs_cookie;
+static struct task_struct *initramfs_task;
+
+static int __init initramfs_async_setup(char *str)
+{
+	initramfs_async = true;
+	return 1;
+}
+__setup("initramfs_async", initramfs_async_setup);
+
+void wait_for_initramfs(void)
+{
+	if (!initramfs_cookie || current == initramfs_task)
+		return;
+	async_synchronize_cookie_domain(initramfs_cookie + 1, &initramfs_domain);
+}
+EXPORT_SYMBOL_GPL(wait_for_initramfs);
+
+static void __init do_populate_rootfs(void *unused, async_cookie_t cookie)
 {
-	char *err = unpack_to_rootfs(__initramfs_start, __initramfs_size);
+	char *err;
+
+	initramfs_task = current;
+	err = unpack_to_rootfs(__initramfs_start, __initramfs_size);
 	if (err)
 		panic("%s", err); /* Failed to decompress INTERNAL initramfs */
 	if (initrd_start) {
@@ -618,10 +648,26 @@ static int __init populate_rootfs(void)
 #endif
 		/*
 		 * Try loading default modules from initramfs.  This gives
-		 * us a chance to load before device_initcalls.
+		 * us a chance to load before device_initcalls.  When unpacking
+		 * asynchronously the helper would wait for us, so leave it to
+		 * kernel_init_freeable().
 		 */
-		load_default_modules();
+		if (!initramfs_async)
+			load_default_modules();
 	}
+	initramfs_task = NULL;
+}
+
+static int __init populate_rootfs(void)
+{
+	if (!initramfs_async) {
+		do_populate_rootfs(NULL, 0);
+		return 0;
+	}
+
+	printk(KERN_INFO "Unpacking initramfs asynchronously\n");
+	initramfs_cookie = async_schedule_domain(do_populate_rootfs, NULL,
+						 &initramfs_domain);
 	return 0;
 }
 rootfs_initcall(populate_rootfs);
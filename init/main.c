@@ -77,6 +77,7 @@
 #include <linux/sched_clock.h>
 #include <linux/context_tracking.h>
 #include <linux/random.h>
+#include <linux/boot_timeline.h>
 
 #include <asm/io.h>
 #include <asm/bugs.h>
@@ -691,6 +692,7 @@ static int __init_or_module do_one_initcall_debug(initcall_t fn)
 int __init_or_module do_one_initcall(initcall_t fn)
 {
 	int count = preempt_count();
+	u64 tl_start = boot_timeline_start();
 	int ret;
 	char msgbuf[64];
 
@@ -699,6 +701,8 @@ int __init_or_module do_one_initcall(initcall_t fn)
 	else
 		ret = fn();
 
+	boot_timeline_end(BOOT_TL_INITCALL, tl_start, "%pf", fn);
+
 	msgbuf[0] = 0;
 
 	if (preempt_count() != count) {
@@ -815,10 +819,16 @@ void __init load_default_modules(void)
 
 static int run_init_process(const char *init_filename)
 {
+	u64 tl_start = boot_timeline_start();
+	int ret;
+
 	argv_init[0] = init_filename;
-	return do_execve(getname_kernel(init_filename),
+	ret = do_execve(getname_kernel(init_filename),
 		(const char __user *const __user *)argv_init,
 		(const char __user *const __user *)envp_init);
+	if (!ret)
+		boot_timeline_end(BOOT_TL_EXEC, tl_start, "%s", init_filename);
+	return ret;
 }
 
 static int try_to_run_init_process(const char *init_filename)
@@ -913,6 +923,9 @@ static noinline void __init kernel_init_freeable(void)
 
 	do_basic_setup();
 
+	/* rootfs may still be being unpacked from initramfs */
+	wait_for_initramfs();
+
 	/* Open the /dev/console on the rootfs, this should never fail */
 	if (sys_open((const char __user *) "/dev/console", O_RDWR, 0) < 0)
 		pr_err("Warning: unable to open an initial console.\n");
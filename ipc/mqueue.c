@@ -35,6 +35,7 @@
 #include <linux/ipc_namespace.h>
 #include <linux/user_namespace.h>
 #include <linux/slab.h>
+#include <linux/security.h>
 
 #include <net/sock.h>
 #include "util.h"
@@ -83,6 +84,10 @@ struct mqueue_inode_info {
 	struct ext_wait_queue e_wait_q[2];
 
 	unsigned long qsize; /* size of queue in memory (sum of all msgs) */
+
+	/* recycled message buffers, see mqueue_alloc_msg() */
+	struct list_head msg_pool;
+	unsigned int msg_pool_len;
 };
 
 static const struct inode_operations mqueue_dir_inode_operations;
@@ -213,6 +218,77 @@ try_again:
 	return msg;
 }
 
+/*
+ * Queues whose messages fit in one page keep the buffers of received
+ * messages and hand them to later senders, so a queue running at a
+ * steady rate stops going to the allocator.  The pool holds at most
+ * mq_maxmsg buffers, which RLIMIT_MSGQUEUE has already accounted for.
+ */
+static inline bool mqueue_pooled(struct mqueue_inode_info *info)
+{
+	return sizeof(struct msg_msg) + info->attr.mq_msgsize <= PAGE_SIZE;
+}
+
+static struct msg_msg *mqueue_alloc_msg(struct mqueue_inode_info *info)
+{
+	struct msg_msg *msg = NULL;
+
+	spin_lock(&info->lock);
+	if (info->msg_pool_len) {
+		msg = list_first_entry(&info->msg_pool, struct msg_msg,
+				       m_list);
+		list_del(&msg->m_list);
+		info->msg_pool_len--;
+	}
+	spin_unlock(&info->lock);
+
+	if (!msg)
+		msg = kmalloc(sizeof(*msg) + info->attr.mq_msgsize,
+			      GFP_KERNEL);
+	return msg;
+}
+
+static void mqueue_free_msg(struct mqueue_inode_info *info,
+			    struct msg_msg *msg)
+{
+	if (!mqueue_pooled(info)) {
+		free_msg(msg);
+		return;
+	}
+
+	security_msg_msg_free(msg);
+	spin_lock(&info->lock);
+	if (info->msg_pool_len < info->attr.mq_maxmsg) {
+		list_add(&msg->m_list, &info->msg_pool);
+		info->msg_pool_len++;
+		msg = NULL;
+	}
+	spin_unlock(&info->lock);
+	kfree(msg);
+}
+
+static struct msg_msg *mqueue_load_msg(struct mqueue_inode_info *info,
+				       const char __user *u_msg_ptr,
+				       size_t msg_len)
+{
+	struct msg_msg *msg;
+	int ret;
+
+	if (!mqueue_pooled(info))
+		return load_msg(u_msg_ptr, msg_len);
+
+	msg = mqueue_alloc_msg(info);
+	if (!msg)
+		return ERR_PTR(-ENOMEM);
+
+	ret = load_msg_into(msg, u_msg_ptr, msg_len);
+	if (ret) {
+		mqueue_free_msg(info, msg);
+		return ERR_PTR(ret);
+	}
+	return msg;
+}
+
 static struct inode *mqueue_get_inode(struct super_block *sb,
 		struct ipc_namespace *ipc_ns, umode_t mode,
 		struct mq_attr *attr)
@@ -249,6 +325,8 @@ static struct inode *mqueue_get_inode(struct super_block *sb,
 		info->user = NULL;	/* set when all is ok */
 		info->msg_tree = RB_ROOT;
 		info->node_cache = NULL;
+		INIT_LIST_HEAD(&info->msg_pool);
+		info->msg_pool_len = 0;
 		memset(&info->attr, 0, sizeof(info->attr));
 		info->attr.mq_maxmsg = min(ipc_ns->mq_msg_max,
 					   ipc_ns->mq_msg_default);
@@ -377,7 +455,7 @@ static void mqueue_evict_inode(struct inode *inode)
 	struct user_struct *user;
 	unsigned long mq_bytes, mq_treesize;
 	struct ipc_namespace *ipc_ns;
-	struct msg_msg *msg;
+	struct msg_msg *msg, *next;
 
 	clear_inode(inode);
 
@@ -390,6 +468,8 @@ static void mqueue_evict_inode(struct inode *inode)
 	while ((msg = msg_get(info)) != NULL)
 		free_msg(msg);
 	kfree(info->node_cache);
+	list_for_each_entry_safe(msg, next, &info->msg_pool, m_list)
+		kfree(msg);
 	spin_unlock(&info->lock);
 
 	/* Total amount of bytes accounted for the mqueue */
@@ -1004,7 +1084,7 @@ SYSCALL_DEFINE5(mq_timedsend, mqd_t, mqdes, const char __user *, u_msg_ptr,
 
 	/* First try to allocate memory, before doing anything with
 	 * existing queues. */
-	msg_ptr = load_msg(u_msg_ptr, msg_len);
+	msg_ptr = mqueue_load_msg(info, u_msg_ptr, msg_len);
 	if (IS_ERR(msg_ptr)) {
 		ret = PTR_ERR(msg_ptr);
 		goto out_fput;
@@ -1064,7 +1144,7 @@ out_unlock:
 	spin_unlock(&info->lock);
 out_free:
 	if (ret)
-		free_msg(msg_ptr);
+		mqueue_free_msg(info, msg_ptr);
 out_fput:
 	fdput(f);
 out:
@@ -1166,7 +1246,7 @@ SYSCALL_DEFINE5(mq_timedreceive, mqd_t, mqdes, char __user *, u_msg_ptr,
 			store_msg(u_msg_ptr, msg_ptr, msg_ptr->m_ts)) {
 			ret = -EFAULT;
 		}
-		free_msg(msg_ptr);
+		mqueue_free_msg(info, msg_ptr);
 	}
 out_fput:
 	fdput(f);
@@ -113,6 +113,23 @@ out_err:
 	free_msg(msg);
 	return ERR_PTR(err);
 }
+/*
+ * Like load_msg(), but into @msg, a single segment buffer of at least
+ * @len bytes that the caller recycles between messages.
+ */
+int load_msg_into(struct msg_msg *msg, const void __user *src, size_t len)
+{
+	if (WARN_ON_ONCE(len > DATALEN_MSG))
+		return -EINVAL;
+
+	msg->next = NULL;
+	msg->security = NULL;
+	if (copy_from_user(msg + 1, src, len))
+		return -EFAULT;
+
+	return security_msg_msg_alloc(msg);
+}
+
 #ifdef CONFIG_CHECKPOINT_RESTORE
 struct msg_msg *copy_msg(struct msg_msg *src, struct msg_msg *dst)
 {
@@ -56,6 +56,7 @@ asynchronous and synchronous parts of the kernel.
 #include <linux/sched.h>
 #include <linux/slab.h>
 #include <linux/workqueue.h>
+#include <linux/boot_timeline.h>
 
 #include "workqueue_internal.h"
 
@@ -283,13 +284,16 @@ EXPORT_SYMBOL_GPL(async_synchronize_full_domain);
 void async_synchronize_cookie_domain(async_cookie_t cookie, struct async_domain *domain)
 {
 	ktime_t uninitialized_var(starttime), delta, endtime;
+	u64 tl_start;
 
 	if (initcall_debug && system_state == SYSTEM_BOOTING) {
 		printk(KERN_DEBUG "async_waiting @ %i\n", task_pid_nr(current));
 		starttime = ktime_get();
 	}
 
+	tl_start = boot_timeline_start();
 	wait_event(async_done, lowest_in_progress(domain) >= cookie);
+	boot_timeline_end(BOOT_TL_ASYNC_WAIT, tl_start, "%s", current->comm);
 
 	if (initcall_debug && system_state == SYSTEM_BOOTING) {
 		endtime = ktime_get();
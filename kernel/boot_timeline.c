@@ -0,0 +1,139 @@
+/*
+ * kernel/boot_timeline.c
+ *
+ * Record what the kernel spends its boot time on: initcalls, driver
+ * probes, waits for async work, firmware loads, the root mount and the
+ * first exec.  Each event is stored with its start time, duration and
+ * the pid that ran it, and the whole timeline can be read back from
+ * debugfs as boot_timeline, one event per line:
+ *
+ *	<start_us> <duration_us> <pid> <type> <name>
+ *
+ * which is simple to turn into a bootchart-style graph.  Recording
+ * starts at boot and stops when the buffer is full or when anything is
+ * written to the file.  The last BOOT_TL_MILESTONES entries are kept
+ * for the root mount and the exec of init, so that a boot with many
+ * initcalls and probes still records where it ended; other events
+ * that do not fit are only counted.
+ */
+#include <linux/boot_timeline.h>
+#include <linux/debugfs.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+
+#define BOOT_TL_ENTRIES		256
+#define BOOT_TL_MILESTONES	8
+#define BOOT_TL_NAME_LEN	44
+
+struct boot_tl_event {
+	u64		start;
+	u32		duration_us;
+	pid_t		pid;
+	u8		type;
+	char		name[BOOT_TL_NAME_LEN];
+};
+
+static const char * const boot_tl_type_name[BOOT_TL_NR_TYPES] = {
+	[BOOT_TL_INITCALL]	= "initcall",
+	[BOOT_TL_PROBE]		= "probe",
+	[BOOT_TL_ASYNC_WAIT]	= "async_wait",
+	[BOOT_TL_FIRMWARE]	= "firmware",
+	[BOOT_TL_MOUNT_ROOT]	= "mount_root",
+	[BOOT_TL_EXEC]		= "exec",
+};
+
+bool boot_timeline_active = true;
+static DEFINE_RAW_SPINLOCK(boot_tl_lock);
+static struct boot_tl_event boot_tl[BOOT_TL_ENTRIES];
+static unsigned int boot_tl_count;
+static unsigned int boot_tl_dropped;
+
+void boot_timeline_end(enum boot_tl_type type, u64 start,
+		       const char *fmt, ...)
+{
+	struct boot_tl_event *ev;
+	char name[BOOT_TL_NAME_LEN];
+	unsigned long flags;
+	unsigned int limit;
+	u64 delta;
+	va_list args;
+
+	if (!start)
+		return;
+	delta = local_clock() - start;
+	do_div(delta, NSEC_PER_USEC);
+
+	va_start(args, fmt);
+	vsnprintf(name, sizeof(name), fmt, args);
+	va_end(args);
+
+	limit = BOOT_TL_ENTRIES;
+	if (type != BOOT_TL_MOUNT_ROOT && type != BOOT_TL_EXEC)
+		limit -= BOOT_TL_MILESTONES;
+
+	raw_spin_lock_irqsave(&boot_tl_lock, flags);
+	if (boot_tl_count == BOOT_TL_ENTRIES)
+		boot_timeline_active = false;
+	if (boot_timeline_active && boot_tl_count >= limit) {
+		boot_tl_dropped++;
+	} else if (boot_timeline_active) {
+		ev = &boot_tl[boot_tl_count];
+		ev->start = start;
+		ev->duration_us = min_t(u64, delta, U32_MAX);
+		ev->pid = task_pid_nr(current);
+		ev->type = type;
+		memcpy(ev->name, name, sizeof(name));
+		/* publish the entry only once it is complete */
+		smp_wmb();
+		boot_tl_count++;
+	}
+	raw_spin_unlock_irqrestore(&boot_tl_lock, flags);
+}
+
+static int boot_tl_show(struct seq_file *m, void *v)
+{
+	unsigned int i, count = ACCESS_ONCE(boot_tl_count);
+
+	smp_rmb();
+	if (boot_tl_dropped)
+		seq_printf(m, "# %u events dropped\n", boot_tl_dropped);
+	seq_puts(m, "# start_us duration_us pid type name\n");
+	for (i = 0; i < count; i++) {
+		struct boot_tl_event *ev = &boot_tl[i];
+		u64 start_us = ev->start;
+
+		do_div(start_us, NSEC_PER_USEC);
+		seq_printf(m, "%llu %u %d %s %s\n", start_us, ev->duration_us,
+			   ev->pid, boot_tl_type_name[ev->type], ev->name);
+	}
+	return 0;
+}
+
+static ssize_t boot_tl_write(struct file *file, const char __user *buf,
+			     size_t count, loff_t *ppos)
+{
+	boot_timeline_active = false;
+	return count;
+}
+
+static int boot_tl_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, boot_tl_show, NULL);
+}
+
+static const struct file_operations boot_tl_fops = {
+	.open		= boot_tl_open,
+	.read		= seq_read,
+	.write		= boot_tl_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init boot_tl_debugfs_init(void)
+{
+	debugfs_create_file("boot_timeline", 0644, NULL, NULL, &boot_tl_fops);
+	return 0;
+}
+late_initcall(boot_tl_debugfs_init);
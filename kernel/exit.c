@@ -20,6 +20,7 @@
 #include <linux/tsacct_kern.h>
 #include <linux/file.h>
 #include <linux/fdtable.h>
+#include <linux/poll.h>
 #include <linux/freezer.h>
 #include <linux/binfmts.h>
 #include <linux/nsproxy.h>
@@ -789,6 +790,7 @@ void do_exit(long code)
 
 	exit_sem(tsk);
 	exit_shm(tsk);
+	poll_cache_drop();
 	exit_files(tsk);
 	exit_fs(tsk);
 	if (group_dead)
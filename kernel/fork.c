@@ -19,9 +19,11 @@
 #include <linux/completion.h>
 #include <linux/personality.h>
 #include <linux/mempolicy.h>
+#include <linux/task_work.h>
 #include <linux/sem.h>
 #include <linux/file.h>
 #include <linux/fdtable.h>
+#include <linux/poll.h>
 #include <linux/iocontext.h>
 #include <linux/key.h>
 #include <linux/binfmts.h>
@@ -538,6 +540,7 @@ static struct mm_struct *mm_init(struct mm_struct *mm, struct task_struct *p)
 	memset(&mm->rss_stat, 0, sizeof(mm->rss_stat));
 	spin_lock_init(&mm->page_table_lock);
 	mm_init_aio(mm);
+	futex_mm_init(mm);
 	mm_init_owner(mm, p);
 	clear_tlb_flush_pending(mm);
 
@@ -595,6 +598,7 @@ void __mmdrop(struct mm_struct *mm)
 	mm_free_pgd(mm);
 	destroy_context(mm);
 	mmu_notifier_mm_destroy(mm);
+	futex_mm_free(mm);
 	check_mm(mm);
 	free_mm(mm);
 }
@@ -882,6 +886,8 @@ static int copy_mm(unsigned long clone_flags, struct task_struct *tsk)
 	vmacache_flush(tsk);
 
 	if (clone_flags & CLONE_VM) {
+		if (clone_flags & CLONE_THREAD)
+			futex_mm_clone_thread(oldmm);
 		atomic_inc(&oldmm->mm_users);
 		mm = oldmm;
 		goto good_mm;
@@ -1313,6 +1319,9 @@ static struct task_struct *copy_process(unsigned long clone_flags,
 	p->memcg_batch.do_batch = 0;
 	p->memcg_batch.memcg = NULL;
 #endif
+#ifdef CONFIG_MMU
+	p->oom_reaper_list = NULL;
+#endif
 #ifdef CONFIG_BCACHE
 	p->sequential_io	= 0;
 	p->sequential_io_avg	= 0;
@@ -1333,6 +1342,9 @@ static struct task_struct *copy_process(unsigned long clone_flags,
 	retval = copy_semundo(clone_flags, p);
 	if (retval)
 		goto bad_fork_cleanup_audit;
+	p->poll_cache = NULL;
+	if (clone_flags & CLONE_FILES)
+		poll_cache_drop();
 	retval = copy_files(clone_flags, p);
 	if (retval)
 		goto bad_fork_cleanup_semundo;
@@ -1576,11 +1588,12 @@ struct task_struct *fork_idle(int cpu)
  * It copies the process, and if successful kick-starts
  * it and waits for it to finish using the VM if required.
  */
-long do_fork(unsigned long clone_flags,
-	      unsigned long stack_start,
-	      unsigned long stack_size,
-	      int __user *parent_tidptr,
-	      int __user *child_tidptr)
+static long __do_fork(unsigned long clone_flags,
+		      unsigned long stack_start,
+		      unsigned long stack_size,
+		      int __user *parent_tidptr,
+		      int __user *child_tidptr,
+		      struct callback_head *child_work)
 {
 	struct task_struct *p;
 	int trace = 0;
@@ -1628,6 +1641,10 @@ long do_fork(unsigned long clone_flags,
 			get_task_struct(p);
 		}
 
+		/* Can't fail, the child has not run yet */
+		if (child_work)
+			task_work_add(p, child_work, true);
+
 		wake_up_new_task(p);
 
 		/* forking complete and child started to run, tell ptracer */
@@ -1646,6 +1663,27 @@ long do_fork(unsigned long clone_flags,
 	return nr;
 }
 
+long do_fork(unsigned long clone_flags,
+	      unsigned long stack_start,
+	      unsigned long stack_size,
+	      int __user *parent_tidptr,
+	      int __user *child_tidptr)
+{
+	return __do_fork(clone_flags, stack_start, stack_size, parent_tidptr,
+			 child_tidptr, NULL);
+}
+
+/*
+ * Like vfork(), but @work runs in the child before it first returns to user
+ * space. It can exec a new program there, without the child ever running
+ * user code on the parent's stack.
+ */
+long do_vfork_work(struct callback_head *work)
+{
+	return __do_fork(CLONE_VFORK | CLONE_VM | SIGCHLD, 0, 0, NULL, NULL,
+			 work);
+}
+
 /*
  * Create a kernel thread.
  */
@@ -64,6 +64,7 @@
 #include <linux/hugetlb.h>
 #include <linux/freezer.h>
 #include <linux/bootmem.h>
+#include <linux/prctl.h>
 
 #include <asm/futex.h>
 
@@ -245,6 +246,21 @@ static unsigned long __read_mostly futex_hashsize;
 
 static struct futex_hash_bucket *futex_queues;
 
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+/*
+ * Per-mm hash table for private futexes.  It is only ever installed or
+ * replaced while the mm has a single user, so no waiter can be queued on
+ * a table other than the one its waker will look up.
+ */
+struct futex_private_hash {
+	unsigned long hashsize;
+	struct futex_hash_bucket queues[0];
+};
+
+/* Size of the table a process gets when it starts its second thread */
+#define FUTEX_PRIVATE_HASH_DEFAULT	16
+#endif
+
 static inline void futex_get_mm(union futex_key *key)
 {
 	atomic_inc(&key->private.mm->mm_count);
@@ -298,6 +314,15 @@ static struct futex_hash_bucket *hash_futex(union futex_key *key)
 	u32 hash = jhash2((u32*)&key->both.word,
 			  (sizeof(key->both.word)+sizeof(key->both.ptr))/4,
 			  key->both.offset);
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+	if (!(key->both.offset & (FUT_OFF_INODE | FUT_OFF_MMSHARED))) {
+		struct futex_private_hash *fph =
+			ACCESS_ONCE(key->private.mm->futex_phash);
+
+		if (fph)
+			return &fph->queues[hash & (fph->hashsize - 1)];
+	}
+#endif
 	return &futex_queues[hash & (futex_hashsize - 1)];
 }
 
@@ -3038,6 +3063,88 @@ static void __init futex_detect_cmpxchg(void)
 #endif
 }
 
+static void futex_hash_bucket_init(struct futex_hash_bucket *hb)
+{
+	atomic_set(&hb->waiters, 0);
+	plist_head_init(&hb->chain);
+	spin_lock_init(&hb->lock);
+}
+
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+static struct futex_private_hash *futex_private_hash_alloc(unsigned long slots)
+{
+	struct futex_private_hash *fph;
+	unsigned long i;
+
+	slots = roundup_pow_of_two(clamp(slots, 2UL, futex_hashsize));
+	fph = kmalloc(sizeof(*fph) + slots * sizeof(fph->queues[0]),
+		      GFP_KERNEL);
+	if (!fph)
+		return NULL;
+
+	fph->hashsize = slots;
+	for (i = 0; i < slots; i++)
+		futex_hash_bucket_init(&fph->queues[i]);
+	return fph;
+}
+
+void futex_mm_init(struct mm_struct *mm)
+{
+	mm->futex_phash = NULL;
+}
+
+void futex_mm_free(struct mm_struct *mm)
+{
+	kfree(mm->futex_phash);
+}
+
+/*
+ * Called by a process about to create a thread.  If it is still the only
+ * user of its mm, no private futex can have waiters yet, so this is the
+ * last point at which a table can be installed safely.  Later threads
+ * keep whatever table (or the global hash) the first one got.
+ */
+void futex_mm_clone_thread(struct mm_struct *mm)
+{
+	if (mm->futex_phash || atomic_read(&mm->mm_users) != 1)
+		return;
+
+	mm->futex_phash = futex_private_hash_alloc(FUTEX_PRIVATE_HASH_DEFAULT);
+}
+
+/*
+ * prctl(PR_FUTEX_HASH): let a process size its private table, in hash
+ * slots, for the number of threads it is about to start.  Zero slots
+ * selects the global hash.  Only allowed while the process is still
+ * single-threaded.
+ */
+int futex_hash_prctl(unsigned long cmd, unsigned long slots)
+{
+	struct mm_struct *mm = current->mm;
+	struct futex_private_hash *fph = NULL, *old;
+
+	switch (cmd) {
+	case PR_FUTEX_HASH_GET_SLOTS:
+		fph = mm->futex_phash;
+		return fph ? fph->hashsize : 0;
+	case PR_FUTEX_HASH_SET_SLOTS:
+		if (atomic_read(&mm->mm_users) != 1)
+			return -EBUSY;
+		if (slots) {
+			fph = futex_private_hash_alloc(slots);
+			if (!fph)
+				return -ENOMEM;
+		}
+		old = mm->futex_phash;
+		mm->futex_phash = fph;
+		kfree(old);
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+#endif
+
 static int __init futex_init(void)
 {
 	unsigned int futex_shift;
@@ -3058,11 +3165,8 @@ static int __init futex_init(void)
 
 	futex_detect_cmpxchg();
 
-	for (i = 0; i < futex_hashsize; i++) {
-		atomic_set(&futex_queues[i].waiters, 0);
-		plist_head_init(&futex_queues[i].chain);
-		spin_lock_init(&futex_queues[i].lock);
-	}
+	for (i = 0; i < futex_hashsize; i++)
+		futex_hash_bucket_init(&futex_queues[i]);
 
 	return 0;
 }
@@ -99,6 +99,9 @@ static inline void unregister_handler_proc(unsigned int irq,
 
 extern int irq_select_affinity_usr(unsigned int irq, struct cpumask *mask);
 
+extern int irq_thread_prio(struct irq_desc *desc);
+extern int irq_set_thread_prio(unsigned int irq, int prio);
+
 extern void irq_set_thread_affinity(struct irq_desc *desc);
 
 extern int irq_do_set_affinity(struct irq_data *data,
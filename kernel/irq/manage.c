@@ -216,6 +216,69 @@ int irq_set_affinity_hint(unsigned int irq, const struct cpumask *m)
 }
 EXPORT_SYMBOL_GPL(irq_set_affinity_hint);
 
+/**
+ *	irq_thread_prio - SCHED_FIFO priority for the threads of an interrupt
+ *	@desc:	interrupt descriptor
+ */
+int irq_thread_prio(struct irq_desc *desc)
+{
+	return desc->thread_prio ? : MAX_USER_RT_PRIO/2;
+}
+
+/**
+ *	irq_set_thread_prio - set the priority of the threads of an interrupt
+ *	@irq:	Interrupt number
+ *	@prio:	SCHED_FIFO priority, 0 restores the default
+ *
+ *	Applies to the threads already running and to those created by
+ *	later request_threaded_irq() calls for this interrupt.
+ */
+int irq_set_thread_prio(unsigned int irq, int prio)
+{
+	struct irq_desc *desc = irq_to_desc(irq);
+	struct irqaction *action;
+	struct task_struct *t;
+	struct sched_param param;
+	unsigned long flags;
+	unsigned int i, n;
+
+	if (!desc)
+		return -EINVAL;
+	if (prio < 0 || prio >= MAX_USER_RT_PRIO)
+		return -EINVAL;
+
+	raw_spin_lock_irqsave(&desc->lock, flags);
+	desc->thread_prio = prio;
+	param.sched_priority = irq_thread_prio(desc);
+	raw_spin_unlock_irqrestore(&desc->lock, flags);
+
+	/*
+	 * sched_setscheduler() takes pi_lock and the runqueue lock and
+	 * walks the PI chain, none of which may nest inside desc->lock.
+	 * Pin one thread at a time and set its priority with the lock
+	 * dropped.
+	 */
+	for (i = 0; ; i++) {
+		t = NULL;
+		n = 0;
+		raw_spin_lock_irqsave(&desc->lock, flags);
+		for (action = desc->action; action; action = action->next) {
+			if (action->thread && n++ == i) {
+				t = action->thread;
+				get_task_struct(t);
+				break;
+			}
+		}
+		raw_spin_unlock_irqrestore(&desc->lock, flags);
+		if (!t)
+			break;
+
+		sched_setscheduler_nocheck(t, SCHED_FIFO, &param);
+		put_task_struct(t);
+	}
+	return 0;
+}
+
 static void irq_affinity_notify(struct work_struct *work)
 {
 	struct irq_affinity_notify *notify =
@@ -956,8 +1019,8 @@ __setup_irq(unsigned int irq, struct irq_desc *desc, struct irqaction *new)
 	 */
 	if (new->thread_fn && !nested) {
 		struct task_struct *t;
-		static const struct sched_param param = {
-			.sched_priority = MAX_USER_RT_PRIO/2,
+		struct sched_param param = {
+			.sched_priority = irq_thread_prio(desc),
 		};
 
 		t = kthread_create(irq_thread, new, "irq/%d-%s", irq,
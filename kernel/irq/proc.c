@@ -12,6 +12,7 @@
 #include <linux/seq_file.h>
 #include <linux/interrupt.h>
 #include <linux/kernel_stat.h>
+#include <linux/sched.h>
 
 #include "internals.h"
 
@@ -266,6 +267,71 @@ static const struct file_operations irq_spurious_proc_fops = {
 	.release	= single_release,
 };
 
+static int irq_thread_prio_proc_show(struct seq_file *m, void *v)
+{
+	struct irq_desc *desc = irq_to_desc((long) m->private);
+
+	seq_printf(m, "%d\n", irq_thread_prio(desc));
+	return 0;
+}
+
+static ssize_t irq_thread_prio_proc_write(struct file *file,
+		const char __user *buffer, size_t count, loff_t *pos)
+{
+	unsigned int irq = (int)(long)PDE_DATA(file_inode(file));
+	int prio, err;
+
+	err = kstrtoint_from_user(buffer, count, 0, &prio);
+	if (err)
+		return err;
+
+	err = irq_set_thread_prio(irq, prio);
+	return err ? : count;
+}
+
+static int irq_thread_prio_proc_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, irq_thread_prio_proc_show, PDE_DATA(inode));
+}
+
+static const struct file_operations irq_thread_prio_proc_fops = {
+	.open		= irq_thread_prio_proc_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+	.write		= irq_thread_prio_proc_write,
+};
+
+static int irq_thread_time_proc_show(struct seq_file *m, void *v)
+{
+	struct irq_desc *desc = irq_to_desc((long) m->private);
+	struct irqaction *action;
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&desc->lock, flags);
+	for (action = desc->action; action; action = action->next) {
+		if (!action->thread)
+			continue;
+		seq_printf(m, "%s %llu\n", action->thread->comm,
+			   (unsigned long long)
+			   action->thread->se.sum_exec_runtime);
+	}
+	raw_spin_unlock_irqrestore(&desc->lock, flags);
+	return 0;
+}
+
+static int irq_thread_time_proc_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, irq_thread_time_proc_show, PDE_DATA(inode));
+}
+
+static const struct file_operations irq_thread_time_proc_fops = {
+	.open		= irq_thread_time_proc_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 #define MAX_NAMELEN 128
 
 static int name_unique(unsigned int irq, struct irqaction *new_action)
@@ -341,6 +407,12 @@ void register_irq_proc(unsigned int irq, struct irq_desc *desc)
 
 	proc_create_data("spurious", 0444, desc->dir,
 			 &irq_spurious_proc_fops, (void *)(long)irq);
+
+	/* create /proc/irq/<irq>/thread_prio and thread_time */
+	proc_create_data("thread_prio", 0644, desc->dir,
+			 &irq_thread_prio_proc_fops, (void *)(long)irq);
+	proc_create_data("thread_time", 0444, desc->dir,
+			 &irq_thread_time_proc_fops, (void *)(long)irq);
 }
 
 void unregister_irq_proc(unsigned int irq, struct irq_desc *desc)
@@ -356,6 +428,8 @@ void unregister_irq_proc(unsigned int irq, struct irq_desc *desc)
 	remove_proc_entry("node", desc->dir);
 #endif
 	remove_proc_entry("spurious", desc->dir);
+	remove_proc_entry("thread_prio", desc->dir);
+	remove_proc_entry("thread_time", desc->dir);
 
 	memset(name, 0, MAX_NAMELEN);
 	sprintf(name, "%u", irq);
@@ -39,6 +39,7 @@
 #include <linux/rwsem.h>
 #include <linux/ptrace.h>
 #include <linux/async.h>
+#include <linux/initrd.h>
 #include <asm/uaccess.h>
 
 #include <trace/events/module.h>
@@ -218,6 +219,9 @@ static int ____call_usermodehelper(void *data)
 	 */
 	set_user_nice(current, 0);
 
+	/* The helper binary may live in an initramfs not yet unpacked. */
+	wait_for_initramfs();
+
 	retval = -ENOMEM;
 	new = prepare_kernel_cred(current);
 	if (!new)
@@ -0,0 +1,187 @@
+/*
+ * kernel/locking/contention.c
+ *
+ * Lightweight lock contention sampling.
+ *
+ * Every contention_sample_period-th task that has to sleep on a mutex
+ * or rw-semaphore is timed from the moment it queues until it owns the
+ * lock.  Wait times are accumulated per lock in a small hash table and
+ * the worst offenders are listed in debugfs.  Unlike lock_stat this
+ * needs neither lockdep nor any per-lock storage, so it is cheap
+ * enough to leave enabled on production builds.
+ *
+ * Locks are identified by address; statically allocated ones resolve
+ * to their symbol name.
+ */
+#include <linux/debugfs.h>
+#include <linux/hash.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/moduleparam.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/spinlock.h>
+
+#include "contention.h"
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "locking."
+
+#define CONTENTION_HASH_BITS	6
+#define CONTENTION_ENTRIES	(1 << CONTENTION_HASH_BITS)
+#define CONTENTION_TOP		16
+
+struct contention_entry {
+	void		*lock;
+	unsigned int	type;
+	unsigned long	count;
+	u64		total_ns;
+	u64		max_ns;
+	char		comm[TASK_COMM_LEN];	/* last waiter */
+};
+
+static unsigned int contention_sample_period = 8;
+module_param(contention_sample_period, uint, 0644);
+
+static DEFINE_PER_CPU(unsigned int, contention_tick);
+static DEFINE_RAW_SPINLOCK(contention_lock);
+static struct contention_entry contention_table[CONTENTION_ENTRIES];
+static unsigned long contention_overflow;
+
+static const char * const contention_type_name[] = {
+	[LOCK_CONTENTION_MUTEX]		= "mutex",
+	[LOCK_CONTENTION_RWSEM_READ]	= "rwsem-r",
+	[LOCK_CONTENTION_RWSEM_WRITE]	= "rwsem-w",
+};
+
+/*
+ * Called by a task about to sleep on a lock.  Returns the start time
+ * if this contention is to be sampled, 0 otherwise.
+ */
+u64 lock_contention_start(void)
+{
+	unsigned int period = ACCESS_ONCE(contention_sample_period);
+	u64 now;
+
+	if (!period || this_cpu_inc_return(contention_tick) % period)
+		return 0;
+
+	now = local_clock();
+	return now ? : 1;
+}
+
+void lock_contention_end(void *lock, u64 start, enum lock_contention_type type)
+{
+	struct contention_entry *e;
+	unsigned long flags;
+	unsigned int i, h;
+	s64 delta;
+
+	if (!start)
+		return;
+
+	delta = local_clock() - start;
+	if (delta < 0)
+		delta = 0;
+
+	h = hash_ptr(lock, CONTENTION_HASH_BITS);
+
+	raw_spin_lock_irqsave(&contention_lock, flags);
+	for (i = 0; i < CONTENTION_ENTRIES; i++) {
+		e = &contention_table[(h + i) & (CONTENTION_ENTRIES - 1)];
+		if (!e->lock) {
+			e->lock = lock;
+			e->type = type;
+		}
+		if (e->lock == lock && e->type == type)
+			break;
+	}
+	if (i == CONTENTION_ENTRIES) {
+		contention_overflow++;
+	} else {
+		e->count++;
+		e->total_ns += delta;
+		if (delta > e->max_ns)
+			e->max_ns = delta;
+		memcpy(e->comm, current->comm, TASK_COMM_LEN);
+	}
+	raw_spin_unlock_irqrestore(&contention_lock, flags);
+}
+
+static int contention_cmp(const void *a, const void *b)
+{
+	const struct contention_entry *ea = a, *eb = b;
+
+	if (ea->total_ns == eb->total_ns)
+		return 0;
+	return ea->total_ns < eb->total_ns ? 1 : -1;
+}
+
+static int contention_show(struct seq_file *m, void *v)
+{
+	struct contention_entry *snap;
+	unsigned long flags, overflow;
+	int i;
+
+	snap = kmalloc(sizeof(contention_table), GFP_KERNEL);
+	if (!snap)
+		return -ENOMEM;
+
+	raw_spin_lock_irqsave(&contention_lock, flags);
+	memcpy(snap, contention_table, sizeof(contention_table));
+	overflow = contention_overflow;
+	raw_spin_unlock_irqrestore(&contention_lock, flags);
+
+	sort(snap, CONTENTION_ENTRIES, sizeof(*snap), contention_cmp, NULL);
+
+	seq_printf(m, "# sample_period %u overflow %lu\n",
+		   contention_sample_period, overflow);
+	seq_puts(m, "# type count total_ns max_ns last_waiter lock\n");
+	for (i = 0; i < CONTENTION_TOP && snap[i].lock; i++)
+		seq_printf(m, "%s %lu %llu %llu %s %pS\n",
+			   contention_type_name[snap[i].type], snap[i].count,
+			   snap[i].total_ns, snap[i].max_ns, snap[i].comm,
+			   snap[i].lock);
+
+	kfree(snap);
+	return 0;
+}
+
+static ssize_t contention_write(struct file *file, const char __user *buf,
+				size_t count, loff_t *ppos)
+{
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&contention_lock, flags);
+	memset(contention_table, 0, sizeof(contention_table));
+	contention_overflow = 0;
+	raw_spin_unlock_irqrestore(&contention_lock, flags);
+
+	return count;
+}
+
+static int contention_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, contention_show, NULL);
+}
+
+static const struct file_operations contention_fops = {
+	.open		= contention_open,
+	.read		= seq_read,
+	.write		= contention_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init contention_debugfs_init(void)
+{
+	debugfs_create_file("lock_contention", 0644, NULL, NULL,
+			    &contention_fops);
+	return 0;
+}
+late_initcall(contention_debugfs_init);
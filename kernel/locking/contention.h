@@ -0,0 +1,29 @@
+/*
+ * Lightweight lock contention sampling, see kernel/locking/contention.c.
+ */
+#ifndef __LOCKING_CONTENTION_H
+#define __LOCKING_CONTENTION_H
+
+enum lock_contention_type {
+	LOCK_CONTENTION_MUTEX,
+	LOCK_CONTENTION_RWSEM_READ,
+	LOCK_CONTENTION_RWSEM_WRITE,
+};
+
+#ifdef CONFIG_LOCK_CONTENTION_SAMPLER
+extern u64 lock_contention_start(void);
+extern void lock_contention_end(void *lock, u64 start,
+				enum lock_contention_type type);
+#else
+static inline u64 lock_contention_start(void)
+{
+	return 0;
+}
+
+static inline void lock_contention_end(void *lock, u64 start,
+				       enum lock_contention_type type)
+{
+}
+#endif
+
+#endif /* __LOCKING_CONTENTION_H */
@@ -38,12 +38,34 @@
 # include <asm/mutex.h>
 #endif
 
+#include "contention.h"
+
 /*
  * A negative mutex count indicates that waiters are sleeping waiting for the
  * mutex.
  */
 #define	MUTEX_SHOW_NO_WAITER(mutex)	(atomic_read(&(mutex)->count) >= 0)
 
+/*
+ * On UP nobody can be spinning for the lock, so when the unlock slowpath
+ * still owns the lock it hands it straight to the first waiter rather
+ * than releasing it.  The woken waiter then needn't race newcomers for
+ * lock->count, and the lock can't be stolen while it waits for the CPU.
+ * Architectures that release the count in the unlock fastpath can't do
+ * this: by the time we get to the slowpath someone else may own it.
+ */
+#if !defined(CONFIG_SMP)
+# define mutex_can_handoff()		__mutex_slowpath_needs_to_unlock()
+# define mutex_waiter_init_handoff(w)	((w)->handoff = false)
+# define mutex_waiter_handoff(w)	((w)->handoff)
+# define mutex_waiter_set_handoff(w)	((w)->handoff = true)
+#else
+# define mutex_can_handoff()		0
+# define mutex_waiter_init_handoff(w)	do { } while (0)
+# define mutex_waiter_handoff(w)	false
+# define mutex_waiter_set_handoff(w)	do { } while (0)
+#endif
+
 void
 __mutex_init(struct mutex *lock, const char *name, struct lock_class_key *key)
 {
@@ -415,6 +437,7 @@ __mutex_lock_common(struct mutex *lock, long state, unsigned int subclass,
 	struct task_struct *task = current;
 	struct mutex_waiter waiter;
 	unsigned long flags;
+	u64 wait_start;
 	int ret;
 
 	preempt_disable();
@@ -525,8 +548,10 @@ slowpath:
 	/* add waiting tasks to the end of the waitqueue (FIFO): */
 	list_add_tail(&waiter.list, &lock->wait_list);
 	waiter.task = task;
+	mutex_waiter_init_handoff(&waiter);
 
 	lock_contended(&lock->dep_map, ip);
+	wait_start = lock_contention_start();
 
 	for (;;) {
 		/*
@@ -538,6 +563,8 @@ slowpath:
 		 * that when we release the lock, we properly wake up the
 		 * other waiters:
 		 */
+		if (mutex_waiter_handoff(&waiter))
+			break;
 		if (MUTEX_SHOW_NO_WAITER(lock) &&
 		    (atomic_xchg(&lock->count, -1) == 1))
 			break;
@@ -569,6 +596,7 @@ slowpath:
 	if (likely(list_empty(&lock->wait_list)))
 		atomic_set(&lock->count, 0);
 	debug_mutex_free_waiter(&waiter);
+	lock_contention_end(lock, wait_start, LOCK_CONTENTION_MUTEX);
 
 skip_wait:
 	/* got the lock - cleanup and rejoice! */
@@ -737,6 +765,12 @@ __mutex_unlock_common_slowpath(atomic_t *lock_count, int nested)
 
 		debug_mutex_wake_waiter(lock, waiter);
 
+		/* keep it locked, the waiter fixes up the count */
+		if (mutex_can_handoff()) {
+			atomic_set(&lock->count, -1);
+			mutex_waiter_set_handoff(waiter);
+		}
+
 		wake_up_process(waiter->task);
 	}
 
@@ -9,6 +9,8 @@
 #include <linux/sched.h>
 #include <linux/export.h>
 
+#include "contention.h"
+
 enum rwsem_waiter_type {
 	RWSEM_WAITING_FOR_WRITE,
 	RWSEM_WAITING_FOR_READ
@@ -123,6 +125,7 @@ void __sched __down_read(struct rw_semaphore *sem)
 	struct rwsem_waiter waiter;
 	struct task_struct *tsk;
 	unsigned long flags;
+	u64 wait_start;
 
 	raw_spin_lock_irqsave(&sem->wait_lock, flags);
 
@@ -146,6 +149,8 @@ void __sched __down_read(struct rw_semaphore *sem)
 	/* we don't need to touch the semaphore struct anymore */
 	raw_spin_unlock_irqrestore(&sem->wait_lock, flags);
 
+	wait_start = lock_contention_start();
+
 	/* wait to be given the lock */
 	for (;;) {
 		if (!waiter.task)
@@ -155,6 +160,7 @@ void __sched __down_read(struct rw_semaphore *sem)
 	}
 
 	tsk->state = TASK_RUNNING;
+	lock_contention_end(sem, wait_start, LOCK_CONTENTION_RWSEM_READ);
  out:
 	;
 }
@@ -189,6 +195,7 @@ void __sched __down_write_nested(struct rw_semaphore *sem, int subclass)
 	struct rwsem_waiter waiter;
 	struct task_struct *tsk;
 	unsigned long flags;
+	u64 wait_start = 0;
 
 	raw_spin_lock_irqsave(&sem->wait_lock, flags);
 
@@ -210,6 +217,8 @@ void __sched __down_write_nested(struct rw_semaphore *sem, int subclass)
 			break;
 		set_task_state(tsk, TASK_UNINTERRUPTIBLE);
 		raw_spin_unlock_irqrestore(&sem->wait_lock, flags);
+		if (!wait_start)
+			wait_start = lock_contention_start();
 		schedule();
 		raw_spin_lock_irqsave(&sem->wait_lock, flags);
 	}
@@ -218,6 +227,7 @@ void __sched __down_write_nested(struct rw_semaphore *sem, int subclass)
 	list_del(&waiter.list);
 
 	raw_spin_unlock_irqrestore(&sem->wait_lock, flags);
+	lock_contention_end(sem, wait_start, LOCK_CONTENTION_RWSEM_WRITE);
 }
 
 void __sched __down_write(struct rw_semaphore *sem)
@@ -11,6 +11,8 @@
 #include <linux/init.h>
 #include <linux/export.h>
 
+#include "contention.h"
+
 /*
  * Initialize an rwsem:
  */
@@ -148,6 +150,7 @@ struct rw_semaphore __sched *rwsem_down_read_failed(struct rw_semaphore *sem)
 	long count, adjustment = -RWSEM_ACTIVE_READ_BIAS;
 	struct rwsem_waiter waiter;
 	struct task_struct *tsk = current;
+	u64 wait_start;
 
 	/* set up my own style of waitqueue */
 	waiter.task = tsk;
@@ -174,6 +177,8 @@ struct rw_semaphore __sched *rwsem_down_read_failed(struct rw_semaphore *sem)
 
 	raw_spin_unlock_irq(&sem->wait_lock);
 
+	wait_start = lock_contention_start();
+
 	/* wait to be given the lock */
 	while (true) {
 		set_task_state(tsk, TASK_UNINTERRUPTIBLE);
@@ -183,6 +188,7 @@ struct rw_semaphore __sched *rwsem_down_read_failed(struct rw_semaphore *sem)
 	}
 
 	tsk->state = TASK_RUNNING;
+	lock_contention_end(sem, wait_start, LOCK_CONTENTION_RWSEM_READ);
 
 	return sem;
 }
@@ -195,6 +201,7 @@ struct rw_semaphore __sched *rwsem_down_write_failed(struct rw_semaphore *sem)
 	long count, adjustment = -RWSEM_ACTIVE_WRITE_BIAS;
 	struct rwsem_waiter waiter;
 	struct task_struct *tsk = current;
+	u64 wait_start = 0;
 
 	/* set up my own style of waitqueue */
 	waiter.task = tsk;
@@ -232,6 +239,9 @@ struct rw_semaphore __sched *rwsem_down_write_failed(struct rw_semaphore *sem)
 
 		raw_spin_unlock_irq(&sem->wait_lock);
 
+		if (!wait_start)
+			wait_start = lock_contention_start();
+
 		/* Block until there are no active lockers. */
 		do {
 			schedule();
@@ -244,6 +254,7 @@ struct rw_semaphore __sched *rwsem_down_write_failed(struct rw_semaphore *sem)
 	list_del(&waiter.list);
 	raw_spin_unlock_irq(&sem->wait_lock);
 	tsk->state = TASK_RUNNING;
+	lock_contention_end(sem, wait_start, LOCK_CONTENTION_RWSEM_WRITE);
 
 	return sem;
 }
@@ -60,6 +60,8 @@
 #include <linux/jump_label.h>
 #include <linux/pfn.h>
 #include <linux/bsearch.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
 #include <linux/fips.h>
 #include <uapi/linux/module.h>
 #include "module-internal.h"
@@ -294,6 +296,25 @@ static bool each_symbol_in_section(const struct symsearch *arr,
 	return false;
 }
 
+static const struct symsearch vmlinux_syms[] = {
+	{ __start___ksymtab, __stop___ksymtab, __start___kcrctab,
+	  NOT_GPL_ONLY, false },
+	{ __start___ksymtab_gpl, __stop___ksymtab_gpl,
+	  __start___kcrctab_gpl,
+	  GPL_ONLY, false },
+	{ __start___ksymtab_gpl_future, __stop___ksymtab_gpl_future,
+	  __start___kcrctab_gpl_future,
+	  WILL_BE_GPL_ONLY, false },
+#ifdef CONFIG_UNUSED_SYMBOLS
+	{ __start___ksymtab_unused, __stop___ksymtab_unused,
+	  __start___kcrctab_unused,
+	  NOT_GPL_ONLY, true },
+	{ __start___ksymtab_unused_gpl, __stop___ksymtab_unused_gpl,
+	  __start___kcrctab_unused_gpl,
+	  GPL_ONLY, true },
+#endif
+};
+
 /* Returns true as soon as fn returns true, otherwise false. */
 bool each_symbol_section(bool (*fn)(const struct symsearch *arr,
 				    struct module *owner,
@@ -301,26 +322,9 @@ bool each_symbol_section(bool (*fn)(const struct symsearch *arr,
 			 void *data)
 {
 	struct module *mod;
-	static const struct symsearch arr[] = {
-		{ __start___ksymtab, __stop___ksymtab, __start___kcrctab,
-		  NOT_GPL_ONLY, false },
-		{ __start___ksymtab_gpl, __stop___ksymtab_gpl,
-		  __start___kcrctab_gpl,
-		  GPL_ONLY, false },
-		{ __start___ksymtab_gpl_future, __stop___ksymtab_gpl_future,
-		  __start___kcrctab_gpl_future,
-		  WILL_BE_GPL_ONLY, false },
-#ifdef CONFIG_UNUSED_SYMBOLS
-		{ __start___ksymtab_unused, __stop___ksymtab_unused,
-		  __start___kcrctab_unused,
-		  NOT_GPL_ONLY, true },
-		{ __start___ksymtab_unused_gpl, __stop___ksymtab_unused_gpl,
-		  __start___kcrctab_unused_gpl,
-		  GPL_ONLY, true },
-#endif
-	};
 
-	if (each_symbol_in_section(arr, ARRAY_SIZE(arr), NULL, fn, data))
+	if (each_symbol_in_section(vmlinux_syms, ARRAY_SIZE(vmlinux_syms),
+				   NULL, fn, data))
 		return true;
 
 	list_for_each_entry_rcu(mod, &modules, list) {
@@ -361,6 +365,7 @@ struct find_symbol_arg {
 	const char *name;
 	bool gplok;
 	bool warn;
+	bool skip_vmlinux;
 
 	/* Output */
 	struct module *owner;
@@ -417,6 +422,9 @@ static bool find_symbol_in_section(const struct symsearch *syms,
 	struct find_symbol_arg *fsa = data;
 	struct kernel_symbol *sym;
 
+	if (!owner && fsa->skip_vmlinux)
+		return false;
+
 	sym = bsearch(fsa->name, syms->start, syms->stop - syms->start,
 			sizeof(struct kernel_symbol), cmp_name);
 
@@ -426,6 +434,87 @@ static bool find_symbol_in_section(const struct symsearch *syms,
 	return false;
 }
 
+/*
+ * Loading a module looks up every undefined symbol, and almost all of them
+ * are exported by vmlinux.  Rather than bsearch each of the kernel's symbol
+ * tables in turn, hash all of them once at boot.  Slots hold the index of
+ * the symbol across the concatenated tables plus one, zero means empty.
+ */
+static u16 *ksym_hash __read_mostly;
+static unsigned int ksym_hash_mask __read_mostly;
+
+static unsigned int ksym_hash_name(const char *name)
+{
+	unsigned int h = 0;
+
+	while (*name)
+		h = h * 31 + *name++;
+	return h;
+}
+
+static const struct kernel_symbol *ksym_hash_entry(unsigned int idx,
+						   const struct symsearch **syms)
+{
+	unsigned int i, n;
+
+	for (i = 0; i < ARRAY_SIZE(vmlinux_syms); i++) {
+		n = vmlinux_syms[i].stop - vmlinux_syms[i].start;
+		if (idx < n) {
+			*syms = &vmlinux_syms[i];
+			return &vmlinux_syms[i].start[idx];
+		}
+		idx -= n;
+	}
+	return NULL;
+}
+
+static bool find_symbol_hashed(struct find_symbol_arg *fsa)
+{
+	const struct symsearch *syms;
+	const struct kernel_symbol *sym;
+	unsigned int h = ksym_hash_name(fsa->name) & ksym_hash_mask;
+
+	for (; ksym_hash[h]; h = (h + 1) & ksym_hash_mask) {
+		sym = ksym_hash_entry(ksym_hash[h] - 1, &syms);
+		if (strcmp(sym->name, fsa->name) == 0)
+			return check_symbol(syms, NULL, sym - syms->start, fsa);
+	}
+	return false;
+}
+
+static int __init ksym_hash_init(void)
+{
+	const struct symsearch *syms;
+	const struct kernel_symbol *sym;
+	unsigned int i, h, nsyms = 0;
+	u16 *table;
+
+	for (i = 0; i < ARRAY_SIZE(vmlinux_syms); i++)
+		nsyms += vmlinux_syms[i].stop - vmlinux_syms[i].start;
+	if (!nsyms || nsyms >= U16_MAX)
+		return 0;
+
+	/* Keep the load factor at or below one half */
+	h = roundup_pow_of_two(nsyms * 2);
+	table = vzalloc(h * sizeof(*table));
+	if (!table)
+		return -ENOMEM;
+	ksym_hash_mask = h - 1;
+
+	for (i = 0; i < nsyms; i++) {
+		sym = ksym_hash_entry(i, &syms);
+		h = ksym_hash_name(sym->name) & ksym_hash_mask;
+		while (table[h])
+			h = (h + 1) & ksym_hash_mask;
+		table[h] = i + 1;
+	}
+
+	smp_wmb();
+	ksym_hash = table;
+	return 0;
+}
+core_initcall(ksym_hash_init);
+
 /* Find a symbol and return it, along with, (optional) crc and
  * (optional) module which owns it.  Needs preempt disabled or module_mutex. */
 const struct kernel_symbol *find_symbol(const char *name,
@@ -439,8 +528,10 @@ const struct kernel_symbol *find_symbol(const char *name,
 	fsa.name = name;
 	fsa.gplok = gplok;
 	fsa.warn = warn;
+	fsa.skip_vmlinux = ksym_hash != NULL;
 
-	if (each_symbol_section(find_symbol_in_section, &fsa)) {
+	if ((fsa.skip_vmlinux && find_symbol_hashed(&fsa)) ||
+	    each_symbol_section(find_symbol_in_section, &fsa)) {
 		if (owner)
 			*owner = fsa.owner;
 		if (crc)
@@ -45,6 +45,7 @@
 #include <linux/poll.h>
 #include <linux/irq_work.h>
 #include <linux/utsname.h>
+#include <linux/kthread.h>
 
 #include <asm/uaccess.h>
 
@@ -1483,6 +1484,18 @@ static size_t cont_print_text(char *text, size_t size)
 	return textlen;
 }
 
+/*
+ * With deferred console output printk() only stores the message and the
+ * printk kthread pushes it to the consoles, so that callers never wait
+ * for a slow serial console.  Oopses still print synchronously.
+ */
+static bool console_deferred;
+module_param_named(deferred_console, console_deferred, bool,
+		   S_IRUGO | S_IWUSR);
+
+static struct task_struct *printk_kthread;
+static void defer_console_output(void);
+
 asmlinkage int vprintk_emit(int facility, int level,
 			    const char *dict, size_t dictlen,
 			    const char *fmt, va_list args)
@@ -1617,8 +1630,14 @@ asmlinkage int vprintk_emit(int facility, int level,
 	 *
 	 * The console_trylock_for_printk() function will release 'logbuf_lock'
 	 * regardless of whether it actually gets the console semaphore or not.
+	 *
+	 * In deferred mode just release 'logbuf_lock' and kick the kthread.
 	 */
-	if (console_trylock_for_printk(this_cpu))
+	if (console_deferred && printk_kthread && !oops_in_progress) {
+		logbuf_cpu = UINT_MAX;
+		raw_spin_unlock(&logbuf_lock);
+		defer_console_output();
+	} else if (console_trylock_for_printk(this_cpu))
 		console_unlock();
 
 	lockdep_on();
@@ -2436,10 +2455,14 @@ late_initcall(printk_late_init);
 
 #define PRINTK_PENDING_WAKEUP	0x01
 #define PRINTK_PENDING_SCHED	0x02
+#define PRINTK_PENDING_OUTPUT	0x04
 
 static DEFINE_PER_CPU(int, printk_pending);
 static DEFINE_PER_CPU(char [PRINTK_BUF_SIZE], printk_sched_buf);
 
+static DECLARE_WAIT_QUEUE_HEAD(printk_kthread_wait);
+static int printk_kthread_pending;
+
 static void wake_up_klogd_work_func(struct irq_work *irq_work)
 {
 	int pending = __this_cpu_xchg(printk_pending, 0);
@@ -2449,6 +2472,11 @@ static void wake_up_klogd_work_func(struct irq_work *irq_work)
 		pr_warn("[sched_delayed] %s", buf);
 	}
 
+	if (pending & PRINTK_PENDING_OUTPUT) {
+		printk_kthread_pending = 1;
+		wake_up(&printk_kthread_wait);
+	}
+
 	if (pending & PRINTK_PENDING_WAKEUP)
 		wake_up_interruptible(&log_wait);
 }
@@ -2468,6 +2496,42 @@ void wake_up_klogd(void)
 	preempt_enable();
 }
 
+/*
+ * Called from vprintk_emit() in any context, possibly with scheduler
+ * locks held, so the kthread is woken from irq_work.
+ */
+static void defer_console_output(void)
+{
+	preempt_disable();
+	this_cpu_or(printk_pending, PRINTK_PENDING_OUTPUT);
+	irq_work_queue(&__get_cpu_var(wake_up_klogd_work));
+	preempt_enable();
+}
+
+static int printk_kthread_func(void *unused)
+{
+	for (;;) {
+		wait_event_interruptible(printk_kthread_wait,
+					 printk_kthread_pending);
+		printk_kthread_pending = 0;
+		console_lock();
+		console_unlock();
+	}
+	return 0;
+}
+
+static int __init printk_kthread_init(void)
+{
+	struct task_struct *t;
+
+	t = kthread_run(printk_kthread_func, NULL, "printk");
+	if (IS_ERR(t))
+		return PTR_ERR(t);
+	printk_kthread = t;
+	return 0;
+}
+late_initcall(printk_kthread_init);
+
 int printk_deferred(const char *fmt, ...)
 {
 	unsigned long flags;
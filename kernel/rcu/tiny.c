@@ -36,6 +36,9 @@
 #include <linux/cpu.h>
 #include <linux/prefetch.h>
 #include <linux/ftrace_event.h>
+#include <linux/kthread.h>
+#include <linux/wait.h>
+#include <linux/moduleparam.h>
 
 #ifdef CONFIG_RCU_TRACE
 #include <trace/events/rcu.h>
@@ -43,9 +46,30 @@
 
 #include "rcu.h"
 
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "rcutiny."
+
+/*
+ * Maximum number of callbacks invoked per pass, 0 for no limit.  When
+ * the limit is hit the remaining callbacks are left for another pass,
+ * so a burst of frees is spread over several softirq runs.
+ */
+static int blimit;
+module_param(blimit, int, 0644);
+
+/* Invoke callbacks from the rcu_kthread task instead of from softirq. */
+static bool use_kthread;
+module_param_named(kthread, use_kthread, bool, 0444);
+
+static struct task_struct *rcu_kthread_task;
+static DECLARE_WAIT_QUEUE_HEAD(rcu_kthread_wq);
+static int have_rcu_kthread_work;
+
 /* Forward declarations for tiny_plugin.h. */
 struct rcu_ctrlblk;
-static void __rcu_process_callbacks(struct rcu_ctrlblk *rcp);
+static bool __rcu_process_callbacks(struct rcu_ctrlblk *rcp);
 static void rcu_process_callbacks(struct softirq_action *unused);
 static void __call_rcu(struct rcu_head *head,
 		       void (*func)(struct rcu_head *rcu),
@@ -210,6 +234,7 @@ static int rcu_qsctr_help(struct rcu_ctrlblk *rcp)
 	if (rcp->rcucblist != NULL &&
 	    rcp->donetail != rcp->curtail) {
 		rcp->donetail = rcp->curtail;
+		RCU_TRACE(rcp->n_gps++);
 		return 1;
 	}
 
@@ -262,13 +287,16 @@ void rcu_check_callbacks(int cpu, int user)
 
 /*
  * Invoke the RCU callbacks on the specified rcu_ctrlkblk structure
- * whose grace period has elapsed.
+ * whose grace period has elapsed.  Returns true if blimit left some
+ * ready callbacks behind.
  */
-static void __rcu_process_callbacks(struct rcu_ctrlblk *rcp)
+static bool __rcu_process_callbacks(struct rcu_ctrlblk *rcp)
 {
 	const char *rn = NULL;
-	struct rcu_head *next, *list;
+	struct rcu_head *next, *list, **tail;
 	unsigned long flags;
+	int bl = ACCESS_ONCE(blimit);
+	bool more;
 	RCU_TRACE(int cb_count = 0);
 
 	/* If no RCU callbacks ready to invoke, just return. */
@@ -279,18 +307,28 @@ static void __rcu_process_callbacks(struct rcu_ctrlblk *rcp)
 					      need_resched(),
 					      is_idle_task(current),
 					      false));
-		return;
+		return false;
 	}
 
-	/* Move the ready-to-invoke callbacks to a local list. */
+	/* Move up to blimit ready-to-invoke callbacks to a local list. */
 	local_irq_save(flags);
-	RCU_TRACE(trace_rcu_batch_start(rcp->name, 0, rcp->qlen, -1));
+	RCU_TRACE(trace_rcu_batch_start(rcp->name, 0, rcp->qlen, bl));
 	list = rcp->rcucblist;
-	rcp->rcucblist = *rcp->donetail;
-	*rcp->donetail = NULL;
-	if (rcp->curtail == rcp->donetail)
+	tail = rcp->donetail;
+	if (bl > 0) {
+		int n = 0;
+
+		for (tail = &rcp->rcucblist;
+		     tail != rcp->donetail && n < bl; n++)
+			tail = &(*tail)->next;
+	}
+	rcp->rcucblist = *tail;
+	*tail = NULL;
+	if (rcp->curtail == tail)
 		rcp->curtail = &rcp->rcucblist;
-	rcp->donetail = &rcp->rcucblist;
+	if (rcp->donetail == tail)
+		rcp->donetail = &rcp->rcucblist;
+	more = rcp->donetail != &rcp->rcucblist;
 	local_irq_restore(flags);
 
 	/* Invoke the callbacks on the local list. */
@@ -306,17 +344,61 @@ static void __rcu_process_callbacks(struct rcu_ctrlblk *rcp)
 		RCU_TRACE(cb_count++);
 	}
 	RCU_TRACE(rcu_trace_sub_qlen(rcp, cb_count));
+	RCU_TRACE(rcu_trace_batch(rcp, cb_count));
 	RCU_TRACE(trace_rcu_batch_end(rcp->name,
-				      cb_count, 0, need_resched(),
+				      cb_count, more, need_resched(),
 				      is_idle_task(current),
 				      false));
+	return more;
+}
+
+static bool rcu_process_both(void)
+{
+	/* Use "|" rather than "||" so that both flavors make progress. */
+	return __rcu_process_callbacks(&rcu_sched_ctrlblk) |
+	       __rcu_process_callbacks(&rcu_bh_ctrlblk);
 }
 
+/*
+ * In kthread mode the softirq only hands the work over, which keeps
+ * the callbacks themselves out of softirq context.
+ */
 static void rcu_process_callbacks(struct softirq_action *unused)
 {
-	__rcu_process_callbacks(&rcu_sched_ctrlblk);
-	__rcu_process_callbacks(&rcu_bh_ctrlblk);
+	if (rcu_kthread_task) {
+		have_rcu_kthread_work = 1;
+		wake_up(&rcu_kthread_wq);
+		return;
+	}
+	if (rcu_process_both())
+		raise_softirq(RCU_SOFTIRQ);
+}
+
+static int rcu_kthread(void *arg)
+{
+	for (;;) {
+		wait_event_interruptible(rcu_kthread_wq,
+					 ACCESS_ONCE(have_rcu_kthread_work));
+		have_rcu_kthread_work = 0;
+		while (rcu_process_both())
+			cond_resched();
+	}
+	return 0;
+}
+
+static int __init rcu_spawn_kthread(void)
+{
+	struct task_struct *t;
+
+	if (!use_kthread)
+		return 0;
+	t = kthread_run(rcu_kthread, NULL, "rcu_kthread");
+	if (IS_ERR(t))
+		return PTR_ERR(t);
+	rcu_kthread_task = t;
+	return 0;
 }
+early_initcall(rcu_spawn_kthread);
 
 /*
  * Wait for a grace period to elapse.  But it is illegal to invoke
@@ -37,6 +37,9 @@ struct rcu_ctrlblk {
 	RCU_TRACE(unsigned long ticks_this_gp); /* Statistic for stalls. */
 	RCU_TRACE(unsigned long jiffies_stall); /* Jiffies at next stall. */
 	RCU_TRACE(const char *name);	/* Name of RCU type. */
+	RCU_TRACE(unsigned long n_gps);	/* GPs that had callbacks. */
+	RCU_TRACE(unsigned long n_cbs);	/* Callbacks invoked. */
+	RCU_TRACE(unsigned long max_batch); /* Most CBs in one pass. */
 };
 
 /* Definition for rcupdate control block. */
@@ -81,13 +84,27 @@ static void rcu_trace_sub_qlen(struct rcu_ctrlblk *rcp, int n)
 	local_irq_restore(flags);
 }
 
+static void rcu_trace_batch(struct rcu_ctrlblk *rcp, int n)
+{
+	rcp->n_cbs += n;
+	if (n > rcp->max_batch)
+		rcp->max_batch = n;
+}
+
+static void show_tiny_ctrlblk(struct seq_file *m, struct rcu_ctrlblk *rcp)
+{
+	seq_printf(m, "%s: qlen: %ld gps: %lu cbs: %lu cbs/gp: %lu max_batch: %lu\n",
+		   rcp->name, rcp->qlen, rcp->n_gps, rcp->n_cbs,
+		   rcp->n_gps ? rcp->n_cbs / rcp->n_gps : 0, rcp->max_batch);
+}
+
 /*
  * Dump statistics for TINY_RCU, such as they are.
  */
 static int show_tiny_stats(struct seq_file *m, void *unused)
 {
-	seq_printf(m, "rcu_sched: qlen: %ld\n", rcu_sched_ctrlblk.qlen);
-	seq_printf(m, "rcu_bh: qlen: %ld\n", rcu_bh_ctrlblk.qlen);
+	show_tiny_ctrlblk(m, &rcu_sched_ctrlblk);
+	show_tiny_ctrlblk(m, &rcu_bh_ctrlblk);
 	return 0;
 }
 
@@ -414,6 +414,24 @@ static void update_dl_entity(struct sched_dl_entity *dl_se,
 		return;
 	}
 
+	/*
+	 * With SCHED_FLAG_DL_WAKEUP_PERIOD the period is paced by whatever
+	 * the task blocks on between instances (a timerfd, an eventfd
+	 * signalled from a driver's period interrupt, ...): each wakeup
+	 * starts a fresh instance, provided at least dl_period passed since
+	 * the current one began. That is the sporadic task model, so the
+	 * admission test done for dl_runtime/dl_period still holds, but
+	 * the budget is refilled in phase with the hardware rather than
+	 * with our own replenishment timer.
+	 */
+	if ((dl_se->flags & SCHED_FLAG_DL_WAKEUP_PERIOD) &&
+	    !dl_time_before(rq_clock(rq), dl_se->deadline -
+			    pi_se->dl_deadline + pi_se->dl_period)) {
+		dl_se->deadline = rq_clock(rq) + pi_se->dl_deadline;
+		dl_se->runtime = pi_se->dl_runtime;
+		return;
+	}
+
 	if (dl_time_before(dl_se->deadline, rq_clock(rq)) ||
 	    dl_entity_overflow(dl_se, pi_se, rq_clock(rq))) {
 		dl_se->deadline = rq_clock(rq) + pi_se->dl_deadline;
@@ -2530,6 +2530,15 @@ place_entity(struct cfs_rq *cfs_rq, struct sched_entity *se, int initial)
 		if (sched_feat(GENTLE_FAIR_SLEEPERS))
 			thresh >>= 1;
 
+		/*
+		 * Latency sensitive tasks get up to twice the sleeper
+		 * credit, so they are queued ahead of the pack. This
+		 * still can't exceed what they actually slept, hence it
+		 * buys no CPU share.
+		 */
+		if (se->latency_nice < 0)
+			thresh += thresh * -se->latency_nice / 20;
+
 		vruntime -= thresh;
 	}
 
@@ -4339,6 +4348,14 @@ wakeup_gran(struct sched_entity *curr, struct sched_entity *se)
 {
 	unsigned long gran = sysctl_sched_wakeup_granularity;
 
+	/*
+	 * Scale the granularity by the waking entity's latency nice:
+	 * -20 preempts on any vruntime lead, 19 needs about twice the
+	 * default lead.
+	 */
+	if (se->latency_nice)
+		gran += (long)gran * se->latency_nice / 20;
+
 	/*
 	 * Since its curr running now, convert the gran from real-time
 	 * to virtual-time in his units.
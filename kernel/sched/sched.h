@@ -32,6 +32,13 @@ extern void update_cpu_load_active(struct rq *this_rq);
 #define PRIO_TO_NICE(prio)	((prio) - MAX_RT_PRIO - 20)
 #define TASK_NICE(p)		PRIO_TO_NICE((p)->static_prio)
 
+/*
+ * Latency nice shares the range of nice but does not touch the load
+ * weight; it only biases wakeup preemption and placement.
+ */
+#define MIN_LATENCY_NICE	(-20)
+#define MAX_LATENCY_NICE	19
+
 /*
  * 'User priority' is the nice value converted to something we
  * can work with better when scaling various scheduler parameters,
@@ -647,6 +654,10 @@ struct rq {
 	unsigned int ttwu_count;
 	unsigned int ttwu_local;
 #endif
+#ifdef CONFIG_SCHED_LAT_HIST
+	/* wakeup-to-run latency of all tasks run here */
+	struct sched_lat_hist lat_hist;
+#endif
 
 #ifdef CONFIG_SMP
 	struct llist_head wake_list;
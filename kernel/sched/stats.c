@@ -137,9 +137,84 @@ static const struct file_operations proc_schedstat_operations = {
 	.release = seq_release,
 };
 
+#ifdef CONFIG_SCHED_LAT_HIST
+/* lower bound of each latency bucket, in ns */
+static inline u64 sched_lat_bucket_floor(int i)
+{
+	return i ? 1ULL << (9 + i) : 0;
+}
+
+void proc_sched_lat_show_task(struct task_struct *p, struct seq_file *m)
+{
+	int i;
+
+	for (i = 0; i < SCHED_LAT_BUCKETS; i++)
+		seq_printf(m, "%llu %u\n", sched_lat_bucket_floor(i),
+			   p->lat_hist.bucket[i]);
+}
+
+void proc_sched_lat_reset_task(struct task_struct *p)
+{
+	memset(p->lat_hist.bucket, 0, sizeof(p->lat_hist.bucket));
+}
+
+static int show_sched_lat(struct seq_file *seq, void *v)
+{
+	int cpu, i;
+
+	seq_puts(seq, "ns");
+	for (i = 0; i < SCHED_LAT_BUCKETS; i++)
+		seq_printf(seq, " %llu", sched_lat_bucket_floor(i));
+	seq_putc(seq, '\n');
+
+	for_each_online_cpu(cpu) {
+		struct rq *rq = cpu_rq(cpu);
+
+		seq_printf(seq, "cpu%d", cpu);
+		for (i = 0; i < SCHED_LAT_BUCKETS; i++)
+			seq_printf(seq, " %u", rq->lat_hist.bucket[i]);
+		seq_putc(seq, '\n');
+	}
+	return 0;
+}
+
+static ssize_t sched_lat_write(struct file *file, const char __user *buf,
+			       size_t count, loff_t *ppos)
+{
+	unsigned long flags;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct rq *rq = cpu_rq(cpu);
+
+		raw_spin_lock_irqsave(&rq->lock, flags);
+		memset(rq->lat_hist.bucket, 0, sizeof(rq->lat_hist.bucket));
+		raw_spin_unlock_irqrestore(&rq->lock, flags);
+	}
+	return count;
+}
+
+static int sched_lat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, show_sched_lat, NULL);
+}
+
+static const struct file_operations proc_sched_lat_operations = {
+	.open    = sched_lat_open,
+	.read    = seq_read,
+	.write   = sched_lat_write,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+#endif
+
 static int __init proc_schedstat_init(void)
 {
 	proc_create("schedstat", 0, NULL, &proc_schedstat_operations);
+#ifdef CONFIG_SCHED_LAT_HIST
+	proc_create("sched_latency", S_IRUGO | S_IWUSR, NULL,
+		    &proc_sched_lat_operations);
+#endif
 	return 0;
 }
 module_init(proc_schedstat_init);
@@ -47,6 +47,40 @@ rq_sched_info_depart(struct rq *rq, unsigned long long delta)
 # define schedstat_set(var, val)	do { } while (0)
 #endif
 
+#ifdef CONFIG_SCHED_LAT_HIST
+/*
+ * Called with the runqueue lock held when @p is enqueued by a wakeup.
+ */
+static inline void sched_lat_wakeup(struct rq *rq, struct task_struct *p)
+{
+	p->lat_hist.wake_stamp = rq_clock(rq) ? : 1;
+}
+
+/*
+ * Called with the runqueue lock held when @p is picked to run. Only the
+ * first pick after a wakeup is accounted; preemptions are not wakeups.
+ */
+static inline void sched_lat_arrive(struct rq *rq, struct task_struct *p)
+{
+	u64 delta;
+	int idx = 0;
+
+	if (!p->lat_hist.wake_stamp)
+		return;
+
+	delta = rq_clock(rq) - p->lat_hist.wake_stamp;
+	p->lat_hist.wake_stamp = 0;
+	if ((s64)delta >= 1024)
+		idx = min(fls64(delta) - 10, SCHED_LAT_BUCKETS - 1);
+
+	p->lat_hist.bucket[idx]++;
+	rq->lat_hist.bucket[idx]++;
+}
+#else
+static inline void sched_lat_wakeup(struct rq *rq, struct task_struct *p) { }
+static inline void sched_lat_arrive(struct rq *rq, struct task_struct *p) { }
+#endif
+
 #if defined(CONFIG_SCHEDSTATS) || defined(CONFIG_TASK_DELAY_ACCT)
 static inline void sched_info_reset_dequeued(struct task_struct *t)
 {
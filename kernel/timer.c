@@ -42,6 +42,8 @@
 #include <linux/sched/sysctl.h>
 #include <linux/slab.h>
 #include <linux/compat.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include <asm/uaccess.h>
 #include <asm/unistd.h>
@@ -81,6 +83,7 @@ struct tvec_base {
 	unsigned long timer_jiffies;
 	unsigned long next_timer;
 	unsigned long active_timers;
+	unsigned long wakeups;
 	struct tvec_root tv1;
 	struct tvec tv2;
 	struct tvec tv3;
@@ -92,6 +95,13 @@ struct tvec_base boot_tvec_bases;
 EXPORT_SYMBOL(boot_tvec_bases);
 static DEFINE_PER_CPU(struct tvec_base *, tvec_bases) = &boot_tvec_bases;
 
+/*
+ * When non-zero, timers which did not ask for a specific slack are
+ * rounded up to a multiple of this many milliseconds so that timers
+ * from unrelated drivers expire on the same tick.
+ */
+unsigned int sysctl_timer_coalesce_ms __read_mostly;
+
 /* Functions below help us manage 'deferrable' flag */
 static inline unsigned int tbase_get_deferrable(struct tvec_base *base)
 {
@@ -799,6 +809,10 @@ EXPORT_SYMBOL(mod_timer_pending);
  *   3) use this bit to make a mask
  *   4) use the bitmask to round down the maximum time, so that all last
  *      bits are zeros
+ *
+ * With timer coalescing enabled, deferrable timers and default-slack
+ * timers at least eight granules out are instead rounded up to the
+ * next coalescing boundary.
  */
 static inline
 unsigned long apply_slack(struct timer_list *timer, unsigned long expires)
@@ -806,6 +820,15 @@ unsigned long apply_slack(struct timer_list *timer, unsigned long expires)
 	unsigned long expires_limit, mask;
 	int bit;
 
+	if (sysctl_timer_coalesce_ms && timer->slack < 0) {
+		unsigned long gran = msecs_to_jiffies(sysctl_timer_coalesce_ms);
+		long delta = expires - jiffies;
+
+		if (gran > 1 && (tbase_get_deferrable(timer->base) ||
+				 delta >= 8 * (long)gran))
+			return roundup(expires, gran);
+	}
+
 	if (timer->slack >= 0) {
 		expires_limit = expires + timer->slack;
 	} else {
@@ -1144,6 +1167,7 @@ static void call_timer_fn(struct timer_list *timer, void (*fn)(unsigned long),
 static inline void __run_timers(struct tvec_base *base)
 {
 	struct timer_list *timer;
+	bool fired = false;
 
 	spin_lock_irq(&base->lock);
 	while (time_after_eq(jiffies, base->timer_jiffies)) {
@@ -1172,6 +1196,7 @@ static inline void __run_timers(struct tvec_base *base)
 			irqsafe = tbase_get_irqsafe(timer->base);
 
 			timer_stats_account_timer(timer);
+			fired = true;
 
 			base->running_timer = timer;
 			detach_expired_timer(timer, base);
@@ -1188,6 +1213,8 @@ static inline void __run_timers(struct tvec_base *base)
 		}
 	}
 	base->running_timer = NULL;
+	if (fired)
+		base->wakeups++;
 	spin_unlock_irq(&base->lock);
 }
 
@@ -1655,6 +1682,52 @@ void __init init_timers(void)
 	open_softirq(TIMER_SOFTIRQ, run_timer_softirq);
 }
 
+#ifdef CONFIG_DEBUG_FS
+/*
+ * Number of timer softirq runs which expired at least one timer, in
+ * total and per second since the previous read.
+ */
+static int timer_wakeups_show(struct seq_file *m, void *v)
+{
+	static unsigned long last_total, last_jiffies = INITIAL_JIFFIES;
+	unsigned long total = 0, now = jiffies, secs;
+	int cpu;
+
+	for_each_online_cpu(cpu)
+		total += per_cpu(tvec_bases, cpu)->wakeups;
+
+	secs = DIV_ROUND_UP(now - last_jiffies, HZ);
+	seq_printf(m, "coalesce_ms %u\n", sysctl_timer_coalesce_ms);
+	seq_printf(m, "wakeups %lu\n", total);
+	seq_printf(m, "wakeups_per_sec %lu\n",
+		   secs ? (total - last_total) / secs : 0);
+
+	last_total = total;
+	last_jiffies = now;
+	return 0;
+}
+
+static int timer_wakeups_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, timer_wakeups_show, NULL);
+}
+
+static const struct file_operations timer_wakeups_fops = {
+	.open		= timer_wakeups_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init timer_wakeups_debugfs_init(void)
+{
+	debugfs_create_file("timer_wakeups", 0444, NULL, NULL,
+			    &timer_wakeups_fops);
+	return 0;
+}
+late_initcall(timer_wakeups_debugfs_init);
+#endif
+
 /**
  * msleep - sleep safely even with waitqueue interruptions
  * @msecs: Time in milliseconds to sleep for
@@ -6377,12 +6377,13 @@ trace_printk_seq(struct trace_seq *s)
 	trace_seq_init(s);
 }
 
-void trace_init_global_iter(struct trace_iterator *iter)
+static void trace_init_iter(struct trace_iterator *iter,
+			    struct trace_array *tr)
 {
-	iter->tr = &global_trace;
+	iter->tr = tr;
 	iter->trace = iter->tr->current_trace;
 	iter->cpu_file = RING_BUFFER_ALL_CPUS;
-	iter->trace_buffer = &global_trace.trace_buffer;
+	iter->trace_buffer = &tr->trace_buffer;
 
 	if (iter->trace && iter->trace->open)
 		iter->trace->open(iter);
@@ -6396,16 +6397,42 @@ void trace_init_global_iter(struct trace_iterator *iter)
 		iter->iter_flags |= TRACE_FILE_TIME_IN_NS;
 }
 
+void trace_init_global_iter(struct trace_iterator *iter)
+{
+	trace_init_iter(iter, &global_trace);
+}
+
+/* Only allow one dump user at a time. */
+static atomic_t dump_running;
+
+/* Format and consume the next entry of a dump into iter->seq */
+static void trace_dump_next_entry(struct trace_iterator *iter)
+{
+	/* reset all but tr, trace, and overruns */
+	memset(&iter->seq, 0,
+	       sizeof(struct trace_iterator) -
+	       offsetof(struct trace_iterator, seq));
+	iter->iter_flags |= TRACE_FILE_LAT_FMT;
+	iter->pos = -1;
+
+	if (trace_find_next_entry_inc(iter) != NULL) {
+		int ret;
+
+		ret = print_trace_line(iter);
+		if (ret != TRACE_TYPE_NO_CONSUME)
+			trace_consume(iter);
+	}
+	touch_nmi_watchdog();
+}
+
 void ftrace_dump(enum ftrace_dump_mode oops_dump_mode)
 {
 	/* use static because iter can be a bit big for the stack */
 	static struct trace_iterator iter;
-	static atomic_t dump_running;
 	unsigned int old_userobj;
 	unsigned long flags;
 	int cnt = 0, cpu;
 
-	/* Only allow one dump user at a time. */
 	if (atomic_inc_return(&dump_running) != 1) {
 		atomic_dec(&dump_running);
 		return;
@@ -6471,22 +6498,7 @@ void ftrace_dump(enum ftrace_dump_mode oops_dump_mode)
 
 		cnt++;
 
-		/* reset all but tr, trace, and overruns */
-		memset(&iter.seq, 0,
-		       sizeof(struct trace_iterator) -
-		       offsetof(struct trace_iterator, seq));
-		iter.iter_flags |= TRACE_FILE_LAT_FMT;
-		iter.pos = -1;
-
-		if (trace_find_next_entry_inc(&iter) != NULL) {
-			int ret;
-
-			ret = print_trace_line(&iter);
-			if (ret != TRACE_TYPE_NO_CONSUME)
-				trace_consume(&iter);
-		}
-		touch_nmi_watchdog();
-
+		trace_dump_next_entry(&iter);
 		trace_printk_seq(&iter.seq);
 	}
 
@@ -6506,6 +6518,86 @@ void ftrace_dump(enum ftrace_dump_mode oops_dump_mode)
 }
 EXPORT_SYMBOL_GPL(ftrace_dump);
 
+/**
+ * trace_array_get_by_name - look up a trace instance and hold a reference
+ * @name: name of the instance, as created in the instances directory
+ *
+ * The instance cannot be removed until the reference is dropped with
+ * trace_array_put(). Returns NULL if no such instance exists.
+ */
+struct trace_array *trace_array_get_by_name(const char *name)
+{
+	struct trace_array *tr;
+
+	mutex_lock(&trace_types_lock);
+	list_for_each_entry(tr, &ftrace_trace_arrays, list) {
+		if (tr->name && strcmp(tr->name, name) == 0) {
+			tr->ref++;
+			mutex_unlock(&trace_types_lock);
+			return tr;
+		}
+	}
+	mutex_unlock(&trace_types_lock);
+
+	return NULL;
+}
+
+/**
+ * trace_array_dump - dump the buffer of a trace instance on a crash
+ * @tr: instance, held with trace_array_get_by_name()
+ * @write: called with each formatted line, oldest first
+ * @data: passed to @write
+ *
+ * Like ftrace_dump(), but for an instance and to an arbitrary sink, e.g.
+ * persistent memory. Recording into the instance is stopped and the
+ * entries are consumed, so this is meant to be called once on oops or
+ * panic. May be called with interrupts disabled.
+ */
+void trace_array_dump(struct trace_array *tr,
+		      void (*write)(const char *buf, size_t len, void *data),
+		      void *data)
+{
+	static struct trace_iterator iter;
+	unsigned int old_userobj;
+	unsigned long flags;
+	int cpu;
+
+	if (atomic_inc_return(&dump_running) != 1) {
+		atomic_dec(&dump_running);
+		return;
+	}
+
+	tracer_tracing_off(tr);
+
+	local_irq_save(flags);
+
+	trace_init_iter(&iter, tr);
+
+	for_each_tracing_cpu(cpu) {
+		atomic_inc(&per_cpu_ptr(iter.trace_buffer->data, cpu)->disabled);
+	}
+
+	old_userobj = trace_flags & TRACE_ITER_SYM_USEROBJ;
+
+	/* don't look at user memory in panic mode */
+	trace_flags &= ~TRACE_ITER_SYM_USEROBJ;
+
+	while (!trace_empty(&iter)) {
+		trace_dump_next_entry(&iter);
+		if (iter.seq.len)
+			write(iter.seq.buffer, iter.seq.len, data);
+		trace_seq_init(&iter.seq);
+	}
+
+	trace_flags |= old_userobj;
+
+	for_each_tracing_cpu(cpu) {
+		atomic_dec(&per_cpu_ptr(iter.trace_buffer->data, cpu)->disabled);
+	}
+	atomic_dec(&dump_running);
+	local_irq_restore(flags);
+}
+
 __init static int tracer_alloc_buffers(void)
 {
 	int ring_buf_size;
@@ -48,6 +48,9 @@
 #include <linux/nodemask.h>
 #include <linux/moduleparam.h>
 #include <linux/uaccess.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/shrinker.h>
 
 #include "workqueue_internal.h"
 
@@ -71,6 +74,7 @@ enum {
 	POOL_MANAGE_WORKERS	= 1 << 0,	/* need to manage workers */
 	POOL_DISASSOCIATED	= 1 << 2,	/* cpu can't serve workers */
 	POOL_FREEZING		= 1 << 3,	/* freeze in progress */
+	POOL_RECLAIM		= 1 << 4,	/* memory pressure, shed idlers */
 
 	/* worker flags */
 	WORKER_STARTED		= 1 << 0,	/* started */
@@ -203,6 +207,11 @@ struct pool_workqueue {
 	struct list_head	delayed_works;	/* L: delayed works */
 	struct list_head	pwqs_node;	/* WR: node on wq->pwqs */
 	struct list_head	mayday_node;	/* MD: node on wq->maydays */
+#ifdef CONFIG_WQ_LATENCY_STATS
+	u64			lat_total;	/* L: sum of queue-to-start ns */
+	u64			lat_max;	/* L: worst queue-to-start ns */
+	unsigned long		lat_count;	/* L: nr of works started */
+#endif
 
 	/*
 	 * Release of unbound pwq is punted to system_wq.  See put_pwq()
@@ -777,6 +786,10 @@ static bool too_many_workers(struct worker_pool *pool)
 	if (list_empty(&pool->idle_list))
 		return false;
 
+	/* under memory pressure keep a single idle worker around */
+	if (pool->flags & POOL_RECLAIM)
+		return nr_idle > 1;
+
 	return nr_idle > 2 && (nr_idle - 2) * MAX_IDLE_WORKERS_RATIO >= nr_busy;
 }
 
@@ -1261,6 +1274,31 @@ fail:
 	return -EAGAIN;
 }
 
+#ifdef CONFIG_WQ_LATENCY_STATS
+static inline void wq_stamp_work(struct work_struct *work)
+{
+	work->queued_at = local_clock();
+}
+
+/* called with pool->lock held when @work is about to be executed */
+static inline void wq_account_latency(struct pool_workqueue *pwq,
+				      struct work_struct *work)
+{
+	s64 delta = local_clock() - work->queued_at;
+
+	if (delta < 0)
+		delta = 0;
+	pwq->lat_total += delta;
+	pwq->lat_count++;
+	if (delta > pwq->lat_max)
+		pwq->lat_max = delta;
+}
+#else
+static inline void wq_stamp_work(struct work_struct *work) { }
+static inline void wq_account_latency(struct pool_workqueue *pwq,
+				      struct work_struct *work) { }
+#endif
+
 /**
  * insert_work - insert a work into a pool
  * @pwq: pwq @work belongs to
@@ -1281,6 +1319,7 @@ static void insert_work(struct pool_workqueue *pwq, struct work_struct *work,
 
 	/* we own @work, set data and link */
 	set_work_pwq(work, pwq, extra_flags);
+	wq_stamp_work(work);
 	list_add_tail(&work->entry, head);
 	get_pwq(pwq);
 
@@ -2035,7 +2074,8 @@ static bool maybe_destroy_workers(struct worker_pool *pool)
 		worker = list_entry(pool->idle_list.prev, struct worker, entry);
 		expires = worker->last_active + IDLE_WORKER_TIMEOUT;
 
-		if (time_before(jiffies, expires)) {
+		if (!(pool->flags & POOL_RECLAIM) &&
+		    time_before(jiffies, expires)) {
 			mod_timer(&pool->idle_timer, expires);
 			break;
 		}
@@ -2043,6 +2083,7 @@ static bool maybe_destroy_workers(struct worker_pool *pool)
 		destroy_worker(worker);
 		ret = true;
 	}
+	pool->flags &= ~POOL_RECLAIM;
 
 	return ret;
 }
@@ -2189,6 +2230,7 @@ __acquires(&pool->lock)
 	work_color = get_work_color(work);
 
 	list_del_init(&work->entry);
+	wq_account_latency(pwq, work);
 
 	/*
 	 * CPU intensive works don't participate in concurrency
@@ -4998,6 +5040,108 @@ out_unlock:
 }
 #endif /* CONFIG_FREEZER */
 
+/*
+ * Idle workers are normally kept for IDLE_WORKER_TIMEOUT.  When reclaim
+ * asks, let each pool's manager destroy all but one of them right away;
+ * every worker pins a kernel stack.
+ */
+static unsigned long wq_idle_count(struct shrinker *shrink,
+				   struct shrink_control *sc)
+{
+	struct worker_pool *pool;
+	unsigned long count = 0;
+	int pi;
+
+	rcu_read_lock_sched();
+	for_each_pool(pool, pi)
+		count += max(ACCESS_ONCE(pool->nr_idle) - 1, 0);
+	rcu_read_unlock_sched();
+
+	return count;
+}
+
+static unsigned long wq_idle_scan(struct shrinker *shrink,
+				  struct shrink_control *sc)
+{
+	struct worker_pool *pool;
+	unsigned long freed = 0;
+	int pi;
+
+	rcu_read_lock_sched();
+	for_each_pool(pool, pi) {
+		spin_lock_irq(&pool->lock);
+		if (pool->nr_idle > 1) {
+			freed += pool->nr_idle - 1;
+			pool->flags |= POOL_RECLAIM | POOL_MANAGE_WORKERS;
+			wake_up_worker(pool);
+		}
+		spin_unlock_irq(&pool->lock);
+	}
+	rcu_read_unlock_sched();
+
+	return freed ? freed : SHRINK_STOP;
+}
+
+static struct shrinker wq_idle_shrinker = {
+	.count_objects	= wq_idle_count,
+	.scan_objects	= wq_idle_scan,
+	.seeks		= DEFAULT_SEEKS,
+};
+
+#ifdef CONFIG_WQ_LATENCY_STATS
+static int wq_latency_show(struct seq_file *m, void *v)
+{
+	struct workqueue_struct *wq;
+	struct pool_workqueue *pwq;
+
+	seq_puts(m, "# name count avg_ns max_ns\n");
+
+	mutex_lock(&wq_pool_mutex);
+	list_for_each_entry(wq, &workqueues, list) {
+		u64 total = 0, max = 0;
+		unsigned long count = 0;
+
+		rcu_read_lock_sched();
+		for_each_pwq(pwq, wq) {
+			spin_lock_irq(&pwq->pool->lock);
+			total += pwq->lat_total;
+			count += pwq->lat_count;
+			max = max(max, pwq->lat_max);
+			spin_unlock_irq(&pwq->pool->lock);
+		}
+		rcu_read_unlock_sched();
+
+		seq_printf(m, "%s %lu %llu %llu\n", wq->name, count,
+			   count ? div64_u64(total, count) : 0, max);
+	}
+	mutex_unlock(&wq_pool_mutex);
+	return 0;
+}
+
+static int wq_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wq_latency_show, NULL);
+}
+
+static const struct file_operations wq_latency_fops = {
+	.open		= wq_latency_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+#endif
+
+static int __init wq_late_init(void)
+{
+	register_shrinker(&wq_idle_shrinker);
+#ifdef CONFIG_WQ_LATENCY_STATS
+	debugfs_create_file("workqueue_latency", 0444, NULL, NULL,
+			    &wq_latency_fops);
+#endif
+	return 0;
+}
+late_initcall(wq_late_init);
+
 static void __init wq_numa_init(void)
 {
 	cpumask_var_t *tbl;
@@ -0,0 +1,115 @@
+/*
+ * Microbenchmark for atomic operations
+ *
+ * Prints the average time, and if known the number of CPU cycles, taken by
+ * atomic, bit and spinlock operations on an uncontended cache-hot variable.
+ * A plain and an interrupt-disabling increment are measured for reference.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <linux/atomic.h>
+#include <linux/bitops.h>
+#include <linux/cpufreq.h>
+#include <linux/irqflags.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/sched.h>
+#include <linux/spinlock.h>
+#include <linux/timex.h>
+
+#include <asm/local.h>
+
+static unsigned int iterations = 1000000;
+module_param(iterations, uint, 0444);
+MODULE_PARM_DESC(iterations, "Number of times each operation is run");
+
+static unsigned int khz;
+module_param(khz, uint, 0444);
+MODULE_PARM_DESC(khz, "CPU clock rate in kHz, used when there is no cycle counter and no cpufreq");
+
+static unsigned int bench_plain;
+static unsigned int bench_sink;
+static atomic_t bench_atomic;
+static local_t bench_local;
+static unsigned long bench_bits;
+static DEFINE_SPINLOCK(bench_lock);
+
+static inline void bench_irq_inc(unsigned int *p)
+{
+	unsigned long flags;
+
+	raw_local_irq_save(flags);
+	(*p)++;
+	raw_local_irq_restore(flags);
+}
+
+static void __init bench_report(const char *name, u64 ns, u64 cycles)
+{
+	unsigned int rate = khz ? khz : cpufreq_quick_get(smp_processor_id());
+	u64 ps = div_u64(ns * 1000, iterations);
+	u64 cc;
+
+	if (!cycles)
+		cycles = div_u64(ns * rate, USEC_PER_SEC);
+	if (!cycles) {
+		pr_info("%-20s %5llu.%03llu ns\n", name, ps / 1000, ps % 1000);
+		return;
+	}
+
+	cc = div_u64(cycles * 100, iterations);
+	pr_info("%-20s %5llu.%03llu ns %5llu.%02llu cycles\n", name,
+		ps / 1000, ps % 1000, cc / 100, cc % 100);
+}
+
+#define BENCH(name, op)							\
+do {									\
+	cycles_t c0 = get_cycles();					\
+	u64 t0 = local_clock();						\
+	unsigned int i;							\
+									\
+	for (i = 0; i < iterations; i++)				\
+		op;							\
+	bench_report(name, local_clock() - t0, get_cycles() - c0);	\
+} while (0)
+
+static int __init atomic_bench_init(void)
+{
+	if (!iterations)
+		return -EINVAL;
+
+	pr_info("%u iterations per operation\n", iterations);
+
+	preempt_disable();
+	BENCH("plain increment", ACCESS_ONCE(bench_plain)++);
+	BENCH("irq-off increment", bench_irq_inc(&bench_plain));
+	BENCH("atomic_inc", atomic_inc(&bench_atomic));
+	BENCH("atomic_dec_and_test",
+	      bench_sink += atomic_dec_and_test(&bench_atomic));
+	BENCH("atomic_add_return",
+	      bench_sink += atomic_add_return(2, &bench_atomic));
+	BENCH("atomic_cmpxchg",
+	      bench_sink += atomic_cmpxchg(&bench_atomic, 0, 1));
+	BENCH("local_inc", local_inc(&bench_local));
+	BENCH("set_bit", set_bit(3, &bench_bits));
+	BENCH("test_and_set_bit",
+	      bench_sink += test_and_set_bit(3, &bench_bits));
+	BENCH("spin_lock+unlock",
+	      { spin_lock(&bench_lock); spin_unlock(&bench_lock); });
+	preempt_enable();
+
+	return 0;
+}
+module_init(atomic_bench_init);
+
+static void __exit atomic_bench_exit(void)
+{
+}
+module_exit(atomic_bench_exit);
+
+MODULE_DESCRIPTION("Atomic operations microbenchmark");
+MODULE_LICENSE("GPL");
@@ -30,6 +30,9 @@
 #include <linux/module.h>
 #include <linux/types.h>
 #include <linux/sched.h>
+#include <linux/scatterlist.h>
+#include <linux/slab.h>
+#include <linux/ktime.h>
 #include "crc32defs.h"
 
 #if CRC_LE_BITS > 8
@@ -76,22 +79,49 @@ static void gf2_matrix_square(u32 *square, u32 *mat)
 
 #if CRC_LE_BITS > 8 || CRC_BE_BITS > 8
 
-/* implements slicing-by-4 or slicing-by-8 algorithm */
+#ifdef CONFIG_CRC32_RUNTIME
+/*
+ * Number of bytes folded per table lookup round: 8, 4 or 1.  The slicing
+ * tables are all built, but the slice-by-8 tables span 8KiB and may not
+ * stay in a small L1 dcache between two calls, in which case slicing by
+ * 4 (4KiB of tables touched) or even bytewise (1KiB) is faster.  Zero
+ * picks the fastest of them at boot; until then slice by 8 is used.
+ */
+static int crc32_slices __read_mostly;
+module_param_named(slices, crc32_slices, int, 0444);
+MODULE_PARM_DESC(slices, "Bytes per lookup round (8, 4 or 1, 0 for auto)");
+
+# define CRC_LE_SLICES	ACCESS_ONCE(crc32_slices)
+# define CRC_BE_SLICES	ACCESS_ONCE(crc32_slices)
+#else
+# define CRC_LE_SLICES	(CRC_LE_BITS / 8)
+# define CRC_BE_SLICES	(CRC_BE_BITS / 8)
+#endif
+
+/*
+ * implements slicing-by-4 or slicing-by-8 algorithm, or the plain bytewise
+ * one on the first table if @slices is 1
+ */
 static inline u32
-crc32_body(u32 crc, unsigned char const *buf, size_t len, const u32 (*tab)[256])
+crc32_body(u32 crc, unsigned char const *buf, size_t len, const u32 (*tab)[256],
+	   int slices)
 {
 # ifdef __LITTLE_ENDIAN
 #  define DO_CRC(x) crc = t0[(crc ^ (x)) & 255] ^ (crc >> 8)
 #  define DO_CRC4 (t3[(q) & 255] ^ t2[(q >> 8) & 255] ^ \
 		   t1[(q >> 16) & 255] ^ t0[(q >> 24) & 255])
-#  define DO_CRC8 (t7[(q) & 255] ^ t6[(q >> 8) & 255] ^ \
-		   t5[(q >> 16) & 255] ^ t4[(q >> 24) & 255])
+#  if CRC_LE_BITS == 64
+#   define DO_CRC8 (t7[(q) & 255] ^ t6[(q >> 8) & 255] ^ \
+		    t5[(q >> 16) & 255] ^ t4[(q >> 24) & 255])
+#  endif
 # else
 #  define DO_CRC(x) crc = t0[((crc >> 24) ^ (x)) & 255] ^ (crc << 8)
 #  define DO_CRC4 (t0[(q) & 255] ^ t1[(q >> 8) & 255] ^ \
 		   t2[(q >> 16) & 255] ^ t3[(q >> 24) & 255])
-#  define DO_CRC8 (t4[(q) & 255] ^ t5[(q >> 8) & 255] ^ \
-		   t6[(q >> 16) & 255] ^ t7[(q >> 24) & 255])
+#  if CRC_LE_BITS == 64
+#   define DO_CRC8 (t4[(q) & 255] ^ t5[(q >> 8) & 255] ^ \
+		    t6[(q >> 16) & 255] ^ t7[(q >> 24) & 255])
+#  endif
 # endif
 	const u32 *b;
 	size_t    rem_len;
@@ -99,11 +129,17 @@ crc32_body(u32 crc, unsigned char const *buf, size_t len, const u32 (*tab)[256])
 	size_t i;
 # endif
 	const u32 *t0=tab[0], *t1=tab[1], *t2=tab[2], *t3=tab[3];
-# if CRC_LE_BITS != 32
+# if CRC_LE_BITS == 64
 	const u32 *t4 = tab[4], *t5 = tab[5], *t6 = tab[6], *t7 = tab[7];
 # endif
 	u32 q;
 
+	if (slices == 1) {
+		while (len--)
+			DO_CRC(*buf++);
+		return crc;
+	}
+
 	/* Align it */
 	if (unlikely((long)buf & 3 && len)) {
 		do {
@@ -111,13 +147,13 @@ crc32_body(u32 crc, unsigned char const *buf, size_t len, const u32 (*tab)[256])
 		} while ((--len) && ((long)buf)&3);
 	}
 
-# if CRC_LE_BITS == 32
-	rem_len = len & 3;
-	len = len >> 2;
-# else
-	rem_len = len & 7;
-	len = len >> 3;
-# endif
+	if (slices == 4) {
+		rem_len = len & 3;
+		len = len >> 2;
+	} else {
+		rem_len = len & 7;
+		len = len >> 3;
+	}
 
 	b = (const u32 *)buf;
 # ifdef CONFIG_X86
@@ -127,13 +163,14 @@ crc32_body(u32 crc, unsigned char const *buf, size_t len, const u32 (*tab)[256])
 	for (--b; len; --len) {
 # endif
 		q = crc ^ *++b; /* use pre increment for speed */
-# if CRC_LE_BITS == 32
-		crc = DO_CRC4;
-# else
-		crc = DO_CRC8;
-		q = *++b;
-		crc ^= DO_CRC4;
+# if CRC_LE_BITS == 64
+		if (slices == 8) {
+			crc = DO_CRC8;
+			q = *++b;
+			crc ^= DO_CRC4;
+		} else
 # endif
+			crc = DO_CRC4;
 	}
 	len = rem_len;
 	/* And the last few bytes */
@@ -244,7 +281,7 @@ static inline u32 __pure crc32_le_generic(u32 crc, unsigned char const *p,
 	}
 # else
 	crc = (__force u32) __cpu_to_le32(crc);
-	crc = crc32_body(crc, p, len, tab);
+	crc = crc32_body(crc, p, len, tab, CRC_LE_SLICES);
 	crc = __le32_to_cpu((__force __le32)crc);
 #endif
 	return crc;
@@ -285,6 +322,35 @@ EXPORT_SYMBOL(crc32_le_combine);
 EXPORT_SYMBOL(__crc32c_le);
 EXPORT_SYMBOL(__crc32c_le_combine);
 
+/**
+ * crc32_le_sg() - Calculate crc32_le over the data of a scatterlist
+ * @crc: seed value for computation, as for crc32_le()
+ * @sgl: scatterlist holding the data
+ * @nents: number of entries in @sgl
+ * @len: number of bytes to checksum, starting at the head of @sgl
+ *
+ * The pages are mapped one at a time, so this may be used on highmem
+ * buffers from atomic context.  The result is the same as running
+ * crc32_le() over the concatenated data.
+ */
+u32 crc32_le_sg(u32 crc, struct scatterlist *sgl, unsigned int nents,
+		size_t len)
+{
+	struct sg_mapping_iter miter;
+	size_t n;
+
+	sg_miter_start(&miter, sgl, nents, SG_MITER_ATOMIC | SG_MITER_FROM_SG);
+	while (len && sg_miter_next(&miter)) {
+		n = min(len, miter.length);
+		crc = crc32_le(crc, miter.addr, n);
+		len -= n;
+	}
+	sg_miter_stop(&miter);
+
+	return crc;
+}
+EXPORT_SYMBOL(crc32_le_sg);
+
 /**
  * crc32_be_generic() - Calculate bitwise big-endian Ethernet AUTODIN II CRC32
  * @crc: seed value for computation.  ~0 for Ethernet, sometimes 0 for
@@ -328,7 +394,7 @@ static inline u32 __pure crc32_be_generic(u32 crc, unsigned char const *p,
 	}
 # else
 	crc = (__force u32) __cpu_to_be32(crc);
-	crc = crc32_body(crc, p, len, tab);
+	crc = crc32_body(crc, p, len, tab, CRC_BE_SLICES);
 	crc = __be32_to_cpu((__force __be32)crc);
 # endif
 	return crc;
@@ -348,6 +414,86 @@ u32 __pure crc32_be(u32 crc, unsigned char const *p, size_t len)
 #endif
 EXPORT_SYMBOL(crc32_be);
 
+#ifdef CONFIG_CRC32_RUNTIME
+
+#define CRC32_BENCH_EVICT	(32 * 1024)
+#define CRC32_BENCH_BUF		2048
+#define CRC32_BENCH_HDR		64
+#define CRC32_BENCH_LOOPS	32
+
+/*
+ * Time crc32_le() the way flash filesystems use it: a small header and a
+ * data block, with the rest of the working set having pushed the tables
+ * out of the dcache in between.
+ */
+static s64 __init crc32_bench(int slices, u8 *buf, u8 *evict)
+{
+	s64 ns = 0;
+	ktime_t start;
+	u32 crc = 0;
+	int i;
+
+	crc32_slices = slices;
+	for (i = 0; i < CRC32_BENCH_LOOPS; i++) {
+		memset(evict, i, CRC32_BENCH_EVICT);
+
+		start = ktime_get();
+		crc = crc32_le(crc, buf, CRC32_BENCH_HDR);
+		crc = crc32_le(crc, buf, CRC32_BENCH_BUF);
+		ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+	}
+	buf[0] ^= crc;
+
+	return ns;
+}
+
+static void __init crc32_select_slices(void)
+{
+	static const int candidates[] __initconst = { 8, 4, 1 };
+	int best = 8;
+	s64 ns, best_ns = S64_MAX;
+	u8 *buf, *evict;
+	int i;
+
+	switch (crc32_slices) {
+	case 8:
+	case 4:
+	case 1:
+		return;
+	case 0:
+		break;
+	default:
+		pr_warn("crc32: invalid slices=%d, selecting automatically\n",
+			crc32_slices);
+		crc32_slices = 0;
+	}
+
+	buf = kmalloc(CRC32_BENCH_BUF, GFP_KERNEL);
+	evict = kmalloc(CRC32_BENCH_EVICT, GFP_KERNEL);
+	if (!buf || !evict)
+		goto out;
+
+	memset(buf, 0x5a, CRC32_BENCH_BUF);
+	for (i = 0; i < ARRAY_SIZE(candidates); i++) {
+		ns = crc32_bench(candidates[i], buf, evict);
+		if (ns < best_ns) {
+			best_ns = ns;
+			best = candidates[i];
+		}
+	}
+	pr_info("crc32: using %d byte%s per lookup round\n", best,
+		best == 1 ? "" : "s");
+out:
+	crc32_slices = best;
+	kfree(evict);
+	kfree(buf);
+}
+#else
+static inline void crc32_select_slices(void)
+{
+}
+#endif /* CONFIG_CRC32_RUNTIME */
+
 #ifdef CONFIG_CRC32_SELFTEST
 
 /* 4096 random bytes */
@@ -1161,13 +1307,25 @@ static int __init crc32_combine_test(void)
 	return 0;
 }
 
-static int __init crc32test_init(void)
+static void __init crc32test_init(void)
 {
 	crc32_test();
 	crc32c_test();
 
 	crc32_combine_test();
 	crc32c_combine_test();
+}
+#else
+static inline void crc32test_init(void)
+{
+}
+#endif /* CONFIG_CRC32_SELFTEST */
+
+#if defined(CONFIG_CRC32_RUNTIME) || defined(CONFIG_CRC32_SELFTEST)
+static int __init crc32_init(void)
+{
+	crc32_select_slices();
+	crc32test_init();
 
 	return 0;
 }
@@ -1176,6 +1334,6 @@ static void __exit crc32_exit(void)
 {
 }
 
-module_init(crc32test_init);
+module_init(crc32_init);
 module_exit(crc32_exit);
-#endif /* CONFIG_CRC32_SELFTEST */
+#endif
@@ -137,6 +137,9 @@
 #ifdef CONFIG_SPARC
 #	define XZ_DEC_SPARC
 #endif
+#ifdef CONFIG_XZ_DEC_MIPS
+#	define XZ_DEC_MIPS
+#endif
 
 /*
  * This will get the basic headers so that memeq() and others
@@ -113,6 +113,17 @@ static int lz4_uncompress(const char *source, char *dest, int osize)
 			length += *ip++;
 		}
 
+		/* a run of one byte, as in zeroed or padded pages */
+		if (op - ref == 1) {
+			cpy = op + length + MINMATCH;
+			/* Error: the last 5 bytes must be literals */
+			if (unlikely(cpy >= oend))
+				goto _output_error;
+			memset(op, *ref, length + MINMATCH);
+			op = cpy;
+			continue;
+		}
+
 		/* copy repeated sequence */
 		if (unlikely((op - ref) < STEPSIZE)) {
 #if LZ4_ARCH64
@@ -243,6 +254,17 @@ static int lz4_uncompress_unknownoutputsize(const char *source, char *dest,
 			}
 		}
 
+		/* a run of one byte, as in zeroed or padded pages */
+		if (op - ref == 1) {
+			cpy = op + length + MINMATCH;
+			/* Error: the last 5 bytes must be literals */
+			if (unlikely(cpy >= oend))
+				goto _output_error;
+			memset(op, *ref, length + MINMATCH);
+			op = cpy;
+			continue;
+		}
+
 		/* copy repeated sequence */
 		if (unlikely((op - ref) < STEPSIZE)) {
 #if LZ4_ARCH64
@@ -143,10 +143,46 @@ typedef struct _U64_S { u64 v; } U64_S;
 #define LZ4_READ_LITTLEENDIAN_16(d, s, p) \
 	(d = s - get_unaligned_le16(p))
 
+#if !LZ4_ARCH64 && !defined(CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS)
+/*
+ * Without cheap unaligned access every PUT4 above is a pair of partial
+ * word loads and stores.  Literal runs and long matches are usually
+ * mutually aligned though, so when source and destination agree modulo
+ * four, copy one unaligned word to align the destination and do the rest
+ * with plain word accesses.  The overrun past e stays below COPYLENGTH.
+ */
+#define LZ4_COALIGNED(s, d)	\
+	((((unsigned long)(s) ^ (unsigned long)(d)) & 3) == 0)
+
+#define LZ4_COPYPACKET_ALIGNED(s, d)				\
+	do {							\
+		*(u32 *)(d) = *(const u32 *)(s);		\
+		*(u32 *)((d) + 4) = *(const u32 *)((s) + 4);	\
+		d += 8;						\
+		s += 8;						\
+	} while (0)
+
+#define LZ4_WILDCOPY(s, d, e)					\
+	do {							\
+		if (LZ4_COALIGNED(s, d)) {			\
+			size_t __n = 4 - ((unsigned long)(d) & 3);	\
+			PUT4(s, d);				\
+			d += __n;				\
+			s += __n;				\
+			while (d < e)				\
+				LZ4_COPYPACKET_ALIGNED(s, d);	\
+		} else {					\
+			do {					\
+				LZ4_COPYPACKET(s, d);		\
+			} while (d < e);			\
+		}						\
+	} while (0)
+#else
 #define LZ4_WILDCOPY(s, d, e)		\
 	do {				\
 		LZ4_COPYPACKET(s, d);	\
 	} while (d < e)
+#endif
 
 #define LZ4_BLINDCOPY(s, d, l)	\
 	do {	\
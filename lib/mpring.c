@@ -0,0 +1,433 @@
+/*
+ * Lockless multi-producer, single-consumer ring of fixed size records
+ *
+ * Every slot carries a sequence number telling whose turn it is: a slot
+ * for record n is free for the producer that reserves n while its seq is
+ * n, and ready for the consumer once the producer has set seq to n + 1.
+ * Producers reserve records by advancing head with cmpxchg(), so they
+ * only ever contend on that one word.  The ring lives in vmalloc_user()
+ * memory so that user space can map it and read records in place.
+ *
+ * The mapping is read-only: user space hands slots back through the
+ * MPRING_IOC_CONSUME ioctl, so head, tail and every seq are only ever
+ * written by the kernel.  A producer still gives up after a bounded
+ * number of attempts and drops its record, as it runs with interrupts
+ * off.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/err.h>
+#include <linux/export.h>
+#include <linux/irqflags.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/mpring.h>
+#include <linux/poll.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#define MPRING_DATA_ALIGN	64
+#define MPRING_WRITE_TRIES	16
+
+static inline struct mpring_slot *mpring_slot(struct mpring *ring, u32 pos)
+{
+	return ring->slots + (pos & ring->mask) * ring->slot_size;
+}
+
+static inline bool mpring_slot_ready(struct mpring *ring, u32 pos)
+{
+	return ACCESS_ONCE(mpring_slot(ring, pos)->seq) == pos + 1;
+}
+
+/* Hand the slot of consumed record @pos back to the producers */
+static inline void mpring_slot_release(struct mpring *ring, u32 pos)
+{
+	smp_mb();
+	ACCESS_ONCE(mpring_slot(ring, pos)->seq) = pos + ring->mask + 1;
+}
+
+static inline bool mpring_readable(struct mpring *ring)
+{
+	return mpring_count(ring) >= ACCESS_ONCE(ring->watermark) &&
+	       mpring_slot_ready(ring, ACCESS_ONCE(ring->hdr->tail));
+}
+
+/**
+ * mpring_alloc - allocate a ring
+ * @nr_records: number of records, a power of two
+ * @record_size: size of one record in bytes
+ *
+ * Returns the ring or an ERR_PTR() on failure.
+ */
+struct mpring *mpring_alloc(unsigned int nr_records, unsigned int record_size)
+{
+	struct mpring *ring;
+	size_t data_offset, slot_size;
+
+	if (!is_power_of_2(nr_records) || !record_size ||
+	    record_size > PAGE_SIZE)
+		return ERR_PTR(-EINVAL);
+
+	ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+	if (!ring)
+		return ERR_PTR(-ENOMEM);
+
+	data_offset = ALIGN(sizeof(struct mpring_header), MPRING_DATA_ALIGN);
+	slot_size = ALIGN(sizeof(struct mpring_slot) + record_size, 8);
+
+	ring->mask = nr_records - 1;
+	ring->record_size = record_size;
+	ring->slot_size = slot_size;
+	ring->size = PAGE_ALIGN(data_offset + nr_records * slot_size);
+
+	ring->hdr = vmalloc_user(ring->size);
+	if (!ring->hdr) {
+		kfree(ring);
+		return ERR_PTR(-ENOMEM);
+	}
+	ring->slots = (void *)ring->hdr + data_offset;
+
+	ring->hdr->mask = ring->mask;
+	ring->hdr->record_size = record_size;
+	ring->hdr->slot_size = slot_size;
+	ring->hdr->data_offset = data_offset;
+	ring->watermark = 1;
+	init_waitqueue_head(&ring->wait);
+	mutex_init(&ring->read_mutex);
+	mpring_reset(ring);
+
+	return ring;
+}
+EXPORT_SYMBOL_GPL(mpring_alloc);
+
+/**
+ * mpring_reset - discard all records
+ * @ring: the ring
+ *
+ * Also clears the drop counter.  There must be no producer and no
+ * consumer active while the ring is reset.
+ */
+void mpring_reset(struct mpring *ring)
+{
+	u32 i;
+
+	ring->hdr->head = 0;
+	ring->hdr->tail = 0;
+	for (i = 0; i <= ring->mask; i++)
+		mpring_slot(ring, i)->seq = i;
+
+	atomic_set(&ring->dropped, 0);
+	ring->hdr->dropped = 0;
+}
+EXPORT_SYMBOL_GPL(mpring_reset);
+
+/**
+ * mpring_free - free a ring
+ * @ring: the ring, may be NULL
+ */
+void mpring_free(struct mpring *ring)
+{
+	if (!ring)
+		return;
+
+	vfree(ring->hdr);
+	kfree(ring);
+}
+EXPORT_SYMBOL_GPL(mpring_free);
+
+/**
+ * mpring_write - append a record
+ * @ring: the ring
+ * @rec: record_size bytes of record
+ *
+ * Callable from any context.  Returns 0, or -ENOSPC if the ring is full
+ * or the slot could not be reserved in MPRING_WRITE_TRIES attempts, in
+ * which case the record is dropped and counted in the header.
+ */
+int mpring_write(struct mpring *ring, const void *rec)
+{
+	struct mpring_header *hdr = ring->hdr;
+	struct mpring_slot *slot;
+	unsigned long flags;
+	unsigned int tries;
+	u32 pos, seq, old;
+
+	/*
+	 * Keep interrupts off between reserving and publishing the slot,
+	 * as the consumer cannot get past it until it is published.
+	 */
+	local_irq_save(flags);
+	pos = ACCESS_ONCE(hdr->head);
+	for (tries = 0; ; tries++) {
+		slot = mpring_slot(ring, pos);
+		seq = ACCESS_ONCE(slot->seq);
+
+		/* Full, or losing every race against the other producers */
+		if ((s32)(seq - pos) < 0 || tries == MPRING_WRITE_TRIES) {
+			local_irq_restore(flags);
+			hdr->dropped = atomic_inc_return(&ring->dropped);
+			return -ENOSPC;
+		}
+
+		if (seq == pos) {
+			/* cmpxchg() orders the seq check against the copy */
+			old = cmpxchg(&hdr->head, pos, pos + 1);
+			if (old == pos)
+				break;
+			pos = old;
+		} else {
+			/* Another producer got there first */
+			pos = ACCESS_ONCE(hdr->head);
+		}
+	}
+
+	memcpy(slot->data, rec, ring->record_size);
+	smp_wmb();
+	ACCESS_ONCE(slot->seq) = pos + 1;
+	local_irq_restore(flags);
+
+	/* Pairs with the barrier in prepare_to_wait() of the consumer */
+	smp_mb();
+	if (waitqueue_active(&ring->wait) && mpring_readable(ring))
+		wake_up_interruptible(&ring->wait);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(mpring_write);
+
+/**
+ * mpring_read - consume records
+ * @ring: the ring
+ * @buf: room for @max records
+ * @max: most records to consume
+ *
+ * Returns the number of records copied to @buf.  Callers must make sure
+ * there is only one consumer at a time.
+ */
+unsigned int mpring_read(struct mpring *ring, void *buf, unsigned int max)
+{
+	struct mpring_header *hdr = ring->hdr;
+	struct mpring_slot *slot;
+	unsigned int n;
+	u32 pos = ACCESS_ONCE(hdr->tail);
+
+	for (n = 0; n < max && mpring_slot_ready(ring, pos); n++, pos++) {
+		slot = mpring_slot(ring, pos);
+		smp_rmb();
+		memcpy(buf + n * ring->record_size, slot->data,
+		       ring->record_size);
+		mpring_slot_release(ring, pos);
+	}
+	ACCESS_ONCE(hdr->tail) = pos;
+
+	return n;
+}
+EXPORT_SYMBOL_GPL(mpring_read);
+
+static ssize_t mpring_read_user(struct mpring *ring, char __user *buf,
+				unsigned int max)
+{
+	struct mpring_header *hdr = ring->hdr;
+	struct mpring_slot *slot;
+	unsigned int n;
+	u32 pos = ACCESS_ONCE(hdr->tail);
+	ssize_t ret = 0;
+
+	for (n = 0; n < max && mpring_slot_ready(ring, pos); n++, pos++) {
+		slot = mpring_slot(ring, pos);
+		smp_rmb();
+		if (copy_to_user(buf + n * ring->record_size, slot->data,
+				 ring->record_size)) {
+			ret = -EFAULT;
+			break;
+		}
+		mpring_slot_release(ring, pos);
+	}
+	ACCESS_ONCE(hdr->tail) = pos;
+
+	return n ? n * ring->record_size : ret;
+}
+
+/**
+ * mpring_consume - drop records read in place through the mapping
+ * @ring: the ring
+ * @max: most records to drop
+ *
+ * Returns the number of records handed back to the producers, which
+ * stops short of @max at the first record not yet published.  Callers
+ * must make sure there is only one consumer at a time.
+ */
+unsigned int mpring_consume(struct mpring *ring, unsigned int max)
+{
+	unsigned int n;
+	u32 pos = ACCESS_ONCE(ring->hdr->tail);
+
+	for (n = 0; n < max && mpring_slot_ready(ring, pos); n++, pos++)
+		mpring_slot_release(ring, pos);
+	ACCESS_ONCE(ring->hdr->tail) = pos;
+
+	return n;
+}
+EXPORT_SYMBOL_GPL(mpring_consume);
+
+/**
+ * mpring_count - number of records reserved but not yet consumed
+ * @ring: the ring
+ */
+unsigned int mpring_count(struct mpring *ring)
+{
+	u32 used = ACCESS_ONCE(ring->hdr->head) - ACCESS_ONCE(ring->hdr->tail);
+
+	return min(used, ring->mask + 1);
+}
+EXPORT_SYMBOL_GPL(mpring_count);
+
+/**
+ * mpring_mmap - map the ring into user space
+ * @ring: the ring
+ * @vma: the vma to map it into, starting at the header
+ *
+ * The mapping must be read-only.
+ */
+int mpring_mmap(struct mpring *ring, struct vm_area_struct *vma)
+{
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_vmalloc_range(vma, ring->hdr, vma->vm_pgoff);
+}
+EXPORT_SYMBOL_GPL(mpring_mmap);
+
+static int mpring_fop_open(struct inode *inode, struct file *file)
+{
+	struct mpring_miscdev *mdev = container_of(file->private_data,
+						   struct mpring_miscdev, misc);
+	int ret;
+
+	file->private_data = mdev;
+
+	if (mdev->open) {
+		ret = mdev->open(mdev);
+		if (ret)
+			return ret;
+	}
+
+	return nonseekable_open(inode, file);
+}
+
+static int mpring_fop_release(struct inode *inode, struct file *file)
+{
+	struct mpring_miscdev *mdev = file->private_data;
+
+	if (mdev->release)
+		mdev->release(mdev);
+	return 0;
+}
+
+static ssize_t mpring_fop_read(struct file *file, char __user *buf,
+			       size_t count, loff_t *ppos)
+{
+	struct mpring_miscdev *mdev = file->private_data;
+	struct mpring *ring = mdev->ring;
+	unsigned int max = min_t(size_t, count / ring->record_size, UINT_MAX);
+	ssize_t ret;
+
+	if (!max)
+		return -EINVAL;
+
+	for (;;) {
+		if (!(file->f_flags & O_NONBLOCK)) {
+			ret = wait_event_interruptible(ring->wait,
+						       mpring_readable(ring));
+			if (ret)
+				return ret;
+		}
+
+		if (mutex_lock_interruptible(&ring->read_mutex))
+			return -ERESTARTSYS;
+		ret = mpring_read_user(ring, buf, max);
+		mutex_unlock(&ring->read_mutex);
+
+		if (ret)
+			return ret;
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+	}
+}
+
+static unsigned int mpring_fop_poll(struct file *file, poll_table *wait)
+{
+	struct mpring_miscdev *mdev = file->private_data;
+
+	poll_wait(file, &mdev->ring->wait, wait);
+
+	if (mpring_readable(mdev->ring))
+		return POLLIN | POLLRDNORM;
+	return 0;
+}
+
+static long mpring_fop_ioctl(struct file *file, unsigned int cmd,
+			     unsigned long arg)
+{
+	struct mpring_miscdev *mdev = file->private_data;
+	struct mpring *ring = mdev->ring;
+	long ret;
+
+	if (cmd != MPRING_IOC_CONSUME)
+		return -ENOTTY;
+
+	if (mutex_lock_interruptible(&ring->read_mutex))
+		return -ERESTARTSYS;
+	ret = mpring_consume(ring, min_t(unsigned long, arg, UINT_MAX));
+	mutex_unlock(&ring->read_mutex);
+
+	return ret;
+}
+
+static int mpring_fop_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct mpring_miscdev *mdev = file->private_data;
+
+	return mpring_mmap(mdev->ring, vma);
+}
+
+static const struct file_operations mpring_fops = {
+	.owner		= THIS_MODULE,
+	.open		= mpring_fop_open,
+	.release	= mpring_fop_release,
+	.read		= mpring_fop_read,
+	.poll		= mpring_fop_poll,
+	.unlocked_ioctl	= mpring_fop_ioctl,
+	.mmap		= mpring_fop_mmap,
+	.llseek		= no_llseek,
+};
+
+/**
+ * mpring_misc_register - register a character device for a ring
+ * @mdev: the device, with misc.name and ring filled in
+ *
+ * misc.minor defaults to a dynamic minor when left zero.
+ */
+int mpring_misc_register(struct mpring_miscdev *mdev)
+{
+	if (!mdev->misc.minor)
+		mdev->misc.minor = MISC_DYNAMIC_MINOR;
+	mdev->misc.fops = &mpring_fops;
+
+	return misc_register(&mdev->misc);
+}
+EXPORT_SYMBOL_GPL(mpring_misc_register);
+
+void mpring_misc_deregister(struct mpring_miscdev *mdev)
+{
+	misc_deregister(&mdev->misc);
+}
+EXPORT_SYMBOL_GPL(mpring_misc_deregister);
+
+MODULE_LICENSE("GPL");
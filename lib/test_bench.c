@@ -0,0 +1,370 @@
+/*
+ * Microbenchmarks of hot kernel primitives.
+ *
+ * Each group of benchmarks is run when its file in <debugfs>/bench is
+ * read, one line per operation:
+ *
+ *   memcpy size=4096 loops=10000 ns_per_op=812.40 cycles_per_op=0 ns_per_kb=203.10
+ *
+ * Every operation is timed over "loops" iterations, "rounds" times, and
+ * the fastest round is reported.  cycles_per_op is taken from
+ * get_cycles() and reads 0 where the architecture does not provide it.
+ * ns_per_kb is only printed for operations on a buffer of "size" bytes.
+ * Read with a buffer of at least a page; the copy_user benchmarks use
+ * the read buffer as their user memory.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <linux/atomic.h>
+#include <linux/crc32.h>
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/gfp.h>
+#include <linux/ktime.h>
+#include <linux/lz4.h>
+#include <linux/lzo.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <linux/zlib.h>
+#include <asm/checksum.h>
+#include <asm/timex.h>
+
+static unsigned int loops = 10000;
+module_param(loops, uint, 0644);
+MODULE_PARM_DESC(loops, "Iterations per timed round");
+
+static unsigned int rounds = 3;
+module_param(rounds, uint, 0644);
+MODULE_PARM_DESC(rounds, "Timed rounds per operation, the fastest is reported");
+
+#define BENCH_BUF_SIZE	4096
+
+struct bench_ctx {
+	char		*out;
+	size_t		len;
+	char __user	*ubuf;
+	size_t		ucount;
+	u8		*src;
+	u8		*dst;
+};
+
+static u32 bench_sink;
+
+static void bench_report(struct bench_ctx *ctx, const char *op,
+			 unsigned int size, unsigned int n, u64 ns, u64 cycles)
+{
+	u64 ns_op = div64_u64(ns * 100, n);
+	u32 frac = do_div(ns_op, 100);
+
+	ctx->len += scnprintf(ctx->out + ctx->len, PAGE_SIZE - ctx->len,
+			      "%s size=%u loops=%u ns_per_op=%llu.%02u cycles_per_op=%llu",
+			      op, size, n, ns_op, frac, div64_u64(cycles, n));
+	if (size) {
+		u64 ns_kb = div64_u64(ns * 1024 * 100, (u64)n * size);
+
+		frac = do_div(ns_kb, 100);
+		ctx->len += scnprintf(ctx->out + ctx->len,
+				      PAGE_SIZE - ctx->len,
+				      " ns_per_kb=%llu.%02u", ns_kb, frac);
+	}
+	ctx->len += scnprintf(ctx->out + ctx->len, PAGE_SIZE - ctx->len, "\n");
+}
+
+/*
+ * Time @stmt, run @n times in a row, and report the fastest of the
+ * configured number of rounds.  The barrier keeps the compiler from
+ * merging or dropping iterations.
+ */
+#define BENCH(ctx, op, size, n, stmt)					\
+do {									\
+	u64 __ns = U64_MAX, __cyc = U64_MAX, __t;			\
+	unsigned int __r, __i, __n = (n);				\
+	cycles_t __c;							\
+	ktime_t __start;						\
+									\
+	for (__r = 0; __r < max(rounds, 1U); __r++) {			\
+		__c = get_cycles();					\
+		__start = ktime_get();					\
+		for (__i = 0; __i < __n; __i++) {			\
+			stmt;						\
+			barrier();					\
+		}							\
+		__t = ktime_to_ns(ktime_sub(ktime_get(), __start));	\
+		__ns = min(__ns, __t);					\
+		__cyc = min(__cyc, (u64)(get_cycles() - __c));		\
+		cond_resched();						\
+	}								\
+	bench_report(ctx, op, size, __n, __ns, __cyc);			\
+} while (0)
+
+static const unsigned int bench_sizes[] = { 64, 512, 4096 };
+
+static void bench_memory(struct bench_ctx *ctx)
+{
+	unsigned int i, sz;
+
+	for (i = 0; i < ARRAY_SIZE(bench_sizes); i++) {
+		sz = bench_sizes[i];
+		BENCH(ctx, "memcpy", sz, loops, memcpy(ctx->dst, ctx->src, sz));
+		BENCH(ctx, "memset", sz, loops, memset(ctx->dst, 0x5a, sz));
+
+		if (ctx->ucount < sz)
+			continue;
+		BENCH(ctx, "copy_to_user", sz, loops,
+		      if (copy_to_user(ctx->ubuf, ctx->src, sz))
+				break);
+		BENCH(ctx, "copy_from_user", sz, loops,
+		      if (copy_from_user(ctx->dst, ctx->ubuf, sz))
+				break);
+	}
+}
+
+static void bench_checksum(struct bench_ctx *ctx)
+{
+	static const unsigned int sizes[] = { 64, 1500, 4096 };
+	unsigned int i, sz;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		sz = sizes[i];
+		BENCH(ctx, "csum_partial", sz, loops,
+		      bench_sink += (__force u32)csum_partial(ctx->src, sz, 0));
+		BENCH(ctx, "crc32_le", sz, loops,
+		      bench_sink += crc32_le(~0, ctx->src, sz));
+	}
+}
+
+static int bench_deflate(const u8 *src, u8 *dst, size_t *dst_len)
+{
+	struct z_stream_s stream = { };
+	int ret = -ENOMEM;
+
+	stream.workspace = vzalloc(zlib_deflate_workspacesize(MAX_WBITS,
+							      MAX_MEM_LEVEL));
+	if (!stream.workspace)
+		return ret;
+
+	ret = -EINVAL;
+	if (zlib_deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+		goto out;
+
+	stream.next_in = src;
+	stream.avail_in = BENCH_BUF_SIZE;
+	stream.next_out = dst;
+	stream.avail_out = *dst_len;
+	if (zlib_deflate(&stream, Z_FINISH) == Z_STREAM_END) {
+		*dst_len = stream.total_out;
+		ret = 0;
+	}
+	zlib_deflateEnd(&stream);
+out:
+	vfree(stream.workspace);
+	return ret;
+}
+
+static void bench_inflate(struct z_stream_s *stream, const u8 *src,
+			  size_t src_len, u8 *dst)
+{
+	zlib_inflateReset(stream);
+	stream->next_in = src;
+	stream->avail_in = src_len;
+	stream->next_out = dst;
+	stream->avail_out = BENCH_BUF_SIZE;
+	zlib_inflate(stream, Z_FINISH);
+}
+
+static void bench_decompress(struct bench_ctx *ctx)
+{
+	unsigned int n = max(loops / 10, 1U);
+	struct z_stream_s stream = { };
+	size_t cap = lz4_compressbound(BENCH_BUF_SIZE);
+	size_t clen, dlen;
+	void *wrkmem;
+	u8 *cbuf;
+
+	cbuf = kmalloc(cap, GFP_KERNEL);
+	wrkmem = vmalloc(max(LZ4_MEM_COMPRESS, LZO1X_1_MEM_COMPRESS));
+	if (!cbuf || !wrkmem)
+		goto out;
+
+	clen = cap;
+	if (!lz4_compress(ctx->src, BENCH_BUF_SIZE, cbuf, &clen, wrkmem))
+		BENCH(ctx, "lz4_decompress", BENCH_BUF_SIZE, n,
+		      dlen = clen;
+		      lz4_decompress(cbuf, &dlen, ctx->dst, BENCH_BUF_SIZE));
+
+	clen = cap;
+	if (lzo1x_1_compress(ctx->src, BENCH_BUF_SIZE, cbuf, &clen,
+			     wrkmem) == LZO_E_OK)
+		BENCH(ctx, "lzo1x_decompress", BENCH_BUF_SIZE, n,
+		      dlen = BENCH_BUF_SIZE;
+		      lzo1x_decompress_safe(cbuf, clen, ctx->dst, &dlen));
+
+	clen = cap;
+	if (bench_deflate(ctx->src, cbuf, &clen))
+		goto out;
+	stream.workspace = vzalloc(zlib_inflate_workspacesize());
+	if (!stream.workspace)
+		goto out;
+	if (zlib_inflateInit(&stream) == Z_OK) {
+		BENCH(ctx, "zlib_inflate", BENCH_BUF_SIZE, n,
+		      bench_inflate(&stream, cbuf, clen, ctx->dst));
+		zlib_inflateEnd(&stream);
+	}
+	vfree(stream.workspace);
+out:
+	vfree(wrkmem);
+	kfree(cbuf);
+}
+
+static void bench_atomic(struct bench_ctx *ctx)
+{
+	atomic_t v = ATOMIC_INIT(0);
+
+	BENCH(ctx, "atomic_inc", 0, loops, atomic_inc(&v));
+	BENCH(ctx, "atomic_add_return", 0, loops,
+	      bench_sink += atomic_add_return(1, &v));
+	atomic_set(&v, 0);
+	BENCH(ctx, "atomic_cmpxchg", 0, loops, atomic_cmpxchg(&v, 0, 0));
+	BENCH(ctx, "atomic_dec_and_test", 0, loops,
+	      bench_sink += atomic_dec_and_test(&v));
+}
+
+static DEFINE_SPINLOCK(bench_lock);
+static DEFINE_MUTEX(bench_mutex);
+
+static void bench_locking(struct bench_ctx *ctx)
+{
+	unsigned long flags;
+
+	BENCH(ctx, "spin_lock_unlock", 0, loops,
+	      spin_lock(&bench_lock); spin_unlock(&bench_lock));
+	BENCH(ctx, "spin_lock_irqsave", 0, loops,
+	      spin_lock_irqsave(&bench_lock, flags);
+	      spin_unlock_irqrestore(&bench_lock, flags));
+	BENCH(ctx, "spin_lock_bh", 0, loops,
+	      spin_lock_bh(&bench_lock); spin_unlock_bh(&bench_lock));
+	BENCH(ctx, "mutex_lock_unlock", 0, loops,
+	      mutex_lock(&bench_mutex); mutex_unlock(&bench_mutex));
+}
+
+static void bench_alloc(struct bench_ctx *ctx)
+{
+	char name[24];
+	struct page *page;
+	unsigned int sz, order;
+	void *p;
+
+	for (sz = 32; sz <= 4096; sz <<= 1)
+		BENCH(ctx, "kmalloc_kfree", sz, loops,
+		      p = kmalloc(sz, GFP_KERNEL); kfree(p));
+
+	for (order = 0; order <= 2; order++) {
+		snprintf(name, sizeof(name), "alloc_pages_order%u", order);
+		BENCH(ctx, name, 0, loops,
+		      page = alloc_pages(GFP_KERNEL, order);
+		      if (page)
+				__free_pages(page, order));
+	}
+}
+
+struct bench_group {
+	const char	*name;
+	void		(*run)(struct bench_ctx *ctx);
+};
+
+static const struct bench_group bench_groups[] = {
+	{ "memory",	bench_memory },
+	{ "checksum",	bench_checksum },
+	{ "decompress",	bench_decompress },
+	{ "atomic",	bench_atomic },
+	{ "locking",	bench_locking },
+	{ "alloc",	bench_alloc },
+};
+
+static ssize_t bench_read(struct file *file, char __user *ubuf,
+			  size_t count, loff_t *ppos)
+{
+	const struct bench_group *group = file->private_data;
+	struct bench_ctx ctx = {
+		.ubuf	= ubuf,
+		.ucount	= count,
+	};
+	unsigned int i;
+	ssize_t ret;
+
+	if (*ppos)
+		return 0;
+
+	ret = -ENOMEM;
+	ctx.out = (char *)__get_free_page(GFP_KERNEL);
+	ctx.src = kmalloc(BENCH_BUF_SIZE, GFP_KERNEL);
+	ctx.dst = kmalloc(BENCH_BUF_SIZE, GFP_KERNEL);
+	if (!ctx.out || !ctx.src || !ctx.dst)
+		goto out;
+
+	/* Compressible, text-like data */
+	for (i = 0; i < BENCH_BUF_SIZE; i++)
+		ctx.src[i] = "kernel bench 0123456789\n"[i % 24] + (i / 512);
+
+	ctx.len = scnprintf(ctx.out, PAGE_SIZE, "# %s loops=%u rounds=%u\n",
+			    group->name, loops, max(rounds, 1U));
+	if (loops)
+		group->run(&ctx);
+
+	ret = simple_read_from_buffer(ubuf, count, ppos, ctx.out, ctx.len);
+out:
+	kfree(ctx.dst);
+	kfree(ctx.src);
+	free_page((unsigned long)ctx.out);
+	return ret;
+}
+
+static const struct file_operations bench_fops = {
+	.owner	= THIS_MODULE,
+	.open	= simple_open,
+	.read	= bench_read,
+	.llseek	= default_llseek,
+};
+
+static struct dentry *bench_dir;
+
+static int __init test_bench_init(void)
+{
+	unsigned int i;
+
+	bench_dir = debugfs_create_dir("bench", NULL);
+	if (IS_ERR_OR_NULL(bench_dir))
+		return -ENODEV;
+
+	for (i = 0; i < ARRAY_SIZE(bench_groups); i++) {
+		if (!debugfs_create_file(bench_groups[i].name, 0400, bench_dir,
+					 (void *)&bench_groups[i],
+					 &bench_fops)) {
+			debugfs_remove_recursive(bench_dir);
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+static void __exit test_bench_exit(void)
+{
+	debugfs_remove_recursive(bench_dir);
+}
+
+module_init(test_bench_init);
+module_exit(test_bench_exit);
+
+MODULE_DESCRIPTION("Microbenchmarks of hot kernel primitives");
+MODULE_LICENSE("GPL");
@@ -16,6 +16,9 @@
  */
 #ifdef XZ_DEC_BCJ
 
+/* Custom Filter ID (0x0000_03xx_xxxx_xxxx range) of the MIPS filter */
+#define BCJ_MIPS_ID 0x000003004D49504CULL
+
 struct xz_dec_bcj {
 	/* Type of the BCJ filter being used */
 	enum {
@@ -24,7 +27,8 @@ struct xz_dec_bcj {
 		BCJ_IA64 = 6,       /* Big or little endian */
 		BCJ_ARM = 7,        /* Little endian only */
 		BCJ_ARMTHUMB = 8,   /* Little endian only */
-		BCJ_SPARC = 9       /* Big or little endian */
+		BCJ_SPARC = 9,      /* Big or little endian */
+		BCJ_MIPS = 0x100    /* Little endian only, see bcj_mips() */
 	} type;
 
 	/*
@@ -70,6 +74,7 @@ struct xz_dec_bcj {
 		 * ARM              4           0
 		 * ARM-Thumb        2           2
 		 * SPARC            4           0
+		 * MIPS             4           0
 		 */
 		uint8_t buf[16];
 	} temp;
@@ -334,6 +339,40 @@ static size_t bcj_sparc(struct xz_dec_bcj *s, uint8_t *buf, size_t size)
 }
 #endif
 
+#ifdef XZ_DEC_MIPS
+/*
+ * Only jal is converted; it is what non-PIC code such as the kernel uses
+ * for calls. The encoder replaces its 26-bit target (a word index within
+ * the current 256 MiB region) by the target minus the word address of the
+ * jal, modulo 2^26, and this adds the word address back. Other
+ * instructions, including bal and j, are left alone.
+ *
+ * This is not one of the filters defined by the .xz file format, so it
+ * uses BCJ_MIPS_ID from the range the format reserves for custom filters.
+ * BCJ_MIPS is only the internal type; the encoder must use BCJ_MIPS_ID.
+ * No released xz can encode it: the input has to be run through the
+ * inverse of this function, compressed with "xz --format=raw --lzma2",
+ * and wrapped in a .xz container whose Block Header lists BCJ_MIPS_ID
+ * followed by LZMA2.
+ */
+static size_t bcj_mips(struct xz_dec_bcj *s, uint8_t *buf, size_t size)
+{
+	size_t i;
+	uint32_t instr;
+
+	for (i = 0; i + 4 <= size; i += 4) {
+		instr = get_unaligned_le32(buf + i);
+		if ((instr & 0xFC000000) == 0x0C000000) {
+			instr += (s->pos + (uint32_t)i) >> 2;
+			instr = 0x0C000000 | (instr & 0x03FFFFFF);
+			put_unaligned_le32(instr, buf + i);
+		}
+	}
+
+	return i;
+}
+#endif
+
 /*
  * Apply the selected BCJ filter. Update *pos and s->pos to match the amount
  * of data that got filtered.
@@ -380,6 +419,11 @@ static void bcj_apply(struct xz_dec_bcj *s,
 	case BCJ_SPARC:
 		filtered = bcj_sparc(s, buf, size);
 		break;
+#endif
+#ifdef XZ_DEC_MIPS
+	case BCJ_MIPS:
+		filtered = bcj_mips(s, buf, size);
+		break;
 #endif
 	default:
 		/* Never reached but silence compiler warnings. */
@@ -533,7 +577,7 @@ XZ_EXTERN struct xz_dec_bcj *xz_dec_bcj_create(bool single_call)
 	return s;
 }
 
-XZ_EXTERN enum xz_ret xz_dec_bcj_reset(struct xz_dec_bcj *s, uint8_t id)
+XZ_EXTERN enum xz_ret xz_dec_bcj_reset(struct xz_dec_bcj *s, uint64_t id)
 {
 	switch (id) {
 #ifdef XZ_DEC_X86
@@ -556,6 +600,12 @@ XZ_EXTERN enum xz_ret xz_dec_bcj_reset(struct xz_dec_bcj *s, uint8_t id)
 #endif
 		break;
 
+#ifdef XZ_DEC_MIPS
+	case BCJ_MIPS_ID:
+		id = BCJ_MIPS;
+		break;
+#endif
+
 	default:
 		/* Unsupported Filter ID */
 		return XZ_OPTIONS_ERROR;
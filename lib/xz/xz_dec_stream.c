@@ -501,7 +501,12 @@ static enum xz_ret dec_block_header(struct xz_dec *s)
 		if (s->temp.size - s->temp.pos < 2)
 			return XZ_OPTIONS_ERROR;
 
-		ret = xz_dec_bcj_reset(s->bcj, s->temp.buf[s->temp.pos++]);
+		/* Custom Filter IDs take more than one byte. */
+		if (dec_vli(s, s->temp.buf, &s->temp.pos, s->temp.size)
+				!= XZ_STREAM_END || s->temp.pos == s->temp.size)
+			return XZ_DATA_ERROR;
+
+		ret = xz_dec_bcj_reset(s->bcj, s->vli);
 		if (ret != XZ_OK)
 			return ret;
 
@@ -223,6 +223,24 @@ static ssize_t max_ratio_store(struct device *dev,
 }
 BDI_SHOW(max_ratio, bdi->max_ratio)
 
+static ssize_t read_latency_target_ms_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	unsigned int target;
+	ssize_t ret;
+
+	ret = kstrtouint(buf, 10, &target);
+	if (ret < 0)
+		return ret;
+
+	bdi->read_lat_target = target;
+	bdi->wb_depth_shift = 0;
+
+	return count;
+}
+BDI_SHOW(read_latency_target_ms, bdi->read_lat_target)
+
 static ssize_t stable_pages_required_show(struct device *dev,
 					  struct device_attribute *attr,
 					  char *page)
@@ -238,6 +256,7 @@ static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_read_ahead_kb.attr,
 	&dev_attr_min_ratio.attr,
 	&dev_attr_max_ratio.attr,
+	&dev_attr_read_latency_target_ms.attr,
 	&dev_attr_stable_pages_required.attr,
 	NULL,
 };
@@ -462,6 +481,10 @@ int bdi_init(struct backing_dev_info *bdi)
 
 	bdi->dirty_exceeded = 0;
 
+	bdi->read_lat_target = 0;
+	bdi->read_lat_avg = 0;
+	bdi->wb_depth_shift = 0;
+
 	bdi->bw_time_stamp = jiffies;
 	bdi->written_stamp = 0;
 
@@ -573,6 +596,46 @@ void set_bdi_congested(struct backing_dev_info *bdi, int sync)
 }
 EXPORT_SYMBOL(set_bdi_congested);
 
+/*
+ * Each halving of the writeback chunk roughly halves the write backlog a
+ * read has to queue behind; 6 steps take a 4MB chunk down to 64KB.
+ */
+#define BDI_WB_DEPTH_SHIFT_MAX	6
+
+/**
+ * bdi_update_read_latency - feed a read completion time into writeback
+ * @bdi: the device the read completed on
+ * @duration: time from queueing to completion, in jiffies
+ *
+ * Called from the block layer for every completed read.  Keeps a moving
+ * average and deepens or relaxes the writeback throttle accordingly.
+ */
+void bdi_update_read_latency(struct backing_dev_info *bdi,
+			     unsigned long duration)
+{
+	unsigned int lat = jiffies_to_msecs(duration);
+	unsigned int target = bdi->read_lat_target;
+
+	if (!target)
+		return;
+
+	/* an idle period makes the old average meaningless */
+	if (time_after_eq(jiffies, bdi->read_lat_stamp + BDI_READ_LAT_WINDOW))
+		bdi->read_lat_avg = lat;
+	else
+		bdi->read_lat_avg = (bdi->read_lat_avg * 7 + lat) / 8;
+	bdi->read_lat_stamp = jiffies;
+
+	if (bdi->read_lat_avg > target) {
+		if (bdi->wb_depth_shift < BDI_WB_DEPTH_SHIFT_MAX)
+			bdi->wb_depth_shift++;
+	} else if (bdi->read_lat_avg < target / 2) {
+		if (bdi->wb_depth_shift)
+			bdi->wb_depth_shift--;
+	}
+}
+EXPORT_SYMBOL(bdi_update_read_latency);
+
 /**
  * congestion_wait - wait for a backing_dev to become uncongested
  * @sync: SYNC or ASYNC IO
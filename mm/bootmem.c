@@ -210,15 +210,18 @@ static unsigned long __init free_all_bootmem_core(bootmem_data_t *bdata)
 		if (IS_ALIGNED(start, BITS_PER_LONG) && vec == ~0UL) {
 			int order = ilog2(BITS_PER_LONG);
 
-			__free_pages_bootmem(pfn_to_page(start), order);
-			count += BITS_PER_LONG;
+			/* Deferred ranges are whole pageblocks */
+			if (!early_page_deferred(start)) {
+				__free_pages_bootmem(pfn_to_page(start), order);
+				count += BITS_PER_LONG;
+			}
 			start += BITS_PER_LONG;
 		} else {
 			unsigned long cur = start;
 
 			start = ALIGN(start + 1, BITS_PER_LONG);
 			while (vec && cur != start) {
-				if (vec & 1) {
+				if ((vec & 1) && !early_page_deferred(cur)) {
 					page = pfn_to_page(cur);
 					__free_pages_bootmem(page, 0);
 					count++;
@@ -229,6 +232,19 @@ static unsigned long __init free_all_bootmem_core(bootmem_data_t *bdata)
 		}
 	}
 
+	/*
+	 * free_deferred_bootmem() still needs the map. Reserved pages in
+	 * the deferred ranges cannot wait for it, free_reserved_area() may
+	 * release them first.
+	 */
+	if (deferred_init_pending()) {
+		for (start = bdata->node_min_pfn; start < end; start++)
+			if (early_page_deferred(start) &&
+			    test_bit(start - bdata->node_min_pfn, map))
+				init_deferred_page(start);
+		goto out;
+	}
+
 	page = virt_to_page(bdata->node_bootmem_map);
 	pages = bdata->node_low_pfn - bdata->node_min_pfn;
 	pages = bootmem_bootmap_pages(pages);
@@ -236,11 +252,55 @@ static unsigned long __init free_all_bootmem_core(bootmem_data_t *bdata)
 	while (pages--)
 		__free_pages_bootmem(page++, 0);
 
+out:
 	bdebug("nid=%td released=%lx\n", bdata - bootmem_node_data, count);
 
 	return count;
 }
 
+#ifdef CONFIG_DEFERRED_STRUCT_PAGE_INIT
+/*
+ * Initialise the struct pages of the free pages in the deferred ranges and
+ * release them, then the bootmem maps free_all_bootmem_core() had to leave
+ * behind. The reserved ones were initialised by free_all_bootmem_core().
+ */
+void __init free_deferred_bootmem(void)
+{
+	bootmem_data_t *bdata;
+	unsigned long pfn, idx, pages, count = 0;
+	struct page *page;
+
+	list_for_each_entry(bdata, &bdata_list, list) {
+		if (!bdata->node_bootmem_map)
+			continue;
+
+		for (pfn = bdata->node_min_pfn; pfn < bdata->node_low_pfn;
+		     pfn++) {
+			idx = pfn - bdata->node_min_pfn;
+			if (early_page_deferred(pfn) &&
+			    !test_bit(idx, bdata->node_bootmem_map) &&
+			    early_pfn_valid(pfn)) {
+				init_deferred_page(pfn);
+				__free_pages_bootmem(pfn_to_page(pfn), 0);
+				count++;
+			}
+			if (!(pfn & (pageblock_nr_pages - 1)))
+				cond_resched();
+		}
+
+		page = virt_to_page(bdata->node_bootmem_map);
+		pages = bdata->node_low_pfn - bdata->node_min_pfn;
+		pages = bootmem_bootmap_pages(pages);
+		count += pages;
+		while (pages--)
+			__free_pages_bootmem(page++, 0);
+		bdata->node_bootmem_map = NULL;
+	}
+
+	totalram_pages += count;
+}
+#endif
+
 static int reset_managed_pages_done __initdata;
 
 static inline void __init reset_node_managed_pages(pg_data_t *pgdat)
@@ -25,6 +25,9 @@ static inline void set_page_count(struct page *page, int v)
 extern int __do_page_cache_readahead(struct address_space *mapping,
 		struct file *filp, pgoff_t offset, unsigned long nr_to_read,
 		unsigned long lookahead_size);
+extern void ra_score_window(struct file_ra_state *ra, bool hit_marker,
+		pgoff_t offset);
+extern unsigned long ra_max_pages(struct file_ra_state *ra);
 
 /*
  * Submit IO for the read-ahead request in file_ra_state.
@@ -32,6 +35,7 @@ extern int __do_page_cache_readahead(struct address_space *mapping,
 static inline unsigned long ra_submit(struct file_ra_state *ra,
 		struct address_space *mapping, struct file *filp)
 {
+	ra->unscored = 1;
 	return __do_page_cache_readahead(mapping, filp,
 					ra->start, ra->size, ra->async_size);
 }
@@ -109,6 +113,23 @@ extern pmd_t *mm_find_pmd(struct mm_struct *mm, unsigned long address);
  * in mm/page_alloc.c
  */
 extern void __free_pages_bootmem(struct page *page, unsigned int order);
+#ifdef CONFIG_DEFERRED_STRUCT_PAGE_INIT
+extern bool early_page_deferred(unsigned long pfn);
+extern bool deferred_init_pending(void);
+extern bool deferred_init_wait(void);
+extern void init_deferred_page(unsigned long pfn);
+extern void free_deferred_bootmem(void);
+#else
+static inline bool early_page_deferred(unsigned long pfn)
+{
+	return false;
+}
+
+static inline bool deferred_init_pending(void)
+{
+	return false;
+}
+#endif
 extern void prep_compound_page(struct page *page, unsigned long order);
 #ifdef CONFIG_MEMORY_FAILURE
 extern bool is_free_buddy_page(struct page *page);
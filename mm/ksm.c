@@ -223,6 +223,13 @@ static unsigned int ksm_thread_pages_to_scan = 100;
 /* Milliseconds ksmd should sleep between batches */
 static unsigned int ksm_thread_sleep_millisecs = 20;
 
+/*
+ * Set when ksmd should only use otherwise idle CPU time: it then runs as
+ * SCHED_IDLE and drops pages changed since the last pass before it spends
+ * time searching the stable tree for them.
+ */
+static unsigned int ksm_thread_idle_scan;
+
 #ifdef CONFIG_NUMA
 /* Zeroed when merging across nodes is not allowed */
 static unsigned int ksm_merge_across_nodes = 1;
@@ -1408,7 +1415,8 @@ static void stable_tree_append(struct rmap_item *rmap_item,
  * cmp_and_merge_page - first see if page can be merged into the stable tree;
  * if not, compare checksum to previous and if it's the same, see if page can
  * be inserted into the unstable tree, or merged with a page already there and
- * both transferred to the stable tree.
+ * both transferred to the stable tree. With ksm_thread_idle_scan the checksum
+ * is compared first, so volatile pages do not cost a stable tree search.
  *
  * @page: the page that we are searching identical page to.
  * @rmap_item: the reverse mapping into the virtual address of this page
@@ -1420,6 +1428,7 @@ static void cmp_and_merge_page(struct page *page, struct rmap_item *rmap_item)
 	struct stable_node *stable_node;
 	struct page *kpage;
 	unsigned int checksum;
+	bool checksum_first = false;
 	int err;
 
 	stable_node = page_stable_node(page);
@@ -1434,6 +1443,14 @@ static void cmp_and_merge_page(struct page *page, struct rmap_item *rmap_item)
 		if (stable_node->head != &migrate_nodes &&
 		    rmap_item->head == stable_node)
 			return;
+	} else if (ACCESS_ONCE(ksm_thread_idle_scan)) {
+		checksum_first = true;
+		checksum = calc_checksum(page);
+		if (rmap_item->oldchecksum != checksum) {
+			rmap_item->oldchecksum = checksum;
+			remove_rmap_item_from_tree(rmap_item);
+			return;
+		}
 	}
 
 	/* We first start with searching the page inside the stable tree */
@@ -1466,10 +1483,12 @@ static void cmp_and_merge_page(struct page *page, struct rmap_item *rmap_item)
 	 * don't want to insert it in the unstable tree, and we don't want
 	 * to waste our time searching for something identical to it there.
 	 */
-	checksum = calc_checksum(page);
-	if (rmap_item->oldchecksum != checksum) {
-		rmap_item->oldchecksum = checksum;
-		return;
+	if (!checksum_first) {
+		checksum = calc_checksum(page);
+		if (rmap_item->oldchecksum != checksum) {
+			rmap_item->oldchecksum = checksum;
+			return;
+		}
 	}
 
 	tree_rmap_item =
@@ -1711,12 +1730,23 @@ static int ksmd_should_run(void)
 	return (ksm_run & KSM_RUN_MERGE) && !list_empty(&ksm_mm_head.mm_list);
 }
 
+static void ksmd_update_policy(void)
+{
+	struct sched_param param = { .sched_priority = 0 };
+	int policy = ksm_thread_idle_scan ? SCHED_IDLE : SCHED_NORMAL;
+
+	if (current->policy != policy)
+		sched_setscheduler(current, policy, &param);
+}
+
 static int ksm_scan_thread(void *nothing)
 {
 	set_freezable();
 	set_user_nice(current, 5);
 
 	while (!kthread_should_stop()) {
+		ksmd_update_policy();
+
 		mutex_lock(&ksm_thread_mutex);
 		wait_while_offlining();
 		if (ksmd_should_run())
@@ -2134,6 +2164,29 @@ static ssize_t pages_to_scan_store(struct kobject *kobj,
 }
 KSM_ATTR(pages_to_scan);
 
+static ssize_t idle_scan_show(struct kobject *kobj,
+			      struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_thread_idle_scan);
+}
+
+static ssize_t idle_scan_store(struct kobject *kobj,
+			       struct kobj_attribute *attr,
+			       const char *buf, size_t count)
+{
+	int err;
+	unsigned long knob;
+
+	err = kstrtoul(buf, 10, &knob);
+	if (err || knob > 1)
+		return -EINVAL;
+
+	ksm_thread_idle_scan = knob;
+
+	return count;
+}
+KSM_ATTR(idle_scan);
+
 static ssize_t run_show(struct kobject *kobj, struct kobj_attribute *attr,
 			char *buf)
 {
@@ -2288,6 +2341,7 @@ KSM_ATTR_RO(full_scans);
 static struct attribute *ksm_attrs[] = {
 	&sleep_millisecs_attr.attr,
 	&pages_to_scan_attr.attr,
+	&idle_scan_attr.attr,
 	&run_attr.attr,
 	&pages_shared_attr.attr,
 	&pages_sharing_attr.attr,
@@ -51,6 +51,7 @@
 #include <linux/seq_file.h>
 #include <linux/vmpressure.h>
 #include <linux/mm_inline.h>
+#include <linux/shmem_fs.h>
 #include <linux/page_cgroup.h>
 #include <linux/cpu.h>
 #include <linux/oom.h>
@@ -87,6 +88,15 @@ static int really_do_swap_account __initdata = 0;
 #define do_swap_account		0
 #endif
 
+/*
+ * "memcg_lite" on the command line trades features for a cheaper charge
+ * path on small systems that only need memory limits: charges are taken
+ * from the res_counter in larger batches, swap is not accounted and the
+ * threshold, soft limit and fault statistics updates are skipped.  Usage
+ * thresholds and soft limits can therefore not be set, and attempts to do
+ * so fail with -EOPNOTSUPP.
+ */
+static bool memcg_lite __read_mostly;
 
 static const char * const mem_cgroup_stat_names[] = {
 	"cache",
@@ -102,6 +112,7 @@ enum mem_cgroup_events_index {
 	MEM_CGROUP_EVENTS_PGPGOUT,	/* # of pages paged out */
 	MEM_CGROUP_EVENTS_PGFAULT,	/* # of page-faults */
 	MEM_CGROUP_EVENTS_PGMAJFAULT,	/* # of major page-faults */
+	MEM_CGROUP_EVENTS_RES_CHARGE,	/* # of res_counter charges */
 	MEM_CGROUP_EVENTS_NSTATS,
 };
 
@@ -110,6 +121,7 @@ static const char * const mem_cgroup_events_names[] = {
 	"pgpgout",
 	"pgfault",
 	"pgmajfault",
+	"res_charge",
 };
 
 static const char * const mem_cgroup_lru_names[] = {
@@ -1039,6 +1051,9 @@ static bool mem_cgroup_event_ratelimit(struct mem_cgroup *memcg,
  */
 static void memcg_check_events(struct mem_cgroup *memcg, struct page *page)
 {
+	if (memcg_lite)
+		return;
+
 	preempt_disable();
 	/* threshold event is triggered in finer grain than soft limit */
 	if (unlikely(mem_cgroup_event_ratelimit(memcg,
@@ -1331,6 +1346,9 @@ void __mem_cgroup_count_vm_event(struct mm_struct *mm, enum vm_event_item idx)
 {
 	struct mem_cgroup *memcg;
 
+	if (memcg_lite)
+		return;
+
 	rcu_read_lock();
 	memcg = mem_cgroup_from_task(rcu_dereference(mm->owner));
 	if (unlikely(!memcg))
@@ -2428,6 +2446,14 @@ void mem_cgroup_update_page_stat(struct page *page,
  * TODO: maybe necessary to use big numbers in big irons.
  */
 #define CHARGE_BATCH	32U
+/*
+ * In lite mode every res_counter charge pays for four times as many pages,
+ * which keeps the lock and hierarchy walk out of almost all page faults.
+ * At most this many pages per cpu are charged but not yet used.
+ */
+#define CHARGE_BATCH_LITE	(4 * CHARGE_BATCH)
+static unsigned int charge_batch __read_mostly = CHARGE_BATCH;
+
 struct memcg_stock_pcp {
 	struct mem_cgroup *cached; /* this never be root cgroup */
 	unsigned int nr_pages;
@@ -2454,7 +2480,7 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 	struct memcg_stock_pcp *stock;
 	bool ret = true;
 
-	if (nr_pages > CHARGE_BATCH)
+	if (nr_pages > charge_batch)
 		return false;
 
 	stock = &get_cpu_var(memcg_stock);
@@ -2655,6 +2681,8 @@ static int mem_cgroup_do_charge(struct mem_cgroup *memcg, gfp_t gfp_mask,
 	unsigned long flags = 0;
 	int ret;
 
+	/* Compared to pgpgin, this tells how well the per-cpu stock works */
+	this_cpu_inc(memcg->stat->events[MEM_CGROUP_EVENTS_RES_CHARGE]);
 	ret = res_counter_charge(&memcg->res, csize, &fail_res);
 
 	if (likely(!ret)) {
@@ -2737,7 +2765,7 @@ static int __mem_cgroup_try_charge(struct mm_struct *mm,
 				   struct mem_cgroup **ptr,
 				   bool oom)
 {
-	unsigned int batch = max(CHARGE_BATCH, nr_pages);
+	unsigned int batch = max(charge_batch, nr_pages);
 	int nr_oom_retries = MEM_CGROUP_RECLAIM_RETRIES;
 	struct mem_cgroup *memcg = NULL;
 	int ret;
@@ -5320,6 +5348,11 @@ static int mem_cgroup_write(struct cgroup_subsys_state *css, struct cftype *cft,
 			return -EINVAL;
 		break;
 	case RES_SOFT_LIMIT:
+		/* memcg_lite never reclaims towards the soft limit */
+		if (memcg_lite) {
+			ret = -EOPNOTSUPP;
+			break;
+		}
 		ret = res_counter_memparse_write_strategy(buffer, &val);
 		if (ret)
 			break;
@@ -5710,6 +5743,10 @@ static int __mem_cgroup_usage_register_event(struct mem_cgroup *memcg,
 	u64 threshold, usage;
 	int i, size, ret;
 
+	/* memcg_lite never checks the thresholds */
+	if (memcg_lite)
+		return -EOPNOTSUPP;
+
 	ret = res_counter_memparse_write_strategy(args, &threshold);
 	if (ret)
 		return ret;
@@ -6848,16 +6885,20 @@ static struct page *mc_handle_file_pte(struct vm_area_struct *vma,
 		pgoff = pte_to_pgoff(ptent);
 
 	/* page is moved even if it's not RSS of this task(page-faulted). */
-	page = find_get_page(mapping, pgoff);
-
 #ifdef CONFIG_SWAP
 	/* shmem/tmpfs may report page out on swap: account for that too. */
-	if (radix_tree_exceptional_entry(page)) {
-		swp_entry_t swap = radix_to_swp_entry(page);
-		if (do_swap_account)
-			*entry = swap;
-		page = find_get_page(swap_address_space(swap), swap.val);
-	}
+	if (shmem_mapping(mapping)) {
+		page = find_get_entry(mapping, pgoff);
+		if (radix_tree_exceptional_entry(page)) {
+			swp_entry_t swp = radix_to_swp_entry(page);
+			if (do_swap_account)
+				*entry = swp;
+			page = find_get_page(swap_address_space(swp), swp.val);
+		}
+	} else
+		page = find_get_page(mapping, pgoff);
+#else
+	page = find_get_page(mapping, pgoff);
 #endif
 	return page;
 }
@@ -7318,6 +7359,14 @@ struct cgroup_subsys mem_cgroup_subsys = {
 	.early_init = 0,
 };
 
+static int __init enable_memcg_lite(char *s)
+{
+	memcg_lite = true;
+	charge_batch = CHARGE_BATCH_LITE;
+	return 1;
+}
+__setup("memcg_lite", enable_memcg_lite);
+
 #ifdef CONFIG_MEMCG_SWAP
 static int __init enable_swap_account(char *s)
 {
@@ -7336,7 +7385,7 @@ static void __init memsw_file_init(void)
 
 static void __init enable_swap_cgroup(void)
 {
-	if (!mem_cgroup_disabled() && really_do_swap_account) {
+	if (!mem_cgroup_disabled() && really_do_swap_account && !memcg_lite) {
 		do_swap_account = 1;
 		memsw_file_init();
 	}
@@ -35,6 +35,8 @@
 #include <linux/freezer.h>
 #include <linux/ftrace.h>
 #include <linux/ratelimit.h>
+#include <linux/kthread.h>
+#include <linux/hugetlb.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/oom.h>
@@ -423,6 +425,157 @@ void note_oom_kill(void)
 	atomic_inc(&oom_kills);
 }
 
+#ifdef CONFIG_MMU
+/*
+ * A victim that sleeps uninterruptibly, e.g. on flash I/O, keeps all of its
+ * memory until it gets as far as exit_mm(). The OOM reaper unmaps the
+ * anonymous memory of a victim right after the kill instead, so the system
+ * does not have to wait for the victim to make progress.
+ */
+static struct task_struct *oom_reaper_th;
+static DECLARE_WAIT_QUEUE_HEAD(oom_reaper_wait);
+static struct task_struct *oom_reaper_list;
+static DEFINE_SPINLOCK(oom_reaper_lock);
+
+#define MAX_OOM_REAP_RETRIES 10
+
+static bool __oom_reap_task(struct task_struct *tsk, unsigned long *freed)
+{
+	struct vm_area_struct *vma;
+	struct task_struct *p;
+	struct mm_struct *mm;
+	unsigned long rss, left;
+
+	/* Nothing left to reap if the victim already got past exit_mm() */
+	p = find_lock_task_mm(tsk);
+	if (!p)
+		return true;
+
+	mm = p->mm;
+	if (!atomic_inc_not_zero(&mm->mm_users)) {
+		task_unlock(p);
+		return true;
+	}
+	task_unlock(p);
+
+	if (!down_read_trylock(&mm->mmap_sem)) {
+		mmput(mm);
+		return false;
+	}
+
+	rss = get_mm_counter(mm, MM_ANONPAGES);
+	for (vma = mm->mmap; vma; vma = vma->vm_next) {
+		/* Shared and file pages do not go away with the victim */
+		if (!vma->anon_vma || (vma->vm_flags & VM_SHARED))
+			continue;
+		/* Unmapping mlocked pages needs mmap_sem for writing */
+		if (vma->vm_flags & (VM_LOCKED | VM_PFNMAP))
+			continue;
+		if (is_vm_hugetlb_page(vma))
+			continue;
+
+		zap_page_range(vma, vma->vm_start, vma->vm_end - vma->vm_start,
+			       NULL);
+	}
+	left = get_mm_counter(mm, MM_ANONPAGES);
+	*freed = rss > left ? rss - left : 0;
+	up_read(&mm->mmap_sem);
+
+	/*
+	 * The victim cannot release much more of its memory now, so make
+	 * sure the next OOM kill goes for another task.
+	 */
+	tsk->signal->oom_score_adj = OOM_SCORE_ADJ_MIN;
+
+	mmput(mm);
+	return true;
+}
+
+static void oom_reap_task(struct task_struct *tsk)
+{
+	unsigned long freed = 0;
+	int attempts = 0;
+	bool reaped;
+
+	/* Retry a while if the victim holds mmap_sem for writing */
+	while (!(reaped = __oom_reap_task(tsk, &freed)) &&
+	       ++attempts < MAX_OOM_REAP_RETRIES)
+		schedule_timeout_interruptible(HZ / 10);
+
+	trace_oom_reap_task(tsk, local_clock() - tsk->oom_kill_time, freed,
+			    reaped);
+	if (!reaped)
+		pr_info("oom_reaper: unable to reap pid:%d (%s)\n",
+			task_pid_nr(tsk), tsk->comm);
+
+	/*
+	 * Let the OOM killer pick another victim if this one still does
+	 * not exit. Without TIF_MEMDIE the scan no longer waits for it.
+	 */
+	clear_tsk_thread_flag(tsk, TIF_MEMDIE);
+	put_task_struct(tsk);
+}
+
+static int oom_reaper(void *unused)
+{
+	set_freezable();
+
+	while (true) {
+		struct task_struct *tsk = NULL;
+
+		wait_event_freezable(oom_reaper_wait, oom_reaper_list != NULL);
+		spin_lock(&oom_reaper_lock);
+		if (oom_reaper_list) {
+			tsk = oom_reaper_list;
+			oom_reaper_list = tsk->oom_reaper_list;
+			tsk->oom_reaper_list = NULL;
+		}
+		spin_unlock(&oom_reaper_lock);
+
+		if (tsk)
+			oom_reap_task(tsk);
+	}
+
+	return 0;
+}
+
+static void wake_oom_reaper(struct task_struct *tsk)
+{
+	if (!oom_reaper_th)
+		return;
+
+	spin_lock(&oom_reaper_lock);
+	/* tsk is already queued? */
+	if (tsk == oom_reaper_list || tsk->oom_reaper_list) {
+		spin_unlock(&oom_reaper_lock);
+		return;
+	}
+	get_task_struct(tsk);
+	tsk->oom_kill_time = local_clock();
+	tsk->oom_reaper_list = oom_reaper_list;
+	oom_reaper_list = tsk;
+	spin_unlock(&oom_reaper_lock);
+
+	wake_up(&oom_reaper_wait);
+}
+
+static int __init oom_init(void)
+{
+	oom_reaper_th = kthread_run(oom_reaper, NULL, "oom_reaper");
+	if (IS_ERR(oom_reaper_th)) {
+		pr_err("Unable to start OOM reaper %ld. Continuing regardless\n",
+		       PTR_ERR(oom_reaper_th));
+		oom_reaper_th = NULL;
+	}
+	return 0;
+}
+subsys_initcall(oom_init);
+#else
+static inline void wake_oom_reaper(struct task_struct *tsk)
+{
+}
+#endif
+
 #define K(x) ((x) << (PAGE_SHIFT-10))
 /*
  * Must be called while holding a reference to p, which will be released upon
@@ -438,6 +591,7 @@ void oom_kill_process(struct task_struct *p, gfp_t gfp_mask, int order,
 	struct task_struct *t;
 	struct mm_struct *mm;
 	unsigned int victim_points = 0;
+	bool can_oom_reap = true;
 	static DEFINE_RATELIMIT_STATE(oom_rs, DEFAULT_RATELIMIT_INTERVAL,
 					      DEFAULT_RATELIMIT_BURST);
 
@@ -516,10 +670,16 @@ void oom_kill_process(struct task_struct *p, gfp_t gfp_mask, int order,
 	 */
 	rcu_read_lock();
 	for_each_process(p)
-		if (p->mm == mm && !same_thread_group(p, victim) &&
-		    !(p->flags & PF_KTHREAD)) {
-			if (p->signal->oom_score_adj == OOM_SCORE_ADJ_MIN)
+		if (p->mm == mm && !same_thread_group(p, victim)) {
+			/*
+			 * The mm outlives the victim, so it must not be
+			 * reaped.
+			 */
+			if (p->flags & PF_KTHREAD ||
+			    p->signal->oom_score_adj == OOM_SCORE_ADJ_MIN) {
+				can_oom_reap = false;
 				continue;
+			}
 
 			task_lock(p);	/* Protect ->comm from prctl() */
 			pr_err("Kill process %d (%s) sharing same memory\n",
@@ -531,6 +691,10 @@ void oom_kill_process(struct task_struct *p, gfp_t gfp_mask, int order,
 
 	set_tsk_thread_flag(victim, TIF_MEMDIE);
 	do_send_sig_info(SIGKILL, SEND_SIG_FORCED, victim, true);
+
+	if (can_oom_reap)
+		wake_oom_reaper(victim);
+
 	put_task_struct(victim);
 }
 #undef K
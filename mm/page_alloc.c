@@ -61,6 +61,7 @@
 #include <linux/page-debug-flags.h>
 #include <linux/hugetlb.h>
 #include <linux/sched/rt.h>
+#include <linux/async.h>
 
 #include <asm/sections.h>
 #include <asm/tlbflush.h>
@@ -120,6 +121,8 @@ unsigned long totalreserve_pages __read_mostly;
 unsigned long dirty_balance_reserve __read_mostly;
 
 int percpu_pagelist_fraction;
+/* Per zone type pcp->high in pages, overriding the above; 0 is auto */
+int sysctl_percpu_pagelist_high[MAX_NR_ZONES];
 gfp_t gfp_allowed_mask __read_mostly = GFP_BOOT_MASK;
 
 #ifdef CONFIG_PM_SLEEP
@@ -2587,6 +2590,10 @@ rebalance:
 		goto nopage;
 	}
 
+	/* Part of memory may not have been handed to the allocator yet */
+	if (deferred_init_wait())
+		goto restart;
+
 	/* Avoid recursion of direct reclaim */
 	if (current->flags & PF_MEMALLOC)
 		goto nopage;
@@ -2806,6 +2813,104 @@ out:
 }
 EXPORT_SYMBOL(__alloc_pages_nodemask);
 
+/**
+ * alloc_pages_bulk - allocate a number of order-0 pages at once
+ * @gfp_mask: GFP flags for the allocation
+ * @nr_pages: number of pages wanted
+ * @pages: array the pages are stored to
+ *
+ * Refill loops that allocate one page after the other go through the
+ * per-cpu lists and, every pcp->batch pages, the zone lock each time.
+ * When the preferred zone is well above its low watermark, this takes
+ * all pages from its per-cpu list with interrupts disabled once, and
+ * refills the list with a single hold of the zone lock. Otherwise a
+ * single page is allocated the normal way, with all its fallbacks.
+ *
+ * Returns the number of pages stored to @pages, which can be less than
+ * @nr_pages; 0 means that even a regular allocation failed. The pages
+ * are freed with __free_page() or release_pages() as usual.
+ */
+unsigned long alloc_pages_bulk(gfp_t gfp_mask, unsigned long nr_pages,
+			       struct page **pages)
+{
+	enum zone_type high_zoneidx = gfp_zone(gfp_mask);
+	int migratetype = allocflags_to_migratetype(gfp_mask);
+	int cold = !!(gfp_mask & __GFP_COLD);
+	struct zonelist *zonelist;
+	struct per_cpu_pages *pcp;
+	struct list_head *list;
+	struct zone *zone;
+	unsigned long flags, nr = 0, i;
+	struct page *page;
+
+	gfp_mask &= gfp_allowed_mask;
+
+	if (!nr_pages)
+		return 0;
+	if (nr_pages == 1 || (gfp_mask & __GFP_KMEMCG) ||
+	    should_fail_alloc_page(gfp_mask, 0))
+		goto single;
+
+	zonelist = node_zonelist(numa_node_id(), gfp_mask);
+	first_zones_zonelist(zonelist, high_zoneidx,
+			     &cpuset_current_mems_allowed, &zone);
+	if (!zone)
+		goto single;
+
+	/* Leave anything close to the watermarks to the regular path */
+	if (zone_page_state(zone, NR_ALLOC_BATCH) < (long)nr_pages ||
+	    !zone_watermark_ok(zone, 0, low_wmark_pages(zone) + nr_pages,
+			       zone_idx(zone), 0))
+		goto single;
+
+	local_irq_save(flags);
+	pcp = &this_cpu_ptr(zone->pageset)->pcp;
+	list = &pcp->lists[migratetype];
+	while (nr < nr_pages) {
+		if (list_empty(list)) {
+			pcp->count += rmqueue_bulk(zone, 0,
+					max_t(unsigned long, pcp->batch,
+					      nr_pages - nr),
+					list, migratetype, cold);
+			if (unlikely(list_empty(list)))
+				break;
+		}
+
+		if (cold)
+			page = list_entry(list->prev, struct page, lru);
+		else
+			page = list_entry(list->next, struct page, lru);
+
+		list_del(&page->lru);
+		pcp->count--;
+		pages[nr++] = page;
+		zone_statistics(zone, zone, gfp_mask);
+	}
+	__mod_zone_page_state(zone, NR_ALLOC_BATCH, -(long)nr);
+	__count_zone_vm_events(PGALLOC, zone, nr);
+	local_irq_restore(flags);
+
+	/* Bad pages are dropped, as buffered_rmqueue() does */
+	for (i = 0, nr_pages = nr, nr = 0; i < nr_pages; i++) {
+		page = pages[i];
+		VM_BUG_ON_PAGE(bad_range(zone, page), page);
+		if (prep_new_page(page, 0, gfp_mask))
+			continue;
+		trace_mm_page_alloc(page, 0, gfp_mask, migratetype);
+		pages[nr++] = page;
+	}
+	if (nr)
+		return nr;
+
+single:
+	page = alloc_pages(gfp_mask, 0);
+	if (!page)
+		return 0;
+	pages[0] = page;
+	return 1;
+}
+EXPORT_SYMBOL(alloc_pages_bulk);
+
 /*
  * Common helper functions.
  */
@@ -4052,10 +4157,166 @@ static void setup_zone_migrate_reserve(struct zone *zone)
  * up by free_all_bootmem() once the early boot process is
  * done. Non-atomic initialization, single-pass.
  */
+static void __meminit __init_single_page(unsigned long pfn, unsigned long zone,
+					int nid, struct zone *z)
+{
+	struct page *page = pfn_to_page(pfn);
+
+	set_page_links(page, zone, nid, pfn);
+	mminit_verify_page_links(page, zone, nid, pfn);
+	init_page_count(page);
+	page_mapcount_reset(page);
+	page_cpupid_reset_last(page);
+	SetPageReserved(page);
+	/*
+	 * Mark the block movable so that blocks are reserved for
+	 * movable at startup. This will force kernel allocations
+	 * to reserve their blocks rather than leaking throughout
+	 * the address space during boot when many long-lived
+	 * kernel allocations are made. Later some blocks near
+	 * the start are marked MIGRATE_RESERVE by
+	 * setup_zone_migrate_reserve()
+	 *
+	 * bitmap is created for zone's valid pfn range. but memmap
+	 * can be created for invalid pages (for alignment)
+	 * check here not to call set_pageblock_migratetype() against
+	 * pfn out of zone.
+	 */
+	if ((z->zone_start_pfn <= pfn)
+	    && (pfn < zone_end_pfn(z))
+	    && !(pfn & (pageblock_nr_pages - 1)))
+		set_pageblock_migratetype(page, MIGRATE_MOVABLE);
+
+	INIT_LIST_HEAD(&page->lru);
+#ifdef WANT_PAGE_VIRTUAL
+	/* The shift won't overflow because ZONE_NORMAL is below 4G. */
+	if (!is_highmem_idx(zone))
+		set_page_address(page, __va(pfn << PAGE_SHIFT));
+#endif
+}
+
+#ifdef CONFIG_DEFERRED_STRUCT_PAGE_INIT
+/*
+ * Only the struct pages of the first DEFERRED_EAGER_PAGES of each lowmem
+ * zone are initialised while the zones are set up.  Reserved pages past
+ * that are done by free_all_bootmem(), as free_reserved_area() may hand
+ * them to the buddy allocator at any time after it.  The free pages are
+ * set up, and released from bootmem, by an async function that runs
+ * alongside the initcalls.  Sleeping allocations that fail in the
+ * meantime wait for it.
+ */
+#define DEFERRED_EAGER_PAGES	((32UL << 20) >> PAGE_SHIFT)
+
+static unsigned long deferred_start_pfn[MAX_NR_ZONES] __meminitdata;
+static unsigned long deferred_end_pfn[MAX_NR_ZONES] __meminitdata;
+static bool deferred_pending;
+static async_cookie_t deferred_cookie;
+
+/* Returns the pfn up to which memmap_init_zone() initialises @zone now */
+static unsigned long __meminit deferred_init_limit(unsigned long zone,
+						   unsigned long start_pfn,
+						   unsigned long end_pfn)
+{
+	unsigned long limit;
+
+	if (is_highmem_idx(zone))
+		return end_pfn;
+
+	/* Keep whole pageblocks on either side, bootmem frees in blocks */
+	limit = ALIGN(start_pfn + DEFERRED_EAGER_PAGES, pageblock_nr_pages);
+	if (limit >= end_pfn)
+		return end_pfn;
+
+	deferred_start_pfn[zone] = limit;
+	deferred_end_pfn[zone] = end_pfn;
+	deferred_pending = true;
+	return limit;
+}
+
+bool __init early_page_deferred(unsigned long pfn)
+{
+	int i;
+
+	for (i = 0; i < MAX_NR_ZONES; i++)
+		if (pfn >= deferred_start_pfn[i] && pfn < deferred_end_pfn[i])
+			return true;
+	return false;
+}
+
+bool deferred_init_pending(void)
+{
+	return deferred_pending;
+}
+
+/* Initialises the struct page of a pfn in one of the deferred ranges */
+void __init init_deferred_page(unsigned long pfn)
+{
+	int nid = first_online_node;
+	unsigned long zone, flags;
+	struct zone *z;
+
+	for (zone = 0; zone < MAX_NR_ZONES; zone++)
+		if (pfn >= deferred_start_pfn[zone] &&
+		    pfn < deferred_end_pfn[zone])
+			break;
+	if (zone == MAX_NR_ZONES || !early_pfn_valid(pfn))
+		return;
+
+	z = &NODE_DATA(nid)->node_zones[zone];
+	if (pfn & (pageblock_nr_pages - 1)) {
+		__init_single_page(pfn, zone, nid, z);
+		return;
+	}
+
+	/*
+	 * The pageblock_flags word is shared with blocks the allocator
+	 * already changes the migratetype of under the zone lock.
+	 */
+	spin_lock_irqsave(&z->lock, flags);
+	__init_single_page(pfn, zone, nid, z);
+	spin_unlock_irqrestore(&z->lock, flags);
+}
+
+static void __init deferred_init_memmap(void *data, async_cookie_t cookie)
+{
+	free_deferred_bootmem();
+	setup_per_zone_wmarks();
+	deferred_pending = false;
+}
+
+static int __init deferred_init_start(void)
+{
+	if (deferred_pending)
+		deferred_cookie = async_schedule(deferred_init_memmap, NULL);
+	return 0;
+}
+pure_initcall(deferred_init_start);
+
+bool deferred_init_wait(void)
+{
+	/* Nothing to wait for before deferred_init_start() */
+	if (!deferred_pending || !deferred_cookie)
+		return false;
+	async_synchronize_cookie(deferred_cookie + 1);
+	return true;
+}
+#else
+static inline unsigned long deferred_init_limit(unsigned long zone,
+						unsigned long start_pfn,
+						unsigned long end_pfn)
+{
+	return end_pfn;
+}
+
+static inline bool deferred_init_wait(void)
+{
+	return false;
+}
+#endif
+
 void __meminit memmap_init_zone(unsigned long size, int nid, unsigned long zone,
 		unsigned long start_pfn, enum memmap_context context)
 {
-	struct page *page;
 	unsigned long end_pfn = start_pfn + size;
 	unsigned long pfn;
 	struct zone *z;
@@ -4063,6 +4324,9 @@ void __meminit memmap_init_zone(unsigned long size, int nid, unsigned long zone,
 	if (highest_memmap_pfn < end_pfn - 1)
 		highest_memmap_pfn = end_pfn - 1;
 
+	if (context == MEMMAP_EARLY)
+		end_pfn = deferred_init_limit(zone, start_pfn, end_pfn);
+
 	z = &NODE_DATA(nid)->node_zones[zone];
 	for (pfn = start_pfn; pfn < end_pfn; pfn++) {
 		/*
@@ -4076,38 +4340,7 @@ void __meminit memmap_init_zone(unsigned long size, int nid, unsigned long zone,
 			if (!early_pfn_in_nid(pfn, nid))
 				continue;
 		}
-		page = pfn_to_page(pfn);
-		set_page_links(page, zone, nid, pfn);
-		mminit_verify_page_links(page, zone, nid, pfn);
-		init_page_count(page);
-		page_mapcount_reset(page);
-		page_cpupid_reset_last(page);
-		SetPageReserved(page);
-		/*
-		 * Mark the block movable so that blocks are reserved for
-		 * movable at startup. This will force kernel allocations
-		 * to reserve their blocks rather than leaking throughout
-		 * the address space during boot when many long-lived
-		 * kernel allocations are made. Later some blocks near
-		 * the start are marked MIGRATE_RESERVE by
-		 * setup_zone_migrate_reserve()
-		 *
-		 * bitmap is created for zone's valid pfn range. but memmap
-		 * can be created for invalid pages (for alignment)
-		 * check here not to call set_pageblock_migratetype() against
-		 * pfn out of zone.
-		 */
-		if ((z->zone_start_pfn <= pfn)
-		    && (pfn < zone_end_pfn(z))
-		    && !(pfn & (pageblock_nr_pages - 1)))
-			set_pageblock_migratetype(page, MIGRATE_MOVABLE);
-
-		INIT_LIST_HEAD(&page->lru);
-#ifdef WANT_PAGE_VIRTUAL
-		/* The shift won't overflow because ZONE_NORMAL is below 4G. */
-		if (!is_highmem_idx(zone))
-			set_page_address(page, __va(pfn << PAGE_SHIFT));
-#endif
+		__init_single_page(pfn, zone, nid, z);
 	}
 }
 
@@ -4244,7 +4477,11 @@ static void pageset_set_high(struct per_cpu_pageset *p,
 static void pageset_set_high_and_batch(struct zone *zone,
 				       struct per_cpu_pageset *pcp)
 {
-	if (percpu_pagelist_fraction)
+	int high = sysctl_percpu_pagelist_high[zone_idx(zone)];
+
+	if (high)
+		pageset_set_high(pcp, high);
+	else if (percpu_pagelist_fraction)
 		pageset_set_high(pcp,
 			(zone->managed_pages /
 				percpu_pagelist_fraction));
@@ -5901,6 +6138,34 @@ out:
 	return ret;
 }
 
+/*
+ * percpu_pagelist_high - sets pcp->high, and with it pcp->batch, for each
+ * zone of a type directly. A zone type left at 0 is sized automatically,
+ * from percpu_pagelist_fraction or from the size of the zone.
+ */
+int percpu_pagelist_high_sysctl_handler(ctl_table *table, int write,
+	void __user *buffer, size_t *length, loff_t *ppos)
+{
+	struct zone *zone;
+	int ret;
+
+	mutex_lock(&pcp_batch_high_lock);
+	ret = proc_dointvec_minmax(table, write, buffer, length, ppos);
+	if (!write || ret < 0)
+		goto out;
+
+	for_each_populated_zone(zone) {
+		unsigned int cpu;
+
+		for_each_possible_cpu(cpu)
+			pageset_set_high_and_batch(zone,
+					per_cpu_ptr(zone->pageset, cpu));
+	}
+out:
+	mutex_unlock(&pcp_batch_high_lock);
+	return ret;
+}
+
 int hashdist = HASHDIST_DEFAULT;
 
 #ifdef CONFIG_NUMA
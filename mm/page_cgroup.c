@@ -77,7 +77,8 @@ void __init page_cgroup_init_flatmem(void)
 		if (fail)
 			goto fail;
 	}
-	printk(KERN_INFO "allocated %ld bytes of page_cgroup\n", total_usage);
+	printk(KERN_INFO "allocated %ld bytes of page_cgroup (%zu per page)\n",
+	       total_usage, sizeof(struct page_cgroup));
 	printk(KERN_INFO "please try 'cgroup_disable=memory' option if you"
 	" don't want memory cgroups\n");
 	return;
@@ -305,7 +306,8 @@ void __init page_cgroup_init(void)
 		}
 	}
 	hotplug_memory_notifier(page_cgroup_callback, 0);
-	printk(KERN_INFO "allocated %ld bytes of page_cgroup\n", total_usage);
+	printk(KERN_INFO "allocated %ld bytes of page_cgroup (%zu per page)\n",
+	       total_usage, sizeof(struct page_cgroup));
 	printk(KERN_INFO "please try 'cgroup_disable=memory' option if you "
 			 "don't want memory cgroups\n");
 	return;
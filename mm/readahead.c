@@ -242,6 +242,49 @@ unsigned long max_sane_readahead(unsigned long nr)
 	return min(nr, MAX_READAHEAD);
 }
 
+/*
+ * Each readahead window is scored once the reader moves on from it.  It
+ * was used if its PG_readahead marker was hit or the reader went on right
+ * past its end.  It was wasted if the reader went elsewhere first, or had
+ * to read pages of it again because they were evicted before being used.
+ *
+ * While wasted windows outweigh the used ones, the maximum window of the
+ * file is halved for every factor of two, down to an eighth.  The scores
+ * decay, so a file that turns from random to streaming access ramps back
+ * up within a few windows.
+ */
+#define RA_SCORE_DECAY	32
+#define RA_MAX_SHRINK	3
+
+void ra_score_window(struct file_ra_state *ra, bool hit_marker,
+		pgoff_t offset)
+{
+	if (!ra->unscored)
+		return;
+	ra->unscored = 0;
+
+	if (hit_marker || offset == ra->start + ra->size)
+		ra->used++;
+	else
+		ra->wasted++;
+
+	if (ra->used + ra->wasted >= RA_SCORE_DECAY) {
+		ra->used /= 2;
+		ra->wasted /= 2;
+	}
+}
+
+unsigned long ra_max_pages(struct file_ra_state *ra)
+{
+	unsigned int used = ra->used + 1;
+	int shift = 0;
+
+	while (shift < RA_MAX_SHRINK && ra->wasted > (used << shift))
+		shift++;
+
+	return max_sane_readahead(max(ra->ra_pages >> shift, 1U));
+}
+
 /*
  * Set the initial window size, round to next power of 2 and square
  * for small size, x 4 for medium, and x 2 for large
@@ -381,9 +424,12 @@ ondemand_readahead(struct address_space *mapping,
 		   bool hit_readahead_marker, pgoff_t offset,
 		   unsigned long req_size)
 {
-	unsigned long max = max_sane_readahead(ra->ra_pages);
+	unsigned long max;
 	pgoff_t prev_offset;
 
+	ra_score_window(ra, hit_readahead_marker, offset);
+	max = ra_max_pages(ra);
+
 	/*
 	 * start of file
 	 */
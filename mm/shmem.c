@@ -152,13 +152,14 @@ static inline void shmem_unacct_size(unsigned long flags, loff_t size)
 /*
  * ... whereas tmpfs objects are accounted incrementally as
  * pages are allocated, in order to allow huge sparse files.
- * shmem_getpage reports shmem_acct_block failure as -ENOSPC not -ENOMEM,
+ * shmem_getpage reports shmem_acct_blocks failure as -ENOSPC not -ENOMEM,
  * so that a failure on a sparse tmpfs mapping will give SIGBUS not OOM.
  */
-static inline int shmem_acct_block(unsigned long flags)
+static inline int shmem_acct_blocks(unsigned long flags, long pages)
 {
 	return (flags & VM_NORESERVE) ?
-		security_vm_enough_memory_mm(current->mm, VM_ACCT(PAGE_CACHE_SIZE)) : 0;
+		security_vm_enough_memory_mm(current->mm,
+				pages * VM_ACCT(PAGE_CACHE_SIZE)) : 0;
 }
 
 static inline void shmem_unacct_blocks(unsigned long flags, long pages)
@@ -1121,7 +1122,7 @@ repeat:
 		swap_free(swap);
 
 	} else {
-		if (shmem_acct_block(info->flags)) {
+		if (shmem_acct_blocks(info->flags, 1)) {
 			error = -ENOSPC;
 			goto failed;
 		}
@@ -1468,6 +1469,106 @@ shmem_write_end(struct file *file, struct address_space *mapping,
 	return copied;
 }
 
+/* How many pages shmem_alloc_run() adds and accounts for in one go */
+#define SHMEM_ALLOC_BATCH	16
+
+/*
+ * Fill the holes from index on with new !Uptodate pages, stopping at end,
+ * at the first page or swap entry already present, or after
+ * SHMEM_ALLOC_BATCH pages. The space for the whole run is reserved at once
+ * instead of page by page as shmem_getpage does. The pages are left dirty
+ * and !Uptodate, just like fallocated ones. Returns how many pages were
+ * added: 0 when index is not a hole or the space cannot be reserved, in
+ * which case shmem_getpage is left to retry or fail properly.
+ */
+static pgoff_t shmem_alloc_run(struct inode *inode, pgoff_t index,
+			       pgoff_t end, struct shmem_falloc *shmem_falloc)
+{
+	struct address_space *mapping = inode->i_mapping;
+	struct shmem_inode_info *info = SHMEM_I(inode);
+	struct shmem_sb_info *sbinfo = SHMEM_SB(inode->i_sb);
+	gfp_t gfp = mapping_gfp_mask(mapping);
+	struct page *page;
+	pgoff_t nr, added;
+	int error;
+
+	if (end - index > SHMEM_ALLOC_BATCH)
+		end = index + SHMEM_ALLOC_BATCH;
+
+	rcu_read_lock();
+	for (nr = 0; index + nr < end; nr++) {
+		if (radix_tree_lookup(&mapping->page_tree, index + nr))
+			break;
+	}
+	rcu_read_unlock();
+	if (!nr)
+		return 0;
+
+	if (shmem_acct_blocks(info->flags, nr))
+		return 0;
+	if (sbinfo->max_blocks) {
+		if (nr > sbinfo->max_blocks ||
+		    percpu_counter_compare(&sbinfo->used_blocks,
+					   sbinfo->max_blocks - nr) > 0) {
+			shmem_unacct_blocks(info->flags, nr);
+			return 0;
+		}
+		percpu_counter_add(&sbinfo->used_blocks, nr);
+	}
+
+	for (added = 0; added < nr; added++) {
+		page = shmem_alloc_page(gfp, info, index + added);
+		if (!page)
+			break;
+
+		SetPageSwapBacked(page);
+		__set_page_locked(page);
+		error = mem_cgroup_cache_charge(page, current->mm,
+						gfp & GFP_RECLAIM_MASK);
+		if (error)
+			goto release;
+		error = radix_tree_maybe_preload(gfp & GFP_RECLAIM_MASK);
+		if (!error) {
+			error = shmem_add_to_page_cache(page, mapping,
+						index + added, gfp, NULL);
+			radix_tree_preload_end();
+		}
+		if (error) {
+			mem_cgroup_uncharge_cache_page(page);
+			goto release;
+		}
+		lru_cache_add_anon(page);
+
+		/* Like shmem_fallocate(), we have the page lock */
+		if (shmem_falloc) {
+			shmem_falloc->next++;
+			shmem_falloc->nr_falloced++;
+		}
+		set_page_dirty(page);
+		unlock_page(page);
+		page_cache_release(page);
+	}
+	goto account;
+
+release:
+	unlock_page(page);
+	page_cache_release(page);
+account:
+	if (added) {
+		spin_lock(&info->lock);
+		info->alloced += added;
+		inode->i_blocks += added * BLOCKS_PER_PAGE;
+		shmem_recalc_inode(inode);
+		spin_unlock(&info->lock);
+	}
+	if (added < nr) {
+		if (sbinfo->max_blocks)
+			percpu_counter_add(&sbinfo->used_blocks, added - nr);
+		shmem_unacct_blocks(info->flags, nr - added);
+	}
+	return added;
+}
+
 static void do_shmem_file_read(struct file *filp, loff_t *ppos, read_descriptor_t *desc, read_actor_t actor)
 {
 	struct inode *inode = file_inode(filp);
@@ -1606,6 +1707,71 @@ static ssize_t shmem_file_aio_read(struct kiocb *iocb,
 	return retval;
 }
 
+/*
+ * Large writes first fill the holes they will cover in runs, which saves
+ * the per-page accounting and locking of shmem_write_begin. Pages left
+ * over by a short write are removed again.
+ */
+static ssize_t shmem_file_aio_write(struct kiocb *iocb,
+		const struct iovec *iov, unsigned long nr_segs, loff_t pos)
+{
+	struct file *file = iocb->ki_filp;
+	struct inode *inode = file_inode(file);
+	pgoff_t start, index, end;
+	unsigned long segs = nr_segs;
+	size_t count;
+	ssize_t ret;
+
+	BUG_ON(iocb->ki_pos != pos);
+
+	mutex_lock(&inode->i_mutex);
+
+	if (file->f_flags & O_APPEND)
+		pos = i_size_read(inode);
+	start = index = pos >> PAGE_CACHE_SHIFT;
+	if (!generic_segment_checks(iov, &segs, &count, VERIFY_READ) &&
+	    count >= SHMEM_ALLOC_BATCH * PAGE_CACHE_SIZE &&
+	    pos + count <= rlimit(RLIMIT_FSIZE) &&
+	    pos + count <= inode->i_sb->s_maxbytes) {
+		pgoff_t nr;
+
+		end = (pos + count + PAGE_CACHE_SIZE - 1) >> PAGE_CACHE_SHIFT;
+		while (index < end) {
+			nr = shmem_alloc_run(inode, index, end, NULL);
+			if (!nr)
+				break;
+			index += nr;
+			cond_resched();
+		}
+	}
+
+	ret = __generic_file_aio_write(iocb, iov, nr_segs, &iocb->ki_pos);
+
+	/*
+	 * Only the pages from start to index were added here. Those the write
+	 * did not reach are still !Uptodate, unlike any it copied into.
+	 */
+	if (index > start) {
+		loff_t written_end = ret > 0 ? iocb->ki_pos : pos;
+
+		shmem_undo_range(inode,
+			max_t(loff_t, round_down(written_end, PAGE_CACHE_SIZE),
+			      (loff_t)start << PAGE_CACHE_SHIFT),
+			((loff_t)index << PAGE_CACHE_SHIFT) - 1, true);
+	}
+
+	mutex_unlock(&inode->i_mutex);
+
+	if (ret > 0) {
+		ssize_t err;
+
+		err = generic_write_sync(file, iocb->ki_pos - ret, ret);
+		if (err < 0)
+			ret = err;
+	}
+	return ret;
+}
+
 static ssize_t shmem_file_splice_read(struct file *in, loff_t *ppos,
 				struct pipe_inode_info *pipe, size_t len,
 				unsigned int flags)
@@ -1870,6 +2036,7 @@ static long shmem_fallocate(struct file *file, int mode, loff_t offset,
 
 	for (index = start; index < end; index++) {
 		struct page *page;
+		pgoff_t nr = 0;
 
 		/*
 		 * Good, the fallocate(2) manpage permits EINTR: we may have
@@ -1879,9 +2046,11 @@ static long shmem_fallocate(struct file *file, int mode, loff_t offset,
 			error = -EINTR;
 		else if (shmem_falloc.nr_unswapped > shmem_falloc.nr_falloced)
 			error = -ENOMEM;
-		else
-			error = shmem_getpage(inode, index, &page, SGP_FALLOC,
-									NULL);
+		else {
+			nr = shmem_alloc_run(inode, index, end, &shmem_falloc);
+			error = nr ? 0 : shmem_getpage(inode, index, &page,
+						       SGP_FALLOC, NULL);
+		}
 		if (error) {
 			/* Remove the !PageUptodate pages we added */
 			shmem_undo_range(inode,
@@ -1890,6 +2059,13 @@ static long shmem_fallocate(struct file *file, int mode, loff_t offset,
 			goto undone;
 		}
 
+		/* A run of holes was filled without going through a page */
+		if (nr) {
+			index += nr - 1;
+			cond_resched();
+			continue;
+		}
+
 		/*
 		 * Inform shmem_writepage() how far we have reached.
 		 * No need for lock or barrier: we have the page lock.
@@ -2733,7 +2909,7 @@ static const struct file_operations shmem_file_operations = {
 	.read		= do_sync_read,
 	.write		= do_sync_write,
 	.aio_read	= shmem_file_aio_read,
-	.aio_write	= generic_file_aio_write,
+	.aio_write	= shmem_file_aio_write,
 	.fsync		= noop_fsync,
 	.splice_read	= shmem_file_splice_read,
 	.splice_write	= generic_file_splice_write,
@@ -47,6 +47,10 @@ struct kmem_cache *kmalloc_slab(size_t, gfp_t);
 /* Functions provided by the slab allocators */
 extern int __kmem_cache_create(struct kmem_cache *, unsigned long flags);
 
+/* Object by object bulk operations, for allocators without a faster way */
+int __kmem_cache_alloc_bulk(struct kmem_cache *, gfp_t, size_t, void **);
+void __kmem_cache_free_bulk(struct kmem_cache *, size_t, void **);
+
 extern struct kmem_cache *create_kmalloc_cache(const char *name, size_t size,
 			unsigned long flags);
 extern void create_boot_cache(struct kmem_cache *, const char *name,
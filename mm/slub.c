@@ -33,6 +33,8 @@
 #include <linux/stacktrace.h>
 #include <linux/prefetch.h>
 #include <linux/memcontrol.h>
+#include <linux/hash.h>
+#include <linux/sort.h>
 
 #include <trace/events/kmem.h>
 
@@ -228,6 +230,89 @@ static inline void stat(const struct kmem_cache *s, enum stat_item si)
 #endif
 }
 
+enum slab_profile_item { PROFILE_ALLOC, PROFILE_FREE, NR_PROFILE_ITEMS };
+
+#ifdef CONFIG_SYSFS
+/*
+ * Slowpath profiling. Unlike the SLUB_STATS counters it is enabled at
+ * runtime and per cache, through /sys/kernel/slab/<cache>/profile_rate.
+ * One in profile_rate slowpath allocations and frees records its caller
+ * in a small hash table, which /sys/kernel/slab/<cache>/profile shows.
+ * The fastpaths are not touched, and a disabled cache only pays for a
+ * test of profile_rate in the slowpaths.
+ */
+#define SLAB_PROFILE_BITS	6
+#define SLAB_PROFILE_SLOTS	(1 << SLAB_PROFILE_BITS)
+
+struct slab_profile_entry {
+	unsigned long addr;
+	unsigned long hits[NR_PROFILE_ITEMS];
+};
+
+struct slab_profile {
+	spinlock_t lock;
+	unsigned int __percpu *tick;
+	/* Samples that found the table full */
+	unsigned long dropped[NR_PROFILE_ITEMS];
+	struct slab_profile_entry entry[SLAB_PROFILE_SLOTS];
+};
+
+/*
+ * Serializes setting up, reading and freeing s->profile.  Not slab_mutex,
+ * the memcg attribute propagation holds that one.
+ */
+static DEFINE_MUTEX(slab_profile_mutex);
+
+static void slab_profile_hit(struct kmem_cache *s, unsigned long addr,
+			     enum slab_profile_item item)
+{
+	unsigned int rate = ACCESS_ONCE(s->profile_rate);
+	struct slab_profile *p;
+	unsigned long flags;
+	unsigned int i, h;
+
+	if (likely(!rate))
+		return;
+
+	/* Pairs with the smp_wmb() in profile_rate_store() */
+	smp_rmb();
+	p = s->profile;
+	if (this_cpu_inc_return(*p->tick) % rate)
+		return;
+
+	h = hash_long(addr, SLAB_PROFILE_BITS);
+	spin_lock_irqsave(&p->lock, flags);
+	for (i = 0; i < SLAB_PROFILE_SLOTS; i++) {
+		struct slab_profile_entry *e;
+
+		e = &p->entry[(h + i) & (SLAB_PROFILE_SLOTS - 1)];
+		if (e->addr == addr || !e->addr) {
+			e->addr = addr;
+			e->hits[item]++;
+			goto out;
+		}
+	}
+	p->dropped[item]++;
+out:
+	spin_unlock_irqrestore(&p->lock, flags);
+}
+
+static void slab_profile_free(struct kmem_cache *s)
+{
+	mutex_lock(&slab_profile_mutex);
+	if (s->profile) {
+		free_percpu(s->profile->tick);
+		kfree(s->profile);
+		s->profile = NULL;
+	}
+	mutex_unlock(&slab_profile_mutex);
+}
+#else
+static inline void slab_profile_hit(struct kmem_cache *s, unsigned long addr,
+				    enum slab_profile_item item) { }
+static inline void slab_profile_free(struct kmem_cache *s) { }
+#endif
+
 /********************************************************************
  * 			Core slab cache functions
  *******************************************************************/
@@ -2291,6 +2376,8 @@ static void *__slab_alloc(struct kmem_cache *s, gfp_t gfpflags, int node,
 	c = this_cpu_ptr(s->cpu_slab);
 #endif
 
+	slab_profile_hit(s, addr, PROFILE_ALLOC);
+
 	page = c->page;
 	if (!page)
 		goto new_slab;
@@ -2543,6 +2630,7 @@ static void __slab_free(struct kmem_cache *s, struct page *page,
 	unsigned long uninitialized_var(flags);
 
 	stat(s, FREE_SLOWPATH);
+	slab_profile_hit(s, addr, PROFILE_FREE);
 
 	if (kmem_cache_debug(s) &&
 		!(n = free_debug_processing(s, page, x, addr, &flags)))
@@ -2704,6 +2792,108 @@ void kmem_cache_free(struct kmem_cache *s, void *x)
 }
 EXPORT_SYMBOL(kmem_cache_free);
 
+/*
+ * The bulk operations keep interrupts disabled over the whole batch and
+ * work on the per cpu freelist directly, instead of paying a
+ * this_cpu_cmpxchg_double() per object. The tid is advanced whenever
+ * interrupts get enabled again, so that a fastpath preempted halfway
+ * through retries.
+ */
+void kmem_cache_free_bulk(struct kmem_cache *s, size_t size, void **p)
+{
+	struct kmem_cache_cpu *c;
+	struct kmem_cache *cs;
+	struct page *page;
+	size_t i;
+
+	local_irq_disable();
+	c = this_cpu_ptr(s->cpu_slab);
+
+	for (i = 0; i < size; i++) {
+		void *object = p[i];
+
+		BUG_ON(!object);
+		cs = cache_from_obj(s, object);
+		if (unlikely(!cs))
+			continue;
+		page = virt_to_head_page(object);
+
+		if (likely(cs == s && page == c->page)) {
+			slab_free_hook(s, object);
+			set_freepointer(s, object, c->freelist);
+			c->freelist = object;
+			stat(s, FREE_FASTPATH);
+			continue;
+		}
+
+		/* Another slab, or a memcg cache: take the regular path */
+		c->tid = next_tid(c->tid);
+		local_irq_enable();
+		slab_free(cs, page, object, _RET_IP_);
+		local_irq_disable();
+		c = this_cpu_ptr(s->cpu_slab);
+	}
+
+	c->tid = next_tid(c->tid);
+	local_irq_enable();
+}
+EXPORT_SYMBOL(kmem_cache_free_bulk);
+
+int kmem_cache_alloc_bulk(struct kmem_cache *s, gfp_t flags, size_t size,
+			  void **p)
+{
+	struct kmem_cache_cpu *c;
+	size_t i;
+
+	if (slab_pre_alloc_hook(s, flags))
+		return 0;
+
+	s = memcg_kmem_get_cache(s, flags);
+
+	local_irq_disable();
+	c = this_cpu_ptr(s->cpu_slab);
+
+	for (i = 0; i < size; i++) {
+		void *object = c->freelist;
+
+		if (unlikely(!object)) {
+			/*
+			 * __slab_alloc() may enable interrupts to allocate
+			 * a new slab.
+			 */
+			c->tid = next_tid(c->tid);
+			p[i] = __slab_alloc(s, flags, NUMA_NO_NODE, _RET_IP_, c);
+			if (unlikely(!p[i]))
+				goto error;
+			c = this_cpu_ptr(s->cpu_slab);
+			continue;
+		}
+		c->freelist = get_freepointer(s, object);
+		p[i] = object;
+		stat(s, ALLOC_FASTPATH);
+	}
+	c->tid = next_tid(c->tid);
+	local_irq_enable();
+
+	for (i = 0; i < size; i++) {
+		if (unlikely(flags & __GFP_ZERO))
+			memset(p[i], 0, s->object_size);
+		slab_post_alloc_hook(s, flags, p[i]);
+	}
+	return i;
+
+error:
+	c = this_cpu_ptr(s->cpu_slab);
+	c->tid = next_tid(c->tid);
+	local_irq_enable();
+	while (i--) {
+		slab_post_alloc_hook(s, flags, p[i]);
+		kmem_cache_free(s, p[i]);
+	}
+	return 0;
+}
+EXPORT_SYMBOL(kmem_cache_alloc_bulk);
+
 /*
  * Object placement in a slab is made very easy because we always start at
  * offset 0. If we tune the size of the object to the alignment then we can
@@ -2733,6 +2923,14 @@ static int slub_min_objects;
  */
 static int slub_nomerge;
 
+/*
+ * Compact mode, for small systems that would rather give up some speed
+ * than memory: order 0 slabs unless they waste more than 1/8th, merging
+ * of caches whose sizes are up to 1/8th apart, and no more than a few
+ * free objects and empty slabs kept around per cpu and per node.
+ */
+static int slub_compact;
+
 /*
  * Calculate the order of allocation given an slab object size.
  *
@@ -2794,6 +2992,13 @@ static inline int calculate_order(int size, int reserved)
 	int fraction;
 	int max_objects;
 
+	/* The smallest order that keeps the waste within 1/8th */
+	if (slub_compact) {
+		order = slab_order(size, 1, slub_max_order, 8, reserved);
+		if (order <= slub_max_order)
+			return order;
+	}
+
 	/*
 	 * Attempt to find best configuration for a slab. This
 	 * works by first attempting to generate a layout with
@@ -3144,6 +3349,11 @@ static int kmem_cache_open(struct kmem_cache *s, unsigned long flags)
 	else
 		s->cpu_partial = 30;
 
+	if (slub_compact) {
+		s->min_partial = 1;
+		s->cpu_partial = min(s->cpu_partial, 2);
+	}
+
 #ifdef CONFIG_NUMA
 	s->remote_node_defrag_ratio = 1000;
 #endif
@@ -3228,6 +3438,7 @@ static inline int kmem_cache_close(struct kmem_cache *s)
 	}
 	free_percpu(s->cpu_slab);
 	free_kmem_cache_nodes(s);
+	slab_profile_free(s);
 	return 0;
 }
 
@@ -3292,6 +3503,14 @@ static int __init setup_slub_nomerge(char *str)
 
 __setup("slub_nomerge", setup_slub_nomerge);
 
+static int __init setup_slub_compact(char *str)
+{
+	slub_compact = 1;
+	return 1;
+}
+
+__setup("slub_compact", setup_slub_compact);
+
 void *__kmalloc(size_t size, gfp_t flags)
 {
 	struct kmem_cache *s;
@@ -3729,7 +3948,8 @@ static struct kmem_cache *find_mergeable(struct mem_cgroup *memcg, size_t size,
 		if ((s->size & ~(align - 1)) != s->size)
 			continue;
 
-		if (s->size - size >= sizeof(void *))
+		if (s->size - size >= max_t(size_t, sizeof(void *),
+					    slub_compact ? size / 8 : 0))
 			continue;
 
 		if (!cache_match_memcg(s, memcg))
@@ -4799,6 +5019,124 @@ static ssize_t shrink_store(struct kmem_cache *s,
 }
 SLAB_ATTR(shrink);
 
+static ssize_t profile_rate_show(struct kmem_cache *s, char *buf)
+{
+	return sprintf(buf, "%u\n", s->profile_rate);
+}
+
+static ssize_t profile_rate_store(struct kmem_cache *s,
+				const char *buf, size_t length)
+{
+	struct slab_profile *p;
+	unsigned int rate;
+	int err;
+
+	err = kstrtouint(buf, 10, &rate);
+	if (err)
+		return err;
+
+	mutex_lock(&slab_profile_mutex);
+	if (rate && !s->profile) {
+		p = kzalloc(sizeof(*p), GFP_KERNEL);
+		if (p)
+			p->tick = alloc_percpu(unsigned int);
+		if (!p || !p->tick) {
+			kfree(p);
+			mutex_unlock(&slab_profile_mutex);
+			return -ENOMEM;
+		}
+		spin_lock_init(&p->lock);
+		s->profile = p;
+		/* Publish the table before the rate enables it */
+		smp_wmb();
+	}
+	s->profile_rate = rate;
+	mutex_unlock(&slab_profile_mutex);
+
+	return length;
+}
+SLAB_ATTR(profile_rate);
+
+static int cmp_profile_entry(const void *a, const void *b)
+{
+	const struct slab_profile_entry *ea = a, *eb = b;
+	unsigned long ha = ea->hits[PROFILE_ALLOC] + ea->hits[PROFILE_FREE];
+	unsigned long hb = eb->hits[PROFILE_ALLOC] + eb->hits[PROFILE_FREE];
+
+	if (ha == hb)
+		return 0;
+	return ha < hb ? 1 : -1;
+}
+
+/*
+ * One line per sampled caller, busiest first: the slowpath allocations
+ * and frees sampled, and the caller.
+ */
+static ssize_t profile_show(struct kmem_cache *s, char *buf)
+{
+	struct slab_profile_entry *entry;
+	unsigned long dropped[NR_PROFILE_ITEMS];
+	struct slab_profile *p;
+	int i, len = 0;
+
+	mutex_lock(&slab_profile_mutex);
+	p = s->profile;
+	if (!p) {
+		mutex_unlock(&slab_profile_mutex);
+		return 0;
+	}
+
+	entry = kmalloc(sizeof(p->entry), GFP_KERNEL);
+	if (!entry) {
+		mutex_unlock(&slab_profile_mutex);
+		return -ENOMEM;
+	}
+
+	spin_lock_irq(&p->lock);
+	memcpy(entry, p->entry, sizeof(p->entry));
+	memcpy(dropped, p->dropped, sizeof(dropped));
+	spin_unlock_irq(&p->lock);
+	mutex_unlock(&slab_profile_mutex);
+
+	sort(entry, SLAB_PROFILE_SLOTS, sizeof(*entry), cmp_profile_entry,
+	     NULL);
+
+	for (i = 0; i < SLAB_PROFILE_SLOTS && entry[i].addr; i++) {
+		if (len > PAGE_SIZE - KSYM_SYMBOL_LEN - 100)
+			break;
+		len += sprintf(buf + len, "%7lu %7lu %pS\n",
+			       entry[i].hits[PROFILE_ALLOC],
+			       entry[i].hits[PROFILE_FREE],
+			       (void *)entry[i].addr);
+	}
+	if (dropped[PROFILE_ALLOC] || dropped[PROFILE_FREE])
+		len += sprintf(buf + len, "%7lu %7lu <table-full>\n",
+			       dropped[PROFILE_ALLOC], dropped[PROFILE_FREE]);
+
+	kfree(entry);
+	return len;
+}
+
+/* Writing anything clears the samples */
+static ssize_t profile_store(struct kmem_cache *s,
+			const char *buf, size_t length)
+{
+	struct slab_profile *p;
+
+	mutex_lock(&slab_profile_mutex);
+	p = s->profile;
+	if (p) {
+		spin_lock_irq(&p->lock);
+		memset(p->entry, 0, sizeof(p->entry));
+		memset(p->dropped, 0, sizeof(p->dropped));
+		spin_unlock_irq(&p->lock);
+	}
+	mutex_unlock(&slab_profile_mutex);
+
+	return length;
+}
+SLAB_ATTR(profile);
+
 #ifdef CONFIG_NUMA
 static ssize_t remote_node_defrag_ratio_show(struct kmem_cache *s, char *buf)
 {
@@ -4922,6 +5260,8 @@ static struct attribute *slab_attrs[] = {
 	&reclaim_account_attr.attr,
 	&destroy_by_rcu_attr.attr,
 	&shrink_attr.attr,
+	&profile_rate_attr.attr,
+	&profile_attr.attr,
 	&reserved_attr.attr,
 	&slabs_cpu_partial_attr.attr,
 #ifdef CONFIG_SLUB_DEBUG
@@ -5346,3 +5686,73 @@ ssize_t slabinfo_write(struct file *file, const char __user *buffer,
 	return -EIO;
 }
 #endif /* CONFIG_SLABINFO */
+
+#if defined(CONFIG_SLUB_DEBUG) && defined(CONFIG_PROC_FS)
+/*
+ * /proc/slab_waste: where the memory of each cache goes that does not
+ * hold objects, in kB. "pad" is the slot space beyond the object size,
+ * "tail" the end of the slabs too short for another object, and "free"
+ * the free objects on the node partial lists. As in /proc/slabinfo, free
+ * objects in cpu slabs are not walked and count as active. The slabs are
+ * assumed to be of the preferred order.
+ */
+static int slab_waste_show(struct seq_file *m, void *v)
+{
+	struct kmem_cache *s;
+
+	seq_puts(m, "# name            <objsize> <size> <order> <objperslab>"
+		 " <slabs> <objs> <active> : <mem> <pad> <tail> <free>\n");
+
+	mutex_lock(&slab_mutex);
+	list_for_each_entry(s, &slab_caches, list) {
+		unsigned long nr_slabs = 0, nr_objs = 0, nr_free = 0;
+		unsigned long slab_bytes = PAGE_SIZE << oo_order(s->oo);
+		unsigned long tail;
+		int node;
+
+		for_each_online_node(node) {
+			struct kmem_cache_node *n = get_node(s, node);
+
+			if (!n)
+				continue;
+
+			nr_slabs += node_nr_slabs(n);
+			nr_objs += node_nr_objs(n);
+			nr_free += count_partial(n, count_free);
+		}
+
+		tail = slab_bytes - oo_objects(s->oo) * s->size;
+		seq_printf(m, "%-17s %9d %6d %7d %12d %7lu %6lu %8lu : "
+			   "%5lu %5lu %6lu %6lu\n",
+			   s->name, s->object_size, s->size, oo_order(s->oo),
+			   oo_objects(s->oo), nr_slabs, nr_objs,
+			   nr_objs - nr_free,
+			   nr_slabs * slab_bytes >> 10,
+			   nr_objs * (s->size - s->object_size) >> 10,
+			   nr_slabs * tail >> 10,
+			   nr_free * s->size >> 10);
+	}
+	mutex_unlock(&slab_mutex);
+
+	return 0;
+}
+
+static int slab_waste_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, slab_waste_show, NULL);
+}
+
+static const struct file_operations proc_slab_waste_operations = {
+	.open		= slab_waste_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init slab_waste_init(void)
+{
+	proc_create("slab_waste", S_IRUSR, NULL, &proc_slab_waste_operations);
+	return 0;
+}
+module_init(slab_waste_init);
+#endif
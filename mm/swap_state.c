@@ -11,6 +11,7 @@
 #include <linux/kernel_stat.h>
 #include <linux/swap.h>
 #include <linux/swapops.h>
+#include <linux/swapfile.h>
 #include <linux/init.h>
 #include <linux/pagemap.h>
 #include <linux/backing-dev.h>
@@ -63,8 +64,6 @@ unsigned long total_swapcache_pages(void)
 	return ret;
 }
 
-static atomic_t swapin_readahead_hits = ATOMIC_INIT(4);
-
 void show_swap_cache_info(void)
 {
 	printk("%lu pages in swap cache\n", total_swapcache_pages());
@@ -291,7 +290,7 @@ struct page * lookup_swap_cache(swp_entry_t entry)
 	if (page) {
 		INC_CACHE_INFO(find_success);
 		if (TestClearPageReadahead(page))
-			atomic_inc(&swapin_readahead_hits);
+			atomic_inc(&swap_info[swp_type(entry)]->ra_hits);
 	}
 
 	INC_CACHE_INFO(find_total);
@@ -394,13 +393,37 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 	return found_page;
 }
 
-static unsigned long swapin_nr_pages(unsigned long offset)
+/*
+ * page_cluster is the upper limit for all swap areas. Each one can be
+ * limited further through the readahead setting of the backing device,
+ * /sys/block/<dev>/queue/read_ahead_kb as of swapon, so that swap on zram
+ * does not waste time decompressing pages nobody asked for while swap on
+ * flash still gets large windows from a raised page_cluster.
+ */
+static unsigned int swapin_max_pages(struct swap_info_struct *si)
 {
-	static unsigned long prev_offset;
-	unsigned int pages, max_pages, last_ra;
-	static atomic_t last_readahead_pages;
+	unsigned int max_pages, ra_pages = si->ra_max_pages;
 
 	max_pages = 1 << ACCESS_ONCE(page_cluster);
+
+	if (ra_pages < max_pages)
+		max_pages = ra_pages ? rounddown_pow_of_two(ra_pages) : 1;
+
+	return max_pages;
+}
+
+/*
+ * The window is sized by how many pages of the previous windows were
+ * actually used, which is tracked per swap area since a compressed RAM
+ * device and a disk behave very differently.
+ */
+static unsigned long swapin_nr_pages(struct swap_info_struct *si,
+				     unsigned long offset)
+{
+	unsigned long prev_offset;
+	unsigned int pages, max_pages, last_ra;
+
+	max_pages = swapin_max_pages(si);
 	if (max_pages <= 1)
 		return 1;
 
@@ -409,16 +432,16 @@ static unsigned long swapin_nr_pages(unsigned long offset)
 	 * random loads, swapping to hard disk or to SSD: please don't ask
 	 * what the "+ 2" means, it just happens to work well, that's all.
 	 */
-	pages = atomic_xchg(&swapin_readahead_hits, 0) + 2;
+	pages = atomic_xchg(&si->ra_hits, 0) + 2;
 	if (pages == 2) {
 		/*
 		 * We can have no readahead hits to judge by: but must not get
-		 * stuck here forever, so check for an adjacent offset instead
-		 * (and don't even bother to check whether swap type is same).
+		 * stuck here forever, so check for an adjacent offset instead.
 		 */
+		prev_offset = ACCESS_ONCE(si->ra_prev_offset);
 		if (offset != prev_offset + 1 && offset != prev_offset - 1)
 			pages = 1;
-		prev_offset = offset;
+		si->ra_prev_offset = offset;
 	} else {
 		unsigned int roundup = 4;
 		while (roundup < pages)
@@ -430,10 +453,10 @@ static unsigned long swapin_nr_pages(unsigned long offset)
 		pages = max_pages;
 
 	/* Don't shrink readahead too fast */
-	last_ra = atomic_read(&last_readahead_pages) / 2;
+	last_ra = atomic_read(&si->ra_pages) / 2;
 	if (pages < last_ra)
 		pages = last_ra;
-	atomic_set(&last_readahead_pages, pages);
+	atomic_set(&si->ra_pages, pages);
 
 	return pages;
 }
@@ -448,7 +471,8 @@ static unsigned long swapin_nr_pages(unsigned long offset)
  * Returns the struct page for entry and addr, after queueing swapin.
  *
  * Primitive swap readahead code. We simply read an aligned block of
- * (1 << page_cluster) entries in the swap area. This method is chosen
+ * up to (1 << page_cluster) entries in the swap area, see swapin_nr_pages()
+ * for how many are actually read. This method is chosen
  * because it doesn't cost us any seek time.  We also make sure to queue
  * the 'original' request together with the readahead ones...
  *
@@ -467,11 +491,11 @@ struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 	unsigned long mask;
 	struct blk_plug plug;
 
-	mask = swapin_nr_pages(offset) - 1;
+	mask = swapin_nr_pages(swap_info[swp_type(entry)], offset) - 1;
 	if (!mask)
 		goto skip;
 
-	/* Read a page_cluster sized and aligned cluster around offset. */
+	/* Read a window sized and aligned cluster around offset. */
 	start_offset = offset & ~mask;
 	end_offset = offset | mask;
 	if (!start_offset)	/* First page is swap header. */
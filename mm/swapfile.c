@@ -2156,6 +2156,9 @@ static struct swap_info_struct *alloc_swap_info(void)
 	p->flags = SWP_USED;
 	spin_unlock(&swap_lock);
 	spin_lock_init(&p->lock);
+	atomic_set(&p->ra_hits, 4);
+	atomic_set(&p->ra_pages, 0);
+	p->ra_prev_offset = 0;
 
 	return p;
 }
@@ -2430,6 +2433,9 @@ SYSCALL_DEFINE2(swapon, const char __user *, specialfile, int, swap_flags)
 	if (unlikely(error))
 		goto bad_swap;
 
+	/* swap_file goes away under swapin at swapoff, so keep a copy */
+	p->ra_max_pages = mapping->backing_dev_info->ra_pages;
+
 	/*
 	 * Read the swap header.
 	 */
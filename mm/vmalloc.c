@@ -569,6 +569,52 @@ static unsigned long lazy_max_pages(void)
 
 static atomic_t vmap_lazy_nr = ATOMIC_INIT(0);
 
+/*
+ * Architectures where flush_tlb_kernel_range() falls back to flushing the
+ * whole TLB past some range size can tell us that size (in pages). Lazily
+ * freed areas are usually small but scattered over the vmalloc space, so a
+ * single flush of their union easily crosses that limit and throws away
+ * every user mapping as well. If the areas themselves cover few enough
+ * pages, flush them one run at a time instead.
+ */
+#ifndef tlb_kernel_range_max_pages
+static inline unsigned long tlb_kernel_range_max_pages(void)
+{
+	return 0;
+}
+#endif
+
+static bool vmap_purge_flush_ranged(unsigned long start, unsigned long end,
+				    int nr)
+{
+	unsigned long max_pages = tlb_kernel_range_max_pages();
+
+	if (!max_pages || nr > max_pages)
+		return false;
+
+	return (end - start) >> PAGE_SHIFT > max_pages;
+}
+
+static void vmap_purge_flush_areas(struct list_head *valist)
+{
+	unsigned long run_start = 0, run_end = 0;
+	struct vmap_area *va;
+
+	/* vmap_area_list is sorted, so adjacent areas merge into one run */
+	list_for_each_entry(va, valist, purge_list) {
+		if (run_end && va->va_start <= run_end) {
+			run_end = max(run_end, va->va_end);
+			continue;
+		}
+		if (run_end)
+			flush_tlb_kernel_range(run_start, run_end);
+		run_start = va->va_start;
+		run_end = va->va_end;
+	}
+	if (run_end)
+		flush_tlb_kernel_range(run_start, run_end);
+}
+
 /* for per-CPU blocks */
 static void purge_fragmented_blocks_allcpus(void);
 
@@ -598,6 +644,7 @@ static void __purge_vmap_area_lazy(unsigned long *start, unsigned long *end,
 	LIST_HEAD(valist);
 	struct vmap_area *va;
 	struct vmap_area *n_va;
+	bool caller_range = *start < *end;
 	int nr = 0;
 
 	/*
@@ -632,7 +679,13 @@ static void __purge_vmap_area_lazy(unsigned long *start, unsigned long *end,
 	if (nr)
 		atomic_sub(nr, &vmap_lazy_nr);
 
-	if (nr || force_flush)
+	/*
+	 * A range handed in by the caller (dirty vmap blocks) is not on
+	 * valist, so only split the flush when there is none.
+	 */
+	if (nr && !caller_range && vmap_purge_flush_ranged(*start, *end, nr))
+		vmap_purge_flush_areas(&valist);
+	else if (nr || force_flush)
 		flush_tlb_kernel_range(*start, *end);
 
 	if (nr) {
@@ -19,7 +19,10 @@
 #include <linux/mm.h>
 #include <linux/vmstat.h>
 #include <linux/eventfd.h>
+#include <linux/poll.h>
+#include <linux/proc_fs.h>
 #include <linux/slab.h>
+#include <linux/uaccess.h>
 #include <linux/swap.h>
 #include <linux/printk.h>
 #include <linux/vmpressure.h>
@@ -46,8 +49,23 @@ static const unsigned long vmpressure_win = SWAP_CLUSTER_MAX * 16;
  * essence, they are percents: the higher the value, the more number
  * unsuccessful reclaims there were.
  */
-static const unsigned int vmpressure_level_med = 60;
-static const unsigned int vmpressure_level_critical = 95;
+int vmpressure_level_med = 60;
+int vmpressure_level_critical = 95;
+
+/*
+ * Reclaim storms make the level flap from one window to the next, and
+ * every window used to reach the listeners. A level is therefore held
+ * for vmpressure_hysteresis_ms after the last window that reached it,
+ * and medium pressure that lasts longer than vmpressure_sustained_ms is
+ * reported as the "sustained" level.
+ *
+ * On top of that, a listener is not signalled twice for the same or a
+ * lower level within vmpressure_ratelimit_ms[level]. Rising pressure is
+ * never held back. The defaults keep the old one event per window.
+ */
+int vmpressure_hysteresis_ms;
+int vmpressure_sustained_ms = 5000;
+int vmpressure_ratelimit_ms[VMPRESSURE_NUM_LEVELS];
 
 /*
  * When there are too little pages left to scan, vmpressure() may miss the
@@ -70,35 +88,67 @@ static const unsigned int vmpressure_level_critical = 95;
  */
 static const unsigned int vmpressure_level_critical_prio = ilog2(100 / 10);
 
+static void vmpressure_work_fn(struct work_struct *work);
+
+/*
+ * System-wide pressure, accounted for global reclaim whether or not the
+ * memory controller is in use, and reported through /proc/vmpressure.
+ */
+static struct vmpressure vmpressure_global = {
+	.sr_lock = __SPIN_LOCK_UNLOCKED(vmpressure_global.sr_lock),
+	.events = LIST_HEAD_INIT(vmpressure_global.events),
+	.events_lock = __MUTEX_INITIALIZER(vmpressure_global.events_lock),
+	.work = __WORK_INITIALIZER(vmpressure_global.work, vmpressure_work_fn),
+};
+
+static DECLARE_WAIT_QUEUE_HEAD(vmpressure_wait);
+
 static struct vmpressure *work_to_vmpressure(struct work_struct *work)
 {
 	return container_of(work, struct vmpressure, work);
 }
 
+#ifdef CONFIG_MEMCG
 static struct vmpressure *vmpressure_parent(struct vmpressure *vmpr)
 {
-	struct cgroup_subsys_state *css = vmpressure_to_css(vmpr);
-	struct mem_cgroup *memcg = mem_cgroup_from_css(css);
+	struct cgroup_subsys_state *css;
+	struct mem_cgroup *memcg;
+
+	if (vmpr == &vmpressure_global)
+		return NULL;
 
+	css = vmpressure_to_css(vmpr);
+	memcg = mem_cgroup_from_css(css);
 	memcg = parent_mem_cgroup(memcg);
 	if (!memcg)
 		return NULL;
 	return memcg_to_vmpressure(memcg);
 }
-
-enum vmpressure_levels {
-	VMPRESSURE_LOW = 0,
-	VMPRESSURE_MEDIUM,
-	VMPRESSURE_CRITICAL,
-	VMPRESSURE_NUM_LEVELS,
-};
+#else
+static struct vmpressure *vmpressure_parent(struct vmpressure *vmpr)
+{
+	return NULL;
+}
+#endif
 
 static const char * const vmpressure_str_levels[] = {
 	[VMPRESSURE_LOW] = "low",
 	[VMPRESSURE_MEDIUM] = "medium",
+	[VMPRESSURE_SUSTAINED] = "sustained",
 	[VMPRESSURE_CRITICAL] = "critical",
 };
 
+static int vmpressure_parse_level(const char *str)
+{
+	int level;
+
+	for (level = 0; level < VMPRESSURE_NUM_LEVELS; level++) {
+		if (sysfs_streq(vmpressure_str_levels[level], str))
+			return level;
+	}
+	return -EINVAL;
+}
+
 static enum vmpressure_levels vmpressure_level(unsigned long pressure)
 {
 	if (pressure >= vmpressure_level_critical)
@@ -130,27 +180,100 @@ static enum vmpressure_levels vmpressure_calc_level(unsigned long scanned,
 	return vmpressure_level(pressure);
 }
 
+/*
+ * Fold the level of the last window into the level reported for @vmpr,
+ * applying the hysteresis and the sustained pressure promotion.
+ */
+static enum vmpressure_levels vmpressure_update_level(struct vmpressure *vmpr,
+						      enum vmpressure_levels level)
+{
+	unsigned long now = jiffies;
+
+	/* The level held from earlier windows has run out */
+	if (time_after_eq(now, vmpr->level_stamp +
+			  msecs_to_jiffies(vmpressure_hysteresis_ms)))
+		vmpr->level = VMPRESSURE_LOW;
+
+	if (level >= vmpr->level) {
+		vmpr->level = level;
+		vmpr->level_stamp = now;
+	}
+
+	/* Only a window below medium ends sustained pressure, not the hold */
+	if (level < VMPRESSURE_MEDIUM) {
+		vmpr->medium = false;
+	} else if (!vmpr->medium) {
+		vmpr->medium = true;
+		vmpr->medium_since = now;
+	}
+
+	if (vmpr->level == VMPRESSURE_MEDIUM && vmpr->medium &&
+	    time_after_eq(now, vmpr->medium_since +
+			  msecs_to_jiffies(vmpressure_sustained_ms)))
+		return VMPRESSURE_SUSTAINED;
+
+	return vmpr->level;
+}
+
+/*
+ * A listener is either an eventfd bound through the memory controller,
+ * or an open /proc/vmpressure when @efd is NULL. The latter counts its
+ * events and is woken through vmpressure_wait.
+ */
 struct vmpressure_event {
 	struct eventfd_ctx *efd;
 	enum vmpressure_levels level;
 	struct list_head node;
+
+	/* Last notification, for the rate limit */
+	bool signalled;
+	enum vmpressure_levels last_level;
+	unsigned long last;
+
+	unsigned long count;
+	unsigned long seen;
 };
 
+static bool vmpressure_ratelimited(struct vmpressure_event *ev,
+				   enum vmpressure_levels level,
+				   unsigned long now)
+{
+	if (!ev->signalled || level > ev->last_level)
+		return false;
+	return time_before(now, ev->last +
+			   msecs_to_jiffies(vmpressure_ratelimit_ms[level]));
+}
+
 static bool vmpressure_event(struct vmpressure *vmpr,
-			     unsigned long scanned, unsigned long reclaimed)
+			     enum vmpressure_levels level)
 {
 	struct vmpressure_event *ev;
-	enum vmpressure_levels level;
+	unsigned long now = jiffies;
 	bool signalled = false;
 
-	level = vmpressure_calc_level(scanned, reclaimed);
-
 	mutex_lock(&vmpr->events_lock);
 
 	list_for_each_entry(ev, &vmpr->events, node) {
-		if (level >= ev->level) {
+		if (level < ev->level)
+			continue;
+
+		/*
+		 * A rate limited listener still counts as handling the
+		 * event, or the parents would get the storm instead.
+		 */
+		signalled = true;
+		if (vmpressure_ratelimited(ev, level, now))
+			continue;
+
+		ev->signalled = true;
+		ev->last_level = level;
+		ev->last = now;
+
+		if (ev->efd) {
 			eventfd_signal(ev->efd, 1);
-			signalled = true;
+		} else {
+			ev->count++;
+			wake_up_interruptible(&vmpressure_wait);
 		}
 	}
 
@@ -162,6 +285,7 @@ static bool vmpressure_event(struct vmpressure *vmpr,
 static void vmpressure_work_fn(struct work_struct *work)
 {
 	struct vmpressure *vmpr = work_to_vmpressure(work);
+	enum vmpressure_levels level;
 	unsigned long scanned;
 	unsigned long reclaimed;
 
@@ -185,8 +309,11 @@ static void vmpressure_work_fn(struct work_struct *work)
 	vmpr->reclaimed = 0;
 	spin_unlock(&vmpr->sr_lock);
 
+	level = vmpressure_calc_level(scanned, reclaimed);
+	level = vmpressure_update_level(vmpr, level);
+
 	do {
-		if (vmpressure_event(vmpr, scanned, reclaimed))
+		if (vmpressure_event(vmpr, level))
 			break;
 		/*
 		 * If not handled, propagate the event upward into the
@@ -195,10 +322,24 @@ static void vmpressure_work_fn(struct work_struct *work)
 	} while ((vmpr = vmpressure_parent(vmpr)));
 }
 
+static void vmpressure_account(struct vmpressure *vmpr,
+			       unsigned long scanned, unsigned long reclaimed)
+{
+	spin_lock(&vmpr->sr_lock);
+	vmpr->scanned += scanned;
+	vmpr->reclaimed += reclaimed;
+	scanned = vmpr->scanned;
+	spin_unlock(&vmpr->sr_lock);
+
+	if (scanned < vmpressure_win)
+		return;
+	schedule_work(&vmpr->work);
+}
+
 /**
  * vmpressure() - Account memory pressure through scanned/reclaimed ratio
  * @gfp:	reclaimer's gfp mask
- * @memcg:	cgroup memory controller handle
+ * @memcg:	cgroup memory controller handle, NULL for global reclaim
  * @scanned:	number of pages scanned
  * @reclaimed:	number of pages reclaimed
  *
@@ -211,8 +352,6 @@ static void vmpressure_work_fn(struct work_struct *work)
 void vmpressure(gfp_t gfp, struct mem_cgroup *memcg,
 		unsigned long scanned, unsigned long reclaimed)
 {
-	struct vmpressure *vmpr = memcg_to_vmpressure(memcg);
-
 	/*
 	 * Here we only want to account pressure that userland is able to
 	 * help us with. For example, suppose that DMA zone is under
@@ -238,15 +377,11 @@ void vmpressure(gfp_t gfp, struct mem_cgroup *memcg,
 	if (!scanned)
 		return;
 
-	spin_lock(&vmpr->sr_lock);
-	vmpr->scanned += scanned;
-	vmpr->reclaimed += reclaimed;
-	scanned = vmpr->scanned;
-	spin_unlock(&vmpr->sr_lock);
-
-	if (scanned < vmpressure_win)
-		return;
-	schedule_work(&vmpr->work);
+	if (!memcg)
+		vmpressure_account(&vmpressure_global, scanned, reclaimed);
+#ifdef CONFIG_MEMCG
+	vmpressure_account(memcg_to_vmpressure(memcg), scanned, reclaimed);
+#endif
 }
 
 /**
@@ -279,6 +414,7 @@ void vmpressure_prio(gfp_t gfp, struct mem_cgroup *memcg, int prio)
 	vmpressure(gfp, memcg, vmpressure_win, 0);
 }
 
+#ifdef CONFIG_MEMCG
 /**
  * vmpressure_register_event() - Bind vmpressure notifications to an eventfd
  * @memcg:	memcg that is interested in vmpressure notifications
@@ -288,8 +424,8 @@ void vmpressure_prio(gfp_t gfp, struct mem_cgroup *memcg, int prio)
  * This function associates eventfd context with the vmpressure
  * infrastructure, so that the notifications will be delivered to the
  * @eventfd. The @args parameter is a string that denotes pressure level
- * threshold (one of vmpressure_str_levels, i.e. "low", "medium", or
- * "critical").
+ * threshold (one of vmpressure_str_levels, i.e. "low", "medium",
+ * "sustained" or "critical").
  *
  * To be used as memcg event method.
  */
@@ -300,13 +436,9 @@ int vmpressure_register_event(struct mem_cgroup *memcg,
 	struct vmpressure_event *ev;
 	int level;
 
-	for (level = 0; level < VMPRESSURE_NUM_LEVELS; level++) {
-		if (!strcmp(vmpressure_str_levels[level], args))
-			break;
-	}
-
-	if (level >= VMPRESSURE_NUM_LEVELS)
-		return -EINVAL;
+	level = vmpressure_parse_level(args);
+	if (level < 0)
+		return level;
 
 	ev = kzalloc(sizeof(*ev), GFP_KERNEL);
 	if (!ev)
@@ -349,6 +481,7 @@ void vmpressure_unregister_event(struct mem_cgroup *memcg,
 	}
 	mutex_unlock(&vmpr->events_lock);
 }
+#endif /* CONFIG_MEMCG */
 
 /**
  * vmpressure_init() - Initialize vmpressure control structure
@@ -380,3 +513,112 @@ void vmpressure_cleanup(struct vmpressure *vmpr)
 	 */
 	flush_work(&vmpr->work);
 }
+
+#ifdef CONFIG_PROC_FS
+/*
+ * /proc/vmpressure reports global pressure without the memory controller.
+ * Each open file is a listener for "low" pressure and up; writing a level
+ * name raises its threshold. poll() flags POLLPRI on a new notification,
+ * and read() returns the level of the last one.
+ */
+static int vmpressure_proc_open(struct inode *inode, struct file *file)
+{
+	struct vmpressure_event *ev;
+
+	ev = kzalloc(sizeof(*ev), GFP_KERNEL);
+	if (!ev)
+		return -ENOMEM;
+
+	ev->level = VMPRESSURE_LOW;
+	file->private_data = ev;
+
+	mutex_lock(&vmpressure_global.events_lock);
+	list_add(&ev->node, &vmpressure_global.events);
+	mutex_unlock(&vmpressure_global.events_lock);
+
+	return 0;
+}
+
+static int vmpressure_proc_release(struct inode *inode, struct file *file)
+{
+	struct vmpressure_event *ev = file->private_data;
+
+	mutex_lock(&vmpressure_global.events_lock);
+	list_del(&ev->node);
+	mutex_unlock(&vmpressure_global.events_lock);
+
+	kfree(ev);
+	return 0;
+}
+
+static ssize_t vmpressure_proc_read(struct file *file, char __user *buf,
+				    size_t count, loff_t *ppos)
+{
+	struct vmpressure_event *ev = file->private_data;
+	enum vmpressure_levels level;
+	char tmp[16];
+	int len;
+
+	mutex_lock(&vmpressure_global.events_lock);
+	level = ev->signalled ? ev->last_level : VMPRESSURE_LOW;
+	ev->seen = ev->count;
+	mutex_unlock(&vmpressure_global.events_lock);
+
+	len = scnprintf(tmp, sizeof(tmp), "%s\n", vmpressure_str_levels[level]);
+	return simple_read_from_buffer(buf, count, ppos, tmp, len);
+}
+
+static ssize_t vmpressure_proc_write(struct file *file,
+				     const char __user *buf,
+				     size_t count, loff_t *ppos)
+{
+	struct vmpressure_event *ev = file->private_data;
+	char tmp[16];
+	int level;
+
+	if (count >= sizeof(tmp))
+		return -EINVAL;
+	if (copy_from_user(tmp, buf, count))
+		return -EFAULT;
+	tmp[count] = '\0';
+
+	level = vmpressure_parse_level(tmp);
+	if (level < 0)
+		return level;
+
+	mutex_lock(&vmpressure_global.events_lock);
+	ev->level = level;
+	mutex_unlock(&vmpressure_global.events_lock);
+
+	return count;
+}
+
+static unsigned int vmpressure_proc_poll(struct file *file, poll_table *wait)
+{
+	struct vmpressure_event *ev = file->private_data;
+
+	poll_wait(file, &vmpressure_wait, wait);
+
+	if (ACCESS_ONCE(ev->count) != ev->seen)
+		return POLLIN | POLLRDNORM | POLLPRI;
+
+	return POLLIN | POLLRDNORM;
+}
+
+static const struct file_operations proc_vmpressure_operations = {
+	.open		= vmpressure_proc_open,
+	.read		= vmpressure_proc_read,
+	.write		= vmpressure_proc_write,
+	.poll		= vmpressure_proc_poll,
+	.llseek		= default_llseek,
+	.release	= vmpressure_proc_release,
+};
+
+static int __init proc_vmpressure_init(void)
+{
+	proc_create("vmpressure", S_IRUGO | S_IWUSR, NULL,
+		    &proc_vmpressure_operations);
+	return 0;
+}
+__initcall(proc_vmpressure_init);
+#endif /* CONFIG_PROC_FS */
@@ -35,6 +35,7 @@
 #include <linux/crypto.h>
 #include <linux/mempool.h>
 #include <linux/zbud.h>
+#include <linux/zsmalloc.h>
 
 #include <linux/mm_types.h>
 #include <linux/page-flags.h>
@@ -89,6 +90,18 @@ static unsigned int zswap_max_pool_percent = 20;
 module_param_named(max_pool_percent,
 			zswap_max_pool_percent, uint, 0644);
 
+/*
+ * Allocator for the compressed pages (fixed at boot). zbud stores at most
+ * two pages per page frame but can evict on its own, zsmalloc packs much
+ * denser and relies on the zswap LRU for writeback. zsmalloc can only be
+ * used if it is built in.
+ */
+#define ZSWAP_ZPOOL_DEFAULT "zbud"
+static char *zswap_zpool_type = ZSWAP_ZPOOL_DEFAULT;
+module_param_named(zpool, zswap_zpool_type, charp, 0444);
+
+static bool zswap_use_zsmalloc __read_mostly;
+
 /*********************************
 * compression functions
 **********************************/
@@ -165,12 +178,15 @@ static void zswap_comp_exit(void)
  *            be held while changing the refcount.  Since the lock must
  *            be held, there is no reason to also make refcount atomic.
  * offset - the swap offset for the entry.  Index into the red-black tree.
- * handle - zsmalloc allocation handle that stores the compressed page data
+ * handle - zbud or zsmalloc allocation handle that stores the compressed
+ *          page data
  * length - the length in bytes of the compressed page data.  Needed during
  *           decompression
+ * lru - links the entry into the LRU list of its tree, oldest first
  */
 struct zswap_entry {
 	struct rb_node rbnode;
+	struct list_head lru;
 	pgoff_t offset;
 	int refcount;
 	unsigned int length;
@@ -184,16 +200,71 @@ struct zswap_header {
 /*
  * The tree lock in the zswap_tree struct protects a few things:
  * - the rbtree
+ * - the LRU list
  * - the refcount field of each entry in the tree
  */
 struct zswap_tree {
 	struct rb_root rbroot;
+	struct list_head lru;
 	spinlock_t lock;
+	unsigned type;
 	struct zbud_pool *pool;
+	struct zs_pool *zs_pool;
 };
 
 static struct zswap_tree *zswap_trees[MAX_SWAPFILES];
 
+/*********************************
+* compressed pool functions
+**********************************/
+/* the zsmalloc calls are compiled out unless it is built in */
+#define zswap_tree_zsmalloc(tree) \
+	(IS_BUILTIN(CONFIG_ZSMALLOC) && (tree)->zs_pool)
+
+static int zswap_pool_alloc(struct zswap_tree *tree, size_t size,
+			unsigned long *handle)
+{
+	if (!zswap_tree_zsmalloc(tree))
+		return zbud_alloc(tree->pool, size,
+				__GFP_NORETRY | __GFP_NOWARN, handle);
+
+	/* zsmalloc can't store objects larger than a page */
+	if (size > PAGE_SIZE)
+		return -ENOSPC;
+	*handle = zs_malloc(tree->zs_pool, size);
+	return *handle ? 0 : -ENOMEM;
+}
+
+static void zswap_pool_free(struct zswap_tree *tree, unsigned long handle)
+{
+	if (zswap_tree_zsmalloc(tree))
+		zs_free(tree->zs_pool, handle);
+	else
+		zbud_free(tree->pool, handle);
+}
+
+static void *zswap_pool_map(struct zswap_tree *tree, unsigned long handle)
+{
+	if (zswap_tree_zsmalloc(tree))
+		return zs_map_object(tree->zs_pool, handle, ZS_MM_RW);
+	return zbud_map(tree->pool, handle);
+}
+
+static void zswap_pool_unmap(struct zswap_tree *tree, unsigned long handle)
+{
+	if (zswap_tree_zsmalloc(tree))
+		zs_unmap_object(tree->zs_pool, handle);
+	else
+		zbud_unmap(tree->pool, handle);
+}
+
+static u64 zswap_pool_size(struct zswap_tree *tree)
+{
+	if (zswap_tree_zsmalloc(tree))
+		return zs_get_total_size_bytes(tree->zs_pool) >> PAGE_SHIFT;
+	return zbud_get_pool_size(tree->pool);
+}
+
 /*********************************
 * zswap entry functions
 **********************************/
@@ -282,16 +353,17 @@ static void zswap_rb_erase(struct rb_root *root, struct zswap_entry *entry)
 }
 
 /*
- * Carries out the common pattern of freeing and entry's zsmalloc allocation,
+ * Carries out the common pattern of freeing and entry's pool allocation,
  * freeing the entry itself, and decrementing the number of stored pages.
  */
 static void zswap_free_entry(struct zswap_tree *tree,
 			struct zswap_entry *entry)
 {
-	zbud_free(tree->pool, entry->handle);
+	list_del(&entry->lru);
+	zswap_pool_free(tree, entry->handle);
 	zswap_entry_cache_free(entry);
 	atomic_dec(&zswap_stored_pages);
-	zswap_pool_pages = zbud_get_pool_size(tree->pool);
+	zswap_pool_pages = zswap_pool_size(tree);
 }
 
 /* caller must hold the tree lock */
@@ -524,10 +596,8 @@ static int zswap_get_swap_cache_page(swp_entry_t entry,
  * the swap cache, the compressed version stored by zswap can be
  * freed.
  */
-static int zswap_writeback_entry(struct zbud_pool *pool, unsigned long handle)
+static int zswap_writeback_swpentry(swp_entry_t swpentry)
 {
-	struct zswap_header *zhdr;
-	swp_entry_t swpentry;
 	struct zswap_tree *tree;
 	pgoff_t offset;
 	struct zswap_entry *entry;
@@ -539,13 +609,8 @@ static int zswap_writeback_entry(struct zbud_pool *pool, unsigned long handle)
 		.sync_mode = WB_SYNC_NONE,
 	};
 
-	/* extract swpentry from data */
-	zhdr = zbud_map(pool, handle);
-	swpentry = zhdr->swpentry; /* here */
-	zbud_unmap(pool, handle);
 	tree = zswap_trees[swp_type(swpentry)];
 	offset = swp_offset(swpentry);
-	BUG_ON(pool != tree->pool);
 
 	/* find and ref zswap entry */
 	spin_lock(&tree->lock);
@@ -573,13 +638,13 @@ static int zswap_writeback_entry(struct zbud_pool *pool, unsigned long handle)
 	case ZSWAP_SWAPCACHE_NEW: /* page is locked */
 		/* decompress */
 		dlen = PAGE_SIZE;
-		src = (u8 *)zbud_map(tree->pool, entry->handle) +
+		src = (u8 *)zswap_pool_map(tree, entry->handle) +
 			sizeof(struct zswap_header);
 		dst = kmap_atomic(page);
 		ret = zswap_comp_op(ZSWAP_COMPOP_DECOMPRESS, src,
 				entry->length, dst, &dlen);
 		kunmap_atomic(dst);
-		zbud_unmap(tree->pool, entry->handle);
+		zswap_pool_unmap(tree, entry->handle);
 		BUG_ON(ret);
 		BUG_ON(dlen != PAGE_SIZE);
 
@@ -628,6 +693,59 @@ end:
 	return ret;
 }
 
+/* zbud eviction callback, the swap entry is found in the zswap header */
+static int zswap_writeback_entry(struct zbud_pool *pool, unsigned long handle)
+{
+	struct zswap_header *zhdr;
+	swp_entry_t swpentry;
+
+	/* extract swpentry from data */
+	zhdr = zbud_map(pool, handle);
+	swpentry = zhdr->swpentry; /* here */
+	zbud_unmap(pool, handle);
+	BUG_ON(pool != zswap_trees[swp_type(swpentry)]->pool);
+
+	return zswap_writeback_swpentry(swpentry);
+}
+
+/*
+ * Write back the oldest entries of @tree until one of them is gone. This is
+ * how space is made in zsmalloc pools, which can't evict by themselves.
+ * Entries are rotated to the LRU tail before trying, so a busy one isn't
+ * retried right away.
+ */
+static int zswap_lru_reclaim(struct zswap_tree *tree, int retries)
+{
+	struct zswap_entry *entry;
+	swp_entry_t swpentry;
+	int ret = -EINVAL;
+
+	while (retries--) {
+		spin_lock(&tree->lock);
+		if (list_empty(&tree->lru)) {
+			spin_unlock(&tree->lock);
+			return -EINVAL;
+		}
+		entry = list_first_entry(&tree->lru, struct zswap_entry, lru);
+		list_move_tail(&entry->lru, &tree->lru);
+		swpentry = swp_entry(tree->type, entry->offset);
+		spin_unlock(&tree->lock);
+
+		ret = zswap_writeback_swpentry(swpentry);
+		if (!ret)
+			return 0;
+	}
+
+	return ret;
+}
+
+static int zswap_reclaim(struct zswap_tree *tree)
+{
+	if (zswap_tree_zsmalloc(tree))
+		return zswap_lru_reclaim(tree, 8);
+	return zbud_reclaim_page(tree->pool, 8);
+}
+
 /*********************************
 * frontswap hooks
 **********************************/
@@ -652,7 +770,7 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 	/* reclaim space if needed */
 	if (zswap_is_full()) {
 		zswap_pool_limit_hit++;
-		if (zbud_reclaim_page(tree->pool, 8)) {
+		if (zswap_reclaim(tree)) {
 			zswap_reject_reclaim_fail++;
 			ret = -ENOMEM;
 			goto reject;
@@ -679,8 +797,7 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 
 	/* store */
 	len = dlen + sizeof(struct zswap_header);
-	ret = zbud_alloc(tree->pool, len, __GFP_NORETRY | __GFP_NOWARN,
-		&handle);
+	ret = zswap_pool_alloc(tree, len, &handle);
 	if (ret == -ENOSPC) {
 		zswap_reject_compress_poor++;
 		goto freepage;
@@ -689,11 +806,11 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 		zswap_reject_alloc_fail++;
 		goto freepage;
 	}
-	zhdr = zbud_map(tree->pool, handle);
+	zhdr = zswap_pool_map(tree, handle);
 	zhdr->swpentry = swp_entry(type, offset);
 	buf = (u8 *)(zhdr + 1);
 	memcpy(buf, dst, dlen);
-	zbud_unmap(tree->pool, handle);
+	zswap_pool_unmap(tree, handle);
 	put_cpu_var(zswap_dstmem);
 
 	/* populate entry */
@@ -712,11 +829,12 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 			zswap_entry_put(tree, dupentry);
 		}
 	} while (ret == -EEXIST);
+	list_add_tail(&entry->lru, &tree->lru);
 	spin_unlock(&tree->lock);
 
 	/* update stats */
 	atomic_inc(&zswap_stored_pages);
-	zswap_pool_pages = zbud_get_pool_size(tree->pool);
+	zswap_pool_pages = zswap_pool_size(tree);
 
 	return 0;
 
@@ -752,13 +870,13 @@ static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 
 	/* decompress */
 	dlen = PAGE_SIZE;
-	src = (u8 *)zbud_map(tree->pool, entry->handle) +
+	src = (u8 *)zswap_pool_map(tree, entry->handle) +
 			sizeof(struct zswap_header);
 	dst = kmap_atomic(page);
 	ret = zswap_comp_op(ZSWAP_COMPOP_DECOMPRESS, src, entry->length,
 		dst, &dlen);
 	kunmap_atomic(dst);
-	zbud_unmap(tree->pool, entry->handle);
+	zswap_pool_unmap(tree, entry->handle);
 	BUG_ON(ret);
 
 	spin_lock(&tree->lock);
@@ -808,7 +926,10 @@ static void zswap_frontswap_invalidate_area(unsigned type)
 	tree->rbroot = RB_ROOT;
 	spin_unlock(&tree->lock);
 
-	zbud_destroy_pool(tree->pool);
+	if (zswap_tree_zsmalloc(tree))
+		zs_destroy_pool(tree->zs_pool);
+	else
+		zbud_destroy_pool(tree->pool);
 	kfree(tree);
 	zswap_trees[type] = NULL;
 }
@@ -824,10 +945,22 @@ static void zswap_frontswap_init(unsigned type)
 	tree = kzalloc(sizeof(struct zswap_tree), GFP_KERNEL);
 	if (!tree)
 		goto err;
-	tree->pool = zbud_create_pool(GFP_KERNEL, &zswap_zbud_ops);
-	if (!tree->pool)
-		goto freetree;
+	if (IS_BUILTIN(CONFIG_ZSMALLOC) && zswap_use_zsmalloc) {
+		char name[16];
+
+		snprintf(name, sizeof(name), "zswap%u", type);
+		tree->zs_pool = zs_create_pool(name, __GFP_NORETRY |
+				__GFP_NOWARN | __GFP_HIGHMEM);
+		if (!tree->zs_pool)
+			goto freetree;
+	} else {
+		tree->pool = zbud_create_pool(GFP_KERNEL, &zswap_zbud_ops);
+		if (!tree->pool)
+			goto freetree;
+	}
 	tree->rbroot = RB_ROOT;
+	INIT_LIST_HEAD(&tree->lru);
+	tree->type = type;
 	spin_lock_init(&tree->lock);
 	zswap_trees[type] = tree;
 	return;
@@ -907,6 +1040,12 @@ static int __init init_zswap(void)
 		return 0;
 
 	pr_info("loading zswap\n");
+	if (IS_BUILTIN(CONFIG_ZSMALLOC) &&
+	    !strcmp(zswap_zpool_type, "zsmalloc"))
+		zswap_use_zsmalloc = true;
+	else if (strcmp(zswap_zpool_type, ZSWAP_ZPOOL_DEFAULT))
+		pr_warn("%s pool not available, using %s\n",
+			zswap_zpool_type, ZSWAP_ZPOOL_DEFAULT);
 	if (zswap_entry_cache_create()) {
 		pr_err("entry cache creation failed\n");
 		goto error;
@@ -95,6 +95,7 @@ static void queue_process(struct work_struct *work)
 
 		local_irq_save(flags);
 		__netif_tx_lock(txq, smp_processor_id());
+		skb->xmit_more = 0;
 		if (netif_xmit_frozen_or_stopped(txq) ||
 		    ops->ndo_start_xmit(skb, dev) != NETDEV_TX_OK) {
 			skb_queue_head(&npinfo->txq, skb);
@@ -397,6 +398,7 @@ void netpoll_send_skb_on_dev(struct netpoll *np, struct sk_buff *skb,
 						skb->vlan_tci = 0;
 					}
 
+					skb->xmit_more = 0;
 					status = ops->ndo_start_xmit(skb, dev);
 					if (status == NETDEV_TX_OK)
 						txq_trans_update(txq);
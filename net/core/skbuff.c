@@ -440,6 +440,136 @@ struct sk_buff *__netdev_alloc_skb(struct net_device *dev,
 }
 EXPORT_SYMBOL(__netdev_alloc_skb);
 
+/*
+ * A netdev_frag_pool is a ring of pages that a driver carves its receive
+ * buffers from.  Pages are handed out in turn, and when the ring comes back
+ * to a page that the stack has released all buffers of, it is reused as is
+ * instead of being freed to and allocated from the page allocator again.
+ * A page that is still in use when its turn comes is left to the stack and
+ * replaced, so the ring never waits for slow consumers.
+ *
+ * A pool is not locked, the driver must serialize its allocations, e.g. by
+ * only allocating from its NAPI poll routine.
+ */
+struct netdev_frag_pool {
+	unsigned int	nr_pages;
+	unsigned int	cur;
+	unsigned int	offset;
+	struct page	*pages[0];
+};
+
+/**
+ *	netdev_frag_pool_create - create a recycling receive buffer pool
+ *	@nr_pages: number of pages in the ring
+ *
+ *	No pages are allocated until buffers are needed. Returns %NULL if
+ *	there is no memory for the pool itself.
+ */
+struct netdev_frag_pool *netdev_frag_pool_create(unsigned int nr_pages)
+{
+	struct netdev_frag_pool *pool;
+
+	if (!nr_pages)
+		return NULL;
+
+	pool = kzalloc(sizeof(*pool) + nr_pages * sizeof(struct page *),
+		       GFP_KERNEL);
+	if (pool)
+		pool->nr_pages = nr_pages;
+	return pool;
+}
+EXPORT_SYMBOL(netdev_frag_pool_create);
+
+/**
+ *	netdev_frag_pool_destroy - release a receive buffer pool
+ *	@pool: pool to release, may be %NULL
+ *
+ *	Buffers still held by the stack stay valid, their pages are freed
+ *	once the last of them is.
+ */
+void netdev_frag_pool_destroy(struct netdev_frag_pool *pool)
+{
+	unsigned int i;
+
+	if (!pool)
+		return;
+
+	for (i = 0; i < pool->nr_pages; i++)
+		if (pool->pages[i])
+			put_page(pool->pages[i]);
+	kfree(pool);
+}
+EXPORT_SYMBOL(netdev_frag_pool_destroy);
+
+static void *netdev_frag_pool_alloc(struct netdev_frag_pool *pool,
+				    unsigned int fragsz, gfp_t gfp_mask)
+{
+	struct page *page = pool->pages[pool->cur];
+
+	if (unlikely(!page || pool->offset < fragsz)) {
+		if (page)
+			pool->cur = (pool->cur + 1) % pool->nr_pages;
+		page = pool->pages[pool->cur];
+
+		/* Reuse the page unless the stack still holds buffers of it */
+		if (page && page_count(page) != 1) {
+			put_page(page);
+			page = NULL;
+		}
+		if (!page) {
+			page = alloc_page(gfp_mask | __GFP_COLD |
+					  __GFP_NOMEMALLOC | __GFP_NOWARN);
+			pool->pages[pool->cur] = page;
+			if (!page)
+				return NULL;
+		}
+		pool->offset = PAGE_SIZE;
+	}
+
+	pool->offset -= fragsz;
+	get_page(page);
+	return page_address(page) + pool->offset;
+}
+
+/**
+ *	netdev_frag_pool_alloc_skb - allocate an rx skbuff from a buffer pool
+ *	@dev: network device to receive on
+ *	@pool: pool to take the buffer from
+ *	@length: length to allocate
+ *	@gfp_mask: get_free_pages mask, passed to alloc_page
+ *
+ *	Like __netdev_alloc_skb(), but the data area comes from @pool.
+ *	Requests that don't fit into a page, or that the pool cannot
+ *	satisfy, fall back to __netdev_alloc_skb().
+ */
+struct sk_buff *netdev_frag_pool_alloc_skb(struct net_device *dev,
+					   struct netdev_frag_pool *pool,
+					   unsigned int length, gfp_t gfp_mask)
+{
+	unsigned int fragsz = SKB_DATA_ALIGN(length + NET_SKB_PAD) +
+			      SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+	struct sk_buff *skb;
+	void *data;
+
+	if (!pool || fragsz > PAGE_SIZE || (gfp_mask & (__GFP_WAIT | GFP_DMA)))
+		return __netdev_alloc_skb(dev, length, gfp_mask);
+
+	data = netdev_frag_pool_alloc(pool, fragsz, gfp_mask);
+	if (unlikely(!data))
+		return __netdev_alloc_skb(dev, length, gfp_mask);
+
+	skb = build_skb(data, fragsz);
+	if (unlikely(!skb)) {
+		put_page(virt_to_head_page(data));
+		return NULL;
+	}
+
+	skb_reserve(skb, NET_SKB_PAD);
+	skb->dev = dev;
+	return skb;
+}
+EXPORT_SYMBOL(netdev_frag_pool_alloc_skb);
+
 void skb_add_rx_frag(struct sk_buff *skb, int i, struct page *page, int off,
 		     int size, unsigned int truesize)
 {
@@ -36,7 +36,7 @@ static void *ah_alloc_tmp(struct crypto_ahash *ahash, int nfrags,
 
 	len += sizeof(struct scatterlist) * nfrags;
 
-	return kmalloc(len, GFP_ATOMIC);
+	return crypto_scratch_alloc(crypto_ahash_tfm(ahash), len, GFP_ATOMIC);
 }
 
 static inline u8 *ah_tmp_auth(void *tmp, unsigned int offset)
@@ -138,7 +138,7 @@ static void ah_output_done(struct crypto_async_request *base, int err)
 		memcpy(top_iph+1, iph+1, top_iph->ihl*4 - sizeof(struct iphdr));
 	}
 
-	kfree(AH_SKB_CB(skb)->tmp);
+	crypto_scratch_free(AH_SKB_CB(skb)->tmp);
 	xfrm_output_resume(skb, err);
 }
 
@@ -239,7 +239,7 @@ static int ah_output(struct xfrm_state *x, struct sk_buff *skb)
 	}
 
 out_free:
-	kfree(iph);
+	crypto_scratch_free(iph);
 out:
 	return err;
 }
@@ -275,7 +275,7 @@ static void ah_input_done(struct crypto_async_request *base, int err)
 	else
 		skb_set_transport_header(skb, -ihl);
 out:
-	kfree(AH_SKB_CB(skb)->tmp);
+	crypto_scratch_free(AH_SKB_CB(skb)->tmp);
 	xfrm_input_resume(skb, err);
 }
 
@@ -392,7 +392,7 @@ static int ah_input(struct xfrm_state *x, struct sk_buff *skb)
 	err = nexthdr;
 
 out_free:
-	kfree (work_iph);
+	crypto_scratch_free(work_iph);
 out:
 	return err;
 }
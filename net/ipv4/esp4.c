@@ -33,7 +33,8 @@ static u32 esp4_get_mtu(struct xfrm_state *x, int mtu);
  * For alignment considerations the IV is placed at the front, followed
  * by the request and finally the SG list.
  *
- * TODO: Use spare space in skb for this where possible.
+ * Synchronous algorithms get per-cpu scratch space rather than a
+ * per-packet allocation; release it with crypto_scratch_free().
  */
 static void *esp_alloc_tmp(struct crypto_aead *aead, int nfrags, int seqhilen)
 {
@@ -54,7 +55,7 @@ static void *esp_alloc_tmp(struct crypto_aead *aead, int nfrags, int seqhilen)
 
 	len += sizeof(struct scatterlist) * nfrags;
 
-	return kmalloc(len, GFP_ATOMIC);
+	return crypto_scratch_alloc(crypto_aead_tfm(aead), len, GFP_ATOMIC);
 }
 
 static inline __be32 *esp_tmp_seqhi(void *tmp)
@@ -109,7 +110,7 @@ static void esp_output_done(struct crypto_async_request *base, int err)
 {
 	struct sk_buff *skb = base->data;
 
-	kfree(ESP_SKB_CB(skb)->tmp);
+	crypto_scratch_free(ESP_SKB_CB(skb)->tmp);
 	xfrm_output_resume(skb, err);
 }
 
@@ -266,7 +267,7 @@ static int esp_output(struct xfrm_state *x, struct sk_buff *skb)
 	if (err == -EBUSY)
 		err = NET_XMIT_DROP;
 
-	kfree(tmp);
+	crypto_scratch_free(tmp);
 
 error:
 	return err;
@@ -284,7 +285,7 @@ static int esp_input_done2(struct sk_buff *skb, int err)
 	u8 nexthdr[2];
 	int padlen;
 
-	kfree(ESP_SKB_CB(skb)->tmp);
+	crypto_scratch_free(ESP_SKB_CB(skb)->tmp);
 
 	if (unlikely(err))
 		goto out;
@@ -0,0 +1,510 @@
+/*
+ * Software flow offload for forwarded IPv4 connections
+ *
+ * Once a forwarded TCP or UDP connection is established, each direction is
+ * entered into a small flow table keyed by the 5-tuple and the input device.
+ * Packets of such flows are picked up before defragmentation and connection
+ * tracking in PRE_ROUTING, get the cached NAT rewrite applied, and are handed
+ * to the neighbour of the cached route directly, skipping conntrack, the NAT
+ * hooks, routing and the FORWARD/POST_ROUTING chains.
+ *
+ * Anything unusual (IP options, fragments, expiring TTL, packets too large
+ * for the route, TCP FIN/RST) takes the normal path again.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/types.h>
+#include <linux/ip.h>
+#include <linux/tcp.h>
+#include <linux/udp.h>
+#include <linux/jhash.h>
+#include <linux/module.h>
+#include <linux/netdevice.h>
+#include <linux/netfilter.h>
+#include <linux/netfilter_ipv4.h>
+#include <linux/skbuff.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
+#include <net/arp.h>
+#include <net/dst.h>
+#include <net/ip.h>
+#include <net/neighbour.h>
+#include <net/route.h>
+#include <net/netfilter/nf_conntrack.h>
+#include <net/netfilter/nf_conntrack_helper.h>
+#include <net/netfilter/nf_conntrack_zones.h>
+#include <net/netfilter/nf_nat.h>
+#include <net/netfilter/nf_nat_l3proto.h>
+#include <net/netfilter/nf_nat_l4proto.h>
+
+static unsigned int max_flows __read_mostly = 512;
+module_param(max_flows, uint, 0644);
+MODULE_PARM_DESC(max_flows, "maximum number of offloaded flow directions");
+
+#define NF_FLOW_HTABLE_BITS	8
+#define NF_FLOW_HTABLE_SIZE	(1 << NF_FLOW_HTABLE_BITS)
+#define NF_FLOW_GC_INTERVAL	HZ
+
+struct nf_flow_key {
+	__be32			saddr;
+	__be32			daddr;
+	__be16			sport;
+	__be16			dport;
+	u8			protonum;
+};
+
+struct nf_flow {
+	struct hlist_node	hnode;
+	struct nf_flow_key	key;
+	const struct net_device	*indev;
+
+	/* what the packet has to look like on the way out */
+	struct nf_conntrack_tuple target;
+	u8			manips;
+
+	struct nf_conn		*ct;
+	enum ip_conntrack_info	ctinfo;
+	unsigned long		timeout;
+
+	struct dst_entry	*dst;
+	unsigned int		mtu;
+
+	bool			dead;
+	struct rcu_head		rcu;
+};
+
+static struct hlist_head nf_flow_htable[NF_FLOW_HTABLE_SIZE];
+static DEFINE_SPINLOCK(nf_flow_lock);
+static unsigned int nf_flow_count;
+static u32 nf_flow_hash_rnd __read_mostly;
+
+static void nf_flow_gc(struct work_struct *work);
+static DECLARE_DELAYED_WORK(nf_flow_gc_work, nf_flow_gc);
+
+static u32 nf_flow_hash(const struct nf_flow_key *key,
+			const struct net_device *indev)
+{
+	return jhash_3words((__force u32)key->saddr,
+			    (__force u32)key->daddr,
+			    ((__force u32)key->sport << 16 |
+			     (__force u32)key->dport) ^
+			    (key->protonum << 8 | indev->ifindex),
+			    nf_flow_hash_rnd) & (NF_FLOW_HTABLE_SIZE - 1);
+}
+
+static struct nf_flow *nf_flow_lookup(const struct nf_flow_key *key,
+				      const struct net_device *indev)
+{
+	struct nf_flow *flow;
+
+	hlist_for_each_entry_rcu(flow, &nf_flow_htable[nf_flow_hash(key, indev)],
+				 hnode) {
+		if (flow->indev == indev &&
+		    !memcmp(&flow->key, key, sizeof(*key)))
+			return flow;
+	}
+	return NULL;
+}
+
+static void nf_flow_free_rcu(struct rcu_head *head)
+{
+	struct nf_flow *flow = container_of(head, struct nf_flow, rcu);
+
+	dst_release(flow->dst);
+	nf_ct_put(flow->ct);
+	kfree(flow);
+}
+
+/* Called with nf_flow_lock held */
+static void __nf_flow_remove(struct nf_flow *flow)
+{
+	hlist_del_rcu(&flow->hnode);
+	flow->dead = true;
+	nf_flow_count--;
+	call_rcu(&flow->rcu, nf_flow_free_rcu);
+}
+
+static void nf_flow_key_from_tuple(struct nf_flow_key *key,
+				   const struct nf_conntrack_tuple *t)
+{
+	memset(key, 0, sizeof(*key));
+	key->saddr = t->src.u3.ip;
+	key->daddr = t->dst.u3.ip;
+	key->sport = t->src.u.all;
+	key->dport = t->dst.u.all;
+	key->protonum = t->dst.protonum;
+}
+
+/*
+ * Stop offloading both directions of the connection of @flow, so that
+ * conntrack sees its teardown.  The reply direction arrives on the device
+ * this direction leaves through.
+ */
+static void nf_flow_teardown(struct nf_flow *flow)
+{
+	struct nf_conn *ct = flow->ct;
+	enum ip_conntrack_dir dir = CTINFO2DIR(flow->ctinfo);
+	struct nf_flow_key key;
+	struct nf_flow *peer;
+
+	nf_flow_key_from_tuple(&key, &ct->tuplehash[!dir].tuple);
+
+	spin_lock_bh(&nf_flow_lock);
+	peer = nf_flow_lookup(&key, flow->dst->dev);
+	if (peer && peer->ct == ct)
+		__nf_flow_remove(peer);
+	if (!flow->dead)
+		__nf_flow_remove(flow);
+	spin_unlock_bh(&nf_flow_lock);
+}
+
+static int nf_flow_xmit(struct sk_buff *skb, struct dst_entry *dst)
+{
+	struct rtable *rt = (struct rtable *)dst;
+	struct net_device *dev = dst->dev;
+	unsigned int hh_len = LL_RESERVED_SPACE(dev);
+	struct neighbour *neigh;
+	u32 nexthop;
+	int res;
+
+	if (unlikely(skb_headroom(skb) < hh_len && dev->header_ops)) {
+		struct sk_buff *skb2;
+
+		skb2 = skb_realloc_headroom(skb, hh_len);
+		consume_skb(skb);
+		if (skb2 == NULL)
+			return -ENOMEM;
+		skb = skb2;
+	}
+
+	rcu_read_lock_bh();
+	nexthop = (__force u32)rt_nexthop(rt, ip_hdr(skb)->daddr);
+	neigh = __ipv4_neigh_lookup_noref(dev, nexthop);
+	if (unlikely(!neigh))
+		neigh = __neigh_create(&arp_tbl, &nexthop, dev, false);
+	if (IS_ERR(neigh)) {
+		rcu_read_unlock_bh();
+		kfree_skb(skb);
+		return PTR_ERR(neigh);
+	}
+	res = dst_neigh_output(dst, neigh, skb);
+	rcu_read_unlock_bh();
+
+	return res;
+}
+
+static unsigned int nf_flow_offload_in(const struct nf_hook_ops *ops,
+				       struct sk_buff *skb,
+				       const struct net_device *in,
+				       const struct net_device *out,
+				       int (*okfn)(struct sk_buff *))
+{
+	const struct nf_nat_l3proto *l3proto;
+	const struct nf_nat_l4proto *l4proto;
+	unsigned int thoff, hdrsize, len;
+	struct nf_flow_key key;
+	struct nf_flow *flow;
+	struct dst_entry *dst;
+	const struct iphdr *iph;
+	__be16 *ports;
+	int mtype;
+
+	if (skb->pkt_type != PACKET_HOST || skb->nfct)
+		return NF_ACCEPT;
+
+	iph = ip_hdr(skb);
+	if (iph->ihl != 5 || ip_is_fragment(iph) || iph->ttl <= 1)
+		return NF_ACCEPT;
+
+	switch (iph->protocol) {
+	case IPPROTO_TCP:
+		hdrsize = sizeof(struct tcphdr);
+		break;
+	case IPPROTO_UDP:
+		hdrsize = sizeof(struct udphdr);
+		break;
+	default:
+		return NF_ACCEPT;
+	}
+
+	thoff = sizeof(*iph);
+	if (!pskb_may_pull(skb, thoff + hdrsize))
+		return NF_ACCEPT;
+
+	iph = ip_hdr(skb);
+	ports = (__be16 *)(skb_network_header(skb) + thoff);
+
+	memset(&key, 0, sizeof(key));
+	key.saddr = iph->saddr;
+	key.daddr = iph->daddr;
+	key.sport = ports[0];
+	key.dport = ports[1];
+	key.protonum = iph->protocol;
+
+	flow = nf_flow_lookup(&key, in);
+	if (!flow)
+		return NF_ACCEPT;
+
+	if (iph->protocol == IPPROTO_TCP) {
+		const struct tcphdr *th = (const struct tcphdr *)ports;
+
+		if (unlikely(th->fin || th->rst)) {
+			nf_flow_teardown(flow);
+			return NF_ACCEPT;
+		}
+	}
+
+	dst = dst_check(flow->dst, 0);
+	if (unlikely(!dst || nf_ct_is_dying(flow->ct))) {
+		nf_flow_teardown(flow);
+		return NF_ACCEPT;
+	}
+
+	len = skb_is_gso(skb) ? skb_gso_network_seglen(skb) : skb->len;
+	if (len > flow->mtu)
+		return NF_ACCEPT;
+
+	if (!skb_make_writable(skb, thoff + hdrsize))
+		return NF_ACCEPT;
+
+	if (flow->manips) {
+		l3proto = __nf_nat_l3proto_find(NFPROTO_IPV4);
+		if (unlikely(!l3proto))
+			return NF_ACCEPT;
+		l4proto = __nf_nat_l4proto_find(NFPROTO_IPV4, key.protonum);
+
+		for (mtype = NF_NAT_MANIP_SRC; mtype <= NF_NAT_MANIP_DST;
+		     mtype++) {
+			if (!(flow->manips & (1 << mtype)))
+				continue;
+			if (!l3proto->manip_pkt(skb, 0, l4proto, &flow->target,
+						mtype))
+				return NF_DROP;
+		}
+	}
+
+	ip_decrease_ttl(ip_hdr(skb));
+	skb->priority = rt_tos2priority(ip_hdr(skb)->tos);
+
+	nf_ct_refresh_acct(flow->ct, flow->ctinfo, skb, flow->timeout);
+
+	IP_INC_STATS_BH(dev_net(dst->dev), IPSTATS_MIB_OUTFORWDATAGRAMS);
+
+	skb_dst_set_noref(skb, dst);
+	skb->dev = dst->dev;
+	nf_flow_xmit(skb, dst);
+
+	return NF_STOLEN;
+}
+
+static unsigned int nf_flow_offload_fwd(const struct nf_hook_ops *ops,
+					struct sk_buff *skb,
+					const struct net_device *in,
+					const struct net_device *out,
+					int (*okfn)(struct sk_buff *))
+{
+	struct dst_entry *dst = skb_dst(skb);
+	enum ip_conntrack_info ctinfo;
+	enum ip_conntrack_dir dir;
+	struct nf_conn_help *help;
+	struct nf_flow *flow;
+	struct nf_conn *ct;
+	long timeout;
+	u32 hash;
+
+	ct = nf_ct_get(skb, &ctinfo);
+	if (!ct || nf_ct_is_untracked(ct))
+		return NF_ACCEPT;
+	if (ctinfo != IP_CT_ESTABLISHED && ctinfo != IP_CT_ESTABLISHED_REPLY)
+		return NF_ACCEPT;
+
+	switch (nf_ct_protonum(ct)) {
+	case IPPROTO_TCP:
+		if (ct->proto.tcp.state != TCP_CONNTRACK_ESTABLISHED)
+			return NF_ACCEPT;
+		break;
+	case IPPROTO_UDP:
+		break;
+	default:
+		return NF_ACCEPT;
+	}
+
+	/* Helpers and sequence adjustment need to see every packet */
+	help = nfct_help(ct);
+	if (help && rcu_access_pointer(help->helper))
+		return NF_ACCEPT;
+	if (test_bit(IPS_SEQ_ADJUST_BIT, &ct->status) ||
+	    !nf_ct_is_confirmed(ct) || nf_ct_is_dying(ct) ||
+	    nf_ct_zone(ct) != NF_CT_DEFAULT_ZONE)
+		return NF_ACCEPT;
+
+	if (ip_hdr(skb)->ihl != 5 || !dst || dst->xfrm ||
+	    ((struct rtable *)dst)->rt_type != RTN_UNICAST)
+		return NF_ACCEPT;
+
+	if (ACCESS_ONCE(nf_flow_count) >= max_flows)
+		return NF_ACCEPT;
+
+	flow = kzalloc(sizeof(*flow), GFP_ATOMIC);
+	if (!flow)
+		return NF_ACCEPT;
+
+	dir = CTINFO2DIR(ctinfo);
+	nf_flow_key_from_tuple(&flow->key, &ct->tuplehash[dir].tuple);
+	flow->indev = in;
+
+	/* We are aiming to look like inverse of other direction. */
+	nf_ct_invert_tuplepr(&flow->target, &ct->tuplehash[!dir].tuple);
+	if (flow->key.saddr != flow->target.src.u3.ip ||
+	    flow->key.sport != flow->target.src.u.all)
+		flow->manips |= 1 << NF_NAT_MANIP_SRC;
+	if (flow->key.daddr != flow->target.dst.u3.ip ||
+	    flow->key.dport != flow->target.dst.u.all)
+		flow->manips |= 1 << NF_NAT_MANIP_DST;
+
+	/* conntrack has just refreshed the timeout for this state */
+	timeout = (long)(ct->timeout.expires - jiffies);
+	flow->timeout = max_t(long, timeout, HZ);
+	flow->ctinfo = ctinfo;
+
+	dst_hold(dst);
+	flow->dst = dst;
+	flow->mtu = dst_mtu(dst);
+
+	/*
+	 * conntrack no longer sees the segments, so it must not judge
+	 * the ones that come after the flow left the fast path against
+	 * stale windows.
+	 */
+	if (nf_ct_protonum(ct) == IPPROTO_TCP) {
+		spin_lock_bh(&ct->lock);
+		ct->proto.tcp.seen[0].flags |= IP_CT_TCP_FLAG_BE_LIBERAL;
+		ct->proto.tcp.seen[1].flags |= IP_CT_TCP_FLAG_BE_LIBERAL;
+		spin_unlock_bh(&ct->lock);
+	}
+
+	nf_conntrack_get(&ct->ct_general);
+	flow->ct = ct;
+
+	hash = nf_flow_hash(&flow->key, in);
+	spin_lock_bh(&nf_flow_lock);
+	if (nf_flow_count >= max_flows || nf_flow_lookup(&flow->key, in)) {
+		spin_unlock_bh(&nf_flow_lock);
+		dst_release(dst);
+		nf_ct_put(ct);
+		kfree(flow);
+		return NF_ACCEPT;
+	}
+	hlist_add_head_rcu(&flow->hnode, &nf_flow_htable[hash]);
+	nf_flow_count++;
+	spin_unlock_bh(&nf_flow_lock);
+
+	return NF_ACCEPT;
+}
+
+static struct nf_hook_ops nf_flow_offload_ops[] __read_mostly = {
+	{
+		.hook		= nf_flow_offload_in,
+		.owner		= THIS_MODULE,
+		.pf		= NFPROTO_IPV4,
+		.hooknum	= NF_INET_PRE_ROUTING,
+		.priority	= NF_IP_PRI_CONNTRACK_DEFRAG - 1,
+	},
+	{
+		.hook		= nf_flow_offload_fwd,
+		.owner		= THIS_MODULE,
+		.pf		= NFPROTO_IPV4,
+		.hooknum	= NF_INET_FORWARD,
+		.priority	= NF_IP_PRI_LAST,
+	},
+};
+
+/* Drop the flows matched by @match, or all of them if it is NULL */
+static void nf_flow_flush(bool (*match)(struct nf_flow *flow, void *data),
+			  void *data)
+{
+	struct hlist_node *n;
+	struct nf_flow *flow;
+	int i;
+
+	spin_lock_bh(&nf_flow_lock);
+	for (i = 0; i < NF_FLOW_HTABLE_SIZE; i++) {
+		hlist_for_each_entry_safe(flow, n, &nf_flow_htable[i], hnode) {
+			if (!match || match(flow, data))
+				__nf_flow_remove(flow);
+		}
+	}
+	spin_unlock_bh(&nf_flow_lock);
+}
+
+static bool nf_flow_stale(struct nf_flow *flow, void *data)
+{
+	return nf_ct_is_dying(flow->ct) || !dst_check(flow->dst, 0);
+}
+
+static void nf_flow_gc(struct work_struct *work)
+{
+	nf_flow_flush(nf_flow_stale, NULL);
+	schedule_delayed_work(&nf_flow_gc_work, NF_FLOW_GC_INTERVAL);
+}
+
+static bool nf_flow_uses_dev(struct nf_flow *flow, void *data)
+{
+	return flow->indev == data || flow->dst->dev == data;
+}
+
+static int nf_flow_netdev_event(struct notifier_block *this,
+				unsigned long event, void *ptr)
+{
+	struct net_device *dev = netdev_notifier_info_to_dev(ptr);
+
+	if (event == NETDEV_DOWN || event == NETDEV_UNREGISTER ||
+	    event == NETDEV_CHANGEMTU)
+		nf_flow_flush(nf_flow_uses_dev, dev);
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block nf_flow_netdev_notifier = {
+	.notifier_call	= nf_flow_netdev_event,
+};
+
+static int __init nf_flow_offload_init(void)
+{
+	int ret;
+
+	get_random_bytes(&nf_flow_hash_rnd, sizeof(nf_flow_hash_rnd));
+
+	ret = register_netdevice_notifier(&nf_flow_netdev_notifier);
+	if (ret < 0)
+		return ret;
+
+	ret = nf_register_hooks(nf_flow_offload_ops,
+				ARRAY_SIZE(nf_flow_offload_ops));
+	if (ret < 0) {
+		unregister_netdevice_notifier(&nf_flow_netdev_notifier);
+		return ret;
+	}
+
+	schedule_delayed_work(&nf_flow_gc_work, NF_FLOW_GC_INTERVAL);
+	return 0;
+}
+
+static void __exit nf_flow_offload_fini(void)
+{
+	nf_unregister_hooks(nf_flow_offload_ops,
+			    ARRAY_SIZE(nf_flow_offload_ops));
+	unregister_netdevice_notifier(&nf_flow_netdev_notifier);
+	cancel_delayed_work_sync(&nf_flow_gc_work);
+	nf_flow_flush(NULL, NULL);
+	rcu_barrier();
+}
+
+module_init(nf_flow_offload_init);
+module_exit(nf_flow_offload_fini);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("IPv4 software flow offload fast path");
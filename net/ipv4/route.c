@@ -90,6 +90,7 @@
 #include <linux/times.h>
 #include <linux/slab.h>
 #include <linux/jhash.h>
+#include <linux/hash.h>
 #include <net/dst.h>
 #include <net/net_namespace.h>
 #include <net/protocol.h>
@@ -1346,8 +1347,167 @@ static void ipv4_dst_destroy(struct dst_entry *dst)
 	}
 }
 
+static bool rt_cache_valid(const struct rtable *rt)
+{
+	return	rt &&
+		rt->dst.obsolete == DST_OBSOLETE_FORCE_CHK &&
+		!rt_is_expired(rt);
+}
+
+#ifdef CONFIG_IP_ROUTE_INPUT_CACHE
+/*
+ * Small per-CPU cache of input routes in front of ip_route_input_slow(),
+ * so a router forwarding a handful of flows skips the FIB lookup and the
+ * source validation for most packets.  Only routes that are cached in a
+ * FIB nexthop or exception are kept here, so an entry stays valid exactly
+ * as long as rt_cache_valid() says that copy is: any FIB change bumps the
+ * genid, and a new nexthop exception marks the route obsolete.
+ */
+#define RT_INPUT_CACHE_BITS	4
+#define RT_INPUT_CACHE_SIZE	(1 << RT_INPUT_CACHE_BITS)
+
+struct rt_input_cache_entry {
+	__be32			daddr;
+	__be32			saddr;
+	const struct net_device	*dev;
+	u32			mark;
+	u8			tos;
+	struct rtable		*rt;
+};
+
+struct rt_input_cache {
+	spinlock_t			lock;
+	struct rt_input_cache_entry	e[RT_INPUT_CACHE_SIZE];
+};
+
+static DEFINE_PER_CPU(struct rt_input_cache, rt_input_cache);
+
+static inline struct rt_input_cache_entry *
+rt_input_cache_slot(struct rt_input_cache *c, __be32 daddr, __be32 saddr,
+		    const struct net_device *dev)
+{
+	u32 h = (__force u32)daddr ^ (__force u32)saddr ^ dev->ifindex;
+
+	return &c->e[hash_32(h, RT_INPUT_CACHE_BITS)];
+}
+
+/* called in rcu_read_lock() section */
+static bool rt_input_cache_lookup(struct sk_buff *skb, __be32 daddr,
+				  __be32 saddr, u8 tos,
+				  struct net_device *dev)
+{
+	struct rt_input_cache *c = &get_cpu_var(rt_input_cache);
+	struct rt_input_cache_entry *e;
+	struct rtable *rt = NULL, *stale = NULL;
+
+	spin_lock_bh(&c->lock);
+	e = rt_input_cache_slot(c, daddr, saddr, dev);
+	if (e->rt && e->daddr == daddr && e->saddr == saddr &&
+	    e->dev == dev && e->tos == tos && e->mark == skb->mark) {
+		if (rt_cache_valid(e->rt)) {
+			rt = e->rt;
+		} else {
+			stale = e->rt;
+			e->rt = NULL;
+		}
+	}
+	spin_unlock_bh(&c->lock);
+	put_cpu_var(rt_input_cache);
+
+	if (stale)
+		dst_release(&stale->dst);
+	if (!rt)
+		return false;
+
+	skb_dst_set_noref(skb, &rt->dst);
+	return true;
+}
+
+static void rt_input_cache_insert(struct sk_buff *skb, __be32 daddr,
+				  __be32 saddr, u8 tos,
+				  struct net_device *dev)
+{
+	struct rtable *rt = skb_rtable(skb), *old;
+	struct rt_input_cache_entry *e;
+	struct rt_input_cache *c;
+
+	if (!rt || (rt->dst.flags & DST_NOCACHE) || !rt_cache_valid(rt))
+		return;
+
+	dst_hold(&rt->dst);
+
+	c = &get_cpu_var(rt_input_cache);
+	spin_lock_bh(&c->lock);
+	e = rt_input_cache_slot(c, daddr, saddr, dev);
+	old = e->rt;
+	e->daddr = daddr;
+	e->saddr = saddr;
+	e->dev = dev;
+	e->mark = skb->mark;
+	e->tos = tos;
+	e->rt = rt;
+	spin_unlock_bh(&c->lock);
+	put_cpu_var(rt_input_cache);
+
+	if (old)
+		dst_release(&old->dst);
+}
+
+/* Drop the cached routes that arrive on or leave through @dev */
+static void rt_input_cache_flush_dev(struct net_device *dev)
+{
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		struct rt_input_cache *c = &per_cpu(rt_input_cache, cpu);
+
+		spin_lock_bh(&c->lock);
+		for (i = 0; i < RT_INPUT_CACHE_SIZE; i++) {
+			struct rt_input_cache_entry *e = &c->e[i];
+
+			if (e->rt && (e->dev == dev || e->rt->dst.dev == dev)) {
+				dst_release(&e->rt->dst);
+				e->rt = NULL;
+			}
+		}
+		spin_unlock_bh(&c->lock);
+	}
+}
+
+static void __init rt_input_cache_init(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu(rt_input_cache, cpu).lock);
+}
+#else
+static inline bool rt_input_cache_lookup(struct sk_buff *skb, __be32 daddr,
+					 __be32 saddr, u8 tos,
+					 struct net_device *dev)
+{
+	return false;
+}
+
+static inline void rt_input_cache_insert(struct sk_buff *skb, __be32 daddr,
+					 __be32 saddr, u8 tos,
+					 struct net_device *dev)
+{
+}
+
+static inline void rt_input_cache_flush_dev(struct net_device *dev)
+{
+}
+
+static inline void rt_input_cache_init(void)
+{
+}
+#endif
+
 void rt_flush_dev(struct net_device *dev)
 {
+	rt_input_cache_flush_dev(dev);
+
 	if (!list_empty(&rt_uncached_list)) {
 		struct net *net = dev_net(dev);
 		struct rtable *rt;
@@ -1364,13 +1524,6 @@ void rt_flush_dev(struct net_device *dev)
 	}
 }
 
-static bool rt_cache_valid(const struct rtable *rt)
-{
-	return	rt &&
-		rt->dst.obsolete == DST_OBSOLETE_FORCE_CHK &&
-		!rt_is_expired(rt);
-}
-
 static void rt_set_nexthop(struct rtable *rt, __be32 daddr,
 			   const struct fib_result *res,
 			   struct fib_nh_exception *fnhe,
@@ -1869,7 +2022,13 @@ int ip_route_input_noref(struct sk_buff *skb, __be32 daddr, __be32 saddr,
 		rcu_read_unlock();
 		return -EINVAL;
 	}
+	if (rt_input_cache_lookup(skb, daddr, saddr, tos, dev)) {
+		rcu_read_unlock();
+		return 0;
+	}
 	res = ip_route_input_slow(skb, daddr, saddr, tos, dev);
+	if (!res)
+		rt_input_cache_insert(skb, daddr, saddr, tos, dev);
 	rcu_read_unlock();
 	return res;
 }
@@ -2731,6 +2890,8 @@ int __init ip_rt_init(void)
 
 	prandom_bytes(ip_idents, IP_IDENTS_SZ * sizeof(*ip_idents));
 
+	rt_input_cache_init();
+
 #ifdef CONFIG_IP_ROUTE_CLASSID
 	ip_rt_acct = __alloc_percpu(256 * sizeof(struct ip_rt_acct), __alignof__(struct ip_rt_acct));
 	if (!ip_rt_acct)
@@ -876,6 +876,7 @@ int udp_sendmsg(struct kiocb *iocb, struct sock *sk, struct msghdr *msg,
 	ipc.opt = NULL;
 	ipc.tx_flags = 0;
 	ipc.ttl = 0;
+	ipc.gso_size = 0;
 	ipc.tos = -1;
 
 	getfrag = is_udplite ? udplite_getfrag : ip_generic_getfrag;
@@ -1017,6 +1018,20 @@ back_from_confirm:
 
 	/* Lockless fast path for the non-corking case. */
 	if (!corkreq) {
+		if (up->gso_size &&
+		    ulen - sizeof(struct udphdr) > up->gso_size) {
+			/* Each segment must fit the path MTU on its own and
+			 * gets its checksum filled in by GSO.
+			 */
+			err = -EINVAL;
+			if (is_udplite || sk->sk_no_check == UDP_CSUM_NOXMIT ||
+			    rt->dst.header_len ||
+			    sizeof(struct iphdr) + sizeof(struct udphdr) +
+			    (ipc.opt ? ipc.opt->opt.optlen : 0) +
+			    up->gso_size > dst_mtu(&rt->dst))
+				goto out;
+			ipc.gso_size = up->gso_size;
+		}
 		skb = ip_make_skb(sk, fl4, getfrag, msg->msg_iov, ulen,
 				  sizeof(struct udphdr), &ipc, &rt,
 				  msg->msg_flags);
@@ -2051,6 +2066,12 @@ int udp_lib_setsockopt(struct sock *sk, int level, int optname,
 		up->pcflag |= UDPLITE_RECV_CC;
 		break;
 
+	case UDP_SEGMENT:
+		if (val < 0 || val > USHRT_MAX)
+			return -EINVAL;
+		up->gso_size = val;
+		break;
+
 	default:
 		err = -ENOPROTOOPT;
 		break;
@@ -2103,6 +2124,10 @@ int udp_lib_getsockopt(struct sock *sk, int level, int optname,
 		val = up->encap_type;
 		break;
 
+	case UDP_SEGMENT:
+		val = up->gso_size;
+		break;
+
 	/* The following two cannot be changed on UDP sockets, the return is
 	 * always 0 (which corresponds to the full checksum coverage of UDP). */
 	case UDPLITE_SEND_CSCOV:
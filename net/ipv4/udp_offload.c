@@ -47,6 +47,61 @@ static int udp4_ufo_send_check(struct sk_buff *skb)
 	return 0;
 }
 
+/* Split a UDP_SEGMENT super datagram into gso_size sized datagrams.
+ * Unlike UFO every segment carries its own UDP header and checksum;
+ * the IP headers are fixed up by inet_gso_segment().
+ */
+static struct sk_buff *udp4_gso_segment(struct sk_buff *gso_skb,
+					netdev_features_t features)
+{
+	struct sk_buff *segs = ERR_PTR(-EINVAL);
+	struct sk_buff *seg;
+	struct udphdr *uh;
+	unsigned int mss;
+	unsigned int len;
+
+	mss = skb_shinfo(gso_skb)->gso_size;
+	if (unlikely(gso_skb->len <= sizeof(*uh) + mss))
+		goto out;
+
+	if (!pskb_may_pull(gso_skb, sizeof(*uh)))
+		goto out;
+
+	if (skb_gso_ok(gso_skb, features | NETIF_F_GSO_ROBUST)) {
+		/* Packet is from an untrusted source, reset gso_segs. */
+		skb_shinfo(gso_skb)->gso_segs =
+			DIV_ROUND_UP(gso_skb->len - sizeof(*uh), mss);
+
+		segs = NULL;
+		goto out;
+	}
+
+	__skb_pull(gso_skb, sizeof(*uh));
+
+	segs = skb_segment(gso_skb, features);
+	if (IS_ERR_OR_NULL(segs))
+		goto out;
+
+	for (seg = segs; seg; seg = seg->next) {
+		const struct iphdr *iph = ip_hdr(seg);
+
+		uh = udp_hdr(seg);
+		len = seg->len - skb_transport_offset(seg);
+
+		uh->len = htons(len);
+		uh->check = ~csum_tcpudp_magic(iph->saddr, iph->daddr, len,
+					       IPPROTO_UDP, 0);
+		if (seg->ip_summed != CHECKSUM_PARTIAL) {
+			uh->check = csum_fold(csum_partial(uh, sizeof(*uh),
+							   seg->csum));
+			if (uh->check == 0)
+				uh->check = CSUM_MANGLED_0;
+		}
+	}
+out:
+	return segs;
+}
+
 static struct sk_buff *udp4_ufo_fragment(struct sk_buff *skb,
 					 netdev_features_t features)
 {
@@ -61,6 +116,11 @@ static struct sk_buff *udp4_ufo_fragment(struct sk_buff *skb,
 		goto out;
 	}
 
+	if (skb_shinfo(skb)->gso_type & SKB_GSO_UDP_L4) {
+		segs = udp4_gso_segment(skb, features);
+		goto out;
+	}
+
 	mss = skb_shinfo(skb)->gso_size;
 	if (unlikely(skb->len <= mss))
 		goto out;
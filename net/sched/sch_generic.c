@@ -48,6 +48,8 @@ EXPORT_SYMBOL(default_qdisc_ops);
 static inline int dev_requeue_skb(struct sk_buff *skb, struct Qdisc *q)
 {
 	skb_dst_force(skb);
+	/* A look-ahead skb parked by sch_direct_xmit() goes after skb */
+	q->gso_next_skb = q->gso_skb;
 	q->gso_skb = skb;
 	q->qstats.requeues++;
 	q->q.qlen++;	/* it's still part of the queue */
@@ -65,7 +67,8 @@ static inline struct sk_buff *dequeue_skb(struct Qdisc *q)
 		/* check the reason of requeuing without tx lock first */
 		txq = netdev_get_tx_queue(txq->dev, skb_get_queue_mapping(skb));
 		if (!netif_xmit_frozen_or_stopped(txq)) {
-			q->gso_skb = NULL;
+			q->gso_skb = q->gso_next_skb;
+			q->gso_next_skb = NULL;
 			q->q.qlen--;
 		} else
 			skb = NULL;
@@ -106,6 +109,18 @@ static inline int handle_dev_cpu_collision(struct sk_buff *skb,
 	return ret;
 }
 
+/*
+ * Only look ahead when the next packet is known to go to the same tx
+ * queue and the driver cannot bounce skb with NETDEV_TX_LOCKED.
+ */
+static inline bool qdisc_may_bulk(const struct Qdisc *q,
+				  const struct net_device *dev)
+{
+	return (q->flags & TCQ_F_ONETXQUEUE) &&
+	       !(dev->features & NETIF_F_LLTX) &&
+	       !q->gso_skb && qdisc_qlen(q);
+}
+
 /*
  * Transmit one skb, and handle the return status as required. Holding the
  * __QDISC_STATE_RUNNING bit guarantees that only one CPU can execute this
@@ -119,8 +134,16 @@ int sch_direct_xmit(struct sk_buff *skb, struct Qdisc *q,
 		    struct net_device *dev, struct netdev_queue *txq,
 		    spinlock_t *root_lock)
 {
+	struct sk_buff *nskb = NULL;
 	int ret = NETDEV_TX_BUSY;
 
+	/* Dequeue the next packet up front, so the driver can be told via
+	 * xmit_more that it may defer its doorbell until the burst ends.
+	 */
+	if (qdisc_may_bulk(q, dev))
+		nskb = q->dequeue(q);
+	skb->xmit_more = nskb ? 1 : 0;
+
 	/* And release qdisc */
 	spin_unlock(root_lock);
 
@@ -132,6 +155,15 @@ int sch_direct_xmit(struct sk_buff *skb, struct Qdisc *q,
 
 	spin_lock(root_lock);
 
+	if (nskb) {
+		/* Park the look-ahead packet where dequeue_skb() picks it
+		 * up next. Should skb be requeued below, dev_requeue_skb()
+		 * moves nskb behind it.
+		 */
+		q->gso_skb = nskb;
+		q->q.qlen++;
+	}
+
 	if (dev_xmit_complete(ret)) {
 		/* Driver sent out skb successfully or skb was consumed */
 		ret = qdisc_qlen(q);
@@ -615,7 +647,9 @@ void qdisc_reset(struct Qdisc *qdisc)
 
 	if (qdisc->gso_skb) {
 		kfree_skb(qdisc->gso_skb);
+		kfree_skb(qdisc->gso_next_skb);
 		qdisc->gso_skb = NULL;
+		qdisc->gso_next_skb = NULL;
 		qdisc->q.qlen = 0;
 	}
 }
@@ -651,6 +685,7 @@ void qdisc_destroy(struct Qdisc *qdisc)
 	dev_put(qdisc_dev(qdisc));
 
 	kfree_skb(qdisc->gso_skb);
+	kfree_skb(qdisc->gso_next_skb);
 	/*
 	 * gen_estimator est_timer() might access qdisc->q.lock,
 	 * wait a RCU grace period before freeing qdisc.
@@ -117,6 +117,7 @@
 #include <net/checksum.h>
 #include <linux/security.h>
 #include <linux/freezer.h>
+#include <linux/splice.h>
 
 struct hlist_head unix_socket_table[2 * UNIX_HASH_SIZE];
 EXPORT_SYMBOL_GPL(unix_socket_table);
@@ -520,6 +521,11 @@ static int unix_stream_sendmsg(struct kiocb *, struct socket *,
 			       struct msghdr *, size_t);
 static int unix_stream_recvmsg(struct kiocb *, struct socket *,
 			       struct msghdr *, size_t, int);
+static ssize_t unix_stream_sendpage(struct socket *, struct page *,
+				    int, size_t, int);
+static ssize_t unix_stream_splice_read(struct socket *, loff_t *,
+				       struct pipe_inode_info *,
+				       size_t, unsigned int);
 static int unix_dgram_sendmsg(struct kiocb *, struct socket *,
 			      struct msghdr *, size_t);
 static int unix_dgram_recvmsg(struct kiocb *, struct socket *,
@@ -563,7 +569,8 @@ static const struct proto_ops unix_stream_ops = {
 	.sendmsg =	unix_stream_sendmsg,
 	.recvmsg =	unix_stream_recvmsg,
 	.mmap =		sock_no_mmap,
-	.sendpage =	sock_no_sendpage,
+	.sendpage =	unix_stream_sendpage,
+	.splice_read =	unix_stream_splice_read,
 	.set_peek_off =	unix_set_peek_off,
 };
 
@@ -1728,6 +1735,69 @@ out_err:
 	return sent ? : err;
 }
 
+/*
+ * Queue a reference to @page on the peer instead of copying it.  This is
+ * what splice() from a pipe ends up in, so vmsplice() + splice() moves
+ * user pages into the peer's receive queue without touching the data.
+ * Every page gets its own skb: queued skbs are never grown here, which
+ * keeps us from having to take the peer's readlock under the pipe lock.
+ */
+static ssize_t unix_stream_sendpage(struct socket *sock, struct page *page,
+				    int offset, size_t size, int flags)
+{
+	struct sock *sk = sock->sk;
+	struct sock *other;
+	struct sk_buff *skb;
+	struct scm_cookie scm;
+	int err;
+
+	if (flags & MSG_OOB)
+		return -EOPNOTSUPP;
+
+	other = unix_peer(sk);
+	if (!other || sk->sk_state != TCP_ESTABLISHED)
+		return -ENOTCONN;
+
+	if (sk->sk_shutdown & SEND_SHUTDOWN)
+		goto pipe_err;
+
+	skb = sock_alloc_send_pskb(sk, 0, 0, flags & MSG_DONTWAIT, &err, 0);
+	if (!skb)
+		return err;
+
+	memset(&scm, 0, sizeof(scm));
+	scm_set_cred(&scm, task_tgid(current), current_uid(), current_gid());
+	unix_scm_to_skb(&scm, skb, false);
+	scm_destroy(&scm);
+
+	get_page(page);
+	skb_fill_page_desc(skb, 0, page, offset, size);
+	skb->len = size;
+	skb->data_len = size;
+	skb->truesize += size;
+	atomic_add(size, &sk->sk_wmem_alloc);
+
+	unix_state_lock(other);
+
+	if (sock_flag(other, SOCK_DEAD) ||
+	    (other->sk_shutdown & RCV_SHUTDOWN)) {
+		unix_state_unlock(other);
+		kfree_skb(skb);
+		goto pipe_err;
+	}
+
+	skb_queue_tail(&other->sk_receive_queue, skb);
+	unix_state_unlock(other);
+	other->sk_data_ready(other, size);
+
+	return size;
+
+pipe_err:
+	if (!(flags & MSG_NOSIGNAL))
+		send_sig(SIGPIPE, current, 0);
+	return -EPIPE;
+}
+
 static int unix_seqpacket_sendmsg(struct kiocb *kiocb, struct socket *sock,
 				  struct msghdr *msg, size_t len)
 {
@@ -2068,6 +2138,117 @@ out:
 	return copied ? : err;
 }
 
+/*
+ * Move queued data into a pipe.  Page fragments are passed on by
+ * reference, only the linear head of an skb is copied.  Credentials are
+ * not reported and any passed descriptors are dropped, as there is no
+ * control message to carry them.
+ */
+static ssize_t unix_stream_splice_read(struct socket *sock, loff_t *ppos,
+				       struct pipe_inode_info *pipe,
+				       size_t size, unsigned int flags)
+{
+	struct sock *sk = sock->sk;
+	struct unix_sock *u = unix_sk(sk);
+	struct scm_cookie scm;
+	int noblock = (sock->file->f_flags & O_NONBLOCK) ||
+		      (flags & SPLICE_F_NONBLOCK);
+	ssize_t spliced = 0;
+	long timeo;
+	int err;
+
+	if (unlikely(*ppos))
+		return -ESPIPE;
+
+	if (sk->sk_state != TCP_ESTABLISHED)
+		return -EINVAL;
+
+	timeo = sock_rcvtimeo(sk, noblock);
+	memset(&scm, 0, sizeof(scm));
+
+	err = mutex_lock_interruptible(&u->readlock);
+	if (unlikely(err))
+		return noblock ? -EAGAIN : -ERESTARTSYS;
+
+	while (size) {
+		struct sk_buff *skb, *last;
+		struct sock *owner;
+		int chunk, ret;
+
+		unix_state_lock(sk);
+		last = skb = skb_peek(&sk->sk_receive_queue);
+		if (skb == NULL) {
+			unix_sk(sk)->recursion_level = 0;
+			if (spliced)
+				goto unlock;
+
+			err = sock_error(sk);
+			if (err)
+				goto unlock;
+			if (sk->sk_shutdown & RCV_SHUTDOWN)
+				goto unlock;
+
+			unix_state_unlock(sk);
+			err = -EAGAIN;
+			if (!timeo)
+				break;
+			mutex_unlock(&u->readlock);
+
+			timeo = unix_stream_data_wait(sk, timeo, last);
+
+			if (signal_pending(current)
+			    ||  mutex_lock_interruptible(&u->readlock)) {
+				err = sock_intr_errno(timeo);
+				goto out;
+			}
+
+			continue;
+ unlock:
+			unix_state_unlock(sk);
+			break;
+		}
+		unix_state_unlock(sk);
+
+		/*
+		 * skb_splice_bits() drops and retakes the owner's socket
+		 * lock around splice_to_pipe(), and copies the linear part
+		 * through the owner's page frag, so hold it like TCP does.
+		 */
+		owner = skb->sk;
+		chunk = min_t(unsigned int, unix_skb_len(skb), size);
+		lock_sock(owner);
+		ret = skb_splice_bits(skb, UNIXCB(skb).consumed, pipe, chunk,
+				      flags);
+		release_sock(owner);
+		if (ret <= 0) {
+			err = ret;
+			break;
+		}
+		spliced += ret;
+		size -= ret;
+
+		UNIXCB(skb).consumed += ret;
+		sk_peek_offset_bwd(sk, ret);
+
+		if (UNIXCB(skb).fp)
+			unix_detach_fds(&scm, skb);
+
+		if (unix_skb_len(skb))
+			break;
+
+		skb_unlink(skb, &sk->sk_receive_queue);
+		consume_skb(skb);
+
+		if (scm.fp)
+			break;
+	}
+
+	mutex_unlock(&u->readlock);
+out:
+	scm_destroy(&scm);
+	return spliced ? : err;
+}
+
 static int unix_shutdown(struct socket *sock, int mode)
 {
 	struct sock *sk = sock->sk;
@@ -38,6 +38,9 @@
 #if defined(CONFIG_MIPS) && defined(CONFIG_DMA_NONCOHERENT)
 #include <dma-coherence.h>
 #endif
+#ifdef CONFIG_MIPS
+#include <asm/cpu-features.h>
+#endif
 
 /*
  *  Compatibility
@@ -3034,8 +3037,22 @@ static unsigned int snd_pcm_capture_poll(struct file *file, poll_table * wait)
 /*
  * Only on coherent architectures, we can mmap the status and the control records
  * for effcient data transfer.  On others, we have to use HWSYNC ioctl...
+ *
+ * The records are only ever accessed by the CPU, so on MIPS it is enough
+ * that the data cache has no aliases: the kernel and the user mapping then
+ * hit the same cache lines, DMA coherence does not matter.
  */
-#if defined(CONFIG_X86) || defined(CONFIG_PPC) || defined(CONFIG_ALPHA)
+#if defined(CONFIG_X86) || defined(CONFIG_PPC) || defined(CONFIG_ALPHA) || \
+	defined(CONFIG_MIPS)
+static inline bool snd_pcm_mmap_records_allowed(void)
+{
+#ifdef CONFIG_MIPS
+	return !cpu_has_dc_aliases;
+#else
+	return true;
+#endif
+}
+
 /*
  * mmap status record
  */
@@ -3062,6 +3079,8 @@ static int snd_pcm_mmap_status(struct snd_pcm_substream *substream, struct file
 			       struct vm_area_struct *area)
 {
 	long size;
+	if (!snd_pcm_mmap_records_allowed())
+		return -ENXIO;
 	if (!(area->vm_flags & VM_READ))
 		return -EINVAL;
 	size = area->vm_end - area->vm_start;
@@ -3099,6 +3118,8 @@ static int snd_pcm_mmap_control(struct snd_pcm_substream *substream, struct file
 				struct vm_area_struct *area)
 {
 	long size;
+	if (!snd_pcm_mmap_records_allowed())
+		return -ENXIO;
 	if (!(area->vm_flags & VM_READ))
 		return -EINVAL;
 	size = area->vm_end - area->vm_start;
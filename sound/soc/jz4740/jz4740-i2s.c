@@ -17,6 +17,7 @@
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
+#include <linux/pm_runtime.h>
 #include <linux/slab.h>
 
 #include <linux/clk.h>
@@ -83,6 +84,12 @@
 
 #define JZ_AIC_CLK_DIV_MASK 0xf
 
+/* DMA burst size in bytes, also the granularity of the period size */
+#define JZ4740_I2S_DMA_BURST 16
+
+/* Keeps the I2S clock running across quickly reopened streams, in ms */
+#define JZ4740_I2S_AUTOSUSPEND_DELAY 500
+
 struct jz4740_i2s {
 	struct resource *mem;
 	void __iomem *base;
@@ -107,11 +114,57 @@ static inline void jz4740_i2s_write(const struct jz4740_i2s *i2s,
 	writel(value, i2s->base + reg);
 }
 
+static void jz4740_i2s_power_on(struct jz4740_i2s *i2s)
+{
+	uint32_t conf;
+
+	clk_prepare_enable(i2s->clk_i2s);
+
+	conf = jz4740_i2s_read(i2s, JZ_REG_AIC_CONF);
+	conf |= JZ_AIC_CONF_ENABLE;
+	jz4740_i2s_write(i2s, JZ_REG_AIC_CONF, conf);
+}
+
+static void jz4740_i2s_power_off(struct jz4740_i2s *i2s)
+{
+	uint32_t conf;
+
+	conf = jz4740_i2s_read(i2s, JZ_REG_AIC_CONF);
+	conf &= ~JZ_AIC_CONF_ENABLE;
+	jz4740_i2s_write(i2s, JZ_REG_AIC_CONF, conf);
+
+	clk_disable_unprepare(i2s->clk_i2s);
+}
+
+/*
+ * The ASoC core holds a runtime PM reference while a stream is open. Without
+ * runtime PM the controller is powered from startup to shutdown instead.
+ */
+static bool jz4740_i2s_is_powered(struct snd_soc_dai *dai)
+{
+	if (pm_runtime_enabled(dai->dev))
+		return !pm_runtime_status_suspended(dai->dev);
+
+	return dai->active;
+}
+
 static int jz4740_i2s_startup(struct snd_pcm_substream *substream,
 	struct snd_soc_dai *dai)
 {
 	struct jz4740_i2s *i2s = snd_soc_dai_get_drvdata(dai);
-	uint32_t conf, ctrl;
+	uint32_t ctrl;
+	int ret;
+
+	/*
+	 * The DMA controller can only end a period on a burst boundary. Any
+	 * multiple of the burst size works though, from small periods for low
+	 * latency streams to large ones for streams which want the CPU to
+	 * wake up rarely.
+	 */
+	ret = snd_pcm_hw_constraint_step(substream->runtime, 0,
+		SNDRV_PCM_HW_PARAM_PERIOD_BYTES, JZ4740_I2S_DMA_BURST);
+	if (ret < 0)
+		return ret;
 
 	if (dai->active)
 		return 0;
@@ -120,11 +173,8 @@ static int jz4740_i2s_startup(struct snd_pcm_substream *substream,
 	ctrl |= JZ_AIC_CTRL_FLUSH;
 	jz4740_i2s_write(i2s, JZ_REG_AIC_CTRL, ctrl);
 
-	clk_prepare_enable(i2s->clk_i2s);
-
-	conf = jz4740_i2s_read(i2s, JZ_REG_AIC_CONF);
-	conf |= JZ_AIC_CONF_ENABLE;
-	jz4740_i2s_write(i2s, JZ_REG_AIC_CONF, conf);
+	if (!pm_runtime_enabled(dai->dev))
+		jz4740_i2s_power_on(i2s);
 
 	return 0;
 }
@@ -133,16 +183,14 @@ static void jz4740_i2s_shutdown(struct snd_pcm_substream *substream,
 	struct snd_soc_dai *dai)
 {
 	struct jz4740_i2s *i2s = snd_soc_dai_get_drvdata(dai);
-	uint32_t conf;
 
 	if (dai->active)
 		return;
 
-	conf = jz4740_i2s_read(i2s, JZ_REG_AIC_CONF);
-	conf &= ~JZ_AIC_CONF_ENABLE;
-	jz4740_i2s_write(i2s, JZ_REG_AIC_CONF, conf);
-
-	clk_disable_unprepare(i2s->clk_i2s);
+	if (pm_runtime_enabled(dai->dev))
+		pm_runtime_mark_last_busy(dai->dev);
+	else
+		jz4740_i2s_power_off(i2s);
 }
 
 static int jz4740_i2s_trigger(struct snd_pcm_substream *substream, int cmd,
@@ -296,15 +344,9 @@ static int jz4740_i2s_set_sysclk(struct snd_soc_dai *dai, int clk_id,
 static int jz4740_i2s_suspend(struct snd_soc_dai *dai)
 {
 	struct jz4740_i2s *i2s = snd_soc_dai_get_drvdata(dai);
-	uint32_t conf;
 
-	if (dai->active) {
-		conf = jz4740_i2s_read(i2s, JZ_REG_AIC_CONF);
-		conf &= ~JZ_AIC_CONF_ENABLE;
-		jz4740_i2s_write(i2s, JZ_REG_AIC_CONF, conf);
-
-		clk_disable_unprepare(i2s->clk_i2s);
-	}
+	if (jz4740_i2s_is_powered(dai))
+		jz4740_i2s_power_off(i2s);
 
 	clk_disable_unprepare(i2s->clk_aic);
 
@@ -314,20 +356,35 @@ static int jz4740_i2s_suspend(struct snd_soc_dai *dai)
 static int jz4740_i2s_resume(struct snd_soc_dai *dai)
 {
 	struct jz4740_i2s *i2s = snd_soc_dai_get_drvdata(dai);
-	uint32_t conf;
 
 	clk_prepare_enable(i2s->clk_aic);
 
-	if (dai->active) {
-		clk_prepare_enable(i2s->clk_i2s);
+	if (jz4740_i2s_is_powered(dai))
+		jz4740_i2s_power_on(i2s);
 
-		conf = jz4740_i2s_read(i2s, JZ_REG_AIC_CONF);
-		conf |= JZ_AIC_CONF_ENABLE;
-		jz4740_i2s_write(i2s, JZ_REG_AIC_CONF, conf);
-	}
+	return 0;
+}
+
+#ifdef CONFIG_PM_RUNTIME
+static int jz4740_i2s_runtime_suspend(struct device *dev)
+{
+	jz4740_i2s_power_off(dev_get_drvdata(dev));
+
+	return 0;
+}
+
+static int jz4740_i2s_runtime_resume(struct device *dev)
+{
+	jz4740_i2s_power_on(dev_get_drvdata(dev));
 
 	return 0;
 }
+#endif
+
+static const struct dev_pm_ops jz4740_i2s_pm_ops = {
+	SET_RUNTIME_PM_OPS(jz4740_i2s_runtime_suspend,
+		jz4740_i2s_runtime_resume, NULL)
+};
 
 static void jz4740_i2c_init_pcm_config(struct jz4740_i2s *i2s)
 {
@@ -335,13 +392,13 @@ static void jz4740_i2c_init_pcm_config(struct jz4740_i2s *i2s)
 
 	/* Playback */
 	dma_data = &i2s->playback_dma_data;
-	dma_data->maxburst = 16;
+	dma_data->maxburst = JZ4740_I2S_DMA_BURST;
 	dma_data->slave_id = JZ4740_DMA_TYPE_AIC_TRANSMIT;
 	dma_data->addr = i2s->phys_base + JZ_REG_AIC_FIFO;
 
 	/* Capture */
 	dma_data = &i2s->capture_dma_data;
-	dma_data->maxburst = 16;
+	dma_data->maxburst = JZ4740_I2S_DMA_BURST;
 	dma_data->slave_id = JZ4740_DMA_TYPE_AIC_RECEIVE;
 	dma_data->addr = i2s->phys_base + JZ_REG_AIC_FIFO;
 }
@@ -441,20 +498,54 @@ static int jz4740_i2s_dev_probe(struct platform_device *pdev)
 
 	platform_set_drvdata(pdev, i2s);
 
+	/*
+	 * Only the I2S clock and the controller are runtime suspended. The
+	 * AIC clock stays enabled, the registers of the internal codec live
+	 * in the AIC block as well.
+	 */
+	pm_runtime_set_autosuspend_delay(&pdev->dev,
+		JZ4740_I2S_AUTOSUSPEND_DELAY);
+	pm_runtime_use_autosuspend(&pdev->dev);
+	pm_runtime_enable(&pdev->dev);
+
 	ret = devm_snd_soc_register_component(&pdev->dev,
 		&jz4740_i2s_component, &jz4740_i2s_dai, 1);
 	if (ret)
-		return ret;
+		goto err_pm_disable;
+
+	ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL,
+		SND_DMAENGINE_PCM_FLAG_COMPAT |
+		SND_DMAENGINE_PCM_FLAG_NO_PERIOD_WAKEUP |
+		SND_DMAENGINE_PCM_FLAG_CACHED_CAPTURE);
+	if (ret)
+		goto err_pm_disable;
+
+	return 0;
 
-	return devm_snd_dmaengine_pcm_register(&pdev->dev, NULL,
-		SND_DMAENGINE_PCM_FLAG_COMPAT);
+err_pm_disable:
+	pm_runtime_disable(&pdev->dev);
+	pm_runtime_dont_use_autosuspend(&pdev->dev);
+	return ret;
+}
+
+static int jz4740_i2s_dev_remove(struct platform_device *pdev)
+{
+	pm_runtime_disable(&pdev->dev);
+	if (!pm_runtime_status_suspended(&pdev->dev))
+		jz4740_i2s_power_off(platform_get_drvdata(pdev));
+	pm_runtime_set_suspended(&pdev->dev);
+	pm_runtime_dont_use_autosuspend(&pdev->dev);
+
+	return 0;
 }
 
 static struct platform_driver jz4740_i2s_driver = {
 	.probe = jz4740_i2s_dev_probe,
+	.remove = jz4740_i2s_dev_remove,
 	.driver = {
 		.name = "jz4740-i2s",
 		.owner = THIS_MODULE,
+		.pm = &jz4740_i2s_pm_ops,
 	},
 };
 
@@ -18,6 +18,7 @@
 #include <linux/platform_device.h>
 #include <sound/core.h>
 #include <sound/pcm.h>
+#include <sound/pcm_params.h>
 #include <sound/soc.h>
 #include <linux/gpio.h>
 
@@ -44,6 +45,10 @@ static const struct snd_soc_dapm_route qi_lb60_routes[] = {
 	{"Mic", NULL, "MIC"},
 	{"Speaker", NULL, "LOUT"},
 	{"Speaker", NULL, "ROUT"},
+#ifdef CONFIG_SND_JZ4740_SOC_QI_LB60_SWDSP
+	{"Playback", NULL, "FE0 Playback"},
+	{"Playback", NULL, "FE1 Playback"},
+#endif
 };
 
 #define QI_LB60_DAIFMT (SND_SOC_DAIFMT_I2S | \
@@ -69,6 +74,8 @@ static int qi_lb60_codec_init(struct snd_soc_pcm_runtime *rtd)
 	return 0;
 }
 
+#ifndef CONFIG_SND_JZ4740_SOC_QI_LB60_SWDSP
+
 static struct snd_soc_dai_link qi_lb60_dai = {
 	.name = "jz4740",
 	.stream_name = "jz4740",
@@ -91,6 +98,80 @@ static struct snd_soc_card qi_lb60 = {
 	.num_dapm_routes = ARRAY_SIZE(qi_lb60_routes),
 };
 
+#else
+
+/*
+ * Two front ends are mixed by the software DSP, which runs the I2S DMA
+ * itself. The back end therefore uses the dummy platform, at a fixed format.
+ */
+static int qi_lb60_be_hw_params_fixup(struct snd_soc_pcm_runtime *rtd,
+	struct snd_pcm_hw_params *params)
+{
+	struct snd_interval *rate, *channels;
+	struct snd_mask *format;
+
+	rate = hw_param_interval(params, SNDRV_PCM_HW_PARAM_RATE);
+	rate->min = rate->max = 48000;
+
+	channels = hw_param_interval(params, SNDRV_PCM_HW_PARAM_CHANNELS);
+	channels->min = channels->max = 2;
+
+	format = hw_param_mask(params, SNDRV_PCM_HW_PARAM_FORMAT);
+	snd_mask_none(format);
+	snd_mask_set(format, SNDRV_PCM_FORMAT_S16_LE);
+
+	return 0;
+}
+
+static struct snd_soc_dai_link qi_lb60_dai[] = {
+	{
+		.name = "jz4740 prompts",
+		.stream_name = "Prompts",
+		.cpu_dai_name = "swdsp-fe0",
+		.platform_name = "snd-soc-swdsp",
+		.codec_dai_name = "snd-soc-dummy-dai",
+		.codec_name = "snd-soc-dummy",
+		.dynamic = 1,
+		.dpcm_playback = 1,
+	},
+	{
+		.name = "jz4740 music",
+		.stream_name = "Music",
+		.cpu_dai_name = "swdsp-fe1",
+		.platform_name = "snd-soc-swdsp",
+		.codec_dai_name = "snd-soc-dummy-dai",
+		.codec_name = "snd-soc-dummy",
+		.dynamic = 1,
+		.dpcm_playback = 1,
+	},
+	{
+		.name = "jz4740",
+		.stream_name = "jz4740",
+		.cpu_dai_name = "jz4740-i2s",
+		.platform_name = "snd-soc-dummy",
+		.codec_dai_name = "jz4740-hifi",
+		.codec_name = "jz4740-codec",
+		.init = qi_lb60_codec_init,
+		.be_hw_params_fixup = qi_lb60_be_hw_params_fixup,
+		.no_pcm = 1,
+		.dpcm_playback = 1,
+	},
+};
+
+static struct snd_soc_card qi_lb60 = {
+	.name = "QI LB60",
+	.owner = THIS_MODULE,
+	.dai_link = qi_lb60_dai,
+	.num_links = ARRAY_SIZE(qi_lb60_dai),
+
+	.dapm_widgets = qi_lb60_widgets,
+	.num_dapm_widgets = ARRAY_SIZE(qi_lb60_widgets),
+	.dapm_routes = qi_lb60_routes,
+	.num_dapm_routes = ARRAY_SIZE(qi_lb60_routes),
+};
+
+#endif
+
 static const struct gpio qi_lb60_gpios[] = {
 	{ QI_LB60_SND_GPIO, GPIOF_OUT_INIT_LOW, "SND" },
 	{ QI_LB60_AMP_GPIO, GPIOF_OUT_INIT_LOW, "AMP" },
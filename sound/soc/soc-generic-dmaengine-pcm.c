@@ -14,6 +14,7 @@
  */
 #include <linux/module.h>
 #include <linux/init.h>
+#include <linux/cache.h>
 #include <linux/dmaengine.h>
 #include <linux/slab.h>
 #include <sound/pcm.h>
@@ -29,6 +30,10 @@ struct dmaengine_pcm {
 	const struct snd_dmaengine_pcm_config *config;
 	struct snd_soc_platform platform;
 	unsigned int flags;
+
+	/* How far the cached capture buffer has been invalidated */
+	unsigned int capture_sync_pos;
+	bool capture_mapped;
 };
 
 static struct dmaengine_pcm *soc_platform_to_pcm(struct snd_soc_platform *p)
@@ -45,6 +50,81 @@ static struct device *dmaengine_dma_dev(struct dmaengine_pcm *pcm,
 	return pcm->chan[substream->stream]->device->dev;
 }
 
+static bool dmaengine_pcm_cached(struct dmaengine_pcm *pcm,
+	struct snd_pcm_substream *substream)
+{
+	return (pcm->flags & SND_DMAENGINE_PCM_FLAG_CACHED_CAPTURE) &&
+		substream->stream == SNDRV_PCM_STREAM_CAPTURE;
+}
+
+/*
+ * A cached capture buffer is mapped for the DMA for as long as the hardware
+ * parameters are set, and handed back to the CPU piecewise in
+ * dmaengine_pcm_pointer().
+ */
+static void dmaengine_pcm_unmap_capture(struct dmaengine_pcm *pcm,
+	struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+
+	if (!pcm->capture_mapped)
+		return;
+
+	dma_unmap_single(dmaengine_dma_dev(pcm, substream), runtime->dma_addr,
+			 runtime->dma_bytes, DMA_FROM_DEVICE);
+	pcm->capture_mapped = false;
+}
+
+static int dmaengine_pcm_map_capture(struct dmaengine_pcm *pcm,
+	struct snd_pcm_substream *substream)
+{
+	struct device *dma_dev = dmaengine_dma_dev(pcm, substream);
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	dma_addr_t addr;
+
+	addr = dma_map_single(dma_dev, runtime->dma_area, runtime->dma_bytes,
+			      DMA_FROM_DEVICE);
+	if (dma_mapping_error(dma_dev, addr))
+		return -ENOMEM;
+
+	runtime->dma_addr = addr;
+	pcm->capture_mapped = true;
+
+	return 0;
+}
+
+/*
+ * The CPU may still hold cache lines of the range from reading it on the
+ * previous lap of the ring, and on most platforms syncing for the CPU does
+ * not drop them. So invalidate the range first, it has only been read by the
+ * CPU and no dirty lines can be lost.
+ */
+static void dmaengine_pcm_sync_range(struct device *dma_dev, dma_addr_t addr,
+	size_t len)
+{
+	dma_sync_single_for_device(dma_dev, addr, len, DMA_FROM_DEVICE);
+	dma_sync_single_for_cpu(dma_dev, addr, len, DMA_FROM_DEVICE);
+}
+
+static void dmaengine_pcm_sync_capture(struct dmaengine_pcm *pcm,
+	struct snd_pcm_substream *substream, unsigned int pos)
+{
+	struct device *dma_dev = dmaengine_dma_dev(pcm, substream);
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	unsigned int start = pcm->capture_sync_pos;
+
+	if (pos < start) {
+		dmaengine_pcm_sync_range(dma_dev, runtime->dma_addr + start,
+			snd_pcm_lib_buffer_bytes(substream) - start);
+		start = 0;
+	}
+	if (pos > start)
+		dmaengine_pcm_sync_range(dma_dev, runtime->dma_addr + start,
+					 pos - start);
+
+	pcm->capture_sync_pos = pos;
+}
+
 /**
  * snd_dmaengine_pcm_prepare_slave_config() - Generic prepare_slave_config callback
  * @substream: PCM substream
@@ -107,7 +187,44 @@ static int dmaengine_pcm_hw_params(struct snd_pcm_substream *substream,
 			return ret;
 	}
 
-	return snd_pcm_lib_malloc_pages(substream, params_buffer_bytes(params));
+	if (!dmaengine_pcm_cached(pcm, substream))
+		return snd_pcm_lib_malloc_pages(substream,
+						params_buffer_bytes(params));
+
+	dmaengine_pcm_unmap_capture(pcm, substream);
+
+	ret = snd_pcm_lib_malloc_pages(substream, params_buffer_bytes(params));
+	if (ret < 0)
+		return ret;
+
+	return dmaengine_pcm_map_capture(pcm, substream) ?: ret;
+}
+
+static int dmaengine_pcm_hw_free(struct snd_pcm_substream *substream)
+{
+	struct snd_soc_pcm_runtime *rtd = substream->private_data;
+	struct dmaengine_pcm *pcm = soc_platform_to_pcm(rtd->platform);
+
+	if (dmaengine_pcm_cached(pcm, substream))
+		dmaengine_pcm_unmap_capture(pcm, substream);
+
+	return snd_pcm_lib_free_pages(substream);
+}
+
+static int dmaengine_pcm_prepare(struct snd_pcm_substream *substream)
+{
+	struct snd_soc_pcm_runtime *rtd = substream->private_data;
+	struct dmaengine_pcm *pcm = soc_platform_to_pcm(rtd->platform);
+	struct snd_pcm_runtime *runtime = substream->runtime;
+
+	/* Drop whatever was cached from the buffer before it is refilled */
+	if (dmaengine_pcm_cached(pcm, substream)) {
+		dma_sync_single_for_device(dmaengine_dma_dev(pcm, substream),
+			runtime->dma_addr, runtime->dma_bytes, DMA_FROM_DEVICE);
+		pcm->capture_sync_pos = 0;
+	}
+
+	return 0;
 }
 
 static int dmaengine_pcm_set_runtime_hwparams(struct snd_pcm_substream *substream)
@@ -139,6 +256,8 @@ static int dmaengine_pcm_set_runtime_hwparams(struct snd_pcm_substream *substrea
 
 	if (pcm->flags & SND_DMAENGINE_PCM_FLAG_NO_RESIDUE)
 		hw.info |= SNDRV_PCM_INFO_BATCH;
+	else if (pcm->flags & SND_DMAENGINE_PCM_FLAG_NO_PERIOD_WAKEUP)
+		hw.info |= SNDRV_PCM_INFO_NO_PERIOD_WAKEUP;
 
 	ret = dma_get_slave_caps(chan, &dma_caps);
 	if (ret == 0) {
@@ -162,6 +281,18 @@ static int dmaengine_pcm_open(struct snd_pcm_substream *substream)
 	if (ret)
 		return ret;
 
+	/*
+	 * Positions are only reported up to the last complete cache line, so
+	 * keep period boundaries on one to report them without delay.
+	 */
+	if (dmaengine_pcm_cached(pcm, substream)) {
+		ret = snd_pcm_hw_constraint_step(substream->runtime, 0,
+				SNDRV_PCM_HW_PARAM_PERIOD_BYTES,
+				cache_line_size());
+		if (ret < 0)
+			return ret;
+	}
+
 	return snd_dmaengine_pcm_open(substream, chan);
 }
 
@@ -252,11 +383,18 @@ static int dmaengine_pcm_new(struct snd_soc_pcm_runtime *rtd)
 			goto err_free;
 		}
 
-		ret = snd_pcm_lib_preallocate_pages(substream,
-				SNDRV_DMA_TYPE_DEV_IRAM,
-				dmaengine_dma_dev(pcm, substream),
-				prealloc_buffer_size,
-				max_buffer_size);
+		if (dmaengine_pcm_cached(pcm, substream))
+			ret = snd_pcm_lib_preallocate_pages(substream,
+					SNDRV_DMA_TYPE_CONTINUOUS,
+					snd_dma_continuous_data(GFP_KERNEL),
+					prealloc_buffer_size,
+					max_buffer_size);
+		else
+			ret = snd_pcm_lib_preallocate_pages(substream,
+					SNDRV_DMA_TYPE_DEV_IRAM,
+					dmaengine_dma_dev(pcm, substream),
+					prealloc_buffer_size,
+					max_buffer_size);
 		if (ret)
 			goto err_free;
 
@@ -283,11 +421,26 @@ static snd_pcm_uframes_t dmaengine_pcm_pointer(
 {
 	struct snd_soc_pcm_runtime *rtd = substream->private_data;
 	struct dmaengine_pcm *pcm = soc_platform_to_pcm(rtd->platform);
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	snd_pcm_uframes_t pos;
+	unsigned int bytes;
 
 	if (pcm->flags & SND_DMAENGINE_PCM_FLAG_NO_RESIDUE)
-		return snd_dmaengine_pcm_pointer_no_residue(substream);
+		pos = snd_dmaengine_pcm_pointer_no_residue(substream);
 	else
-		return snd_dmaengine_pcm_pointer(substream);
+		pos = snd_dmaengine_pcm_pointer(substream);
+
+	if (!dmaengine_pcm_cached(pcm, substream))
+		return pos;
+
+	/*
+	 * The DMA may still be writing to the current cache line. Stop short
+	 * of it, so it is not cached before it is complete.
+	 */
+	bytes = round_down(frames_to_bytes(runtime, pos), cache_line_size());
+	dmaengine_pcm_sync_capture(pcm, substream, bytes);
+
+	return bytes_to_frames(runtime, bytes);
 }
 
 static const struct snd_pcm_ops dmaengine_pcm_ops = {
@@ -295,7 +448,8 @@ static const struct snd_pcm_ops dmaengine_pcm_ops = {
 	.close		= snd_dmaengine_pcm_close,
 	.ioctl		= snd_pcm_lib_ioctl,
 	.hw_params	= dmaengine_pcm_hw_params,
-	.hw_free	= snd_pcm_lib_free_pages,
+	.hw_free	= dmaengine_pcm_hw_free,
+	.prepare	= dmaengine_pcm_prepare,
 	.trigger	= snd_dmaengine_pcm_trigger,
 	.pointer	= dmaengine_pcm_pointer,
 };
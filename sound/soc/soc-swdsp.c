@@ -0,0 +1,677 @@
+/*
+ * soc-swdsp.c  --  ALSA SoC software DSP front ends
+ *
+ * Mixes up to SWDSP_NUM_FES playback streams into the DMA ring of a single
+ * back end DAI, converting their sample rates on the way, so that several
+ * applications can share the output without a mixing daemon in between.
+ *
+ * Machine drivers use it through dynamic PCM. Each front end link uses one
+ * of the "swdsp-feN" CPU DAIs, the dummy codec and the "snd-soc-swdsp"
+ * platform, and is routed to the back end by connecting its "FEn Playback"
+ * stream to the back end CPU DAI's playback stream. The back end link uses
+ * the dummy platform, since the DMA is run from here, and has to be fixed up
+ * to 16 bit stereo at a rate at least as high as any front end's.
+ *
+ * Front ends are mixed one DMA period at a time from the DMA completion
+ * callback, so their position advances in steps of SWDSP_PERIOD_FRAMES.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under  the terms of the GNU General  Public License as published by the
+ *  Free Software Foundation;  either version 2 of the License, or (at your
+ *  option) any later version.
+ */
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/platform_device.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+#include <sound/dmaengine_pcm.h>
+#include <sound/pcm.h>
+#include <sound/pcm_params.h>
+#include <sound/soc.h>
+#include <sound/soc-dpcm.h>
+
+#define SWDSP_NUM_FES		4
+
+#define SWDSP_RING_PERIODS	4
+#define SWDSP_PERIOD_FRAMES	256
+#define SWDSP_PERIOD_BYTES	(SWDSP_PERIOD_FRAMES * 2 * sizeof(s16))
+#define SWDSP_RING_BYTES	(SWDSP_RING_PERIODS * SWDSP_PERIOD_BYTES)
+
+#define SWDSP_PHASES		32
+#define SWDSP_TAPS		16
+
+/*
+ * Polyphase filter for upsampling: a Kaiser windowed sinc with its cutoff at
+ * 90% of the input Nyquist rate, in Q15. Row p interpolates at p / 32 of the
+ * way from tap 7 to tap 8, each row adds up to unity gain.
+ */
+static const s16 swdsp_coeffs[SWDSP_PHASES][SWDSP_TAPS] = {
+	{ 48, -192, 511, -1047, 1755, -2496, 3063, 29489,
+	  3063, -2496, 1755, -1047, 511, -192, 48, -5 },
+	{ 49, -191, 496, -990, 1603, -2135, 2145, 29445,
+	  4021, -2852, 1900, -1097, 523, -192, 47, -4 },
+	{ 49, -187, 478, -928, 1443, -1773, 1270, 29325,
+	  5015, -3200, 2034, -1139, 530, -190, 45, -4 },
+	{ 48, -183, 456, -861, 1278, -1412, 440, 29129,
+	  6042, -3538, 2157, -1174, 533, -186, 43, -4 },
+	{ 47, -177, 432, -790, 1110, -1056, -341, 28853,
+	  7097, -3862, 2268, -1201, 532, -180, 39, -3 },
+	{ 46, -170, 405, -716, 940, -706, -1073, 28502,
+	  8178, -4169, 2363, -1219, 526, -173, 36, -2 },
+	{ 44, -162, 376, -639, 768, -365, -1752, 28077,
+	  9278, -4455, 2443, -1226, 514, -163, 31, -1 },
+	{ 42, -152, 346, -560, 598, -36, -2378, 27575,
+	  10395, -4718, 2506, -1224, 498, -150, 26, 0 },
+	{ 40, -143, 314, -480, 429, 280, -2949, 27007,
+	  11523, -4954, 2550, -1211, 477, -136, 20, 1 },
+	{ 38, -132, 281, -400, 264, 581, -3464, 26369,
+	  12657, -5160, 2575, -1188, 450, -119, 13, 3 },
+	{ 35, -121, 248, -320, 104, 864, -3924, 25671,
+	  13792, -5333, 2579, -1153, 418, -101, 5, 4 },
+	{ 32, -110, 214, -241, -51, 1129, -4328, 24912,
+	  14923, -5471, 2562, -1107, 381, -80, -3, 6 },
+	{ 30, -98, 181, -163, -199, 1374, -4676, 24092,
+	  16045, -5569, 2523, -1049, 338, -57, -12, 8 },
+	{ 27, -87, 147, -88, -339, 1597, -4968, 23223,
+	  17154, -5626, 2461, -980, 290, -33, -21, 11 },
+	{ 24, -75, 115, -16, -471, 1799, -5206, 22305,
+	  18243, -5639, 2375, -900, 238, -6, -31, 13 },
+	{ 21, -64, 83, 54, -594, 1978, -5391, 21344,
+	  19307, -5605, 2266, -809, 181, 22, -41, 16 },
+	{ 18, -52, 52, 119, -706, 2134, -5523, 20343,
+	  20341, -5523, 2134, -706, 119, 52, -52, 18 },
+	{ 16, -41, 22, 181, -809, 2266, -5605, 19307,
+	  21344, -5391, 1978, -594, 54, 83, -64, 21 },
+	{ 13, -31, -6, 238, -900, 2375, -5639, 18243,
+	  22305, -5206, 1799, -471, -16, 115, -75, 24 },
+	{ 11, -21, -33, 290, -980, 2461, -5626, 17154,
+	  23223, -4968, 1597, -339, -88, 147, -87, 27 },
+	{ 8, -12, -57, 338, -1049, 2523, -5569, 16045,
+	  24092, -4676, 1374, -199, -163, 181, -98, 30 },
+	{ 6, -3, -80, 381, -1107, 2562, -5471, 14923,
+	  24912, -4328, 1129, -51, -241, 214, -110, 32 },
+	{ 4, 5, -101, 418, -1153, 2579, -5333, 13792,
+	  25671, -3924, 864, 104, -320, 248, -121, 35 },
+	{ 3, 13, -119, 450, -1188, 2575, -5160, 12657,
+	  26369, -3464, 581, 264, -400, 281, -132, 38 },
+	{ 1, 20, -136, 477, -1211, 2550, -4954, 11523,
+	  27007, -2949, 280, 429, -480, 314, -143, 40 },
+	{ 0, 26, -150, 498, -1224, 2506, -4718, 10395,
+	  27575, -2378, -36, 598, -560, 346, -152, 42 },
+	{ -1, 31, -163, 514, -1226, 2443, -4455, 9278,
+	  28077, -1752, -365, 768, -639, 376, -162, 44 },
+	{ -2, 36, -173, 526, -1219, 2363, -4169, 8178,
+	  28502, -1073, -706, 940, -716, 405, -170, 46 },
+	{ -3, 39, -180, 532, -1201, 2268, -3862, 7097,
+	  28853, -341, -1056, 1110, -790, 432, -177, 47 },
+	{ -4, 43, -186, 533, -1174, 2157, -3538, 6042,
+	  29129, 440, -1412, 1278, -861, 456, -183, 48 },
+	{ -4, 45, -190, 530, -1139, 2034, -3200, 5015,
+	  29325, 1270, -1773, 1443, -928, 478, -187, 49 },
+	{ -4, 47, -192, 523, -1097, 1900, -2852, 4021,
+	  29445, 2145, -2135, 1603, -990, 496, -191, 49 },
+};
+
+struct swdsp_fe {
+	struct snd_pcm_substream *substream;
+	bool running;
+
+	unsigned int rate;
+	unsigned int channels;
+
+	/* Frames consumed from the buffer, wrapping at the runtime boundary */
+	snd_pcm_uframes_t hw_ptr;
+	snd_pcm_uframes_t period_pos;
+
+	/* Position past tap 7, in units of 1 / output rate */
+	unsigned int phase;
+	s16 hist[SWDSP_TAPS][2];
+};
+
+struct swdsp {
+	struct device *dev;
+
+	/* Protects the front ends and the ring state against the DMA callback */
+	spinlock_t lock;
+	struct swdsp_fe fe[SWDSP_NUM_FES];
+	unsigned int active;
+	unsigned int in_callback;
+	/* Woken when the last running callback is done reporting */
+	wait_queue_head_t callback_wq;
+
+	/* Protects the ring setup, done while any front end is open */
+	struct mutex open_lock;
+	unsigned int users;
+	unsigned int rate;
+
+	struct dma_chan *chan;
+	dma_cookie_t cookie;
+	void *ring;
+	dma_addr_t ring_addr;
+	unsigned int fill_period;
+
+	s32 *mix;
+};
+
+static const struct snd_pcm_hardware swdsp_pcm_hardware = {
+	.info = SNDRV_PCM_INFO_MMAP | SNDRV_PCM_INFO_MMAP_VALID |
+		SNDRV_PCM_INFO_INTERLEAVED | SNDRV_PCM_INFO_BLOCK_TRANSFER |
+		SNDRV_PCM_INFO_PAUSE | SNDRV_PCM_INFO_RESUME |
+		SNDRV_PCM_INFO_BATCH | SNDRV_PCM_INFO_NO_PERIOD_WAKEUP,
+	.formats = SNDRV_PCM_FMTBIT_S16_LE,
+	.rates = SNDRV_PCM_RATE_CONTINUOUS | SNDRV_PCM_RATE_8000_48000,
+	.rate_min = 8000,
+	.rate_max = 48000,
+	.channels_min = 1,
+	.channels_max = 2,
+	.buffer_bytes_max = 128 * 1024,
+	.period_bytes_min = 64,
+	.period_bytes_max = 64 * 1024,
+	.periods_min = 2,
+	.periods_max = 1024,
+};
+
+static inline struct swdsp_fe *swdsp_substream_fe(struct swdsp *dsp,
+	struct snd_pcm_substream *substream)
+{
+	struct snd_soc_pcm_runtime *rtd = substream->private_data;
+
+	return &dsp->fe[rtd->cpu_dai->id];
+}
+
+static struct snd_soc_dpcm *swdsp_be_link(struct snd_pcm_substream *substream)
+{
+	struct snd_soc_pcm_runtime *fe = substream->private_data;
+
+	return list_first_entry_or_null(&fe->dpcm[substream->stream].be_clients,
+					struct snd_soc_dpcm, list_be);
+}
+
+/*
+ * Renders up to frames output frames of a front end into the mix buffer,
+ * reading as much of its buffer as the rate conversion needs. Returns true
+ * if the PCM core has to be told about the new position, either because a
+ * period has elapsed or because the stream ran dry.
+ */
+static bool swdsp_fe_render(struct swdsp *dsp, struct swdsp_fe *fe,
+	unsigned int frames)
+{
+	struct snd_pcm_runtime *runtime = fe->substream->runtime;
+	snd_pcm_sframes_t avail;
+	snd_pcm_uframes_t ofs, consumed = 0;
+	const s16 *coeffs, *src;
+	s32 *mix = dsp->mix;
+	s32 l, r;
+	unsigned int i, k;
+
+	avail = runtime->control->appl_ptr - fe->hw_ptr;
+	if (avail < 0)
+		avail += runtime->boundary;
+
+	ofs = fe->hw_ptr % runtime->buffer_size;
+
+	for (i = 0; i < frames; i++, mix += 2) {
+		while (fe->phase >= dsp->rate) {
+			if (!avail)
+				goto out;
+
+			src = (s16 *)runtime->dma_area + ofs * fe->channels;
+			memmove(fe->hist[0], fe->hist[1],
+				sizeof(fe->hist) - sizeof(fe->hist[0]));
+			fe->hist[SWDSP_TAPS - 1][0] = src[0];
+			fe->hist[SWDSP_TAPS - 1][1] = src[fe->channels - 1];
+
+			if (++ofs == runtime->buffer_size)
+				ofs = 0;
+			avail--;
+			consumed++;
+			fe->phase -= dsp->rate;
+		}
+
+		if (fe->rate == dsp->rate) {
+			mix[0] += fe->hist[SWDSP_TAPS - 1][0];
+			mix[1] += fe->hist[SWDSP_TAPS - 1][1];
+		} else {
+			coeffs = swdsp_coeffs[fe->phase * SWDSP_PHASES /
+					      dsp->rate];
+			l = r = 0;
+			for (k = 0; k < SWDSP_TAPS; k++) {
+				l += coeffs[k] * fe->hist[k][0];
+				r += coeffs[k] * fe->hist[k][1];
+			}
+			mix[0] += l >> 15;
+			mix[1] += r >> 15;
+		}
+
+		fe->phase += fe->rate;
+	}
+
+out:
+	fe->hw_ptr += consumed;
+	if (fe->hw_ptr >= runtime->boundary)
+		fe->hw_ptr -= runtime->boundary;
+
+	/* Let the core notice the underrun */
+	if (i < frames)
+		return true;
+
+	fe->period_pos += consumed;
+	if (fe->period_pos < runtime->period_size)
+		return false;
+
+	fe->period_pos %= runtime->period_size;
+	return !runtime->no_period_wakeup;
+}
+
+static void swdsp_fill_period(struct swdsp *dsp, unsigned int period,
+	struct snd_pcm_substream **elapsed)
+{
+	s16 *dst = dsp->ring + period * SWDSP_PERIOD_BYTES;
+	struct swdsp_fe *fe;
+	unsigned int i;
+
+	memset(dsp->mix, 0, SWDSP_PERIOD_FRAMES * 2 * sizeof(*dsp->mix));
+
+	for (i = 0; i < SWDSP_NUM_FES; i++) {
+		fe = &dsp->fe[i];
+		if (fe->running &&
+		    swdsp_fe_render(dsp, fe, SWDSP_PERIOD_FRAMES))
+			elapsed[i] = fe->substream;
+	}
+
+	for (i = 0; i < SWDSP_PERIOD_FRAMES * 2; i++)
+		dst[i] = clamp_t(s32, dsp->mix[i], -32768, 32767);
+}
+
+/*
+ * Refills every period of the ring the DMA has finished with since the last
+ * call, which may be more than one if the callback was delayed.
+ */
+static void swdsp_dma_complete(void *data)
+{
+	struct swdsp *dsp = data;
+	struct snd_pcm_substream *elapsed[SWDSP_NUM_FES] = { NULL };
+	unsigned int period, i;
+	struct dma_tx_state state;
+	unsigned long flags;
+
+	spin_lock_irqsave(&dsp->lock, flags);
+
+	if (!dsp->active) {
+		spin_unlock_irqrestore(&dsp->lock, flags);
+		return;
+	}
+
+	dmaengine_tx_status(dsp->chan, dsp->cookie, &state);
+	period = (SWDSP_RING_BYTES - state.residue) / SWDSP_PERIOD_BYTES;
+	period %= SWDSP_RING_PERIODS;
+
+	while (dsp->fill_period != period) {
+		swdsp_fill_period(dsp, dsp->fill_period, elapsed);
+		dsp->fill_period = (dsp->fill_period + 1) % SWDSP_RING_PERIODS;
+	}
+
+	dsp->in_callback++;
+	spin_unlock_irqrestore(&dsp->lock, flags);
+
+	for (i = 0; i < SWDSP_NUM_FES; i++) {
+		if (elapsed[i])
+			snd_pcm_period_elapsed(elapsed[i]);
+	}
+
+	spin_lock_irqsave(&dsp->lock, flags);
+	if (!--dsp->in_callback)
+		wake_up(&dsp->callback_wq);
+	spin_unlock_irqrestore(&dsp->lock, flags);
+}
+
+static int swdsp_ring_start(struct swdsp *dsp)
+{
+	struct dma_async_tx_descriptor *desc;
+
+	/* The ring starts out silent, front ends are mixed in as it drains */
+	memset(dsp->ring, 0, SWDSP_RING_BYTES);
+	dsp->fill_period = 0;
+
+	desc = dmaengine_prep_dma_cyclic(dsp->chan, dsp->ring_addr,
+		SWDSP_RING_BYTES, SWDSP_PERIOD_BYTES, DMA_MEM_TO_DEV,
+		DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!desc)
+		return -ENOMEM;
+
+	desc->callback = swdsp_dma_complete;
+	desc->callback_param = dsp;
+	dsp->cookie = dmaengine_submit(desc);
+
+	dma_async_issue_pending(dsp->chan);
+
+	return 0;
+}
+
+static int swdsp_ring_alloc(struct swdsp *dsp,
+	struct snd_pcm_substream *substream, struct snd_soc_dai *be_dai)
+{
+	struct snd_dmaengine_dai_dma_data *dma_data;
+	struct dma_slave_config config;
+	int ret;
+
+	dma_data = snd_soc_dai_get_dma_data(be_dai, substream);
+	if (!dma_data)
+		return -ENODEV;
+
+	dsp->chan = snd_dmaengine_pcm_request_channel(NULL,
+						      dma_data->filter_data);
+	if (!dsp->chan)
+		return -ENXIO;
+
+	memset(&config, 0, sizeof(config));
+	config.direction = DMA_MEM_TO_DEV;
+	snd_dmaengine_pcm_set_config_from_dai_data(substream, dma_data,
+						   &config);
+	config.dst_addr_width = DMA_SLAVE_BUSWIDTH_2_BYTES;
+
+	ret = dmaengine_slave_config(dsp->chan, &config);
+	if (ret)
+		goto err_release_channel;
+
+	dsp->ring = dma_alloc_coherent(dsp->chan->device->dev,
+				       SWDSP_RING_BYTES, &dsp->ring_addr,
+				       GFP_KERNEL);
+	if (!dsp->ring) {
+		ret = -ENOMEM;
+		goto err_release_channel;
+	}
+
+	return 0;
+
+err_release_channel:
+	dma_release_channel(dsp->chan);
+	dsp->chan = NULL;
+	return ret;
+}
+
+static void swdsp_ring_free(struct swdsp *dsp)
+{
+	dmaengine_terminate_all(dsp->chan);
+	dma_free_coherent(dsp->chan->device->dev, SWDSP_RING_BYTES,
+			  dsp->ring, dsp->ring_addr);
+	dma_release_channel(dsp->chan);
+	dsp->chan = NULL;
+	dsp->rate = 0;
+}
+
+static int swdsp_pcm_open(struct snd_pcm_substream *substream)
+{
+	struct snd_soc_pcm_runtime *rtd = substream->private_data;
+	struct swdsp *dsp = snd_soc_platform_get_drvdata(rtd->platform);
+	struct swdsp_fe *fe = swdsp_substream_fe(dsp, substream);
+	struct snd_soc_dpcm *dpcm;
+	int ret = 0;
+
+	if (substream->stream != SNDRV_PCM_STREAM_PLAYBACK)
+		return -EINVAL;
+
+	dpcm = swdsp_be_link(substream);
+	if (!dpcm) {
+		dev_err(dsp->dev, "%s is not routed to a back end\n",
+			rtd->dai_link->name);
+		return -ENODEV;
+	}
+
+	mutex_lock(&dsp->open_lock);
+	if (!dsp->users) {
+		ret = swdsp_ring_alloc(dsp, substream, dpcm->be->cpu_dai);
+		if (ret) {
+			dev_err(dsp->dev, "Failed to set up DMA: %d\n", ret);
+			goto out_unlock;
+		}
+	}
+	dsp->users++;
+
+	spin_lock_irq(&dsp->lock);
+	fe->substream = substream;
+	spin_unlock_irq(&dsp->lock);
+
+	snd_soc_set_runtime_hwparams(substream, &swdsp_pcm_hardware);
+
+out_unlock:
+	mutex_unlock(&dsp->open_lock);
+	return ret;
+}
+
+static int swdsp_pcm_close(struct snd_pcm_substream *substream)
+{
+	struct snd_soc_pcm_runtime *rtd = substream->private_data;
+	struct swdsp *dsp = snd_soc_platform_get_drvdata(rtd->platform);
+	struct swdsp_fe *fe = swdsp_substream_fe(dsp, substream);
+
+	spin_lock_irq(&dsp->lock);
+	fe->substream = NULL;
+	/* Wait for a callback which may still report this stream */
+	wait_event_lock_irq(dsp->callback_wq, !dsp->in_callback, dsp->lock);
+	spin_unlock_irq(&dsp->lock);
+
+	mutex_lock(&dsp->open_lock);
+	if (!--dsp->users)
+		swdsp_ring_free(dsp);
+	mutex_unlock(&dsp->open_lock);
+
+	return 0;
+}
+
+static int swdsp_pcm_hw_params(struct snd_pcm_substream *substream,
+	struct snd_pcm_hw_params *params)
+{
+	struct snd_soc_pcm_runtime *rtd = substream->private_data;
+	struct swdsp *dsp = snd_soc_platform_get_drvdata(rtd->platform);
+	struct swdsp_fe *fe = swdsp_substream_fe(dsp, substream);
+	struct snd_pcm_hw_params *be_params;
+	struct snd_soc_dpcm *dpcm;
+	int ret = 0;
+
+	mutex_lock(&dsp->open_lock);
+
+	/*
+	 * The back end is only configured by the first front end, the
+	 * others see it already running.
+	 */
+	if (!dsp->rate) {
+		dpcm = swdsp_be_link(substream);
+		if (!dpcm) {
+			dev_err(dsp->dev, "%s is not routed to a back end\n",
+				rtd->dai_link->name);
+			ret = -ENODEV;
+			goto out_unlock;
+		}
+		be_params = &dpcm->hw_params;
+
+		if (params_format(be_params) != SNDRV_PCM_FORMAT_S16_LE ||
+		    params_channels(be_params) != 2) {
+			dev_err(dsp->dev, "Back end must be 16 bit stereo\n");
+			ret = -EINVAL;
+			goto out_unlock;
+		}
+		dsp->rate = params_rate(be_params);
+	}
+
+	if (params_rate(params) > dsp->rate) {
+		dev_err(dsp->dev, "Cannot play %u Hz on a %u Hz back end\n",
+			params_rate(params), dsp->rate);
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	fe->rate = params_rate(params);
+	fe->channels = params_channels(params);
+
+	ret = snd_pcm_lib_alloc_vmalloc_buffer(substream,
+					       params_buffer_bytes(params));
+	if (ret > 0)
+		ret = 0;
+
+out_unlock:
+	mutex_unlock(&dsp->open_lock);
+	return ret;
+}
+
+static int swdsp_pcm_hw_free(struct snd_pcm_substream *substream)
+{
+	return snd_pcm_lib_free_vmalloc_buffer(substream);
+}
+
+static int swdsp_pcm_trigger(struct snd_pcm_substream *substream, int cmd)
+{
+	struct snd_soc_pcm_runtime *rtd = substream->private_data;
+	struct swdsp *dsp = snd_soc_platform_get_drvdata(rtd->platform);
+	struct swdsp_fe *fe = swdsp_substream_fe(dsp, substream);
+	unsigned long flags;
+	int ret = 0;
+
+	spin_lock_irqsave(&dsp->lock, flags);
+
+	switch (cmd) {
+	case SNDRV_PCM_TRIGGER_START:
+		fe->hw_ptr = substream->runtime->status->hw_ptr;
+		fe->period_pos = 0;
+		fe->phase = dsp->rate;
+		memset(fe->hist, 0, sizeof(fe->hist));
+		/* Fall through */
+	case SNDRV_PCM_TRIGGER_RESUME:
+	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
+		if (fe->running)
+			break;
+		if (!dsp->active) {
+			ret = swdsp_ring_start(dsp);
+			if (ret)
+				break;
+		}
+		dsp->active++;
+		fe->running = true;
+		break;
+	case SNDRV_PCM_TRIGGER_STOP:
+	case SNDRV_PCM_TRIGGER_SUSPEND:
+	case SNDRV_PCM_TRIGGER_PAUSE_PUSH:
+		if (!fe->running)
+			break;
+		fe->running = false;
+		if (!--dsp->active)
+			dmaengine_terminate_all(dsp->chan);
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	spin_unlock_irqrestore(&dsp->lock, flags);
+
+	return ret;
+}
+
+static snd_pcm_uframes_t swdsp_pcm_pointer(struct snd_pcm_substream *substream)
+{
+	struct snd_soc_pcm_runtime *rtd = substream->private_data;
+	struct swdsp *dsp = snd_soc_platform_get_drvdata(rtd->platform);
+	struct swdsp_fe *fe = swdsp_substream_fe(dsp, substream);
+
+	return ACCESS_ONCE(fe->hw_ptr) % substream->runtime->buffer_size;
+}
+
+static struct snd_pcm_ops swdsp_pcm_ops = {
+	.open		= swdsp_pcm_open,
+	.close		= swdsp_pcm_close,
+	.ioctl		= snd_pcm_lib_ioctl,
+	.hw_params	= swdsp_pcm_hw_params,
+	.hw_free	= swdsp_pcm_hw_free,
+	.trigger	= swdsp_pcm_trigger,
+	.pointer	= swdsp_pcm_pointer,
+	.page		= snd_pcm_lib_get_vmalloc_page,
+};
+
+static struct snd_soc_platform_driver swdsp_platform = {
+	.ops		= &swdsp_pcm_ops,
+};
+
+#define SWDSP_FE_DAI(num) \
+	{ \
+		.name = "swdsp-fe" #num, \
+		.id = num, \
+		.playback = { \
+			.stream_name = "FE" #num " Playback", \
+			.channels_min = 1, \
+			.channels_max = 2, \
+			.rates = SNDRV_PCM_RATE_CONTINUOUS, \
+			.rate_min = 8000, \
+			.rate_max = 48000, \
+			.formats = SNDRV_PCM_FMTBIT_S16_LE, \
+		}, \
+	}
+
+static struct snd_soc_dai_driver swdsp_dais[SWDSP_NUM_FES] = {
+	SWDSP_FE_DAI(0),
+	SWDSP_FE_DAI(1),
+	SWDSP_FE_DAI(2),
+	SWDSP_FE_DAI(3),
+};
+
+static const struct snd_soc_component_driver swdsp_component = {
+	.name		= "snd-soc-swdsp",
+};
+
+static int swdsp_probe(struct platform_device *pdev)
+{
+	struct swdsp *dsp;
+	int ret;
+
+	dsp = devm_kzalloc(&pdev->dev, sizeof(*dsp), GFP_KERNEL);
+	if (!dsp)
+		return -ENOMEM;
+
+	dsp->mix = devm_kzalloc(&pdev->dev,
+		SWDSP_PERIOD_FRAMES * 2 * sizeof(*dsp->mix), GFP_KERNEL);
+	if (!dsp->mix)
+		return -ENOMEM;
+
+	dsp->dev = &pdev->dev;
+	spin_lock_init(&dsp->lock);
+	init_waitqueue_head(&dsp->callback_wq);
+	mutex_init(&dsp->open_lock);
+	platform_set_drvdata(pdev, dsp);
+
+	ret = snd_soc_register_platform(&pdev->dev, &swdsp_platform);
+	if (ret)
+		return ret;
+
+	ret = snd_soc_register_component(&pdev->dev, &swdsp_component,
+					 swdsp_dais, ARRAY_SIZE(swdsp_dais));
+	if (ret)
+		snd_soc_unregister_platform(&pdev->dev);
+
+	return ret;
+}
+
+static int swdsp_remove(struct platform_device *pdev)
+{
+	snd_soc_unregister_component(&pdev->dev);
+	snd_soc_unregister_platform(&pdev->dev);
+
+	return 0;
+}
+
+static struct platform_driver swdsp_driver = {
+	.driver = {
+		.name = "snd-soc-swdsp",
+		.owner = THIS_MODULE,
+	},
+	.probe = swdsp_probe,
+	.remove = swdsp_remove,
+};
+
+module_platform_driver(swdsp_driver);
+
+MODULE_DESCRIPTION("ASoC software DSP front ends");
+MODULE_LICENSE("GPL");
+MODULE_ALIAS("platform:snd-soc-swdsp");